@@ -103,6 +103,28 @@ bool CCANPort::AddFrame(can_frame_t* in_pFrame)
    return l_bResult;
 }
 
+/**
+   Перенос фреймов полученных в прерывании из очереди в буфер
+   на входе    :  in_rQueue   - ссылка на очередь в которую обработчик прерывания помещает фреймы целиком
+   на выходе   :  количество перенесенных фреймов
+   примечание  :  метод вызывается из основного цикла, поэтому работа с буфером фреймов (Flush, GetPacket)
+                  не требует запрета прерываний
+*/
+size_t CCANPort::AddFrames(CByteQueue& in_rQueue)
+{
+   size_t l_stResult = 0;
+   can_frame_t l_Frame;
+
+   // Перенос фреймов пока есть место в буфере
+   while(m_InBuffer.m_stCount < m_InBuffer.m_stMax && in_rQueue.Size() >= sizeof(can_frame_t))
+   {
+      in_rQueue.Pop(&l_Frame, sizeof(l_Frame));
+      AddFrame(&l_Frame);
+      l_stResult++;
+   }
+   return l_stResult;
+}
+
 /**
    Добавление пакета в буфер (разложение на фреймы)
    на входе    :  in_bBroadcast  - признак широковещательного пакета
@@ -154,6 +176,32 @@ bool CCANPort::AddPacket(bool in_bBroadcast, u8 in_u8Address, void* in_pBuffer,
    return l_bResult;
 }
 
+/**
+   Перенос пакетов из очереди исходящих пакетов протокола в буфер фреймов
+   на входе    :  in_rQueue      - ссылка на очередь исходящих пакетов
+                  in_bBroadcast  - признак широковещательного пакета
+                  in_u8Address   - адрес на который надо отправлять CAN фреймы
+   на выходе   :  количество перенесенных пакетов
+   примечание  :  следующий пакет раскладывается на фреймы только после отправки всех фреймов предыдущего,
+                  поэтому приоритетный пакет ожидает не более одного пакета. Пакет, который не помещается
+                  в пустой буфер фреймов, удаляется из очереди
+*/
+size_t CCANPort::AddPackets(CIridiumBusOutQueue& in_rQueue, bool in_bBroadcast, u8 in_u8Address)
+{
+   size_t l_stResult = 0;
+   size_t l_stSize = 0;
+   const void* l_pPacket = NULL;
+
+   while(!m_OutBuffer.m_stCount && (l_stSize = in_rQueue.Peek(l_pPacket)) != 0)
+   {
+      // Разложение пакета на фреймы
+      if(AddPacket(in_bBroadcast, in_u8Address, (void*)l_pPacket, l_stSize))
+         l_stResult++;
+      in_rQueue.Release();
+   }
+   return l_stResult;
+}
+
 /**
    Получение текущего пакета
    на входе    :  out_rBuffer - ссылка на указатель куда нужно поместить указатель на данные полученого пакета
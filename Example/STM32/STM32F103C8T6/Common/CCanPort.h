@@ -2,6 +2,8 @@
 #define _C_CAN_PORT_H_INCLUDED_
 
 #include "IridiumTypes.h"
+#include "CByteQueue.h"
+#include "CIridiumBusOutQueue.h"
 
 // 31 30 29 28 27 26 25 24 23 22 21 20 19 18 17 16 15 14 13 12 11 10  9  8  7  6  5  4  3  2  1  0
 // [X][X][X][C][C][C][C][C][C][C][C][C][C][C][C][C][C][C][C][T][T][T][T][T][T][T][T][T][T][T][T][E]
@@ -89,6 +91,8 @@ public:
    //////////////////////////////////////////////////////////////////////////
    // Добавление фрейма в буфер
    bool AddFrame(can_frame_t* in_pFrame);
+   // Перенос фреймов полученных в прерывании из очереди в буфер
+   size_t AddFrames(CByteQueue& in_rQueue);
    // Получение данных
    bool GetPacket(void*& out_rBuffer, size_t& in_rSize);
       // Удаление пакета
@@ -101,6 +105,8 @@ public:
    //////////////////////////////////////////////////////////////////////////
    // Разложение буфера на фреймы
    bool AddPacket(bool in_bBroadcast, u8 in_u8Address, void* in_pBuffer, size_t in_stSize);
+   // Перенос пакетов из очереди исходящих пакетов протокола в буфер фреймов
+   size_t AddPackets(CIridiumBusOutQueue& in_rQueue, bool in_bBroadcast, u8 in_u8Address);
    // Получение указателя на фрейм по индексу
    can_frame_t* GetFrame();
    // Удаление фрейма
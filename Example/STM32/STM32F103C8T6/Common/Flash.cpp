@@ -105,3 +105,19 @@ bool FLASH_Test(u8* in_pBuffer, size_t in_stFlash, size_t in_stSize)
    return true;
 }
 
+/**
+   Проверка стертой флеш памяти
+   на входе    :  in_stFlash  - адрес проверяемой флеш памяти
+                  in_stSize   - размер проверяемой памяти
+   на выходе   :  true - все байты равны 0xFF, false - память нужно стирать перед записью
+*/
+bool FLASH_IsEmpty(size_t in_stFlash, size_t in_stSize)
+{
+   for(size_t i = 0; i < in_stSize; i++)
+   {
+      if(*(__IO uint8_t*)in_stFlash++ != 0xFF)
+         return false;
+   }
+   return true;
+}
+
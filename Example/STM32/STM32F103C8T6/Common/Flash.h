@@ -12,6 +12,7 @@ void FLASH_Clear(size_t in_stStart, size_t in_stEnd);
 void FLASH_Write(u8* in_pBuffer, size_t in_stFlash, size_t in_stSize);
 void FLASH_Read(u8* in_pBuffer, size_t in_stFlash, size_t in_stSize);
 bool FLASH_Test(u8* in_pBuffer, size_t in_stFlash, size_t in_stSize);
+bool FLASH_IsEmpty(size_t in_stFlash, size_t in_stSize);
    
 #ifdef __cplusplus
 }
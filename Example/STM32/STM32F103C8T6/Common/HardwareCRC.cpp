@@ -0,0 +1,114 @@
+#include "stm32f1xx_hal.h"
+#include "IridiumCRC16.h"
+#include "HardwareCRC.h"
+
+// Канал DMA для передачи данных в блок CRC (режим память-память)
+#define HWCRC_DMA_CHANNEL     DMA1_Channel1
+#define HWCRC_DMA_DONE        (DMA_ISR_TCIF1 | DMA_ISR_TEIF1)
+#define HWCRC_DMA_ERROR       DMA_ISR_TEIF1
+#define HWCRC_DMA_CLEAR       DMA_IFCR_CGIF1
+#define HWCRC_DMA_MAX_COUNT   0xFFFF
+
+//////////////////////////////////////////////////////////////////////////
+// Аппаратное вычисление CRC-32
+//////////////////////////////////////////////////////////////////////////
+volatile bool  g_bHWCRCBusy = false;               // Выполняется фоновое вычисление
+u32            g_u32HWCRCResult = 0;               // Результат последнего фонового вычисления
+
+/**
+   Инициализация блока CRC и DMA
+   на входе    :  *
+   на выходе   :  *
+   примечание  :  может вызываться до HAL_Init, после вызова GetCRC32Words использует блок CRC.
+                  Блок CRC микроконтроллеров STM32F1 вычисляет только CRC-32, поэтому GetCRC16Modbus
+                  остается программной
+*/
+void HWCRC_Init(void)
+{
+   // Включение тактирования блока CRC и DMA
+   RCC->AHBENR |= RCC_AHBENR_CRCEN | RCC_AHBENR_DMA1EN;
+   (void)RCC->AHBENR;
+
+   // Установка аппаратной реализации
+   SetCRC32Hook(HWCRC_Calc);
+}
+
+/**
+   Вычисление CRC-32 блоком CRC
+   на входе    :  in_pBuffer  - указатель на выровненный буфер с данными
+                  in_stCount  - количество 32 битных слов в буфере
+   на выходе   :  вычисленное значение CRC
+   примечание  :  если выполняется фоновое вычисление, метод дождется его окончания
+*/
+u32 HWCRC_Calc(const u32* in_pBuffer, size_t in_stCount)
+{
+   // Блок CRC занят фоновым вычислением
+   while(HWCRC_IsBusy()) ;
+
+   // Сброс и загрузка данных в блок CRC
+   CRC->CR = CRC_CR_RESET;
+   while(in_stCount--)
+      CRC->DR = *in_pBuffer++;
+   return CRC->DR;
+}
+
+/**
+   Запуск фонового вычисления CRC-32
+   на входе    :  in_pBuffer  - указатель на выровненный буфер с данными
+                  in_stCount  - количество 32 битных слов в буфере
+   на выходе   :  успешность запуска
+   примечание  :  данные передаются в блок CRC каналом DMA с низким приоритетом, процессор в это время
+                  свободен. Окончание проверяется HWCRC_IsBusy, результат получается HWCRC_GetResult
+*/
+bool HWCRC_Start(const u32* in_pBuffer, size_t in_stCount)
+{
+   bool l_bResult = false;
+   if(!g_bHWCRCBusy && in_stCount && in_stCount <= HWCRC_DMA_MAX_COUNT)
+   {
+      // Сброс блока CRC и канала DMA
+      CRC->CR = CRC_CR_RESET;
+      HWCRC_DMA_CHANNEL->CCR = 0;
+      DMA1->IFCR = HWCRC_DMA_CLEAR;
+
+      // Передача слов из памяти в регистр данных блока CRC
+      HWCRC_DMA_CHANNEL->CPAR = (u32)&CRC->DR;
+      HWCRC_DMA_CHANNEL->CMAR = (u32)in_pBuffer;
+      HWCRC_DMA_CHANNEL->CNDTR = in_stCount;
+      g_bHWCRCBusy = true;
+      HWCRC_DMA_CHANNEL->CCR = DMA_CCR_MEM2MEM | DMA_CCR_DIR | DMA_CCR_MINC | DMA_CCR_PSIZE_1 | DMA_CCR_MSIZE_1 | DMA_CCR_EN;
+      l_bResult = true;
+   }
+   return l_bResult;
+}
+
+/**
+   Проверка выполнения фонового вычисления CRC-32
+   на входе    :  *
+   на выходе   :  true  - вычисление выполняется
+                  false - блок CRC свободен
+*/
+bool HWCRC_IsBusy(void)
+{
+   u32 l_u32Flags = DMA1->ISR;
+   if(g_bHWCRCBusy && (l_u32Flags & HWCRC_DMA_DONE))
+   {
+      // Остановка канала и сохранение результата, при ошибке передачи результат заведомо неверный
+      HWCRC_DMA_CHANNEL->CCR = 0;
+      DMA1->IFCR = HWCRC_DMA_CLEAR;
+      g_u32HWCRCResult = CRC->DR;
+      if(l_u32Flags & HWCRC_DMA_ERROR)
+         g_u32HWCRCResult = ~g_u32HWCRCResult;
+      g_bHWCRCBusy = false;
+   }
+   return g_bHWCRCBusy;
+}
+
+/**
+   Получение результата фонового вычисления CRC-32
+   на входе    :  *
+   на выходе   :  вычисленное значение CRC
+*/
+u32 HWCRC_GetResult(void)
+{
+   return g_u32HWCRCResult;
+}
@@ -0,0 +1,22 @@
+#ifndef _HARDWARE_CRC_H_INCLUDED_
+#define _HARDWARE_CRC_H_INCLUDED_
+
+#include "IridiumTypes.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Аппаратное вычисление CRC-32 (блок CRC, совпадает с GetCRC32Words)
+void HWCRC_Init(void);
+u32 HWCRC_Calc(const u32* in_pBuffer, size_t in_stCount);
+
+// Фоновое вычисление CRC-32 через DMA
+bool HWCRC_Start(const u32* in_pBuffer, size_t in_stCount);
+bool HWCRC_IsBusy(void);
+u32 HWCRC_GetResult(void);
+   
+#ifdef __cplusplus
+}
+#endif
+#endif   // _HARDWARE_CRC_H_INCLUDED_
@@ -64,4 +64,15 @@ typedef enum firmware_id
 // Максимальное количество байт
 #define EEPROM_MAX                     768
 
+// CRC-32 прошивки для проверки блоком CRC (хранится в конце памяти и не сдвигает данные устройства)
+#define EEPROM_U32_FIRMWARE_CRC32      (EEPROM_MAX - 4)                             // CRC-32 прошивки
+#define EEPROM_U16_FIRMWARE_CRC32_KEY  (EEPROM_U32_FIRMWARE_CRC32 - 2)              // CRC16 прошивки для которой вычислена CRC-32
+// Размер окна запрошенный при открытии потока прошивки (передается загрузчику вместе с адресом и TID)
+#define EEPROM_U8_FIRMWARE_WINDOW      (EEPROM_U16_FIRMWARE_CRC32_KEY - 1)          // Размер окна потока прошивки
+// Точка продолжения прерванной загрузки прошивки (сохраняется загрузчиком на границе страницы флеш)
+#define EEPROM_U32_FIRMWARE_OFFSET     (EEPROM_U8_FIRMWARE_WINDOW - 4)              // Смещение в потоке прошивки (0 - точки нет)
+#define EEPROM_U16_FIRMWARE_STREAM_CRC (EEPROM_U32_FIRMWARE_OFFSET - 2)             // CRC16 потока прошивки до смещения
+#define EEPROM_U32_FIRMWARE_WRITTEN    (EEPROM_U16_FIRMWARE_STREAM_CRC - 4)         // Адрес флеш, до которого прошивка записана
+#define EEPROM_FIRMWARE_IV             (EEPROM_U32_FIRMWARE_WRITTEN - BLOCK_CIPHER_SIZE) // Блок шифра перед смещением (вектор продолжения)
+
 #endif   // _MEMORY_MAP_H_INCLUDED_
@@ -2,7 +2,9 @@
 #include "Device.h"
 #include "stm32f1xx_hal.h"
 #include "CCANPort.h"
-#include "CIridiumBusInBuffer.h"
+#include "CIridiumBusRingBuffer.h"
+#include "CIridiumBusOutQueue.h"
+#include "CByteQueue.h"
 #include "IridiumCRC16.h"
 #include "IridiumBus.h"
 
@@ -19,22 +21,31 @@ static CanTxMsgTypeDef  g_aCanTxMessage;           // Структура для
 static CanRxMsgTypeDef  g_aCanRxMessage;           // Структура для принимаемого сообщения
 
 // Входящий UART буфер
-CIridiumBusInBuffer     g_UARTInBuffer;
-u8                      g_aUARTInBuffer[IRIDIUM_BUS_IN_BUFFER_SIZE];
+CIridiumBusRingBuffer   g_UARTInBuffer;
+u8                      g_aUARTInBuffer[IRIDIUM_BUS_RING_BUFFER_SIZE];
 
 // Входящий CAN буфер
-CIridiumBusInBuffer     g_CANInBuffer;
-u8                      g_aCANInBuffer[IRIDIUM_BUS_IN_BUFFER_SIZE];
+CIridiumBusRingBuffer   g_CANInBuffer;
+u8                      g_aCANInBuffer[IRIDIUM_BUS_RING_BUFFER_SIZE];
 
 CCANPort                g_CAN;
-can_frame_t             g_aFromUart[512];
-can_frame_t             g_aFromCan[512];
+can_frame_t             g_aFromUart[(IRIDIUM_BUS_OUT_BUFFER_SIZE + IRIDIUM_BUS_CRC_SIZE + 7) / 8];
+can_frame_t             g_aFromCan[480];
+
+// Очередь пакетов из UART для отправки в CAN с учетом класса приоритета
+CIridiumBusOutQueue     g_OutQueue;
+u8                      g_aOutQueuePriority[IRIDIUM_GATE_OUT_QUEUE_PRIORITY * (IRIDIUM_BUS_OUT_BUFFER_SIZE + IRIDIUM_BUS_CRC_SIZE + IRIDIUM_BUS_OUT_QUEUE_HEADER)];
+u8                      g_aOutQueueNormal[IRIDIUM_GATE_OUT_QUEUE_NORMAL * (IRIDIUM_BUS_OUT_BUFFER_SIZE + IRIDIUM_BUS_CRC_SIZE + IRIDIUM_BUS_OUT_QUEUE_HEADER)];
+
+// Очередь фреймов полученных в прерывании CAN
+CByteQueue              g_CANQueue;
+u8                      g_aCANQueue[32 * sizeof(can_frame_t)];
 
 bool                    g_bTransmitEnd = true;
 uint8_t                 g_aUartBuffer[1];
 
 /**
-   Поиск шинного пакета в буфере UART и отправка в буфер для формирования фреймов
+   Поиск шинного пакета в буфере UART и отправка в очередь пакетов для CAN
    на входе    :  *
    на выходе   :  *
 */
@@ -46,8 +57,8 @@ void FindPacketsToCan()
    // Найдем пакет в буфере UART
    if(g_UARTInBuffer.OpenPacket())
    { 
-      // Добавим пакет в буфер для формирования фреймов и отправки в CAN
-      g_CAN.AddPacket(true, 0, g_UARTInBuffer.GetPacketPtr(), g_UARTInBuffer.GetPacketSize());
+      // Добавим пакет в очередь, класс приоритета определяется по заголовку пакета
+      g_OutQueue.Push(g_UARTInBuffer.GetPacketPtr(), g_UARTInBuffer.GetPacketSize());
    }
    // Закрытие шинного сообщения
    g_UARTInBuffer.ClosePacket();
@@ -96,20 +107,15 @@ void FindAndSendToUart()
    void* l_pBuffer = NULL;
    size_t l_stSize = 0;
    
+   // Перенос полученных в прерывании фреймов в буфер
+   g_CAN.AddFrames(g_CANQueue);
+
    // Получим размер помещенного в буфер пакета
    bool l_bResult = g_CAN.GetPacket(l_pBuffer, l_stSize);
    
-   // Отключим прерывания для избежания потери данных во время сдвига
-   HAL_NVIC_DisableIRQ(CAN1_RX1_IRQn);
-   HAL_NVIC_DisableIRQ(USB_LP_CAN1_RX0_IRQn);
-
-   // Удаление обработаных пакетов
+   // Удаление обработаных пакетов, буфер фреймов изменяется только в основном цикле
    g_CAN.Flush();
 
-   // Вернем прерывания
-   HAL_NVIC_EnableIRQ(CAN1_RX1_IRQn);
-   HAL_NVIC_EnableIRQ(USB_LP_CAN1_RX0_IRQn);
-
    // Если в буфере есть данные
    if(l_bResult)
    {
@@ -155,8 +161,8 @@ void HAL_CAN_RxCpltCallback(CAN_HandleTypeDef* in_pCan)
    // Скопируем полезную нагрузку
    memcpy(l_Frame.m_aData, in_pCan->pRxMsg->Data, l_Frame.m_u8Size);
    
-   // Добавление полученого фрейма в буфер
-   g_CAN.AddFrame(&l_Frame);
+   // Добавление полученого фрейма в очередь, фрейм помещается целиком или отбрасывается
+   g_CANQueue.Push(&l_Frame, sizeof(l_Frame));
    
    // Включим прерыване обратно
    HAL_CAN_Receive_IT(&hcan, CAN_FIFO0);
@@ -236,11 +242,18 @@ void iRidiumDevice_Setup(void)
 
    HAL_CAN_ConfigFilter(&hcan, &CAN_FilterFIFO0);
 
+   // Инициализируем очередь фреймов до включения прерываний
+   g_CANQueue.SetBuffer(g_aCANQueue, sizeof(g_aCANQueue));
+
    // Включаем прерывания на прием
    HAL_CAN_Receive_IT(&hcan, CAN_FIFO0);
    
    g_CAN.SetInBuffer(g_aFromCan, sizeof(g_aFromCan));
    g_CAN.SetOutBuffer(g_aFromUart, sizeof(g_aFromUart));
+
+   // Инициализируем очередь пакетов для CAN
+   g_OutQueue.SetBuffer(IRIDIUM_BUS_OUT_CLASS_PRIORITY, g_aOutQueuePriority, sizeof(g_aOutQueuePriority));
+   g_OutQueue.SetBuffer(IRIDIUM_BUS_OUT_CLASS_NORMAL, g_aOutQueueNormal, sizeof(g_aOutQueueNormal));
   
    // Инициализируем буфер UART
    g_UARTInBuffer.SetBuffer(g_aUARTInBuffer, sizeof(g_aUARTInBuffer));
@@ -298,6 +311,8 @@ void iRidiumDevice_Loop(void)
    // Обработаем буфер из уарта
    if(g_UARTInBuffer.Size())
       FindPacketsToCan();
+   // Перенесем следующий пакет из очереди, если фреймы предыдущего пакета отправлены
+   g_CAN.AddPackets(g_OutQueue, true, 0);
    // Обработаем буфер на отправку в CAN
    if(g_CAN.GetFrame())
       SendPacketsToCan();
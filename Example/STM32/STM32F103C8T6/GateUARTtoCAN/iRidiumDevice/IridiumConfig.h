@@ -31,6 +31,28 @@
 // Настройка CRC8 и CRC16
 //#define IRIDIUM_ENABLE_FAST_CRC8
 //#define IRIDIUM_ENABLE_FAST_CRC16
+// Подсчет CRC16 входящих пакетов по мере поступления данных (AddByte/Add)
+//#define IRIDIUM_ENABLE_STREAM_CRC16
+
+// Отслеживание ответов на запросы ведущего (таблица транзакций с ожиданием ответа и повторами)
+//#define IRIDIUM_ENABLE_TRANSACTIONS
+
+// Распределение ответов на широковещательный поиск по временным слотам (требует вызова ProcessSearch)
+//#define IRIDIUM_ENABLE_SEARCH_SLOTS
+
+// Хэш каталога каналов в ответе на запрос информации об устройстве (кэширование каталога ведущим)
+//#define IRIDIUM_ENABLE_CATALOG_HASH
+
+// Передача блоков потока окном с выборочным подтверждением (передающая сторона вызывает ProcessStream)
+//#define IRIDIUM_ENABLE_STREAM_WINDOW
+
+// Продолжение прерванной записи потока с точки, сохраненной устройством (работает вместе с окном)
+//#define IRIDIUM_ENABLE_STREAM_RESUME
+
+// Размер очередей пакетов из UART в CAN (количество пакетов максимального размера, около 266 байт ОЗУ на пакет).
+// Пакеты, не поместившиеся в очередь, отбрасываются. По умолчанию 2 приоритетных и 6 обычных пакетов (около 2 КБ)
+#define IRIDIUM_GATE_OUT_QUEUE_PRIORITY   2
+#define IRIDIUM_GATE_OUT_QUEUE_NORMAL     6
 
 // Конфигурация протокола
 // Системные
@@ -58,6 +80,8 @@
 #define IRIDIUM_CONFIG_SET_TAG_VALUE_SLAVE
 //#define IRIDIUM_CONFIG_GET_TAG_VALUE_MASTER
 #define IRIDIUM_CONFIG_GET_TAG_VALUE_SLAVE
+//#define IRIDIUM_CONFIG_SUBSCRIBE_TAG_MASTER
+//#define IRIDIUM_CONFIG_SUBSCRIBE_TAG_SLAVE
 // Работа с каналами управления
 //#define IRIDIUM_CONFIG_GET_CHANNELS_MASTER
 #define IRIDIUM_CONFIG_GET_CHANNELS_SLAVE
@@ -69,6 +93,9 @@
 #define IRIDIUM_CONFIG_GET_CHANNEL_DESCRIPTION_SLAVE
 //#define IRIDIUM_CONFIG_GET_CHANNEL_VALUE_MASTER
 #define IRIDIUM_CONFIG_GET_CHANNEL_VALUE_SLAVE
+// Пакетное выполнение операций с каналами
+//#define IRIDIUM_CONFIG_BATCH_MASTER
+#define IRIDIUM_CONFIG_BATCH_SLAVE
 // Работа с потоками
 //#define IRIDIUM_CONFIG_STREAM_OPEN_MASTER
 #define IRIDIUM_CONFIG_STREAM_OPEN_SLAVE
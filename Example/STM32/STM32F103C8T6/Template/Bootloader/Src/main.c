@@ -44,6 +44,7 @@
 #include "MemoryMap.h"
 #include "EEPROM.h"
 #include "IridiumCRC16.h"
+#include "HardwareCRC.h"
 
 /* USER CODE END Includes */
 
@@ -74,6 +75,28 @@ extern void iRidiumDevice_Init(void);
 extern void iRidiumDevice_Setup(void);
 extern void iRidiumDevice_Loop(void);
 
+/**
+   Проверка целостности прошивки
+   на входе    :  in_u32Size  - размер прошивки
+                  in_u16CRC   - CRC16 прошивки
+   на выходе   :  успешность проверки
+   примечание  :  если для прошивки уже вычислена CRC-32, прошивка проверяется блоком CRC, что значительно
+                  быстрее программного вычисления CRC16. Иначе (или если CRC-32 не совпала) прошивка
+                  проверяется по CRC16
+*/
+static bool CheckFirmware(u32 in_u32Size, u16 in_u16CRC)
+{
+   // Проверка блоком CRC
+   if(EEPROM_ReadU16(EEPROM_U16_FIRMWARE_CRC32_KEY) == in_u16CRC)
+   {
+      HWCRC_Init();
+      if(HWCRC_Calc((const u32*)FIRMWARE_START, (in_u32Size + 3) / 4) == EEPROM_ReadU32(EEPROM_U32_FIRMWARE_CRC32))
+         return true;
+   }
+   // Проверка CRC16
+   return GetCRC16Modbus(0x77, (u8*)FIRMWARE_START, in_u32Size) == in_u16CRC;
+}
+
 /* USER CODE END 0 */
 
 /**
@@ -96,7 +119,7 @@ int main(void)
    if(l_eMode == BOOTLOADER_MODE_RUN)
    {
       // Проверка размера и контрольной суммы прошивки
-      if(l_u32Size && l_u32Size <= FIRMWARE_SIZE && GetCRC16Modbus(0x77, (u8*)FIRMWARE_START, l_u32Size) == l_u16CRC)
+      if(l_u32Size && l_u32Size <= FIRMWARE_SIZE && CheckFirmware(l_u32Size, l_u16CRC))
       {
          // Прототип функции
          typedef void (*function_t)();
@@ -15,9 +15,11 @@
 #include "IridiumCRC16.h"
 #include "CIridiumStreebog.h"
 #include "CIridiumCipherGrasshopper.h"
+#include "CIridiumFirmwareStream.h"
 
 // Common
 #include "CCanPort.h"
+#include "CByteQueue.h"
 #include "Flash.h"
 #include "EEPROM.h"
 #include "MemoryMap.h"
@@ -34,6 +36,10 @@
 
 #define MAX_INPUTS                     1
 
+#define FIRMWARE_WINDOW_SLOTS          3           // Количество блоков прошивки полученных вне очереди (окно на 1 больше)
+
+#define FIRMWARE_CHECKPOINT_SIZE       4096        // Шаг сохранения точки продолжения загрузки (кратен размеру страницы флеш)
+
 ///////////////////////////////////////////////////////////////////////////////
 // Информация об устройстве
 ///////////////////////////////////////////////////////////////////////////////
@@ -75,6 +81,15 @@ u32                        g_u32FirmwareSize = 0;  // Размер прошив
 u16                        g_u16FirmwareCRC = 0;   // Контрольная сумма прошивки
 CFirmware                  g_Firmware;             // Прошивка устройства
 CIridiumCipherGrasshopper  g_Cipher;               // Шифр для декодирования прошивки
+size_t                     g_stFirmwareErased = FIRMWARE_START; // Конец области флеш, подготовленной для записи прошивки
+u8                         g_u8FirmwareFormat = IRIDIUM_FIRMWARE_FORMAT_RAW; // Формат принимаемого потока прошивки
+CIridiumFirmwareStream     g_FirmwareStream;       // Распаковка сжатой прошивки
+#if defined(IRIDIUM_ENABLE_STREAM_RESUME)
+u32                        g_u32StreamOffset = 0;  // Количество принятых байт потока прошивки
+u16                        g_u16StreamCRC = 0;     // CRC16 принятых байт потока прошивки
+u8                         g_aStreamIV[BLOCK_CIPHER_SIZE]; // Последний принятый блок шифра
+size_t                     g_stResumeSkip = 0;     // Количество байт первого блока после продолжения, которые уже записаны
+#endif
 
 // Для работы с временем, количество тиков в 1 микросекунде
 volatile u32               g_u32TickPerUs = HAL_RCC_GetHCLKFreq() / 1000000;
@@ -89,9 +104,17 @@ static CanRxMsgTypeDef  g_aCanRxMessage;           // Структура для
 
 // Параметры CAN порта для сборки и разборки пакетов
 CCANPort                g_ExtCAN;                  // Данные внешнего CAN порта
-can_frame_t             g_aCANInBuffer[256];       // Массив для приема и сборки CAN пакетов
-can_frame_t             g_aCANOutBuffer[33*8];     // Массив для отправки CAN пакетов
+can_frame_t             g_aCANInBuffer[224];       // Массив для приема и сборки CAN пакетов
+CByteQueue              g_CANQueue;                // Очередь фреймов полученных в прерывании
+u8                      g_aCANQueue[32 * sizeof(can_frame_t)];
+can_frame_t             g_aCANOutBuffer[(IRIDIUM_BUS_OUT_BUFFER_SIZE + IRIDIUM_BUS_CRC_SIZE + 7) / 8]; // Массив для отправки CAN пакетов (один пакет)
+// Буферы очереди исходящих пакетов протокола
+u8                      g_aOutQueuePriority[1 * (IRIDIUM_BUS_OUT_BUFFER_SIZE + IRIDIUM_BUS_CRC_SIZE + IRIDIUM_BUS_OUT_QUEUE_HEADER)];
+u8                      g_aOutQueueNormal[4 * (IRIDIUM_BUS_OUT_BUFFER_SIZE + IRIDIUM_BUS_CRC_SIZE + IRIDIUM_BUS_OUT_QUEUE_HEADER)];
 u16                     g_u16CANID = 0;            // Идентификатор CAN
+#if defined(IRIDIUM_ENABLE_STREAM_WINDOW)
+u8                      g_aStreamSlots[FIRMWARE_WINDOW_SLOTS * IRIDIUM_BUS_MAX_BODY_SIZE]; // Буфер блоков прошивки полученных вне очереди
+#endif
 
 // Проверка наличия входов
 #if MAX_INPUTS != 0
@@ -126,38 +149,6 @@ CCANPort* GetCANPort(CAN_HandleTypeDef* in_pCanHandle)
    return l_pResult;
 }
 
-/**
-   Блокирование доступа к CAN порту
-   на входе    :  in_pCanHandle  - указатель на хэндлер порта
-   на выходе   :  *
-*/
-void LockCANPort(CAN_HandleTypeDef* in_pCanHandle)
-{
-   // Проверка на нужный порт
-   if(in_pCanHandle->Instance == CAN1)
-   {
-      // Выключение прерываний CAN 1 на время сдвига буфера во избежании потери данных
-      HAL_NVIC_DisableIRQ(CAN1_RX1_IRQn);
-      HAL_NVIC_DisableIRQ(CAN1_RX0_IRQn);
-   }
-}
-
-/**
-   Блокирование доступа к CAN порту
-   на входе    :  in_pCanHandle  - указатель на хэндлер порта
-   на выходе   :  *
-*/
-void UnLockCANPort(CAN_HandleTypeDef* in_pCanHandle)
-{
-   // Проверка на нужный порт
-   if(in_pCanHandle->Instance == CAN1)
-   {
-      // Включение прерываний CAN 1
-      HAL_NVIC_EnableIRQ(CAN1_RX1_IRQn);
-      HAL_NVIC_EnableIRQ(CAN1_RX0_IRQn);
-   }
-}
-
 /**
    Отправка прерывания приема пакета с CAN
    на входе    :  in_pCanHandle - указатель на структуру CAN
@@ -178,8 +169,8 @@ void HAL_CAN_RxCpltCallback(CAN_HandleTypeDef* in_pCanHandle)
       // Скопируем полезную нагрузку
       memcpy(l_Frame.m_aData, in_pCanHandle->pRxMsg->Data, l_Frame.m_u8Size);
 
-      // Добавление полученого фрейма в буфер
-      l_pPort->AddFrame(&l_Frame);
+      // Добавление полученого фрейма в очередь, фрейм помещается целиком или отбрасывается
+      g_CANQueue.Push(&l_Frame, sizeof(l_Frame));
 
       // Включим прерыване обратно
       HAL_CAN_Receive_IT(in_pCanHandle, CAN_FIFO0);
@@ -218,6 +209,9 @@ void BUS_Init()
    CAN_FilterInitStructure.BankNumber = 14;                 // Важно заполнить это поле
    HAL_CAN_ConfigFilter(&hcan, &CAN_FilterInitStructure);
 
+   // Очередь фреймов инициализируется до включения прерываний
+   g_CANQueue.SetBuffer(g_aCANQueue, sizeof(g_aCANQueue));
+
    HAL_CAN_Receive_IT(&hcan, CAN_FIFO0);
 
    g_ExtCAN.SetCANID(0);
@@ -284,19 +278,6 @@ void BUS_SetFilter(u16 in_u16CanID, u8 in_u8Address)
    HAL_CAN_Receive_IT(&hcan, CAN_FIFO0);
 }
 
-/**
-   Отправка сообщения на шину
-   на входе    :  in_bBroadcast  - признак широковещательно пакета
-                  in_u8Address   - адрес кому предназначен пакет
-                  in_pBuffer     - указатель на отправляемые данные
-                  in_stSize      - размер отправляемых данных
-   на выходе   :  успешность отправки данных
-*/
-bool BUS_Write(bool in_bBroadcast, u8 in_u8Address, void* in_pBuffer, size_t in_stSize)
-{
-   return g_ExtCAN.AddPacket(in_bBroadcast, in_u8Address, in_pBuffer, in_stSize);
-}
-
 /////////////////////////////////////////////////////////////////////////////////////////////////
 //// Работа с таймером
 /////////////////////////////////////////////////////////////////////////////////////////////////
@@ -351,6 +332,49 @@ void Reboot()
    NVIC_SystemReset();
 }
 
+/**
+   Подготовка страниц флеш к записи данных прошивки
+   на входе    :  in_stEnd - адрес конца записываемых данных
+   на выходе   :  *
+   примечание  :  страницы стираются по одной перед первой записью в них, поэтому прием блока задерживается
+                  не более чем на стирание одной страницы, а страницы за концом нового образа не изнашиваются.
+                  Уже чистые страницы не стираются. Перед использованием нужно вызывать метод HAL_FLASH_Unlock()
+*/
+static void PrepareFirmwareFlash(size_t in_stEnd)
+{
+   // Стирать можно только область прошивки
+   if(in_stEnd > FIRMWARE_END + 1)
+      in_stEnd = FIRMWARE_END + 1;
+
+   // Стирание страниц, в которые еще не было записи
+   while(g_stFirmwareErased < in_stEnd)
+   {
+      if(!FLASH_IsEmpty(g_stFirmwareErased, FLASH_PAGE_SIZE))
+         FLASH_Clear(g_stFirmwareErased, g_stFirmwareErased + FLASH_PAGE_SIZE);
+      g_stFirmwareErased += FLASH_PAGE_SIZE;
+   }
+}
+
+/**
+   Запись данных прошивки во флеш с текущей позиции
+   на входе    :  in_pBuffer  - указатель на записываемые данные
+                  in_stSize   - размер записываемых данных (четный, кроме последней записи)
+   на выходе   :  *
+   примечание  :  перед использованием нужно вызывать метод HAL_FLASH_Unlock()
+*/
+static void WriteFirmware(u8* in_pBuffer, size_t in_stSize)
+{
+   // Запись ограничена областью прошивки
+   if(in_stSize > g_Firmware.GetSize())
+      in_stSize = g_Firmware.GetSize();
+   // Стирание страниц перед первой записью в них
+   PrepareFirmwareFlash((size_t)g_Firmware.GetPtr() + in_stSize);
+   // Запись во флеш память
+   FLASH_Write(in_pBuffer, (size_t)g_Firmware.GetPtr(), in_stSize);
+   // Сдвиг позиции
+   g_Firmware.Skip(in_stSize);
+}
+
 /**
    Генерация HWID устройства
    на входе    :  in_pHWID    - указатель на буфер куда нужно поместить строку с HWID
@@ -390,13 +414,14 @@ CDevice::CDevice() : CIridiumBusProtocol()
    // Настройка входящего буфера
    m_InBuffer.SetBuffer(m_aInBuffer, IRIDIUM_BUS_IN_BUFFER_SIZE);
    m_InBuffer.Clear();
-
-   // Установка указателей на методы блокирования и разблокирования входящего буфера   
-   m_InBuffer.SetLockUnlock(LockInBuffer, UnLockInBuffer);
    
    // Настройка исходящего буфера
    m_OutBuffer.SetBuffer(IRIDIUM_BUS_MAX_HEADER_SIZE, IRIDIUM_BUS_CRC_SIZE, m_aOutBuffer, sizeof(m_aOutBuffer));
    m_OutBuffer.Clear();
+
+   // Настройка очереди исходящих пакетов
+   m_OutQueue.SetBuffer(IRIDIUM_BUS_OUT_CLASS_PRIORITY, g_aOutQueuePriority, sizeof(g_aOutQueuePriority));
+   m_OutQueue.SetBuffer(IRIDIUM_BUS_OUT_CLASS_NORMAL, g_aOutQueueNormal, sizeof(g_aOutQueueNormal));
    
    // Инициализация параметров протокола
    m_OutPH.m_u8Type              = IRIDIUM_BUS_PROTOCOL_ID;
@@ -424,13 +449,15 @@ CDevice::~CDevice()
    на входе    :  in_pBuffer  - указатель на буфер с данными
                   in_stSize   - размер данных
    на выходе   :  успешность отправки
+   примечание  :  пакет помещается в очередь исходящих пакетов, в CAN порт пакеты переносятся из очереди
+                  по одному с учетом класса приоритета
 */
 bool CDevice::SendPacket(void* in_pBuffer, size_t in_stSize)
 {
    while(1)
    {
-      // Попробуем отправить буфер в шину
-      if(!BUS_Write(true, GetDstAddress(), in_pBuffer, in_stSize))
+      // Попробуем поместить буфер в очередь
+      if(!CIridiumBusProtocol::SendPacket(in_pBuffer, in_stSize))
       {
          // Обработаем входящий буфер во время простоя
          m_InBuffer.FilterNoiseAndForeignPacket(m_Address);
@@ -443,23 +470,28 @@ bool CDevice::SendPacket(void* in_pBuffer, size_t in_stSize)
 }
 
 /**
-   Блокирование доступа к входному буферу
-   на входе    :  *
-   на выходе   :  данные блокировки
-*/
-u8 CDevice::LockInBuffer()
-{
-   //HAL_NVIC_DisableIRQ(USART2_IRQn);
-   return 0;
-}
-
-/**
-   Разблокирование доступа к входному буферу
-   на входе    :  in_pData - данные блокировки
-   на выходе   :  *
+   Отправка пакета, состоящего из нескольких сегментов
+   на входе    :  in_pVec     - указатель на массив сегментов пакета
+                  in_stCount  - количество сегментов
+   на выходе   :  успешность отправки
+   примечание  :  сегменты (например блок потока со ссылкой на данные) собираются сразу в очереди исходящих
+                  пакетов, без предварительной сборки в исходящем буфере
 */
-void CDevice::UnLockInBuffer(u8 in_u8Data)
+bool CDevice::SendPacketV(const iridium_iovec_t* in_pVec, size_t in_stCount)
 {
+   while(1)
+   {
+      // Попробуем поместить сегменты в очередь
+      if(!m_OutQueue.Push(in_pVec, in_stCount))
+      {
+         // Обработаем входящий буфер во время простоя
+         m_InBuffer.FilterNoiseAndForeignPacket(m_Address);
+         // Отправка во внешний CAN порт во время простоя
+         WriteToExtCan();
+      } else
+         break;
+   }
+   return true;
 }
 
 /**
@@ -580,6 +612,16 @@ u8 CDevice::StreamOpen(const char* in_pszName, eIridiumStreamMode in_eMode)
          g_Firmware.SetTime(HAL_GetTick() + FIRMWARE_WAIT_TIME);
          // Установка данных потока
          g_Firmware.Open((u8*)FIRMWARE_START, FIRMWARE_SIZE);
+         // Флеш будет стираться по мере записи
+         g_stFirmwareErased = FIRMWARE_START;
+         // Формат потока станет известен из заголовка
+         g_u8FirmwareFormat = IRIDIUM_FIRMWARE_FORMAT_RAW;
+#if defined(IRIDIUM_ENABLE_STREAM_RESUME)
+         // Поток передается с начала, пока не запрошена точка продолжения
+         g_u32StreamOffset = 0;
+         g_u16StreamCRC = IRIDIUM_STREAM_RESUME_CRC_INIT;
+         g_stResumeSkip = 0;
+#endif
       }
    }
    return l_u8Result;
@@ -612,6 +654,14 @@ size_t CDevice::StreamBlock(u8 in_u8StreamID, u8 in_u8BlockID, size_t in_stSize,
    u8* l_pBuffer = (u8*)in_pBuffer;
    size_t l_stSize = in_stSize;
    bool l_bFirst = false;
+#if defined(IRIDIUM_ENABLE_STREAM_RESUME)
+   size_t l_stCheck = 0;
+   u32 l_u32CheckOffset = 0;
+   u16 l_u16CheckCRC = 0;
+   u16 l_u16StreamCRC = 0;
+   u8 l_aCheckIV[BLOCK_CIPHER_SIZE];
+   u8 l_aStreamIV[BLOCK_CIPHER_SIZE];
+#endif
    
    // Проверка был ли откры поток, идентификатора потока и размер данных
    if(g_Firmware.IsOpen() && g_Firmware.GetStreamID() == in_u8StreamID && in_stSize >= 16)
@@ -627,6 +677,28 @@ size_t CDevice::StreamBlock(u8 in_u8StreamID, u8 in_u8BlockID, size_t in_stSize,
          g_Cipher.Init(g_aKeyAndIV);
       }
       
+#if defined(IRIDIUM_ENABLE_STREAM_RESUME)
+      // Поиск границы точки продолжения по адресу флеш, до которого будет записан блок. Смещение точки в потоке
+      // выравнивается на блок шифра, данные до границы будут пропущены при продолжении
+      l_stCheck = (size_t)g_Firmware.GetPtr() + in_stSize - (l_bFirst ? IRIDIUM_FIRMWARE_HEADER_SIZE : g_stResumeSkip);
+      l_stCheck = FIRMWARE_START + ((l_stCheck - FIRMWARE_START) / FIRMWARE_CHECKPOINT_SIZE) * FIRMWARE_CHECKPOINT_SIZE;
+      l_u32CheckOffset = (u32)((l_stCheck - FIRMWARE_START + IRIDIUM_FIRMWARE_HEADER_SIZE) & ~(BLOCK_CIPHER_SIZE - 1));
+      // Для сжатого потока позиция во флеш не связана со смещением в потоке, точки не сохраняются
+      if(l_stCheck <= (size_t)g_Firmware.GetPtr() || l_u32CheckOffset < g_u32StreamOffset || g_u8FirmwareFormat != IRIDIUM_FIRMWARE_FORMAT_RAW)
+      {
+         l_stCheck = 0;
+         l_u32CheckOffset = g_u32StreamOffset;
+      }
+      // CRC16 потока до точки и до конца блока, блоки шифра перед ними (до декодирования)
+      l_u16CheckCRC = GetCRC16Modbus(g_u16StreamCRC, (u8*)in_pBuffer, l_u32CheckOffset - g_u32StreamOffset);
+      l_u16StreamCRC = GetCRC16Modbus(l_u16CheckCRC, (u8*)in_pBuffer + (l_u32CheckOffset - g_u32StreamOffset), in_stSize - (l_u32CheckOffset - g_u32StreamOffset));
+      if(l_u32CheckOffset > g_u32StreamOffset)
+         memcpy(l_aCheckIV, (u8*)in_pBuffer + (l_u32CheckOffset - g_u32StreamOffset) - BLOCK_CIPHER_SIZE, BLOCK_CIPHER_SIZE);
+      else
+         memcpy(l_aCheckIV, g_aStreamIV, BLOCK_CIPHER_SIZE);
+      memcpy(l_aStreamIV, (u8*)in_pBuffer + in_stSize - BLOCK_CIPHER_SIZE, BLOCK_CIPHER_SIZE);
+#endif
+
       // Декодирование полученого блока
       g_Cipher.Decode((u8*)in_pBuffer, in_stSize);
       
@@ -637,41 +709,68 @@ size_t CDevice::StreamBlock(u8 in_u8StreamID, u8 in_u8BlockID, size_t in_stSize,
       if(l_bFirst)
       {
          // Чтение случайного числа, маркера, размера и контрольной суммы прошивки из заголовка
-         l_pBuffer = ReadU8(l_pBuffer, l_u8Marker);
-         l_pBuffer = ReadU8(l_pBuffer, l_u8Marker);
-         l_pBuffer = ReadU32LE(l_pBuffer, l_u32Size);
-         l_pBuffer = ReadU16LE(l_pBuffer, l_u16CRC);
+         l_pBuffer = (u8*)CIridiumFirmwareStream::ReadHeader(l_pBuffer, l_u8Marker, l_u32Size, l_u16CRC);
          // Уменьшение размера данных на размер заголовка
          l_stSize -= (l_pBuffer - (u8*)in_pBuffer);
          
-         // Проверка размера и маркера
-         if(l_u32Size && l_u8Marker == 0x77)
+         // Проверка размера и формата, загрузчики без поддержки формата отклоняют поток
+         if(l_u32Size && l_u32Size <= FIRMWARE_SIZE && (l_u8Marker == IRIDIUM_FIRMWARE_FORMAT_RAW || l_u8Marker == IRIDIUM_FIRMWARE_FORMAT_LZ))
          {
+            // Подготовка распаковки
+            g_u8FirmwareFormat = l_u8Marker;
+            g_FirmwareStream.Start(l_u32Size);
+
             // Запись информации о прошивке
             EEPROM_WriteU8(EEPROM_U8_MODE, BOOTLOADER_MODE_RUN);
             EEPROM_WriteU32(EEPROM_U32_FIRMWARE_SIZE, l_u32Size);
             EEPROM_WriteU16(EEPROM_U16_FIRMWARE_CRC16, l_u16CRC);
-            
-            // Очистка памяти
-            size_t l_stStart = (size_t)g_Firmware.GetPtr();
-            size_t l_stEnd = (size_t)(g_Firmware.GetPtr() + g_Firmware.GetSize());
-            FLASH_Clear(l_stStart, l_stEnd);
+            // CRC-32 прошивки будет вычислена заново после проверки CRC16
+            EEPROM_WriteU16(EEPROM_U16_FIRMWARE_CRC32_KEY, (u16)~l_u16CRC);
+#if defined(IRIDIUM_ENABLE_STREAM_RESUME)
+            // Сброс точки продолжения предыдущей загрузки
+            EEPROM_WriteU32(EEPROM_U32_FIRMWARE_OFFSET, 0);
+#endif
          } else
          {
             // Ошибка: маркер не найден
             in_stSize = 0;
          }
       }
+#if defined(IRIDIUM_ENABLE_STREAM_RESUME)
+      else if(g_stResumeSkip)
+      {
+         // Пропуск данных, записанных до точки продолжения
+         l_pBuffer += g_stResumeSkip;
+         l_stSize -= g_stResumeSkip;
+      }
+#endif
       
       // Проверка на ошибку
       if(in_stSize)
       {
          // Запись во флеш память
-         FLASH_Write((u8*)l_pBuffer, (size_t)g_Firmware.GetPtr(), l_stSize);
-         // Сдвиг позиции
-         g_Firmware.Skip(l_stSize);
+         if(g_u8FirmwareFormat == IRIDIUM_FIRMWARE_FORMAT_LZ)
+            g_FirmwareStream.Write(l_pBuffer, l_stSize, WriteFirmware);
+         else
+            WriteFirmware(l_pBuffer, l_stSize);
          // Установка времени по истечению которого нужно закрыть поток
          g_Firmware.SetTime(HAL_GetTick() + FIRMWARE_WAIT_TIME);
+#if defined(IRIDIUM_ENABLE_STREAM_RESUME)
+         // Учет принятых данных потока
+         g_u32StreamOffset += in_stSize;
+         g_u16StreamCRC = l_u16StreamCRC;
+         memcpy(g_aStreamIV, l_aStreamIV, BLOCK_CIPHER_SIZE);
+         g_stResumeSkip = 0;
+         // Сохранение точки продолжения, данные до нее уже записаны во флеш
+         if(l_stCheck)
+         {
+            EEPROM_WriteU32(EEPROM_U32_FIRMWARE_OFFSET, l_u32CheckOffset);
+            EEPROM_WriteU16(EEPROM_U16_FIRMWARE_STREAM_CRC, l_u16CheckCRC);
+            EEPROM_WriteU32(EEPROM_U32_FIRMWARE_WRITTEN, (u32)l_stCheck);
+            for(u8 i = 0; i < BLOCK_CIPHER_SIZE; i++)
+               EEPROM_WriteU8(EEPROM_FIRMWARE_IV + i, l_aCheckIV[i]);
+         }
+#endif
       } else
       {
          // Установим текущее время чтобы закрыть поток
@@ -681,8 +780,12 @@ size_t CDevice::StreamBlock(u8 in_u8StreamID, u8 in_u8BlockID, size_t in_stSize,
       // Заблокируем флеш
       HAL_FLASH_Lock();
 
-      // Сохранение информации о прошивке
+      // Сохранение информации о прошивке и точки продолжения
+#if defined(IRIDIUM_ENABLE_STREAM_RESUME)
+      if(l_bFirst || (in_stSize && l_stCheck))
+#else
       if(l_bFirst)
+#endif
          EEPROM_ForceSaveBuffer();
    }
    return in_stSize;
@@ -721,6 +824,56 @@ void CDevice::StreamClose(u8 in_u8StreamID)
    }
 }
 
+#if defined(IRIDIUM_ENABLE_STREAM_RESUME)
+
+/**
+   Обработчик запроса точки продолжения прерванной загрузки прошивки
+   на входе    :  in_u8StreamID  - идентификатор открытого потока
+                  out_rOffset    - ссылка куда нужно поместить смещение в потоке, с которого нужно продолжить передачу
+                  out_rCRC       - ссылка куда нужно поместить CRC16 потока до смещения
+   на выходе   :  true - загрузка продолжается с точки, false - прошивка передается с начала
+   примечание  :  страницы после точки будут стерты перед записью, в них могли попасть блоки принятые после сохранения точки.
+                  Вектор инициализации шифра восстанавливается из последнего блока шифра перед точкой
+*/
+bool CDevice::StreamResume(u8 in_u8StreamID, u32& out_rOffset, u16& out_rCRC)
+{
+   bool l_bResult = false;
+   u8 l_aKeyAndIV[BLOCK_CIPHER_KEY_SIZE + BLOCK_CIPHER_SIZE];
+   u32 l_u32Offset = EEPROM_ReadU32(EEPROM_U32_FIRMWARE_OFFSET);
+   u32 l_u32Written = EEPROM_ReadU32(EEPROM_U32_FIRMWARE_WRITTEN);
+
+   // Проверка открытого с начала потока и сохраненной точки
+   if(g_Firmware.IsOpen() && g_Firmware.GetStreamID() == in_u8StreamID && g_Firmware.GetPtr() == (u8*)FIRMWARE_START &&
+      l_u32Offset && !(l_u32Offset % BLOCK_CIPHER_SIZE) && l_u32Written > FIRMWARE_START && l_u32Written <= FIRMWARE_END &&
+      l_u32Written - FIRMWARE_START + IRIDIUM_FIRMWARE_HEADER_SIZE >= l_u32Offset &&
+      l_u32Written - FIRMWARE_START + IRIDIUM_FIRMWARE_HEADER_SIZE - l_u32Offset < BLOCK_CIPHER_SIZE)
+   {
+      // Восстановление шифра
+      memcpy(l_aKeyAndIV, g_aKeyAndIV, BLOCK_CIPHER_KEY_SIZE);
+      for(u8 i = 0; i < BLOCK_CIPHER_SIZE; i++)
+         l_aKeyAndIV[BLOCK_CIPHER_KEY_SIZE + i] = EEPROM_ReadU8(EEPROM_FIRMWARE_IV + i);
+      g_Cipher.EnableIV(true);
+      g_Cipher.Init(l_aKeyAndIV);
+      memcpy(g_aStreamIV, l_aKeyAndIV + BLOCK_CIPHER_KEY_SIZE, BLOCK_CIPHER_SIZE);
+
+      // Страницы после точки стираются заново по мере записи
+      g_stFirmwareErased = l_u32Written;
+
+      // Сдвиг позиции записи и восстановление состояния потока
+      g_Firmware.Skip(l_u32Written - FIRMWARE_START);
+      g_u32StreamOffset = l_u32Offset;
+      g_u16StreamCRC = EEPROM_ReadU16(EEPROM_U16_FIRMWARE_STREAM_CRC);
+      g_stResumeSkip = l_u32Written - FIRMWARE_START + IRIDIUM_FIRMWARE_HEADER_SIZE - l_u32Offset;
+
+      out_rOffset = l_u32Offset;
+      out_rCRC = g_u16StreamCRC;
+      l_bResult = true;
+   }
+   return l_bResult;
+}
+
+#endif   // defined(IRIDIUM_ENABLE_STREAM_RESUME)
+
 /**
    Инициализация устройства
    на входе    :  *
@@ -741,6 +894,11 @@ void CDevice::Setup()
    
    // Инициализация шины
    BUS_Init();
+
+#if defined(IRIDIUM_ENABLE_STREAM_WINDOW)
+   // Буфер для приема прошивки окном
+   SetStreamBuffer(g_aStreamSlots, sizeof(g_aStreamSlots), IRIDIUM_BUS_MAX_BODY_SIZE);
+#endif
    
    // Установка фильтров
    g_u16CANID = GetCRC16Modbus(1, (u8*)g_pszHWID, sizeof(g_pszHWID));
@@ -784,6 +942,11 @@ void CDevice::Loop()
    
    // Обработка сохранения изменений
    EEPROM_WorkBuffer();
+
+#if defined(IRIDIUM_ENABLE_SEARCH_SLOTS)
+   // Отправка ответа на поиск в слоте устройства
+   ProcessSearch(HAL_GetTick());
+#endif
    
    // Запись во внешний CAN порт
    WriteToExtCan();
@@ -813,8 +976,21 @@ void CDevice::Loop()
       m_InMH.m_u8Type            = IRIDIUM_MESSAGE_STREAM_OPEN;
       m_InMH.m_u16TID            = EEPROM_ReadU16(EEPROM_U16_FIRMWARE_TID);
       
+#if defined(IRIDIUM_ENABLE_STREAM_WINDOW)
+      // Открытие окна приема, если оно было запрошено у прошивки
+      u8 l_u8Window = EEPROM_ReadU8(EEPROM_U8_FIRMWARE_WINDOW);
+      EEPROM_WriteU8(EEPROM_U8_FIRMWARE_WINDOW, 0);
+      if(l_u8Stream && l_u8Window)
+         l_u8Window = OpenStreamWindow(m_pInPH->m_SrcAddr, l_u8Stream, l_u8Window);
+      else
+         l_u8Window = 0;
+
+      // Отправка ответа
+      SendStreamOpenResponse(FIRMWARE_NAME, IRIDIUM_STREAM_MODE_WRITE, l_u8Stream, l_u8Window);
+#else
       // Отправка ответа
       SendStreamOpenResponse(FIRMWARE_NAME, IRIDIUM_STREAM_MODE_WRITE, l_u8Stream);
+#endif
 
       g_bPress = false;
    }
@@ -940,15 +1116,14 @@ void CDevice::ReadFromExtCan()
       // Чтение входящих сообщений
       HAL_CAN_Receive_IT(&hcan, CAN_FIFO0); 
 
+      // Перенос полученных в прерывании фреймов в буфер порта
+      l_pPort->AddFrames(g_CANQueue);
+
       // Получение пакета
       l_bResult = l_pPort->GetPacket(l_pBuffer, l_stSize);
       
-      // Блокирование доступа к порту
-      LockCANPort(&hcan);
-      // Удаление обработанных пакетов
+      // Удаление обработанных пакетов, буфер фреймов изменяется только в основном цикле
       l_pPort->Flush();
-      // Разблокирование доступа к порту
-      UnLockCANPort(&hcan);
       
       // Проверка наличия данных
       if(l_bResult)
@@ -996,6 +1171,9 @@ void CDevice::WriteToExtCan()
    CCANPort* l_pPort = GetCANPort(&hcan);
    if(l_pPort)
    {
+      // Перенос следующего пакета из очереди, если фреймы предыдущего пакета отправлены
+      l_pPort->AddPackets(m_OutQueue, true, 0);
+
       // Получим фрейм для отправки в CAN
       can_frame_t* l_pPtr = l_pPort->GetFrame();
       if(l_pPtr)
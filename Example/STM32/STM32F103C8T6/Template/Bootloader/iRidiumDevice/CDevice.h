@@ -50,11 +50,8 @@ public:
    //////////////////////////////////////////////////////////////////////////
    // Отправка данных
    virtual bool SendPacket(void* in_pBuffer, size_t in_stSize);
+   virtual bool SendPacketV(const iridium_iovec_t* in_pVec, size_t in_stCount);
 
-   // Блокирование/разблокирование входящего буфера (данные методы предназначены для микроконтроллеров
-   // если микроконтроллер получает данные из шины по прерываниям)
-   static u8 LockInBuffer();
-   static void UnLockInBuffer(u8 in_u8Data);
 
    // Настройка
    virtual bool SetLID(char* in_pszHWID, u8 in_u8LID);
@@ -74,6 +71,9 @@ public:
    virtual size_t StreamBlock(u8 in_u8StreamID, u8 in_u8BlockID, size_t in_stSize, const void* in_pBuffer);
    virtual void StreamBlockResult(u8 in_u8StreamID, u8 in_u8BlockID, size_t in_stSize);
    virtual void StreamClose(u8 in_u8StreamID);
+#if defined(IRIDIUM_ENABLE_STREAM_RESUME)
+   virtual bool StreamResume(u8 in_u8StreamID, u32& out_rOffset, u16& out_rCRC);
+#endif
       
    //////////////////////////////////////////////////////////////////////////
    // Собственные методы
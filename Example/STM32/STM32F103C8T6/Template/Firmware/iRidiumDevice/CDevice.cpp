@@ -16,7 +16,9 @@
 
 // Common
 #include "CCanPort.h"
+#include "CByteQueue.h"
 #include "EEPROM.h"
+#include "HardwareCRC.h"
 #include "MemoryMap.h"
 #include "InputOutput.h"
 #include "UTF8.h"
@@ -28,6 +30,7 @@
 
 #define FIRMWARE_READ_STREAM_ID        1           // Идентификатор потока чтения прошивки
 #define FIRMWARE_WRITE_STREAM_ID       2           // Идентификатор потока записи прошивки
+#define FIRMWARE_CHECK_PERIOD          60000       // Период фоновой проверки целостности прошивки (мс)
 
 #define MAX_SAVE_CHANNELS              1           // Максимальное количество сохраняемых каналов
 #define START_SAVE_CHANNEL_INDEX       3           // Начальный индекс сохраняемого канала управления
@@ -61,6 +64,9 @@ u8 g_aEEPROM[EEPROM_MAX];                          // Данные энерго
 
 char g_szTemp[128];                                // Промежуточный буфер
 
+bool g_bFirmwareCheck = false;                     // Выполняется фоновая проверка целостности прошивки
+u32 g_u32FirmwareCheckTime = 0;                    // Время запуска следующей проверки целостности прошивки
+
 // Информация об устройстве
 const iridium_device_info_t g_DeviceInfo =
 {
@@ -308,8 +314,13 @@ static CanRxMsgTypeDef  g_aCanRxMessage;           // Структура для
 
 // Параметры CAN порта для сборки и разборки пакетов
 CCANPort                g_ExtCAN;                  // Данные внешнего CAN порта
-can_frame_t             g_aCANInBuffer[256];       // Массив для приема и сборки CAN пакетов
-can_frame_t             g_aCANOutBuffer[33*8];     // Массив для отправки CAN пакетов
+can_frame_t             g_aCANInBuffer[224];       // Массив для приема и сборки CAN пакетов
+CByteQueue              g_CANQueue;                // Очередь фреймов полученных в прерывании
+u8                      g_aCANQueue[32 * sizeof(can_frame_t)];
+can_frame_t             g_aCANOutBuffer[(IRIDIUM_BUS_OUT_BUFFER_SIZE + IRIDIUM_BUS_CRC_SIZE + 7) / 8]; // Массив для отправки CAN пакетов (один пакет)
+// Буферы очереди исходящих пакетов протокола
+u8                      g_aOutQueuePriority[2 * (IRIDIUM_BUS_OUT_BUFFER_SIZE + IRIDIUM_BUS_CRC_SIZE + IRIDIUM_BUS_OUT_QUEUE_HEADER)];
+u8                      g_aOutQueueNormal[4 * (IRIDIUM_BUS_OUT_BUFFER_SIZE + IRIDIUM_BUS_CRC_SIZE + IRIDIUM_BUS_OUT_QUEUE_HEADER)];
 u16                     g_u16CANID = 0;            // Идентификатор CAN
 
 // Индексы кнопок
@@ -439,38 +450,6 @@ CCANPort* GetCANPort(CAN_HandleTypeDef* in_pCanHandle)
    return l_pResult;
 }
 
-/**
-   Блокирование доступа к CAN порту
-   на входе    :  in_pCanHandle  - указатель на хэндлер порта
-   на выходе   :  *
-*/
-void LockCANPort(CAN_HandleTypeDef* in_pCanHandle)
-{
-   // Проверка на нужный порт
-   if(in_pCanHandle->Instance == CAN1)
-   {
-      // Выключение прерываний CAN 1 на время сдвига буфера во избежании потери данных
-      HAL_NVIC_DisableIRQ(CAN1_RX1_IRQn);
-      HAL_NVIC_DisableIRQ(CAN1_RX0_IRQn);
-   }
-}
-
-/**
-   Блокирование доступа к CAN порту
-   на входе    :  in_pCanHandle  - указатель на хэндлер порта
-   на выходе   :  *
-*/
-void UnLockCANPort(CAN_HandleTypeDef* in_pCanHandle)
-{
-   // Проверка на нужный порт
-   if(in_pCanHandle->Instance == CAN1)
-   {
-      // Включение прерываний CAN 1
-      HAL_NVIC_EnableIRQ(CAN1_RX1_IRQn);
-      HAL_NVIC_EnableIRQ(CAN1_RX0_IRQn);
-   }
-}
-
 /**
    Отправка прерывания приема пакета с CAN
    на входе    :  in_pCanHandle - указатель на структуру CAN
@@ -491,8 +470,8 @@ void HAL_CAN_RxCpltCallback(CAN_HandleTypeDef* in_pCanHandle)
       // Скопируем полезную нагрузку
       memcpy(l_Frame.m_aData, in_pCanHandle->pRxMsg->Data, l_Frame.m_u8Size);
 
-      // Добавление полученого фрейма в буфер
-      l_pPort->AddFrame(&l_Frame);
+      // Добавление полученого фрейма в очередь, фрейм помещается целиком или отбрасывается
+      g_CANQueue.Push(&l_Frame, sizeof(l_Frame));
 
       // Включим прерыване обратно
       HAL_CAN_Receive_IT(in_pCanHandle, CAN_FIFO0);
@@ -531,6 +510,9 @@ void BUS_Init()
    CAN_FilterInitStructure.BankNumber = 14;                 // Важно заполнить это поле
    HAL_CAN_ConfigFilter(&hcan, &CAN_FilterInitStructure);
 
+   // Очередь фреймов инициализируется до включения прерываний
+   g_CANQueue.SetBuffer(g_aCANQueue, sizeof(g_aCANQueue));
+
    HAL_CAN_Receive_IT(&hcan, CAN_FIFO0);
 
    g_ExtCAN.SetCANID(0);
@@ -597,19 +579,6 @@ void BUS_SetFilter(u16 in_u16CanID, u8 in_u8Address)
    HAL_CAN_Receive_IT(&hcan, CAN_FIFO0);
 }
 
-/**
-   Отправка сообщения на шину
-   на входе    :  in_bBroadcast  - признак широковещательно пакета
-                  in_u8Address   - адрес кому предназначен пакет
-                  in_pBuffer     - указатель на отправляемые данные
-                  in_stSize      - размер отправляемых данных
-   на выходе   :  успешность отправки данных
-*/
-bool BUS_Write(bool in_bBroadcast, u8 in_u8Address, void* in_pBuffer, size_t in_stSize)
-{
-   return g_ExtCAN.AddPacket(in_bBroadcast, in_u8Address, in_pBuffer, in_stSize);
-}
-
 /////////////////////////////////////////////////////////////////////////////////////////////////
 //// Работа с таймером
 /////////////////////////////////////////////////////////////////////////////////////////////////
@@ -703,13 +672,14 @@ CDevice::CDevice() : CIridiumBusProtocol()
    // Настройка входящего буфера
    m_InBuffer.SetBuffer(m_aInBuffer, IRIDIUM_BUS_IN_BUFFER_SIZE);
    m_InBuffer.Clear();
-
-   // Установка указателей на методы блокирования и разблокирования входящего буфера   
-   m_InBuffer.SetLockUnlock(LockInBuffer, UnLockInBuffer);
    
    // Настройка исходящего буфера
    m_OutBuffer.SetBuffer(IRIDIUM_BUS_MAX_HEADER_SIZE, IRIDIUM_BUS_CRC_SIZE, m_aOutBuffer, sizeof(m_aOutBuffer));
    m_OutBuffer.Clear();
+
+   // Настройка очереди исходящих пакетов
+   m_OutQueue.SetBuffer(IRIDIUM_BUS_OUT_CLASS_PRIORITY, g_aOutQueuePriority, sizeof(g_aOutQueuePriority));
+   m_OutQueue.SetBuffer(IRIDIUM_BUS_OUT_CLASS_NORMAL, g_aOutQueueNormal, sizeof(g_aOutQueueNormal));
    
    // Инициализация параметров протокола
    m_OutPH.m_u8Type              = IRIDIUM_BUS_PROTOCOL_ID;
@@ -737,13 +707,15 @@ CDevice::~CDevice()
    на входе    :  in_pBuffer  - указатель на буфер с данными
                   in_stSize   - размер данных
    на выходе   :  успешность отправки
+   примечание  :  пакет помещается в очередь исходящих пакетов, в CAN порт пакеты переносятся из очереди
+                  по одному с учетом класса приоритета
 */
 bool CDevice::SendPacket(void* in_pBuffer, size_t in_stSize)
 {
    while(1)
    {
-      // Попробуем отправить буфер в шину
-      if(!BUS_Write(true, GetDstAddress(), in_pBuffer, in_stSize))
+      // Попробуем поместить буфер в очередь
+      if(!CIridiumBusProtocol::SendPacket(in_pBuffer, in_stSize))
       {
          // Обработаем входящий буфер во время простоя
          m_InBuffer.FilterNoiseAndForeignPacket(m_Address);
@@ -756,23 +728,28 @@ bool CDevice::SendPacket(void* in_pBuffer, size_t in_stSize)
 }
 
 /**
-   Блокирование доступа к входному буферу
-   на входе    :  *
-   на выходе   :  данные блокировки
-*/
-u8 CDevice::LockInBuffer()
-{
-   //HAL_NVIC_DisableIRQ(USART2_IRQn);
-   return 0;
-}
-
-/**
-   Разблокирование доступа к входному буферу
-   на входе    :  in_pData - данные блокировки
-   на выходе   :  *
+   Отправка пакета, состоящего из нескольких сегментов
+   на входе    :  in_pVec     - указатель на массив сегментов пакета
+                  in_stCount  - количество сегментов
+   на выходе   :  успешность отправки
+   примечание  :  сегменты (например блок потока со ссылкой на данные) собираются сразу в очереди исходящих
+                  пакетов, без предварительной сборки в исходящем буфере
 */
-void CDevice::UnLockInBuffer(u8 in_u8Data)
+bool CDevice::SendPacketV(const iridium_iovec_t* in_pVec, size_t in_stCount)
 {
+   while(1)
+   {
+      // Попробуем поместить сегменты в очередь
+      if(!m_OutQueue.Push(in_pVec, in_stCount))
+      {
+         // Обработаем входящий буфер во время простоя
+         m_InBuffer.FilterNoiseAndForeignPacket(m_Address);
+         // Отправка во внешний CAN порт во время простоя
+         WriteToExtCan();
+      } else
+         break;
+   }
+   return true;
 }
 
 /**
@@ -1322,6 +1299,10 @@ bool CDevice::SetChannelValue(u32 in_u32ChannelID, u8 in_u8Type, universal_value
          size_t l_stIndex = GetTagIndex(TAG_TEST);
          if(l_stIndex != (size_t)-1)
             SendSetVariableRequest(g_aTagsVariable[l_stIndex], in_u8Type, in_rValue);
+#if defined(IRIDIUM_CONFIG_SUBSCRIBE_TAG_SLAVE)
+         // Значение будет отправлено подписчикам канала
+         SetTagChanged(TAG_TEST);
+#endif
          l_bResult = true;
       }
       break;
@@ -1350,6 +1331,10 @@ u8 CDevice::StreamOpen(const char* in_pszName, eIridiumStreamMode in_eMode)
          EEPROM_WriteU16(EEPROM_U16_FIRMWARE_ADDRESS, GetSrcAddress());
          // Запись идентификатора транзакции
          EEPROM_WriteU16(EEPROM_U16_FIRMWARE_TID, m_InMH.m_u16TID);
+#if defined(IRIDIUM_ENABLE_STREAM_WINDOW)
+         // Запись размера окна, запрошенного для передачи прошивки
+         EEPROM_WriteU8(EEPROM_U8_FIRMWARE_WINDOW, m_u8StreamWindow);
+#endif
          EEPROM_ForceSaveBuffer();
          
          // Осуществим переход в загрузчик через сброс контроллера
@@ -1506,6 +1491,10 @@ void CDevice::Setup()
    
    // Инициализация шины
    BUS_Init();
+
+   // Инициализация блока CRC, первая проверка целостности прошивки будет запущена в основном цикле
+   HWCRC_Init();
+   g_u32FirmwareCheckTime = HAL_GetTick();
    
    // Установка фильтров
    g_u16CANID = GetCRC16Modbus(1, (u8*)g_pszHWID, sizeof(g_pszHWID));
@@ -1531,6 +1520,19 @@ void CDevice::Loop()
    
    // Обработка сохранения изменений
    EEPROM_WorkBuffer();
+
+   // Фоновая проверка целостности прошивки
+   WorkFirmwareCheck();
+
+#if defined(IRIDIUM_CONFIG_SUBSCRIBE_TAG_SLAVE)
+   // Отправка изменений каналов обратной связи подписчикам
+   ProcessSubscriptions(HAL_GetTick());
+#endif
+
+#if defined(IRIDIUM_ENABLE_SEARCH_SLOTS)
+   // Отправка ответа на поиск в слоте устройства
+   ProcessSearch(HAL_GetTick());
+#endif
    
    // Запись во внешний CAN порт
    WriteToExtCan();
@@ -1539,6 +1541,53 @@ void CDevice::Loop()
    ReadFromExtCan();
 }
 
+/**
+   Фоновая проверка целостности прошивки
+   на входе    :  *
+   на выходе   :  *
+   примечание  :  область прошивки передается в блок CRC через DMA, процессор в это время обрабатывает шину.
+                  Результат сравнивается с CRC-32, сохраненной для текущей CRC16 прошивки. Если CRC-32 еще не
+                  вычислялась (после загрузки новой прошивки) или не совпала, прошивка один раз проверяется
+                  по CRC16: при совпадении сохраняется новая CRC-32, иначе прошивка повреждена и устройство
+                  перезагружается в загрузчик
+*/
+void CDevice::WorkFirmwareCheck()
+{
+   u32 l_u32Size = EEPROM_ReadU32(EEPROM_U32_FIRMWARE_SIZE);
+   u16 l_u16CRC = EEPROM_ReadU16(EEPROM_U16_FIRMWARE_CRC16);
+   u32 l_u32CRC = 0;
+
+   // Проверка выполняется
+   if(HWCRC_IsBusy())
+      return;
+
+   if(g_bFirmwareCheck)
+   {
+      // Проверка окончена, сравнение результата
+      g_bFirmwareCheck = false;
+      l_u32CRC = HWCRC_GetResult();
+      if(EEPROM_ReadU16(EEPROM_U16_FIRMWARE_CRC32_KEY) != l_u16CRC || EEPROM_ReadU32(EEPROM_U32_FIRMWARE_CRC32) != l_u32CRC)
+      {
+         if(GetCRC16Modbus(0x77, (u8*)FIRMWARE_START, l_u32Size) == l_u16CRC)
+         {
+            // Прошивка цела, запомним ее CRC-32
+            EEPROM_WriteU32(EEPROM_U32_FIRMWARE_CRC32, l_u32CRC);
+            EEPROM_WriteU16(EEPROM_U16_FIRMWARE_CRC32_KEY, l_u16CRC);
+            EEPROM_NeedSaveBuffer();
+         } else
+            Reboot();
+      }
+      g_u32FirmwareCheckTime = HAL_GetTick() + FIRMWARE_CHECK_PERIOD;
+   } else if((s32)(HAL_GetTick() - g_u32FirmwareCheckTime) >= 0)
+   {
+      // Запуск проверки
+      if(l_u32Size && l_u32Size <= FIRMWARE_SIZE)
+         g_bFirmwareCheck = HWCRC_Start((const u32*)FIRMWARE_START, (l_u32Size + 3) / 4);
+      if(!g_bFirmwareCheck)
+         g_u32FirmwareCheckTime = HAL_GetTick() + FIRMWARE_CHECK_PERIOD;
+   }
+}
+
 /**
    Цикл обработки нажатий
    на входе    :  *
@@ -1677,15 +1726,14 @@ void CDevice::ReadFromExtCan()
       // Чтение входящих сообщений
       HAL_CAN_Receive_IT(&hcan, CAN_FIFO0); 
 
+      // Перенос полученных в прерывании фреймов в буфер порта
+      l_pPort->AddFrames(g_CANQueue);
+
       // Получение пакета
       l_bResult = l_pPort->GetPacket(l_pBuffer, l_stSize);
       
-      // Блокирование доступа к порту
-      LockCANPort(&hcan);
-      // Удаление обработанных пакетов
+      // Удаление обработанных пакетов, буфер фреймов изменяется только в основном цикле
       l_pPort->Flush();
-      // Разблокирование доступа к порту
-      UnLockCANPort(&hcan);
       
       // Проверка наличия данных
       if(l_bResult)
@@ -1733,6 +1781,9 @@ void CDevice::WriteToExtCan()
    CCANPort* l_pPort = GetCANPort(&hcan);
    if(l_pPort)
    {
+      // Перенос следующего пакета из очереди, если фреймы предыдущего пакета отправлены
+      l_pPort->AddPackets(m_OutQueue, true, 0);
+
       // Получим фрейм для отправки в CAN
       can_frame_t* l_pPtr = l_pPort->GetFrame();
       if(l_pPtr)
@@ -50,11 +50,8 @@ public:
    //////////////////////////////////////////////////////////////////////////
    // Отправка данных
    virtual bool SendPacket(void* in_pBuffer, size_t in_stSize);
+   virtual bool SendPacketV(const iridium_iovec_t* in_pVec, size_t in_stCount);
 
-   // Блокирование/разблокирование входящего буфера (данные методы предназначены для микроконтроллеров
-   // если микроконтроллер получает данные из шины по прерываниям)
-   static u8 LockInBuffer();
-   static void UnLockInBuffer(u8 in_u8Data);
    
    virtual iridium_address_t GetAddress()
       { return m_Address; }
@@ -112,6 +109,7 @@ public:
 
 private:
    void WorkInputs();
+   void WorkFirmwareCheck();
    void ChangeVariable(u16 in_u16Variable, u8 in_u8Type, universal_value_t& in_rValue);
 
    bool GetChannelValue(u32 in_u32ChannelID, u8& out_rType, universal_value_t& out_rValue);
@@ -31,6 +31,23 @@
 // Настройка CRC8 и CRC16
 //#define IRIDIUM_ENABLE_FAST_CRC8
 //#define IRIDIUM_ENABLE_FAST_CRC16
+// Подсчет CRC16 входящих пакетов по мере поступления данных (AddByte/Add)
+//#define IRIDIUM_ENABLE_STREAM_CRC16
+
+// Отслеживание ответов на запросы ведущего (таблица транзакций с ожиданием ответа и повторами)
+//#define IRIDIUM_ENABLE_TRANSACTIONS
+
+// Распределение ответов на широковещательный поиск по временным слотам (требует вызова ProcessSearch)
+#define IRIDIUM_ENABLE_SEARCH_SLOTS
+
+// Хэш каталога каналов в ответе на запрос информации об устройстве (кэширование каталога ведущим)
+#define IRIDIUM_ENABLE_CATALOG_HASH
+
+// Передача блоков потока окном с выборочным подтверждением (передающая сторона вызывает ProcessStream)
+#define IRIDIUM_ENABLE_STREAM_WINDOW
+
+// Продолжение прерванной записи потока с точки, сохраненной устройством (работает вместе с окном)
+//#define IRIDIUM_ENABLE_STREAM_RESUME
 
 // Конфигурация протокола
 // Системные
@@ -60,6 +77,10 @@
 #define IRIDIUM_CONFIG_SET_TAG_VALUE_SLAVE
 //#define IRIDIUM_CONFIG_GET_TAG_VALUE_MASTER
 #define IRIDIUM_CONFIG_GET_TAG_VALUE_SLAVE
+//#define IRIDIUM_CONFIG_SUBSCRIBE_TAG_MASTER
+#define IRIDIUM_CONFIG_SUBSCRIBE_TAG_SLAVE
+// Количество подписок: каналы обратной связи устройства для двух ведущих
+#define IRIDIUM_MAX_SUBSCRIPTIONS                     4
 // Работа с каналами управления
 //#define IRIDIUM_CONFIG_GET_CHANNELS_MASTER
 #define IRIDIUM_CONFIG_GET_CHANNELS_SLAVE
@@ -71,6 +92,9 @@
 #define IRIDIUM_CONFIG_GET_CHANNEL_DESCRIPTION_SLAVE
 //#define IRIDIUM_CONFIG_GET_CHANNEL_VALUE_MASTER
 #define IRIDIUM_CONFIG_GET_CHANNEL_VALUE_SLAVE
+// Пакетное выполнение операций с каналами
+//#define IRIDIUM_CONFIG_BATCH_MASTER
+#define IRIDIUM_CONFIG_BATCH_SLAVE
 // Работа с потоками
 //#define IRIDIUM_CONFIG_STREAM_OPEN_MASTER
 #define IRIDIUM_CONFIG_STREAM_OPEN_SLAVE
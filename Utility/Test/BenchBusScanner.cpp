@@ -0,0 +1,304 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+//////////////////////////////////////////////////////////////////////////
+// Замер скорости поиска пакетов во входящем шинном буфере
+//////////////////////////////////////////////////////////////////////////
+// Поток из пакетов и шума подается в буфер частями по 1-4 байта, как из прерывания UART, после каждой
+// части буфер фильтруется. Сравнивается возобновляемый поиск CIridiumBusInBuffer (FilterNoise) и
+// прежний поиск, который после каждой части заново разбирает все необработанные данные побайтно с начала
+// буфера (копия FindBUSPacket до векторного поиска маркера, данные добавляются в CInBuffer без подсчета
+// CRC16 при добавлении). Доля шума - вероятность шума вместо очередного пакета, шум - случайный байт или
+// заголовок оборванного пакета, из-за которого следующие пакеты ожидают проверки до его отбрасывания
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "CIridiumBusInBuffer.h"
+#include "CalcParity.h"
+#include "Bytes.h"
+
+#define BENCH_STREAM_SIZE     (4 * 1024 * 1024)    // Размер потока
+#define BENCH_MAX_CHUNK       4                    // Максимальный размер части потока
+
+static u8 g_aStream[BENCH_STREAM_SIZE + 1024];
+static u8 g_aChunks[BENCH_STREAM_SIZE];
+static u8 g_aBuffer[IRIDIUM_BUS_IN_BUFFER_SIZE];
+
+/**
+   Создание пакета со случайным телом
+   на входе    :  out_pBuffer - указатель на буфер куда нужно поместить пакет
+                  in_stBody   - размер тела пакета без CRC16
+                  in_bAddress - признак пакета с адресами
+   на выходе   :  размер пакета
+*/
+static size_t MakePacket(u8* out_pBuffer, size_t in_stBody, bool in_bAddress)
+{
+   size_t l_stSize = in_stBody + 2;
+   size_t l_stHeader = 3;
+   out_pBuffer[0] = 0x75 | (in_bAddress ? 8 : 0);
+   out_pBuffer[2] = (u8)l_stSize;
+   out_pBuffer[1] = (u8)((GetParity(out_pBuffer[2]) << 7) | (1 << 3));
+   if(in_bAddress)
+   {
+      out_pBuffer[3] = (u8)rand();
+      out_pBuffer[4] = (u8)rand();
+      l_stHeader = 5;
+   }
+   for(size_t i = 0; i < in_stBody; i++)
+      out_pBuffer[l_stHeader + i] = (u8)rand();
+   u16 l_u16CRC = GetCRC16Modbus(0xFFFF, out_pBuffer + l_stHeader, in_stBody);
+   out_pBuffer[l_stHeader + in_stBody] = (u8)l_u16CRC;
+   out_pBuffer[l_stHeader + in_stBody + 1] = (u8)(l_u16CRC >> 8);
+   return l_stHeader + l_stSize;
+}
+
+/**
+   Создание потока
+   на входе    :  in_iNoise - доля шума в процентах
+   на выходе   :  размер потока
+*/
+static size_t MakeStream(int in_iNoise)
+{
+   size_t l_stSize = 0;
+   srand(in_iNoise + 1);
+   while(l_stSize < BENCH_STREAM_SIZE)
+   {
+      if(rand() % 100 < in_iNoise)
+      {
+         // Шум: случайный байт или заголовок оборванного пакета, который ожидает недостающих данных
+         if(rand() % 4)
+            g_aStream[l_stSize++] = (u8)rand();
+         else
+         {
+            bool l_bAddress = rand() & 1;
+            MakePacket(g_aStream + l_stSize, rand() % 200, l_bAddress);
+            l_stSize += l_bAddress ? 5 : 3;
+         }
+      } else
+         l_stSize += MakePacket(g_aStream + l_stSize, rand() % 200, rand() & 1);
+   }
+   for(size_t i = 0; i < BENCH_STREAM_SIZE; i++)
+      g_aChunks[i] = (u8)(rand() % BENCH_MAX_CHUNK + 1);
+   return l_stSize;
+}
+
+/**
+   Получение времени в секундах
+*/
+static double GetTime()
+{
+   struct timespec l_Time;
+   clock_gettime(CLOCK_MONOTONIC, &l_Time);
+   return l_Time.tv_sec + l_Time.tv_nsec / 1e9;
+}
+
+/**
+   Прием потока возобновляемым поиском
+   на входе    :  in_stSize   - размер потока
+                  out_rPackets - ссылка куда нужно поместить количество найденных пакетов
+   на выходе   :  время в секундах
+*/
+static double RunScan(size_t in_stSize, size_t& out_rPackets)
+{
+   CIridiumBusInBuffer l_Buffer;
+   l_Buffer.SetBuffer(g_aBuffer, sizeof(g_aBuffer));
+   l_Buffer.Clear();
+   out_rPackets = 0;
+   double l_dStart = GetTime();
+   for(size_t l_stPos = 0, i = 0; l_stPos < in_stSize; i++)
+   {
+      size_t l_stChunk = g_aChunks[i];
+      if(l_stChunk > in_stSize - l_stPos)
+         l_stChunk = in_stSize - l_stPos;
+      l_stPos += l_Buffer.Add(g_aStream + l_stPos, l_stChunk);
+      while(l_Buffer.FilterNoise())
+         ;
+      while(l_Buffer.OpenPacket())
+      {
+         out_rPackets++;
+         l_Buffer.ClosePacket();
+      }
+   }
+   return GetTime() - l_dStart;
+}
+
+/**
+   Прежний побайтный поиск заголовка пакета для BUS протокола
+   на входе    :  in_pBuffer  - указатель на буфер в котором нужно искать пакет
+                  in_stSize   - размер данных в буфере
+                  out_rInPH   - ссылка на структуру куда нужно поместить данные заголовка
+                  out_rPacket - ссылка на структуру куда нужно поместить данные о пакете
+   на выходе   :  true  - пакет найден
+                  false - пакета в буфере нет
+*/
+static bool FindBUSPacketBytewise(u8* in_pBuffer, size_t in_stSize, iridium_packet_header_t& out_rInPH, iridium_packet_t& out_rPacket)
+{
+   bool l_bResult = false;
+
+   u8 l_u8Byte = 0;
+   u8* l_pPtr = in_pBuffer;
+   size_t l_stSize = in_stSize;
+   // Подготовка структур
+   memset(&out_rPacket, 0, sizeof(out_rPacket));
+   memset(&out_rInPH, 0, sizeof(out_rInPH));
+   out_rPacket.m_stShift = (size_t)-1;
+   // Искать заголовок пока это позволяют данные
+   while(l_stSize >= IRIDIUM_BUS_MIN_HEADER_SIZE)
+   {
+      // Извлечение типа протокола, версии и флагов
+      out_rInPH.m_u8Type            = l_pPtr[0] & IRIDIUM_PROTOCOL_ID_MASK;
+      out_rInPH.m_Flags.m_bPriority = (l_pPtr[0] >> 7) & 1;
+      out_rInPH.m_Flags.m_bAddress  = (l_pPtr[0] >> 3) & 1;
+      out_rInPH.m_Flags.m_bSegment  = (l_pPtr[1] >> 6) & 1;
+      out_rInPH.m_Flags.m_u2Version = (l_pPtr[1] >> 3) & 3;
+      // Получение размера сообщения
+      out_rPacket.m_stSize          = l_pPtr[2];
+
+      // Проверка маркера, версии протокола и минимального размера сообщения
+      if(out_rInPH.m_u8Type == IRIDIUM_BUS_PROTOCOL_ID && out_rInPH.m_Flags.m_u2Version <= IRIDIUM_PROTOCOL_BUS_VERSION && out_rPacket.m_stSize >= IRIDIUM_BUS_MIN_BODY_SIZE)
+      {
+         // Проверка четности размера данных
+         if((l_pPtr[1] >> 7) == GetParity(l_pPtr[2]))
+         {
+            // Вычисление размера заголовка
+            out_rPacket.m_stHeader = IRIDIUM_BUS_MIN_HEADER_SIZE;
+            out_rPacket.m_stHeader += out_rInPH.m_Flags.m_bSegment ? 2 : 0;
+            out_rPacket.m_stHeader += out_rInPH.m_Flags.m_bAddress ? 2 : 0;
+
+            // Проверка наличия данных заголовка в буфере
+            if(l_stSize >= out_rPacket.m_stHeader)
+            {
+               // Получение флага конца цепочки сообщения и типа шифрации
+               out_rInPH.m_Flags.m_u3Crypt = l_pPtr[1] & 7;
+
+               u8* l_pBody = l_pPtr + IRIDIUM_BUS_MIN_HEADER_SIZE;
+
+               // Чтение данных сегмента об источнике и приемнике
+               if(out_rInPH.m_Flags.m_bSegment)
+               {
+                  l_pBody = ReadU8(l_pBody, l_u8Byte);
+                  out_rInPH.m_SrcAddr = l_u8Byte << 8;
+                  l_pBody = ReadU8(l_pBody, l_u8Byte);
+                  out_rInPH.m_DstAddr = l_u8Byte << 8;
+               }
+               // Чтение данных адреса об источнике и приемнике
+               if(out_rInPH.m_Flags.m_bAddress)
+               {
+                  l_pBody = ReadU8(l_pBody, l_u8Byte);
+                  out_rInPH.m_SrcAddr |= l_u8Byte;
+                  l_pBody = ReadU8(l_pBody, l_u8Byte);
+                  out_rInPH.m_DstAddr |= l_u8Byte;
+               }
+
+               // Проверка доступности всех данных контейнера
+               if(l_stSize >= (out_rPacket.m_stHeader + out_rPacket.m_stSize))
+               {
+                  u16 l_u16CRC = 0;
+                  // Получение CRC16 из пакета
+                  out_rPacket.m_stBody = out_rPacket.m_stSize - IRIDIUM_BUS_CRC_SIZE;
+                  ReadU16LE(l_pBody + out_rPacket.m_stBody, l_u16CRC);
+                  // Вычисление CRC16 пакета и справнение с CRC16 из пакета
+                  if(GetCRC16Modbus(0xFFFF, l_pBody, out_rPacket.m_stBody) == l_u16CRC)
+                  {
+                     // Пакет найден, запишем размер тела
+                     out_rPacket.m_stShift = l_pPtr - in_pBuffer;
+                     l_bResult = true;
+                     break;
+                  }
+               } else
+               {
+                  // Если это первый пакет у которого нехватает данных, запомним на него указатель
+                  if(out_rPacket.m_stShift == (size_t)-1)
+                     out_rPacket.m_stShift = l_pPtr - in_pBuffer;
+               }
+            } else
+            {
+               // В буфере недостаточно данных для получения данных заголовка, нужно прекратить поиск заголовков в буфере
+               l_bResult = false;
+               break;
+            }
+         }
+      }
+      // Переход на следующий байт
+      l_pPtr++;
+      l_stSize--;
+   }
+   // Если пакет не найден, начала сообщения нет
+   if(!l_bResult)
+   {
+      out_rPacket.m_stHeader = 0;
+      // Если в буфере не было найдено пакетов с недостающими данными, очистим буфер от мусора
+      if(out_rPacket.m_stShift == (size_t)-1)
+         out_rPacket.m_stShift = l_pPtr - in_pBuffer;
+   }
+
+   return l_bResult;
+}
+
+/**
+   Прием потока полным повторным разбором необработанных данных (поиск до возобновляемого сканера)
+   на входе    :  in_stSize   - размер потока
+                  out_rPackets - ссылка куда нужно поместить количество найденных пакетов
+   на выходе   :  время в секундах
+*/
+static double RunRescan(size_t in_stSize, size_t& out_rPackets)
+{
+   CInBuffer l_Buffer;
+   iridium_packet_header_t l_InPH;
+   iridium_packet_t l_Packet;
+   l_Buffer.SetBuffer(g_aBuffer, sizeof(g_aBuffer));
+   l_Buffer.Clear();
+   out_rPackets = 0;
+   double l_dStart = GetTime();
+   for(size_t l_stPos = 0, i = 0; l_stPos < in_stSize; i++)
+   {
+      size_t l_stChunk = g_aChunks[i];
+      if(l_stChunk > in_stSize - l_stPos)
+         l_stChunk = in_stSize - l_stPos;
+      l_stPos += l_Buffer.Add(g_aStream + l_stPos, l_stChunk);
+      for(;;)
+      {
+         bool l_bFound = FindBUSPacketBytewise((u8*)l_Buffer.GetBuffer(), l_Buffer.Used(), l_InPH, l_Packet);
+         size_t l_stCut = l_Packet.m_stShift + (l_bFound ? l_Packet.m_stHeader + l_Packet.m_stSize : 0);
+         if(l_stCut)
+            l_Buffer.Cut(0, l_stCut);
+         if(!l_bFound)
+            break;
+         out_rPackets++;
+      }
+   }
+   return GetTime() - l_dStart;
+}
+
+int main()
+{
+   static const int l_aNoise[] = { 0, 10, 30, 50, 70, 90 };
+   int l_iResult = 0;
+   printf("noise   rescan MB/s   scan MB/s   speedup   packets\n");
+   for(size_t i = 0; i < sizeof(l_aNoise) / sizeof(l_aNoise[0]); i++)
+   {
+      size_t l_stSize = MakeStream(l_aNoise[i]);
+      size_t l_stOld = 0;
+      size_t l_stNew = 0;
+      double l_dOld = RunRescan(l_stSize, l_stOld);
+      double l_dNew = RunScan(l_stSize, l_stNew);
+      printf("%4d%%   %11.1f   %9.1f   %6.1fx   %zu%s\n", l_aNoise[i], l_stSize / l_dOld / 1e6, l_stSize / l_dNew / 1e6,
+         l_dOld / l_dNew, l_stNew, l_stOld == l_stNew ? "" : " (mismatch)");
+      if(l_stOld != l_stNew)
+         l_iResult = 1;
+   }
+   return l_iResult;
+}
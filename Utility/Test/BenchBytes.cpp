@@ -0,0 +1,188 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+//////////////////////////////////////////////////////////////////////////
+// Замер скорости записи и чтения значений в LE/BE последовательности байт
+//////////////////////////////////////////////////////////////////////////
+// Функции Bytes.h сравниваются с побайтовой реализацией библиотеки (Bytes.cpp собирается в этом же файле
+// в пространстве имен bytewise) на записях из 16, 32 и 64 битных целых и значений с плавающей запятой в LE
+// и BE последовательности байт, записанные данные должны совпадать. Отдельно замеряется AddValue/GetValue
+// всех числовых типов и времени через COutBuffer/CInBuffer. Для замера AddValue/GetValue с побайтовой
+// реализацией библиотека собирается без определения последовательности байт платформы:
+//    make clean && CXXFLAGS="-O2 -g -U__BYTE_ORDER__" make bench
+// Результат в МБ/с записанных и прочитанных данных
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "Bytes.h"
+#include "COutBuffer.h"
+#include "CInBuffer.h"
+
+#define BENCH_BUFFER_SIZE     4096                 // Размер буфера
+#define BENCH_TOTAL_SIZE      (256 * 1024 * 1024)  // Объем данных для одного замера
+#define BENCH_RECORD_SIZE     52                   // Размер записи из значений всех типов
+
+#define BENCH_BARRIER()       __asm__ __volatile__("" ::: "memory")
+
+static u8 g_aBuffer[BENCH_BUFFER_SIZE];
+static u8 g_aExpected[BENCH_BUFFER_SIZE];
+
+#if defined(IRIDIUM_BYTES_INLINE)
+   #define BENCH_MODE         "inline"
+#else
+   #define BENCH_MODE         "bytewise"
+#endif
+
+// Побайтовая реализация библиотеки (Bytes.cpp) в отдельном пространстве имен
+namespace bytewise
+{
+#undef IRIDIUM_BYTES_INLINE
+#include "Bytes.cpp"
+}
+
+// Запись и чтение буфера записями из значений всех типов заданными функциями, чтение выполняется из памяти
+#define BENCH_CODEC(name, prefix) \
+static u64 name(u64 in_u64Seed) \
+{ \
+   u64 l_u64Sum = 0; \
+   u8* l_pPtr = g_aBuffer; \
+   for(size_t i = 0; i + BENCH_RECORD_SIZE <= BENCH_BUFFER_SIZE; i += BENCH_RECORD_SIZE) \
+   { \
+      u64 l_u64Value = in_u64Seed + i; \
+      l_pPtr = prefix WriteU16LE(l_pPtr, (u16)l_u64Value); \
+      l_pPtr = prefix WriteU16BE(l_pPtr, (u16)l_u64Value); \
+      l_pPtr = prefix WriteU32LE(l_pPtr, (u32)l_u64Value); \
+      l_pPtr = prefix WriteU32BE(l_pPtr, (u32)l_u64Value); \
+      l_pPtr = prefix WriteU64LE(l_pPtr, l_u64Value); \
+      l_pPtr = prefix WriteU64BE(l_pPtr, l_u64Value); \
+      l_pPtr = prefix WriteF32LE(l_pPtr, (f32)i); \
+      l_pPtr = prefix WriteF32BE(l_pPtr, (f32)i); \
+      l_pPtr = prefix WriteF64LE(l_pPtr, (f64)l_u64Value); \
+      l_pPtr = prefix WriteF64BE(l_pPtr, (f64)l_u64Value); \
+   } \
+   BENCH_BARRIER(); \
+   l_pPtr = g_aBuffer; \
+   for(size_t i = 0; i + BENCH_RECORD_SIZE <= BENCH_BUFFER_SIZE; i += BENCH_RECORD_SIZE) \
+   { \
+      u16 l_u16Value; u32 l_u32Value; u64 l_u64Value; f32 l_f32Value; f64 l_f64Value; \
+      l_pPtr = prefix ReadU16LE(l_pPtr, l_u16Value); l_u64Sum += l_u16Value; \
+      l_pPtr = prefix ReadU16BE(l_pPtr, l_u16Value); l_u64Sum += l_u16Value; \
+      l_pPtr = prefix ReadU32LE(l_pPtr, l_u32Value); l_u64Sum += l_u32Value; \
+      l_pPtr = prefix ReadU32BE(l_pPtr, l_u32Value); l_u64Sum += l_u32Value; \
+      l_pPtr = prefix ReadU64LE(l_pPtr, l_u64Value); l_u64Sum += l_u64Value; \
+      l_pPtr = prefix ReadU64BE(l_pPtr, l_u64Value); l_u64Sum += l_u64Value; \
+      l_pPtr = prefix ReadF32LE(l_pPtr, l_f32Value); l_u64Sum += (u64)l_f32Value; \
+      l_pPtr = prefix ReadF32BE(l_pPtr, l_f32Value); l_u64Sum += (u64)l_f32Value; \
+      l_pPtr = prefix ReadF64LE(l_pPtr, l_f64Value); l_u64Sum += (u64)l_f64Value; \
+      l_pPtr = prefix ReadF64BE(l_pPtr, l_f64Value); l_u64Sum += (u64)l_f64Value; \
+   } \
+   return l_u64Sum; \
+}
+
+BENCH_CODEC(RunByte, bytewise::)
+BENCH_CODEC(RunLibrary, )
+
+/**
+   Запись и чтение буфера через AddValue/GetValue
+   на входе    :  in_u64Seed  - первичное значение
+   на выходе   :  сумма прочитанных значений
+*/
+static u64 RunValue(u64 in_u64Seed)
+{
+   static const u8 l_aTypes[] = { IVT_S16, IVT_U16, IVT_S32, IVT_U32, IVT_F32, IVT_S64, IVT_U64, IVT_F64, IVT_TIME };
+   COutBuffer l_Out;
+   CInBuffer l_In;
+   universal_value_t l_Value;
+   u64 l_u64Sum = 0;
+   u8 l_u8Type = 0;
+
+   l_Out.SetBuffer(g_aBuffer, sizeof(g_aBuffer));
+   for(size_t i = 0; l_Out.Free() >= 1 + sizeof(u64) + IRIDIUM_VALUE_RESERVE; i++)
+   {
+      size_t l_stRemain = 0;
+      memset(&l_Value, 0, sizeof(l_Value));
+      l_Value.m_u64Value = in_u64Seed + i + 1;
+      l_Value.m_f32Value = (l_aTypes[i % sizeof(l_aTypes)] == IVT_F32) ? (f32)(i + 1) : l_Value.m_f32Value;
+      l_Value.m_f64Value = (l_aTypes[i % sizeof(l_aTypes)] == IVT_F64) ? (f64)(i + 1) : l_Value.m_f64Value;
+      if(l_aTypes[i % sizeof(l_aTypes)] == IVT_TIME)
+      {
+         l_Value.m_Time.m_u8Flags = IRIDIUM_TIME_FLAG_DATE | IRIDIUM_TIME_FLAG_TIME;
+         l_Value.m_Time.m_u16Year = 2019;
+         l_Value.m_Time.m_u8Month = 1 + i % 12;
+         l_Value.m_Time.m_u8Day = 1 + i % 28;
+         l_Value.m_Time.m_u16Milliseconds = (u16)(i % 1000);
+      }
+      l_Out.AddValue(l_aTypes[i % sizeof(l_aTypes)], l_Value, l_stRemain, 0);
+   }
+
+   l_In.SetBuffer(g_aBuffer, l_Out.Size());
+   while(l_In.Size() && l_In.GetValue(l_u8Type, l_Value))
+      l_u64Sum += l_Value.m_u64Value;
+   return l_u64Sum + l_In.Tell();
+}
+
+/**
+   Получение времени в секундах
+*/
+static double GetTime()
+{
+   struct timespec l_Time;
+   clock_gettime(CLOCK_MONOTONIC, &l_Time);
+   return l_Time.tv_sec + l_Time.tv_nsec / 1e9;
+}
+
+/**
+   Замер скорости
+   на входе    :  in_pFunc    - функция записи и чтения буфера
+                  out_rSum    - ссылка куда нужно поместить сумму прочитанных значений
+   на выходе   :  скорость в МБ/с
+*/
+static double Run(u64 (*in_pFunc)(u64), u64& out_rSum)
+{
+   size_t l_stCount = BENCH_TOTAL_SIZE / BENCH_BUFFER_SIZE;
+   u64 l_u64Sum = 0;
+   double l_dStart = GetTime();
+   for(size_t i = 0; i < l_stCount; i++)
+      l_u64Sum += in_pFunc(i);
+   double l_dTime = GetTime() - l_dStart;
+   out_rSum = l_u64Sum;
+   return 2.0 * l_stCount * BENCH_BUFFER_SIZE / l_dTime / 1e6;
+}
+
+int main()
+{
+   u64 l_u64Byte = 0;
+   u64 l_u64Library = 0;
+   u64 l_u64Value = 0;
+   int l_iResult = 0;
+
+   // Записанные данные должны совпадать
+   RunByte(1);
+   memcpy(g_aExpected, g_aBuffer, sizeof(g_aExpected));
+   RunLibrary(1);
+   if(memcmp(g_aExpected, g_aBuffer, sizeof(g_aExpected)))
+      l_iResult = 1;
+
+   double l_dByte = Run(RunByte, l_u64Byte);
+   double l_dLibrary = Run(RunLibrary, l_u64Library);
+   double l_dValue = Run(RunValue, l_u64Value);
+   printf("bytewise        %8.1f MB/s\n", l_dByte);
+   printf("Bytes.h %-8s %8.1f MB/s   %4.1fx%s\n", BENCH_MODE, l_dLibrary, l_dLibrary / l_dByte,
+          (l_iResult || l_u64Byte != l_u64Library) ? " (mismatch)" : "");
+   printf("AddValue/GetValue %6.1f MB/s   sum %016llx\n", l_dValue, (unsigned long long)l_u64Value);
+   if(l_u64Byte != l_u64Library)
+      l_iResult = 1;
+   return l_iResult;
+}
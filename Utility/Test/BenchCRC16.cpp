@@ -0,0 +1,128 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+//////////////////////////////////////////////////////////////////////////
+// Замер скорости вычисления CRC-16 (Modbus)
+//////////////////////////////////////////////////////////////////////////
+// Реализации библиотеки сравниваются с побайтным табличным расчетом (одна таблица на 256 значений)
+// на размерах от 8 байт до 64 КБ. Данные находятся в кэше, результат в МБ/с
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "IridiumCRC16.h"
+
+#define BENCH_MAX_SIZE        (64 * 1024)          // Максимальный размер данных
+#define BENCH_TOTAL_SIZE      (256 * 1024 * 1024)  // Объем данных для одного замера
+
+typedef u16 (*bench_crc16_t)(u16 in_u16Init, const u8* in_pBuffer, size_t in_stSize);
+
+static u8 g_aData[BENCH_MAX_SIZE];
+static u16 g_aTable[256];
+
+/**
+   Побайтное табличное вычисление CRC-16 (Modbus)
+   на входе    :  in_u16Init  - первичное значение
+                  in_pBuffer  - указатель на буфер с данными
+                  in_stSize   - размер данных в буфере
+   на выходе   :  вычисленное значение CRC
+*/
+static u16 GetTableCRC(u16 in_u16Init, const u8* in_pBuffer, size_t in_stSize)
+{
+   while(in_stSize--)
+      in_u16Init = (in_u16Init >> 8) ^ g_aTable[(in_u16Init ^ *in_pBuffer++) & 0xFF];
+   return in_u16Init;
+}
+
+/**
+   Получение времени в секундах
+*/
+static double GetTime()
+{
+   struct timespec l_Time;
+   clock_gettime(CLOCK_MONOTONIC, &l_Time);
+   return l_Time.tv_sec + l_Time.tv_nsec / 1e9;
+}
+
+/**
+   Замер скорости
+   на входе    :  in_pFunc    - функция вычисления CRC
+                  in_stSize   - размер данных
+                  out_rCRC    - ссылка куда нужно поместить итоговое значение CRC
+   на выходе   :  скорость в МБ/с
+*/
+static double Run(bench_crc16_t in_pFunc, size_t in_stSize, u16& out_rCRC)
+{
+   size_t l_stCount = BENCH_TOTAL_SIZE / in_stSize;
+   u16 l_u16CRC = 0xFFFF;
+   double l_dStart = GetTime();
+   for(size_t i = 0; i < l_stCount; i++)
+      l_u16CRC = in_pFunc(l_u16CRC, g_aData, in_stSize);
+   double l_dTime = GetTime() - l_dStart;
+   out_rCRC = l_u16CRC;
+   return l_stCount * in_stSize / l_dTime / 1e6;
+}
+
+int main()
+{
+   static const size_t l_aSizes[] = { 8, 16, 64, 256, 1024, 4096, 16384, 65536 };
+   static const struct
+   {
+      eIridiumCRC16Engine  m_eEngine;
+      const char*          m_pszName;
+   } l_aEngines[] =
+   {
+      { IRIDIUM_CRC16_ENGINE_SLICING,  "slicing" },
+      { IRIDIUM_CRC16_ENGINE_FOLD,     "fold" },
+   };
+   int l_iResult = 0;
+
+   for(u16 b = 0; b < 256; b++)
+   {
+      u16 l_u16CRC = b;
+      for(u8 i = 0; i < 8; i++)
+         l_u16CRC = l_u16CRC & 0x1 ? (l_u16CRC >> 1) ^ 0xA001 : l_u16CRC >> 1;
+      g_aTable[b] = l_u16CRC;
+   }
+   for(size_t i = 0; i < sizeof(g_aData); i++)
+      g_aData[i] = (u8)rand();
+
+   printf("size      table MB/s");
+   for(size_t e = 0; e < sizeof(l_aEngines) / sizeof(l_aEngines[0]); e++)
+      printf("   %8s MB/s   speedup", l_aEngines[e].m_pszName);
+   printf("\n");
+
+   for(size_t i = 0; i < sizeof(l_aSizes) / sizeof(l_aSizes[0]); i++)
+   {
+      u16 l_u16Table = 0;
+      double l_dTable = Run(GetTableCRC, l_aSizes[i], l_u16Table);
+      printf("%6zu   %12.1f", l_aSizes[i], l_dTable);
+      for(size_t e = 0; e < sizeof(l_aEngines) / sizeof(l_aEngines[0]); e++)
+      {
+         if(!SetCRC16Engine(l_aEngines[e].m_eEngine))
+         {
+            printf("   %13s   %7s", "-", "-");
+            continue;
+         }
+         u16 l_u16CRC = 0;
+         double l_dSpeed = Run(GetCRC16Modbus, l_aSizes[i], l_u16CRC);
+         printf("   %13.1f   %6.1fx%s", l_dSpeed, l_dSpeed / l_dTable, l_u16CRC == l_u16Table ? "" : " (mismatch)");
+         if(l_u16CRC != l_u16Table)
+            l_iResult = 1;
+      }
+      printf("\n");
+   }
+   SetCRC16Engine(IRIDIUM_CRC16_ENGINE_AUTO);
+   return l_iResult;
+}
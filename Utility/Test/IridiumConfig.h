@@ -0,0 +1,66 @@
+#ifndef _IRIDIUM_CONFIG_H_INCLUDED_
+#define _IRIDIUM_CONFIG_H_INCLUDED_
+
+// Конфигурация библиотеки для тестов на хосте: шинный протокол, ведущий и ведомый одновременно
+
+// Протоколы
+#define IRIDIUM_ENABLE_BUS_PROTOCOL
+
+// Подсчет CRC16 пакетов при добавлении данных во входящий шинный буфер
+#define IRIDIUM_ENABLE_STREAM_CRC16
+
+// Хэш каталога каналов в ответе на запрос информации об устройстве
+#define IRIDIUM_ENABLE_CATALOG_HASH
+
+// Передача блоков потока окном с выборочным подтверждением и продолжение прерванной записи
+#define IRIDIUM_ENABLE_STREAM_WINDOW
+#define IRIDIUM_ENABLE_STREAM_RESUME
+#define IRIDIUM_STREAM_MAX_TX 8
+
+// Вектор инициализации блочного шифра (поток прошивки загрузчика)
+#define IRIDIUM_ENABLE_IV
+
+// Таблица транзакций ведущего
+#define IRIDIUM_ENABLE_TRANSACTIONS
+
+// Конфигурация протокола
+#define IRIDIUM_CONFIG_SYSTEM_SEARCH_SLAVE
+#define IRIDIUM_CONFIG_SYSTEM_DEVICE_INFO_MASTER
+#define IRIDIUM_CONFIG_SYSTEM_DEVICE_INFO_SLAVE
+#define IRIDIUM_CONFIG_SYSTEM_SET_LID_SLAVE
+#define IRIDIUM_CONFIG_SYSTEM_SMART_API_SLAVE
+
+#define IRIDIUM_CONFIG_SET_VARIABLE_MASTER
+#define IRIDIUM_CONFIG_SET_VARIABLE_SLAVE
+#define IRIDIUM_CONFIG_GET_VARIABLE_MASTER
+#define IRIDIUM_CONFIG_GET_VARIABLE_SLAVE
+
+#define IRIDIUM_CONFIG_GET_TAGS_MASTER
+#define IRIDIUM_CONFIG_GET_TAGS_SLAVE
+#define IRIDIUM_CONFIG_LINK_TAG_AND_VARIABLE_MASTER
+#define IRIDIUM_CONFIG_LINK_TAG_AND_VARIABLE_SLAVE
+#define IRIDIUM_CONFIG_GET_TAG_DESCRIPTION_SLAVE
+#define IRIDIUM_CONFIG_SET_TAG_VALUE_SLAVE
+#define IRIDIUM_CONFIG_GET_TAG_VALUE_MASTER
+#define IRIDIUM_CONFIG_GET_TAG_VALUE_SLAVE
+#define IRIDIUM_CONFIG_SUBSCRIBE_TAG_MASTER
+#define IRIDIUM_CONFIG_SUBSCRIBE_TAG_SLAVE
+
+#define IRIDIUM_CONFIG_GET_CHANNELS_MASTER
+#define IRIDIUM_CONFIG_GET_CHANNELS_SLAVE
+#define IRIDIUM_CONFIG_SET_CHANNEL_VALUE_SLAVE
+#define IRIDIUM_CONFIG_LINK_CHANNEL_AND_VARIABLE_SLAVE
+#define IRIDIUM_CONFIG_GET_CHANNEL_DESCRIPTION_SLAVE
+#define IRIDIUM_CONFIG_GET_CHANNEL_VALUE_SLAVE
+
+#define IRIDIUM_CONFIG_BATCH_MASTER
+#define IRIDIUM_CONFIG_BATCH_SLAVE
+
+#define IRIDIUM_CONFIG_STREAM_OPEN_MASTER
+#define IRIDIUM_CONFIG_STREAM_OPEN_SLAVE
+#define IRIDIUM_CONFIG_STREAM_BLOCK_MASTER
+#define IRIDIUM_CONFIG_STREAM_BLOCK_SLAVE
+#define IRIDIUM_CONFIG_STREAM_CLOSE_MASTER
+#define IRIDIUM_CONFIG_STREAM_CLOSE_SLAVE
+
+#endif   // _IRIDIUM_CONFIG_H_INCLUDED_
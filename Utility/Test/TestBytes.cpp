@@ -0,0 +1,105 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+//////////////////////////////////////////////////////////////////////////
+// Проверка записи и чтения значений в LE/BE последовательности байт (Bytes.h)
+//////////////////////////////////////////////////////////////////////////
+// Каждое значение записывается со всеми смещениями от выравнивания, проверяется порядок байт в буфере,
+// сохранность соседних байт, сдвиг указателя и совпадение прочитанного значения с записанным побитно
+#include <stdio.h>
+#include <string.h>
+#include "Bytes.h"
+
+#define TEST_MAX_SHIFT        16                   // Количество проверяемых смещений
+#define TEST_GUARD            0xA5                 // Значение байт вокруг записанного значения
+
+static int g_iErrors = 0;
+
+/**
+   Проверка записи и чтения значения
+   на входе    :  in_pszName  - название значения
+                  in_pWrite   - функция записи
+                  in_pRead    - функция чтения
+                  in_Value    - значение
+                  in_bBE      - признак BE последовательности байт
+   на выходе   :  *
+*/
+template<typename T> static void Check(const char* in_pszName, u8* (*in_pWrite)(u8*, T), u8* (*in_pRead)(u8*, T&), T in_Value, bool in_bBE)
+{
+   u8 l_aBuffer[TEST_MAX_SHIFT + sizeof(T) + 8];
+   u8 l_aExpected[sizeof(T)];
+   u64 l_u64Bits = 0;
+
+   // Ожидаемая последовательность байт
+   memcpy(&l_u64Bits, &in_Value, sizeof(T));
+   for(size_t i = 0; i < sizeof(T); i++)
+      l_aExpected[in_bBE ? sizeof(T) - 1 - i : i] = (u8)(l_u64Bits >> (8 * i));
+
+   for(size_t l_stShift = 0; l_stShift < TEST_MAX_SHIFT; l_stShift++)
+   {
+      bool l_bResult = true;
+      T l_Value;
+      memset(l_aBuffer, TEST_GUARD, sizeof(l_aBuffer));
+      memset(&l_Value, 0, sizeof(l_Value));
+
+      u8* l_pWrite = in_pWrite(l_aBuffer + l_stShift, in_Value);
+      u8* l_pRead = in_pRead(l_aBuffer + l_stShift, l_Value);
+
+      if(l_pWrite != l_aBuffer + l_stShift + sizeof(T) || l_pRead != l_pWrite)
+         l_bResult = false;
+      if(memcmp(l_aBuffer + l_stShift, l_aExpected, sizeof(T)) || memcmp(&l_Value, &in_Value, sizeof(T)))
+         l_bResult = false;
+      for(size_t i = 0; i < sizeof(l_aBuffer); i++)
+      {
+         if((i < l_stShift || i >= l_stShift + sizeof(T)) && l_aBuffer[i] != TEST_GUARD)
+            l_bResult = false;
+      }
+
+      if(!l_bResult)
+      {
+         printf("%s: shift %zu failed\n", in_pszName, l_stShift);
+         g_iErrors++;
+      }
+   }
+}
+
+#define CHECK(type, name, value) \
+   Check<type>(#name "LE", Write##name##LE, Read##name##LE, value, false); \
+   Check<type>(#name "BE", Write##name##BE, Read##name##BE, value, true)
+
+int main()
+{
+   CHECK(u16, U16, 0x1234);
+   CHECK(u16, U16, 0xFE01);
+   CHECK(s16, S16, -2);
+   CHECK(s16, S16, 0x7F80);
+   CHECK(u32, U32, 0x12345678);
+   CHECK(u32, U32, 0xFEDCBA98);
+   CHECK(s32, S32, -123456789);
+   CHECK(f32, F32, 3.14159f);
+   CHECK(f32, F32, -1.5e-20f);
+   CHECK(u64, U64, 0x0123456789ABCDEFULL);
+   CHECK(u64, U64, 0xFEDCBA9876543210ULL);
+   CHECK(s64, S64, -1234567890123456789LL);
+   CHECK(f64, F64, 2.718281828459045);
+   CHECK(f64, F64, -6.02214076e23);
+   CHECK(size_t, ST, (size_t)0x89ABCDEF);
+
+   Check<u8>("U8", WriteU8, ReadU8, 0xC3, false);
+   Check<s8>("S8", WriteS8, ReadS8, -100, false);
+
+   printf("%d errors\n", g_iErrors);
+   return g_iErrors ? 1 : 0;
+}
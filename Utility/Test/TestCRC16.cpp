@@ -0,0 +1,209 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+//////////////////////////////////////////////////////////////////////////
+// Сверка реализаций CRC-16 (Modbus) с побитным расчетом
+//////////////////////////////////////////////////////////////////////////
+// Каждая доступная на процессоре реализация сравнивается с эталоном на случайных размерах
+// (от 0 до 64 КБ, с упором на границы блоков свертки), смещениях от выравнивания и первичных значениях.
+// Объединение, исправление и потоковое вычисление CRC сверяются с GetCRC16Modbus по всем данным
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "IridiumCRC16.h"
+
+#define TEST_MAX_SIZE         (64 * 1024)          // Максимальный размер данных
+#define TEST_MAX_SHIFT        32                   // Максимальное смещение данных от начала буфера
+#define TEST_ITERATIONS       20000                // Количество проверок для каждой реализации
+#define TEST_MAX_PATCH        64                   // Максимальный размер исправляемого участка
+
+static u8 g_aData[TEST_MAX_SIZE + TEST_MAX_SHIFT];
+
+/**
+   Побитное вычисление CRC-16 (Modbus), эталон
+   на входе    :  in_u16Init  - первичное значение
+                  in_pBuffer  - указатель на буфер с данными
+                  in_stSize   - размер данных в буфере
+   на выходе   :  вычисленное значение CRC
+*/
+static u16 GetReferenceCRC(u16 in_u16Init, const u8* in_pBuffer, size_t in_stSize)
+{
+   while(in_stSize--)
+   {
+      in_u16Init ^= *in_pBuffer++;
+      for(u8 i = 0; i < 8; i++)
+         in_u16Init = in_u16Init & 0x1 ? (in_u16Init >> 1) ^ 0xA001 : in_u16Init >> 1;
+   }
+   return in_u16Init;
+}
+
+/**
+   Получение случайного размера данных
+   на входе    :  in_iIteration  - номер проверки
+   на выходе   :  размер данных
+*/
+static size_t GetSize(int in_iIteration)
+{
+   size_t l_stResult;
+   switch(in_iIteration % 4)
+   {
+   case 0:
+      // Все малые размеры подряд
+      l_stResult = (in_iIteration / 4) % 300;
+      break;
+   case 1:
+      // Около границ блоков по 16 байт
+      l_stResult = (rand() % (TEST_MAX_SIZE / 16)) * 16 + rand() % 3 - 1;
+      break;
+   default:
+      l_stResult = rand() % (TEST_MAX_SIZE + 1);
+      break;
+   }
+   return l_stResult > TEST_MAX_SIZE ? 0 : l_stResult;
+}
+
+/**
+   Сверка текущей реализации с эталоном
+   на входе    :  in_pszName  - название реализации
+   на выходе   :  количество ошибок
+*/
+static int CheckEngine(const char* in_pszName)
+{
+   int l_iErrors = 0;
+   srand(1);
+   for(int i = 0; i < TEST_ITERATIONS; i++)
+   {
+      size_t l_stSize = GetSize(i);
+      size_t l_stShift = rand() % TEST_MAX_SHIFT;
+      u16 l_u16Init = (rand() & 1) ? 0xFFFF : (u16)rand();
+      u16 l_u16Expected = GetReferenceCRC(l_u16Init, g_aData + l_stShift, l_stSize);
+      u16 l_u16CRC = GetCRC16Modbus(l_u16Init, g_aData + l_stShift, l_stSize);
+      if(l_u16CRC != l_u16Expected)
+      {
+         if(l_iErrors < 10)
+            printf("%s: size %zu shift %zu init %04X: %04X, expected %04X\n", in_pszName, l_stSize, l_stShift, l_u16Init, l_u16CRC, l_u16Expected);
+         l_iErrors++;
+      }
+   }
+   return l_iErrors;
+}
+
+/**
+   Сверка объединения, исправления и потокового вычисления CRC с расчетом по всем данным
+   на входе    :  *
+   на выходе   :  количество ошибок
+*/
+static int CheckCombine()
+{
+   static u8 l_aPatched[TEST_MAX_SIZE];
+   int l_iErrors = 0;
+   srand(2);
+   for(int i = 0; i < TEST_ITERATIONS; i++)
+   {
+      size_t l_stSize = GetSize(i);
+      size_t l_stSplit = l_stSize ? rand() % (l_stSize + 1) : 0;
+      u16 l_u16Init = (rand() & 1) ? 0xFFFF : (u16)rand();
+      u16 l_u16Expected = GetCRC16Modbus(l_u16Init, g_aData, l_stSize);
+
+      // Объединение CRC двух соседних участков
+      u16 l_u16A = GetCRC16Modbus(l_u16Init, g_aData, l_stSplit);
+      u16 l_u16B = GetCRC16Modbus(0xFFFF, g_aData + l_stSplit, l_stSize - l_stSplit);
+      u16 l_u16CRC = CombineCRC16Modbus(l_u16A, l_u16B, l_stSize - l_stSplit);
+      if(l_u16CRC != l_u16Expected)
+      {
+         if(l_iErrors < 10)
+            printf("combine: size %zu split %zu init %04X: %04X, expected %04X\n", l_stSize, l_stSplit, l_u16Init, l_u16CRC, l_u16Expected);
+         l_iErrors++;
+      }
+
+      // Потоковое вычисление по частям
+      crc16_stream_t l_Stream;
+      InitCRC16Stream(&l_Stream, l_u16Init);
+      UpdateCRC16Stream(&l_Stream, g_aData, l_stSplit);
+      UpdateCRC16Stream(&l_Stream, g_aData + l_stSplit, l_stSize - l_stSplit);
+      if(l_Stream.m_u16CRC != l_u16Expected || l_Stream.m_stSize != l_stSize)
+      {
+         if(l_iErrors < 10)
+            printf("stream: size %zu split %zu init %04X: %04X/%zu, expected %04X\n", l_stSize, l_stSplit, l_u16Init, l_Stream.m_u16CRC, l_Stream.m_stSize, l_u16Expected);
+         l_iErrors++;
+      }
+
+      // Исправление CRC после изменения участка данных
+      if(l_stSize)
+      {
+         size_t l_stOffset = rand() % l_stSize;
+         size_t l_stPatch = rand() % (TEST_MAX_PATCH + 1);
+         if(l_stPatch > l_stSize - l_stOffset)
+            l_stPatch = l_stSize - l_stOffset;
+         memcpy(l_aPatched, g_aData, l_stSize);
+         for(size_t j = 0; j < l_stPatch; j++)
+            l_aPatched[l_stOffset + j] = (u8)rand();
+         l_u16CRC = PatchCRC16Modbus(l_u16Expected, g_aData + l_stOffset, l_aPatched + l_stOffset, l_stPatch, l_stSize - l_stOffset - l_stPatch);
+         u16 l_u16Patched = GetCRC16Modbus(l_u16Init, l_aPatched, l_stSize);
+         if(l_u16CRC != l_u16Patched)
+         {
+            if(l_iErrors < 10)
+               printf("patch: size %zu offset %zu patch %zu init %04X: %04X, expected %04X\n", l_stSize, l_stOffset, l_stPatch, l_u16Init, l_u16CRC, l_u16Patched);
+            l_iErrors++;
+         }
+      }
+   }
+   return l_iErrors;
+}
+
+int main()
+{
+   static const struct
+   {
+      eIridiumCRC16Engine  m_eEngine;
+      const char*          m_pszName;
+   } l_aEngines[] =
+   {
+      { IRIDIUM_CRC16_ENGINE_SLICING,  "slicing" },
+      { IRIDIUM_CRC16_ENGINE_FOLD,     "fold" },
+      { IRIDIUM_CRC16_ENGINE_AUTO,     "auto" },
+   };
+   int l_iResult = 0;
+
+   for(size_t i = 0; i < sizeof(g_aData); i++)
+      g_aData[i] = (u8)rand();
+
+   // Известное значение "123456789"
+   if(GetCRC16Modbus(0xFFFF, (const u8*)"123456789", 9) != 0x4B37)
+   {
+      printf("check value mismatch\n");
+      l_iResult = 1;
+   }
+
+   for(size_t i = 0; i < sizeof(l_aEngines) / sizeof(l_aEngines[0]); i++)
+   {
+      if(!SetCRC16Engine(l_aEngines[i].m_eEngine))
+      {
+         printf("%-8s not supported\n", l_aEngines[i].m_pszName);
+         continue;
+      }
+      int l_iErrors = CheckEngine(l_aEngines[i].m_pszName);
+      printf("%-8s %d checks, %d errors\n", l_aEngines[i].m_pszName, TEST_ITERATIONS, l_iErrors);
+      if(l_iErrors)
+         l_iResult = 1;
+   }
+   SetCRC16Engine(IRIDIUM_CRC16_ENGINE_AUTO);
+
+   int l_iErrors = CheckCombine();
+   printf("%-8s %d checks, %d errors\n", "combine", TEST_ITERATIONS, l_iErrors);
+   if(l_iErrors)
+      l_iResult = 1;
+   return l_iResult;
+}
@@ -0,0 +1,103 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+//////////////////////////////////////////////////////////////////////////
+// Проверка сохранения кэша каталогов в файл и отображения файла в память
+//////////////////////////////////////////////////////////////////////////
+// Образ сохраняется в файл и отображается в память, затем обновленный образ, собранный из отображенного,
+// сохраняется поверх файла: отображенный образ должен оставаться доступным, новое отображение - содержать
+// обновленную запись. Поврежденный и отсутствующий файлы не подключаются
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "CIridiumCatalogCache.h"
+
+#define TEST_CACHE_PATH       "build/TestCatalogCache.bin"
+
+static int g_iErrors = 0;
+
+/**
+   Проверка условия
+   на входе    :  in_bCondition  - условие
+                  in_pszName     - название проверки
+   на выходе   :  *
+*/
+static void Check(bool in_bCondition, const char* in_pszName)
+{
+   printf("%-32s %s\n", in_pszName, in_bCondition ? "ok" : "FAILED");
+   if(!in_bCondition)
+      g_iErrors++;
+}
+
+/**
+   Проверка данных каталога в образе
+   на входе    :  in_rCache      - ссылка на кэш
+                  in_pszHWID     - HWID устройства
+                  in_u32Version  - версия устройства
+                  in_u32Catalog  - хэш каталога
+                  in_pszData     - ожидаемые данные каталога
+   на выходе   :  true - каталог найден и совпадает
+*/
+static bool IsCatalog(CIridiumCatalogCache& in_rCache, const char* in_pszHWID, u32 in_u32Version, u32 in_u32Catalog, const char* in_pszData)
+{
+   size_t l_stSize = 0;
+   const void* l_pData = in_rCache.Find(in_pszHWID, in_u32Version, in_u32Catalog, l_stSize);
+   return l_pData && l_stSize == strlen(in_pszData) && !memcmp(l_pData, in_pszData, l_stSize);
+}
+
+int main()
+{
+   static u8 l_aImage[512];
+   static u8 l_aUpdate[512];
+   CIridiumCatalogCache l_Cache;
+   CIridiumCatalogCache l_Mapped;
+   CIridiumCatalogCache l_Update;
+   CIridiumCatalogCache l_Reload;
+
+   unlink(TEST_CACHE_PATH);
+   Check(!l_Mapped.MapFile(TEST_CACHE_PATH), "missing file");
+
+   // Сохранение и отображение образа
+   l_Cache.Create(l_aImage, sizeof(l_aImage));
+   l_Cache.Add("HW-1", 1, 0x1111, "tags-1", 6);
+   l_Cache.Add("HW-2", 3, 0x2222, "tags-2", 6);
+   Check(l_Cache.SaveFile(TEST_CACHE_PATH), "save");
+   Check(l_Mapped.MapFile(TEST_CACHE_PATH) && l_Mapped.GetCount() == 2, "map");
+   Check(IsCatalog(l_Mapped, "HW-1", 1, 0x1111, "tags-1") && IsCatalog(l_Mapped, "HW-2", 3, 0x2222, "tags-2"), "find mapped");
+
+   // Обновление каталога одного устройства и замена файла при отображенном предыдущем образе
+   l_Update.Create(l_aUpdate, sizeof(l_aUpdate));
+   l_Update.Copy(l_Mapped, "HW-1");
+   l_Update.Add("HW-1", 2, 0x3333, "tags-1b", 7);
+   Check(l_Update.SaveFile(TEST_CACHE_PATH), "save over mapped");
+   Check(IsCatalog(l_Mapped, "HW-1", 1, 0x1111, "tags-1"), "old mapping intact");
+   Check(l_Reload.MapFile(TEST_CACHE_PATH) && IsCatalog(l_Reload, "HW-1", 2, 0x3333, "tags-1b") &&
+      IsCatalog(l_Reload, "HW-2", 3, 0x2222, "tags-2") && !IsCatalog(l_Reload, "HW-1", 1, 0x1111, "tags-1"), "reload updated");
+   l_Mapped.Close();
+   l_Reload.Close();
+
+   // Поврежденный файл
+   FILE* l_pFile = fopen(TEST_CACHE_PATH, "r+b");
+   if(l_pFile)
+   {
+      fseek(l_pFile, 8, SEEK_SET);
+      fputc(0xFF, l_pFile);
+      fclose(l_pFile);
+   }
+   Check(!l_Reload.MapFile(TEST_CACHE_PATH), "corrupt file");
+   unlink(TEST_CACHE_PATH);
+
+   return g_iErrors ? 1 : 0;
+}
@@ -0,0 +1,395 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+//////////////////////////////////////////////////////////////////////////
+// Проверка масштабирования параллельной прошивки на модели шины
+//////////////////////////////////////////////////////////////////////////
+// Ведущий с CIridiumFlasher и N ведомых-загрузчиков соединены моделью полудуплексной шины 115200 бод:
+// пакеты передаются по одному, время передачи пропорционально размеру. Каждый загрузчик принимает только
+// адресованные ему пакеты, пишет каждый блок во флеш TEST_WRITE_TIME мс и в это время не разбирает входящие
+// пакеты. Одно устройство ограничено записью флеш, поэтому пока одно устройство пишет, шина занята блоками
+// других: время прошивки одного устройства T(N) / N должно падать с ростом N, пока шина не станет узким
+// местом, а T(N) не должно превышать нижнюю границу max(T(1), N * B(1)) больше чем в TEST_MAX_BUS_FACTOR
+// раз, где B(1) - время занятости шины при прошивке одного устройства. Дополнительно проверяются загрузчики
+// без окна и потери пакетов
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CIridiumBusProtocol.h"
+#include "CIridiumFlasher.h"
+
+#define TEST_BUS_RATE         11.52                // Скорость шины в байтах за миллисекунду (115200 бод)
+#define TEST_WRITE_TIME       40                   // Время записи блока во флеш загрузчиком в миллисекундах
+#define TEST_MASTER_PACKETS   2                    // Количество пакетов ведущего в очереди передатчика
+#define TEST_MAX_SLAVES       16                   // Максимальное количество ведомых
+#define TEST_WIRE_PACKETS     1024                 // Размер очереди пакетов на шине
+#define TEST_RX_PACKETS       64                   // Размер очереди входящих пакетов ведомого
+#define TEST_IMAGE_SIZE       (250 * IRIDIUM_FLASHER_BLOCK_SIZE - 55) // Размер образа прошивки
+#define TEST_MAX_TIME         2000000              // Максимальное время прошивки в миллисекундах
+#define TEST_MAX_BUS_FACTOR   1.15                 // Максимальное отношение T(N) к нижней границе времени прошивки
+
+// Пакет на шине
+typedef struct test_packet_s
+{
+   u8       m_aData[IRIDIUM_BUS_OUT_BUFFER_SIZE + IRIDIUM_BUS_CRC_SIZE]; // Данные пакета
+   u16      m_u16Size;                             // Размер пакета
+   int      m_iFrom;                               // Номер отправителя (0 - ведущий)
+   double   m_dTime;                               // Время окончания передачи пакета
+} test_packet_t;
+
+// Очередь пакетов
+typedef struct test_queue_s
+{
+   test_packet_t* m_pPackets;                      // Пакеты
+   size_t         m_stMax;                         // Размер очереди
+   size_t         m_stRead;                        // Индекс первого пакета
+   size_t         m_stCount;                       // Количество пакетов
+} test_queue_t;
+
+static u8 g_aImage[TEST_IMAGE_SIZE];
+static test_packet_t g_aWire[TEST_WIRE_PACKETS];
+static test_packet_t g_aRx[TEST_MAX_SLAVES][TEST_RX_PACKETS];
+static test_queue_t g_Wire = { g_aWire, TEST_WIRE_PACKETS, 0, 0 };
+static double g_dNow = 0;                          // Текущее время
+static double g_dBusFree = 0;                      // Время освобождения шины
+static double g_dBusTime = 0;                      // Суммарное время занятости шины
+static int g_iMasterPackets = 0;                   // Количество пакетов ведущего на шине
+static int g_iLoss = 0;                            // Вероятность потери пакета в процентах
+static unsigned g_uSeed = 1;
+
+/**
+   Получение псевдослучайного числа (одинаковая последовательность на всех платформах)
+*/
+static unsigned GetRandom()
+{
+   g_uSeed = g_uSeed * 1103515245 + 12345;
+   return (g_uSeed >> 16) & 0x7FFF;
+}
+
+/**
+   Добавление пакета в конец очереди
+   на входе    :  io_rQueue   - ссылка на очередь
+                  in_rPacket  - ссылка на пакет
+   на выходе   :  успешность, false - очередь заполнена
+*/
+static bool Push(test_queue_t& io_rQueue, const test_packet_t& in_rPacket)
+{
+   bool l_bResult = false;
+   if(io_rQueue.m_stCount < io_rQueue.m_stMax)
+   {
+      io_rQueue.m_pPackets[(io_rQueue.m_stRead + io_rQueue.m_stCount++) % io_rQueue.m_stMax] = in_rPacket;
+      l_bResult = true;
+   }
+   return l_bResult;
+}
+
+/**
+   Удаление пакета из начала очереди
+   на входе    :  io_rQueue   - ссылка на очередь
+   на выходе   :  *
+*/
+static void Pop(test_queue_t& io_rQueue)
+{
+   io_rQueue.m_stRead = (io_rQueue.m_stRead + 1) % io_rQueue.m_stMax;
+   io_rQueue.m_stCount--;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// class CTestNode
+//////////////////////////////////////////////////////////////////////////
+// Узел шины: ведущий передает события потоков флешеру, ведомый принимает образ как загрузчик
+class CTestNode : public CIridiumBusProtocol
+{
+public:
+   CTestNode(int in_iIndex, CIridiumFlasher* in_pFlasher, bool in_bLegacy)
+   {
+      m_OutBuffer.SetBuffer(IRIDIUM_BUS_MAX_HEADER_SIZE, IRIDIUM_BUS_CRC_SIZE, m_aOut, sizeof(m_aOut));
+      m_OutPH.m_u8Type = IRIDIUM_BUS_PROTOCOL_ID;
+      SetStreamBuffer(m_aSlots, sizeof(m_aSlots), IRIDIUM_FLASHER_BLOCK_SIZE);
+      m_iIndex = in_iIndex;
+      m_pFlasher = in_pFlasher;
+      m_bLegacy = in_bLegacy;
+      m_dBusy = 0;
+      m_bBlock = false;
+      m_stSink = 0;
+      m_Rx.m_pPackets = in_iIndex ? g_aRx[in_iIndex - 1] : NULL;
+      m_Rx.m_stMax = TEST_RX_PACKETS;
+      m_Rx.m_stRead = 0;
+      m_Rx.m_stCount = 0;
+   }
+
+   // Отправка пакета на шину
+   virtual bool SendPacket(void* in_pBuffer, size_t in_stSize)
+   {
+      test_packet_t l_Packet;
+      bool l_bResult = false;
+
+      // Очередь передатчика ведущего ограничена, флешер должен повторить отправку позже
+      if(m_iIndex || g_iMasterPackets < TEST_MASTER_PACKETS)
+      {
+         double l_dStart = (g_dBusFree > g_dNow) ? g_dBusFree : g_dNow;
+         g_dBusFree = l_dStart + in_stSize / TEST_BUS_RATE;
+         g_dBusTime += in_stSize / TEST_BUS_RATE;
+         l_bResult = true;
+         if(!g_iLoss || (int)(GetRandom() % 100) >= g_iLoss)
+         {
+            memcpy(l_Packet.m_aData, in_pBuffer, in_stSize);
+            l_Packet.m_u16Size = (u16)in_stSize;
+            l_Packet.m_iFrom = m_iIndex;
+            l_Packet.m_dTime = g_dBusFree;
+            if(Push(g_Wire, l_Packet) && !m_iIndex)
+               g_iMasterPackets++;
+         }
+      }
+      return l_bResult;
+   }
+
+   // Разбор полученного пакета
+   void Receive(test_packet_t& in_rPacket)
+   {
+      m_bBlock = false;
+      m_InBuffer.SetBuffer(in_rPacket.m_aData, in_rPacket.m_u16Size);
+      m_InBuffer.FilterNoiseAndForeignPacket(m_Address);
+      while(m_InBuffer.OpenPacket())
+      {
+         ProcessMessage(m_InBuffer.GetPacketHeader(), m_InBuffer.GetMessagePtr(), m_InBuffer.GetMessageSize());
+         m_InBuffer.ClosePacket();
+      }
+      // Загрузчик занят записью блока
+      if(m_bBlock)
+         m_dBusy = g_dNow + TEST_WRITE_TIME;
+   }
+
+   // Проверка адресации пакета ведомому (широковещательные пакеты принимают все)
+   bool IsOwn(test_packet_t& in_rPacket) const
+   {
+      iridium_packet_header_t l_PH;
+      iridium_packet_t l_Packet;
+      CIridiumBusInBuffer::ParseBUSHeader(in_rPacket.m_aData, in_rPacket.m_u16Size, l_PH, l_Packet);
+      return !l_PH.m_Flags.m_bAddress || l_PH.m_DstAddr == m_Address;
+   }
+
+   // Обработка очереди входящих пакетов ведомого
+   void Process()
+   {
+      if(m_dBusy <= g_dNow && m_Rx.m_stCount)
+      {
+         test_packet_t& l_rPacket = m_Rx.m_pPackets[m_Rx.m_stRead];
+         Receive(l_rPacket);
+         Pop(m_Rx);
+      }
+   }
+
+   // Проверка принятого образа
+   bool IsImage() const
+      { return m_stSink == sizeof(g_aImage) && !memcmp(m_aSink, g_aImage, sizeof(g_aImage)); }
+
+   test_queue_t   m_Rx;                            // Очередь входящих пакетов ведомого
+
+protected:
+   // Ведомый
+   virtual u8 StreamOpen(const char* in_pszName, eIridiumStreamMode in_eMode)
+   {
+      m_stSink = 0;
+      if(m_bLegacy)
+         m_u8StreamWindow = 0;
+      else
+         OpenStreamWindow(1, 7, m_u8StreamWindow);
+      return 7;
+   }
+   virtual size_t StreamBlock(u8 in_u8StreamID, u8 in_u8BlockID, size_t in_stSize, const void* in_pBuffer)
+   {
+      if(m_stSink + in_stSize > sizeof(m_aSink))
+         in_stSize = 0;
+      memcpy(m_aSink + m_stSink, in_pBuffer, in_stSize);
+      m_stSink += in_stSize;
+      m_bBlock = true;
+      return in_stSize;
+   }
+   virtual void StreamClose(u8 in_u8StreamID)
+   {
+      if(m_pFlasher)
+         m_pFlasher->StreamClose(GetSrcAddress(), in_u8StreamID);
+   }
+
+   // Ведущий
+   virtual void StreamOpenResult(const char* in_pszName, eIridiumStreamMode in_eMode, u8 in_u8StreamID)
+      { m_pFlasher->StreamOpenResult(GetSrcAddress(), in_u8StreamID); }
+   virtual void StreamResumeResult(iridium_address_t in_SrcAddr, u8 in_u8StreamID, u32 in_u32Offset, u16 in_u16CRC)
+      { m_pFlasher->StreamResumeResult(in_SrcAddr, in_u8StreamID, in_u32Offset, in_u16CRC); }
+   virtual void StreamBlockResult(u8 in_u8StreamID, u8 in_u8BlockID, size_t in_stSize)
+      { m_pFlasher->StreamBlockResult(GetSrcAddress(), in_u8StreamID, in_u8BlockID, in_stSize); }
+   virtual bool StreamGetBlock(iridium_address_t in_DstAddr, u8 in_u8StreamID, u32 in_u32Index, const void*& out_rBlock, u16& out_rSize)
+      { return m_pFlasher->StreamGetBlock(in_DstAddr, in_u8StreamID, in_u32Index, out_rBlock, out_rSize); }
+   virtual void StreamComplete(iridium_address_t in_DstAddr, u8 in_u8StreamID, bool in_bSuccess)
+      { m_pFlasher->StreamComplete(in_DstAddr, in_u8StreamID, in_bSuccess); }
+
+private:
+   u8                m_aOut[IRIDIUM_BUS_OUT_BUFFER_SIZE]; // Буфер исходящего пакета
+   u8                m_aSlots[3 * IRIDIUM_FLASHER_BLOCK_SIZE]; // Буфер блоков окна приема
+   u8                m_aSink[TEST_IMAGE_SIZE];     // Принятый образ
+   size_t            m_stSink;                     // Размер принятого образа
+   int               m_iIndex;                     // Номер узла (0 - ведущий)
+   CIridiumFlasher*  m_pFlasher;                   // Флешер ведущего
+   bool              m_bLegacy;                    // Признак загрузчика без поддержки окна
+   double            m_dBusy;                      // Время окончания записи блока
+   bool              m_bBlock;                     // Признак получения блока в последнем пакете
+};
+
+/**
+   Прошивка устройств на модели шины
+   на входе    :  in_iSlaves  - количество ведомых
+                  in_iLegacy  - маска ведомых без поддержки окна
+                  in_iLoss    - вероятность потери пакета в процентах
+                  out_rTime   - ссылка куда нужно поместить время прошивки в миллисекундах
+                  out_rBus    - ссылка куда нужно поместить время занятости шины в миллисекундах
+   на выходе   :  true - все устройства прошиты и образы совпадают
+*/
+static bool Run(int in_iSlaves, int in_iLegacy, int in_iLoss, u32& out_rTime, double& out_rBus)
+{
+   static CIridiumFlasher l_Flasher;
+   CTestNode* l_apNodes[TEST_MAX_SLAVES + 1];
+   int l_iDone = 0;
+   u32 l_u32Time = 0;
+
+   g_dNow = 0;
+   g_dBusFree = 0;
+   g_dBusTime = 0;
+   g_iMasterPackets = 0;
+   g_iLoss = in_iLoss;
+   g_Wire.m_stRead = 0;
+   g_Wire.m_stCount = 0;
+
+   l_Flasher.Clear();
+   l_apNodes[0] = new CTestNode(0, &l_Flasher, false);
+   l_apNodes[0]->SetAddress(1);
+   l_Flasher.Init(l_apNodes[0]);
+   l_Flasher.SetImage(g_aImage, sizeof(g_aImage), IRIDIUM_FLASHER_BLOCK_SIZE);
+   for(int i = 0; i < in_iSlaves; i++)
+   {
+      l_apNodes[i + 1] = new CTestNode(i + 1, NULL, (in_iLegacy >> i) & 1);
+      l_apNodes[i + 1]->SetAddress((iridium_address_t)(10 + i));
+      l_Flasher.Add((iridium_address_t)(10 + i), 0);
+   }
+
+   for( ; l_u32Time < TEST_MAX_TIME && l_Flasher.IsActive(); l_u32Time++)
+   {
+      g_dNow = l_u32Time;
+      // Доставка переданных пакетов: ведущий разбирает пакеты сразу, ведомые - свои пакеты когда не пишут флеш
+      while(g_Wire.m_stCount && g_Wire.m_pPackets[g_Wire.m_stRead].m_dTime <= g_dNow)
+      {
+         test_packet_t& l_rPacket = g_Wire.m_pPackets[g_Wire.m_stRead];
+         if(!l_rPacket.m_iFrom)
+            g_iMasterPackets--;
+         for(int i = 0; i <= in_iSlaves; i++)
+         {
+            if(i == l_rPacket.m_iFrom)
+               continue;
+            if(!i)
+               l_apNodes[0]->Receive(l_rPacket);
+            else if(l_apNodes[i]->IsOwn(l_rPacket))
+               Push(l_apNodes[i]->m_Rx, l_rPacket);
+         }
+         Pop(g_Wire);
+      }
+      for(int i = 1; i <= in_iSlaves; i++)
+         l_apNodes[i]->Process();
+      l_Flasher.Process(l_u32Time);
+   }
+
+   for(int i = 0; i < in_iSlaves; i++)
+   {
+      const iridium_flash_device_t* l_pDevice = l_Flasher.GetDevice(i);
+      if(l_pDevice->m_eState == IRIDIUM_FLASH_DONE && l_apNodes[i + 1]->IsImage())
+         l_iDone++;
+   }
+   for(int i = 0; i <= in_iSlaves; i++)
+      delete l_apNodes[i];
+
+   out_rTime = l_u32Time;
+   out_rBus = g_dBusTime;
+   return l_iDone == in_iSlaves;
+}
+
+/**
+   Прошивка устройств без проверки масштабирования
+   на входе    :  in_pszName  - название проверки
+                  in_iSlaves  - количество ведомых
+                  in_iLegacy  - маска ведомых без поддержки окна
+                  in_iLoss    - вероятность потери пакета в процентах
+   на выходе   :  true - все устройства прошиты и образы совпадают
+*/
+static bool Check(const char* in_pszName, int in_iSlaves, int in_iLegacy, int in_iLoss)
+{
+   u32 l_u32Time = 0;
+   double l_dBus = 0;
+   bool l_bResult = Run(in_iSlaves, in_iLegacy, in_iLoss, l_u32Time, l_dBus);
+   printf("%-28s %u ms%s\n", in_pszName, l_u32Time, l_bResult ? "" : " (not flashed)");
+   return l_bResult;
+}
+
+int main()
+{
+   static const int l_aSlaves[] = { 1, 2, 4, 8, 16 };
+   int l_iResult = 0;
+   u32 l_u32Single = 0;
+   double l_dSingleBus = 0;
+   double l_dPrevious = 0;
+
+   for(size_t i = 0; i < sizeof(g_aImage); i++)
+      g_aImage[i] = (u8)GetRandom();
+
+   printf("slaves   parallel ms   serial ms   per device ms   bus bound ms   to bound\n");
+   for(size_t i = 0; i < sizeof(l_aSlaves) / sizeof(l_aSlaves[0]); i++)
+   {
+      u32 l_u32Time = 0;
+      double l_dBus = 0;
+      const char* l_pszError = "";
+
+      if(!Run(l_aSlaves[i], 0, 0, l_u32Time, l_dBus))
+         l_pszError = " (not flashed)";
+      // Одно устройство - основа последовательной прошивки и занятости шины
+      if(!i)
+      {
+         l_u32Single = l_u32Time;
+         l_dSingleBus = l_dBus;
+      }
+
+      double l_dDevice = (double)l_u32Time / l_aSlaves[i];
+      double l_dBound = l_aSlaves[i] * l_dSingleBus;
+      if(l_dBound < l_u32Single)
+         l_dBound = l_u32Single;
+      double l_dFactor = l_u32Time / l_dBound;
+
+      // Время на устройство падает пока шина не занята полностью, затем T(N) держится у нижней границы
+      if(!*l_pszError && i && l_dDevice > l_dPrevious)
+         l_pszError = " (per device time grows)";
+      if(!*l_pszError && l_dFactor > TEST_MAX_BUS_FACTOR)
+         l_pszError = " (far from bus bound)";
+      printf("%6d   %11u   %9u   %13.0f   %12.0f   %8.2f%s\n", l_aSlaves[i], l_u32Time, l_aSlaves[i] * l_u32Single,
+         l_dDevice, l_dBound, l_dFactor, l_pszError);
+      if(*l_pszError)
+         l_iResult = 1;
+      l_dPrevious = l_dDevice;
+   }
+
+   // Загрузчики без окна вперемешку с оконными и потери пакетов
+   if(!Check("4 slaves, 2 without window:", 4, 0x5, 0))
+      l_iResult = 1;
+   if(!Check("8 slaves, 3% packet loss:", 8, 0, 3))
+      l_iResult = 1;
+
+   return l_iResult;
+}
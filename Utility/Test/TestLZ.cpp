@@ -0,0 +1,277 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+//////////////////////////////////////////////////////////////////////////
+// Проверка сжатия и потоковой распаковки прошивки (CIridiumLZ, CIridiumFirmwareStream)
+//////////////////////////////////////////////////////////////////////////
+// Данные сжимаются Encode и распаковываются Decode частями нечетных размеров, как загрузчик получает
+// блоки потока. Подача сжатых данных по 1 байту делит каждую ссылку между вызовами Decode по байтам,
+// выходной буфер в 1 байт делит между вызовами копирование каждой ссылки. Затем из данных готовится
+// зашифрованный поток прошивки, который разбирается как в загрузчике: блоки потока расшифровываются по
+// одному, из первого читается заголовок, образ записывается частями через CIridiumFirmwareStream::Write
+#include <stdio.h>
+#include <string.h>
+#include "CIridiumLZ.h"
+#include "CIridiumFirmwareStream.h"
+#include "CIridiumCipherGrasshopper.h"
+#include "IridiumCRC16.h"
+
+#define TEST_MAX_SIZE         4099                 // Максимальный размер исходных данных
+#define TEST_MAX_ENCODED      (TEST_MAX_SIZE + (TEST_MAX_SIZE + 7) / 8) // Размер сжатых данных в худшем случае
+#define TEST_MAX_STREAM       (IRIDIUM_FIRMWARE_HEADER_SIZE + TEST_MAX_ENCODED + BLOCK_CIPHER_SIZE) // Размер потока прошивки в худшем случае
+#define TEST_RANDOM           0x5C                 // Случайное число заголовка потока
+
+static u8 g_aData[TEST_MAX_SIZE];
+static u8 g_aEncoded[TEST_MAX_ENCODED];
+static u8 g_aDecoded[TEST_MAX_SIZE];
+static CIridiumLZ g_Decoder;
+static u8 g_aStream[TEST_MAX_STREAM];
+static u8 g_aFlash[TEST_MAX_SIZE + 4];             // Записанный образ (с дополнением до 4 байт)
+static size_t g_stFlash = 0;                       // Размер записанного образа
+static bool g_bFlashOdd = false;                   // Признак записи нечетного размера не в конце образа
+static CIridiumFirmwareStream g_Stream;
+
+// Ключ и вектор инициализации шифра загрузчика
+static const u8 g_aKeyAndIV[BLOCK_CIPHER_KEY_SIZE + BLOCK_CIPHER_SIZE] =
+{
+   0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+   0xf0, 0xe0, 0xd0, 0xc0, 0xb0, 0xa0, 0x90, 0x80, 0x70, 0x60, 0x50, 0x40, 0x30, 0x20, 0x10, 0x00,
+   0x13, 0x57, 0x9b, 0xdf, 0x02, 0x46, 0x8a, 0xce, 0xec, 0xa8, 0x64, 0x20, 0xfd, 0xb9, 0x75, 0x31
+};
+static int g_iErrors = 0;
+static unsigned g_uSeed = 1;
+
+/**
+   Получение псевдослучайного числа (одинаковая последовательность на всех платформах)
+*/
+static unsigned GetRandom()
+{
+   g_uSeed = g_uSeed * 1103515245 + 12345;
+   return (g_uSeed >> 16) & 0x7FFF;
+}
+
+/**
+   Заполнение данных похожих на прошивку: повторы из окна и за его границей вперемешку со случайными байтами
+   на входе    :  in_stSize   - размер данных
+   на выходе   :  *
+*/
+static void FillImage(size_t in_stSize)
+{
+   size_t l_stPos = 0;
+   while(l_stPos < in_stSize)
+   {
+      size_t l_stLen = 1 + GetRandom() % 80;
+      size_t l_stOffset = 1 + GetRandom() % (IRIDIUM_LZ_WINDOW_SIZE + 100);
+      bool l_bCopy = (GetRandom() & 1) && l_stOffset <= l_stPos;
+      for(size_t i = 0; i < l_stLen && l_stPos < in_stSize; i++, l_stPos++)
+         g_aData[l_stPos] = l_bCopy ? g_aData[l_stPos - l_stOffset] : (u8)GetRandom();
+   }
+}
+
+/**
+   Запись распакованного образа (флеш загрузчика)
+   на входе    :  in_pBuffer  - указатель на записываемые данные
+                  in_stSize   - размер записываемых данных
+   на выходе   :  *
+*/
+static void WriteFlash(u8* in_pBuffer, size_t in_stSize)
+{
+   // Флеш пишется полусловами, нечетный размер допустим только в конце образа
+   if(g_stFlash & 1)
+      g_bFlashOdd = true;
+   if(g_stFlash + in_stSize > sizeof(g_aFlash))
+      in_stSize = sizeof(g_aFlash) - g_stFlash;
+   memcpy(g_aFlash + g_stFlash, in_pBuffer, in_stSize);
+   g_stFlash += in_stSize;
+}
+
+/**
+   Подготовка потока прошивки и разбор потока как в загрузчике
+   на входе    :  in_pszName  - название данных
+                  in_stSize   - размер данных
+                  in_u8Format - формат потока
+   на выходе   :  размер потока
+*/
+static size_t CheckStream(const char* in_pszName, size_t in_stSize, u8 in_u8Format)
+{
+   static const size_t l_aBlocks[] = { 16, 48, 192, 240 };
+   u8 l_aBlock[240];
+
+   size_t l_stStream = CIridiumFirmwareStream::Encode(g_aData, in_stSize, in_u8Format, TEST_RANDOM, g_aKeyAndIV, g_aStream, sizeof(g_aStream));
+   if(!l_stStream || (l_stStream & (BLOCK_CIPHER_SIZE - 1)) || l_stStream > CIridiumFirmwareStream::GetMaxSize(in_stSize))
+   {
+      printf("%s: stream %02X size %zu failed\n", in_pszName, in_u8Format, l_stStream);
+      g_iErrors++;
+      return 0;
+   }
+   // Буфер меньше потока
+   if(CIridiumFirmwareStream::Encode(g_aData, in_stSize, in_u8Format, TEST_RANDOM, g_aKeyAndIV, g_aStream, l_stStream - BLOCK_CIPHER_SIZE))
+   {
+      printf("%s: stream %02X into short buffer failed\n", in_pszName, in_u8Format);
+      g_iErrors++;
+   }
+   CIridiumFirmwareStream::Encode(g_aData, in_stSize, in_u8Format, TEST_RANDOM, g_aKeyAndIV, g_aStream, sizeof(g_aStream));
+
+   for(size_t i = 0; i < sizeof(l_aBlocks) / sizeof(l_aBlocks[0]); i++)
+   {
+      CIridiumCipherGrasshopper l_Cipher;
+      u8 l_u8Format = 0;
+      u32 l_u32Size = 0;
+      u16 l_u16CRC = 0;
+      bool l_bResult = true;
+
+      l_Cipher.EnableIV(true);
+      l_Cipher.Init(g_aKeyAndIV);
+      memset(g_aFlash, 0, sizeof(g_aFlash));
+      g_stFlash = 0;
+      g_bFlashOdd = false;
+
+      // Блоки потока расшифровываются по мере получения, шифр продолжает цепочку между блоками
+      for(size_t l_stPos = 0; l_bResult && l_stPos < l_stStream; l_stPos += l_aBlocks[i])
+      {
+         size_t l_stSize = l_stStream - l_stPos;
+         if(l_stSize > l_aBlocks[i])
+            l_stSize = l_aBlocks[i];
+         memcpy(l_aBlock, g_aStream + l_stPos, l_stSize);
+         l_Cipher.Decode(l_aBlock, l_stSize);
+
+         const u8* l_pData = l_aBlock;
+         if(!l_stPos)
+         {
+            // Заголовок: формат, размер и CRC16 образа
+            l_pData = CIridiumFirmwareStream::ReadHeader(l_aBlock, l_u8Format, l_u32Size, l_u16CRC);
+            l_stSize -= IRIDIUM_FIRMWARE_HEADER_SIZE;
+            if(l_aBlock[0] != TEST_RANDOM || l_u8Format != in_u8Format || l_u32Size != in_stSize ||
+               l_u16CRC != GetCRC16Modbus(IRIDIUM_FIRMWARE_CRC16_INIT, g_aData, in_stSize))
+               l_bResult = false;
+            g_Stream.Start(l_u32Size);
+         }
+         if(in_u8Format == IRIDIUM_FIRMWARE_FORMAT_LZ)
+            g_Stream.Write(l_pData, l_stSize, WriteFlash);
+         else
+            WriteFlash((u8*)l_pData, l_stSize);
+      }
+
+      // Сжатый образ дополняется 0xFF до 4 байт, несжатый записывается с выравниванием шифра
+      if(l_bResult && in_u8Format == IRIDIUM_FIRMWARE_FORMAT_LZ)
+      {
+         l_bResult = !g_bFlashOdd && g_stFlash == ((in_stSize + 3) & ~3);
+         for(size_t j = in_stSize; l_bResult && j < g_stFlash; j++)
+            l_bResult = (g_aFlash[j] == 0xFF);
+      }
+      if(!l_bResult || g_stFlash < in_stSize || memcmp(g_aFlash, g_aData, in_stSize))
+      {
+         printf("%s: stream %02X block %zu failed (written %zu)\n", in_pszName, in_u8Format, l_aBlocks[i], g_stFlash);
+         g_iErrors++;
+      }
+   }
+   return l_stStream;
+}
+
+/**
+   Сжатие и распаковка данных частями
+   на входе    :  in_pszName  - название данных
+                  in_stSize   - размер данных
+   на выходе   :  *
+*/
+static void Check(const char* in_pszName, size_t in_stSize)
+{
+   static const size_t l_aIn[] = { 1, 2, 3, 7, 61, 1001, TEST_MAX_ENCODED };
+   static const size_t l_aOut[] = { 1, 2, 5, 131, TEST_MAX_SIZE };
+
+   size_t l_stEncoded = CIridiumLZ::Encode(g_aData, in_stSize, g_aEncoded, sizeof(g_aEncoded));
+   if((!l_stEncoded && in_stSize) || l_stEncoded > in_stSize + (in_stSize + 7) / 8)
+   {
+      printf("%s: encode size %zu failed\n", in_pszName, l_stEncoded);
+      g_iErrors++;
+      return;
+   }
+   // Буфер меньше сжатых данных
+   if(l_stEncoded && CIridiumLZ::Encode(g_aData, in_stSize, g_aEncoded, l_stEncoded - 1))
+   {
+      printf("%s: encode into short buffer failed\n", in_pszName);
+      g_iErrors++;
+   }
+   CIridiumLZ::Encode(g_aData, in_stSize, g_aEncoded, sizeof(g_aEncoded));
+
+   for(size_t i = 0; i < sizeof(l_aIn) / sizeof(l_aIn[0]); i++)
+   {
+      for(size_t j = 0; j < sizeof(l_aOut) / sizeof(l_aOut[0]); j++)
+      {
+         size_t l_stIn = 0;
+         size_t l_stOut = 0;
+         size_t l_stUsed = 0;
+         bool l_bResult = true;
+
+         memset(g_aDecoded, 0, sizeof(g_aDecoded));
+         g_Decoder.Reset();
+         while(l_bResult && l_stOut < in_stSize)
+         {
+            size_t l_stInSize = l_stEncoded - l_stIn;
+            if(l_stInSize > l_aIn[i])
+               l_stInSize = l_aIn[i];
+            size_t l_stOutSize = in_stSize - l_stOut;
+            if(l_stOutSize > l_aOut[j])
+               l_stOutSize = l_aOut[j];
+
+            size_t l_stSize = g_Decoder.Decode(g_aEncoded + l_stIn, l_stInSize, l_stUsed, g_aDecoded + l_stOut, l_stOutSize);
+            // Нет прогресса - сжатые данные закончились раньше исходных
+            if(!l_stSize && !l_stUsed)
+               l_bResult = false;
+            l_stIn += l_stUsed;
+            l_stOut += l_stSize;
+         }
+         if(!l_bResult || l_stIn != l_stEncoded || memcmp(g_aDecoded, g_aData, in_stSize))
+         {
+            printf("%s: in %zu out %zu failed (used %zu of %zu, decoded %zu)\n", in_pszName, l_aIn[i], l_aOut[j],
+               l_stIn, l_stEncoded, l_stOut);
+            g_iErrors++;
+         }
+      }
+   }
+   // Поток прошивки из тех же данных
+   size_t l_stStream = 0;
+   if(in_stSize)
+   {
+      l_stStream = CheckStream(in_pszName, in_stSize, IRIDIUM_FIRMWARE_FORMAT_LZ);
+      CheckStream(in_pszName, in_stSize, IRIDIUM_FIRMWARE_FORMAT_RAW);
+   }
+   printf("%-12s %5zu -> %5zu, stream %5zu\n", in_pszName, in_stSize, l_stEncoded, l_stStream);
+}
+
+int main()
+{
+   memset(g_aData, 0, sizeof(g_aData));
+   Check("empty", 0);
+   Check("zeros 1", 1);
+   Check("zeros 3", 3);
+   Check("zeros 4", 4);
+   Check("zeros", TEST_MAX_SIZE);
+
+   for(size_t i = 0; i < TEST_MAX_SIZE; i++)
+      g_aData[i] = (u8)GetRandom();
+   Check("random", TEST_MAX_SIZE);
+
+   for(size_t i = 0; i < TEST_MAX_SIZE; i++)
+      g_aData[i] = (u8)"ABCDEFG"[i % 7];
+   Check("period 7", TEST_MAX_SIZE);
+
+   FillImage(TEST_MAX_SIZE);
+   Check("image", TEST_MAX_SIZE);
+   Check("image 1021", 1021);
+
+   printf("%d errors\n", g_iErrors);
+   return g_iErrors ? 1 : 0;
+}
@@ -0,0 +1,491 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+//////////////////////////////////////////////////////////////////////////
+// Проверка кодирования и разбора сообщений работы с каналами
+//////////////////////////////////////////////////////////////////////////
+// Ведущий и ведомый соединены моделью шины, запрос ведущего кодируется библиотекой, разбирается ведомым,
+// ответ ведомого разбирается ведущим. Проверяется пакетное сообщение (IRIDIUM_MESSAGE_BATCH): результат
+// и значение каждой операции, пароль доступа, неизвестные каналы, а также передача запроса и ответа,
+// не помещающихся в один пакет, цепочкой пакетов без потери и перестановки операций. Проверяется подписка
+// на изменение канала обратной связи (IRIDIUM_MESSAGE_SUBSCRIBE_TAG) и доставка значений уведомлениями
+// с учетом зоны нечувствительности и интервалов отправки, а также постраничное получение списков каналов
+// (IRIDIUM_MESSAGE_GET_TAGS, IRIDIUM_MESSAGE_GET_CHANNELS): границы страницы, продолжение списка в каждом
+// пакете ответа, продолжение после потери пакетов и запрос всего списка без параметров страницы
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CIridiumBusProtocol.h"
+
+#define TEST_MASTER           1                    // Адрес ведущего
+#define TEST_SLAVE            10                   // Адрес ведомого
+#define TEST_WIRE_PACKETS     64                   // Размер очереди пакетов на шине
+#define TEST_CHANNELS         100                  // Количество каналов управления ведомого
+#define TEST_TAGS             4                    // Количество каналов обратной связи ведомого
+#define TEST_BAD_PIN          0xBAD                // Пароль доступа, не подходящий для записи
+#define TEST_MAX_RESULTS      128                  // Максимальное количество результатов операций
+
+// Пакет на шине
+typedef struct test_packet_s
+{
+   u8                m_aData[IRIDIUM_BUS_OUT_BUFFER_SIZE + IRIDIUM_BUS_CRC_SIZE]; // Данные пакета
+   u16               m_u16Size;                    // Размер пакета
+   iridium_address_t m_SrcAddr;                    // Адрес отправителя
+} test_packet_t;
+
+// Результат операции пакетного сообщения
+typedef struct test_result_s
+{
+   u8                m_u8Operation;                // Тип операции
+   u32               m_u32ID;                      // Идентификатор канала
+   eIridiumError     m_eError;                     // Результат операции
+} test_result_t;
+
+static test_packet_t g_aWire[TEST_WIRE_PACKETS];
+static size_t g_stWire = 0;
+static int g_iErrors = 0;
+
+/**
+   Проверка условия
+   на входе    :  in_bCondition  - условие
+                  in_pszName     - название проверки
+   на выходе   :  *
+*/
+static void Check(bool in_bCondition, const char* in_pszName)
+{
+   printf("%-40s %s\n", in_pszName, in_bCondition ? "ok" : "FAILED");
+   if(!in_bCondition)
+      g_iErrors++;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// class CTestNode
+//////////////////////////////////////////////////////////////////////////
+// Узел шины: ведомый хранит каналы управления со строковыми значениями и каналы обратной связи,
+// ведущий запоминает результаты операций и полученные значения каналов
+class CTestNode : public CIridiumBusProtocol
+{
+public:
+   CTestNode(iridium_address_t in_Address)
+   {
+      m_OutBuffer.SetBuffer(IRIDIUM_BUS_MAX_HEADER_SIZE, IRIDIUM_BUS_CRC_SIZE, m_aOut, sizeof(m_aOut));
+      m_OutPH.m_u8Type = IRIDIUM_BUS_PROTOCOL_ID;
+      SetAddress(in_Address);
+      Clear();
+   }
+
+   // Очистка сохраненных значений и результатов
+   void Clear()
+   {
+      memset(m_aTags, 0, sizeof(m_aTags));
+      memset(m_aChannels, 0, sizeof(m_aChannels));
+      memset(m_aValues, 0, sizeof(m_aValues));
+      m_stResults = 0;
+      m_stPackets = 0;
+      m_stList = 0;
+      m_u16Next = 0;
+      m_stPages = 0;
+      m_stEnd = 0;
+   }
+
+   // Отправка пакета на шину
+   virtual bool SendPacket(void* in_pBuffer, size_t in_stSize)
+   {
+      bool l_bResult = false;
+      if(g_stWire < TEST_WIRE_PACKETS)
+      {
+         test_packet_t& l_rPacket = g_aWire[g_stWire++];
+         memcpy(l_rPacket.m_aData, in_pBuffer, in_stSize);
+         l_rPacket.m_u16Size = (u16)in_stSize;
+         l_rPacket.m_SrcAddr = m_Address;
+         m_stPackets++;
+         l_bResult = true;
+      }
+      return l_bResult;
+   }
+
+   // Разбор полученного пакета
+   void Receive(test_packet_t& in_rPacket)
+   {
+      m_InBuffer.SetBuffer(in_rPacket.m_aData, in_rPacket.m_u16Size);
+      m_InBuffer.FilterNoiseAndForeignPacket(m_Address);
+      while(m_InBuffer.OpenPacket())
+      {
+         ProcessMessage(m_InBuffer.GetPacketHeader(), m_InBuffer.GetMessagePtr(), m_InBuffer.GetMessageSize());
+         m_InBuffer.ClosePacket();
+      }
+   }
+
+   s32               m_aTags[TEST_TAGS + 1];       // Установленные значения каналов обратной связи
+   s32               m_aChannels[TEST_CHANNELS + 1]; // Установленные значения каналов управления
+   char              m_aValues[TEST_CHANNELS + 1][16]; // Полученные значения каналов управления
+   test_result_t     m_aResults[TEST_MAX_RESULTS]; // Результаты операций пакетного сообщения
+   size_t            m_stResults;                  // Количество результатов
+   size_t            m_stPackets;                  // Количество отправленных пакетов
+   u32               m_aList[TEST_CHANNELS * 2];   // Идентификаторы полученных каналов списка
+   size_t            m_stList;                     // Количество полученных каналов списка
+   u16               m_u16Next;                    // Последнее полученное продолжение списка
+   size_t            m_stPages;                    // Количество полученных последних пакетов страниц
+   size_t            m_stEnd;                      // Количество оповещений об окончании списка
+
+protected:
+   virtual bool SetTagValue(u32 in_u32TagID, u8 in_u8Type, universal_value_t& in_rValue, u8 in_u8Flags)
+   {
+      bool l_bResult = (in_u32TagID >= 1 && in_u32TagID <= TEST_TAGS && in_u8Type == IVT_S32);
+      if(l_bResult)
+         m_aTags[in_u32TagID] = in_rValue.m_s32Value;
+      return l_bResult;
+   }
+
+   virtual size_t GetTags()
+      { return TEST_TAGS; }
+   virtual size_t GetTagIndex(u32 in_u32TagID)
+      { return (in_u32TagID >= 1 && in_u32TagID <= TEST_TAGS) ? in_u32TagID - 1 : (size_t)-1; }
+
+   virtual size_t GetTagData(size_t in_stIndex, iridium_tag_info_t& out_rInfo, size_t in_stSize)
+   {
+      static char l_szName[] = "tag";
+      out_rInfo.m_u32ID = (u32)(in_stIndex + 1);
+      out_rInfo.m_pszName = l_szName;
+      out_rInfo.m_u8Type = IVT_S32;
+      out_rInfo.m_Value.m_s32Value = m_aTags[in_stIndex + 1];
+      // Размер данных: идентификатор, имя с завершающим нулем, тип и значение
+      return 4 + sizeof(l_szName) + 1 + sizeof(s32);
+   }
+
+   virtual size_t GetChannels()
+      { return TEST_CHANNELS; }
+   virtual size_t GetChannelIndex(u32 in_u32ChannelID)
+      { return (in_u32ChannelID >= 1 && in_u32ChannelID <= TEST_CHANNELS) ? in_u32ChannelID - 1 : (size_t)-1; }
+
+   virtual size_t GetChannelData(size_t in_stIndex, iridium_channel_info_t& out_rInfo)
+   {
+      static char l_szValue[16];
+      static char l_szName[] = "channel";
+      snprintf(l_szValue, sizeof(l_szValue), "value %03u", (unsigned)(in_stIndex + 1));
+      out_rInfo.m_u32ID = (u32)(in_stIndex + 1);
+      out_rInfo.m_pszName = l_szName;
+      out_rInfo.m_u8Type = IVT_STRING8;
+      out_rInfo.m_Value.m_Array.m_stSize = strlen(l_szValue);
+      out_rInfo.m_Value.m_Array.m_pPtr = l_szValue;
+      // Размер данных в списке каналов: идентификатор и имя с завершающим нулем
+      return 4 + sizeof(l_szName);
+   }
+
+   virtual bool SetChannelValue(u32 in_u32ChannelID, u8 in_u8Type, universal_value_t& in_rValue, u8 in_u8Flags)
+   {
+      bool l_bResult = (GetChannelIndex(in_u32ChannelID) != (size_t)-1);
+      if(l_bResult)
+      {
+         // Установка значения ведомым, получение значения ведущим
+         if(in_u8Type == IVT_S32)
+            m_aChannels[in_u32ChannelID] = in_rValue.m_s32Value;
+         else if(in_u8Type == IVT_STRING8 && in_rValue.m_Array.m_stSize < sizeof(m_aValues[0]))
+            memcpy(m_aValues[in_u32ChannelID], in_rValue.m_Array.m_pPtr, in_rValue.m_Array.m_stSize);
+         else
+            l_bResult = false;
+      }
+      return l_bResult;
+   }
+
+   virtual s8 TestPIN(eIridiumOperation in_eType, u32 in_u32PIN, void* in_pData)
+      { return (in_eType == IRIDIUM_OPERATION_WRITE_CHANNEL && in_u32PIN == TEST_BAD_PIN) ? 0 : 1; }
+
+   // Получение списков каналов ведущим
+   virtual void SetTagData(iridium_tag_info_t& in_rInfo)
+      { AddList(in_rInfo.m_u32ID); }
+   virtual void SetChannelData(iridium_channel_info_t& in_rInfo)
+      { AddList(in_rInfo.m_u32ID); }
+   virtual void TagsPage(u16 in_u16Next, bool in_bEnd)
+      { SetPage(in_u16Next, in_bEnd); }
+   virtual void ChannelsPage(u16 in_u16Next, bool in_bEnd)
+      { SetPage(in_u16Next, in_bEnd); }
+   virtual void EndTags()
+      { m_stEnd++; }
+   virtual void EndChannels()
+      { m_stEnd++; }
+
+   void AddList(u32 in_u32ID)
+   {
+      if(m_stList < sizeof(m_aList) / sizeof(m_aList[0]))
+         m_aList[m_stList++] = in_u32ID;
+   }
+   void SetPage(u16 in_u16Next, bool in_bEnd)
+   {
+      m_u16Next = in_u16Next;
+      if(in_bEnd)
+         m_stPages++;
+   }
+
+   virtual void BatchResult(u8 in_u8Operation, u32 in_u32ID, eIridiumError in_eError)
+   {
+      if(m_stResults < TEST_MAX_RESULTS)
+      {
+         test_result_t& l_rResult = m_aResults[m_stResults];
+         l_rResult.m_u8Operation = in_u8Operation;
+         l_rResult.m_u32ID = in_u32ID;
+         l_rResult.m_eError = in_eError;
+      }
+      m_stResults++;
+   }
+
+private:
+   u8                m_aOut[IRIDIUM_BUS_OUT_BUFFER_SIZE]; // Буфер исходящего пакета
+};
+
+static CTestNode* g_pMaster = NULL;
+static CTestNode* g_pSlave = NULL;
+
+/**
+   Доставка всех пакетов на шине, включая ответы, отправленные при доставке
+   на входе    :  *
+   на выходе   :  *
+*/
+static void Deliver()
+{
+   static test_packet_t l_aPackets[TEST_WIRE_PACKETS];
+   while(g_stWire)
+   {
+      size_t l_stCount = g_stWire;
+      memcpy(l_aPackets, g_aWire, l_stCount * sizeof(test_packet_t));
+      g_stWire = 0;
+      for(size_t i = 0; i < l_stCount; i++)
+      {
+         if(l_aPackets[i].m_SrcAddr == TEST_MASTER)
+            g_pSlave->Receive(l_aPackets[i]);
+         else
+            g_pMaster->Receive(l_aPackets[i]);
+      }
+   }
+}
+
+/**
+   Подготовка узлов к проверке
+   на входе    :  *
+   на выходе   :  *
+*/
+static void Reset()
+{
+   g_pMaster->Clear();
+   g_pSlave->Clear();
+   g_stWire = 0;
+}
+
+/**
+   Проверка результата операции пакетного сообщения
+   на входе    :  in_stIndex     - индекс результата
+                  in_u8Operation - ожидаемый тип операции
+                  in_u32ID       - ожидаемый идентификатор канала
+                  in_eError      - ожидаемый результат
+   на выходе   :  совпадение
+*/
+static bool IsResult(size_t in_stIndex, u8 in_u8Operation, u32 in_u32ID, eIridiumError in_eError)
+{
+   test_result_t& l_rResult = g_pMaster->m_aResults[in_stIndex];
+   return in_stIndex < g_pMaster->m_stResults && l_rResult.m_u8Operation == in_u8Operation &&
+          l_rResult.m_u32ID == in_u32ID && l_rResult.m_eError == in_eError;
+}
+
+/**
+   Проверка пакетного сообщения
+   на входе    :  *
+   на выходе   :  *
+*/
+static void CheckBatch()
+{
+   universal_value_t l_Value;
+   char l_szValue[16];
+
+   // Операции разных типов в одном пакете
+   Reset();
+   g_pMaster->BeginBatchRequest(TEST_SLAVE);
+   l_Value.m_s32Value = 7;
+   g_pMaster->AddBatchSetTagValue(2, IVT_S32, l_Value);
+   g_pMaster->AddBatchSetTagValue(TEST_TAGS + 1, IVT_S32, l_Value);
+   l_Value.m_s32Value = -5;
+   g_pMaster->AddBatchSetChannelValue(3, IVT_S32, l_Value, 0);
+   g_pMaster->AddBatchSetChannelValue(4, IVT_S32, l_Value, TEST_BAD_PIN);
+   g_pMaster->AddBatchGetChannelValue(5, 0);
+   g_pMaster->AddBatchGetChannelValue(6, 1234);
+   g_pMaster->AddBatchGetChannelValue(TEST_CHANNELS + 1, 0);
+   g_pMaster->SendBatchRequest();
+   bool l_bSingle = (g_stWire == 1);
+   Deliver();
+   Check(l_bSingle && g_pSlave->m_stPackets == 1, "batch: single packet");
+   Check(g_pMaster->m_stResults == 7 &&
+         IsResult(0, IRIDIUM_MESSAGE_SET_TAG_VALUE, 2, IRIDIUM_OK) &&
+         IsResult(1, IRIDIUM_MESSAGE_SET_TAG_VALUE, TEST_TAGS + 1, IRIDIUM_ERROR_BAD_TAG_ID) &&
+         IsResult(2, IRIDIUM_MESSAGE_SET_CHANNEL_VALUE, 3, IRIDIUM_OK) &&
+         IsResult(3, IRIDIUM_MESSAGE_SET_CHANNEL_VALUE, 4, IRIDIUM_BAD_PIN) &&
+         IsResult(4, IRIDIUM_MESSAGE_GET_CHANNEL_VALUE, 5, IRIDIUM_OK) &&
+         IsResult(5, IRIDIUM_MESSAGE_GET_CHANNEL_VALUE, 6, IRIDIUM_OK) &&
+         IsResult(6, IRIDIUM_MESSAGE_GET_CHANNEL_VALUE, TEST_CHANNELS + 1, IRIDIUM_ERROR_BAD_CHANNEL_ID), "batch: results");
+   Check(g_pSlave->m_aTags[2] == 7 && g_pSlave->m_aChannels[3] == -5 && !g_pSlave->m_aChannels[4] &&
+         !strcmp(g_pMaster->m_aValues[5], "value 005") && !strcmp(g_pMaster->m_aValues[6], "value 006"), "batch: values");
+
+   // Запрос и ответ цепочкой пакетов
+   Reset();
+   bool l_bResult = g_pMaster->BeginBatchRequest(TEST_SLAVE);
+   for(u32 i = 1; l_bResult && i <= TEST_CHANNELS; i++)
+      l_bResult = g_pMaster->AddBatchGetChannelValue(i, 0);
+   l_bResult = g_pMaster->SendBatchRequest() && l_bResult;
+   size_t l_stRequest = g_stWire;
+   Deliver();
+   Check(l_bResult && l_stRequest > 1 && g_pSlave->m_stPackets > 1, "batch: chain of packets");
+   for(u32 i = 1; l_bResult && i <= TEST_CHANNELS; i++)
+   {
+      snprintf(l_szValue, sizeof(l_szValue), "value %03u", (unsigned)i);
+      l_bResult = IsResult(i - 1, IRIDIUM_MESSAGE_GET_CHANNEL_VALUE, i, IRIDIUM_OK) && !strcmp(g_pMaster->m_aValues[i], l_szValue);
+   }
+   Check(l_bResult && g_pMaster->m_stResults == TEST_CHANNELS, "batch: chain results in order");
+}
+
+/**
+   Проверка подписки на изменение канала обратной связи
+   на входе    :  *
+   на выходе   :  *
+*/
+static void CheckSubscribe()
+{
+   Reset();
+   g_pSlave->ProcessSubscriptions(1000);
+   g_pSlave->m_aTags[1] = 10;
+
+   // Подписка на неизвестный канал отклоняется
+   g_pMaster->SendSubscribeTagRequest(TEST_SLAVE, TEST_TAGS + 1, 0, 100, 1000, 5.0f);
+   Deliver();
+   bool l_bResult = !g_pSlave->GetSubscriptions();
+
+   // Текущее значение отправляется сразу после подписки
+   g_pMaster->SendSubscribeTagRequest(TEST_SLAVE, 1, 0, 100, 1000, 5.0f);
+   Deliver();
+   g_pSlave->ProcessSubscriptions(1000);
+   Deliver();
+   Check(l_bResult && g_pSlave->GetSubscriptions() == 1 && g_pMaster->m_aTags[1] == 10, "subscribe: initial value");
+
+   // Изменение отправляется не раньше минимального интервала, изменение в пределах зоны нечувствительности
+   // не отправляется
+   g_pSlave->m_aTags[1] = 20;
+   g_pSlave->SetTagChanged(1);
+   g_pSlave->ProcessSubscriptions(1050);
+   l_bResult = !g_stWire;
+   g_pSlave->ProcessSubscriptions(1100);
+   Deliver();
+   l_bResult = l_bResult && g_pMaster->m_aTags[1] == 20;
+   g_pSlave->m_aTags[1] = 22;
+   g_pSlave->SetTagChanged(1);
+   g_pSlave->ProcessSubscriptions(1200);
+   Check(l_bResult && !g_stWire && g_pMaster->m_aTags[1] == 20, "subscribe: min interval and deadband");
+
+   // Контрольная отправка по истечении максимального интервала, отмена подписки
+   g_pSlave->ProcessSubscriptions(2099);
+   l_bResult = !g_stWire;
+   g_pSlave->ProcessSubscriptions(2100);
+   Deliver();
+   l_bResult = l_bResult && g_pMaster->m_aTags[1] == 22;
+   g_pMaster->SendSubscribeTagRequest(TEST_SLAVE, 1, IRIDIUM_SUBSCRIBE_FLAG_CANCEL, 0, 0, 0.0f);
+   Deliver();
+   g_pSlave->ProcessSubscriptions(5000);
+   Check(l_bResult && !g_pSlave->GetSubscriptions() && !g_stWire, "subscribe: max interval and cancel");
+}
+
+/**
+   Проверка списка каналов, полученного ведущим
+   на входе    :  in_stFirst  - индекс первого канала в списке ведущего
+                  in_u32ID    - идентификатор первого ожидаемого канала
+                  in_stCount  - количество ожидаемых каналов
+   на выходе   :  true - каналы получены по порядку без пропусков и повторов
+*/
+static bool IsList(size_t in_stFirst, u32 in_u32ID, size_t in_stCount)
+{
+   bool l_bResult = (g_pMaster->m_stList == in_stFirst + in_stCount);
+   for(size_t i = 0; l_bResult && i < in_stCount; i++)
+      l_bResult = (g_pMaster->m_aList[in_stFirst + i] == in_u32ID + i);
+   return l_bResult;
+}
+
+/**
+   Проверка постраничного получения списков каналов
+   на входе    :  *
+   на выходе   :  *
+*/
+static void CheckPages()
+{
+   // Список каналов управления страницами по 30 каналов, каждая страница передается несколькими пакетами
+   Reset();
+   bool l_bResult = true;
+   size_t l_stRequests = 0;
+   u16 l_u16Start = 0;
+   do
+   {
+      size_t l_stPages = g_pMaster->m_stPages;
+      g_pMaster->SendGetChannelsRequest(TEST_SLAVE, l_u16Start, 30);
+      size_t l_stPackets = g_pSlave->m_stPackets;
+      Deliver();
+      l_bResult = l_bResult && g_pMaster->m_stPages == l_stPages + 1;
+      l_bResult = l_bResult && (l_u16Start + 30 >= TEST_CHANNELS || g_pSlave->m_stPackets - l_stPackets > 1);
+      l_bResult = l_bResult && (g_pMaster->m_u16Next ? !g_pMaster->m_stEnd : g_pMaster->m_stEnd == 1);
+      l_u16Start = g_pMaster->m_u16Next;
+      l_stRequests++;
+   } while(l_u16Start && l_stRequests < TEST_CHANNELS);
+   Check(l_bResult && l_stRequests == 4 && IsList(0, 1, TEST_CHANNELS), "pages: channels by pages");
+
+   // Потеря пакетов ответа, продолжение с последнего полученного продолжения списка
+   Reset();
+   g_pMaster->SendGetChannelsRequest(TEST_SLAVE, 0, 0);
+   g_pSlave->Receive(g_aWire[0]);
+   l_bResult = (g_stWire == 1 + g_pSlave->m_stPackets && g_pSlave->m_stPackets > 2);
+   g_pMaster->Receive(g_aWire[1]);
+   g_stWire = 0;
+   size_t l_stFirst = g_pMaster->m_stList;
+   l_bResult = l_bResult && l_stFirst && g_pMaster->m_u16Next == l_stFirst && !g_pMaster->m_stPages && !g_pMaster->m_stEnd;
+   g_pMaster->SendGetChannelsRequest(TEST_SLAVE, g_pMaster->m_u16Next, 0);
+   Deliver();
+   Check(l_bResult && g_pMaster->m_stEnd == 1 && !g_pMaster->m_u16Next && IsList(0, 1, TEST_CHANNELS), "pages: resume after lost packets");
+
+   // Страница за концом списка передается пустой с окончанием списка, запрос без параметров - весь список
+   Reset();
+   g_pMaster->SendGetChannelsRequest(TEST_SLAVE, TEST_CHANNELS + 5, 10);
+   Deliver();
+   l_bResult = g_pSlave->m_stPackets == 1 && !g_pMaster->m_stList && g_pMaster->m_stPages == 1 && g_pMaster->m_stEnd == 1;
+   g_pMaster->m_stPages = 0;
+   g_pMaster->m_stEnd = 0;
+   g_pMaster->SendGetChannelsRequest(TEST_SLAVE);
+   Deliver();
+   Check(l_bResult && !g_pMaster->m_stPages && g_pMaster->m_stEnd == 1 && IsList(0, 1, TEST_CHANNELS), "pages: empty page and whole list");
+
+   // Список каналов обратной связи
+   Reset();
+   g_pMaster->SendGetTagsRequest(TEST_SLAVE, 1, 2);
+   Deliver();
+   l_bResult = IsList(0, 2, 2) && g_pMaster->m_u16Next == 3 && !g_pMaster->m_stEnd;
+   g_pMaster->SendGetTagsRequest(TEST_SLAVE, g_pMaster->m_u16Next, 0);
+   Deliver();
+   Check(l_bResult && IsList(2, 4, 1) && !g_pMaster->m_u16Next && g_pMaster->m_stPages == 2 && g_pMaster->m_stEnd == 1, "pages: tags");
+}
+
+int main()
+{
+   g_pMaster = new CTestNode(TEST_MASTER);
+   g_pSlave = new CTestNode(TEST_SLAVE);
+
+   CheckBatch();
+   CheckSubscribe();
+   CheckPages();
+
+   delete g_pMaster;
+   delete g_pSlave;
+   return g_iErrors ? 1 : 0;
+}
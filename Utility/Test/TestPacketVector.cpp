@@ -0,0 +1,225 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+//////////////////////////////////////////////////////////////////////////
+// Проверка отправки пакета со ссылкой на внешние данные по сегментам
+//////////////////////////////////////////////////////////////////////////
+// Пакет со ссылкой (AddDataRef) и такой же пакет с копированием данных (AddData) собираются в исходящих буферах
+// со случайными размерами данных до и после ссылки и случайными флагами заголовка. CRC16, вычисленная по
+// сегментам, и сегменты, собранные очередью исходящих пакетов (CIridiumBusOutQueue::Push) и реализацией
+// SendPacketV по умолчанию, должны совпадать с пакетом, отправленным через SendPacket целиком
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CIridiumBusProtocol.h"
+#include "IridiumCRC16.h"
+
+#define TEST_ITERATIONS       5000                 // Количество проверок
+#define TEST_MAX_PART         40                   // Максимальный размер данных до и после ссылки
+#define TEST_MAX_REF          120                  // Максимальный размер внешних данных
+#define TEST_QUEUE_SIZE       600                  // Размер буфера класса очереди
+#define TEST_MAX_QUEUED       16                   // Максимальное количество пакетов в очереди
+
+static u8 g_aRef[TEST_MAX_REF];
+static u8 g_aData[2 * TEST_MAX_PART];
+
+// Ожидаемые пакеты очереди исходящих пакетов
+typedef struct test_expected_s
+{
+   u8       m_aPacket[IRIDIUM_BUS_OUT_BUFFER_SIZE + IRIDIUM_BUS_CRC_SIZE]; // Данные пакета
+   size_t   m_stSize;                              // Размер пакета
+   u8       m_u8Class;                             // Класс приоритета
+} test_expected_t;
+
+static test_expected_t g_aExpected[TEST_MAX_QUEUED];
+static size_t g_stExpected = 0;
+
+//////////////////////////////////////////////////////////////////////////
+// class CTestSink
+//////////////////////////////////////////////////////////////////////////
+// Протокол, запоминающий последний пакет, переданный в SendPacket
+class CTestSink : public CIridiumBusProtocol
+{
+public:
+   CTestSink()
+      { m_stSize = 0; }
+
+   virtual bool SendPacket(void* in_pBuffer, size_t in_stSize)
+   {
+      memcpy(m_aPacket, in_pBuffer, in_stSize);
+      m_stSize = in_stSize;
+      return true;
+   }
+
+   u8       m_aPacket[IRIDIUM_BUS_OUT_BUFFER_SIZE + IRIDIUM_BUS_CRC_SIZE]; // Данные пакета
+   size_t   m_stSize;                              // Размер пакета
+};
+
+/**
+   Сборка пакета
+   на входе    :  io_rBuffer  - ссылка на исходящий буфер
+                  in_rPH      - ссылка на заголовок пакета
+                  in_stPrefix - размер данных до ссылки
+                  in_stRef    - размер внешних данных
+                  in_stSuffix - размер данных после ссылки
+                  in_bRef     - true - внешние данные добавляются ссылкой, false - копируются
+   на выходе   :  успешность
+*/
+static bool Build(CIridiumBusOutBuffer& io_rBuffer, iridium_packet_header_t& in_rPH, size_t in_stPrefix, size_t in_stRef, size_t in_stSuffix, bool in_bRef)
+{
+   io_rBuffer.Begin(0);
+   io_rBuffer.AllowDataRef(in_bRef);
+   io_rBuffer.AddData(g_aData, in_stPrefix);
+   io_rBuffer.AddDataRef(g_aRef, in_stRef);
+   io_rBuffer.AddData(g_aData + TEST_MAX_PART, in_stSuffix);
+   return io_rBuffer.End(in_rPH) && io_rBuffer.IsDataRef() == in_bRef;
+}
+
+/**
+   Извлечение пакетов из очереди и сравнение с ожидаемыми
+   на входе    :  io_rQueue   - ссылка на очередь исходящих пакетов
+                  in_stCount  - количество извлекаемых пакетов
+   на выходе   :  успешность, пакеты каждого класса извлекаются в порядке добавления
+*/
+static bool Drain(CIridiumBusOutQueue& io_rQueue, size_t in_stCount)
+{
+   bool l_bResult = io_rQueue.GetCount() == g_stExpected;
+   const void* l_pPacket = NULL;
+   size_t l_stSize = 0;
+
+   while(l_bResult && in_stCount-- && (l_stSize = io_rQueue.Peek(l_pPacket)) != 0)
+   {
+      // Первый ожидаемый пакет того же класса
+      u8 l_u8Class = (((const u8*)l_pPacket)[0] & IRIDIUM_BUS_PRIORITY_MASK) ? IRIDIUM_BUS_OUT_CLASS_PRIORITY : IRIDIUM_BUS_OUT_CLASS_NORMAL;
+      size_t i = 0;
+      while(i < g_stExpected && g_aExpected[i].m_u8Class != l_u8Class)
+         i++;
+      l_bResult = i < g_stExpected && io_rQueue.GetCount(l_u8Class) &&
+                  l_stSize == g_aExpected[i].m_stSize && !memcmp(l_pPacket, g_aExpected[i].m_aPacket, l_stSize);
+      if(l_bResult)
+      {
+         memmove(g_aExpected + i, g_aExpected + i + 1, (g_stExpected - i - 1) * sizeof(test_expected_t));
+         g_stExpected--;
+      }
+      io_rQueue.Release();
+   }
+   return l_bResult && io_rQueue.GetCount() == g_stExpected;
+}
+
+int main()
+{
+   static u8 l_aFlat[IRIDIUM_BUS_OUT_BUFFER_SIZE + IRIDIUM_BUS_CRC_SIZE];
+   static u8 l_aSegmented[IRIDIUM_BUS_OUT_BUFFER_SIZE + IRIDIUM_BUS_CRC_SIZE];
+   static u8 l_aQueue[IRIDIUM_BUS_OUT_CLASSES][TEST_QUEUE_SIZE];
+   CIridiumBusOutBuffer l_Flat;
+   CIridiumBusOutBuffer l_Segmented;
+   CIridiumBusOutQueue l_Queue;
+   CTestSink l_Sink;
+   int l_iErrors = 0;
+
+   l_Flat.SetBuffer(IRIDIUM_BUS_MAX_HEADER_SIZE, IRIDIUM_BUS_CRC_SIZE, l_aFlat, sizeof(l_aFlat));
+   l_Segmented.SetBuffer(IRIDIUM_BUS_MAX_HEADER_SIZE, IRIDIUM_BUS_CRC_SIZE, l_aSegmented, sizeof(l_aSegmented));
+   for(u8 i = 0; i < IRIDIUM_BUS_OUT_CLASSES; i++)
+      l_Queue.SetBuffer(i, l_aQueue[i], sizeof(l_aQueue[i]));
+
+   srand(1);
+   for(size_t i = 0; i < sizeof(g_aRef); i++)
+      g_aRef[i] = (u8)rand();
+   for(size_t i = 0; i < sizeof(g_aData); i++)
+      g_aData[i] = (u8)rand();
+
+   for(int i = 0; i < TEST_ITERATIONS; i++)
+   {
+      iridium_packet_header_t l_PH;
+      iridium_iovec_t l_aVec[IRIDIUM_PACKET_MAX_SEGMENTS];
+      size_t l_stPrefix = rand() % (TEST_MAX_PART + 1);
+      size_t l_stRef = 1 + rand() % TEST_MAX_REF;
+      size_t l_stSuffix = rand() % (TEST_MAX_PART + 1);
+      size_t l_stCount = 0;
+      size_t l_stSize = 0;
+      bool l_bOk = true;
+
+      memset(&l_PH, 0, sizeof(l_PH));
+      l_PH.m_u8Type = IRIDIUM_BUS_PROTOCOL_ID;
+      l_PH.m_Flags.m_bAddress = rand() & 1;
+      l_PH.m_Flags.m_bSegment = rand() & 1;
+      l_PH.m_Flags.m_bPriority = rand() & 1;
+      l_PH.m_SrcAddr = (iridium_address_t)rand();
+      l_PH.m_DstAddr = (iridium_address_t)rand();
+
+      // Пакет с копированием данных, отправленный целиком
+      l_bOk = Build(l_Flat, l_PH, l_stPrefix, l_stRef, l_stSuffix, false);
+      const u8* l_pFlat = (const u8*)l_Flat.GetPacketPtr();
+      size_t l_stFlat = l_Flat.GetPacketSize();
+
+      // CRC16 пакета с копированием совпадает с CRC16 тела
+      u16 l_u16CRC = GetCRC16Modbus(0xFFFF, l_Flat.GetMessagePtr(), l_stFlat - (l_Flat.GetMessagePtr() - l_pFlat) - IRIDIUM_BUS_CRC_SIZE);
+      l_bOk = l_bOk && l_pFlat[l_stFlat - 2] == (u8)l_u16CRC && l_pFlat[l_stFlat - 1] == (u8)(l_u16CRC >> 8);
+
+      // Пакет со ссылкой: CRC16 по сегментам и сегменты, собранные подряд
+      l_bOk = l_bOk && Build(l_Segmented, l_PH, l_stPrefix, l_stRef, l_stSuffix, true);
+      l_stCount = l_Segmented.GetPacketVector(l_aVec, IRIDIUM_PACKET_MAX_SEGMENTS);
+      l_bOk = l_bOk && l_stCount == 3 && l_aVec[1].m_pPtr == g_aRef;
+      if(l_bOk)
+      {
+         static u8 l_aGathered[IRIDIUM_BUS_OUT_BUFFER_SIZE + IRIDIUM_BUS_CRC_SIZE];
+         for(size_t j = 0; j < l_stCount; j++)
+         {
+            memcpy(l_aGathered + l_stSize, l_aVec[j].m_pPtr, l_aVec[j].m_stSize);
+            l_stSize += l_aVec[j].m_stSize;
+         }
+         l_bOk = l_stSize == l_stFlat && !memcmp(l_aGathered, l_pFlat, l_stFlat);
+      }
+
+      // Сборка сегментов очередью исходящих пакетов, класс определяется по заголовку первого сегмента
+      if(l_bOk)
+      {
+         // В очереди нет места, транспорт отправляет все пакеты
+         if(g_stExpected == TEST_MAX_QUEUED || !l_Queue.Push(l_aVec, l_stCount))
+            l_bOk = Drain(l_Queue, g_stExpected) && l_Queue.Push(l_aVec, l_stCount);
+         if(l_bOk)
+         {
+            test_expected_t& l_rExpected = g_aExpected[g_stExpected++];
+            memcpy(l_rExpected.m_aPacket, l_pFlat, l_stFlat);
+            l_rExpected.m_stSize = l_stFlat;
+            l_rExpected.m_u8Class = l_PH.m_Flags.m_bPriority ? IRIDIUM_BUS_OUT_CLASS_PRIORITY : IRIDIUM_BUS_OUT_CLASS_NORMAL;
+            // Часть пакетов остается в очереди, чтобы запись в кольцо переходила в начало буфера
+            l_bOk = Drain(l_Queue, rand() % (g_stExpected + 1));
+         }
+         if(!l_bOk)
+         {
+            l_Queue.Clear();
+            g_stExpected = 0;
+         }
+      }
+
+      // Сборка сегментов реализацией SendPacketV по умолчанию
+      if(l_bOk)
+      {
+         l_bOk = l_Sink.CIridiumProtocol::SendPacketV(l_aVec, l_stCount);
+         l_bOk = l_bOk && l_Sink.m_stSize == l_stFlat && !memcmp(l_Sink.m_aPacket, l_pFlat, l_stFlat);
+      }
+
+      if(!l_bOk)
+      {
+         if(l_iErrors < 10)
+            printf("prefix %zu ref %zu suffix %zu flags %d%d%d: mismatch\n", l_stPrefix, l_stRef, l_stSuffix,
+                   l_PH.m_Flags.m_bAddress, l_PH.m_Flags.m_bSegment, l_PH.m_Flags.m_bPriority);
+         l_iErrors++;
+      }
+   }
+   printf("%d packets, %d errors\n", TEST_ITERATIONS, l_iErrors);
+   return l_iErrors ? 1 : 0;
+}
@@ -0,0 +1,220 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+//////////////////////////////////////////////////////////////////////////
+// Проверка поиска устройств раундами с сужением по префиксу хэша HWID
+//////////////////////////////////////////////////////////////////////////
+// Ведущий выполняет раунды CIridiumSearch, устройства отвечают так же, как CIridiumProtocol::GetSearchDelay:
+// только при совпадении младших бит хэша HWID с префиксом раунда. Проверяется, что каждое устройство
+// отвечает в раунде без перегрузки слотов, количество раундов растет линейно с количеством устройств,
+// устройства без поддержки слотов, отвечающие в каждом раунде, не вызывают деления префикса до
+// максимальной длины, ответы на запросы прошлых раундов не учитываются, а раунд, запрос которого не
+// удалось отправить, повторяется с тем же префиксом
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CIridiumSearch.h"
+
+#define TEST_MAX_DEVICES      512                  // Максимальное количество устройств
+#define TEST_SLOTS            16                   // Количество слотов ответа
+#define TEST_SLOT_TIME        10                   // Ширина слота в миллисекундах
+#define TEST_MAX_ROUNDS       2000                 // Ограничение количества раундов
+
+// Устройство на шине
+typedef struct test_device_s
+{
+   u16               m_u16Hash;                    // Хэш HWID
+   bool              m_bLegacy;                    // Устройство без поддержки слотов (отвечает всегда)
+   bool              m_bFound;                     // Устройство ответило в раунде без перегрузки
+} test_device_t;
+
+// Результат поиска
+typedef struct test_search_s
+{
+   size_t            m_stRounds;                   // Количество раундов
+   u8                m_u8MaxBits;                  // Наибольшая длина префикса
+   bool              m_bLoad;                      // Загрузка раундов без деления не превышает допустимую
+} test_search_t;
+
+static test_device_t g_aDevices[TEST_MAX_DEVICES];
+static size_t g_stDevices = 0;
+static int g_iErrors = 0;
+
+/**
+   Проверка условия
+   на входе    :  in_bCondition  - условие
+                  in_pszName     - название проверки
+   на выходе   :  *
+*/
+static void Check(bool in_bCondition, const char* in_pszName)
+{
+   printf("%-40s %s\n", in_pszName, in_bCondition ? "ok" : "FAILED");
+   if(!in_bCondition)
+      g_iErrors++;
+}
+
+/**
+   Создание устройств со случайными HWID
+   на входе    :  in_stDevices   - количество устройств
+                  in_stLegacy    - количество устройств без поддержки слотов
+   на выходе   :  *
+*/
+static void Init(size_t in_stDevices, size_t in_stLegacy)
+{
+   char l_szHWID[32];
+   iridium_search_info_t l_Info;
+   memset(&l_Info, 0, sizeof(l_Info));
+   l_Info.m_pszHWID = l_szHWID;
+
+   g_stDevices = in_stDevices + in_stLegacy;
+   for(size_t i = 0; i < g_stDevices; i++)
+   {
+      snprintf(l_szHWID, sizeof(l_szHWID), "%08X%08X", rand(), rand());
+      g_aDevices[i].m_u16Hash = GetSearchHash(l_Info);
+      g_aDevices[i].m_bLegacy = (i >= in_stDevices);
+      g_aDevices[i].m_bFound = false;
+   }
+}
+
+/**
+   Выполнение поиска
+   на входе    :  in_u32Time  - время начала поиска
+   на выходе   :  результат поиска
+*/
+static test_search_t Search(u32 in_u32Time)
+{
+   CIridiumSearch l_Search;
+   iridium_search_slots_t l_Slots;
+   test_search_t l_Result;
+   u16 l_u16TID = 1;
+   memset(&l_Result, 0, sizeof(l_Result));
+   l_Result.m_bLoad = true;
+
+   l_Search.Start(0, 0xFF, TEST_SLOTS, TEST_SLOT_TIME);
+   while(l_Search.IsActive() && l_Result.m_stRounds < TEST_MAX_ROUNDS)
+   {
+      if(!l_Search.IsDue(in_u32Time))
+      {
+         in_u32Time++;
+         continue;
+      }
+      if(!l_Search.Next(l_u16TID, in_u32Time, l_Slots))
+         break;
+      l_Result.m_stRounds++;
+      if(l_Slots.m_u8Bits > l_Result.m_u8MaxBits)
+         l_Result.m_u8MaxBits = l_Slots.m_u8Bits;
+
+      // Ответы устройств, совпадающих с префиксом, и устройств без поддержки слотов
+      u16 l_u16Mask = (u16)((1UL << l_Slots.m_u8Bits) - 1);
+      size_t l_stLoad = 0;
+      for(size_t i = 0; i < g_stDevices; i++)
+      {
+         bool l_bMatch = (g_aDevices[i].m_u16Hash & l_u16Mask) == (l_Slots.m_u16Prefix & l_u16Mask);
+         if(l_bMatch || g_aDevices[i].m_bLegacy)
+         {
+            // Ответ на запрос прошлого раунда не учитывается
+            l_Search.Received(l_u16TID - 1, l_Slots.m_u16Prefix);
+            if(l_Search.Received(l_u16TID, g_aDevices[i].m_u16Hash))
+               l_stLoad++;
+         }
+      }
+
+      // Раунд без деления префикса: все совпадающие устройства найдены, загрузка в допустимых пределах
+      if(l_stLoad * 100 <= (size_t)TEST_SLOTS * IRIDIUM_SEARCH_MAX_LOAD)
+      {
+         for(size_t i = 0; i < g_stDevices; i++)
+            if((g_aDevices[i].m_u16Hash & l_u16Mask) == (l_Slots.m_u16Prefix & l_u16Mask))
+               g_aDevices[i].m_bFound = true;
+      } else if(l_Slots.m_u8Bits >= IRIDIUM_SEARCH_MAX_BITS)
+         l_Result.m_bLoad = false;
+      l_u16TID++;
+   }
+   return l_Result;
+}
+
+/**
+   Проверка, что все устройства найдены
+   на входе    :  *
+   на выходе   :  true - все устройства ответили в раунде без перегрузки
+*/
+static bool IsFound()
+{
+   bool l_bResult = true;
+   for(size_t i = 0; l_bResult && i < g_stDevices; i++)
+      l_bResult = g_aDevices[i].m_bFound;
+   return l_bResult;
+}
+
+/**
+   Проверка повтора раунда и времени окончания раунда
+   на входе    :  *
+   на выходе   :  *
+*/
+static void CheckRound()
+{
+   CIridiumSearch l_Search;
+   iridium_search_slots_t l_Slots;
+   iridium_search_slots_t l_Repeat;
+   u32 l_u32Time = 0xFFFFFFFF - 100;
+   u32 l_u32Duration = TEST_SLOTS * TEST_SLOT_TIME + IRIDIUM_SEARCH_GUARD_TIME;
+
+   // Раунд заканчивается через время всех слотов и ожидания, в том числе при переполнении времени
+   bool l_bResult = !l_Search.Start(0, 0, TEST_SLOTS, TEST_SLOT_TIME) && l_Search.Start(0, 0xFF, TEST_SLOTS, TEST_SLOT_TIME) &&
+                    l_Search.IsDue(l_u32Time) && l_Search.Next(1, l_u32Time, l_Slots) && !l_Slots.m_u8Bits &&
+                    !l_Search.IsDue(l_u32Time + l_u32Duration - 1) && l_Search.IsDue(l_u32Time + l_u32Duration);
+   Check(l_bResult, "round: duration across time wrap");
+
+   // Перегруженный раунд делится на две половины, неотправленный раунд повторяется с тем же префиксом
+   l_bResult = l_Search.Start(0, 0xFF, TEST_SLOTS, TEST_SLOT_TIME) && l_Search.IsDue(0) && l_Search.Next(1, 0, l_Slots);
+   for(u16 i = 0; i < TEST_SLOTS; i++)
+      l_Search.Received(1, i);
+   l_bResult = l_bResult && l_Search.GetResponses() == TEST_SLOTS && l_Search.IsDue(l_u32Duration) && l_Search.Next(2, l_u32Duration, l_Slots) &&
+               l_Slots.m_u8Bits == 1 && l_Slots.m_u16Prefix == 0;
+   l_Search.Repeat();
+   l_bResult = l_bResult && l_Search.IsDue(l_u32Duration) && l_Search.Next(3, l_u32Duration, l_Repeat) &&
+               l_Repeat.m_u8Bits == 1 && l_Repeat.m_u16Prefix == 0 && l_Search.IsDue(2 * l_u32Duration) &&
+               l_Search.Next(4, 2 * l_u32Duration, l_Slots) && l_Slots.m_u8Bits == 1 && l_Slots.m_u16Prefix == 1 &&
+               l_Search.IsDue(3 * l_u32Duration) && !l_Search.Next(5, 3 * l_u32Duration, l_Slots) && !l_Search.IsActive();
+   Check(l_bResult, "round: split and repeat");
+}
+
+int main()
+{
+   test_search_t l_aResults[4];
+   size_t l_aDevices[4] = { 8, 64, 256, 512 };
+   bool l_bFound = true;
+   bool l_bLoad = true;
+   srand(1);
+
+   // Количество раундов на устройство не растет с количеством устройств
+   for(int i = 0; i < 4; i++)
+   {
+      Init(l_aDevices[i], 0);
+      l_aResults[i] = Search(0);
+      l_bFound = l_bFound && IsFound();
+      l_bLoad = l_bLoad && l_aResults[i].m_bLoad;
+      printf("%4u devices %4u rounds, max bits %u\n", (unsigned)l_aDevices[i], (unsigned)l_aResults[i].m_stRounds, l_aResults[i].m_u8MaxBits);
+   }
+   Check(l_bFound && l_bLoad, "search: all devices found");
+   Check(l_aResults[3].m_stRounds * l_aDevices[1] <= 2 * l_aResults[1].m_stRounds * l_aDevices[3], "search: rounds grow linearly");
+
+   // Устройства без поддержки слотов отвечают в каждом раунде, но не учитываются в загрузке
+   Init(8, 64);
+   test_search_t l_Legacy = Search(0);
+   Check(IsFound() && l_Legacy.m_u8MaxBits < 8 && l_Legacy.m_stRounds < 32, "search: legacy devices");
+
+   CheckRound();
+   return g_iErrors ? 1 : 0;
+}
@@ -0,0 +1,231 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+//////////////////////////////////////////////////////////////////////////
+// Проверка подсчета CRC16 пакетов при добавлении данных (IRIDIUM_ENABLE_STREAM_CRC16)
+//////////////////////////////////////////////////////////////////////////
+// Пакеты подаются в линейный и кольцевой шинные буферы по одному байту, как из прерывания UART. После
+// каждого байта тела CRC16 пакета-кандидата сравнивается с GetCRC16Modbus по уже полученной части тела,
+// после получения пакета проверяется, что пакет отмечен проверенным и находится при фильтрации.
+// Поврежденный пакет не отмечается и отбрасывается при поиске. Поток из пакетов и шума (случайные байты и
+// заголовки оборванных пакетов), подаваемый частями по 1-4 байта, должен дать все пакеты потока
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CIridiumBusRingBuffer.h"
+#include "CalcParity.h"
+#include "Bytes.h"
+
+#if !defined(IRIDIUM_ENABLE_STREAM_CRC16)
+   #error "IRIDIUM_ENABLE_STREAM_CRC16 must be defined in IridiumConfig.h"
+#endif
+
+#define TEST_PACKETS          200                  // Количество пакетов в проверке по одному байту
+#define TEST_STREAM_PACKETS   5000                 // Количество пакетов в потоке с шумом
+#define TEST_MAX_BODY         200                  // Максимальный размер тела пакета без CRC16
+#define TEST_MAX_CHUNK        4                    // Максимальный размер части потока
+
+static u8 g_aBuffer[IRIDIUM_BUS_RING_BUFFER_SIZE];
+static u8 g_aPacket[IRIDIUM_BUS_MAX_HEADER_SIZE + TEST_MAX_BODY + IRIDIUM_BUS_CRC_SIZE];
+static int g_iErrors = 0;
+
+//////////////////////////////////////////////////////////////////////////
+// class CTestBuffer
+//////////////////////////////////////////////////////////////////////////
+// Шинный буфер с доступом к состоянию подсчета CRC16 при добавлении данных
+template<class T> class CTestBuffer : public T
+{
+public:
+   // Получение CRC16 полученной части тела пакета-кандидата
+   u16 GetStreamCRC() const
+      { return this->m_StreamCRC.m_u16CRC; }
+   // Получение количества полученных данных пакета-кандидата
+   size_t GetStreamSize() const
+      { return this->m_StreamPacket.m_stHeader ? this->m_stStreamSize : 0; }
+   // Получение количества добавленных данных
+   size_t GetStreamCount() const
+      { return this->m_stStreamCount; }
+   // Проверка того, что пакет отмечен проверенным
+   bool IsChecked(size_t in_stStart, size_t in_stSize) const
+   {
+      bool l_bResult = false;
+      for(u8 i = 0; !l_bResult && i < IRIDIUM_BUS_STREAM_CHECKED; i++)
+         l_bResult = (this->m_aStreamChecked[i].m_stStart == in_stStart && this->m_aStreamChecked[i].m_stSize == in_stSize);
+      return l_bResult;
+   }
+};
+
+/**
+   Проверка условия
+   на входе    :  in_bCondition  - условие
+                  in_pszName     - название проверки
+   на выходе   :  *
+*/
+static void Check(bool in_bCondition, const char* in_pszName)
+{
+   printf("%-40s %s\n", in_pszName, in_bCondition ? "ok" : "FAILED");
+   if(!in_bCondition)
+      g_iErrors++;
+}
+
+/**
+   Создание пакета со случайным телом
+   на входе    :  out_pBuffer - указатель на буфер куда нужно поместить пакет
+                  in_stBody   - размер тела пакета без CRC16
+                  in_bAddress - признак пакета с адресами
+                  out_rHeader - ссылка куда нужно поместить размер заголовка
+   на выходе   :  размер пакета
+*/
+static size_t MakePacket(u8* out_pBuffer, size_t in_stBody, bool in_bAddress, size_t& out_rHeader)
+{
+   size_t l_stSize = in_stBody + IRIDIUM_BUS_CRC_SIZE;
+   out_rHeader = in_bAddress ? 5 : 3;
+   out_pBuffer[0] = IRIDIUM_BUS_PROTOCOL_ID | (in_bAddress ? 8 : 0);
+   out_pBuffer[2] = (u8)l_stSize;
+   out_pBuffer[1] = (u8)((GetParity(out_pBuffer[2]) << 7) | (1 << 3));
+   if(in_bAddress)
+   {
+      out_pBuffer[3] = (u8)rand();
+      out_pBuffer[4] = (u8)rand();
+   }
+   for(size_t i = 0; i < in_stBody; i++)
+      out_pBuffer[out_rHeader + i] = (u8)rand();
+   u16 l_u16CRC = GetCRC16Modbus(0xFFFF, out_pBuffer + out_rHeader, in_stBody);
+   WriteU16LE(out_pBuffer + out_rHeader + in_stBody, l_u16CRC);
+   return out_rHeader + l_stSize;
+}
+
+/**
+   Получение всех найденных в буфере пакетов
+   на входе    :  io_rBuffer  - ссылка на буфер
+   на выходе   :  количество пакетов
+*/
+template<class T> static size_t Receive(T& io_rBuffer)
+{
+   size_t l_stResult = 0;
+   while(io_rBuffer.FilterNoise())
+      ;
+   while(io_rBuffer.OpenPacket())
+   {
+      l_stResult++;
+      io_rBuffer.ClosePacket();
+   }
+   return l_stResult;
+}
+
+/**
+   Проверка подсчета CRC16 при добавлении пакетов по одному байту
+   на входе    :  in_pszName  - название буфера
+   на выходе   :  *
+*/
+template<class T> static void CheckBytes(const char* in_pszName)
+{
+   CTestBuffer<T> l_Buffer;
+   char l_szName[64];
+   bool l_bCRC = true;
+   bool l_bChecked = true;
+   bool l_bCorrupted = true;
+   size_t l_stHeader = 0;
+   srand(1);
+
+   l_Buffer.SetBuffer(g_aBuffer, sizeof(g_aBuffer));
+   l_Buffer.Clear();
+   for(size_t n = 0; n < TEST_PACKETS; n++)
+   {
+      size_t l_stBody = (size_t)rand() % (TEST_MAX_BODY + 1);
+      size_t l_stSize = MakePacket(g_aPacket, l_stBody, rand() & 1, l_stHeader);
+      size_t l_stStart = l_Buffer.GetStreamCount();
+
+      // Каждый третий пакет поврежден
+      bool l_bCorrupt = (n % 3 == 2) && l_stBody;
+      if(l_bCorrupt)
+         g_aPacket[l_stHeader + (size_t)rand() % l_stBody] ^= 1 << (rand() % 8);
+
+      for(size_t i = 0; i < l_stSize; i++)
+      {
+         l_Buffer.AddByte(g_aPacket[i]);
+         // CRC16 полученной части тела
+         if(i >= l_stHeader && i < l_stHeader + l_stBody)
+            l_bCRC = l_bCRC && l_Buffer.GetStreamSize() == i + 1 &&
+                     l_Buffer.GetStreamCRC() == GetCRC16Modbus(0xFFFF, g_aPacket + l_stHeader, i + 1 - l_stHeader);
+      }
+
+      // Пакет отмечен проверенным только если CRC16 совпала, поврежденный пакет отбрасывается
+      size_t l_stPackets = Receive(l_Buffer);
+      if(l_bCorrupt)
+         l_bCorrupted = l_bCorrupted && !l_Buffer.IsChecked(l_stStart, l_stSize) && !l_stPackets;
+      else
+         l_bChecked = l_bChecked && l_Buffer.IsChecked(l_stStart, l_stSize) && l_stPackets == 1;
+   }
+
+   snprintf(l_szName, sizeof(l_szName), "%s: body CRC byte by byte", in_pszName);
+   Check(l_bCRC, l_szName);
+   snprintf(l_szName, sizeof(l_szName), "%s: packet checked", in_pszName);
+   Check(l_bChecked, l_szName);
+   snprintf(l_szName, sizeof(l_szName), "%s: corrupted packet dropped", in_pszName);
+   Check(l_bCorrupted, l_szName);
+}
+
+/**
+   Проверка приема потока из пакетов и шума частями
+   на входе    :  in_pszName  - название буфера
+   на выходе   :  *
+*/
+template<class T> static void CheckStream(const char* in_pszName)
+{
+   static u8 l_aStream[TEST_STREAM_PACKETS * (sizeof(g_aPacket) + 4)];
+   CTestBuffer<T> l_Buffer;
+   char l_szName[64];
+   size_t l_stSize = 0;
+   size_t l_stHeader = 0;
+   size_t l_stPackets = 0;
+   srand(2);
+
+   // Между пакетами шум: случайный байт или заголовок оборванного пакета
+   for(size_t n = 0; n < TEST_STREAM_PACKETS; n++)
+   {
+      if(rand() % 5 == 0)
+      {
+         if(rand() % 4)
+            l_aStream[l_stSize++] = (u8)rand();
+         else
+            l_stSize += MakePacket(l_aStream + l_stSize, (size_t)rand() % TEST_MAX_BODY, rand() & 1, l_stHeader) - 3;
+         l_aStream[l_stSize - 1] &= ~IRIDIUM_PROTOCOL_ID_MASK;
+      }
+      l_stSize += MakePacket(l_aStream + l_stSize, (size_t)rand() % (TEST_MAX_BODY + 1), rand() & 1, l_stHeader);
+   }
+
+   l_Buffer.SetBuffer(g_aBuffer, sizeof(g_aBuffer));
+   l_Buffer.Clear();
+   for(size_t l_stPos = 0; l_stPos < l_stSize;)
+   {
+      size_t l_stChunk = (size_t)rand() % TEST_MAX_CHUNK + 1;
+      if(l_stChunk > l_stSize - l_stPos)
+         l_stChunk = l_stSize - l_stPos;
+      l_stPos += l_Buffer.Add(l_aStream + l_stPos, l_stChunk);
+      l_stPackets += Receive(l_Buffer);
+   }
+   snprintf(l_szName, sizeof(l_szName), "%s: stream with noise", in_pszName);
+   Check(l_stPackets == TEST_STREAM_PACKETS, l_szName);
+}
+
+int main()
+{
+   CheckBytes<CIridiumBusInBuffer>("linear");
+   CheckBytes<CIridiumBusRingBuffer>("ring");
+   CheckStream<CIridiumBusInBuffer>("linear");
+   CheckStream<CIridiumBusRingBuffer>("ring");
+   return g_iErrors ? 1 : 0;
+}
@@ -0,0 +1,503 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+//////////////////////////////////////////////////////////////////////////
+// Проверка окна передачи блоков потока с выборочным подтверждением
+//////////////////////////////////////////////////////////////////////////
+// Проверяется прием CIridiumStreamWindow: сохранение блоков вне очереди в буфере (индексация мест при
+// переполнении идентификатора блока), передача приложению строго по порядку, отбрасывание повторов и блоков
+// вне окна. Проверяется передача: сдвиг маски подтверждения, обнаружение пропуска по более позднему
+// подтвержденному блоку, однократный повтор по обнаруженному пропуску, повторное и устаревшее подтверждение,
+// повтор по тайм-ауту и прерывание передачи. Окна приема и передачи соединяются моделью канала с потерями,
+// повторами и перестановкой пакетов. На модели шины проверяется передача окном и переход к передаче по
+// одному блоку, если устройство ответило на запрос открытия без размера окна
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CIridiumBusProtocol.h"
+
+#define TEST_WINDOW           8                    // Размер окна
+#define TEST_SLOT_SIZE        8                    // Размер места под блок в буфере приемника
+#define TEST_CHANNEL_PACKETS  64                   // Размер очереди пакетов модели канала
+#define TEST_STREAM_BLOCKS    1000                 // Количество блоков потока на модели канала
+#define TEST_MASTER           1                    // Адрес ведущего
+#define TEST_SLAVE            10                   // Адрес ведомого
+#define TEST_STREAM_ID        5                    // Идентификатор потока ведомого
+#define TEST_BLOCK_SIZE       64                   // Размер блока потока на модели шины
+#define TEST_BUS_BLOCKS       40                   // Количество блоков потока на модели шины
+#define TEST_WIRE_PACKETS     32                   // Размер очереди пакетов на шине
+
+// Пакет модели канала: блок или подтверждение
+typedef struct test_channel_packet_s
+{
+   bool              m_bAck;                       // Признак подтверждения
+   u8                m_u8BlockID;                  // Идентификатор блока
+   u16               m_u16Mask;                    // Маска подтверждения
+   u32               m_u32Data;                    // Данные блока (номер блока в потоке)
+} test_channel_packet_t;
+
+// Пакет на шине
+typedef struct test_packet_s
+{
+   u8                m_aData[IRIDIUM_BUS_OUT_BUFFER_SIZE + IRIDIUM_BUS_CRC_SIZE]; // Данные пакета
+   u16               m_u16Size;                    // Размер пакета
+   iridium_address_t m_SrcAddr;                    // Адрес отправителя
+} test_packet_t;
+
+static u8 g_aBuffer[(TEST_WINDOW - 1) * TEST_SLOT_SIZE];
+static test_channel_packet_t g_aChannel[TEST_CHANNEL_PACKETS];
+static size_t g_stChannel = 0;
+static test_packet_t g_aWire[TEST_WIRE_PACKETS];
+static size_t g_stWire = 0;
+static u8 g_aImage[TEST_BUS_BLOCKS * TEST_BLOCK_SIZE];
+static int g_iErrors = 0;
+
+/**
+   Проверка условия
+   на входе    :  in_bCondition  - условие
+                  in_pszName     - название проверки
+   на выходе   :  *
+*/
+static void Check(bool in_bCondition, const char* in_pszName)
+{
+   printf("%-40s %s\n", in_pszName, in_bCondition ? "ok" : "FAILED");
+   if(!in_bCondition)
+      g_iErrors++;
+}
+
+/**
+   Прием блока окном с номером блока в данных
+   на входе    :  in_rWindow     - ссылка на окно приема
+                  in_u32Index    - номер блока в потоке
+                  io_rDelivered  - ссылка на количество блоков переданных приложению
+   на выходе   :  true - все блоки переданы приложению по порядку
+   примечание  :  повторяет CIridiumProtocol::ReceiveStreamWindowBlock
+*/
+static bool Receive(CIridiumStreamWindow& in_rWindow, u32 in_u32Index, u32& io_rDelivered)
+{
+   bool l_bResult = true;
+   u8 l_u8BlockID = 0;
+   u16 l_u16Size = 0;
+   void* l_pData = NULL;
+
+   if(in_rWindow.Receive((u8)in_u32Index, sizeof(in_u32Index), &in_u32Index))
+   {
+      l_bResult = (in_u32Index == io_rDelivered++);
+      in_rWindow.Delivered(sizeof(in_u32Index));
+      while(in_rWindow.GetStored(l_u8BlockID, l_u16Size, l_pData))
+      {
+         u32 l_u32Index = 0;
+         memcpy(&l_u32Index, l_pData, sizeof(l_u32Index));
+         l_bResult = l_bResult && l_u16Size == sizeof(l_u32Index) && l_u8BlockID == (u8)l_u32Index && l_u32Index == io_rDelivered++;
+         in_rWindow.Delivered(l_u16Size);
+      }
+   }
+   return l_bResult;
+}
+
+/**
+   Проверка приема блоков
+   на входе    :  *
+   на выходе   :  *
+*/
+static void CheckReceive()
+{
+   CIridiumStreamWindow l_Window;
+   u32 l_u32Delivered = 0;
+   u8 l_u8BlockID = 0;
+   u16 l_u16Size = 0;
+   u16 l_u16Mask = 0;
+   void* l_pData = NULL;
+
+   l_Window.SetBuffer(g_aBuffer, sizeof(g_aBuffer), TEST_SLOT_SIZE);
+   l_Window.Open(TEST_MASTER, TEST_STREAM_ID, TEST_WINDOW);
+   bool l_bResult = l_Window.GetMaxWindow() == TEST_WINDOW && Receive(l_Window, 0, l_u32Delivered);
+   l_Window.GetAck(l_u8BlockID, l_u16Size, l_u16Mask);
+   Check(l_bResult && l_u32Delivered == 1 && l_u8BlockID == 0 && l_u16Size == sizeof(u32) && !l_u16Mask, "receive: in order");
+
+   // Блоки вне очереди сохраняются, маска отмечает блоки после последнего полученного по порядку
+   l_bResult = Receive(l_Window, 2, l_u32Delivered) && Receive(l_Window, 4, l_u32Delivered) && l_u32Delivered == 1;
+   l_Window.GetAck(l_u8BlockID, l_u16Size, l_u16Mask);
+   l_bResult = l_bResult && l_u8BlockID == 0 && l_u16Mask == 0x000A && !l_Window.GetStored(l_u8BlockID, l_u16Size, l_pData);
+   // Повтор сохраненного блока и блок вне окна отбрасываются
+   l_bResult = l_bResult && Receive(l_Window, 2, l_u32Delivered) && Receive(l_Window, 1 + TEST_WINDOW, l_u32Delivered);
+   l_Window.GetAck(l_u8BlockID, l_u16Size, l_u16Mask);
+   l_bResult = l_bResult && l_u16Mask == 0x000A;
+   // Пропущенный блок передает приложению его и следующие за ним сохраненные блоки
+   l_bResult = l_bResult && Receive(l_Window, 1, l_u32Delivered) && l_u32Delivered == 3;
+   l_Window.GetAck(l_u8BlockID, l_u16Size, l_u16Mask);
+   Check(l_bResult && l_u8BlockID == 2 && l_u16Mask == 0x0002, "receive: reordered blocks stored");
+
+   // Повтор уже переданного блока отбрасывается, подтверждение не меняется
+   l_bResult = Receive(l_Window, 1, l_u32Delivered) && Receive(l_Window, 3, l_u32Delivered) && l_u32Delivered == 5;
+   l_Window.GetAck(l_u8BlockID, l_u16Size, l_u16Mask);
+   Check(l_bResult && l_u8BlockID == 4 && !l_u16Mask, "receive: duplicate dropped");
+
+   // Каждая группа блоков окна принимается в обратном порядке, места буфера переиспользуются при
+   // переполнении идентификатора блока
+   l_bResult = true;
+   for(u32 i = 5; l_bResult && i + TEST_WINDOW <= 5 + 100 * TEST_WINDOW; i += TEST_WINDOW)
+   {
+      for(u32 j = TEST_WINDOW; l_bResult && j > 0; j--)
+         l_bResult = Receive(l_Window, i + j - 1, l_u32Delivered);
+      l_Window.GetAck(l_u8BlockID, l_u16Size, l_u16Mask);
+      l_bResult = l_bResult && l_u32Delivered == i + TEST_WINDOW && l_u8BlockID == (u8)(i + TEST_WINDOW - 1) && !l_u16Mask;
+   }
+   Check(l_bResult, "receive: slot indexing across wrap");
+
+   // Блок не принят приложением, прием прекращается
+   l_Window.Delivered(0);
+   l_Window.GetAck(l_u8BlockID, l_u16Size, l_u16Mask);
+   Check(l_Window.IsFailed() && !l_u16Size && !l_Window.Receive(l_u8BlockID + 1, 0, NULL), "receive: rejected block stops stream");
+}
+
+/**
+   Отправка новых блоков окном
+   на входе    :  in_rWindow  - ссылка на окно передачи
+                  in_u32Time  - время
+   на выходе   :  номер первого отправленного блока, 0xFFFFFFFF - блок не отправлен
+*/
+static u32 Send(CIridiumStreamWindow& in_rWindow, u32 in_u32Time)
+{
+   u32 l_u32Result = 0xFFFFFFFF;
+   u32 l_u32Index = 0;
+   if(in_rWindow.GetNext(in_u32Time, l_u32Index))
+   {
+      in_rWindow.Sent(l_u32Index, in_u32Time);
+      l_u32Result = l_u32Index;
+   }
+   return l_u32Result;
+}
+
+/**
+   Проверка передачи блоков
+   на входе    :  *
+   на выходе   :  *
+*/
+static void CheckSend()
+{
+   CIridiumStreamWindow l_Window;
+   u32 l_u32Time = 1000;
+   bool l_bResult = true;
+
+   // Окно заполняется новыми блоками
+   l_Window.Open(TEST_SLAVE, TEST_STREAM_ID, 4);
+   for(u32 i = 0; l_bResult && i < 4; i++)
+      l_bResult = Send(l_Window, l_u32Time) == i;
+   Check(l_bResult && Send(l_Window, l_u32Time) == 0xFFFFFFFF, "send: window full");
+
+   // Подтвержден блок 0 по порядку и блок 2 по маске: блок 1 потерян и повторяется сразу, раньше новых
+   l_bResult = l_Window.Acknowledge(0, 0x0002) == 1 && l_Window.GetBase() == 1 && Send(l_Window, l_u32Time + 1) == 1 &&
+               Send(l_Window, l_u32Time + 1) == 4 && Send(l_Window, l_u32Time + 1) == 0xFFFFFFFF;
+   Check(l_bResult, "send: loss detected by later ack");
+
+   // Повторное подтверждение не вызывает второго повтора по обнаруженному пропуску
+   l_bResult = l_Window.Acknowledge(0, 0x0002) == 0 && Send(l_Window, l_u32Time + 2) == 0xFFFFFFFF;
+   // Подтверждение блока 3 по маске не повторяет уже повторенный блок 1
+   l_bResult = l_bResult && l_Window.Acknowledge(0, 0x0006) == 0 && Send(l_Window, l_u32Time + 2) == 0xFFFFFFFF;
+   Check(l_bResult, "send: resend once");
+
+   // Устаревшее подтверждение и подтверждение неотправленного блока не учитываются
+   l_bResult = l_Window.Acknowledge(0xFF, 0) == -1 && l_Window.Acknowledge(5, 0) == -1 && l_Window.GetBase() == 1;
+   Check(l_bResult, "send: stale ack");
+
+   // Неподтвержденные блоки повторяются по тайм-ауту
+   l_bResult = Send(l_Window, l_u32Time + IRIDIUM_STREAM_RETRY_TIME) == 0xFFFFFFFF && Send(l_Window, l_u32Time + 1 + IRIDIUM_STREAM_RETRY_TIME) == 1 &&
+               Send(l_Window, l_u32Time + 1 + IRIDIUM_STREAM_RETRY_TIME) == 4;
+   // Накопительное подтверждение сдвигает окно и маску
+   l_bResult = l_bResult && l_Window.Acknowledge(3, 0x0000) == 3 && l_Window.GetBase() == 4 &&
+               Send(l_Window, l_u32Time + 1 + IRIDIUM_STREAM_RETRY_TIME) == 5;
+   l_Window.SetEnd(6);
+   l_bResult = l_bResult && l_Window.Acknowledge(5, 0) == 2 && l_Window.IsComplete() && !l_Window.IsFailed();
+   Check(l_bResult, "send: timeout and cumulative ack");
+
+   // Передача прерывается после IRIDIUM_STREAM_MAX_RETRIES повторов по тайм-ауту
+   l_Window.Open(TEST_SLAVE, TEST_STREAM_ID, 4);
+   l_bResult = Send(l_Window, 0) == 0;
+   for(u32 i = 1; l_bResult && i <= IRIDIUM_STREAM_MAX_RETRIES; i++)
+      l_bResult = Send(l_Window, i * IRIDIUM_STREAM_RETRY_TIME) == 0;
+   l_bResult = l_bResult && Send(l_Window, (IRIDIUM_STREAM_MAX_RETRIES + 1) * IRIDIUM_STREAM_RETRY_TIME) == 0xFFFFFFFF;
+   Check(l_bResult && l_Window.IsFailed(), "send: max retries");
+}
+
+/**
+   Добавление пакета в модель канала с потерями и повторами
+   на входе    :  in_rPacket  - ссылка на пакет
+   на выходе   :  *
+*/
+static void Post(test_channel_packet_t& in_rPacket)
+{
+   int l_iCopies = (rand() % 100 < 5) ? 0 : ((rand() % 100 < 5) ? 2 : 1);
+   for(int i = 0; i < l_iCopies && g_stChannel < TEST_CHANNEL_PACKETS; i++)
+      g_aChannel[g_stChannel++] = in_rPacket;
+}
+
+/**
+   Проверка передачи потока через канал с потерями, повторами и перестановкой пакетов
+   на входе    :  *
+   на выходе   :  *
+*/
+static void CheckChannel()
+{
+   CIridiumStreamWindow l_Tx;
+   CIridiumStreamWindow l_Rx;
+   u32 l_u32Delivered = 0;
+   u32 l_u32Time = 0;
+   u32 l_u32Sent = 0;
+   u32 l_u32Index = 0;
+   bool l_bResult = true;
+   srand(3);
+
+   l_Rx.SetBuffer(g_aBuffer, sizeof(g_aBuffer), TEST_SLOT_SIZE);
+   l_Rx.Open(TEST_MASTER, TEST_STREAM_ID, TEST_WINDOW);
+   l_Tx.Open(TEST_SLAVE, TEST_STREAM_ID, TEST_WINDOW);
+   g_stChannel = 0;
+
+   while(l_bResult && !l_Tx.IsComplete() && !l_Tx.IsFailed() && l_u32Time < 1000000)
+   {
+      // Отправка повторов и новых блоков
+      while(l_Tx.GetNext(l_u32Time, l_u32Index))
+      {
+         if(l_u32Index == TEST_STREAM_BLOCKS)
+            l_Tx.SetEnd(l_u32Index);
+         else
+         {
+            test_channel_packet_t l_Packet = { false, (u8)l_u32Index, 0, l_u32Index };
+            l_Tx.Sent(l_u32Index, l_u32Time);
+            Post(l_Packet);
+            l_u32Sent++;
+         }
+      }
+
+      // Доставка нескольких пакетов в случайном порядке
+      for(int i = 0; l_bResult && g_stChannel && i < 4; i++)
+      {
+         size_t l_stIndex = (size_t)rand() % g_stChannel;
+         test_channel_packet_t l_Packet = g_aChannel[l_stIndex];
+         g_aChannel[l_stIndex] = g_aChannel[--g_stChannel];
+         if(l_Packet.m_bAck)
+            l_Tx.Acknowledge(l_Packet.m_u8BlockID, l_Packet.m_u16Mask);
+         else
+         {
+            l_bResult = Receive(l_Rx, l_Packet.m_u32Data, l_u32Delivered);
+            u16 l_u16Size = 0;
+            l_Packet.m_bAck = true;
+            l_Rx.GetAck(l_Packet.m_u8BlockID, l_u16Size, l_Packet.m_u16Mask);
+            Post(l_Packet);
+         }
+      }
+      l_u32Time += 10;
+   }
+   printf("%u blocks, %u sent, %u ms\n", (unsigned)TEST_STREAM_BLOCKS, (unsigned)l_u32Sent, (unsigned)l_u32Time);
+   Check(l_bResult && l_Tx.IsComplete() && !l_Tx.IsFailed() && l_u32Delivered == TEST_STREAM_BLOCKS, "channel: loss, reorder, duplicates");
+}
+
+//////////////////////////////////////////////////////////////////////////
+// class CTestNode
+//////////////////////////////////////////////////////////////////////////
+// Узел шины: ведущий передает образ блоками, ведомый собирает принятые блоки
+class CTestNode : public CIridiumBusProtocol
+{
+public:
+   CTestNode(iridium_address_t in_Address)
+   {
+      m_OutBuffer.SetBuffer(IRIDIUM_BUS_MAX_HEADER_SIZE, IRIDIUM_BUS_CRC_SIZE, m_aOut, sizeof(m_aOut));
+      m_OutPH.m_u8Type = IRIDIUM_BUS_PROTOCOL_ID;
+      SetAddress(in_Address);
+      SetStreamBuffer(m_aBuffer, sizeof(m_aBuffer), TEST_BLOCK_SIZE);
+      Clear();
+   }
+
+   // Очистка состояния передачи
+   void Clear()
+   {
+      memset(m_aImage, 0, sizeof(m_aImage));
+      m_stImage = 0;
+      m_u8StreamID = 0;
+      m_u8BlockID = 0;
+      m_u16BlockSize = 0;
+      m_bComplete = false;
+      m_bSuccess = false;
+   }
+
+   // Отправка пакета на шину
+   virtual bool SendPacket(void* in_pBuffer, size_t in_stSize)
+   {
+      bool l_bResult = false;
+      if(g_stWire < TEST_WIRE_PACKETS)
+      {
+         test_packet_t& l_rPacket = g_aWire[g_stWire++];
+         memcpy(l_rPacket.m_aData, in_pBuffer, in_stSize);
+         l_rPacket.m_u16Size = (u16)in_stSize;
+         l_rPacket.m_SrcAddr = m_Address;
+         l_bResult = true;
+      }
+      return l_bResult;
+   }
+
+   // Разбор полученного пакета
+   void Receive(test_packet_t& in_rPacket)
+   {
+      m_InBuffer.SetBuffer(in_rPacket.m_aData, in_rPacket.m_u16Size);
+      m_InBuffer.FilterNoiseAndForeignPacket(m_Address);
+      while(m_InBuffer.OpenPacket())
+      {
+         ProcessMessage(m_InBuffer.GetPacketHeader(), m_InBuffer.GetMessagePtr(), m_InBuffer.GetMessageSize());
+         m_InBuffer.ClosePacket();
+      }
+   }
+
+   u8                m_aImage[sizeof(g_aImage)];   // Принятый образ
+   size_t            m_stImage;                    // Размер принятого образа
+   u8                m_u8StreamID;                 // Идентификатор открытого потока
+   u8                m_u8BlockID;                  // Идентификатор последнего подтвержденного блока
+   u16               m_u16BlockSize;               // Результат обработки последнего подтвержденного блока
+   bool              m_bComplete;                  // Признак окончания передачи окном
+   bool              m_bSuccess;                   // Признак успешной передачи окном
+
+protected:
+   virtual u8 StreamOpen(const char* in_pszName, eIridiumStreamMode in_eMode)
+      { return TEST_STREAM_ID; }
+   virtual void StreamOpenResult(const char* in_pszName, eIridiumStreamMode in_eMode, u8 in_u8StreamID)
+      { m_u8StreamID = in_u8StreamID; }
+
+   virtual size_t StreamBlock(u8 in_u8StreamID, u8 in_u8BlockID, size_t in_stSize, const void* in_pBuffer)
+   {
+      size_t l_stResult = 0;
+      if(m_stImage + in_stSize <= sizeof(m_aImage))
+      {
+         memcpy(m_aImage + m_stImage, in_pBuffer, in_stSize);
+         m_stImage += in_stSize;
+         l_stResult = in_stSize;
+      }
+      return l_stResult;
+   }
+
+   virtual void StreamBlockResult(u8 in_u8StreamID, u8 in_u8BlockID, size_t in_stSize)
+   {
+      m_u8BlockID = in_u8BlockID;
+      m_u16BlockSize = (u16)in_stSize;
+   }
+
+   virtual bool StreamGetBlock(iridium_address_t in_DstAddr, u8 in_u8StreamID, u32 in_u32Index, const void*& out_rBlock, u16& out_rSize)
+   {
+      bool l_bResult = (in_u32Index < TEST_BUS_BLOCKS);
+      if(l_bResult)
+      {
+         out_rBlock = g_aImage + in_u32Index * TEST_BLOCK_SIZE;
+         out_rSize = TEST_BLOCK_SIZE;
+      }
+      return l_bResult;
+   }
+
+   virtual void StreamComplete(iridium_address_t in_DstAddr, u8 in_u8StreamID, bool in_bSuccess)
+   {
+      m_bComplete = true;
+      m_bSuccess = in_bSuccess;
+   }
+
+private:
+   u8                m_aOut[IRIDIUM_BUS_OUT_BUFFER_SIZE]; // Буфер исходящего пакета
+   u8                m_aBuffer[(TEST_WINDOW - 1) * TEST_BLOCK_SIZE]; // Буфер блоков вне очереди
+};
+
+static CTestNode* g_pMaster = NULL;
+static CTestNode* g_pSlave = NULL;
+
+/**
+   Доставка всех пакетов на шине, включая ответы, отправленные при доставке
+   на входе    :  *
+   на выходе   :  *
+*/
+static void Deliver()
+{
+   static test_packet_t l_aPackets[TEST_WIRE_PACKETS];
+   while(g_stWire)
+   {
+      size_t l_stCount = g_stWire;
+      memcpy(l_aPackets, g_aWire, l_stCount * sizeof(test_packet_t));
+      g_stWire = 0;
+      for(size_t i = 0; i < l_stCount; i++)
+      {
+         if(l_aPackets[i].m_SrcAddr == TEST_MASTER)
+            g_pSlave->Receive(l_aPackets[i]);
+         else
+            g_pMaster->Receive(l_aPackets[i]);
+      }
+   }
+}
+
+/**
+   Проверка передачи потока на модели шины
+   на входе    :  *
+   на выходе   :  *
+*/
+static void CheckBus()
+{
+   for(size_t i = 0; i < sizeof(g_aImage); i++)
+      g_aImage[i] = (u8)rand();
+
+   // Передача окном: в пути до TEST_WINDOW блоков
+   g_pMaster->Clear();
+   g_pSlave->Clear();
+   g_pMaster->SendStreamOpenRequest(TEST_SLAVE, "image", IRIDIUM_STREAM_MODE_WRITE, 0, TEST_WINDOW);
+   Deliver();
+   bool l_bResult = g_pMaster->m_u8StreamID == TEST_STREAM_ID && g_pMaster->GetStreamWindow(TEST_SLAVE, TEST_STREAM_ID) == TEST_WINDOW;
+   g_pMaster->ProcessStream(0);
+   l_bResult = l_bResult && g_stWire == TEST_WINDOW;
+   for(u32 i = 1; !g_pMaster->m_bComplete && i < 10 * TEST_BUS_BLOCKS; i++)
+   {
+      Deliver();
+      g_pMaster->ProcessStream(i);
+   }
+   Check(l_bResult && g_pMaster->m_bSuccess && g_pSlave->m_stImage == sizeof(g_aImage) && !memcmp(g_pSlave->m_aImage, g_aImage, sizeof(g_aImage)),
+         "bus: window transfer");
+
+   // Ответ на запрос открытия без размера окна, как у устройства без поддержки окна: окно освобождается,
+   // поток передается по одному блоку с ожиданием подтверждения каждого блока
+   g_pMaster->Clear();
+   g_pSlave->Clear();
+   g_pMaster->SendStreamOpenRequest(TEST_SLAVE, "image", IRIDIUM_STREAM_MODE_WRITE, 0, TEST_WINDOW);
+   g_stWire = 0;
+   g_pMaster->SendStreamOpenRequest(TEST_SLAVE, "image", IRIDIUM_STREAM_MODE_WRITE, 0);
+   Deliver();
+   l_bResult = g_pMaster->m_u8StreamID == TEST_STREAM_ID && !g_pMaster->GetStreamWindow(TEST_SLAVE, TEST_STREAM_ID);
+   g_pMaster->ProcessStream(0);
+   l_bResult = l_bResult && !g_stWire;
+   for(u32 i = 0; l_bResult && i < TEST_BUS_BLOCKS; i++)
+   {
+      g_pMaster->SendStreamBlockRequest(TEST_SLAVE, TEST_STREAM_ID, (u8)i, TEST_BLOCK_SIZE, g_aImage + i * TEST_BLOCK_SIZE);
+      l_bResult = (g_stWire == 1);
+      Deliver();
+      l_bResult = l_bResult && g_pMaster->m_u8BlockID == (u8)i && g_pMaster->m_u16BlockSize == TEST_BLOCK_SIZE;
+   }
+   Check(l_bResult && !g_pMaster->m_bComplete && g_pSlave->m_stImage == sizeof(g_aImage) && !memcmp(g_pSlave->m_aImage, g_aImage, sizeof(g_aImage)),
+         "bus: legacy peer stop-and-wait");
+}
+
+int main()
+{
+   g_pMaster = new CTestNode(TEST_MASTER);
+   g_pSlave = new CTestNode(TEST_SLAVE);
+
+   CheckReceive();
+   CheckSend();
+   CheckChannel();
+   CheckBus();
+
+   delete g_pMaster;
+   delete g_pSlave;
+   return g_iErrors ? 1 : 0;
+}
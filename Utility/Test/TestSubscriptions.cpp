@@ -0,0 +1,204 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+//////////////////////////////////////////////////////////////////////////
+// Проверка таблицы подписок на изменение каналов обратной связи
+//////////////////////////////////////////////////////////////////////////
+// Таблица обрабатывается так же, как в CIridiumProtocol::ProcessSubscriptions. Проверяется немедленная
+// отправка значения после подписки, объединение частых изменений до минимального интервала, пропуск
+// изменений в пределах зоны нечувствительности, контрольная отправка по истечении максимального интервала,
+// в том числе при переполнении счетчика времени, а также упорядоченность и заполнение таблицы
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CIridiumSubscriptions.h"
+
+#define TEST_TAG              5                    // Идентификатор канала обратной связи
+#define TEST_ADDR             10                   // Адрес подписчика
+#define TEST_MIN_INTERVAL     100                  // Минимальный интервал отправки
+#define TEST_MAX_INTERVAL     1000                 // Максимальный интервал отправки
+#define TEST_DEADBAND         1.0f                 // Зона нечувствительности
+
+static CIridiumSubscriptions g_Subscriptions;
+static u32 g_u32Base = 0;                          // Начало отсчета времени проверки
+static int g_iErrors = 0;
+
+/**
+   Проверка условия
+   на входе    :  in_bCondition  - условие
+                  in_pszName     - название проверки
+   на выходе   :  *
+*/
+static void Check(bool in_bCondition, const char* in_pszName)
+{
+   printf("%-40s %s\n", in_pszName, in_bCondition ? "ok" : "FAILED");
+   if(!in_bCondition)
+      g_iErrors++;
+}
+
+/**
+   Обработка подписок с текущим значением канала
+   на входе    :  in_u32Time  - время от начала отсчета
+                  in_u8Type   - тип текущего значения
+                  in_rValue   - ссылка на текущее значение
+   на выходе   :  количество отправленных значений
+*/
+static size_t Process(u32 in_u32Time, u8 in_u8Type, universal_value_t& in_rValue)
+{
+   size_t l_stResult = 0;
+   if(g_Subscriptions.IsDue(g_u32Base + in_u32Time))
+   {
+      for(size_t i = 0; i < g_Subscriptions.GetCount(); i++)
+      {
+         iridium_subscription_t* l_pSubscription = g_Subscriptions.Get(i);
+         u8 l_u8Due = g_Subscriptions.GetDue(l_pSubscription);
+         if(l_u8Due)
+         {
+            if(l_u8Due == IRIDIUM_SUBSCRIPTION_CHANGED && !g_Subscriptions.IsChanged(l_pSubscription, in_u8Type, in_rValue))
+               g_Subscriptions.Skip(l_pSubscription);
+            else
+            {
+               g_Subscriptions.Sent(l_pSubscription, in_u8Type, in_rValue);
+               l_stResult++;
+            }
+         }
+      }
+      g_Subscriptions.Schedule();
+   }
+   return l_stResult;
+}
+
+/**
+   Обработка подписок с числовым значением канала
+   на входе    :  in_u32Time  - время от начала отсчета
+                  in_f32Value - текущее значение
+   на выходе   :  количество отправленных значений
+*/
+static size_t Process(u32 in_u32Time, f32 in_f32Value)
+{
+   universal_value_t l_Value;
+   l_Value.m_f32Value = in_f32Value;
+   return Process(in_u32Time, IVT_F32, l_Value);
+}
+
+/**
+   Изменение значения канала
+   на входе    :  in_u32Time  - время от начала отсчета
+                  in_f32Value - текущее значение
+   на выходе   :  количество отправленных значений
+*/
+static size_t Change(u32 in_u32Time, f32 in_f32Value)
+{
+   size_t l_stResult = Process(in_u32Time, in_f32Value);
+   g_Subscriptions.SetChanged(TEST_TAG);
+   return l_stResult + Process(in_u32Time, in_f32Value);
+}
+
+/**
+   Проверка интервалов отправки и зоны нечувствительности
+   на входе    :  in_u32Base  - начало отсчета времени
+                  in_pszName  - название проверки
+   на выходе   :  *
+*/
+static void CheckIntervals(u32 in_u32Base, const char* in_pszName)
+{
+   char l_szName[64];
+   bool l_bResult = true;
+   g_Subscriptions.Clear();
+   g_u32Base = in_u32Base;
+
+   // Значение отправляется сразу после подписки, без проверки зоны нечувствительности
+   Process(0, 10.0f);
+   g_Subscriptions.Add(TEST_TAG, TEST_ADDR, TEST_MIN_INTERVAL, TEST_MAX_INTERVAL, TEST_DEADBAND);
+   l_bResult = Process(0, 10.0f) == 1;
+
+   // Изменение в пределах зоны нечувствительности пропускается
+   l_bResult = l_bResult && Change(10, 10.5f) == 0 && Process(TEST_MIN_INTERVAL - 1, 10.5f) == 0 && Process(TEST_MIN_INTERVAL, 10.5f) == 0;
+
+   // Изменение за пределами зоны отправляется, если минимальный интервал уже истек
+   l_bResult = l_bResult && Change(150, 11.2f) == 1;
+   snprintf(l_szName, sizeof(l_szName), "%s: deadband", in_pszName);
+   Check(l_bResult, l_szName);
+
+   // Частые изменения объединяются и отправляются по истечении минимального интервала
+   l_bResult = Change(160, 13.0f) == 0 && Change(170, 15.0f) == 0 && Process(249, 15.0f) == 0 && Process(250, 15.0f) == 1 &&
+               Process(260, 15.0f) == 0;
+   snprintf(l_szName, sizeof(l_szName), "%s: min interval", in_pszName);
+   Check(l_bResult, l_szName);
+
+   // Без изменений значение отправляется по истечении максимального интервала
+   l_bResult = Process(250 + TEST_MAX_INTERVAL - 1, 15.0f) == 0 && Process(250 + TEST_MAX_INTERVAL, 15.0f) == 1 &&
+               Process(250 + 2 * TEST_MAX_INTERVAL - 1, 15.0f) == 0 && Process(250 + 2 * TEST_MAX_INTERVAL, 15.0f) == 1;
+   // Контрольная отправка обновляет значение для зоны нечувствительности
+   l_bResult = l_bResult && Change(250 + 2 * TEST_MAX_INTERVAL + 200, 15.9f) == 0;
+   snprintf(l_szName, sizeof(l_szName), "%s: max interval", in_pszName);
+   Check(l_bResult, l_szName);
+}
+
+/**
+   Проверка нечисловых значений, нескольких подписчиков и заполнения таблицы
+   на входе    :  *
+   на выходе   :  *
+*/
+static void CheckTable()
+{
+   universal_value_t l_Value;
+   static char l_szValue[] = "text";
+   l_Value.m_Array.m_stSize = sizeof(l_szValue) - 1;
+   l_Value.m_Array.m_pPtr = l_szValue;
+   g_Subscriptions.Clear();
+   g_u32Base = 0;
+
+   // Нечисловое значение отправляется при любом изменении
+   Process(0, IVT_STRING8, l_Value);
+   g_Subscriptions.Add(TEST_TAG, TEST_ADDR, 0, 0, TEST_DEADBAND);
+   bool l_bResult = Process(0, IVT_STRING8, l_Value) == 1 && Process(1, IVT_STRING8, l_Value) == 0;
+   g_Subscriptions.SetChanged(TEST_TAG);
+   Check(l_bResult && Process(1, IVT_STRING8, l_Value) == 1, "table: non numeric value");
+
+   // Изменение отмечается для всех подписчиков канала, таблица упорядочена по каналу и адресу
+   g_Subscriptions.Add(TEST_TAG + 1, TEST_ADDR, 0, 0, 0.0f);
+   g_Subscriptions.Add(TEST_TAG, TEST_ADDR - 1, 0, 0, 0.0f);
+   g_Subscriptions.Add(TEST_TAG - 1, TEST_ADDR, 0, 0, 0.0f);
+   Process(2, IVT_STRING8, l_Value);
+   l_bResult = g_Subscriptions.GetCount() == 4;
+   for(size_t i = 1; l_bResult && i < g_Subscriptions.GetCount(); i++)
+   {
+      iridium_subscription_t* l_pPrev = g_Subscriptions.Get(i - 1);
+      iridium_subscription_t* l_pNext = g_Subscriptions.Get(i);
+      l_bResult = l_pPrev->m_u32TagID < l_pNext->m_u32TagID || (l_pPrev->m_u32TagID == l_pNext->m_u32TagID && l_pPrev->m_Addr < l_pNext->m_Addr);
+   }
+   l_bResult = l_bResult && g_Subscriptions.SetChanged(TEST_TAG) && !g_Subscriptions.SetChanged(TEST_TAG + 2);
+   Check(l_bResult && Process(3, IVT_STRING8, l_Value) == 2, "table: all subscribers of tag");
+
+   // Повторная подписка изменяет параметры, удаление и заполнение таблицы
+   iridium_subscription_t* l_pSubscription = g_Subscriptions.Add(TEST_TAG, TEST_ADDR, TEST_MAX_INTERVAL, TEST_MIN_INTERVAL, 0.0f);
+   l_bResult = g_Subscriptions.GetCount() == 4 && l_pSubscription == g_Subscriptions.Find(TEST_TAG, TEST_ADDR) &&
+               l_pSubscription->m_u32MaxInterval == TEST_MAX_INTERVAL;
+   l_bResult = l_bResult && g_Subscriptions.Remove(TEST_TAG, TEST_ADDR - 1) && !g_Subscriptions.Find(TEST_TAG, TEST_ADDR - 1) &&
+               !g_Subscriptions.Remove(TEST_TAG, TEST_ADDR - 1);
+   for(u32 i = 0; g_Subscriptions.GetCount() < IRIDIUM_MAX_SUBSCRIPTIONS; i++)
+      g_Subscriptions.Add(100 + i, TEST_ADDR, 0, 0, 0.0f);
+   Check(l_bResult && !g_Subscriptions.Add(TEST_TAG, TEST_ADDR + 1, 0, 0, 0.0f) && g_Subscriptions.Add(TEST_TAG, TEST_ADDR, 0, 0, 0.0f),
+         "table: update, remove and full");
+}
+
+int main()
+{
+   CheckIntervals(1000, "intervals");
+   CheckIntervals(0xFFFFFFFF - 500, "intervals wrap");
+   CheckTable();
+   return g_iErrors ? 1 : 0;
+}
@@ -0,0 +1,450 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+//////////////////////////////////////////////////////////////////////////
+// Проверка таблицы транзакций и окна запросов ведущего
+//////////////////////////////////////////////////////////////////////////
+// Ведущий и ведомые соединены моделью шины, пакеты доставляются вызовом Deliver или теряются вызовом Drop.
+// Проверяется повтор запроса с тем же идентификатором транзакции по истечении времени ожидания, завершение
+// транзакции ответом, истечением попыток и отменой, пропуск нулевого идентификатора при переполнении счетчика
+// и вызов обработчика завершения под захватом Lock. Проверяется, что запросы сверх окна получателя ожидают
+// в очереди и отправляются по мере получения ответов, а запрос, который нельзя сохранить для отправки из
+// очереди (большой пакет или цепочка пакетов), при заполненном окне отклоняется и не передается ни одним пакетом
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CIridiumBusProtocol.h"
+
+#define TEST_MASTER           1                    // Адрес ведущего
+#define TEST_SLAVE            10                   // Адрес первого ведомого
+#define TEST_SLAVES           2                    // Количество ведомых
+#define TEST_WIRE_PACKETS     32                   // Размер очереди пакетов на шине
+#define TEST_LARGE_BLOCK      100                  // Размер блока запроса, который не сохраняется для повтора
+#define TEST_TIMEOUT          100                  // Время ожидания ответа
+#define TEST_BATCH_ITEMS      80                   // Количество операций пакетного запроса (цепочка пакетов)
+
+// Пакет на шине
+typedef struct test_packet_s
+{
+   u8                m_aData[IRIDIUM_BUS_OUT_BUFFER_SIZE + IRIDIUM_BUS_CRC_SIZE]; // Данные пакета
+   u16               m_u16Size;                    // Размер пакета
+   iridium_address_t m_SrcAddr;                    // Адрес отправителя
+} test_packet_t;
+
+// Результат завершения транзакции
+typedef struct test_result_s
+{
+   u16                        m_u16TID;            // Идентификатор транзакции
+   iridium_address_t          m_DstAddr;           // Адрес получателя
+   eIridiumTransactionState   m_eState;            // Состояние завершения
+   int                        m_iLock;             // Глубина захвата Lock при вызове обработчика
+} test_result_t;
+
+static test_packet_t g_aWire[TEST_WIRE_PACKETS];
+static size_t g_stWire = 0;
+static test_result_t g_aResults[16];
+static size_t g_stResults = 0;
+static int g_iErrors = 0;
+
+/**
+   Проверка условия
+   на входе    :  in_bCondition  - условие
+                  in_pszName     - название проверки
+   на выходе   :  *
+*/
+static void Check(bool in_bCondition, const char* in_pszName)
+{
+   printf("%-40s %s\n", in_pszName, in_bCondition ? "ok" : "FAILED");
+   if(!in_bCondition)
+      g_iErrors++;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// class CTestNode
+//////////////////////////////////////////////////////////////////////////
+// Узел шины: ведущий отправляет запросы с регистрацией транзакций, ведомый отвечает на запрос информации
+class CTestNode : public CIridiumBusProtocol
+{
+public:
+   CTestNode(iridium_address_t in_Address)
+   {
+      m_OutBuffer.SetBuffer(IRIDIUM_BUS_MAX_HEADER_SIZE, IRIDIUM_BUS_CRC_SIZE, m_aOut, sizeof(m_aOut));
+      m_OutPH.m_u8Type = IRIDIUM_BUS_PROTOCOL_ID;
+      SetAddress(in_Address);
+      m_iLock = 0;
+      m_iMaxLock = 0;
+   }
+
+   // Подсчет глубины захвата общих данных протокола
+   virtual void Lock()
+      { if(++m_iLock > m_iMaxLock) m_iMaxLock = m_iLock; }
+   virtual void Unlock()
+      { m_iLock--; }
+
+   // Отправка пакета на шину
+   virtual bool SendPacket(void* in_pBuffer, size_t in_stSize)
+   {
+      bool l_bResult = false;
+      if(g_stWire < TEST_WIRE_PACKETS)
+      {
+         test_packet_t& l_rPacket = g_aWire[g_stWire++];
+         memcpy(l_rPacket.m_aData, in_pBuffer, in_stSize);
+         l_rPacket.m_u16Size = (u16)in_stSize;
+         l_rPacket.m_SrcAddr = m_Address;
+         l_bResult = true;
+      }
+      return l_bResult;
+   }
+
+   // Разбор полученного пакета
+   void Receive(test_packet_t& in_rPacket)
+   {
+      m_InBuffer.SetBuffer(in_rPacket.m_aData, in_rPacket.m_u16Size);
+      m_InBuffer.FilterNoiseAndForeignPacket(m_Address);
+      while(m_InBuffer.OpenPacket())
+      {
+         ProcessMessage(m_InBuffer.GetPacketHeader(), m_InBuffer.GetMessagePtr(), m_InBuffer.GetMessageSize());
+         m_InBuffer.ClosePacket();
+      }
+   }
+
+   // Отправка запроса с регистрацией транзакции
+   bool Request(iridium_address_t in_DstAddr, u8 in_u8Retries, iridium_transaction_callback_t in_pCallback = NULL)
+   {
+      SetTransaction(TEST_TIMEOUT, in_u8Retries, in_pCallback, this);
+      return SendDeviceInfoRequest(in_DstAddr);
+   }
+
+   // Отправка запроса, пакет которого не помещается в IRIDIUM_TRANSACTION_PACKET_SIZE
+   bool RequestLarge(iridium_address_t in_DstAddr)
+   {
+      static u8 l_aBlock[TEST_LARGE_BLOCK];
+      SetTransaction(TEST_TIMEOUT, 0, NULL, NULL);
+      return SendStreamBlockRequest(in_DstAddr, 1, 0, sizeof(l_aBlock), l_aBlock);
+   }
+
+   // Отправка пакетного запроса цепочкой пакетов
+   bool RequestChain(iridium_address_t in_DstAddr)
+   {
+      bool l_bResult = true;
+      SetTransaction(TEST_TIMEOUT, 0, NULL, NULL);
+      BeginBatchRequest(in_DstAddr);
+      for(int i = 0; l_bResult && i < TEST_BATCH_ITEMS; i++)
+         l_bResult = AddBatchGetChannelValue(i + 1, 0);
+      return SendBatchRequest() && l_bResult;
+   }
+
+   CIridiumTransactions* GetTransactions()
+      { return &m_Transactions; }
+   void SetTID(u16 in_u16TID)
+      { m_u16TID = in_u16TID; }
+
+   // Сохранение результата завершения транзакции
+   void AddResult(iridium_transaction_t& in_rTransaction, eIridiumTransactionState in_eState)
+   {
+      test_result_t& l_rResult = g_aResults[g_stResults++ % (sizeof(g_aResults) / sizeof(g_aResults[0]))];
+      l_rResult.m_u16TID = in_rTransaction.m_u16TID;
+      l_rResult.m_DstAddr = in_rTransaction.m_DstAddr;
+      l_rResult.m_eState = in_eState;
+      l_rResult.m_iLock = m_iLock;
+   }
+
+   int               m_iLock;                      // Глубина захвата общих данных протокола
+   int               m_iMaxLock;                   // Наибольшая глубина захвата
+
+protected:
+   virtual void TransactionResult(iridium_transaction_t& in_rTransaction, eIridiumTransactionState in_eState, eIridiumError in_eError)
+      { AddResult(in_rTransaction, in_eState); }
+
+   virtual bool GetDeviceInfo(iridium_device_info_t& out_rInfo)
+   {
+      static char l_szName[] = "test";
+      out_rInfo.m_pszName = l_szName;
+      out_rInfo.m_pszProducer = l_szName;
+      out_rInfo.m_pszModel = l_szName;
+      out_rInfo.m_pszHWID = l_szName;
+      return true;
+   }
+
+private:
+   u8                m_aOut[IRIDIUM_BUS_OUT_BUFFER_SIZE]; // Буфер исходящего пакета
+};
+
+static CTestNode* g_apNodes[TEST_SLAVES + 1];
+
+/**
+   Получение количества пакетов на шине, отправленных узлом
+   на входе    :  in_Address  - адрес отправителя
+   на выходе   :  количество пакетов
+*/
+static size_t GetWireCount(iridium_address_t in_Address)
+{
+   size_t l_stResult = 0;
+   for(size_t i = 0; i < g_stWire; i++)
+      if(g_aWire[i].m_SrcAddr == in_Address)
+         l_stResult++;
+   return l_stResult;
+}
+
+/**
+   Доставка всех пакетов на шине, включая ответы, отправленные при доставке
+   на входе    :  *
+   на выходе   :  *
+*/
+static void Deliver()
+{
+   static test_packet_t l_aPackets[TEST_WIRE_PACKETS];
+   while(g_stWire)
+   {
+      size_t l_stCount = g_stWire;
+      memcpy(l_aPackets, g_aWire, l_stCount * sizeof(test_packet_t));
+      g_stWire = 0;
+      for(size_t i = 0; i < l_stCount; i++)
+      {
+         for(int j = 0; j <= TEST_SLAVES; j++)
+            if(g_apNodes[j]->GetAddress() != l_aPackets[i].m_SrcAddr)
+               g_apNodes[j]->Receive(l_aPackets[i]);
+      }
+   }
+}
+
+/**
+   Потеря всех пакетов на шине
+   на входе    :  *
+   на выходе   :  *
+*/
+static void Drop()
+{
+   g_stWire = 0;
+}
+
+/**
+   Подготовка узлов к проверке
+   на входе    :  *
+   на выходе   :  ведущий
+*/
+static CTestNode* Reset()
+{
+   for(int i = 0; i <= TEST_SLAVES; i++)
+      g_apNodes[i]->Reset();
+   g_stWire = 0;
+   g_stResults = 0;
+   return g_apNodes[0];
+}
+
+/**
+   Получение идентификатора транзакции пакета на шине
+   на входе    :  in_rPacket  - ссылка на пакет
+   на выходе   :  идентификатор транзакции
+*/
+static u16 GetTID(test_packet_t& in_rPacket)
+{
+   iridium_packet_header_t l_PH;
+   iridium_packet_t l_Packet;
+   iridium_message_header_t l_MH;
+   CIridiumInBuffer l_Message;
+   memset(&l_MH, 0, sizeof(l_MH));
+   CIridiumBusInBuffer::ParseBUSHeader(in_rPacket.m_aData, in_rPacket.m_u16Size, l_PH, l_Packet);
+   l_Message.SetBuffer(in_rPacket.m_aData + l_Packet.m_stHeader, l_Packet.m_stBody);
+   l_Message.GetMessageHeader(l_MH);
+   return l_MH.m_u16TID;
+}
+
+/**
+   Обработчик завершения, отправляющий из обработчика следующий запрос
+   на входе    :  in_pContext       - указатель на ведущего
+                  in_rTransaction   - ссылка на данные транзакции
+                  in_eState         - состояние завершения
+                  in_eError         - код ошибки
+   на выходе   :  *
+*/
+static void SendNext(void* in_pContext, iridium_transaction_t& in_rTransaction, eIridiumTransactionState in_eState, eIridiumError in_eError)
+{
+   CTestNode* l_pMaster = (CTestNode*)in_pContext;
+   l_pMaster->AddResult(in_rTransaction, in_eState);
+   l_pMaster->Request(in_rTransaction.m_DstAddr, 0);
+}
+
+/**
+   Проверка повтора и завершения транзакций
+   на входе    :  *
+   на выходе   :  *
+*/
+static void CheckRetry()
+{
+   CTestNode* l_pMaster = Reset();
+   u32 l_u32Time = 1000;
+   l_pMaster->ProcessTransactions(l_u32Time);
+
+   // Запрос повторяется по истечении времени ожидания с тем же идентификатором транзакции
+   l_pMaster->Request(TEST_SLAVE, 2);
+   test_packet_t l_Request = g_aWire[0];
+   Drop();
+   l_pMaster->ProcessTransactions(l_u32Time + TEST_TIMEOUT - 1);
+   bool l_bEarly = !g_stWire;
+   l_pMaster->ProcessTransactions(l_u32Time + TEST_TIMEOUT);
+   bool l_bRetry = g_stWire == 1 && g_aWire[0].m_u16Size == l_Request.m_u16Size && !memcmp(g_aWire[0].m_aData, l_Request.m_aData, l_Request.m_u16Size);
+   Drop();
+   Check(l_bEarly && l_bRetry, "retry: same packet after timeout");
+
+   // Попытки исчерпаны, транзакция завершается по истечении времени ожидания
+   l_pMaster->ProcessTransactions(l_u32Time + 2 * TEST_TIMEOUT);
+   l_bRetry = g_stWire == 1;
+   Drop();
+   l_pMaster->ProcessTransactions(l_u32Time + 3 * TEST_TIMEOUT);
+   Check(l_bRetry && !g_stWire && g_stResults == 1 && g_aResults[0].m_eState == IRIDIUM_TRANSACTION_TIMEOUT &&
+         g_aResults[0].m_u16TID == GetTID(l_Request) && !l_pMaster->GetTransactions()->GetCount(), "retry: timeout after retries");
+
+   // Ответ на повторный запрос завершает транзакцию, повторный ответ игнорируется
+   l_u32Time += 4 * TEST_TIMEOUT;
+   g_stResults = 0;
+   l_pMaster->Request(TEST_SLAVE, 2);
+   Drop();
+   l_pMaster->ProcessTransactions(l_u32Time + TEST_TIMEOUT);
+   l_Request = g_aWire[0];
+   Drop();
+   g_apNodes[1]->Receive(l_Request);
+   test_packet_t l_Response = g_aWire[0];
+   Drop();
+   l_pMaster->Receive(l_Response);
+   l_pMaster->Receive(l_Response);
+   l_pMaster->ProcessTransactions(l_u32Time + 4 * TEST_TIMEOUT);
+   Check(g_stResults == 1 && g_aResults[0].m_eState == IRIDIUM_TRANSACTION_DONE && g_aResults[0].m_DstAddr == TEST_SLAVE &&
+         !g_stWire && !l_pMaster->GetTransactions()->GetCount(), "retry: response completes once");
+
+   // Отмена транзакций получателя, транзакции других получателей остаются
+   g_stResults = 0;
+   l_pMaster->Request(TEST_SLAVE, 2);
+   l_pMaster->Request(TEST_SLAVE + 1, 2);
+   Drop();
+   l_pMaster->CancelTransactions(TEST_SLAVE);
+   Check(g_stResults == 1 && g_aResults[0].m_eState == IRIDIUM_TRANSACTION_CANCEL && l_pMaster->GetTransactions()->GetCount() == 1,
+         "retry: cancel");
+   l_pMaster->CancelTransactions(TEST_SLAVE + 1);
+   Check(!l_pMaster->m_iLock, "retry: lock released");
+}
+
+/**
+   Проверка переполнения идентификатора транзакции и обработчика завершения
+   на входе    :  *
+   на выходе   :  *
+*/
+static void CheckTID()
+{
+   CTestNode* l_pMaster = Reset();
+
+   // После 0xFFFF следует 1, нулевой идентификатор означает отсутствие транзакции
+   l_pMaster->SetTID(0xFFFE);
+   l_pMaster->Request(TEST_SLAVE, 0);
+   l_pMaster->Request(TEST_SLAVE + 1, 0);
+   bool l_bWrap = g_stWire == 2 && GetTID(g_aWire[0]) == 0xFFFF && GetTID(g_aWire[1]) == 1 &&
+                  l_pMaster->GetTransactions()->Find(TEST_SLAVE, 0xFFFF) && l_pMaster->GetTransactions()->Find(TEST_SLAVE + 1, 1);
+   Deliver();
+   Check(l_bWrap && g_stResults == 2 && g_aResults[0].m_u16TID == 0xFFFF && g_aResults[1].m_u16TID == 1, "tid: wrap skips 0");
+
+   // Обработчик вызывается под захватом Lock, отправка нового запроса из обработчика захватывает его повторно
+   l_pMaster = Reset();
+   l_pMaster->Request(TEST_SLAVE, 0, SendNext);
+   l_pMaster->m_iMaxLock = 0;
+   Deliver();
+   Check(g_stResults == 2 && g_aResults[0].m_iLock > 0 && l_pMaster->m_iMaxLock > 1 && g_aResults[1].m_eState == IRIDIUM_TRANSACTION_DONE &&
+         !l_pMaster->GetTransactions()->GetCount() && !l_pMaster->m_iLock, "tid: callback under recursive lock");
+}
+
+/**
+   Проверка окна запросов получателя
+   на входе    :  *
+   на выходе   :  *
+*/
+static void CheckWindow()
+{
+   CTestNode* l_pMaster = Reset();
+   l_pMaster->SetTransactionWindow(TEST_SLAVE, 2, 0);
+
+   // Два запроса отправляются сразу, третий ожидает в очереди
+   bool l_bSent = l_pMaster->Request(TEST_SLAVE, 0) && l_pMaster->Request(TEST_SLAVE, 0) && l_pMaster->Request(TEST_SLAVE, 0);
+   Check(l_bSent && GetWireCount(TEST_MASTER) == 2 && l_pMaster->GetTransactions()->GetCount() == 3, "window: third request queued");
+
+   // Окно другого получателя не зависит от заполненного окна
+   Check(l_pMaster->Request(TEST_SLAVE + 1, 0) && GetWireCount(TEST_MASTER) == 3, "window: other destination not blocked");
+
+   // Запрос, который нельзя сохранить, при заполненном окне не отправляется
+   Check(!l_pMaster->RequestLarge(TEST_SLAVE) && GetWireCount(TEST_MASTER) == 3 && l_pMaster->GetTransactions()->GetCount() == 4,
+         "window: large request rejected when full");
+
+   // Цепочка пакетов при заполненном окне отклоняется целиком, ни один пакет не передается
+   Check(!l_pMaster->RequestChain(TEST_SLAVE) && GetWireCount(TEST_MASTER) == 3 && l_pMaster->GetTransactions()->GetCount() == 4,
+         "window: chain rejected when full");
+
+   // Ответы освобождают окно, ожидающий запрос отправляется
+   Deliver();
+   Check(g_stResults == 4 && !l_pMaster->GetTransactions()->GetCount(), "window: queued request sent on response");
+
+   // При свободном окне запрос, который нельзя сохранить, отправляется
+   Check(l_pMaster->RequestLarge(TEST_SLAVE) && GetWireCount(TEST_MASTER) == 1, "window: large request sent when open");
+   Drop();
+   l_pMaster->CancelTransactions(TEST_SLAVE);
+   Check(l_pMaster->RequestChain(TEST_SLAVE) && GetWireCount(TEST_MASTER) > 1 && l_pMaster->GetTransactions()->GetCount() == 1,
+         "window: chain sent when open");
+   Drop();
+
+   // Ограничение суммарного размера запросов: в 24 байта помещаются два пакета запроса информации
+   l_pMaster = Reset();
+   l_pMaster->SetTransactionWindow(TEST_SLAVE, 4, 24);
+   l_bSent = l_pMaster->Request(TEST_SLAVE, 0) && l_pMaster->Request(TEST_SLAVE, 0) && l_pMaster->Request(TEST_SLAVE, 0);
+   Check(l_bSent && GetWireCount(TEST_MASTER) == 2, "window: byte limit");
+   Deliver();
+   Check(g_stResults == 3, "window: byte limit drained");
+
+   // Общее ограничение отправленных запросов для всех получателей
+   l_pMaster = Reset();
+   l_pMaster->SetTransactionLimit(1);
+   l_bSent = l_pMaster->Request(TEST_SLAVE, 0) && l_pMaster->Request(TEST_SLAVE + 1, 0);
+   Check(l_bSent && GetWireCount(TEST_MASTER) == 1, "window: global limit");
+   Deliver();
+   Check(g_stResults == 2, "window: global limit drained");
+   l_pMaster->SetTransactionLimit(IRIDIUM_MAX_TRANSACTIONS);
+
+   // Окно без заданных параметров начинается с одного запроса, растет с ответами и сбрасывается при потере
+   l_pMaster = Reset();
+   l_pMaster->SetTransactionWindow(TEST_SLAVE, 0, 0);
+   for(int i = 0; i < 3; i++)
+      l_pMaster->Request(TEST_SLAVE, 0);
+   size_t l_stFirst = GetWireCount(TEST_MASTER);
+   Deliver();
+   for(int i = 0; i < 3; i++)
+      l_pMaster->Request(TEST_SLAVE, 0);
+   size_t l_stGrown = GetWireCount(TEST_MASTER);
+   Drop();
+   l_pMaster->ProcessTransactions(TEST_TIMEOUT);
+   l_pMaster->Request(TEST_SLAVE, 0);
+   l_pMaster->Request(TEST_SLAVE, 0);
+   Check(l_stFirst == 1 && l_stGrown == 3 && GetWireCount(TEST_MASTER) == 1, "window: learned window");
+   Drop();
+}
+
+int main()
+{
+   for(int i = 0; i <= TEST_SLAVES; i++)
+      g_apNodes[i] = new CTestNode((iridium_address_t)(i ? TEST_SLAVE + i - 1 : TEST_MASTER));
+
+   CheckRetry();
+   CheckTID();
+   CheckWindow();
+
+   for(int i = 0; i <= TEST_SLAVES; i++)
+      delete g_apNodes[i];
+   return g_iErrors ? 1 : 0;
+}
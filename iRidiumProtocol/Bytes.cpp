@@ -16,6 +16,9 @@
 #include "Bytes.h"
 #include "IridiumValue.h"
 
+// Побайтовая реализация, используется если платформа не поддерживает чтение/запись значений словом (см. Bytes.h)
+#if !defined(IRIDIUM_BYTES_INLINE)
+
 /**
    Запись беззнакового 8 битного значения в буфер
    на входе    :  in_pBuffer  - указатель на буфер
@@ -812,6 +815,8 @@ u8* ReadSTLE(u8* in_pBuffer, size_t& out_rValue)
    return in_pBuffer + sizeof(size_t);
 }
 
+#endif   // !defined(IRIDIUM_BYTES_INLINE)
+
 /*
 bool BytesUnitTest()
 {
@@ -18,6 +18,139 @@
 
 #include "IridiumTypes.h"
 
+// Определение возможности чтения/записи значений целым словом:
+// на платформах с LE последовательностью байт (x86/x64, Cortex-M) значение копируется через memcpy, который
+// компилятор заменяет одной командой чтения/записи (Cortex-M3/M4 поддерживают невыровненный доступ), а для BE
+// последовательности байты переставляются встроенными функциями компилятора. Для AVR используется побайтовая реализация
+#if !defined(IRIDIUM_AVR_PLATFORM)
+   #if defined(IRIDIUM_WINDOWS_PLATFORM) || (defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)) || (defined(__ARMCC_VERSION) && !defined(__BIG_ENDIAN))
+      #define IRIDIUM_BYTES_INLINE
+   #endif
+#endif
+
+#if defined(IRIDIUM_BYTES_INLINE)
+
+#include <string.h>
+
+// Перестановка байт
+#if defined(_MSC_VER)
+   #include <stdlib.h>
+   #define IRIDIUM_BSWAP16(x)    _byteswap_ushort(x)
+   #define IRIDIUM_BSWAP32(x)    _byteswap_ulong(x)
+   #define IRIDIUM_BSWAP64(x)    _byteswap_uint64(x)
+#elif defined(__ARMCC_VERSION) && (__ARMCC_VERSION < 6000000)
+   #define IRIDIUM_BSWAP16(x)    ((u16)(__rev(x) >> 16))
+   #define IRIDIUM_BSWAP32(x)    ((u32)__rev(x))
+   #define IRIDIUM_BSWAP64(x)    ((u64)__rev((u32)(x)) << 32 | __rev((u32)((x) >> 32)))
+#elif defined(__GNUC__) || defined(__clang__)
+   #define IRIDIUM_BSWAP16(x)    __builtin_bswap16(x)
+   #define IRIDIUM_BSWAP32(x)    __builtin_bswap32(x)
+   #define IRIDIUM_BSWAP64(x)    __builtin_bswap64(x)
+#else
+   #define IRIDIUM_BSWAP16(x)    ((u16)((x) << 8 | (x) >> 8))
+   #define IRIDIUM_BSWAP32(x)    ((u32)(x) << 24 | ((u32)(x) & 0xFF00) << 8 | ((u32)(x) >> 8 & 0xFF00) | (u32)(x) >> 24)
+   #define IRIDIUM_BSWAP64(x)    ((u64)IRIDIUM_BSWAP32((u32)(x)) << 32 | IRIDIUM_BSWAP32((u32)((x) >> 32)))
+#endif
+
+// Запись значений в буфер
+inline u8* WriteU8(u8* in_pBuffer, u8 in_u8Value)
+   { in_pBuffer[0] = in_u8Value; return in_pBuffer + 1; }
+inline u8* WriteS8(u8* in_pBuffer, s8 in_s8Value)
+   { in_pBuffer[0] = in_s8Value; return in_pBuffer + 1; }
+inline u8* WriteU16LE(u8* in_pBuffer, u16 in_u16Value)
+   { memcpy(in_pBuffer, &in_u16Value, 2); return in_pBuffer + 2; }
+inline u8* WriteU16BE(u8* in_pBuffer, u16 in_u16Value)
+   { return WriteU16LE(in_pBuffer, IRIDIUM_BSWAP16(in_u16Value)); }
+inline u8* WriteS16LE(u8* in_pBuffer, s16 in_s16Value)
+   { return WriteU16LE(in_pBuffer, (u16)in_s16Value); }
+inline u8* WriteS16BE(u8* in_pBuffer, s16 in_s16Value)
+   { return WriteU16BE(in_pBuffer, (u16)in_s16Value); }
+inline u8* WriteU32LE(u8* in_pBuffer, u32 in_u32Value)
+   { memcpy(in_pBuffer, &in_u32Value, 4); return in_pBuffer + 4; }
+inline u8* WriteU32BE(u8* in_pBuffer, u32 in_u32Value)
+   { return WriteU32LE(in_pBuffer, IRIDIUM_BSWAP32(in_u32Value)); }
+inline u8* WriteS32LE(u8* in_pBuffer, s32 in_s32Value)
+   { return WriteU32LE(in_pBuffer, (u32)in_s32Value); }
+inline u8* WriteS32BE(u8* in_pBuffer, s32 in_s32Value)
+   { return WriteU32BE(in_pBuffer, (u32)in_s32Value); }
+inline u8* WriteF32LE(u8* in_pBuffer, f32 in_f32Value)
+   { memcpy(in_pBuffer, &in_f32Value, 4); return in_pBuffer + 4; }
+inline u8* WriteF32BE(u8* in_pBuffer, f32 in_f32Value)
+   { u32 l_u32Value; memcpy(&l_u32Value, &in_f32Value, 4); return WriteU32BE(in_pBuffer, l_u32Value); }
+inline u8* WriteU64LE(u8* in_pBuffer, u64 in_u64Value)
+   { memcpy(in_pBuffer, &in_u64Value, 8); return in_pBuffer + 8; }
+inline u8* WriteU64BE(u8* in_pBuffer, u64 in_u64Value)
+   { return WriteU64LE(in_pBuffer, IRIDIUM_BSWAP64(in_u64Value)); }
+inline u8* WriteS64LE(u8* in_pBuffer, s64 in_s64Value)
+   { return WriteU64LE(in_pBuffer, (u64)in_s64Value); }
+inline u8* WriteS64BE(u8* in_pBuffer, s64 in_s64Value)
+   { return WriteU64BE(in_pBuffer, (u64)in_s64Value); }
+inline u8* WriteF64LE(u8* in_pBuffer, f64 in_f64Value)
+   { memcpy(in_pBuffer, &in_f64Value, 8); return in_pBuffer + 8; }
+inline u8* WriteF64BE(u8* in_pBuffer, f64 in_f64Value)
+   { u64 l_u64Value; memcpy(&l_u64Value, &in_f64Value, 8); return WriteU64BE(in_pBuffer, l_u64Value); }
+inline u8* WriteSTBE(u8* in_pBuffer, size_t in_stValue)
+   { return (sizeof(size_t) == sizeof(u64)) ? WriteU64BE(in_pBuffer, (u64)in_stValue) : WriteU32BE(in_pBuffer, (u32)in_stValue); }
+inline u8* WriteSTLE(u8* in_pBuffer, size_t in_stValue)
+   { memcpy(in_pBuffer, &in_stValue, sizeof(size_t)); return in_pBuffer + sizeof(size_t); }
+
+// Чтение значений из буфера
+inline u8* ReadU8(u8* in_pBuffer, u8& out_rValue)
+   { out_rValue = in_pBuffer[0]; return in_pBuffer + 1; }
+inline u8* ReadS8(u8* in_pBuffer, s8& out_rValue)
+   { out_rValue = in_pBuffer[0]; return in_pBuffer + 1; }
+inline u8* ReadU16LE(u8* in_pBuffer, u16& out_rValue)
+   { memcpy(&out_rValue, in_pBuffer, 2); return in_pBuffer + 2; }
+inline u8* ReadU16BE(u8* in_pBuffer, u16& out_rValue)
+   { u16 l_u16Value; memcpy(&l_u16Value, in_pBuffer, 2); out_rValue = IRIDIUM_BSWAP16(l_u16Value); return in_pBuffer + 2; }
+inline u8* ReadS16LE(u8* in_pBuffer, s16& out_rValue)
+   { memcpy(&out_rValue, in_pBuffer, 2); return in_pBuffer + 2; }
+inline u8* ReadS16BE(u8* in_pBuffer, s16& out_rValue)
+   { u16 l_u16Value; u8* l_pPtr = ReadU16BE(in_pBuffer, l_u16Value); out_rValue = (s16)l_u16Value; return l_pPtr; }
+inline u8* ReadU32LE(u8* in_pBuffer, u32& out_rValue)
+   { memcpy(&out_rValue, in_pBuffer, 4); return in_pBuffer + 4; }
+inline u8* ReadU32BE(u8* in_pBuffer, u32& out_rValue)
+   { u32 l_u32Value; memcpy(&l_u32Value, in_pBuffer, 4); out_rValue = IRIDIUM_BSWAP32(l_u32Value); return in_pBuffer + 4; }
+inline u8* ReadS32LE(u8* in_pBuffer, s32& out_rValue)
+   { memcpy(&out_rValue, in_pBuffer, 4); return in_pBuffer + 4; }
+inline u8* ReadS32BE(u8* in_pBuffer, s32& out_rValue)
+   { u32 l_u32Value; u8* l_pPtr = ReadU32BE(in_pBuffer, l_u32Value); out_rValue = (s32)l_u32Value; return l_pPtr; }
+inline u8* ReadF32LE(u8* in_pBuffer, f32& out_rValue)
+   { memcpy(&out_rValue, in_pBuffer, 4); return in_pBuffer + 4; }
+inline u8* ReadF32BE(u8* in_pBuffer, f32& out_rValue)
+   { u32 l_u32Value; u8* l_pPtr = ReadU32BE(in_pBuffer, l_u32Value); memcpy(&out_rValue, &l_u32Value, 4); return l_pPtr; }
+inline u8* ReadU64LE(u8* in_pBuffer, u64& out_rValue)
+   { memcpy(&out_rValue, in_pBuffer, 8); return in_pBuffer + 8; }
+inline u8* ReadU64BE(u8* in_pBuffer, u64& out_rValue)
+   { u64 l_u64Value; memcpy(&l_u64Value, in_pBuffer, 8); out_rValue = IRIDIUM_BSWAP64(l_u64Value); return in_pBuffer + 8; }
+inline u8* ReadS64LE(u8* in_pBuffer, s64& out_rValue)
+   { memcpy(&out_rValue, in_pBuffer, 8); return in_pBuffer + 8; }
+inline u8* ReadS64BE(u8* in_pBuffer, s64& out_rValue)
+   { u64 l_u64Value; u8* l_pPtr = ReadU64BE(in_pBuffer, l_u64Value); out_rValue = (s64)l_u64Value; return l_pPtr; }
+inline u8* ReadF64LE(u8* in_pBuffer, f64& out_rValue)
+   { memcpy(&out_rValue, in_pBuffer, 8); return in_pBuffer + 8; }
+inline u8* ReadF64BE(u8* in_pBuffer, f64& out_rValue)
+   { u64 l_u64Value; u8* l_pPtr = ReadU64BE(in_pBuffer, l_u64Value); memcpy(&out_rValue, &l_u64Value, 8); return l_pPtr; }
+inline u8* ReadSTBE(u8* in_pBuffer, size_t& out_rValue)
+{
+   if(sizeof(size_t) == sizeof(u64))
+   {
+      u64 l_u64Value;
+      ReadU64BE(in_pBuffer, l_u64Value);
+      out_rValue = (size_t)l_u64Value;
+   } else
+   {
+      u32 l_u32Value;
+      ReadU32BE(in_pBuffer, l_u32Value);
+      out_rValue = (size_t)l_u32Value;
+   }
+   return in_pBuffer + sizeof(size_t);
+}
+inline u8* ReadSTLE(u8* in_pBuffer, size_t& out_rValue)
+   { memcpy(&out_rValue, in_pBuffer, sizeof(size_t)); return in_pBuffer + sizeof(size_t); }
+
+#else    // defined(IRIDIUM_BYTES_INLINE)
+
 // Запись значений в буфер
 u8* WriteU8(u8* in_pBuffer, u8 in_u8Value);        // Запись беззнакового 8 битного значения
 u8* WriteS8(u8* in_pBuffer, s8 in_s8Value);        // Запись знакового 8 битного значения
@@ -62,6 +195,8 @@ u8* ReadF64BE(u8* in_pBuffer, f64& out_rValue);    // Чтение 64 битно
 u8* ReadSTBE(u8* in_pBuffer, size_t& out_rValue);  // Чтение значения в зависимости от битности системы, в BE последовательности байт
 u8* ReadSTLE(u8* in_pBuffer, size_t& out_rValue);  // Чтение значения в зависимости от битности системы, в LE последовательности байт
 
+#endif   // defined(IRIDIUM_BYTES_INLINE)
+
 //bool BytesUnitTest();
 
 #endif // _BYTE_SWAP_H_INCLUDED_
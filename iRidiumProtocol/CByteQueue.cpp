@@ -0,0 +1,245 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+#include <string.h>
+#include "CByteQueue.h"
+
+/**
+   Конструктор класса
+   на входе    :  *
+*/
+CByteQueue::CByteQueue()
+{
+   m_pBuffer = NULL;
+   m_Size = 0;
+   m_Write = 0;
+   m_Read = 0;
+   m_stLost = 0;
+}
+
+/**
+   Деструктор класса
+*/
+CByteQueue::~CByteQueue()
+{
+}
+
+/**
+   Установка внешнего буфера
+   на входе    :  in_pBuffer  - указатель на буфер
+                  in_stSize   - размер буфера
+   на выходе   :  *
+   примечание  :  очередь вмещает на один байт меньше размера буфера, на AVR размер ограничен 255 байтами
+*/
+void CByteQueue::SetBuffer(void* in_pBuffer, size_t in_stSize)
+{
+   iridium_queue_index_t l_Max = (iridium_queue_index_t)-1;
+   if(in_stSize > l_Max)
+      in_stSize = l_Max;
+
+   m_pBuffer = (u8*)in_pBuffer;
+   m_Size = (iridium_queue_index_t)in_stSize;
+   Clear();
+}
+
+/**
+   Очистка очереди
+   на входе    :  *
+   на выходе   :  *
+*/
+void CByteQueue::Clear()
+{
+   m_Write = 0;
+   m_Read = 0;
+   m_stLost = 0;
+}
+
+/**
+   Добавление байта в очередь
+   на входе    :  in_u8Byte   - значение для добавления
+   на выходе   :  true  - значение было добавлено
+                  false - очередь переполнена, значение потеряно
+*/
+bool CByteQueue::Push(u8 in_u8Byte)
+{
+   bool l_bResult = false;
+   iridium_queue_index_t l_Write = Load(m_Write);
+   iridium_queue_index_t l_Next = l_Write + 1;
+   if(l_Next >= m_Size)
+      l_Next = 0;
+
+   // Проверка наличия места, индекс чтения должен быть прочитан до записи данных
+   if(m_Size && l_Next != LoadAcquire(m_Read))
+   {
+      m_pBuffer[l_Write] = in_u8Byte;
+      // Публикация данных, запись индекса после записи данных
+      StoreRelease(m_Write, l_Next);
+      l_bResult = true;
+   } else
+      m_stLost++;
+
+   return l_bResult;
+}
+
+/**
+   Добавление блока данных в очередь
+   на входе    :  in_pBuffer  - указатель на данные
+                  in_stSize   - размер данных
+   на выходе   :  true  - данные добавлены целиком
+                  false - в очереди недостаточно места, данные потеряны
+   примечание  :  читатель видит блок только целиком, что позволяет передавать через очередь структуры (CAN фреймы)
+*/
+bool CByteQueue::Push(const void* in_pBuffer, size_t in_stSize)
+{
+   bool l_bResult = false;
+   const u8* l_pData = (const u8*)in_pBuffer;
+   iridium_queue_index_t l_Write = Load(m_Write);
+   iridium_queue_index_t l_Read = LoadAcquire(m_Read);
+
+   // Вычисление свободного места
+   size_t l_stFree = (l_Read > l_Write) ? (l_Read - l_Write - 1) : (m_Size - l_Write + l_Read - 1);
+   if(m_Size && in_stSize <= l_stFree)
+   {
+      // Копирование данных с переходом через конец буфера
+      size_t l_stPart = m_Size - l_Write;
+      if(l_stPart > in_stSize)
+         l_stPart = in_stSize;
+      memcpy(m_pBuffer + l_Write, l_pData, l_stPart);
+      memcpy(m_pBuffer, l_pData + l_stPart, in_stSize - l_stPart);
+
+      l_Write = (iridium_queue_index_t)((l_Write + in_stSize) % m_Size);
+      // Публикация данных
+      StoreRelease(m_Write, l_Write);
+      l_bResult = true;
+   } else
+      m_stLost += in_stSize;
+
+   return l_bResult;
+}
+
+/**
+   Получение размера данных в очереди
+   на входе    :  *
+   на выходе   :  количество байт доступных для чтения
+*/
+size_t CByteQueue::Size() const
+{
+   iridium_queue_index_t l_Write = LoadAcquire(m_Write);
+   iridium_queue_index_t l_Read = Load(m_Read);
+   return (l_Write >= l_Read) ? (l_Write - l_Read) : (m_Size - l_Read + l_Write);
+}
+
+/**
+   Получение непрерывного фрагмента данных из очереди без удаления
+   на входе    :  out_rPtr - ссылка на указатель куда нужно поместить указатель на данные
+   на выходе   :  размер непрерывного фрагмента, 0 - очередь пуста
+   примечание  :  после обработки данных нужно вызвать Release
+*/
+size_t CByteQueue::Peek(u8*& out_rPtr) const
+{
+   iridium_queue_index_t l_Write = LoadAcquire(m_Write);
+   iridium_queue_index_t l_Read = Load(m_Read);
+
+   out_rPtr = m_pBuffer + l_Read;
+   return (l_Write >= l_Read) ? (l_Write - l_Read) : (m_Size - l_Read);
+}
+
+/**
+   Удаление данных из очереди
+   на входе    :  in_stSize   - количество удаляемых байт
+   на выходе   :  *
+*/
+void CByteQueue::Release(size_t in_stSize)
+{
+   size_t l_stSize = Size();
+   if(in_stSize > l_stSize)
+      in_stSize = l_stSize;
+
+   // Освобождение места, запись индекса после чтения данных
+   StoreRelease(m_Read, (iridium_queue_index_t)((Load(m_Read) + in_stSize) % m_Size));
+}
+
+/**
+   Извлечение данных из очереди
+   на входе    :  out_pBuffer - указатель на буфер куда нужно поместить данные
+                  in_stSize   - размер буфера
+   на выходе   :  количество извлеченных байт
+*/
+size_t CByteQueue::Pop(void* out_pBuffer, size_t in_stSize)
+{
+   size_t l_stResult = 0;
+   size_t l_stPart = 0;
+   u8* l_pPtr = NULL;
+   u8* l_pOut = (u8*)out_pBuffer;
+
+   // Копирование не более двух непрерывных фрагментов
+   while(l_stResult < in_stSize && 0 != (l_stPart = Peek(l_pPtr)))
+   {
+      if(l_stPart > (in_stSize - l_stResult))
+         l_stPart = in_stSize - l_stResult;
+      memcpy(l_pOut + l_stResult, l_pPtr, l_stPart);
+      Release(l_stPart);
+      l_stResult += l_stPart;
+   }
+   return l_stResult;
+}
+
+/**
+   Чтение собственного индекса
+   на входе    :  in_rIndex   - ссылка на индекс
+   на выходе   :  значение индекса
+*/
+iridium_queue_index_t CByteQueue::Load(const iridium_queue_atomic_t& in_rIndex)
+{
+#if defined(IRIDIUM_CORTEX_M_PLATFORM) || defined(IRIDIUM_AVR_PLATFORM)
+   return in_rIndex;
+#else
+   return in_rIndex.load(std::memory_order_relaxed);
+#endif
+}
+
+/**
+   Чтение индекса другой стороны
+   на входе    :  in_rIndex   - ссылка на индекс
+   на выходе   :  значение индекса
+   примечание  :  данные опубликованные до записи индекса гарантированно видны после его чтения
+*/
+iridium_queue_index_t CByteQueue::LoadAcquire(const iridium_queue_atomic_t& in_rIndex)
+{
+#if defined(IRIDIUM_CORTEX_M_PLATFORM) || defined(IRIDIUM_AVR_PLATFORM)
+   iridium_queue_index_t l_Result = in_rIndex;
+   IRIDIUM_MEMORY_BARRIER();
+   return l_Result;
+#else
+   return in_rIndex.load(std::memory_order_acquire);
+#endif
+}
+
+/**
+   Запись собственного индекса
+   на входе    :  out_rIndex  - ссылка на индекс
+                  in_Value    - новое значение индекса
+   на выходе   :  *
+   примечание  :  все операции с данными завершаются до записи индекса
+*/
+void CByteQueue::StoreRelease(iridium_queue_atomic_t& out_rIndex, iridium_queue_index_t in_Value)
+{
+#if defined(IRIDIUM_CORTEX_M_PLATFORM) || defined(IRIDIUM_AVR_PLATFORM)
+   IRIDIUM_MEMORY_BARRIER();
+   out_rIndex = in_Value;
+#else
+   out_rIndex.store(in_Value, std::memory_order_release);
+#endif
+}
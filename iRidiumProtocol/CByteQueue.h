@@ -0,0 +1,89 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+#ifndef _C_BYTE_QUEUE_H_INCLUDED_
+#define _C_BYTE_QUEUE_H_INCLUDED_
+
+// Включения
+#include "IridiumConfig.h"
+#include "IridiumTypes.h"
+
+// Тип индекса очереди, запись индекса должна выполняться одной командой процессора
+#if defined(IRIDIUM_AVR_PLATFORM)
+typedef u8 iridium_queue_index_t;                  // На AVR атомарна только запись 8 битного значения
+#else
+typedef size_t iridium_queue_index_t;
+#endif
+
+// Хранение индексов очереди
+#if defined(IRIDIUM_CORTEX_M_PLATFORM) || defined(IRIDIUM_AVR_PLATFORM)
+   // Микроконтроллеры: обычные чтение/запись и барьер памяти
+   typedef volatile iridium_queue_index_t iridium_queue_atomic_t;
+
+   #if defined(IRIDIUM_AVR_PLATFORM)
+      #define IRIDIUM_MEMORY_BARRIER()    __asm__ __volatile__("" ::: "memory")
+   #elif defined(__CC_ARM)
+      #define IRIDIUM_MEMORY_BARRIER()    __dmb(0xF)
+   #else
+      #define IRIDIUM_MEMORY_BARRIER()    __asm volatile("dmb 0xF" ::: "memory")
+   #endif
+#else
+   // Хосты: атомарные операции стандартной библиотеки
+   #include <atomic>
+   typedef std::atomic<iridium_queue_index_t> iridium_queue_atomic_t;
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+// class CByteQueue
+//////////////////////////////////////////////////////////////////////////
+// Очередь байт без блокировок для одного писателя и одного читателя. Писатель (обычно обработчик
+// прерывания UART/CAN) изменяет только индекс записи, читатель (основной цикл протокола) только
+// индекс чтения, поэтому запрещать прерывания на время работы с очередью не требуется
+class CByteQueue
+{
+public:
+   // Конструктор/деструктор
+   CByteQueue();
+   ~CByteQueue();
+
+   // Установка внешнего буфера и очистка (вызывается когда писатель и читатель не работают с очередью)
+   void SetBuffer(void* in_pBuffer, size_t in_stSize);
+   void Clear();
+
+   // Методы писателя
+   bool Push(u8 in_u8Byte);                        // Добавление одного байта
+   bool Push(const void* in_pBuffer, size_t in_stSize); // Добавление блока данных целиком
+   size_t GetLost() const                          // Количество потерянных из-за переполнения байт
+      { return m_stLost; }
+
+   // Методы читателя
+   size_t Size() const;                            // Получение размера данных в очереди
+   size_t Peek(u8*& out_rPtr) const;               // Получение непрерывного фрагмента данных
+   void Release(size_t in_stSize);                 // Удаление данных из очереди
+   size_t Pop(void* out_pBuffer, size_t in_stSize);// Извлечение данных из очереди
+
+private:
+   // Чтение/запись индексов
+   static iridium_queue_index_t Load(const iridium_queue_atomic_t& in_rIndex);
+   static iridium_queue_index_t LoadAcquire(const iridium_queue_atomic_t& in_rIndex);
+   static void StoreRelease(iridium_queue_atomic_t& out_rIndex, iridium_queue_index_t in_Value);
+
+   u8*                     m_pBuffer;              // Буфер с данными
+   iridium_queue_index_t   m_Size;                 // Размер буфера
+   iridium_queue_atomic_t  m_Write;                // Индекс записи (изменяется только писателем)
+   iridium_queue_atomic_t  m_Read;                 // Индекс чтения (изменяется только читателем)
+   volatile size_t         m_stLost;               // Количество потерянных байт (изменяется только писателем)
+};
+#endif   // _C_BYTE_QUEUE_H_INCLUDED_
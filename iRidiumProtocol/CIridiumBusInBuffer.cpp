@@ -21,6 +21,25 @@
 #include "Bytes.h"
 #include "IridiumCRC16.h"
 
+// Векторный поиск маркера начала пакета используется только на хостах, на микроконтроллерах поиск скалярный
+#if !defined(IRIDIUM_AVR_PLATFORM) && !defined(IRIDIUM_CORTEX_M_PLATFORM)
+   #if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+      #define IRIDIUM_BUS_MARKER_SSE2
+      #include <emmintrin.h>
+      #if defined(_MSC_VER)
+         #include <intrin.h>
+      #endif
+      // AVX2 выбирается во время выполнения, если процессор его поддерживает
+      #if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+         #define IRIDIUM_BUS_MARKER_AVX2
+         #include <immintrin.h>
+      #endif
+   #elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+      #define IRIDIUM_BUS_MARKER_NEON
+      #include <arm_neon.h>
+   #endif
+#endif
+
 /**
    Конструктор класса
    на входе    :  *
@@ -31,6 +50,10 @@ CIridiumBusInBuffer::CIridiumBusInBuffer() : CIridiumInBuffer()
    m_stFiltered = 0;
    m_pLock = NULL;
    m_pUnLock = NULL;
+   ResetScan();
+#if defined(IRIDIUM_ENABLE_STREAM_CRC16)
+   ResetStream();
+#endif
 }
 
 /**
@@ -54,6 +77,29 @@ void CIridiumBusInBuffer::SetBuffer(const void* in_pBuffer, size_t in_stSize)
    // Сброс собственных переменных
    m_stCount = 0;
    m_stFiltered = 0;
+   ResetScan();
+#if defined(IRIDIUM_ENABLE_STREAM_CRC16)
+   ResetStream();
+#endif
+}
+
+/**
+   Очистка буфера
+   на входе    :  *
+   на выходе   :  *
+*/
+void CIridiumBusInBuffer::Clear()
+{
+   // Вызов родителя
+   CIridiumInBuffer::Clear();
+
+   // Сброс собственных переменных
+   m_stCount = 0;
+   m_stFiltered = 0;
+   ResetScan();
+#if defined(IRIDIUM_ENABLE_STREAM_CRC16)
+   ResetStream();
+#endif
 }
 
 /**
@@ -72,8 +118,16 @@ s8 CIridiumBusInBuffer::OpenPacket()
    // Проверка наличия пакетов в буфере
    if(m_stCount)
    {
+#if defined(IRIDIUM_ENABLE_STREAM_CRC16)
+      // Пакет уже найден и проверен при фильтрации, шум перед ним удален, достаточно разобрать заголовок
+      l_bResult = (IRIDIUM_BUS_HEADER_COMPLETE == ParseBUSHeader(GetDataPtr(), Size(), m_InPH, m_Packet));
+      m_Packet.m_stShift = 0;
+      if(!l_bResult)
+         m_Packet.m_stHeader = 0;
+#else
       // Загрузка BUS пакета входящего буфера
       l_bResult = FindBUSPacket(GetDataPtr(), Size(), m_InPH, m_Packet);
+#endif
 
       // Проверка наличия "мусора"
       if(m_Packet.m_stShift)
@@ -142,13 +196,12 @@ bool CIridiumBusInBuffer::FilterNoise()
    iridium_packet_t l_Packet;
    iridium_packet_header_t l_InPH;
 
-   // Получение текущего указателя и размера необработанных данных
-   u8* l_pPtr = (u8*)GetBuffer() + m_stFiltered;
-   size_t l_stSize = Used() - m_stFiltered;
+   size_t l_stSize = 0;
    size_t l_stCur = m_stFiltered;
 
-   // Поиск BUS пакета во входящем буфере
-   l_bResult = FindBUSPacket(l_pPtr, l_stSize, l_InPH, l_Packet);
+   // Продолжение поиска BUS пакета во входящем буфере
+   l_stSize = Used() - m_stFiltered;
+   l_bResult = ScanBUSPacket((u8*)GetBuffer() + m_stFiltered, l_stSize, l_stSize, 0, l_InPH, l_Packet);
    // Получение количества пропускаемых данных
    l_stSize = l_Packet.m_stShift;
    // Если пакет найден
@@ -188,13 +241,12 @@ bool CIridiumBusInBuffer::FilterNoiseAndForeignPacket(iridium_address_t in_Addre
    iridium_packet_t l_Packet;
    iridium_packet_header_t l_InPH;
 
-   // Получение текущего указателя и размера необработанных данных
-   u8* l_pPtr = (u8*)GetBuffer() + m_stFiltered;
-   size_t l_stSize = Used() - m_stFiltered;
+   size_t l_stSize = 0;
    size_t l_stCur = m_stFiltered;
 
-   // Поиск BUS пакета во входящем буфере
-   l_bResult = FindBUSPacket(l_pPtr, l_stSize, l_InPH, l_Packet);
+   // Продолжение поиска BUS пакета во входящем буфере
+   l_stSize = Used() - m_stFiltered;
+   l_bResult = ScanBUSPacket((u8*)GetBuffer() + m_stFiltered, l_stSize, l_stSize, 0, l_InPH, l_Packet);
    // Получение количества пропускаемых данных
    l_stSize = l_Packet.m_stShift;
    // Если пакет найден
@@ -242,101 +294,551 @@ void CIridiumBusInBuffer::SetLockUnlock(lock_buffer_t in_pLock, unlock_buffer_t
 }
 
 /**
-   Поиск заголовка пакета для BUS протокола
-   на входе    :  in_pBuffer  - указатель на буфер в котором нужно искать пакет
-                  in_stSize   - размер данных в буфере
+   Сброс состояния возобновляемого поиска пакета
+   на входе    :  *
+   на выходе   :  *
+*/
+void CIridiumBusInBuffer::ResetScan()
+{
+   m_stScan = 0;
+   m_stPending = (size_t)-1;
+   m_stSkipped = (size_t)-1;
+   m_stSkippedEnd = (size_t)-1;
+   memset(&m_PendingPH, 0, sizeof(m_PendingPH));
+   memset(&m_PendingPacket, 0, sizeof(m_PendingPacket));
+   InitCRC16Stream(&m_PendingCRC, 0xFFFF);
+}
+
+/**
+   Досчет CRC16 тела пакета ожидающего данных по мере поступления данных
+   на входе    :  in_pPacket  - указатель на начало пакета ожидающего данных
+                  in_stSize   - размер данных в буфере начиная с in_pPacket
+   на выходе   :  true  - пакет получен полностью и CRC16 совпадает
+                  false - пакет получен не полностью или поврежден
+   примечание  :  CRC16 считается только по данным которые еще не были учтены, поэтому каждый байт тела
+                  обрабатывается один раз, а при получении последних байт остается только сравнение
+*/
+bool CIridiumBusInBuffer::UpdatePendingCRC(u8* in_pPacket, size_t in_stSize)
+{
+   u16 l_u16CRC = 0;
+   u8* l_pBody = in_pPacket + m_PendingPacket.m_stHeader;
+   size_t l_stBody = in_stSize - m_PendingPacket.m_stHeader;
+
+#if defined(IRIDIUM_ENABLE_STREAM_CRC16)
+   // CRC16 считается при добавлении данных, здесь тело проверяется только если пакет не был подтвержден
+   if(in_stSize < (m_PendingPacket.m_stHeader + m_PendingPacket.m_stSize))
+      return false;
+#endif
+
+   // Добавление полученной части тела
+   if(l_stBody > m_PendingPacket.m_stBody)
+      l_stBody = m_PendingPacket.m_stBody;
+   if(l_stBody > m_PendingCRC.m_stSize)
+      UpdateCRC16Stream(&m_PendingCRC, l_pBody + m_PendingCRC.m_stSize, l_stBody - m_PendingCRC.m_stSize);
+
+   // Проверка наличия CRC16 пакета
+   if(in_stSize < (m_PendingPacket.m_stHeader + m_PendingPacket.m_stSize))
+      return false;
+
+   ReadU16LE(l_pBody + m_PendingPacket.m_stBody, l_u16CRC);
+   return m_PendingCRC.m_u16CRC == l_u16CRC;
+}
+
+/**
+   Возобновляемый поиск BUS пакета в необработанной части входящего буфера
+   на входе    :  in_pBuffer  - указатель на необработанные данные (позиция m_stFiltered)
+                  in_stSize   - размер необработанных данных
+                  in_stWrap   - смещение от in_pBuffer на котором данные продолжаются с начала кольцевого буфера
+                  in_stRing   - размер кольцевого буфера, 0 для линейного буфера
                   out_rInPH   - ссылка на структуру куда нужно поместить данные заголовка
                   out_rPacket - ссылка на структуру куда нужно поместить данные о пакете
    на выходе   :  true  - пакет найден
                   false - пакета в буфере нет
+   примечание  :  в отличии от FindBUSPacket метод не начинает поиск заново, а продолжает его с позиции
+                  на которой остановился предыдущий вызов. Заголовок первого пакета, тело которого еще не
+                  получено, запоминается и повторно не разбирается, CRC16 такого пакета вычисляется один раз,
+                  когда пакет будет получен полностью. Для следующих незавершенных пакетов запоминается только
+                  смещение первого из них и конец ближайшего из них, повторная проверка данных выполняется
+                  только с этого смещения и только в случае если первый незавершенный пакет оказался шумом
+                  или один из следующих незавершенных пакетов получен полностью.
+                  Метод рассчитывает на то, что вызывающая сторона удалит out_rPacket.m_stShift байт с
+                  позиции m_stFiltered, а в случае найденного пакета сместит m_stFiltered за пакет или
+                  удалит пакет из буфера. Для кольцевого буфера данные любого пакета должны быть доступны
+                  непрерывно от его начала (см. CIridiumBusRingBuffer)
 */
-bool CIridiumBusInBuffer::FindBUSPacket(u8* in_pBuffer, size_t in_stSize, iridium_packet_header_t& out_rInPH, iridium_packet_t& out_rPacket)
+bool CIridiumBusInBuffer::ScanBUSPacket(u8* in_pBuffer, size_t in_stSize, size_t in_stWrap, size_t in_stRing, iridium_packet_header_t& out_rInPH, iridium_packet_t& out_rPacket)
 {
    bool l_bResult = false;
-
-   u8 l_u8Byte = 0;
-   u8* l_pPtr = in_pBuffer;
+   u8 l_u8State = IRIDIUM_BUS_HEADER_NONE;
+   u8* l_pPtr = NULL;
    size_t l_stSize = in_stSize;
+   size_t l_stCount = 0;
+   size_t l_stSkip = 0;
+
    // Подготовка структур
    memset(&out_rPacket, 0, sizeof(out_rPacket));
    memset(&out_rInPH, 0, sizeof(out_rInPH));
-   out_rPacket.m_stShift = (size_t)-1;
-   // Искать заголовок пока это позволяют данные
-   while(l_stSize >= IRIDIUM_BUS_MIN_HEADER_SIZE)
+
+   // Если буфер был изменен в обход фильтрации, начнем поиск заново
+   if(m_stScan > l_stSize || (m_stPending != (size_t)-1 && m_stPending >= m_stScan))
+      ResetScan();
+
+   // Проверка пакета ожидающего данных
+   if(m_stPending != (size_t)-1)
    {
-      // Извлечение типа протокола, версии и флагов
-      out_rInPH.m_u8Type            = l_pPtr[0] & IRIDIUM_PROTOCOL_ID_MASK;
-      out_rInPH.m_Flags.m_bPriority = (l_pPtr[0] >> 7) & 1;
-      out_rInPH.m_Flags.m_bAddress  = (l_pPtr[0] >> 3) & 1;
-      out_rInPH.m_Flags.m_bSegment  = (l_pPtr[1] >> 6) & 1;
-      out_rInPH.m_Flags.m_u2Version = (l_pPtr[1] >> 3) & 3;
-      // Получение размера сообщения
-      out_rPacket.m_stSize          = l_pPtr[2];
-
-      // Проверка маркера, версии протокола и минимального размера сообщения
-      if(out_rInPH.m_u8Type == IRIDIUM_BUS_PROTOCOL_ID && out_rInPH.m_Flags.m_u2Version <= IRIDIUM_PROTOCOL_BUS_VERSION && out_rPacket.m_stSize >= IRIDIUM_BUS_MIN_BODY_SIZE)
+      l_pPtr = in_pBuffer + m_stPending;
+      if(m_stPending >= in_stWrap)
+         l_pPtr -= in_stRing;
+
+      // Досчет CRC16 по полученным данным и проверка пакета
+      if(IsStreamChecked(m_stPending, l_stSize, m_PendingPacket) || UpdatePendingCRC(l_pPtr, l_stSize - m_stPending))
       {
-         // Проверка четности размера данных
-         if((l_pPtr[1] >> 7) == GetParity(l_pPtr[2]))
+         out_rInPH = m_PendingPH;
+         out_rPacket = m_PendingPacket;
+         out_rPacket.m_stShift = m_stPending;
+         l_bResult = true;
+      }
+
+      if(l_stSize >= (m_stPending + m_PendingPacket.m_stHeader + m_PendingPacket.m_stSize))
+      {
+         if(!l_bResult && m_stSkipped != (size_t)-1)
          {
-            // Вычисление размера заголовка
-            out_rPacket.m_stHeader = IRIDIUM_BUS_MIN_HEADER_SIZE;
-            out_rPacket.m_stHeader += out_rInPH.m_Flags.m_bSegment ? 2 : 0;
-            out_rPacket.m_stHeader += out_rInPH.m_Flags.m_bAddress ? 2 : 0;
+            // Пакет оказался шумом, продолжим поиск со следующего незавершенного пакета
+            m_stScan = m_stSkipped;
+            m_stSkipped = (size_t)-1;
+            m_stSkippedEnd = (size_t)-1;
+         }
+         m_stPending = (size_t)-1;
+      }
+   }
 
-            // Проверка наличия данных заголовка в буфере
-            if(l_stSize >= out_rPacket.m_stHeader)
-            {
-               // Получение флага конца цепочки сообщения и типа шифрации
-               out_rInPH.m_Flags.m_u3Crypt = l_pPtr[1] & 7;
+   // Если один из следующих незавершенных пакетов получен полностью, повторим поиск с первого из них
+   if(!l_bResult && m_stSkipped != (size_t)-1 && l_stSize >= m_stSkippedEnd)
+   {
+      m_stScan = m_stSkipped;
+      m_stSkipped = (size_t)-1;
+      m_stSkippedEnd = (size_t)-1;
+   }
 
-               u8* l_pBody = l_pPtr + IRIDIUM_BUS_MIN_HEADER_SIZE;
+   // Продолжение поиска с первого непроверенного байта
+   while(!l_bResult && (l_stSize - m_stScan) >= IRIDIUM_BUS_MIN_HEADER_SIZE)
+   {
+      // Получение указателя на проверяемый байт с учетом перехода через конец кольцевого буфера
+      l_pPtr = in_pBuffer + m_stScan;
+      if(m_stScan >= in_stWrap)
+         l_pPtr -= in_stRing;
 
-               // Чтение данных сегмента об источнике и приемнике
-               if(out_rInPH.m_Flags.m_bSegment)
-               {
-                  l_pBody = ReadU8(l_pBody, l_u8Byte);
-                  out_rInPH.m_SrcAddr = l_u8Byte << 8;
-                  l_pBody = ReadU8(l_pBody, l_u8Byte);
-                  out_rInPH.m_DstAddr = l_u8Byte << 8;
-               }
-               // Чтение данных адреса об источнике и приемнике
-               if(out_rInPH.m_Flags.m_bAddress)
-               {
-                  l_pBody = ReadU8(l_pBody, l_u8Byte);
-                  out_rInPH.m_SrcAddr |= l_u8Byte;
-                  l_pBody = ReadU8(l_pBody, l_u8Byte);
-                  out_rInPH.m_DstAddr |= l_u8Byte;
-               }
+      // Пропуск байт которые не могут быть началом пакета, до перехода через конец кольцевого буфера данные
+      // непрерывны (начало кольца зеркалируется за его концом)
+      l_stCount = l_stSize - m_stScan - (IRIDIUM_BUS_MIN_HEADER_SIZE - 1);
+      if(m_stScan < in_stWrap && l_stCount > (in_stWrap - m_stScan))
+         l_stCount = in_stWrap - m_stScan;
+      l_stSkip = FindBUSMarker(l_pPtr, l_stCount);
+      m_stScan += l_stSkip;
+      // Кандидатов до конца непрерывного участка нет
+      if(l_stSkip == l_stCount)
+         continue;
+      l_pPtr += l_stSkip;
 
-               // Проверка доступности всех данных контейнера
-               if(l_stSize >= (out_rPacket.m_stHeader + out_rPacket.m_stSize))
-               {
-                  u16 l_u16CRC = 0;
-                  // Получение CRC16 из пакета
-                  out_rPacket.m_stBody = out_rPacket.m_stSize - IRIDIUM_BUS_CRC_SIZE;
-                  ReadU16LE(l_pBody + out_rPacket.m_stBody, l_u16CRC);
-                  // Вычисление CRC16 пакета и справнение с CRC16 из пакета
-                  if(GetCRC16Modbus(0xFFFF, l_pBody, out_rPacket.m_stBody) == l_u16CRC)
-                  {
-                     // Пакет найден, запишем размер тела
-                     out_rPacket.m_stShift = l_pPtr - in_pBuffer;
-                     l_bResult = true;
-                     break;
-                  }
-               } else
+      l_u8State = ParseBUSHeader(l_pPtr, l_stSize - m_stScan, out_rInPH, out_rPacket);
+      // В буфере недостаточно данных для получения данных заголовка, нужно прекратить поиск
+      if(l_u8State == IRIDIUM_BUS_HEADER_PARTIAL)
+         break;
+
+      if(l_u8State == IRIDIUM_BUS_HEADER_COMPLETE)
+      {
+         // Пакет получен полностью, проверим CRC16 (если она не была проверена при добавлении данных)
+         if(IsStreamChecked(m_stScan, l_stSize, out_rPacket) || CheckBUSPacket(l_pPtr, out_rPacket))
+         {
+            out_rPacket.m_stShift = m_stScan;
+            l_bResult = true;
+            break;
+         }
+      } else if(l_u8State == IRIDIUM_BUS_HEADER_INCOMPLETE)
+      {
+         if(m_stPending == (size_t)-1)
+         {
+            // Запомним первый пакет у которого нехватает данных
+            m_stPending = m_stScan;
+            m_PendingPH = out_rInPH;
+            m_PendingPacket = out_rPacket;
+            // Начнем считать CRC16 по уже полученной части тела
+            InitCRC16Stream(&m_PendingCRC, 0xFFFF);
+            UpdatePendingCRC(l_pPtr, l_stSize - m_stScan);
+         } else
+         {
+            // Запомним смещение первого из следующих пакетов и конец ближайшего из них
+            if(m_stSkipped == (size_t)-1)
+               m_stSkipped = m_stScan;
+            if(m_stSkippedEnd > (m_stScan + out_rPacket.m_stHeader + out_rPacket.m_stSize))
+               m_stSkippedEnd = m_stScan + out_rPacket.m_stHeader + out_rPacket.m_stSize;
+         }
+      }
+      // Переход на следующий байт
+      m_stScan++;
+   }
+
+   if(l_bResult)
+   {
+      // Вызывающая сторона удалит или пропустит данные до конца пакета, поиск начнется заново
+      ResetScan();
+   } else
+   {
+      // Начала сообщения нет, все данные до незавершенного пакета или до непроверенного байта являются мусором
+      memset(&out_rInPH, 0, sizeof(out_rInPH));
+      memset(&out_rPacket, 0, sizeof(out_rPacket));
+      out_rPacket.m_stShift = (m_stPending != (size_t)-1) ? m_stPending : m_stScan;
+      // Данные будут удалены из буфера, скорректируем позиции
+      m_stScan -= out_rPacket.m_stShift;
+      if(m_stPending != (size_t)-1)
+         m_stPending -= out_rPacket.m_stShift;
+      if(m_stSkipped != (size_t)-1)
+      {
+         m_stSkipped -= out_rPacket.m_stShift;
+         m_stSkippedEnd -= out_rPacket.m_stShift;
+      }
+   }
+   return l_bResult;
+}
+
+#if defined(IRIDIUM_ENABLE_STREAM_CRC16)
+/**
+   Добавление байта в буфер с подсчетом CRC16 пакета
+   на входе    :  in_u8Byte   - значение для добавления
+   на выходе   :  true  - значение было добавлено
+                  false - недостаточно места, значение не записано
+*/
+bool CIridiumBusInBuffer::AddByte(u8 in_u8Byte)
+{
+   bool l_bResult = CInBuffer::AddByte(in_u8Byte);
+   if(l_bResult)
+      StreamData(&in_u8Byte, 1);
+   else
+      DropStreamPacket();
+   return l_bResult;
+}
+
+/**
+   Добавление данных в буфер с подсчетом CRC16 пакетов
+   на входе    :  in_pBuffer  - указатель на буфер с данными
+                  in_stSize   - размер данных
+   на выходе   :  количество добавленных байт
+*/
+size_t CIridiumBusInBuffer::Add(const void* in_pBuffer, size_t in_stSize)
+{
+   size_t l_stResult = CInBuffer::Add(in_pBuffer, in_stSize);
+   StreamData((const u8*)in_pBuffer, l_stResult);
+   // Часть данных не поместилась, поток прерван
+   if(l_stResult < in_stSize)
+      DropStreamPacket();
+   return l_stResult;
+}
+
+/**
+   Сброс подсчета CRC16 пакетов при добавлении данных
+   на входе    :  *
+   на выходе   :  *
+*/
+void CIridiumBusInBuffer::ResetStream()
+{
+   m_stStreamCount = 0;
+   m_stStreamStart = 0;
+   m_u16StreamCRC = 0;
+   m_u8StreamChecked = 0;
+   memset(m_aStreamHeader, 0, sizeof(m_aStreamHeader));
+   memset(&m_StreamPacket, 0, sizeof(m_StreamPacket));
+   memset(m_aStreamChecked, 0, sizeof(m_aStreamChecked));
+   InitCRC16Stream(&m_StreamCRC, 0xFFFF);
+   DropStreamPacket();
+}
+
+/**
+   Подсчет CRC16 пакетов по добавленным данным
+   на входе    :  in_pData    - указатель на добавленные данные
+                  in_stSize   - размер добавленных данных
+   на выходе   :  *
+   примечание  :  метод вызывается при добавлении данных (в том числе из прерывания) и разбирает поток
+                  независимо от поиска пакета в ScanBUSPacket. Как только получен заголовок с верным маркером,
+                  версией и четностью размера, тело пакета-кандидата добавляется в CRC16 по мере поступления,
+                  после получения CRC16 пакета остается только сравнение. Позиция пакета с совпавшей CRC16
+                  запоминается, и ScanBUSPacket не вычисляет CRC16 такого пакета повторно. Если кандидат
+                  оказался шумом, он просто отбрасывается: пакеты внутри него не отслеживаются и будут проверены
+                  при поиске обычным способом
+*/
+void CIridiumBusInBuffer::StreamData(const u8* in_pData, size_t in_stSize)
+{
+   u8 l_u8State = IRIDIUM_BUS_HEADER_NONE;
+   size_t l_stPart = 0;
+   size_t l_stBody = 0;
+   iridium_packet_header_t l_InPH;
+
+   while(in_stSize)
+   {
+      if(!m_StreamPacket.m_stHeader)
+      {
+         // Пропуск байт которые не могут быть началом пакета
+         if(!m_stStreamSize && (in_pData[0] & IRIDIUM_PROTOCOL_ID_MASK) != IRIDIUM_BUS_PROTOCOL_ID)
+         {
+            in_pData++;
+            in_stSize--;
+            m_stStreamCount++;
+            continue;
+         }
+         if(!m_stStreamSize)
+            m_stStreamStart = m_stStreamCount;
+
+         // Накопление и разбор заголовка
+         m_aStreamHeader[m_stStreamSize++] = in_pData[0];
+         in_pData++;
+         in_stSize--;
+         m_stStreamCount++;
+         l_u8State = ParseBUSHeader(m_aStreamHeader, m_stStreamSize, l_InPH, m_StreamPacket);
+
+         // Заголовок не прошел проверку, поиск маркера в уже полученных байтах заголовка
+         while(l_u8State == IRIDIUM_BUS_HEADER_NONE && m_stStreamSize)
+         {
+            m_stStreamSize--;
+            m_stStreamStart++;
+            memmove(m_aStreamHeader, m_aStreamHeader + 1, m_stStreamSize);
+            if(m_stStreamSize && (m_aStreamHeader[0] & IRIDIUM_PROTOCOL_ID_MASK) == IRIDIUM_BUS_PROTOCOL_ID)
+               l_u8State = ParseBUSHeader(m_aStreamHeader, m_stStreamSize, l_InPH, m_StreamPacket);
+         }
+
+         // Заголовок разобран, начало подсчета CRC16 тела
+         if(l_u8State == IRIDIUM_BUS_HEADER_INCOMPLETE)
+         {
+            InitCRC16Stream(&m_StreamCRC, 0xFFFF);
+            m_u16StreamCRC = 0;
+         } else
+            m_StreamPacket.m_stHeader = 0;
+      } else
+      {
+         l_stBody = m_StreamPacket.m_stHeader + m_StreamPacket.m_stBody;
+         if(m_stStreamSize < l_stBody)
+         {
+            // Добавление полученной части тела в CRC16
+            l_stPart = l_stBody - m_stStreamSize;
+            if(l_stPart > in_stSize)
+               l_stPart = in_stSize;
+            UpdateCRC16Stream(&m_StreamCRC, in_pData, l_stPart);
+            in_pData += l_stPart;
+            in_stSize -= l_stPart;
+            m_stStreamSize += l_stPart;
+            m_stStreamCount += l_stPart;
+         } else
+         {
+            // Получение CRC16 пакета (LE)
+            m_u16StreamCRC |= (u16)in_pData[0] << ((m_stStreamSize - l_stBody) * 8);
+            in_pData++;
+            in_stSize--;
+            m_stStreamSize++;
+            m_stStreamCount++;
+
+            // Пакет получен полностью, сравнение CRC16
+            if(m_stStreamSize == (m_StreamPacket.m_stHeader + m_StreamPacket.m_stSize))
+            {
+               if(m_u16StreamCRC == m_StreamCRC.m_u16CRC)
                {
-                  // Если это первый пакет у которого нехватает данных, запомним на него указатель
-                  if(out_rPacket.m_stShift == (size_t)-1)
-                     out_rPacket.m_stShift = l_pPtr - in_pBuffer;
+                  m_aStreamChecked[m_u8StreamChecked].m_stStart = m_stStreamStart;
+                  m_aStreamChecked[m_u8StreamChecked].m_stSize = m_stStreamSize;
+                  m_u8StreamChecked = (m_u8StreamChecked + 1) % IRIDIUM_BUS_STREAM_CHECKED;
                }
-            } else
+               DropStreamPacket();
+            }
+         }
+      }
+   }
+}
+
+/**
+   Проверка того, что CRC16 пакета была проверена при добавлении данных
+   на входе    :  in_stOffset - смещение пакета от позиции фильтрации
+                  in_stSize   - размер данных после позиции фильтрации
+                  in_rPacket  - ссылка на структуру с размерами заголовка и тела пакета
+   на выходе   :  true  - пакет получен полностью и его CRC16 совпала
+                  false - CRC16 пакета нужно проверить
+   примечание  :  позиция пакета в потоке отсчитывается от последнего добавленного байта, поэтому не зависит
+                  от удаления данных перед пакетом. Количество добавленных данных и позиция записи читаются
+                  при заблокированном входящем буфере
+*/
+bool CIridiumBusInBuffer::IsStreamChecked(size_t in_stOffset, size_t in_stSize, const iridium_packet_t& in_rPacket)
+{
+   bool l_bResult = false;
+   u8 l_u8Data = 0;
+   size_t l_stStart = 0;
+   size_t l_stPacket = in_rPacket.m_stHeader + in_rPacket.m_stSize;
+
+   // Пакет должен быть получен полностью
+   if((in_stSize - in_stOffset) < l_stPacket)
+      return false;
+
+   // Блокируем доступ к входному буферу
+   if(m_pLock)
+      l_u8Data = m_pLock();
+   // Позиция начала пакета в потоке
+   l_stStart = m_stStreamCount - (GetUnfiltered() - in_stOffset);
+   for(u8 i = 0; i < IRIDIUM_BUS_STREAM_CHECKED; i++)
+   {
+      if(m_aStreamChecked[i].m_stSize == l_stPacket && m_aStreamChecked[i].m_stStart == l_stStart)
+      {
+         l_bResult = true;
+         break;
+      }
+   }
+   // Разблокирование буфера
+   if(m_pUnLock)
+      m_pUnLock(l_u8Data);
+   return l_bResult;
+}
+#endif   // defined(IRIDIUM_ENABLE_STREAM_CRC16)
+
+/**
+   Разбор заголовка BUS пакета по указанному смещению
+   на входе    :  in_pBuffer  - указатель на предполагаемое начало пакета
+                  in_stSize   - размер данных в буфере начиная с in_pBuffer
+                  out_rInPH   - ссылка на структуру куда нужно поместить данные заголовка
+                  out_rPacket - ссылка на структуру куда нужно поместить размеры заголовка и тела пакета
+   на выходе   :  IRIDIUM_BUS_HEADER_NONE       - по смещению нет заголовка пакета
+                  IRIDIUM_BUS_HEADER_PARTIAL    - данных заголовка недостаточно для разбора
+                  IRIDIUM_BUS_HEADER_INCOMPLETE - заголовок разобран, тело пакета получено не полностью
+                  IRIDIUM_BUS_HEADER_COMPLETE   - заголовок разобран, пакет получен полностью, но CRC16 не проверен
+   примечание  :  поле out_rPacket.m_stShift не изменяется
+*/
+u8 CIridiumBusInBuffer::ParseBUSHeader(u8* in_pBuffer, size_t in_stSize, iridium_packet_header_t& out_rInPH, iridium_packet_t& out_rPacket)
+{
+   u8 l_u8Result = IRIDIUM_BUS_HEADER_NONE;
+   u8 l_u8Byte = 0;
+
+   if(in_stSize < IRIDIUM_BUS_MIN_HEADER_SIZE)
+      return IRIDIUM_BUS_HEADER_PARTIAL;
+
+   // Извлечение типа протокола, версии и флагов
+   out_rInPH.m_u8Type            = in_pBuffer[0] & IRIDIUM_PROTOCOL_ID_MASK;
+   out_rInPH.m_Flags.m_bPriority = (in_pBuffer[0] >> 7) & 1;
+   out_rInPH.m_Flags.m_bAddress  = (in_pBuffer[0] >> 3) & 1;
+   out_rInPH.m_Flags.m_bSegment  = (in_pBuffer[1] >> 6) & 1;
+   out_rInPH.m_Flags.m_u2Version = (in_pBuffer[1] >> 3) & 3;
+   // Получение размера сообщения
+   out_rPacket.m_stSize          = in_pBuffer[2];
+
+   // Проверка маркера, версии протокола и минимального размера сообщения
+   if(out_rInPH.m_u8Type == IRIDIUM_BUS_PROTOCOL_ID && out_rInPH.m_Flags.m_u2Version <= IRIDIUM_PROTOCOL_BUS_VERSION && out_rPacket.m_stSize >= IRIDIUM_BUS_MIN_BODY_SIZE)
+   {
+      // Проверка четности размера данных
+      if((in_pBuffer[1] >> 7) == GetParity(in_pBuffer[2]))
+      {
+         // Вычисление размера заголовка
+         out_rPacket.m_stHeader = IRIDIUM_BUS_MIN_HEADER_SIZE;
+         out_rPacket.m_stHeader += out_rInPH.m_Flags.m_bSegment ? 2 : 0;
+         out_rPacket.m_stHeader += out_rInPH.m_Flags.m_bAddress ? 2 : 0;
+         out_rPacket.m_stBody = out_rPacket.m_stSize - IRIDIUM_BUS_CRC_SIZE;
+
+         // Проверка наличия данных заголовка в буфере
+         if(in_stSize >= out_rPacket.m_stHeader)
+         {
+            // Получение флага конца цепочки сообщения и типа шифрации
+            out_rInPH.m_Flags.m_u3Crypt = in_pBuffer[1] & 7;
+            out_rInPH.m_SrcAddr = 0;
+            out_rInPH.m_DstAddr = 0;
+
+            u8* l_pBody = in_pBuffer + IRIDIUM_BUS_MIN_HEADER_SIZE;
+
+            // Чтение данных сегмента об источнике и приемнике
+            if(out_rInPH.m_Flags.m_bSegment)
             {
-               // В буфере недостаточно данных для получения данных заголовка, нужно прекратить поиск заголовков в буфере
-               l_bResult = false;
-               break;
+               l_pBody = ReadU8(l_pBody, l_u8Byte);
+               out_rInPH.m_SrcAddr = l_u8Byte << 8;
+               l_pBody = ReadU8(l_pBody, l_u8Byte);
+               out_rInPH.m_DstAddr = l_u8Byte << 8;
             }
+            // Чтение данных адреса об источнике и приемнике
+            if(out_rInPH.m_Flags.m_bAddress)
+            {
+               l_pBody = ReadU8(l_pBody, l_u8Byte);
+               out_rInPH.m_SrcAddr |= l_u8Byte;
+               l_pBody = ReadU8(l_pBody, l_u8Byte);
+               out_rInPH.m_DstAddr |= l_u8Byte;
+            }
+
+            // Проверка доступности всех данных контейнера
+            if(in_stSize >= (out_rPacket.m_stHeader + out_rPacket.m_stSize))
+               l_u8Result = IRIDIUM_BUS_HEADER_COMPLETE;
+            else
+               l_u8Result = IRIDIUM_BUS_HEADER_INCOMPLETE;
+         } else
+            l_u8Result = IRIDIUM_BUS_HEADER_PARTIAL;
+      }
+   }
+   return l_u8Result;
+}
+
+/**
+   Проверка CRC16 полностью полученного BUS пакета
+   на входе    :  in_pBuffer  - указатель на начало пакета
+                  in_rPacket  - ссылка на структуру с размерами заголовка и тела пакета
+   на выходе   :  true  - CRC16 пакета совпадает
+                  false - пакет поврежден или является шумом
+*/
+bool CIridiumBusInBuffer::CheckBUSPacket(u8* in_pBuffer, const iridium_packet_t& in_rPacket)
+{
+   u16 l_u16CRC = 0;
+   u8* l_pBody = in_pBuffer + in_rPacket.m_stHeader;
+   // Получение CRC16 из пакета
+   ReadU16LE(l_pBody + in_rPacket.m_stBody, l_u16CRC);
+   // Вычисление CRC16 пакета и справнение с CRC16 из пакета
+   return GetCRC16Modbus(0xFFFF, l_pBody, in_rPacket.m_stBody) == l_u16CRC;
+}
+
+/**
+   Поиск заголовка пакета для BUS протокола
+   на входе    :  in_pBuffer  - указатель на буфер в котором нужно искать пакет
+                  in_stSize   - размер данных в буфере
+                  out_rInPH   - ссылка на структуру куда нужно поместить данные заголовка
+                  out_rPacket - ссылка на структуру куда нужно поместить данные о пакете
+   на выходе   :  true  - пакет найден
+                  false - пакета в буфере нет
+*/
+bool CIridiumBusInBuffer::FindBUSPacket(u8* in_pBuffer, size_t in_stSize, iridium_packet_header_t& out_rInPH, iridium_packet_t& out_rPacket)
+{
+   bool l_bResult = false;
+   u8 l_u8State = IRIDIUM_BUS_HEADER_NONE;
+   u8* l_pPtr = in_pBuffer;
+   size_t l_stSize = in_stSize;
+   size_t l_stSkip = 0;
+   // Подготовка структур
+   memset(&out_rPacket, 0, sizeof(out_rPacket));
+   memset(&out_rInPH, 0, sizeof(out_rInPH));
+   out_rPacket.m_stShift = (size_t)-1;
+   // Искать заголовок пока это позволяют данные
+   while(l_stSize >= IRIDIUM_BUS_MIN_HEADER_SIZE)
+   {
+      // Пропуск байт которые не могут быть началом пакета
+      l_stSkip = FindBUSMarker(l_pPtr, l_stSize - (IRIDIUM_BUS_MIN_HEADER_SIZE - 1));
+      l_pPtr += l_stSkip;
+      l_stSize -= l_stSkip;
+      if(l_stSize < IRIDIUM_BUS_MIN_HEADER_SIZE)
+         break;
+
+      l_u8State = ParseBUSHeader(l_pPtr, l_stSize, out_rInPH, out_rPacket);
+      // В буфере недостаточно данных для получения данных заголовка, нужно прекратить поиск заголовков в буфере
+      if(l_u8State == IRIDIUM_BUS_HEADER_PARTIAL)
+         break;
+
+      if(l_u8State == IRIDIUM_BUS_HEADER_COMPLETE)
+      {
+         // Проверка CRC16 пакета
+         if(CheckBUSPacket(l_pPtr, out_rPacket))
+         {
+            // Пакет найден, запишем размер тела
+            out_rPacket.m_stShift = l_pPtr - in_pBuffer;
+            l_bResult = true;
+            break;
          }
+      } else if(l_u8State == IRIDIUM_BUS_HEADER_INCOMPLETE)
+      {
+         // Если это первый пакет у которого нехватает данных, запомним на него указатель
+         if(out_rPacket.m_stShift == (size_t)-1)
+            out_rPacket.m_stShift = l_pPtr - in_pBuffer;
       }
       // Переход на следующий байт
       l_pPtr++;
@@ -354,3 +856,236 @@ bool CIridiumBusInBuffer::FindBUSPacket(u8* in_pBuffer, size_t in_stSize, iridiu
    return l_bResult;
 }
 
+/**
+   Проверка может ли байт быть началом BUS пакета
+   на входе    :  in_pBuffer  - указатель на проверяемый байт (должны быть доступны еще 2 байта)
+   на выходе   :  true  - маркер, версия, минимальный размер и четность размера совпадают
+                  false - байт не может быть началом пакета
+*/
+static inline bool IsBUSMarker(const u8* in_pBuffer)
+{
+   return (in_pBuffer[0] & IRIDIUM_PROTOCOL_ID_MASK) == IRIDIUM_BUS_PROTOCOL_ID &&
+      ((in_pBuffer[1] >> 3) & 3) <= IRIDIUM_PROTOCOL_BUS_VERSION &&
+      in_pBuffer[2] >= IRIDIUM_BUS_MIN_BODY_SIZE &&
+      (in_pBuffer[1] >> 7) == GetParity(in_pBuffer[2]);
+}
+
+/**
+   Скалярный поиск кандидата на начало BUS пакета
+   на входе    :  in_pBuffer  - указатель на данные
+                  in_stCount  - количество проверяемых позиций
+   на выходе   :  смещение первого кандидата, in_stCount если кандидатов нет
+*/
+static size_t FindBUSMarkerScalar(const u8* in_pBuffer, size_t in_stCount)
+{
+   size_t i = 0;
+   for(; i < in_stCount; i++)
+   {
+      if(IsBUSMarker(in_pBuffer + i))
+         break;
+   }
+   return i;
+}
+
+#if defined(IRIDIUM_BUS_MARKER_SSE2) || defined(IRIDIUM_BUS_MARKER_NEON)
+/**
+   Получение номера младшего установленного бита
+   на входе    :  in_u32Mask  - маска, не равна 0
+   на выходе   :  номер бита
+*/
+static inline size_t GetLowestBit(u32 in_u32Mask)
+{
+#if defined(_MSC_VER)
+   unsigned long l_ulIndex = 0;
+   _BitScanForward(&l_ulIndex, in_u32Mask);
+   return l_ulIndex;
+#else
+   return __builtin_ctz(in_u32Mask);
+#endif
+}
+#endif
+
+#if defined(IRIDIUM_BUS_MARKER_SSE2)
+/**
+   Поиск кандидата на начало BUS пакета по 16 байт (SSE2)
+   на входе    :  in_pBuffer  - указатель на данные
+                  in_stCount  - количество проверяемых позиций
+   на выходе   :  смещение первого кандидата, in_stCount если кандидатов нет
+*/
+static size_t FindBUSMarkerSSE2(const u8* in_pBuffer, size_t in_stCount)
+{
+   const __m128i l_Mask    = _mm_set1_epi8((char)IRIDIUM_PROTOCOL_ID_MASK);
+   const __m128i l_ID      = _mm_set1_epi8((char)IRIDIUM_BUS_PROTOCOL_ID);
+   const __m128i l_Version = _mm_set1_epi8((char)(IRIDIUM_PROTOCOL_BUS_VERSION << 3));
+   const __m128i l_VerMask = _mm_set1_epi8(0x18);
+   const __m128i l_MinBody = _mm_set1_epi8((char)IRIDIUM_BUS_MIN_BODY_SIZE);
+   const __m128i l_Low4    = _mm_set1_epi8(0x0F);
+   const __m128i l_Low2    = _mm_set1_epi8(0x03);
+   const __m128i l_Low1    = _mm_set1_epi8(0x01);
+   const __m128i l_Zero    = _mm_setzero_si128();
+   size_t i = 0;
+
+   for(; i + 16 <= in_stCount; i += 16)
+   {
+      __m128i l_B0 = _mm_loadu_si128((const __m128i*)(in_pBuffer + i));
+      __m128i l_B1 = _mm_loadu_si128((const __m128i*)(in_pBuffer + i + 1));
+      __m128i l_B2 = _mm_loadu_si128((const __m128i*)(in_pBuffer + i + 2));
+
+      // Маркер начала пакета
+      __m128i l_Result = _mm_cmpeq_epi8(_mm_and_si128(l_B0, l_Mask), l_ID);
+      // Версия протокола не больше поддерживаемой
+      __m128i l_Ver = _mm_and_si128(l_B1, l_VerMask);
+      l_Result = _mm_and_si128(l_Result, _mm_cmpeq_epi8(_mm_min_epu8(l_Ver, l_Version), l_Ver));
+      // Минимальный размер тела
+      l_Result = _mm_and_si128(l_Result, _mm_cmpeq_epi8(_mm_max_epu8(l_B2, l_MinBody), l_B2));
+      // Четность размера (свертка байта до одного бита) должна совпасть со старшим битом второго байта
+      __m128i l_Parity = _mm_xor_si128(l_B2, _mm_and_si128(_mm_srli_epi16(l_B2, 4), l_Low4));
+      l_Parity = _mm_xor_si128(l_Parity, _mm_and_si128(_mm_srli_epi16(l_Parity, 2), l_Low2));
+      l_Parity = _mm_xor_si128(l_Parity, _mm_and_si128(_mm_srli_epi16(l_Parity, 1), l_Low1));
+      l_Parity = _mm_cmpeq_epi8(_mm_and_si128(l_Parity, l_Low1), l_Low1);
+      l_Result = _mm_and_si128(l_Result, _mm_cmpeq_epi8(l_Parity, _mm_cmpgt_epi8(l_Zero, l_B1)));
+
+      u32 l_u32Bits = (u32)_mm_movemask_epi8(l_Result);
+      if(l_u32Bits)
+         return i + GetLowestBit(l_u32Bits);
+   }
+   // Проверка остатка
+   return i + FindBUSMarkerScalar(in_pBuffer + i, in_stCount - i);
+}
+#endif
+
+#if defined(IRIDIUM_BUS_MARKER_AVX2)
+/**
+   Поиск кандидата на начало BUS пакета по 32 байта (AVX2)
+   на входе    :  in_pBuffer  - указатель на данные
+                  in_stCount  - количество проверяемых позиций
+   на выходе   :  смещение первого кандидата, in_stCount если кандидатов нет
+*/
+__attribute__((target("avx2"))) static size_t FindBUSMarkerAVX2(const u8* in_pBuffer, size_t in_stCount)
+{
+   const __m256i l_Mask    = _mm256_set1_epi8((char)IRIDIUM_PROTOCOL_ID_MASK);
+   const __m256i l_ID      = _mm256_set1_epi8((char)IRIDIUM_BUS_PROTOCOL_ID);
+   const __m256i l_Version = _mm256_set1_epi8((char)(IRIDIUM_PROTOCOL_BUS_VERSION << 3));
+   const __m256i l_VerMask = _mm256_set1_epi8(0x18);
+   const __m256i l_MinBody = _mm256_set1_epi8((char)IRIDIUM_BUS_MIN_BODY_SIZE);
+   const __m256i l_Low4    = _mm256_set1_epi8(0x0F);
+   const __m256i l_Low2    = _mm256_set1_epi8(0x03);
+   const __m256i l_Low1    = _mm256_set1_epi8(0x01);
+   const __m256i l_Zero    = _mm256_setzero_si256();
+   size_t i = 0;
+
+   for(; i + 32 <= in_stCount; i += 32)
+   {
+      __m256i l_B0 = _mm256_loadu_si256((const __m256i*)(in_pBuffer + i));
+      __m256i l_B1 = _mm256_loadu_si256((const __m256i*)(in_pBuffer + i + 1));
+      __m256i l_B2 = _mm256_loadu_si256((const __m256i*)(in_pBuffer + i + 2));
+
+      // Маркер начала пакета
+      __m256i l_Result = _mm256_cmpeq_epi8(_mm256_and_si256(l_B0, l_Mask), l_ID);
+      // Версия протокола не больше поддерживаемой
+      __m256i l_Ver = _mm256_and_si256(l_B1, l_VerMask);
+      l_Result = _mm256_and_si256(l_Result, _mm256_cmpeq_epi8(_mm256_min_epu8(l_Ver, l_Version), l_Ver));
+      // Минимальный размер тела
+      l_Result = _mm256_and_si256(l_Result, _mm256_cmpeq_epi8(_mm256_max_epu8(l_B2, l_MinBody), l_B2));
+      // Четность размера должна совпасть со старшим битом второго байта
+      __m256i l_Parity = _mm256_xor_si256(l_B2, _mm256_and_si256(_mm256_srli_epi16(l_B2, 4), l_Low4));
+      l_Parity = _mm256_xor_si256(l_Parity, _mm256_and_si256(_mm256_srli_epi16(l_Parity, 2), l_Low2));
+      l_Parity = _mm256_xor_si256(l_Parity, _mm256_and_si256(_mm256_srli_epi16(l_Parity, 1), l_Low1));
+      l_Parity = _mm256_cmpeq_epi8(_mm256_and_si256(l_Parity, l_Low1), l_Low1);
+      l_Result = _mm256_and_si256(l_Result, _mm256_cmpeq_epi8(l_Parity, _mm256_cmpgt_epi8(l_Zero, l_B1)));
+
+      u32 l_u32Bits = (u32)_mm256_movemask_epi8(l_Result);
+      if(l_u32Bits)
+         return i + GetLowestBit(l_u32Bits);
+   }
+   // Проверка остатка
+   return i + FindBUSMarkerSSE2(in_pBuffer + i, in_stCount - i);
+}
+#endif
+
+#if defined(IRIDIUM_BUS_MARKER_NEON)
+/**
+   Поиск кандидата на начало BUS пакета по 16 байт (NEON)
+   на входе    :  in_pBuffer  - указатель на данные
+                  in_stCount  - количество проверяемых позиций
+   на выходе   :  смещение первого кандидата, in_stCount если кандидатов нет
+*/
+static size_t FindBUSMarkerNEON(const u8* in_pBuffer, size_t in_stCount)
+{
+   const uint8x16_t l_Mask    = vdupq_n_u8(IRIDIUM_PROTOCOL_ID_MASK);
+   const uint8x16_t l_ID      = vdupq_n_u8(IRIDIUM_BUS_PROTOCOL_ID);
+   const uint8x16_t l_Version = vdupq_n_u8(IRIDIUM_PROTOCOL_BUS_VERSION << 3);
+   const uint8x16_t l_VerMask = vdupq_n_u8(0x18);
+   const uint8x16_t l_MinBody = vdupq_n_u8(IRIDIUM_BUS_MIN_BODY_SIZE);
+   const uint8x16_t l_Low1    = vdupq_n_u8(0x01);
+   size_t i = 0;
+
+   for(; i + 16 <= in_stCount; i += 16)
+   {
+      uint8x16_t l_B0 = vld1q_u8(in_pBuffer + i);
+      uint8x16_t l_B1 = vld1q_u8(in_pBuffer + i + 1);
+      uint8x16_t l_B2 = vld1q_u8(in_pBuffer + i + 2);
+
+      // Маркер начала пакета, версия протокола и минимальный размер тела
+      uint8x16_t l_Result = vceqq_u8(vandq_u8(l_B0, l_Mask), l_ID);
+      l_Result = vandq_u8(l_Result, vcleq_u8(vandq_u8(l_B1, l_VerMask), l_Version));
+      l_Result = vandq_u8(l_Result, vcgeq_u8(l_B2, l_MinBody));
+      // Четность размера (младший бит количества единиц) должна совпасть со старшим битом второго байта
+      l_Result = vandq_u8(l_Result, vceqq_u8(vandq_u8(vcntq_u8(l_B2), l_Low1), vshrq_n_u8(l_B1, 7)));
+
+      // Сжатие результата до 4 бит на позицию
+      uint64_t l_u64Bits = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(l_Result), 4)), 0);
+      if(l_u64Bits)
+      {
+         u32 l_u32Low = (u32)l_u64Bits;
+         return i + (l_u32Low ? GetLowestBit(l_u32Low) : 32 + GetLowestBit((u32)(l_u64Bits >> 32))) / 4;
+      }
+   }
+   // Проверка остатка
+   return i + FindBUSMarkerScalar(in_pBuffer + i, in_stCount - i);
+}
+#endif
+
+#if defined(IRIDIUM_BUS_MARKER_SSE2)
+typedef size_t (*find_bus_marker_t)(const u8*, size_t);
+
+/**
+   Выбор реализации поиска кандидата по возможностям процессора
+   на входе    :  *
+   на выходе   :  указатель на функцию поиска
+*/
+static find_bus_marker_t SelectFindBUSMarker()
+{
+   find_bus_marker_t l_pResult = FindBUSMarkerSSE2;
+#if defined(IRIDIUM_BUS_MARKER_AVX2)
+   __builtin_cpu_init();
+   if(__builtin_cpu_supports("avx2"))
+      l_pResult = FindBUSMarkerAVX2;
+#endif
+   return l_pResult;
+}
+#endif
+
+/**
+   Поиск кандидата на начало BUS пакета
+   на входе    :  in_pBuffer  - указатель на данные
+                  in_stCount  - количество проверяемых позиций, после последней позиции должно быть доступно
+                                еще IRIDIUM_BUS_MIN_HEADER_SIZE - 1 байт
+   на выходе   :  смещение первой позиции на которой маркер, версия, минимальный размер и четность размера
+                  совпадают, in_stCount если таких позиций нет
+   примечание  :  на позициях которые пропускает метод ParseBUSHeader всегда возвращает IRIDIUM_BUS_HEADER_NONE.
+                  На хостах проверка выполняется векторно (SSE2/AVX2 на x86, NEON на ARM), на микроконтроллерах
+                  используется скалярная проверка
+*/
+size_t CIridiumBusInBuffer::FindBUSMarker(const u8* in_pBuffer, size_t in_stCount)
+{
+#if defined(IRIDIUM_BUS_MARKER_SSE2)
+   // Реализация выбирается при первом вызове, инициализация локальной статической переменной потокобезопасна
+   static const find_bus_marker_t l_pFindBUSMarker = SelectFindBUSMarker();
+   return l_pFindBUSMarker(in_pBuffer, in_stCount);
+#elif defined(IRIDIUM_BUS_MARKER_NEON)
+   return FindBUSMarkerNEON(in_pBuffer, in_stCount);
+#else
+   return FindBUSMarkerScalar(in_pBuffer, in_stCount);
+#endif
+}
@@ -18,10 +18,27 @@
 
 // Включения
 #include "CIridiumInBuffer.h"
+#include "IridiumCRC16.h"
+#include "IridiumBus.h"
 
 typedef u8 (*lock_buffer_t)();
 typedef void (*unlock_buffer_t)(u8);
 
+// Результаты разбора заголовка BUS пакета
+#define IRIDIUM_BUS_HEADER_NONE        0           // По смещению нет заголовка пакета
+#define IRIDIUM_BUS_HEADER_PARTIAL     1           // Заголовок получен не полностью
+#define IRIDIUM_BUS_HEADER_INCOMPLETE  2           // Заголовок разобран, тело пакета получено не полностью
+#define IRIDIUM_BUS_HEADER_COMPLETE    3           // Заголовок разобран, пакет получен полностью
+
+#if defined(IRIDIUM_ENABLE_STREAM_CRC16)
+// Пакет, CRC16 которого проверена при добавлении данных
+typedef struct bus_stream_packet_s
+{
+   size_t   m_stStart;                             // Позиция начала пакета в потоке добавленных данных
+   size_t   m_stSize;                              // Размер пакета (заголовок и тело), 0 если запись пуста
+} bus_stream_packet_t;
+#endif
+
 //////////////////////////////////////////////////////////////////////////
 // class CIridiumBusInBuffer
 //////////////////////////////////////////////////////////////////////////
@@ -34,6 +51,7 @@ public:
 
    // Перегруженные методы
    virtual void SetBuffer(const void* in_pBuffer, size_t in_stSize);
+   virtual void Clear();
 
    // Открытие/закрытие пакета
    virtual s8 OpenPacket();
@@ -43,16 +61,64 @@ public:
    bool FilterNoise();
    bool FilterNoiseAndForeignPacket(iridium_address_t in_Address);
 
+#if defined(IRIDIUM_ENABLE_STREAM_CRC16)
+   // Добавление данных с подсчетом CRC16 пакетов по мере поступления (методы могут вызываться из прерывания)
+   bool AddByte(u8 in_u8Byte);
+   size_t Add(const void* in_pBuffer, size_t in_stSize);
+#endif
+
    // Установка блокирование/разблокирование входящего буфера (данные методы предназначены для микроконтроллеров
    // если микроконтроллер получает данные из шины по прерываниям)
    void SetLockUnlock(lock_buffer_t in_pLock, unlock_buffer_t in_pUnLock);
 
    // Методы децентрализованной части протокола
    static bool FindBUSPacket(u8* in_pBuffer, size_t in_stSize, iridium_packet_header_t& out_rInPH, iridium_packet_t& out_rPacket);
-private:
+   static u8 ParseBUSHeader(u8* in_pBuffer, size_t in_stSize, iridium_packet_header_t& out_rInPH, iridium_packet_t& out_rPacket);
+   static bool CheckBUSPacket(u8* in_pBuffer, const iridium_packet_t& in_rPacket);
+   static size_t FindBUSMarker(const u8* in_pBuffer, size_t in_stCount);
+
+protected:
+   // Возобновляемый поиск пакета в необработанной части буфера
+   bool ScanBUSPacket(u8* in_pBuffer, size_t in_stSize, size_t in_stWrap, size_t in_stRing, iridium_packet_header_t& out_rInPH, iridium_packet_t& out_rPacket);
+   void ResetScan();
+   bool UpdatePendingCRC(u8* in_pPacket, size_t in_stSize);
+
+#if defined(IRIDIUM_ENABLE_STREAM_CRC16)
+   // Подсчет CRC16 пакетов при добавлении данных
+   void ResetStream();
+   void DropStreamPacket()
+      { m_stStreamSize = 0; m_StreamPacket.m_stHeader = 0; }
+   void StreamData(const u8* in_pData, size_t in_stSize);
+   bool IsStreamChecked(size_t in_stOffset, size_t in_stSize, const iridium_packet_t& in_rPacket);
+   // Получение количества данных после позиции фильтрации
+   virtual size_t GetUnfiltered()
+      { return Used() - m_stFiltered; }
+#else
+   bool IsStreamChecked(size_t in_stOffset, size_t in_stSize, const iridium_packet_t& in_rPacket)
+      { return false; }
+#endif
+
    size_t            m_stCount;                       // Количество найденных пакетов
    size_t            m_stFiltered;                    // Смещение на текущую позицию обработки входящего буфера
+   size_t            m_stScan;                        // Смещение от m_stFiltered до первого непроверенного байта
+   size_t            m_stPending;                     // Смещение от m_stFiltered до пакета ожидающего данных, (size_t)-1 если пакета нет
+   iridium_packet_header_t m_PendingPH;               // Заголовок пакета ожидающего данных
+   iridium_packet_t  m_PendingPacket;                 // Параметры пакета ожидающего данных
+   crc16_stream_t    m_PendingCRC;                    // CRC16 полученной части тела пакета ожидающего данных
+   size_t            m_stSkipped;                     // Смещение от m_stFiltered до следующего пакета ожидающего данных, (size_t)-1 если пакета нет
+   size_t            m_stSkippedEnd;                  // Смещение от m_stFiltered до конца ближайшего из следующих пакетов ожидающих данных
    lock_buffer_t     m_pLock;                         // Указатель на метод блокирования входящего буфера
    unlock_buffer_t   m_pUnLock;                       // Указатель на метод разблокирования входящего буфера
+#if defined(IRIDIUM_ENABLE_STREAM_CRC16)
+   size_t            m_stStreamCount;                 // Количество добавленных в буфер данных (позиция в потоке)
+   size_t            m_stStreamStart;                 // Позиция начала пакета-кандидата в потоке
+   size_t            m_stStreamSize;                  // Количество полученных данных пакета-кандидата
+   u8                m_aStreamHeader[IRIDIUM_BUS_MAX_HEADER_SIZE]; // Полученная часть заголовка пакета-кандидата
+   iridium_packet_t  m_StreamPacket;                  // Параметры пакета-кандидата, m_stHeader = 0 пока заголовок не разобран
+   crc16_stream_t    m_StreamCRC;                     // CRC16 полученной части тела пакета-кандидата
+   u16               m_u16StreamCRC;                  // Полученная часть CRC16 пакета-кандидата
+   bus_stream_packet_t m_aStreamChecked[IRIDIUM_BUS_STREAM_CHECKED]; // Пакеты, CRC16 которых совпала
+   u8                m_u8StreamChecked;               // Индекс записи следующего проверенного пакета
+#endif
 };
 #endif   // _C_IRIDIUM_BUS_IN_BUFFER_H_INCLUDED_
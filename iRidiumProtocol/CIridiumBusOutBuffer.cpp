@@ -48,6 +48,11 @@ void CIridiumBusOutBuffer::Begin(size_t in_stBlockSize)
    m_pPacket = NULL;
    m_pPtr = m_pMessage;
    m_pEnd = m_pMessage + m_stMaxMessageSize;
+   // Сброс ссылки на внешние данные
+   m_bDataRefAllow = false;
+   m_pDataRefPos = NULL;
+   m_pDataRef = NULL;
+   m_stDataRefSize = 0;
    // Проверка наличия блочного шифрования
    if(in_stBlockSize)
    {
@@ -74,9 +79,21 @@ bool CIridiumBusOutBuffer::End(iridium_packet_header_t& in_rHeader)
    // Проверка размера буфера
    if(l_stSize)
    {
-      // Расчет и добавление CRC8
-      m_pPtr = WriteU16LE(m_pPtr, GetCRC16Modbus(0xFFFF, l_pPtr, l_stSize));
-      l_stSize += 2;
+      u16 l_u16CRC = 0;
+
+      // Расчет CRC16
+      if(m_pDataRef)
+      {
+         // CRC16 вычисляется по сегментам: данные до ссылки, внешние данные и данные после ссылки
+         u8* l_pRefEnd = m_pDataRefPos + m_stDataRefSize;
+         l_u16CRC = GetCRC16Modbus(0xFFFF, l_pPtr, m_pDataRefPos - l_pPtr);
+         l_u16CRC = GetCRC16Modbus(l_u16CRC, m_pDataRef, m_stDataRefSize);
+         l_u16CRC = GetCRC16Modbus(l_u16CRC, l_pRefEnd, m_pPtr - l_pRefEnd);
+      } else
+         l_u16CRC = GetCRC16Modbus(0xFFFF, l_pPtr, l_stSize);
+      // Добавление CRC16
+      m_pPtr = WriteU16LE(m_pPtr, l_u16CRC);
+         l_stSize += 2;
       
       // Вычисление размера заголовка
       l_pPtr -= IRIDIUM_BUS_MIN_HEADER_SIZE;
@@ -0,0 +1,288 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+#include "CIridiumBusOutQueue.h"
+#include "Bytes.h"
+
+/**
+   Конструктор класса
+   на входе    :  *
+*/
+CIridiumBusOutQueue::CIridiumBusOutQueue()
+{
+   memset(m_aRing, 0, sizeof(m_aRing));
+   m_u8Class = IRIDIUM_BUS_OUT_CLASS_PRIORITY;
+   m_u8Burst = 0;
+   m_u8MaxBurst = IRIDIUM_BUS_OUT_QUEUE_BURST;
+}
+
+/**
+   Деструктор класса
+*/
+CIridiumBusOutQueue::~CIridiumBusOutQueue()
+{
+}
+
+/**
+   Установка буфера класса приоритета
+   на входе    :  in_u8Class  - класс приоритета
+                  in_pBuffer  - указатель на буфер
+                  in_stSize   - размер буфера
+   на выходе   :  успешность установки буфера
+   примечание  :  буфер класса должен вмещать хотя бы один пакет максимального размера с заголовком записи
+                  (IRIDIUM_BUS_OUT_BUFFER_SIZE + IRIDIUM_BUS_CRC_SIZE + IRIDIUM_BUS_OUT_QUEUE_HEADER)
+*/
+bool CIridiumBusOutQueue::SetBuffer(u8 in_u8Class, void* in_pBuffer, size_t in_stSize)
+{
+   bool l_bResult = false;
+
+   if(in_u8Class < IRIDIUM_BUS_OUT_CLASSES)
+   {
+      iridium_out_ring_t& l_rRing = m_aRing[in_u8Class];
+      l_rRing.m_pBuffer = (u8*)in_pBuffer;
+      l_rRing.m_stSize = in_pBuffer ? in_stSize : 0;
+      Clear(l_rRing);
+      l_bResult = true;
+   }
+   return l_bResult;
+}
+
+/**
+   Очистка очереди
+   на входе    :  *
+   на выходе   :  *
+*/
+void CIridiumBusOutQueue::Clear()
+{
+   for(u8 i = 0; i < IRIDIUM_BUS_OUT_CLASSES; i++)
+      Clear(m_aRing[i]);
+   m_u8Class = IRIDIUM_BUS_OUT_CLASS_PRIORITY;
+   m_u8Burst = 0;
+}
+
+/**
+   Очистка очереди класса
+   на входе    :  in_rRing - ссылка на очередь класса
+   на выходе   :  *
+*/
+void CIridiumBusOutQueue::Clear(iridium_out_ring_t& in_rRing)
+{
+   in_rRing.m_stRead = 0;
+   in_rRing.m_stWrite = 0;
+   in_rRing.m_stEnd = 0;
+   in_rRing.m_bWrap = false;
+   in_rRing.m_stCount = 0;
+}
+
+/**
+   Добавление пакета, класс определяется флагом приоритета в заголовке шинного пакета
+   на входе    :  in_pPacket  - указатель на данные пакета
+                  in_stSize   - размер пакета
+   на выходе   :  успешность добавления, false - в очереди класса нет места
+*/
+bool CIridiumBusOutQueue::Push(const void* in_pPacket, size_t in_stSize)
+{
+   bool l_bResult = false;
+
+   if(in_pPacket && in_stSize)
+   {
+      u8 l_u8Class = (((const u8*)in_pPacket)[0] & IRIDIUM_BUS_PRIORITY_MASK) ? IRIDIUM_BUS_OUT_CLASS_PRIORITY : IRIDIUM_BUS_OUT_CLASS_NORMAL;
+      l_bResult = Push(l_u8Class, in_pPacket, in_stSize);
+   }
+   return l_bResult;
+}
+
+/**
+   Добавление пакета в указанный класс
+   на входе    :  in_u8Class  - класс приоритета
+                  in_pPacket  - указатель на данные пакета
+                  in_stSize   - размер пакета
+   на выходе   :  успешность добавления, false - в очереди класса нет места
+   примечание  :  если буфер класса не задан, пакет добавляется в очередь другого класса
+*/
+bool CIridiumBusOutQueue::Push(u8 in_u8Class, const void* in_pPacket, size_t in_stSize)
+{
+   iridium_iovec_t l_Vec;
+   l_Vec.m_pPtr = in_pPacket;
+   l_Vec.m_stSize = in_stSize;
+   return Push(in_u8Class, &l_Vec, 1);
+}
+
+/**
+   Добавление пакета, состоящего из нескольких сегментов, класс определяется флагом приоритета в заголовке
+   на входе    :  in_pVec     - указатель на массив сегментов пакета
+                  in_stCount  - количество сегментов
+   на выходе   :  успешность добавления, false - в очереди класса нет места
+*/
+bool CIridiumBusOutQueue::Push(const iridium_iovec_t* in_pVec, size_t in_stCount)
+{
+   bool l_bResult = false;
+
+   if(in_pVec && in_stCount && in_pVec[0].m_pPtr && in_pVec[0].m_stSize)
+   {
+      u8 l_u8Class = (((const u8*)in_pVec[0].m_pPtr)[0] & IRIDIUM_BUS_PRIORITY_MASK) ? IRIDIUM_BUS_OUT_CLASS_PRIORITY : IRIDIUM_BUS_OUT_CLASS_NORMAL;
+      l_bResult = Push(l_u8Class, in_pVec, in_stCount);
+   }
+   return l_bResult;
+}
+
+/**
+   Добавление пакета, состоящего из нескольких сегментов, в указанный класс
+   на входе    :  in_u8Class  - класс приоритета
+                  in_pVec     - указатель на массив сегментов пакета
+                  in_stCount  - количество сегментов
+   на выходе   :  успешность добавления, false - в очереди класса нет места
+   примечание  :  сегменты копируются один раз, сразу в буфер класса. Если буфер класса не задан, пакет
+                  добавляется в очередь другого класса
+*/
+bool CIridiumBusOutQueue::Push(u8 in_u8Class, const iridium_iovec_t* in_pVec, size_t in_stCount)
+{
+   bool l_bResult = false;
+   size_t l_stSize = 0;
+
+   // Вычисление размера пакета
+   for(size_t i = 0; in_pVec && i < in_stCount; i++)
+   {
+      if(in_pVec[i].m_stSize && !in_pVec[i].m_pPtr)
+      {
+         l_stSize = 0;
+         break;
+      }
+      l_stSize += in_pVec[i].m_stSize;
+   }
+
+   if(in_u8Class < IRIDIUM_BUS_OUT_CLASSES && l_stSize && l_stSize <= 0xFFFF)
+   {
+      // Класс без буфера, пакеты передаются через очередь другого класса
+      if(!m_aRing[in_u8Class].m_stSize)
+         in_u8Class = (in_u8Class == IRIDIUM_BUS_OUT_CLASS_PRIORITY) ? IRIDIUM_BUS_OUT_CLASS_NORMAL : IRIDIUM_BUS_OUT_CLASS_PRIORITY;
+
+      iridium_out_ring_t& l_rRing = m_aRing[in_u8Class];
+      size_t l_stNeed = l_stSize + IRIDIUM_BUS_OUT_QUEUE_HEADER;
+      u8* l_pPtr = NULL;
+
+      if(!l_rRing.m_bWrap)
+      {
+         if(l_rRing.m_stSize - l_rRing.m_stWrite >= l_stNeed)
+         {
+            // Место есть в конце буфера
+            l_pPtr = l_rRing.m_pBuffer + l_rRing.m_stWrite;
+            l_rRing.m_stWrite += l_stNeed;
+         } else if(l_rRing.m_stRead >= l_stNeed)
+         {
+            // Пакет размещается в начале буфера, данные в конце буфера заканчиваются текущей позицией записи
+            l_rRing.m_stEnd = l_rRing.m_stWrite;
+            l_rRing.m_bWrap = true;
+            l_pPtr = l_rRing.m_pBuffer;
+            l_rRing.m_stWrite = l_stNeed;
+         }
+      } else if(l_rRing.m_stRead - l_rRing.m_stWrite >= l_stNeed)
+      {
+         // Место есть между концом записанных данных и первым пакетом
+         l_pPtr = l_rRing.m_pBuffer + l_rRing.m_stWrite;
+         l_rRing.m_stWrite += l_stNeed;
+      }
+
+      // Запись пакета
+      if(l_pPtr)
+      {
+         l_pPtr = WriteU16LE(l_pPtr, (u16)l_stSize);
+         for(size_t i = 0; i < in_stCount; i++)
+         {
+            if(in_pVec[i].m_stSize)
+               memcpy(l_pPtr, in_pVec[i].m_pPtr, in_pVec[i].m_stSize);
+            l_pPtr += in_pVec[i].m_stSize;
+         }
+         l_rRing.m_stCount++;
+         l_bResult = true;
+      }
+   }
+   return l_bResult;
+}
+
+/**
+   Выбор класса следующего пакета для отправки
+   на входе    :  *
+   на выходе   :  класс приоритета
+   примечание  :  обычный пакет выбирается, если приоритетных пакетов нет или приоритетные пакеты
+                  отправлены IRIDIUM_BUS_OUT_QUEUE_BURST раз подряд, пока обычные пакеты ожидали
+*/
+u8 CIridiumBusOutQueue::Select()
+{
+   u8 l_u8Result = IRIDIUM_BUS_OUT_CLASS_PRIORITY;
+
+   if(!m_aRing[IRIDIUM_BUS_OUT_CLASS_PRIORITY].m_stCount ||
+      (m_aRing[IRIDIUM_BUS_OUT_CLASS_NORMAL].m_stCount && m_u8MaxBurst && m_u8Burst >= m_u8MaxBurst))
+      l_u8Result = IRIDIUM_BUS_OUT_CLASS_NORMAL;
+
+   return l_u8Result;
+}
+
+/**
+   Получение следующего пакета для отправки
+   на входе    :  out_rPacket - ссылка на указатель, куда будет помещен указатель на данные пакета
+   на выходе   :  размер пакета, 0 - очередь пуста
+   примечание  :  пакет остается в очереди до вызова Release, повторный вызов Peek до Release
+                  может вернуть пакет другого класса, если за это время был добавлен приоритетный пакет
+*/
+size_t CIridiumBusOutQueue::Peek(const void*& out_rPacket)
+{
+   size_t l_stResult = 0;
+
+   m_u8Class = Select();
+   iridium_out_ring_t& l_rRing = m_aRing[m_u8Class];
+   if(l_rRing.m_stCount)
+   {
+      u16 l_u16Size = 0;
+      ReadU16LE(l_rRing.m_pBuffer + l_rRing.m_stRead, l_u16Size);
+      out_rPacket = l_rRing.m_pBuffer + l_rRing.m_stRead + IRIDIUM_BUS_OUT_QUEUE_HEADER;
+      l_stResult = l_u16Size;
+   }
+   return l_stResult;
+}
+
+/**
+   Удаление пакета, полученного Peek
+   на входе    :  *
+   на выходе   :  *
+*/
+void CIridiumBusOutQueue::Release()
+{
+   iridium_out_ring_t& l_rRing = m_aRing[m_u8Class];
+   if(l_rRing.m_stCount)
+   {
+      // Удаление пакета
+      u16 l_u16Size = 0;
+      ReadU16LE(l_rRing.m_pBuffer + l_rRing.m_stRead, l_u16Size);
+      l_rRing.m_stRead += l_u16Size + IRIDIUM_BUS_OUT_QUEUE_HEADER;
+      l_rRing.m_stCount--;
+
+      // Данные в конце буфера закончились, продолжаем с начала буфера
+      if(l_rRing.m_bWrap && l_rRing.m_stRead == l_rRing.m_stEnd)
+      {
+         l_rRing.m_stRead = 0;
+         l_rRing.m_bWrap = false;
+      }
+      // Очередь пуста, запись начинается с начала буфера
+      if(!l_rRing.m_stCount)
+         Clear(l_rRing);
+
+      // Подсчет приоритетных пакетов, отправленных пока обычные пакеты ожидали
+      if(m_u8Class == IRIDIUM_BUS_OUT_CLASS_PRIORITY && m_aRing[IRIDIUM_BUS_OUT_CLASS_NORMAL].m_stCount)
+         m_u8Burst++;
+      else
+         m_u8Burst = 0;
+   }
+}
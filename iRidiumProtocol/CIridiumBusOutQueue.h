@@ -0,0 +1,97 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+#ifndef _C_IRIDIUM_BUS_OUT_QUEUE_H_INCLUDED_
+#define _C_IRIDIUM_BUS_OUT_QUEUE_H_INCLUDED_
+
+// Включения
+#include "IridiumBus.h"
+
+// Классы приоритета исходящих пакетов
+#define IRIDIUM_BUS_OUT_CLASS_PRIORITY    0        // Интерактивные сообщения (флаг приоритета в заголовке пакета)
+#define IRIDIUM_BUS_OUT_CLASS_NORMAL      1        // Остальные сообщения, в том числе передача больших объемов данных
+#define IRIDIUM_BUS_OUT_CLASSES           2        // Количество классов приоритета
+
+// Максимальное количество приоритетных пакетов подряд, если обычные пакеты ожидают отправки
+#ifndef IRIDIUM_BUS_OUT_QUEUE_BURST
+#define IRIDIUM_BUS_OUT_QUEUE_BURST       4
+#endif
+
+// Размер заголовка записи пакета в очереди (размер пакета)
+#define IRIDIUM_BUS_OUT_QUEUE_HEADER      2
+
+// Структура очереди пакетов одного класса
+typedef struct iridium_out_ring_s
+{
+   u8*                              m_pBuffer;     // Буфер с пакетами
+   size_t                           m_stSize;      // Размер буфера
+   size_t                           m_stRead;      // Смещение первого пакета
+   size_t                           m_stWrite;     // Смещение для записи следующего пакета
+   size_t                           m_stEnd;       // Конец данных в конце буфера, если запись перешла в начало буфера
+   bool                             m_bWrap;       // Признак перехода записи в начало буфера
+   size_t                           m_stCount;     // Количество пакетов
+} iridium_out_ring_t;
+
+//////////////////////////////////////////////////////////////////////////
+// class CIridiumBusOutQueue
+//////////////////////////////////////////////////////////////////////////
+// Очередь исходящих пакетов с классами приоритета. Класс пакета определяется флагом приоритета в заголовке
+// шинного пакета, пакеты одного класса отправляются в порядке добавления. Приоритетные пакеты отправляются
+// раньше обычных, но не более IRIDIUM_BUS_OUT_QUEUE_BURST подряд, если обычные пакеты ожидают отправки.
+// Пакеты хранятся в буферах классов целиком, поэтому транспорт получает непрерывный блок данных пакета
+class CIridiumBusOutQueue
+{
+public:
+   // Конструктор/деструктор
+   CIridiumBusOutQueue();
+   ~CIridiumBusOutQueue();
+
+   // Установка буфера класса и очистка очереди
+   bool SetBuffer(u8 in_u8Class, void* in_pBuffer, size_t in_stSize);
+   void Clear();
+   // Установка максимального количества приоритетных пакетов подряд (0 - без ограничения)
+   void SetBurst(u8 in_u8Burst)
+      { m_u8MaxBurst = in_u8Burst; }
+
+   // Добавление пакета, класс определяется по заголовку пакета
+   bool Push(const void* in_pPacket, size_t in_stSize);
+   // Добавление пакета в указанный класс
+   bool Push(u8 in_u8Class, const void* in_pPacket, size_t in_stSize);
+   // Добавление пакета, состоящего из нескольких сегментов (сегменты собираются сразу в буфере класса)
+   bool Push(const iridium_iovec_t* in_pVec, size_t in_stCount);
+   bool Push(u8 in_u8Class, const iridium_iovec_t* in_pVec, size_t in_stCount);
+
+   // Получение следующего пакета для отправки (0 - очередь пуста), пакет остается в очереди
+   size_t Peek(const void*& out_rPacket);
+   // Удаление пакета, полученного Peek
+   void Release();
+
+   // Получение количества пакетов в очереди
+   size_t GetCount() const
+      { return m_aRing[IRIDIUM_BUS_OUT_CLASS_PRIORITY].m_stCount + m_aRing[IRIDIUM_BUS_OUT_CLASS_NORMAL].m_stCount; }
+   size_t GetCount(u8 in_u8Class) const
+      { return (in_u8Class < IRIDIUM_BUS_OUT_CLASSES) ? m_aRing[in_u8Class].m_stCount : 0; }
+
+protected:
+   u8 Select();
+   static void Clear(iridium_out_ring_t& in_rRing);
+
+private:
+   iridium_out_ring_t      m_aRing[IRIDIUM_BUS_OUT_CLASSES]; // Очереди классов
+   u8                      m_u8Class;              // Класс пакета, полученного Peek
+   u8                      m_u8Burst;              // Количество приоритетных пакетов, отправленных подряд
+   u8                      m_u8MaxBurst;           // Максимальное количество приоритетных пакетов подряд
+};
+#endif   // _C_IRIDIUM_BUS_OUT_QUEUE_H_INCLUDED_
@@ -31,7 +31,7 @@ CIridiumBusProtocol::CIridiumBusProtocol() : CIridiumProtocol()
 
    // Подготовка исходящего буфера
    m_OutBuffer.Clear();
-   m_pOutMessage = &m_OutBuffer;
+   m_Builder.SetBuffer(&m_OutBuffer);
 
    // Сброс данных
    Reset();
@@ -57,6 +57,7 @@ void CIridiumBusProtocol::Reset()
    m_InBuffer.Clear();
    m_MessageBuffer.Clear();
    m_OutBuffer.Clear();
+   m_OutQueue.Clear();
 
 #if defined(IRIDIUM_ENABLE_CIPHER)
    m_pCipher = NULL;
@@ -75,26 +76,51 @@ void CIridiumBusProtocol::Reset()
 */
 bool CIridiumBusProtocol::SendSearchRequest(iridium_address_t in_DstAddr, u8 in_u8Mask)
 {
+   return SendSearchRequest(in_DstAddr, in_u8Mask, GetTID(), NULL);
+}
+
+/**
+   Отправка запроса поиска с распределением ответов по слотам
+   на входе    :  in_DstAddr  - адрес сегмента
+                  in_u8Mask   - маска поиска
+                  in_u16TID   - идентификатор транзакции
+                  in_pSlots   - указатель на параметры слотов (NULL - ответ без задержки)
+   на выходе   :  успешность
+   примечание  :  параметры слотов добавляются после маски поиска, версия сообщения не меняется, чтобы
+                  запрос принимали устройства без поддержки слотов (они отвечают без задержки)
+*/
+bool CIridiumBusProtocol::SendSearchRequest(iridium_address_t in_DstAddr, u8 in_u8Mask, u16 in_u16TID, iridium_search_slots_t* in_pSlots)
+{
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
+
    // Заполнение заголовка пакета
-   m_OutPH.m_Flags.m_bSegment    = (0 != (in_DstAddr & 0xFF00));
-   m_OutPH.m_DstAddr             = in_DstAddr & ~0xFF;
-   m_OutPH.m_Flags.m_bAddress    = false; // Запрос всегда широковещательный
+   l_pOut->m_PH.m_Flags.m_bSegment = (0 != (in_DstAddr & 0xFF00));
+   l_pOut->m_PH.m_DstAddr          = in_DstAddr & ~0xFF;
+   l_pOut->m_PH.m_Flags.m_bAddress = false; // Запрос всегда широковещательный
 
    // Заполнение заголовка сообщения
-   m_OutMH.m_Flags.m_bDirection  = IRIDIUM_REQUEST;
-   m_OutMH.m_Flags.m_bError      = IRIDIUM_NO_ERROR;
-   m_OutMH.m_Flags.m_bNoTID      = false;
-   m_OutMH.m_Flags.m_bEnd        = true;
-   m_OutMH.m_Flags.m_u4Version   = GetMessageVersion(IRIDIUM_MESSAGE_SYSTEM_SEARCH);
-   m_OutMH.m_u8Type              = IRIDIUM_MESSAGE_SYSTEM_SEARCH;
-   m_OutMH.m_u16TID              = GetTID();
+   l_pOut->m_MH.m_Flags.m_bDirection = IRIDIUM_REQUEST;
+   l_pOut->m_MH.m_Flags.m_bError     = IRIDIUM_NO_ERROR;
+   l_pOut->m_MH.m_Flags.m_bNoTID     = false;
+   l_pOut->m_MH.m_Flags.m_bEnd       = true;
+   l_pOut->m_MH.m_Flags.m_u4Version  = GetMessageVersion(IRIDIUM_MESSAGE_SYSTEM_SEARCH);
+   l_pOut->m_MH.m_u8Type             = IRIDIUM_MESSAGE_SYSTEM_SEARCH;
+   l_pOut->m_MH.m_u16TID             = in_u16TID;
 
    // Начало работы с пакетом
-   Begin();
+   l_pOut->Begin();
    // Добавление маски поиска
-   m_pOutMessage->AddU8(in_u8Mask);
+   l_pOut->m_pBuffer->AddU8(in_u8Mask);
+   // Добавление параметров слотов
+   if(in_pSlots)
+   {
+      l_pOut->m_pBuffer->AddU8(in_pSlots->m_u8Slots);
+      l_pOut->m_pBuffer->AddU16LE(in_pSlots->m_u16SlotTime);
+      l_pOut->m_pBuffer->AddU8(in_pSlots->m_u8Bits);
+      l_pOut->m_pBuffer->AddU16LE(in_pSlots->m_u16Prefix);
+   }
    // Окончание работы и отправка пакета
-   return End();
+   return l_pOut->End();
 }
 
 #endif   // #if defined(IRIDIUM_CONFIG_SYSTEM_SEARCH_MASTER)
@@ -112,30 +138,32 @@ bool CIridiumBusProtocol::SendSearchRequest(iridium_address_t in_DstAddr, u8 in_
 */
 bool CIridiumBusProtocol::SendSetLIDRequest(iridium_address_t in_DstAddr, const char* in_pszHWID, u8 in_u8LID, u32 in_u32PIN)
 {
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
+
    // Заполнение заголовка пакета
-   m_OutPH.m_Flags.m_bSegment    = (0 != (in_DstAddr & 0xFF00));
-   m_OutPH.m_DstAddr             = in_DstAddr & ~0xFF;
-   m_OutPH.m_Flags.m_bAddress    = false; // Запрос всегда широковещательный
+   l_pOut->m_PH.m_Flags.m_bSegment = (0 != (in_DstAddr & 0xFF00));
+   l_pOut->m_PH.m_DstAddr          = in_DstAddr & ~0xFF;
+   l_pOut->m_PH.m_Flags.m_bAddress = false; // Запрос всегда широковещательный
 
    // Заполнение заголовка сообщения
-   m_OutMH.m_Flags.m_bDirection  = IRIDIUM_REQUEST;
-   m_OutMH.m_Flags.m_bError      = IRIDIUM_NO_ERROR;
-   m_OutMH.m_Flags.m_bNoTID      = true;
-   m_OutMH.m_Flags.m_bEnd        = true;
-   m_OutMH.m_Flags.m_u4Version   = GetMessageVersion(IRIDIUM_MESSAGE_SYSTEM_SET_LID);
-   m_OutMH.m_u8Type              = IRIDIUM_MESSAGE_SYSTEM_SET_LID;
-   m_OutMH.m_u16TID              = GetTID();
+   l_pOut->m_MH.m_Flags.m_bDirection = IRIDIUM_REQUEST;
+   l_pOut->m_MH.m_Flags.m_bError     = IRIDIUM_NO_ERROR;
+   l_pOut->m_MH.m_Flags.m_bNoTID     = true;
+   l_pOut->m_MH.m_Flags.m_bEnd       = true;
+   l_pOut->m_MH.m_Flags.m_u4Version  = GetMessageVersion(IRIDIUM_MESSAGE_SYSTEM_SET_LID);
+   l_pOut->m_MH.m_u8Type             = IRIDIUM_MESSAGE_SYSTEM_SET_LID;
+   l_pOut->m_MH.m_u16TID             = GetTID();
 
    // Начало работы с пакетом
-   Begin();
+   l_pOut->Begin();
    // Добавление HWID и LID
-   m_pOutMessage->AddString(in_pszHWID);
-   m_pOutMessage->AddU8(in_u8LID);
+   l_pOut->m_pBuffer->AddString(in_pszHWID);
+   l_pOut->m_pBuffer->AddU8(in_u8LID);
    // Добавление PIN кода
    if(in_u32PIN)
-      m_pOutMessage->AddU32LE(in_u32PIN);
+      l_pOut->m_pBuffer->AddU32LE(in_u32PIN);
    // Окончание работы и отправка пакета
-   return End();
+   return l_pOut->End();
 }
 
 #endif   // #if defined(IRIDIUM_CONFIG_SYSTEM_SET_LID_MASTER)
@@ -149,20 +177,22 @@ bool CIridiumBusProtocol::SendSetLIDRequest(iridium_address_t in_DstAddr, const
 */
 void CIridiumBusProtocol::InitRequestPacket(iridium_address_t in_DstAddr, u8 in_u8Type)
 {
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
+
    // Заполнение заголовка пакета
-   m_OutPH.m_Flags.m_bSegment    = (0 != (in_DstAddr & 0xFF00));
-   m_OutPH.m_DstAddr             = in_DstAddr;
-   m_OutPH.m_Flags.m_bAddress    = true;
-   m_OutPH.m_SrcAddr             = m_Address;
+   l_pOut->m_PH.m_Flags.m_bSegment = (0 != (in_DstAddr & 0xFF00));
+   l_pOut->m_PH.m_DstAddr          = in_DstAddr;
+   l_pOut->m_PH.m_Flags.m_bAddress = true;
+   l_pOut->m_PH.m_SrcAddr          = m_Address;
 
    // Заполнение заголовка сообщения
-   m_OutMH.m_Flags.m_bDirection  = IRIDIUM_REQUEST;
-   m_OutMH.m_Flags.m_bError      = IRIDIUM_NO_ERROR;
-   m_OutMH.m_Flags.m_bNoTID      = false;
-   m_OutMH.m_Flags.m_bEnd        = true;
-   m_OutMH.m_Flags.m_u4Version   = GetMessageVersion(in_u8Type);
-   m_OutMH.m_u8Type              = in_u8Type;
-   m_OutMH.m_u16TID              = GetTID();
+   l_pOut->m_MH.m_Flags.m_bDirection = IRIDIUM_REQUEST;
+   l_pOut->m_MH.m_Flags.m_bError     = IRIDIUM_NO_ERROR;
+   l_pOut->m_MH.m_Flags.m_bNoTID     = false;
+   l_pOut->m_MH.m_Flags.m_bEnd       = true;
+   l_pOut->m_MH.m_Flags.m_u4Version  = GetVersion(in_u8Type);
+   l_pOut->m_MH.m_u8Type             = in_u8Type;
+   l_pOut->m_MH.m_u16TID             = GetTID();
 }
 
 /**
@@ -173,20 +203,36 @@ void CIridiumBusProtocol::InitRequestPacket(iridium_address_t in_DstAddr, u8 in_
 */
 void CIridiumBusProtocol::InitResponsePacket()
 {
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
+
    // Заполнение заголовка пакета
-   m_OutPH.m_Flags.m_bSegment    = m_pInPH->m_Flags.m_bSegment;
-   m_OutPH.m_DstAddr             = m_pInPH->m_SrcAddr;
-   m_OutPH.m_Flags.m_bAddress    = true;
-   m_OutPH.m_SrcAddr             = m_Address;
+   l_pOut->m_PH.m_Flags.m_bSegment = m_pInPH->m_Flags.m_bSegment;
+   l_pOut->m_PH.m_DstAddr          = m_pInPH->m_SrcAddr;
+   l_pOut->m_PH.m_Flags.m_bAddress = true;
+   l_pOut->m_PH.m_SrcAddr          = m_Address;
 
    // Заполнение заголовка сообщения
-   m_OutMH.m_Flags.m_bDirection  = IRIDIUM_RESPONSE;
-   m_OutMH.m_Flags.m_bError      = IRIDIUM_NO_ERROR;
-   m_OutMH.m_Flags.m_bNoTID      = false;
-   m_OutMH.m_Flags.m_bEnd        = true;
-   m_OutMH.m_Flags.m_u4Version   = m_InMH.m_Flags.m_u4Version;
-   m_OutMH.m_u8Type              = m_InMH.m_u8Type;
-   m_OutMH.m_u16TID              = m_InMH.m_u16TID;
+   l_pOut->m_MH.m_Flags.m_bDirection = IRIDIUM_RESPONSE;
+   l_pOut->m_MH.m_Flags.m_bError     = IRIDIUM_NO_ERROR;
+   l_pOut->m_MH.m_Flags.m_bNoTID     = false;
+   l_pOut->m_MH.m_Flags.m_bEnd       = true;
+   l_pOut->m_MH.m_Flags.m_u4Version  = m_InMH.m_Flags.m_u4Version;
+   l_pOut->m_MH.m_u8Type             = m_InMH.m_u8Type;
+   l_pOut->m_MH.m_u16TID             = m_InMH.m_u16TID;
+}
+
+/**
+   Отправка пакета через очередь исходящих пакетов
+   на входе    :  in_pBuffer  - указатель на данные пакета
+                  in_stSize   - размер пакета
+   на выходе   :  успешность, false - в очереди нет места
+   примечание  :  класс пакета определяется флагом приоритета в заголовке. Буферы очереди задаются
+                  приложением (m_OutQueue.SetBuffer), транспорт (CAN порт, UART, сокет) забирает пакеты
+                  методами Peek/Release очереди. Приложения, отправляющие пакеты напрямую, перегружают метод
+*/
+bool CIridiumBusProtocol::SendPacket(void* in_pBuffer, size_t in_stSize)
+{
+   return m_OutQueue.Push(in_pBuffer, in_stSize);
 }
 
 #if defined(IRIDIUM_ENABLE_CIPHER)
@@ -308,3 +354,17 @@ bool CIridiumBusProtocol::DecodeMessage(u8 in_u8Crypt, u8*& out_rBuffer, size_t&
 }
 
 #endif   // defined(IRIDIUM_ENABLE_CIPHER)
+
+/**
+   Привязка построителя пакетов шины к протоколу и области памяти под пакет
+   на входе    :  in_pProtocol   - указатель на протокол, через который отправляются пакеты
+                  in_pBuffer     - указатель на область памяти под пакет
+                  in_stSize      - размер области памяти (не менее IRIDIUM_BUS_OUT_BUFFER_SIZE)
+   на выходе   :  *
+*/
+void CIridiumBusPacketBuilder::Init(CIridiumBusProtocol* in_pProtocol, void* in_pBuffer, size_t in_stSize)
+{
+   m_Buffer.SetBuffer(IRIDIUM_BUS_MAX_HEADER_SIZE, IRIDIUM_BUS_CRC_SIZE, in_pBuffer, in_stSize);
+   m_Buffer.Clear();
+   CIridiumPacketBuilder::Init(in_pProtocol, &m_Buffer);
+}
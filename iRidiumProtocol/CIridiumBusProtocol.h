@@ -20,6 +20,7 @@
 #include "CIridiumProtocol.h"
 #include "CIridiumBusInBuffer.h"
 #include "CIridiumBusOutBuffer.h"
+#include "CIridiumBusOutQueue.h"
 
 #if defined(IRIDIUM_ENABLE_CIPHER)
 #if defined(IRIDIUM_ENABLE_GRASSHOPPER_CIPHER)
@@ -40,6 +41,7 @@ public:
    // IRIDIUM_MESSAGE_SYSTEM_SEARCH (0x03)
 #if defined(IRIDIUM_CONFIG_SYSTEM_SEARCH_MASTER)
    virtual bool SendSearchRequest(iridium_address_t in_DstAddr, u8 in_u8Mask);
+   virtual bool SendSearchRequest(iridium_address_t in_DstAddr, u8 in_u8Mask, u16 in_u16TID, iridium_search_slots_t* in_pSlots);
 #endif
 
    // IRIDIUM_MESSAGE_SYSTEM_SET_LID (0x05)
@@ -51,6 +53,12 @@ public:
    virtual void InitRequestPacket(iridium_address_t in_DstAddr, u8 in_u8Type);
    virtual void InitResponsePacket();
 
+   // Отправка данных через очередь исходящих пакетов
+   virtual bool SendPacket(void* in_pBuffer, size_t in_stSize);
+   // Получение очереди исходящих пакетов, транспорт забирает из нее пакеты для отправки
+   CIridiumBusOutQueue* GetOutQueue()
+      { return &m_OutQueue; }
+
 #if defined(IRIDIUM_ENABLE_CIPHER)
    // Инициализация шифрования
    virtual void InitCrypt(u8 in_u8Crypt, u8* in_pData);
@@ -66,10 +74,26 @@ protected:
    CIridiumBusInBuffer        m_MessageBuffer;     // Входящий буфер для обработки сообщений
    // Данные для формирования исходящих сообщения
    CIridiumBusOutBuffer       m_OutBuffer;         // Исходящий буфер
+   CIridiumBusOutQueue        m_OutQueue;          // Очередь исходящих пакетов с классами приоритета
 
 #if defined(IRIDIUM_ENABLE_CIPHER) && defined(IRIDIUM_ENABLE_GRASSHOPPER_CIPHER)
    CIridiumCipherGrasshopper  m_Grasshopper;       // Шифр "Кузнечик"
 #endif   // defined(IRIDIUM_ENABLE_CIPHER) && defined(IRIDIUM_ENABLE_GRASSHOPPER_CIPHER)
 };
+
+//////////////////////////////////////////////////////////////////////////
+// class CIridiumBusPacketBuilder
+//////////////////////////////////////////////////////////////////////////
+// Построитель пакетов шины с собственным исходящим буфером. Используется для формирования пакетов
+// вне основного контекста (дополнительные потоки, прерывания), см. CIridiumProtocol::GetBuilder
+class CIridiumBusPacketBuilder : public CIridiumPacketBuilder
+{
+public:
+   // Привязка построителя к протоколу и области памяти под пакет (не менее IRIDIUM_BUS_OUT_BUFFER_SIZE)
+   void Init(CIridiumBusProtocol* in_pProtocol, void* in_pBuffer, size_t in_stSize);
+
+protected:
+   CIridiumBusOutBuffer       m_Buffer;            // Исходящий буфер построителя
+};
 #endif   // _C_IRIDIUM_BUS_PROTOCOL_H_INCLUDED_
 
@@ -0,0 +1,321 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+#include <stdio.h>
+#include "CIridiumBusRingBuffer.h"
+
+/**
+   Конструктор класса
+   на входе    :  *
+*/
+CIridiumBusRingBuffer::CIridiumBusRingBuffer() : CIridiumBusInBuffer()
+{
+   m_stRing = 0;
+   m_stRead = 0;
+   m_stWrite = 0;
+}
+
+/**
+   Деструктор класса
+*/
+CIridiumBusRingBuffer::~CIridiumBusRingBuffer()
+{
+}
+
+/**
+   Установка внешнего буфера
+   на входе    :  in_pBuffer  - указатель на буфер
+                  in_stSize   - размер буфера
+   на выходе   :  *
+   примечание  :  последние IRIDIUM_BUS_RING_MIRROR_SIZE байт буфера используются для зеркалирования
+                  начала кольца, рекомендуемый размер буфера IRIDIUM_BUS_RING_BUFFER_SIZE
+*/
+void CIridiumBusRingBuffer::SetBuffer(const void* in_pBuffer, size_t in_stSize)
+{
+   // Вызов родительского класса
+   CIridiumBusInBuffer::SetBuffer(in_pBuffer, in_stSize);
+
+   // Кольцо должно вмещать пакет максимального размера и область зеркалирования
+   m_stRing = 0;
+   if(in_stSize > (IRIDIUM_BUS_RING_MIRROR_SIZE * 2))
+      m_stRing = in_stSize - IRIDIUM_BUS_RING_MIRROR_SIZE;
+   m_stRead = 0;
+   m_stWrite = 0;
+}
+
+/**
+   Очистка буфера
+   на входе    :  *
+   на выходе   :  *
+*/
+void CIridiumBusRingBuffer::Clear()
+{
+   // Вызов родителя
+   CIridiumBusInBuffer::Clear();
+
+   // Сброс индексов
+   m_stRead = 0;
+   m_stWrite = 0;
+}
+
+/**
+   Добавление байта в буфер
+   на входе    :  in_u8Byte   - значение для добавления
+   на выходе   :  true  - значение было добавлено
+                  false - недостаточно места, значение не записано
+   примечание  :  метод может вызываться из прерывания, изменяется только индекс записи
+*/
+bool CIridiumBusRingBuffer::AddByte(u8 in_u8Byte)
+{
+   bool l_bResult = false;
+   size_t l_stWrite = m_stWrite;
+
+   if(Free())
+   {
+      // Запись байта и его зеркала
+      m_pBuffer[l_stWrite] = in_u8Byte;
+      if(l_stWrite < IRIDIUM_BUS_RING_MIRROR_SIZE)
+         m_pBuffer[m_stRing + l_stWrite] = in_u8Byte;
+      // Публикация данных
+      m_stWrite = Advance(l_stWrite, 1);
+      l_bResult = true;
+   }
+#if defined(IRIDIUM_ENABLE_STREAM_CRC16)
+   // Подсчет CRC16 пакета по мере поступления данных
+   if(l_bResult)
+      StreamData(&in_u8Byte, 1);
+   else
+      DropStreamPacket();
+#endif
+   return l_bResult;
+}
+
+/**
+   Добавление данных в буфер
+   на входе    :  in_pBuffer  - указатель на буфер с данными
+                  in_stSize   - размер данных
+   на выходе   :  количество добавленных байт
+   примечание  :  метод может вызываться из прерывания, изменяется только индекс записи
+*/
+size_t CIridiumBusRingBuffer::Add(const void* in_pBuffer, size_t in_stSize)
+{
+   const u8* l_pData = (const u8*)in_pBuffer;
+   size_t l_stWrite = m_stWrite;
+   size_t l_stPart = 0;
+   size_t l_stMirror = 0;
+
+   // Проверка размера данных
+   size_t l_stResult = Free();
+   if(l_stResult > in_stSize)
+      l_stResult = in_stSize;
+
+   // Копирование данных с переходом через конец кольца
+   for(size_t l_stLeft = l_stResult; l_stLeft; l_stLeft -= l_stPart)
+   {
+      l_stPart = m_stRing - l_stWrite;
+      if(l_stPart > l_stLeft)
+         l_stPart = l_stLeft;
+      memcpy(m_pBuffer + l_stWrite, l_pData, l_stPart);
+
+      // Обновление зеркала начала кольца
+      if(l_stWrite < IRIDIUM_BUS_RING_MIRROR_SIZE)
+      {
+         l_stMirror = IRIDIUM_BUS_RING_MIRROR_SIZE - l_stWrite;
+         if(l_stMirror > l_stPart)
+            l_stMirror = l_stPart;
+         memcpy(m_pBuffer + m_stRing + l_stWrite, l_pData, l_stMirror);
+      }
+
+      l_pData += l_stPart;
+      l_stWrite = Advance(l_stWrite, l_stPart);
+   }
+
+   // Публикация данных
+   m_stWrite = l_stWrite;
+#if defined(IRIDIUM_ENABLE_STREAM_CRC16)
+   // Подсчет CRC16 пакетов по мере поступления данных, если часть данных не поместилась поток прерван
+   StreamData((const u8*)in_pBuffer, l_stResult);
+   if(l_stResult < in_stSize)
+      DropStreamPacket();
+#endif
+   return l_stResult;
+}
+
+/**
+   Открытие сообщения для обработки из входящего шинного буфера
+   на входе    :  *
+   на выходе   :  true  - сообщение было найдено
+                  false - сообщение не найдено
+   примечание  :  пакет уже был найден и проверен при фильтрации, метод пропускает удаленный шум
+                  перед пакетом и разбирает его заголовок
+*/
+s8 CIridiumBusRingBuffer::OpenPacket()
+{
+   bool l_bResult = false;
+   size_t l_stRead = m_stRead;
+
+   // Проверка наличия пакетов в буфере
+   if(m_stCount)
+   {
+      // Пропуск удаленного шума (обнуленных данных) перед пакетом
+      while(l_stRead != m_stFiltered && !m_pBuffer[l_stRead])
+         l_stRead = Advance(l_stRead, 1);
+      if(l_stRead != m_stRead)
+         SetReadIndex(l_stRead);
+
+      // Разбор заголовка пакета
+      l_bResult = (IRIDIUM_BUS_HEADER_COMPLETE == ParseBUSHeader(m_pBuffer + l_stRead, Size(), m_InPH, m_Packet));
+      m_Packet.m_stShift = 0;
+      if(!l_bResult)
+         m_Packet.m_stHeader = 0;
+   }
+   // Вернем результат работы
+   return l_bResult;
+}
+
+/**
+   Закрытие обработанного сообшения из входящего буфера
+   на входе    :  *
+   на выходе   :  *
+*/
+void CIridiumBusRingBuffer::ClosePacket()
+{
+   if(m_stCount)
+   {
+      // Уменьшение количества пакетов
+      m_stCount--;
+
+      // Пропустим обработанные данные, если пакетов больше нет пропустим и удаленный шум
+      if(!m_stCount)
+         SetReadIndex(m_stFiltered);
+      else if(m_Packet.m_stHeader)
+         SetReadIndex(Advance(m_stRead, m_Packet.m_stHeader + m_Packet.m_stSize));
+
+      m_Packet.m_stHeader = 0;
+   }
+}
+
+/**
+   Удаление шума из входящего шинного буфера
+   на входе    :  *
+   на выходе   :  true  - был найден и обработан пакет
+                  false - пакетов найдено не было
+*/
+bool CIridiumBusRingBuffer::FilterNoise()
+{
+   bool l_bResult = false;
+   iridium_packet_t l_Packet;
+   iridium_packet_header_t l_InPH;
+
+   // Продолжение поиска BUS пакета во входящем буфере
+   l_bResult = ScanBUSPacket(m_pBuffer + m_stFiltered, GetDistance(m_stFiltered, m_stWrite), m_stRing - m_stFiltered, m_stRing, l_InPH, l_Packet);
+
+   // Удаление "мусора" перед пакетом
+   if(l_Packet.m_stShift)
+      Drop(l_Packet.m_stShift);
+
+   // Если пакет найден, установка новой позиции упаковки
+   if(l_bResult)
+   {
+      m_stFiltered = Advance(m_stFiltered, l_Packet.m_stHeader + l_Packet.m_stSize);
+      m_stCount++;
+   }
+   // Вернем результат работы
+   return l_bResult;
+}
+
+/**
+   Удаление шума и пакетов не относящихся к устройству из входящего шинного буфера
+   на входе    :  in_Address  - адрес устройства пакеты коротого нужно оставить в буфере
+   на выходе   :  true  - был найден и обработан пакет
+                  false - пакетов найдено не было
+*/
+bool CIridiumBusRingBuffer::FilterNoiseAndForeignPacket(iridium_address_t in_Address)
+{
+   bool l_bResult = false;
+   iridium_packet_t l_Packet;
+   iridium_packet_header_t l_InPH;
+
+   // Продолжение поиска BUS пакета во входящем буфере
+   l_bResult = ScanBUSPacket(m_pBuffer + m_stFiltered, GetDistance(m_stFiltered, m_stWrite), m_stRing - m_stFiltered, m_stRing, l_InPH, l_Packet);
+   // Получение количества пропускаемых данных
+   size_t l_stSize = l_Packet.m_stShift;
+   // Если пакет найден
+   if(l_bResult)
+   {
+      // Пакет нам не предназначен, удалим его из буфера вместе с "мусором"
+      if(l_InPH.m_Flags.m_bAddress && l_InPH.m_DstAddr != in_Address)
+         l_stSize += l_Packet.m_stHeader + l_Packet.m_stSize;
+   }
+
+   // Удаление "мусора"
+   if(l_stSize)
+      Drop(l_stSize);
+
+   // Обрабатываем только широковещательные и пакеты предназначеные нам
+   if(l_bResult && (!l_InPH.m_Flags.m_bAddress || l_InPH.m_DstAddr == in_Address))
+   {
+      // Установка новой позиции упаковки
+      m_stFiltered = Advance(m_stFiltered, l_Packet.m_stHeader + l_Packet.m_stSize);
+      m_stCount++;
+   }
+   // Вернем результат работы
+   return l_bResult;
+}
+
+/**
+   Удаление шума с позиции фильтрации
+   на входе    :  in_stSize   - количество удаляемых данных
+   на выходе   :  *
+   примечание  :  если в буфере нет необработанных пакетов шум удаляется перемещением индекса чтения,
+                  иначе шум находится между пакетами и обнуляется, OpenPacket пропустит его
+*/
+void CIridiumBusRingBuffer::Drop(size_t in_stSize)
+{
+   if(!m_stCount)
+   {
+      m_stFiltered = Advance(m_stFiltered, in_stSize);
+      SetReadIndex(m_stFiltered);
+   } else
+   {
+      // Обнуление данных вместе с зеркалом (нулевой байт не может быть началом пакета)
+      for(; in_stSize; in_stSize--)
+      {
+         m_pBuffer[m_stFiltered] = 0;
+         if(m_stFiltered < IRIDIUM_BUS_RING_MIRROR_SIZE)
+            m_pBuffer[m_stRing + m_stFiltered] = 0;
+         m_stFiltered = Advance(m_stFiltered, 1);
+      }
+   }
+}
+
+/**
+   Установка индекса чтения
+   на входе    :  in_stIndex  - новый индекс чтения
+   на выходе   :  *
+   примечание  :  блокировка входящего буфера требуется только на время записи индекса
+*/
+void CIridiumBusRingBuffer::SetReadIndex(size_t in_stIndex)
+{
+   u8 l_u8Data = 0;
+
+   // Блокируем доступ к входному буферу
+   if(m_pLock)
+      l_u8Data = m_pLock();
+   m_stRead = in_stIndex;
+   // Разблокирование буфера
+   if(m_pUnLock)
+      m_pUnLock(l_u8Data);
+}
@@ -0,0 +1,89 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+#ifndef _C_IRIDIUM_BUS_RING_BUFFER_H_INCLUDED_
+#define _C_IRIDIUM_BUS_RING_BUFFER_H_INCLUDED_
+
+// Включения
+#include "CIridiumBusInBuffer.h"
+#include "IridiumBus.h"
+
+//////////////////////////////////////////////////////////////////////////
+// class CIridiumBusRingBuffer
+//////////////////////////////////////////////////////////////////////////
+// Входящий шинный буфер на основе кольцевого буфера: обработка пакета и удаление шума сводятся
+// к перемещению индекса чтения, данные в буфере не сдвигаются. Последние IRIDIUM_BUS_RING_MIRROR_SIZE
+// байт внешнего буфера являются зеркалом начала кольца, поэтому любой пакет доступен непрерывно
+// от своего начала, в том числе если он переходит через конец кольца
+class CIridiumBusRingBuffer : public CIridiumBusInBuffer
+{
+public:
+   // Конструктор/деструктор
+   CIridiumBusRingBuffer();
+   virtual ~CIridiumBusRingBuffer();
+
+   // Перегруженные методы
+   virtual void SetBuffer(const void* in_pBuffer, size_t in_stSize);
+   virtual void Clear();
+
+   // Открытие/закрытие пакета
+   virtual s8 OpenPacket();
+   virtual void ClosePacket();
+
+   // Фильтрация входящего потока
+   bool FilterNoise();
+   bool FilterNoiseAndForeignPacket(iridium_address_t in_Address);
+
+   // Получение размеров
+   size_t Size() const                             // Получение размера данных
+      { return GetDistance(m_stRead, m_stWrite); }
+   size_t Free() const                             // Получение доступного свободного пространства
+      { return m_stRing ? (m_stRing - 1 - Size()) : 0; }
+
+   // Добавление данных
+   bool AddByte(u8 in_u8Byte);                     // Добавление одного байт
+   size_t Add(const void* in_pBuffer, size_t in_stSize); // Добавление данных
+
+   // Получение указателя на данные открытого сообщения
+   void* GetMessagePtr()
+      { return m_pBuffer + m_stRead + m_Packet.m_stHeader; }
+   // Получение указателя на данные открытого пакета
+   void* GetPacketPtr()
+      { return m_pBuffer + m_stRead; }
+
+protected:
+#if defined(IRIDIUM_ENABLE_STREAM_CRC16)
+   // Получение количества данных после позиции фильтрации
+   virtual size_t GetUnfiltered()
+      { return GetDistance(m_stFiltered, m_stWrite); }
+#endif
+
+private:
+   // Получение количества данных между индексами кольца
+   size_t GetDistance(size_t in_stFrom, size_t in_stTo) const
+      { return (in_stTo >= in_stFrom) ? (in_stTo - in_stFrom) : (m_stRing - in_stFrom + in_stTo); }
+   // Сдвиг индекса в кольце
+   size_t Advance(size_t in_stIndex, size_t in_stSize) const
+      { in_stIndex += in_stSize; return (in_stIndex >= m_stRing) ? (in_stIndex - m_stRing) : in_stIndex; }
+   // Удаление шума после позиции фильтрации
+   void Drop(size_t in_stSize);
+   // Установка индекса чтения
+   void SetReadIndex(size_t in_stIndex);
+
+   size_t            m_stRing;                        // Размер кольца (без области зеркалирования)
+   volatile size_t   m_stRead;                        // Индекс чтения (изменяется только при обработке)
+   volatile size_t   m_stWrite;                       // Индекс записи (изменяется только при добавлении данных)
+};
+#endif   // _C_IRIDIUM_BUS_RING_BUFFER_H_INCLUDED_
@@ -0,0 +1,359 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+#include "CIridiumCatalogCache.h"
+#include "Bytes.h"
+
+#if defined(IRIDIUM_LINUX_PLATFORM)
+#include <stdio.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/**
+   Конструктор класса
+   на входе    :  *
+*/
+CIridiumCatalogCache::CIridiumCatalogCache()
+{
+   m_stMapped = 0;
+   Close();
+}
+
+/**
+   Деструктор класса
+*/
+CIridiumCatalogCache::~CIridiumCatalogCache()
+{
+   Close();
+}
+
+/**
+   Подключение готового образа только для чтения
+   на входе    :  in_pImage   - указатель на образ (например отображенный в память файл кэша)
+                  in_stSize   - размер образа
+   на выходе   :  успешность подключения, false - образ поврежден или другой версии
+   примечание  :  все записи проверяются при подключении, поэтому поиск выполняется без проверок границ
+*/
+bool CIridiumCatalogCache::Open(const void* in_pImage, size_t in_stSize)
+{
+   bool l_bResult = false;
+   u32 l_u32Magic = 0;
+   u16 l_u16Version = 0;
+   u16 l_u16Count = 0;
+
+   Close();
+   if(in_pImage && in_stSize >= IRIDIUM_CATALOG_CACHE_HEADER)
+   {
+      u8* l_pPtr = (u8*)in_pImage;
+      l_pPtr = ReadU32LE(l_pPtr, l_u32Magic);
+      l_pPtr = ReadU16LE(l_pPtr, l_u16Version);
+      l_pPtr = ReadU16LE(l_pPtr, l_u16Count);
+
+      if(l_u32Magic == IRIDIUM_CATALOG_CACHE_MAGIC && l_u16Version == IRIDIUM_CATALOG_CACHE_VERSION)
+      {
+         u8* l_pEnd = (u8*)in_pImage + in_stSize;
+         u16 i = 0;
+         // Проверка размеров записей и наличия завершающего нуля HWID
+         for( ; i < l_u16Count; i++)
+         {
+            u32 l_u32Size = 0;
+            if((size_t)(l_pEnd - l_pPtr) < IRIDIUM_CATALOG_CACHE_RECORD)
+               break;
+            ReadU32LE(l_pPtr, l_u32Size);
+            if(l_u32Size <= IRIDIUM_CATALOG_CACHE_RECORD || l_u32Size > (size_t)(l_pEnd - l_pPtr))
+               break;
+            if(!memchr(l_pPtr + IRIDIUM_CATALOG_CACHE_RECORD, 0, l_u32Size - IRIDIUM_CATALOG_CACHE_RECORD))
+               break;
+            l_pPtr += l_u32Size;
+         }
+         if(i == l_u16Count)
+         {
+            m_pImage = (u8*)in_pImage;
+            m_stSize = l_pPtr - m_pImage;
+            m_u16Count = l_u16Count;
+            l_bResult = true;
+         }
+      }
+   }
+   return l_bResult;
+}
+
+/**
+   Создание пустого образа в буфере
+   на входе    :  in_pBuffer  - указатель на буфер образа
+                  in_stSize   - размер буфера
+   на выходе   :  успешность создания
+*/
+bool CIridiumCatalogCache::Create(void* in_pBuffer, size_t in_stSize)
+{
+   bool l_bResult = false;
+
+   Close();
+   if(in_pBuffer && in_stSize >= IRIDIUM_CATALOG_CACHE_HEADER)
+   {
+      m_pImage = (u8*)in_pBuffer;
+      m_stMax = in_stSize;
+      u8* l_pPtr = WriteU32LE(m_pImage, IRIDIUM_CATALOG_CACHE_MAGIC);
+      l_pPtr = WriteU16LE(l_pPtr, IRIDIUM_CATALOG_CACHE_VERSION);
+      l_pPtr = WriteU16LE(l_pPtr, 0);
+      m_stSize = l_pPtr - m_pImage;
+      l_bResult = true;
+   }
+   return l_bResult;
+}
+
+/**
+   Отключение образа
+   на входе    :  *
+   на выходе   :  *
+*/
+void CIridiumCatalogCache::Close()
+{
+#if defined(IRIDIUM_LINUX_PLATFORM)
+   if(m_stMapped)
+      munmap(m_pImage, m_stMapped);
+#endif
+   m_stMapped = 0;
+   m_pImage = NULL;
+   m_stSize = 0;
+   m_stMax = 0;
+   m_u16Count = 0;
+}
+
+#if defined(IRIDIUM_LINUX_PLATFORM)
+
+/**
+   Отображение файла кэша в память только для чтения
+   на входе    :  in_pszPath  - путь к файлу кэша
+   на выходе   :  успешность, false - файл отсутствует, поврежден или другой версии
+   примечание  :  образ используется без копирования до вызова Close или подключения другого образа
+*/
+bool CIridiumCatalogCache::MapFile(const char* in_pszPath)
+{
+   bool l_bResult = false;
+   struct stat l_Stat;
+
+   Close();
+   int l_iFile = open(in_pszPath, O_RDONLY);
+   if(l_iFile >= 0)
+   {
+      if(!fstat(l_iFile, &l_Stat) && l_Stat.st_size > 0)
+      {
+         void* l_pImage = mmap(NULL, (size_t)l_Stat.st_size, PROT_READ, MAP_PRIVATE, l_iFile, 0);
+         if(l_pImage != MAP_FAILED)
+         {
+            l_bResult = Open(l_pImage, (size_t)l_Stat.st_size);
+            if(l_bResult)
+               m_stMapped = (size_t)l_Stat.st_size;
+            else
+               munmap(l_pImage, (size_t)l_Stat.st_size);
+         }
+      }
+      close(l_iFile);
+   }
+   return l_bResult;
+}
+
+/**
+   Сохранение образа в файл
+   на входе    :  in_pszPath  - путь к файлу кэша
+   на выходе   :  успешность
+   примечание  :  образ записывается во временный файл рядом с файлом кэша, который затем заменяет файл кэша.
+                  Поэтому отображенный в память предыдущий образ остается доступным, а при сбое записи
+                  файл кэша не повреждается
+*/
+bool CIridiumCatalogCache::SaveFile(const char* in_pszPath)
+{
+   bool l_bResult = false;
+   char l_szTemp[PATH_MAX];
+
+   if(m_pImage && (size_t)snprintf(l_szTemp, sizeof(l_szTemp), "%s.tmp", in_pszPath) < sizeof(l_szTemp))
+   {
+      int l_iFile = open(l_szTemp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      if(l_iFile >= 0)
+      {
+         // Запись образа
+         const u8* l_pPtr = m_pImage;
+         size_t l_stSize = m_stSize;
+         while(l_stSize)
+         {
+            ssize_t l_iWritten = write(l_iFile, l_pPtr, l_stSize);
+            if(l_iWritten <= 0)
+               break;
+            l_pPtr += l_iWritten;
+            l_stSize -= (size_t)l_iWritten;
+         }
+         l_bResult = !l_stSize && !fsync(l_iFile);
+         if(close(l_iFile))
+            l_bResult = false;
+
+         // Замена файла кэша
+         if(l_bResult)
+            l_bResult = !rename(l_szTemp, in_pszPath);
+         if(!l_bResult)
+            unlink(l_szTemp);
+      }
+   }
+   return l_bResult;
+}
+
+#endif   // defined(IRIDIUM_LINUX_PLATFORM)
+
+/**
+   Поиск каталога устройства
+   на входе    :  in_pszHWID     - HWID устройства
+                  in_u32Version  - версия устройства
+                  in_u32Catalog  - хэш каталога из ответа на запрос информации об устройстве
+                  out_rSize      - ссылка куда нужно поместить размер данных каталога
+   на выходе   :  указатель на данные каталога, NULL - каталог не найден или устарел
+   примечание  :  устройство, которое не сообщает хэш каталога (in_u32Catalog == 0), всегда опрашивается заново
+*/
+const void* CIridiumCatalogCache::Find(const char* in_pszHWID, u32 in_u32Version, u32 in_u32Catalog, size_t& out_rSize)
+{
+   const void* l_pResult = NULL;
+
+   out_rSize = 0;
+   if(m_pImage && in_pszHWID && in_u32Catalog)
+   {
+      u32 l_u32Hash = GetHWIDHash(in_pszHWID);
+      u8* l_pPtr = m_pImage + IRIDIUM_CATALOG_CACHE_HEADER;
+      for(u16 i = 0; i < m_u16Count; i++)
+      {
+         u32 l_u32Size = 0;
+         u32 l_u32RecordHash = 0;
+         const char* l_pszHWID = NULL;
+         u8* l_pData = GetRecord(l_pPtr, l_u32Size, l_u32RecordHash, l_pszHWID);
+
+         if(l_u32RecordHash == l_u32Hash && !strcmp(l_pszHWID, in_pszHWID))
+         {
+            u32 l_u32Version = 0;
+            u32 l_u32Catalog = 0;
+            ReadU32LE(ReadU32LE(l_pPtr + 8, l_u32Version), l_u32Catalog);
+            // Запись устройства единственная, при несовпадении версии или хэша каталог устарел
+            if(l_u32Version == in_u32Version && l_u32Catalog == in_u32Catalog)
+            {
+               out_rSize = l_pPtr + l_u32Size - l_pData;
+               l_pResult = l_pData;
+            }
+            break;
+         }
+         l_pPtr += l_u32Size;
+      }
+   }
+   return l_pResult;
+}
+
+/**
+   Добавление каталога устройства в создаваемый образ
+   на входе    :  in_pszHWID     - HWID устройства
+                  in_u32Version  - версия устройства
+                  in_u32Catalog  - хэш каталога
+                  in_pData       - указатель на данные каталога
+                  in_stSize      - размер данных каталога
+   на выходе   :  успешность добавления, false - образ только для чтения или нет места
+   примечание  :  запись заменяемого каталога исключается при копировании старого образа (Copy)
+*/
+bool CIridiumCatalogCache::Add(const char* in_pszHWID, u32 in_u32Version, u32 in_u32Catalog, const void* in_pData, size_t in_stSize)
+{
+   bool l_bResult = false;
+
+   if(m_stMax && in_pszHWID && in_u32Catalog && m_u16Count < 0xFFFF)
+   {
+      size_t l_stHWID = strlen(in_pszHWID) + 1;
+      size_t l_stSize = IRIDIUM_CATALOG_CACHE_RECORD + l_stHWID + in_stSize;
+      if(l_stSize <= m_stMax - m_stSize)
+      {
+         u8* l_pPtr = m_pImage + m_stSize;
+         l_pPtr = WriteU32LE(l_pPtr, (u32)l_stSize);
+         l_pPtr = WriteU32LE(l_pPtr, GetHWIDHash(in_pszHWID));
+         l_pPtr = WriteU32LE(l_pPtr, in_u32Version);
+         l_pPtr = WriteU32LE(l_pPtr, in_u32Catalog);
+         memcpy(l_pPtr, in_pszHWID, l_stHWID);
+         if(in_stSize)
+            memcpy(l_pPtr + l_stHWID, in_pData, in_stSize);
+         m_stSize += l_stSize;
+         WriteU16LE(m_pImage + 6, ++m_u16Count);
+         l_bResult = true;
+      }
+   }
+   return l_bResult;
+}
+
+/**
+   Копирование записей другого образа
+   на входе    :  in_rSource  - ссылка на исходный образ
+                  in_pszExcept - HWID устройства, запись которого не копируется (NULL - копировать все)
+   на выходе   :  успешность копирования, false - образ только для чтения или нет места
+*/
+bool CIridiumCatalogCache::Copy(CIridiumCatalogCache& in_rSource, const char* in_pszExcept)
+{
+   bool l_bResult = (m_stMax != 0);
+
+   if(l_bResult && in_rSource.m_pImage)
+   {
+      u8* l_pPtr = in_rSource.m_pImage + IRIDIUM_CATALOG_CACHE_HEADER;
+      for(u16 i = 0; l_bResult && i < in_rSource.m_u16Count; i++)
+      {
+         u32 l_u32Size = 0;
+         u32 l_u32Hash = 0;
+         const char* l_pszHWID = NULL;
+         GetRecord(l_pPtr, l_u32Size, l_u32Hash, l_pszHWID);
+
+         if(!in_pszExcept || strcmp(l_pszHWID, in_pszExcept))
+         {
+            // Запись копируется целиком, без повторного расчета хэша HWID
+            l_bResult = (l_u32Size <= m_stMax - m_stSize && m_u16Count < 0xFFFF);
+            if(l_bResult)
+            {
+               memcpy(m_pImage + m_stSize, l_pPtr, l_u32Size);
+               m_stSize += l_u32Size;
+               WriteU16LE(m_pImage + 6, ++m_u16Count);
+            }
+         }
+         l_pPtr += l_u32Size;
+      }
+   }
+   return l_bResult;
+}
+
+/**
+   Получение хэша HWID для быстрого сравнения записей
+   на входе    :  in_pszHWID  - HWID устройства
+   на выходе   :  хэш HWID
+*/
+u32 CIridiumCatalogCache::GetHWIDHash(const char* in_pszHWID)
+{
+   return GetHash32(IRIDIUM_HASH32_INIT, in_pszHWID, strlen(in_pszHWID) + 1);
+}
+
+/**
+   Разбор заголовка записи
+   на входе    :  in_pRecord  - указатель на запись
+                  out_rSize   - ссылка куда нужно поместить размер записи
+                  out_rHash   - ссылка куда нужно поместить хэш HWID
+                  out_rHWID   - ссылка куда нужно поместить указатель на HWID
+   на выходе   :  указатель на данные каталога
+*/
+u8* CIridiumCatalogCache::GetRecord(u8* in_pRecord, u32& out_rSize, u32& out_rHash, const char*& out_rHWID)
+{
+   u8* l_pPtr = ReadU32LE(in_pRecord, out_rSize);
+   ReadU32LE(l_pPtr, out_rHash);
+   out_rHWID = (const char*)(in_pRecord + IRIDIUM_CATALOG_CACHE_RECORD);
+   return (u8*)out_rHWID + strlen(out_rHWID) + 1;
+}
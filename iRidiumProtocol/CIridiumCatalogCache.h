@@ -0,0 +1,84 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+#ifndef _C_IRIDIUM_CATALOG_CACHE_H_INCLUDED_
+#define _C_IRIDIUM_CATALOG_CACHE_H_INCLUDED_
+
+// Включения
+#include "Iridium.h"
+
+#define IRIDIUM_CATALOG_CACHE_MAGIC       0x54414349  // Сигнатура образа кэша каталогов ("ICAT")
+#define IRIDIUM_CATALOG_CACHE_VERSION     1           // Версия формата образа
+#define IRIDIUM_CATALOG_CACHE_HEADER      8           // Размер заголовка образа
+#define IRIDIUM_CATALOG_CACHE_RECORD      16          // Размер заголовка записи (без HWID и данных каталога)
+
+//////////////////////////////////////////////////////////////////////////
+// class CIridiumCatalogCache
+//////////////////////////////////////////////////////////////////////////
+// Кэш каталогов устройств для ведущего. Каталог (списки и описания каналов в формате приложения) хранится
+// вместе с HWID, версией устройства и хэшем каталога из ответа на запрос информации об устройстве. Если все
+// три значения совпадают, ведущий берет каталог из кэша и не запрашивает списки и описания каналов.
+// Образ кэша плоский: заголовок (сигнатура, версия формата, количество записей) и записи (размер записи,
+// хэш HWID, версия, хэш каталога, HWID с завершающим нулем, данные каталога), все значения LE. Образ
+// не требует разбора и может использоваться непосредственно из отображенного в память файла, при
+// изменении каталогов новый образ собирается в буфере копированием неизменных записей и сохраняется
+// в файл заменой предыдущего
+class CIridiumCatalogCache
+{
+public:
+   // Конструктор/деструктор
+   CIridiumCatalogCache();
+   ~CIridiumCatalogCache();
+
+   // Подключение готового образа только для чтения
+   bool Open(const void* in_pImage, size_t in_stSize);
+   // Создание пустого образа в буфере
+   bool Create(void* in_pBuffer, size_t in_stSize);
+   // Отключение образа
+   void Close();
+#if defined(IRIDIUM_LINUX_PLATFORM)
+   // Отображение файла кэша в память только для чтения
+   bool MapFile(const char* in_pszPath);
+   // Сохранение образа в файл
+   bool SaveFile(const char* in_pszPath);
+#endif
+
+   // Поиск каталога устройства
+   const void* Find(const char* in_pszHWID, u32 in_u32Version, u32 in_u32Catalog, size_t& out_rSize);
+   // Добавление каталога устройства в создаваемый образ
+   bool Add(const char* in_pszHWID, u32 in_u32Version, u32 in_u32Catalog, const void* in_pData, size_t in_stSize);
+   // Копирование записей другого образа, кроме записи устройства с указанным HWID
+   bool Copy(CIridiumCatalogCache& in_rSource, const char* in_pszExcept);
+
+   // Получение данных образа для сохранения
+   const void* GetImage() const
+      { return m_pImage; }
+   size_t GetSize() const
+      { return m_stSize; }
+   u16 GetCount() const
+      { return m_u16Count; }
+
+protected:
+   u32 GetHWIDHash(const char* in_pszHWID);
+   u8* GetRecord(u8* in_pRecord, u32& out_rSize, u32& out_rHash, const char*& out_rHWID);
+
+private:
+   u8*                     m_pImage;               // Указатель на образ
+   size_t                  m_stSize;               // Размер данных образа
+   size_t                  m_stMax;                // Размер буфера образа (0 - образ только для чтения)
+   u16                     m_u16Count;             // Количество записей
+   size_t                  m_stMapped;             // Размер отображенного в память файла (0 - образ не отображен)
+};
+#endif   // _C_IRIDIUM_CATALOG_CACHE_H_INCLUDED_
@@ -0,0 +1,160 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+#include "CIridiumFirmwareStream.h"
+#include "CIridiumCipherGrasshopper.h"
+#include "IridiumCRC16.h"
+#include "Bytes.h"
+
+/**
+   Конструктор класса
+   на входе    :  *
+*/
+CIridiumFirmwareStream::CIridiumFirmwareStream()
+{
+   Start(0);
+}
+
+/**
+   Деструктор класса
+*/
+CIridiumFirmwareStream::~CIridiumFirmwareStream()
+{
+}
+
+/**
+   Подготовка зашифрованного потока прошивки
+   на входе    :  in_pImage      - указатель на образ прошивки
+                  in_stSize      - размер образа прошивки
+                  in_u8Format    - формат потока (IRIDIUM_FIRMWARE_FORMAT_RAW или IRIDIUM_FIRMWARE_FORMAT_LZ)
+                  in_u8Random    - случайное число для первого байта заголовка
+                  in_pKeyAndIV   - указатель на ключ и вектор инициализации шифра загрузчика
+                  out_pBuffer    - указатель на буфер куда нужно поместить поток
+                  in_stMaxSize   - размер буфера, достаточно GetMaxSize(in_stSize)
+   на выходе   :  размер потока (кратен BLOCK_CIPHER_SIZE), 0 - ошибка параметров или буфер мал
+   примечание  :  поток передается загрузчику потоком записи как есть, блоками кратными BLOCK_CIPHER_SIZE
+*/
+size_t CIridiumFirmwareStream::Encode(const void* in_pImage, size_t in_stSize, u8 in_u8Format, u8 in_u8Random, const u8* in_pKeyAndIV, void* out_pBuffer, size_t in_stMaxSize)
+{
+   CIridiumCipherGrasshopper l_Cipher;
+   u8* l_pBuffer = (u8*)out_pBuffer;
+   size_t l_stResult = 0;
+   size_t l_stSize = 0;
+
+   if(in_pImage && in_stSize && in_pKeyAndIV && out_pBuffer && in_stMaxSize >= IRIDIUM_FIRMWARE_HEADER_SIZE)
+   {
+      // Заголовок
+      l_pBuffer = WriteU8(l_pBuffer, in_u8Random);
+      l_pBuffer = WriteU8(l_pBuffer, in_u8Format);
+      l_pBuffer = WriteU32LE(l_pBuffer, (u32)in_stSize);
+      l_pBuffer = WriteU16LE(l_pBuffer, GetCRC16Modbus(IRIDIUM_FIRMWARE_CRC16_INIT, (const u8*)in_pImage, in_stSize));
+
+      // Образ
+      if(in_u8Format == IRIDIUM_FIRMWARE_FORMAT_LZ)
+         l_stSize = CIridiumLZ::Encode(in_pImage, in_stSize, l_pBuffer, in_stMaxSize - IRIDIUM_FIRMWARE_HEADER_SIZE);
+      else if(in_u8Format == IRIDIUM_FIRMWARE_FORMAT_RAW && in_stSize <= in_stMaxSize - IRIDIUM_FIRMWARE_HEADER_SIZE)
+      {
+         memcpy(l_pBuffer, in_pImage, in_stSize);
+         l_stSize = in_stSize;
+      }
+
+      // Шифрование потока целиком, хвост последнего блока шифра дополняется шифром
+      if(l_stSize)
+      {
+         l_stResult = in_stMaxSize;
+#if defined(IRIDIUM_ENABLE_IV)
+         l_Cipher.EnableIV(true);
+#endif
+         l_Cipher.Init(in_pKeyAndIV);
+         if(!l_Cipher.Encode((u8*)out_pBuffer, IRIDIUM_FIRMWARE_HEADER_SIZE + l_stSize, l_stResult))
+            l_stResult = 0;
+      }
+   }
+   return l_stResult;
+}
+
+/**
+   Чтение заголовка расшифрованного потока
+   на входе    :  in_pBuffer  - указатель на начало расшифрованного потока
+                  out_rFormat - ссылка куда нужно поместить формат потока
+                  out_rSize   - ссылка куда нужно поместить размер образа прошивки
+                  out_rCRC    - ссылка куда нужно поместить CRC16 образа прошивки
+   на выходе   :  указатель на данные образа после заголовка
+*/
+const u8* CIridiumFirmwareStream::ReadHeader(const u8* in_pBuffer, u8& out_rFormat, u32& out_rSize, u16& out_rCRC)
+{
+   u8* l_pBuffer = (u8*)in_pBuffer;
+
+   // Случайное число пропускается
+   l_pBuffer = ReadU8(l_pBuffer, out_rFormat);
+   l_pBuffer = ReadU8(l_pBuffer, out_rFormat);
+   l_pBuffer = ReadU32LE(l_pBuffer, out_rSize);
+   l_pBuffer = ReadU16LE(l_pBuffer, out_rCRC);
+   return l_pBuffer;
+}
+
+/**
+   Начало распаковки сжатого образа
+   на входе    :  in_u32Size  - размер образа прошивки из заголовка
+   на выходе   :  *
+*/
+void CIridiumFirmwareStream::Start(u32 in_u32Size)
+{
+   m_Decoder.Reset();
+   m_u32Left = in_u32Size;
+   m_stChunk = 0;
+}
+
+/**
+   Распаковка очередной части сжатого образа и запись
+   на входе    :  in_pBuffer  - указатель на сжатые данные
+                  in_stSize   - размер сжатых данных
+                  in_pWrite   - функция записи распакованных данных
+   на выходе   :  *
+   примечание  :  распакованные данные накапливаются в буфере, чтобы запись (например во флеш полусловами)
+                  шла частями IRIDIUM_FIRMWARE_LZ_CHUNK байт. Распаковка прекращается на размере образа из
+                  заголовка, остаток (выравнивание шифра) отбрасывается. Последняя часть дополняется 0xFF до
+                  4 байт, чтобы образ можно было проверять словами
+*/
+void CIridiumFirmwareStream::Write(const u8* in_pBuffer, size_t in_stSize, firmware_write_t in_pWrite)
+{
+   while(in_stSize && m_u32Left)
+   {
+      // Распаковка в свободное место буфера, но не дальше конца образа
+      size_t l_stUsed = 0;
+      size_t l_stMax = sizeof(m_aChunk) - m_stChunk;
+      if(l_stMax > m_u32Left)
+         l_stMax = m_u32Left;
+      size_t l_stOut = m_Decoder.Decode(in_pBuffer, in_stSize, l_stUsed, m_aChunk + m_stChunk, l_stMax);
+      in_pBuffer += l_stUsed;
+      in_stSize -= l_stUsed;
+      m_stChunk += l_stOut;
+      m_u32Left -= (u32)l_stOut;
+
+      if(!m_u32Left)
+      {
+         // Конец образа
+         while(m_stChunk & 3)
+            m_aChunk[m_stChunk++] = 0xFF;
+         in_pWrite(m_aChunk, m_stChunk);
+         m_stChunk = 0;
+      } else if(m_stChunk == sizeof(m_aChunk))
+      {
+         // Буфер заполнен
+         in_pWrite(m_aChunk, m_stChunk);
+         m_stChunk = 0;
+      }
+   }
+}
@@ -0,0 +1,72 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+#ifndef _C_IRIDIUM_FIRMWARE_STREAM_H_INCLUDED_
+#define _C_IRIDIUM_FIRMWARE_STREAM_H_INCLUDED_
+
+// Включения
+#include "Iridium.h"
+#include "CIridiumCipher.h"
+#include "CIridiumLZ.h"
+
+// Формат потока прошивки (изменение делает поток несовместимым с загрузчиками)
+#define IRIDIUM_FIRMWARE_HEADER_SIZE      8           // Размер заголовка (случайное число, формат, размер, CRC16)
+#define IRIDIUM_FIRMWARE_FORMAT_RAW       0x77        // Образ прошивки без сжатия
+#define IRIDIUM_FIRMWARE_FORMAT_LZ        0x78        // Образ прошивки сжат CIridiumLZ
+#define IRIDIUM_FIRMWARE_CRC16_INIT       0x77        // Начальное значение CRC16 образа прошивки
+
+// Размер буфера распакованных данных перед записью (кратен 4)
+#ifndef IRIDIUM_FIRMWARE_LZ_CHUNK
+#define IRIDIUM_FIRMWARE_LZ_CHUNK         64
+#endif
+
+// Запись распакованных данных прошивки с текущей позиции
+typedef void (*firmware_write_t)(u8* in_pBuffer, size_t in_stSize);
+
+//////////////////////////////////////////////////////////////////////////
+// class CIridiumFirmwareStream
+//////////////////////////////////////////////////////////////////////////
+// Поток прошивки для загрузчика: заголовок IRIDIUM_FIRMWARE_HEADER_SIZE байт (случайное число, формат, размер
+// и CRC16 образа LE) и образ без сжатия или сжатый CIridiumLZ, все вместе зашифровано "Кузнечиком" в режиме
+// CBC. Encode готовит поток целиком на стороне ведущего (или утилиты подготовки прошивки), загрузчик
+// расшифровывает блоки потока, читает заголовок ReadHeader и передает сжатые данные в Write
+class CIridiumFirmwareStream
+{
+public:
+   // Конструктор/деструктор
+   CIridiumFirmwareStream();
+   ~CIridiumFirmwareStream();
+
+   // Подготовка зашифрованного потока прошивки
+   static size_t Encode(const void* in_pImage, size_t in_stSize, u8 in_u8Format, u8 in_u8Random, const u8* in_pKeyAndIV, void* out_pBuffer, size_t in_stMaxSize);
+   // Размер буфера потока в худшем случае
+   static size_t GetMaxSize(size_t in_stSize)
+      { return (IRIDIUM_FIRMWARE_HEADER_SIZE + in_stSize + (in_stSize + 7) / 8 + BLOCK_CIPHER_SIZE) & ~(BLOCK_CIPHER_SIZE - 1); }
+
+   // Чтение заголовка расшифрованного потока
+   static const u8* ReadHeader(const u8* in_pBuffer, u8& out_rFormat, u32& out_rSize, u16& out_rCRC);
+
+   // Начало распаковки сжатого образа
+   void Start(u32 in_u32Size);
+   // Распаковка очередной части сжатого образа и запись
+   void Write(const u8* in_pBuffer, size_t in_stSize, firmware_write_t in_pWrite);
+
+private:
+   CIridiumLZ              m_Decoder;              // Распаковка образа
+   u32                     m_u32Left;              // Количество байт образа, которые осталось распаковать
+   u8                      m_aChunk[IRIDIUM_FIRMWARE_LZ_CHUNK]; // Распакованные данные, ожидающие записи
+   size_t                  m_stChunk;              // Количество байт в буфере распакованных данных
+};
+#endif   // _C_IRIDIUM_FIRMWARE_STREAM_H_INCLUDED_
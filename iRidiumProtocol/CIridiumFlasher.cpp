@@ -0,0 +1,553 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+#include "CIridiumFlasher.h"
+#include "IridiumCRC16.h"
+
+#if defined(IRIDIUM_ENABLE_STREAM_WINDOW) && defined(IRIDIUM_CONFIG_STREAM_OPEN_MASTER) && defined(IRIDIUM_CONFIG_STREAM_BLOCK_MASTER) && defined(IRIDIUM_CONFIG_STREAM_CLOSE_MASTER)
+
+#if defined(IRIDIUM_LINUX_PLATFORM)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/**
+   Конструктор класса
+   на входе    :  *
+*/
+CIridiumFlasher::CIridiumFlasher()
+{
+   m_pProtocol = NULL;
+   m_pImage = NULL;
+   m_stImage = 0;
+   m_u16BlockSize = 0;
+   m_u32Blocks = 0;
+   m_bMapped = false;
+   m_stDevices = 0;
+   m_u32Time = 0;
+}
+
+/**
+   Деструктор класса
+*/
+CIridiumFlasher::~CIridiumFlasher()
+{
+   CloseImage();
+}
+
+/**
+   Подключение протокола
+   на входе    :  in_pProtocol   - указатель на протокол, через который прошиваются устройства
+   на выходе   :  *
+*/
+void CIridiumFlasher::Init(CIridiumProtocol* in_pProtocol)
+{
+   m_pProtocol = in_pProtocol;
+}
+
+/**
+   Подключение образа прошивки
+   на входе    :  in_pImage       - указатель на образ прошивки
+                  in_stSize       - размер образа
+                  in_u16BlockSize - размер блока (0 - IRIDIUM_FLASHER_BLOCK_SIZE)
+   на выходе   :  успешность
+   примечание  :  данные не копируются и должны быть доступны до окончания прошивки
+*/
+bool CIridiumFlasher::SetImage(const void* in_pImage, size_t in_stSize, u16 in_u16BlockSize)
+{
+   bool l_bResult = false;
+
+   CloseImage();
+   if(!in_u16BlockSize)
+      in_u16BlockSize = IRIDIUM_FLASHER_BLOCK_SIZE;
+   if(in_pImage && in_stSize)
+   {
+      m_pImage = (const u8*)in_pImage;
+      m_stImage = in_stSize;
+      m_u16BlockSize = in_u16BlockSize;
+      m_u32Blocks = (u32)((in_stSize + in_u16BlockSize - 1) / in_u16BlockSize);
+      l_bResult = true;
+   }
+   return l_bResult;
+}
+
+#if defined(IRIDIUM_LINUX_PLATFORM)
+
+/**
+   Отображение файла образа прошивки в память
+   на входе    :  in_pszPath      - путь к файлу образа
+                  in_u16BlockSize - размер блока (0 - IRIDIUM_FLASHER_BLOCK_SIZE)
+   на выходе   :  успешность
+   примечание  :  файл отображается только для чтения и используется всеми устройствами без копирования
+*/
+bool CIridiumFlasher::MapImage(const char* in_pszPath, u16 in_u16BlockSize)
+{
+   bool l_bResult = false;
+   struct stat l_Stat;
+
+   CloseImage();
+   int l_iFile = open(in_pszPath, O_RDONLY);
+   if(l_iFile >= 0)
+   {
+      if(!fstat(l_iFile, &l_Stat) && l_Stat.st_size > 0)
+      {
+         void* l_pImage = mmap(NULL, (size_t)l_Stat.st_size, PROT_READ, MAP_PRIVATE, l_iFile, 0);
+         if(l_pImage != MAP_FAILED)
+         {
+            l_bResult = SetImage(l_pImage, (size_t)l_Stat.st_size, in_u16BlockSize);
+            if(l_bResult)
+               m_bMapped = true;
+            else
+               munmap(l_pImage, (size_t)l_Stat.st_size);
+         }
+      }
+      close(l_iFile);
+   }
+   return l_bResult;
+}
+
+#endif   // defined(IRIDIUM_LINUX_PLATFORM)
+
+/**
+   Отключение образа прошивки
+   на входе    :  *
+   на выходе   :  *
+*/
+void CIridiumFlasher::CloseImage()
+{
+#if defined(IRIDIUM_LINUX_PLATFORM)
+   if(m_bMapped)
+      munmap((void*)m_pImage, m_stImage);
+#endif
+   m_bMapped = false;
+   m_pImage = NULL;
+   m_stImage = 0;
+   m_u16BlockSize = 0;
+   m_u32Blocks = 0;
+}
+
+/**
+   Добавление устройства в список прошивки
+   на входе    :  in_Addr     - адрес устройства
+                  in_u32PIN   - PIN код записи потока
+   на выходе   :  успешность
+*/
+bool CIridiumFlasher::Add(iridium_address_t in_Addr, u32 in_u32PIN)
+{
+   bool l_bResult = false;
+
+   if(m_stDevices < IRIDIUM_FLASHER_MAX_DEVICES)
+   {
+      iridium_flash_device_t& l_rDevice = m_aDevices[m_stDevices++];
+      memset(&l_rDevice, 0, sizeof(l_rDevice));
+      l_rDevice.m_Addr = in_Addr;
+      l_rDevice.m_u32PIN = in_u32PIN;
+      l_rDevice.m_eState = IRIDIUM_FLASH_WAIT;
+      l_bResult = true;
+   }
+   return l_bResult;
+}
+
+/**
+   Очистка списка устройств
+   на входе    :  *
+   на выходе   :  *
+   примечание  :  окна передачи прошиваемых устройств закрываются
+*/
+void CIridiumFlasher::Clear()
+{
+   for(size_t i = 0; i < m_stDevices; i++)
+   {
+      if(m_aDevices[i].m_eState == IRIDIUM_FLASH_OPEN || m_aDevices[i].m_eState == IRIDIUM_FLASH_WRITE)
+         Fail(m_aDevices[i]);
+   }
+   m_stDevices = 0;
+}
+
+/**
+   Проверка наличия устройств, прошивка которых не окончена
+   на входе    :  *
+   на выходе   :  true - есть устройства ожидающие очереди или прошиваемые
+*/
+bool CIridiumFlasher::IsActive() const
+{
+   bool l_bResult = false;
+
+   for(size_t i = 0; !l_bResult && i < m_stDevices; i++)
+      l_bResult = (m_aDevices[i].m_eState != IRIDIUM_FLASH_DONE && m_aDevices[i].m_eState != IRIDIUM_FLASH_FAILED);
+   return l_bResult;
+}
+
+/**
+   Обработка прошивки
+   на входе    :  in_u32Time  - монотонное время платформы в миллисекундах
+   на выходе   :  *
+   примечание  :  контроль времени ответов, запуск очередных устройств, отправка блоков загрузчикам без
+                  окна и вызов ProcessStream протокола для потоков открытых окном
+*/
+void CIridiumFlasher::Process(u32 in_u32Time)
+{
+   bool l_bStart = (m_pProtocol && m_pImage);
+   size_t l_stActive = 0;
+   const void* l_pBlock = NULL;
+   u16 l_u16Size = 0;
+
+   m_u32Time = in_u32Time;
+
+   // Контроль времени
+   for(size_t i = 0; i < m_stDevices; i++)
+   {
+      iridium_flash_device_t& l_rDevice = m_aDevices[i];
+      switch(l_rDevice.m_eState)
+      {
+         case IRIDIUM_FLASH_OPEN:
+            // Повтор запроса открытия потока
+            if((u32)(in_u32Time - l_rDevice.m_u32Time) >= IRIDIUM_FLASHER_OPEN_TIME)
+            {
+               if(l_rDevice.m_u8Retries < IRIDIUM_FLASHER_RETRIES)
+                  Open(l_rDevice);
+               else
+                  Fail(l_rDevice);
+            }
+            break;
+
+         case IRIDIUM_FLASH_WRITE:
+            // Загрузчик закрывает поток, если блоки не приходят IRIDIUM_FLASHER_WAIT_TIME
+            if((u32)(in_u32Time - l_rDevice.m_u32Progress) >= IRIDIUM_FLASHER_WAIT_TIME)
+               Fail(l_rDevice);
+            else if(!l_rDevice.m_u8Window && l_rDevice.m_bWait && (u32)(in_u32Time - l_rDevice.m_u32Time) >= IRIDIUM_FLASHER_REPLY_TIME)
+               Fail(l_rDevice);
+            else if((u32)(in_u32Time - l_rDevice.m_u32Progress) >= IRIDIUM_FLASHER_WAIT_TIME / 2)
+               l_bStart = false;
+            break;
+
+         case IRIDIUM_FLASH_CLOSE:
+            // Все блоки подтверждены, без ответа на закрытие загрузчик закроет поток сам
+            if((u32)(in_u32Time - l_rDevice.m_u32Time) >= IRIDIUM_FLASHER_REPLY_TIME)
+            {
+               if(l_rDevice.m_u8Retries < IRIDIUM_FLASHER_RETRIES)
+                  Close(l_rDevice);
+               else
+                  l_rDevice.m_eState = IRIDIUM_FLASH_DONE;
+            }
+            break;
+
+         default:
+            break;
+      }
+      if(l_rDevice.m_eState == IRIDIUM_FLASH_OPEN || l_rDevice.m_eState == IRIDIUM_FLASH_WRITE || l_rDevice.m_eState == IRIDIUM_FLASH_CLOSE)
+         l_stActive++;
+   }
+
+   // Запуск очередных устройств
+   for(size_t i = 0; l_bStart && l_stActive < IRIDIUM_FLASHER_MAX_ACTIVE && i < m_stDevices; i++)
+   {
+      if(m_aDevices[i].m_eState == IRIDIUM_FLASH_WAIT)
+      {
+         m_aDevices[i].m_u8Retries = 0;
+         Open(m_aDevices[i]);
+         l_stActive++;
+      }
+   }
+
+   if(m_pProtocol)
+   {
+      // Отправка блоков загрузчикам без окна
+      for(size_t i = 0; i < m_stDevices; i++)
+      {
+         iridium_flash_device_t& l_rDevice = m_aDevices[i];
+         if(l_rDevice.m_eState == IRIDIUM_FLASH_WRITE && !l_rDevice.m_u8Window && !l_rDevice.m_bWait && GetBlock(l_rDevice.m_u32Offset, l_rDevice.m_u32Blocks, l_pBlock, l_u16Size))
+         {
+            if(!m_pProtocol->SendStreamBlockRequest(l_rDevice.m_Addr, l_rDevice.m_u8StreamID, (u8)l_rDevice.m_u32Blocks, l_u16Size, l_pBlock))
+               break;
+            l_rDevice.m_bWait = true;
+            l_rDevice.m_u32Time = in_u32Time;
+         }
+      }
+      // Отправка блоков потоков открытых окном
+      m_pProtocol->ProcessStream(in_u32Time);
+   }
+}
+
+/**
+   Обработка ответа на запрос открытия потока
+   на входе    :  in_SrcAddr     - адрес устройства
+                  in_u8StreamID  - идентификатор открытого потока (0 - поток не открыт)
+   на выходе   :  *
+   примечание  :  если поток не открыт, запрос повторяется по истечении времени ожидания
+*/
+void CIridiumFlasher::StreamOpenResult(iridium_address_t in_SrcAddr, u8 in_u8StreamID)
+{
+   iridium_flash_device_t* l_pDevice = Find(in_SrcAddr, 0);
+
+   if(l_pDevice && l_pDevice->m_eState == IRIDIUM_FLASH_OPEN && in_u8StreamID)
+   {
+      l_pDevice->m_eState = IRIDIUM_FLASH_WRITE;
+      l_pDevice->m_u8StreamID = in_u8StreamID;
+      l_pDevice->m_u8Window = m_pProtocol->GetStreamWindow(in_SrcAddr, in_u8StreamID);
+      l_pDevice->m_u8Retries = 0;
+      l_pDevice->m_bWait = false;
+      l_pDevice->m_u32Blocks = 0;
+      l_pDevice->m_u32Progress = m_u32Time;
+      l_pDevice->m_bRestart = false;
+   }
+}
+
+/**
+   Обработка ответа на запрос передачи блока
+   на входе    :  in_SrcAddr     - адрес устройства
+                  in_u8StreamID  - идентификатор потока
+                  in_u8BlockID   - идентификатор блока (для окна - последний блок подтвержденный по порядку)
+                  in_stSize      - количество обработанных данных (0 - ошибка записи блока)
+   на выходе   :  *
+*/
+void CIridiumFlasher::StreamBlockResult(iridium_address_t in_SrcAddr, u8 in_u8StreamID, u8 in_u8BlockID, size_t in_stSize)
+{
+   iridium_flash_device_t* l_pDevice = Find(in_SrcAddr, in_u8StreamID);
+
+   if(l_pDevice && l_pDevice->m_eState == IRIDIUM_FLASH_WRITE)
+   {
+      if(!in_stSize)
+         Fail(*l_pDevice);
+      else if(l_pDevice->m_u8Window)
+      {
+         // Подтверждение окна
+         l_pDevice->m_u32Blocks = m_pProtocol->GetStreamProgress(in_SrcAddr, in_u8StreamID);
+         l_pDevice->m_u32Progress = m_u32Time;
+      } else if(l_pDevice->m_bWait && in_u8BlockID == (u8)l_pDevice->m_u32Blocks)
+      {
+         // Подтверждение блока без окна
+         l_pDevice->m_bWait = false;
+         l_pDevice->m_u32Blocks++;
+         l_pDevice->m_u32Progress = m_u32Time;
+         if(l_pDevice->m_u32Blocks == GetBlocks(*l_pDevice))
+         {
+            l_pDevice->m_u8Retries = 0;
+            Close(*l_pDevice);
+         }
+      }
+   }
+}
+
+/**
+   Получение блока прошивки для потока открытого окном
+   на входе    :  in_DstAddr     - адрес устройства
+                  in_u8StreamID  - идентификатор потока
+                  in_u32Index    - порядковый номер блока
+                  out_rBlock     - ссылка куда нужно поместить указатель на данные блока
+                  out_rSize      - ссылка куда нужно поместить размер блока
+   на выходе   :  true - блок есть, false - образ закончился
+*/
+bool CIridiumFlasher::StreamGetBlock(iridium_address_t in_DstAddr, u8 in_u8StreamID, u32 in_u32Index, const void*& out_rBlock, u16& out_rSize)
+{
+   bool l_bResult = false;
+   iridium_flash_device_t* l_pDevice = Find(in_DstAddr, in_u8StreamID);
+
+   if(l_pDevice && l_pDevice->m_eState == IRIDIUM_FLASH_WRITE)
+      l_bResult = GetBlock(l_pDevice->m_u32Offset, in_u32Index, out_rBlock, out_rSize);
+   return l_bResult;
+}
+
+/**
+   Обработка окончания передачи потока открытого окном
+   на входе    :  in_DstAddr     - адрес устройства
+                  in_u8StreamID  - идентификатор потока
+                  in_bSuccess    - все блоки подтверждены
+   на выходе   :  *
+*/
+void CIridiumFlasher::StreamComplete(iridium_address_t in_DstAddr, u8 in_u8StreamID, bool in_bSuccess)
+{
+   iridium_flash_device_t* l_pDevice = Find(in_DstAddr, in_u8StreamID);
+
+   if(l_pDevice && l_pDevice->m_eState == IRIDIUM_FLASH_WRITE)
+   {
+      if(in_bSuccess)
+      {
+         l_pDevice->m_u32Blocks = GetBlocks(*l_pDevice);
+         l_pDevice->m_u8Retries = 0;
+         Close(*l_pDevice);
+      } else
+         Fail(*l_pDevice);
+   }
+}
+
+/**
+   Обработка закрытия потока устройством или ответа на запрос закрытия
+   на входе    :  in_SrcAddr     - адрес устройства
+                  in_u8StreamID  - идентификатор потока
+   на выходе   :  *
+   примечание  :  загрузчик закрывает поток сам, если блоки не приходят FIRMWARE_WAIT_TIME
+*/
+void CIridiumFlasher::StreamClose(iridium_address_t in_SrcAddr, u8 in_u8StreamID)
+{
+   iridium_flash_device_t* l_pDevice = Find(in_SrcAddr, in_u8StreamID);
+
+   if(l_pDevice)
+   {
+      if(l_pDevice->m_eState == IRIDIUM_FLASH_CLOSE)
+         l_pDevice->m_eState = IRIDIUM_FLASH_DONE;
+      else if(l_pDevice->m_eState == IRIDIUM_FLASH_WRITE)
+         Fail(*l_pDevice);
+   }
+}
+
+#if defined(IRIDIUM_ENABLE_STREAM_RESUME)
+
+/**
+   Обработка точки продолжения записи, сохраненной загрузчиком
+   на входе    :  in_SrcAddr     - адрес устройства
+                  in_u8StreamID  - идентификатор открытого потока
+                  in_u32Offset   - смещение в потоке, с которого загрузчик ожидает данные
+                  in_u16CRC      - CRC16 данных потока, принятых загрузчиком до смещения
+   на выходе   :  *
+   примечание  :  если данные до смещения не совпадают с образом (прерывалась загрузка другого образа), поток
+                  закрывается и устройство прошивается заново без запроса точки продолжения
+*/
+void CIridiumFlasher::StreamResumeResult(iridium_address_t in_SrcAddr, u8 in_u8StreamID, u32 in_u32Offset, u16 in_u16CRC)
+{
+   iridium_flash_device_t* l_pDevice = Find(in_SrcAddr, 0);
+
+   if(l_pDevice && l_pDevice->m_eState == IRIDIUM_FLASH_OPEN)
+   {
+      if(in_u32Offset < m_stImage && GetCRC16Modbus(IRIDIUM_STREAM_RESUME_CRC_INIT, m_pImage, in_u32Offset) == in_u16CRC)
+         l_pDevice->m_u32Offset = in_u32Offset;
+      else
+      {
+         // Закрытие потока и повтор прошивки с начала
+         m_pProtocol->CloseStreamWindow(in_SrcAddr);
+         m_pProtocol->SendStreamCloseRequest(in_SrcAddr, in_u8StreamID);
+         l_pDevice->m_eState = IRIDIUM_FLASH_WAIT;
+         l_pDevice->m_bRestart = true;
+      }
+   }
+}
+
+#endif   // defined(IRIDIUM_ENABLE_STREAM_RESUME)
+
+/**
+   Поиск прошиваемого устройства
+   на входе    :  in_Addr        - адрес устройства
+                  in_u8StreamID  - идентификатор потока (0 - любой)
+   на выходе   :  указатель на устройство, NULL - устройство не найдено
+*/
+iridium_flash_device_t* CIridiumFlasher::Find(iridium_address_t in_Addr, u8 in_u8StreamID)
+{
+   iridium_flash_device_t* l_pResult = NULL;
+
+   for(size_t i = 0; !l_pResult && i < m_stDevices; i++)
+   {
+      iridium_flash_device_t& l_rDevice = m_aDevices[i];
+      if(l_rDevice.m_Addr == in_Addr && (!in_u8StreamID || l_rDevice.m_u8StreamID == in_u8StreamID) &&
+         (l_rDevice.m_eState == IRIDIUM_FLASH_OPEN || l_rDevice.m_eState == IRIDIUM_FLASH_WRITE || l_rDevice.m_eState == IRIDIUM_FLASH_CLOSE))
+         l_pResult = &l_rDevice;
+   }
+   return l_pResult;
+}
+
+/**
+   Получение количества блоков, передаваемых устройству
+   на входе    :  in_rDevice  - ссылка на устройство
+   на выходе   :  количество блоков от смещения устройства до конца образа
+*/
+u32 CIridiumFlasher::GetBlocks(const iridium_flash_device_t& in_rDevice) const
+{
+   u32 l_u32Result = 0;
+
+   if(in_rDevice.m_u32Offset < m_stImage)
+      l_u32Result = (u32)((m_stImage - in_rDevice.m_u32Offset + m_u16BlockSize - 1) / m_u16BlockSize);
+   return l_u32Result;
+}
+
+/**
+   Получение блока образа
+   на входе    :  in_u32Offset   - смещение в образе, с которого передаются блоки
+                  in_u32Index    - порядковый номер блока от смещения
+                  out_rBlock     - ссылка куда нужно поместить указатель на данные блока
+                  out_rSize      - ссылка куда нужно поместить размер блока
+   на выходе   :  true - блок есть, false - образ закончился
+*/
+bool CIridiumFlasher::GetBlock(u32 in_u32Offset, u32 in_u32Index, const void*& out_rBlock, u16& out_rSize)
+{
+   bool l_bResult = false;
+   size_t l_stOffset = in_u32Offset + (size_t)in_u32Index * m_u16BlockSize;
+
+   if(l_stOffset < m_stImage)
+   {
+      size_t l_stSize = m_stImage - l_stOffset;
+      out_rBlock = m_pImage + l_stOffset;
+      out_rSize = (u16)((l_stSize < m_u16BlockSize) ? l_stSize : m_u16BlockSize);
+      l_bResult = true;
+   }
+   return l_bResult;
+}
+
+/**
+   Отправка запроса открытия потока прошивки
+   на входе    :  in_rDevice  - ссылка на устройство
+   на выходе   :  *
+   примечание  :  прошивка устройства получив запрос перезагружается в загрузчик, ответ отправляет загрузчик.
+                  Если очередь отправки занята блоками, запрос повторяется при следующем вызове Process
+*/
+void CIridiumFlasher::Open(iridium_flash_device_t& in_rDevice)
+{
+   in_rDevice.m_eState = IRIDIUM_FLASH_OPEN;
+   in_rDevice.m_u8StreamID = 0;
+   in_rDevice.m_u8Window = 0;
+   in_rDevice.m_u32Offset = 0;
+#if defined(IRIDIUM_ENABLE_STREAM_RESUME)
+   if(m_pProtocol->SendStreamOpenRequest(in_rDevice.m_Addr, IRIDIUM_FLASHER_STREAM_NAME, IRIDIUM_STREAM_MODE_WRITE, in_rDevice.m_u32PIN, IRIDIUM_FLASHER_WINDOW, !in_rDevice.m_bRestart))
+#else
+   if(m_pProtocol->SendStreamOpenRequest(in_rDevice.m_Addr, IRIDIUM_FLASHER_STREAM_NAME, IRIDIUM_STREAM_MODE_WRITE, in_rDevice.m_u32PIN, IRIDIUM_FLASHER_WINDOW))
+#endif
+   {
+      in_rDevice.m_u8Retries++;
+      in_rDevice.m_u32Time = m_u32Time;
+   } else
+      in_rDevice.m_u32Time = m_u32Time - IRIDIUM_FLASHER_OPEN_TIME;
+}
+
+/**
+   Отправка запроса закрытия потока прошивки
+   на входе    :  in_rDevice  - ссылка на устройство
+   на выходе   :  *
+   примечание  :  получив запрос загрузчик перезагружается в новую прошивку.
+                  Если очередь отправки занята блоками, запрос повторяется при следующем вызове Process
+*/
+void CIridiumFlasher::Close(iridium_flash_device_t& in_rDevice)
+{
+   in_rDevice.m_eState = IRIDIUM_FLASH_CLOSE;
+   if(m_pProtocol->SendStreamCloseRequest(in_rDevice.m_Addr, in_rDevice.m_u8StreamID))
+   {
+      in_rDevice.m_u8Retries++;
+      in_rDevice.m_u32Time = m_u32Time;
+   } else
+      in_rDevice.m_u32Time = m_u32Time - IRIDIUM_FLASHER_REPLY_TIME;
+}
+
+/**
+   Прерывание прошивки устройства
+   на входе    :  in_rDevice  - ссылка на устройство
+   на выходе   :  *
+*/
+void CIridiumFlasher::Fail(iridium_flash_device_t& in_rDevice)
+{
+   in_rDevice.m_eState = IRIDIUM_FLASH_FAILED;
+   if(m_pProtocol)
+      m_pProtocol->CloseStreamWindow(in_rDevice.m_Addr);
+}
+
+#endif   // defined(IRIDIUM_ENABLE_STREAM_WINDOW) && defined(IRIDIUM_CONFIG_STREAM_OPEN_MASTER) && defined(IRIDIUM_CONFIG_STREAM_BLOCK_MASTER) && defined(IRIDIUM_CONFIG_STREAM_CLOSE_MASTER)
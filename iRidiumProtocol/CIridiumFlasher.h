@@ -0,0 +1,180 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+#ifndef _C_IRIDIUM_FLASHER_H_INCLUDED_
+#define _C_IRIDIUM_FLASHER_H_INCLUDED_
+
+// Включения
+#include "CIridiumProtocol.h"
+
+#if defined(IRIDIUM_ENABLE_STREAM_WINDOW) && defined(IRIDIUM_CONFIG_STREAM_OPEN_MASTER) && defined(IRIDIUM_CONFIG_STREAM_BLOCK_MASTER) && defined(IRIDIUM_CONFIG_STREAM_CLOSE_MASTER)
+
+// Имя потока прошивки
+#ifndef IRIDIUM_FLASHER_STREAM_NAME
+#define IRIDIUM_FLASHER_STREAM_NAME       "Firmware.bin"
+#endif
+
+// Максимальное количество устройств в списке прошивки
+#ifndef IRIDIUM_FLASHER_MAX_DEVICES
+#define IRIDIUM_FLASHER_MAX_DEVICES       64
+#endif
+
+// Максимальное количество одновременно прошиваемых устройств
+#ifndef IRIDIUM_FLASHER_MAX_ACTIVE
+#define IRIDIUM_FLASHER_MAX_ACTIVE        IRIDIUM_STREAM_MAX_TX
+#endif
+
+// Размер блока прошивки по умолчанию (кратен блоку шифра образа)
+#ifndef IRIDIUM_FLASHER_BLOCK_SIZE
+#define IRIDIUM_FLASHER_BLOCK_SIZE        192
+#endif
+
+// Запрашиваемый размер окна передачи блоков
+#ifndef IRIDIUM_FLASHER_WINDOW
+#define IRIDIUM_FLASHER_WINDOW            4
+#endif
+
+// Время ожидания ответа на запрос открытия потока в миллисекундах (включает перезагрузку прошивки в загрузчик)
+#ifndef IRIDIUM_FLASHER_OPEN_TIME
+#define IRIDIUM_FLASHER_OPEN_TIME         5000
+#endif
+
+// Время ожидания ответа на запрос закрытия потока и на блок без окна в миллисекундах
+#ifndef IRIDIUM_FLASHER_REPLY_TIME
+#define IRIDIUM_FLASHER_REPLY_TIME        1000
+#endif
+
+// Количество попыток открытия и закрытия потока
+#ifndef IRIDIUM_FLASHER_RETRIES
+#define IRIDIUM_FLASHER_RETRIES           3
+#endif
+
+// Время без подтвержденных блоков, после которого загрузчик закрывает поток (FIRMWARE_WAIT_TIME загрузчика)
+#ifndef IRIDIUM_FLASHER_WAIT_TIME
+#define IRIDIUM_FLASHER_WAIT_TIME         3000
+#endif
+
+// Состояние прошивки устройства
+enum eIridiumFlashState
+{
+   IRIDIUM_FLASH_WAIT = 0,                         // Устройство ожидает очереди
+   IRIDIUM_FLASH_OPEN,                             // Ожидание ответа на запрос открытия потока
+   IRIDIUM_FLASH_WRITE,                            // Передача блоков прошивки
+   IRIDIUM_FLASH_CLOSE,                            // Ожидание ответа на запрос закрытия потока
+   IRIDIUM_FLASH_DONE,                             // Прошивка передана
+   IRIDIUM_FLASH_FAILED,                           // Прошивка прервана
+};
+
+// Состояние прошивки устройства
+typedef struct iridium_flash_device_s
+{
+   iridium_address_t       m_Addr;                 // Адрес устройства
+   u32                     m_u32PIN;               // PIN код записи потока
+   eIridiumFlashState      m_eState;               // Состояние прошивки
+   u8                      m_u8StreamID;           // Идентификатор открытого потока
+   u8                      m_u8Window;             // Размер окна (0 - загрузчик принимает по одному блоку)
+   u8                      m_u8Retries;            // Количество повторов запроса открытия или закрытия
+   bool                    m_bWait;                // Признак ожидания ответа на блок без окна
+   u32                     m_u32Offset;            // Смещение в образе, с которого передаются блоки (точка продолжения)
+   u32                     m_u32Blocks;            // Количество подтвержденных блоков (от смещения m_u32Offset)
+   u32                     m_u32Time;              // Время отправки последнего запроса
+   u32                     m_u32Progress;          // Время последнего подтверждения блока
+   bool                    m_bRestart;             // Признак загрузки с начала (точка продолжения не совпала с образом)
+} iridium_flash_device_t;
+
+//////////////////////////////////////////////////////////////////////////
+// class CIridiumFlasher
+//////////////////////////////////////////////////////////////////////////
+// Прошивка нескольких устройств на одной шине. Образ прошивки (закодированный, как его принимает загрузчик)
+// подключается один раз без копирования, блоки всех устройств берутся из него. Одновременно прошивается до
+// IRIDIUM_FLASHER_MAX_ACTIVE устройств: потоки открываются окном, и ProcessStream протокола отправляет блоки
+// разным устройствам по кругу, поэтому пока одно устройство пишет флеш, шина занята блоками других.
+// Загрузчикам без поддержки окна блоки отправляются по одному с ожиданием ответа, повтор блока для них
+// невозможен (блок будет записан дважды), поэтому потерянный ответ прерывает прошивку такого устройства.
+// Новые устройства не запускаются, пока одно из прошиваемых не получает подтверждений больше половины
+// IRIDIUM_FLASHER_WAIT_TIME, чтобы загрузчики не закрыли потоки из-за перегрузки шины.
+// Если загрузчик сохранил точку продолжения прерванной записи (IRIDIUM_ENABLE_STREAM_RESUME), передается только
+// недостающий хвост образа. Точка принимается, только если CRC16 образа до нее совпадает с сообщенной загрузчиком,
+// иначе поток закрывается и устройство прошивается с начала.
+// Приложение передает флешеру события своего протокола: StreamOpenResult, StreamBlockResult, StreamGetBlock,
+// StreamComplete и StreamClose вместе с адресом устройства (GetSrcAddress для ответов)
+class CIridiumFlasher
+{
+public:
+   // Конструктор/деструктор
+   CIridiumFlasher();
+   ~CIridiumFlasher();
+
+   // Подключение протокола, через который прошиваются устройства
+   void Init(CIridiumProtocol* in_pProtocol);
+
+   // Подключение образа прошивки (данные не копируются и должны быть доступны до окончания прошивки)
+   bool SetImage(const void* in_pImage, size_t in_stSize, u16 in_u16BlockSize);
+#if defined(IRIDIUM_LINUX_PLATFORM)
+   // Отображение файла образа прошивки в память
+   bool MapImage(const char* in_pszPath, u16 in_u16BlockSize);
+#endif
+   // Отключение образа прошивки
+   void CloseImage();
+
+   // Работа со списком устройств
+   bool Add(iridium_address_t in_Addr, u32 in_u32PIN);
+   void Clear();
+   size_t GetDevices() const
+      { return m_stDevices; }
+   const iridium_flash_device_t* GetDevice(size_t in_stIndex) const
+      { return (in_stIndex < m_stDevices) ? &m_aDevices[in_stIndex] : NULL; }
+   // Количество блоков образа
+   u32 GetBlocks() const
+      { return m_u32Blocks; }
+   // Проверка наличия устройств, прошивка которых не окончена
+   bool IsActive() const;
+
+   // Запуск прошивки очередных устройств, отправка блоков и контроль времени (in_u32Time - монотонное время
+   // платформы в миллисекундах)
+   void Process(u32 in_u32Time);
+
+   // События протокола
+   void StreamOpenResult(iridium_address_t in_SrcAddr, u8 in_u8StreamID);
+   void StreamBlockResult(iridium_address_t in_SrcAddr, u8 in_u8StreamID, u8 in_u8BlockID, size_t in_stSize);
+   bool StreamGetBlock(iridium_address_t in_DstAddr, u8 in_u8StreamID, u32 in_u32Index, const void*& out_rBlock, u16& out_rSize);
+   void StreamComplete(iridium_address_t in_DstAddr, u8 in_u8StreamID, bool in_bSuccess);
+   void StreamClose(iridium_address_t in_SrcAddr, u8 in_u8StreamID);
+#if defined(IRIDIUM_ENABLE_STREAM_RESUME)
+   void StreamResumeResult(iridium_address_t in_SrcAddr, u8 in_u8StreamID, u32 in_u32Offset, u16 in_u16CRC);
+#endif
+
+protected:
+   iridium_flash_device_t* Find(iridium_address_t in_Addr, u8 in_u8StreamID);
+   u32 GetBlocks(const iridium_flash_device_t& in_rDevice) const;
+   bool GetBlock(u32 in_u32Offset, u32 in_u32Index, const void*& out_rBlock, u16& out_rSize);
+   void Open(iridium_flash_device_t& in_rDevice);
+   void Close(iridium_flash_device_t& in_rDevice);
+   void Fail(iridium_flash_device_t& in_rDevice);
+
+private:
+   CIridiumProtocol*       m_pProtocol;            // Указатель на протокол
+   const u8*               m_pImage;               // Указатель на образ прошивки
+   size_t                  m_stImage;              // Размер образа прошивки
+   u16                     m_u16BlockSize;         // Размер блока
+   u32                     m_u32Blocks;            // Количество блоков образа
+   bool                    m_bMapped;              // Признак отображенного в память файла образа
+   iridium_flash_device_t  m_aDevices[IRIDIUM_FLASHER_MAX_DEVICES]; // Список устройств
+   size_t                  m_stDevices;            // Количество устройств в списке
+   u32                     m_u32Time;              // Текущее время, последнее значение переданное в Process
+};
+
+#endif   // defined(IRIDIUM_ENABLE_STREAM_WINDOW) && defined(IRIDIUM_CONFIG_STREAM_OPEN_MASTER) && defined(IRIDIUM_CONFIG_STREAM_BLOCK_MASTER) && defined(IRIDIUM_CONFIG_STREAM_CLOSE_MASTER)
+#endif   // _C_IRIDIUM_FLASHER_H_INCLUDED_
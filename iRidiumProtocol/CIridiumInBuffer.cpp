@@ -130,6 +130,8 @@ bool CIridiumInBuffer::GetDeviceInfo(iridium_device_info_t& out_rInfo)
       {
          GetU32LE(out_rInfo.m_u32Channels);
          GetU32LE(out_rInfo.m_u32Tags);
+         // Получение хэша каталога каналов (0 - устройство не сообщает хэш)
+         GetU32LE(out_rInfo.m_u32Catalog);
       }
    }
    return l_bResult;
@@ -0,0 +1,188 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+#include "CIridiumLZ.h"
+
+/**
+   Конструктор класса
+   на входе    :  *
+*/
+CIridiumLZ::CIridiumLZ()
+{
+   Reset();
+}
+
+/**
+   Деструктор класса
+*/
+CIridiumLZ::~CIridiumLZ()
+{
+}
+
+/**
+   Сжатие данных
+   на входе    :  in_pBuffer     - указатель на сжимаемые данные
+                  in_stSize      - размер сжимаемых данных
+                  out_pBuffer    - указатель на буфер куда нужно поместить сжатые данные
+                  in_stMaxSize   - размер буфера, в худшем случае in_stSize + (in_stSize + 7) / 8
+   на выходе   :  размер сжатых данных, 0 - буфер мал
+   примечание  :  поиск ссылок полным перебором окна, выбирается самая длинная и самая близкая ссылка
+*/
+size_t CIridiumLZ::Encode(const void* in_pBuffer, size_t in_stSize, void* out_pBuffer, size_t in_stMaxSize)
+{
+   const u8* l_pIn = (const u8*)in_pBuffer;
+   u8* l_pOut = (u8*)out_pBuffer;
+   size_t l_stOut = 0;
+   size_t l_stFlags = 0;
+   u8 l_u8Item = 8;
+   size_t l_stPos = 0;
+
+   while(l_stPos < in_stSize)
+   {
+      // Место под байт флагов новой группы
+      if(l_u8Item == 8)
+      {
+         if(l_stOut + 1 > in_stMaxSize)
+            return 0;
+         l_stFlags = l_stOut++;
+         l_pOut[l_stFlags] = 0;
+         l_u8Item = 0;
+      }
+
+      // Поиск самой длинной ссылки в окне
+      size_t l_stMax = in_stSize - l_stPos;
+      if(l_stMax > IRIDIUM_LZ_MAX_MATCH)
+         l_stMax = IRIDIUM_LZ_MAX_MATCH;
+      size_t l_stBest = 0;
+      size_t l_stOffset = 0;
+      for(size_t i = 1; i <= IRIDIUM_LZ_WINDOW_SIZE && i <= l_stPos && l_stBest < l_stMax; i++)
+      {
+         size_t l_stLen = 0;
+         while(l_stLen < l_stMax && l_pIn[l_stPos + l_stLen - i] == l_pIn[l_stPos + l_stLen])
+            l_stLen++;
+         if(l_stLen > l_stBest)
+         {
+            l_stBest = l_stLen;
+            l_stOffset = i;
+         }
+      }
+
+      if(l_stBest >= IRIDIUM_LZ_MIN_MATCH)
+      {
+         // Ссылка
+         if(l_stOut + 2 > in_stMaxSize)
+            return 0;
+         u16 l_u16Ref = (u16)((l_stOffset - 1) | ((l_stBest - IRIDIUM_LZ_MIN_MATCH) << IRIDIUM_LZ_WINDOW_BITS));
+         l_pOut[l_stOut++] = (u8)l_u16Ref;
+         l_pOut[l_stOut++] = (u8)(l_u16Ref >> 8);
+         l_stPos += l_stBest;
+      } else
+      {
+         // Байт данных
+         if(l_stOut + 1 > in_stMaxSize)
+            return 0;
+         l_pOut[l_stFlags] |= (u8)(1 << l_u8Item);
+         l_pOut[l_stOut++] = l_pIn[l_stPos++];
+      }
+      l_u8Item++;
+   }
+   return l_stOut;
+}
+
+/**
+   Сброс состояния распаковки
+   на входе    :  *
+   на выходе   :  *
+*/
+void CIridiumLZ::Reset()
+{
+   memset(m_aWindow, 0, sizeof(m_aWindow));
+   m_u16Pos = 0;
+   m_u8Flags = 0;
+   m_u8Items = 0;
+   m_u8Low = 0;
+   m_bLow = false;
+   m_u16Offset = 0;
+   m_u8Copy = 0;
+}
+
+/**
+   Распаковка очередной части данных
+   на входе    :  in_pBuffer     - указатель на сжатые данные
+                  in_stSize      - размер сжатых данных
+                  out_rUsed      - ссылка куда нужно поместить количество обработанных сжатых данных
+                  out_pBuffer    - указатель на буфер куда нужно поместить распакованные данные
+                  in_stMaxSize   - размер буфера
+   на выходе   :  размер распакованных данных
+   примечание  :  распаковка прекращается когда закончились сжатые данные или заполнен буфер, необработанные
+                  данные нужно передать при следующем вызове. Ссылка может быть разделена между вызовами
+*/
+size_t CIridiumLZ::Decode(const void* in_pBuffer, size_t in_stSize, size_t& out_rUsed, void* out_pBuffer, size_t in_stMaxSize)
+{
+   const u8* l_pIn = (const u8*)in_pBuffer;
+   u8* l_pOut = (u8*)out_pBuffer;
+   size_t l_stOut = 0;
+   size_t l_stUsed = 0;
+
+   while(l_stOut < in_stMaxSize)
+   {
+      // Копирование ссылки
+      if(m_u8Copy)
+      {
+         u8 l_u8Byte = m_aWindow[(m_u16Pos - m_u16Offset) & (IRIDIUM_LZ_WINDOW_SIZE - 1)];
+         m_aWindow[m_u16Pos] = l_u8Byte;
+         m_u16Pos = (m_u16Pos + 1) & (IRIDIUM_LZ_WINDOW_SIZE - 1);
+         l_pOut[l_stOut++] = l_u8Byte;
+         m_u8Copy--;
+         continue;
+      }
+
+      // Проверка окончания сжатых данных
+      if(l_stUsed == in_stSize)
+         break;
+      u8 l_u8Byte = l_pIn[l_stUsed++];
+
+      if(!m_u8Items)
+      {
+         // Байт флагов новой группы
+         m_u8Flags = l_u8Byte;
+         m_u8Items = 8;
+      } else if(m_u8Flags & 1)
+      {
+         // Байт данных
+         m_aWindow[m_u16Pos] = l_u8Byte;
+         m_u16Pos = (m_u16Pos + 1) & (IRIDIUM_LZ_WINDOW_SIZE - 1);
+         l_pOut[l_stOut++] = l_u8Byte;
+         m_u8Flags >>= 1;
+         m_u8Items--;
+      } else if(!m_bLow)
+      {
+         // Младший байт ссылки
+         m_u8Low = l_u8Byte;
+         m_bLow = true;
+      } else
+      {
+         // Старший байт ссылки, начало копирования
+         u16 l_u16Ref = (u16)(m_u8Low | (l_u8Byte << 8));
+         m_u16Offset = (l_u16Ref & (IRIDIUM_LZ_WINDOW_SIZE - 1)) + 1;
+         m_u8Copy = (u8)((l_u16Ref >> IRIDIUM_LZ_WINDOW_BITS) + IRIDIUM_LZ_MIN_MATCH);
+         m_bLow = false;
+         m_u8Flags >>= 1;
+         m_u8Items--;
+      }
+   }
+   out_rUsed = l_stUsed;
+   return l_stOut;
+}
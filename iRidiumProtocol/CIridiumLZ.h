@@ -0,0 +1,63 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+#ifndef _C_IRIDIUM_LZ_H_INCLUDED_
+#define _C_IRIDIUM_LZ_H_INCLUDED_
+
+// Включения
+#include "Iridium.h"
+
+// Параметры формата сжатия (изменение делает сжатые данные несовместимыми)
+#define IRIDIUM_LZ_WINDOW_BITS            9           // Количество бит смещения ссылки
+#define IRIDIUM_LZ_WINDOW_SIZE            (1 << IRIDIUM_LZ_WINDOW_BITS) // Размер окна (максимальное смещение ссылки)
+#define IRIDIUM_LZ_MIN_MATCH              3           // Минимальная длина ссылки
+#define IRIDIUM_LZ_MAX_MATCH              (IRIDIUM_LZ_MIN_MATCH + (1 << (16 - IRIDIUM_LZ_WINDOW_BITS)) - 1) // Максимальная длина ссылки
+
+//////////////////////////////////////////////////////////////////////////
+// class CIridiumLZ
+//////////////////////////////////////////////////////////////////////////
+// Сжатие LZSS с небольшим окном для передачи прошивки. Сжатые данные - группы из байта флагов и 8
+// элементов (бит i равен 1 - элемент i это байт данных, 0 - ссылка на ранее распакованные данные).
+// Ссылка занимает 2 байта LE: младшие IRIDIUM_LZ_WINDOW_BITS бит - смещение назад минус 1, старшие
+// биты - длина минус IRIDIUM_LZ_MIN_MATCH. Конец данных не кодируется, распаковывающая сторона должна
+// знать размер исходных данных. Распаковка потоковая: данные могут подаваться и забираться частями
+// любого размера, для нее нужно только окно IRIDIUM_LZ_WINDOW_SIZE байт. Сжатие выполняется ведущим
+// (или утилитой подготовки прошивки) целиком над образом
+class CIridiumLZ
+{
+public:
+   // Конструктор/деструктор
+   CIridiumLZ();
+   ~CIridiumLZ();
+
+   // Сжатие данных
+   static size_t Encode(const void* in_pBuffer, size_t in_stSize, void* out_pBuffer, size_t in_stMaxSize);
+
+   // Сброс состояния распаковки
+   void Reset();
+   // Распаковка очередной части данных
+   size_t Decode(const void* in_pBuffer, size_t in_stSize, size_t& out_rUsed, void* out_pBuffer, size_t in_stMaxSize);
+
+private:
+   u8                      m_aWindow[IRIDIUM_LZ_WINDOW_SIZE]; // Окно распакованных данных
+   u16                     m_u16Pos;               // Позиция записи в окне
+   u8                      m_u8Flags;              // Флаги элементов текущей группы
+   u8                      m_u8Items;              // Количество оставшихся элементов текущей группы
+   u8                      m_u8Low;                // Младший байт ссылки
+   bool                    m_bLow;                 // Признак получения младшего байта ссылки
+   u16                     m_u16Offset;            // Смещение копируемой ссылки
+   u8                      m_u8Copy;               // Количество оставшихся байт копируемой ссылки
+};
+#endif   // _C_IRIDIUM_LZ_H_INCLUDED_
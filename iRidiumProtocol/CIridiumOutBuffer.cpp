@@ -24,6 +24,10 @@ CIridiumOutBuffer::CIridiumOutBuffer() : COutBuffer()
    m_pPacket = NULL;
    m_pMessage = NULL;
    m_stMaxMessageSize = 0;
+   m_bDataRefAllow = false;
+   m_pDataRefPos = NULL;
+   m_pDataRef = NULL;
+   m_stDataRefSize = 0;
 }
 
 /**
@@ -177,6 +181,9 @@ bool CIridiumOutBuffer::AddDeviceInfo(iridium_device_info_t& in_rInfo)
       l_bResult = AddU32LE(in_rInfo.m_u32Channels);
    if(l_bResult)
       l_bResult = AddU32LE(in_rInfo.m_u32Tags);
+   // Добавление хэша каталога каналов (необязательное поле, старые ведущие его пропускают)
+   if(l_bResult && in_rInfo.m_u32Catalog)
+      l_bResult = AddU32LE(in_rInfo.m_u32Catalog);
 
    return l_bResult;
 }
@@ -535,3 +542,134 @@ void CIridiumOutBuffer::SetMessageHeaderEnd(bool in_bEnd)
       m_pMessage[0] = l_u8Byte | in_bEnd << 4;
    }
 }
+
+/**
+   Добавление ссылки на внешние данные
+   на входе    :  in_pData    - указатель на данные
+                  in_stSize   - размер данных
+   на выходе   :  успешность добавления в буфер
+   примечание  :  данные не копируются, в буфере под них только резервируется место, а в пакет они попадают
+                  отдельным сегментом (см. GetPacketVector). Данные должны быть доступны до окончания отправки
+                  пакета. В пакете может быть только одна ссылка, если ссылки запрещены (например сообщение
+                  шифруется) или ссылка уже есть, данные копируются в буфер
+*/
+bool CIridiumOutBuffer::AddDataRef(const void* in_pData, size_t in_stSize)
+{
+   bool l_bResult = false;
+
+   // Проверка возможности добавления ссылки
+   if(m_bDataRefAllow && !m_pDataRef)
+   {
+      // Проверка на наличие данных и свободного места
+      if(in_pData && in_stSize && (m_pPtr + in_stSize) <= m_pEnd)
+      {
+         // Запоминание ссылки и резервирование места под данные
+         m_pDataRefPos = m_pPtr;
+         m_pDataRef = (const u8*)in_pData;
+         m_stDataRefSize = in_stSize;
+         m_pPtr += in_stSize;
+         l_bResult = true;
+      }
+   } else
+      l_bResult = AddData(in_pData, in_stSize);
+
+   return l_bResult;
+}
+
+/**
+   Добавление массива в виде универсального значения IVT_ARRAY_U8 со ссылкой на данные массива
+   на входе    :  in_rValue      - ссылка на универсальное значение
+                  out_stRemain   - ссылка на переменную с остатком
+                  in_stReserve   - размер зарезервированных данных
+   на выходе   :  успешность добавления в буфер
+   примечание  :  формат данных совпадает с AddValue(IVT_ARRAY_U8, ...), но данные массива не копируются
+*/
+bool CIridiumOutBuffer::AddArrayRef(universal_value_t& in_rValue, size_t& out_stRemain, size_t in_stReserve)
+{
+   bool l_bResult = false;
+
+   // Ссылка невозможна, если данных нет или они расположены в памяти программы
+   bool l_bRef = m_bDataRefAllow && !m_pDataRef && in_rValue.m_Array.m_stSize && in_rValue.m_Array.m_pPtr;
+#if defined(IRIDIUM_AVR_PLATFORM)
+   l_bRef = l_bRef && !in_rValue.m_Array.m_bMem;
+#endif
+
+   if(l_bRef)
+   {
+      // Проверка инициализации остатка
+      if(out_stRemain == (size_t)-1)
+         out_stRemain = in_rValue.m_Array.m_stSize;
+
+      // Резервируем место для типа
+      if(CreateAnchorU8())
+      {
+         // Проверка влезет ли пакет в буфер с учетом зарезервированного места плюс размер массива и контрольной суммы
+         size_t l_stSize = Free();
+         if(l_stSize > (in_stReserve + IRIDIUM_VALUE_RESERVE))
+         {
+            // Вычисление позиции в массиве
+            size_t l_stPos = in_rValue.m_Array.m_stSize - out_stRemain;
+
+            l_stSize -= (in_stReserve + IRIDIUM_VALUE_RESERVE);
+            if(l_stSize > out_stRemain)
+               l_stSize = out_stRemain;
+
+            // Добавление размера массива и ссылки на данные
+            AddU16LE(l_stSize);
+            l_bResult = AddDataRef((const u8*)in_rValue.m_Array.m_pPtr + l_stPos, l_stSize);
+            if(l_bResult)
+            {
+               // Сдвиг позиции
+               out_stRemain -= l_stSize;
+               // Запишем значение типа с признаком наличия данных
+               SetAnchorU8Value(IVT_ARRAY_U8 | 1 << 7);
+            }
+         }
+      }
+   } else
+      l_bResult = AddValue(IVT_ARRAY_U8, in_rValue, out_stRemain, in_stReserve);
+
+   return l_bResult;
+}
+
+/**
+   Получение списка сегментов сформированного пакета
+   на входе    :  out_pVec - указатель на массив сегментов
+                  in_stMax - максимальное количество сегментов в массиве
+   на выходе   :  количество сегментов, 0 - пакет не сформирован или массив слишком мал
+   примечание  :  если в пакете нет ссылки на внешние данные, пакет состоит из одного сегмента.
+                  Сегменты со ссылкой идут в порядке их расположения в пакете, место под внешние данные
+                  зарезервировано в буфере, поэтому пакет можно собрать в буфере начиная с первого сегмента
+*/
+size_t CIridiumOutBuffer::GetPacketVector(iridium_iovec_t* out_pVec, size_t in_stMax)
+{
+   size_t l_stCount = 0;
+
+   // Проверка наличия пакета
+   if(m_pPacket && out_pVec)
+   {
+      if(!m_pDataRef)
+      {
+         // Пакет расположен в буфере целиком
+         if(in_stMax >= 1)
+         {
+            out_pVec[0].m_pPtr   = m_pPacket;
+            out_pVec[0].m_stSize = m_pPtr - m_pPacket;
+            l_stCount = 1;
+         }
+      } else if(in_stMax >= 3)
+      {
+         // Данные до ссылки
+         out_pVec[0].m_pPtr   = m_pPacket;
+         out_pVec[0].m_stSize = m_pDataRefPos - m_pPacket;
+         // Внешние данные
+         out_pVec[1].m_pPtr   = m_pDataRef;
+         out_pVec[1].m_stSize = m_stDataRefSize;
+         // Данные после ссылки и CRC
+         out_pVec[2].m_pPtr   = m_pDataRefPos + m_stDataRefSize;
+         out_pVec[2].m_stSize = m_pPtr - (m_pDataRefPos + m_stDataRefSize);
+         l_stCount = 3;
+      }
+   }
+   return l_stCount;
+}
@@ -51,11 +51,20 @@ public:
    // Установка флага окончания данных
    void SetMessageHeaderEnd(bool in_bEnd);
 
+   // Добавление ссылки на внешние данные без копирования
+   void AllowDataRef(bool in_bAllow)
+      { m_bDataRefAllow = in_bAllow; }
+   bool AddDataRef(const void* in_pData, size_t in_stSize);
+   bool AddArrayRef(universal_value_t& in_rValue, size_t& out_stRemain, size_t in_stReserve);
+   bool IsDataRef()
+      { return m_pDataRef != NULL; }
+
    // Получение данных сформированого пакета
    void* GetPacketPtr()
       { return m_pPacket; }
    size_t GetPacketSize()
       { return m_pPtr - m_pPacket; }
+   size_t GetPacketVector(iridium_iovec_t* out_pVec, size_t in_stMax);
 
    // Установка/получение данных о данных сообщения
    u8* GetMessagePtr()
@@ -71,5 +80,9 @@ protected:
    u8*      m_pPacket;                             // Указатель на данные пакета
    u8*      m_pMessage;                            // Указатель на данные сообщения
    size_t   m_stMaxMessageSize;                    // Максимальный размер данных сообщения
+   bool     m_bDataRefAllow;                       // Признак разрешения ссылок на внешние данные
+   u8*      m_pDataRefPos;                         // Позиция внешних данных в пакете
+   const u8* m_pDataRef;                           // Указатель на внешние данные
+   size_t   m_stDataRefSize;                       // Размер внешних данных
 };
 #endif   // _C_IRIDIUM_OUT_BUFFER_H_INCLUDED_
@@ -0,0 +1,83 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+#include "CIridiumPacketBuilder.h"
+#include "CIridiumProtocol.h"
+
+/**
+   Конструктор класса
+   на входе    :  *
+*/
+CIridiumPacketBuilder::CIridiumPacketBuilder()
+{
+   memset(&m_PH, 0, sizeof(m_PH));
+   memset(&m_MH, 0, sizeof(m_MH));
+   m_pBuffer = NULL;
+   m_pProtocol = NULL;
+
+#if defined(IRIDIUM_CONFIG_BATCH_MASTER) || defined(IRIDIUM_CONFIG_BATCH_SLAVE)
+   m_stBatchBegin = 0;
+#endif
+
+#if defined(IRIDIUM_ENABLE_TRANSACTIONS)
+   m_bTransaction = false;
+   m_bTransactionChain = false;
+   m_bTransactionReject = false;
+   m_u32TransactionTimeout = 0;
+   m_u8TransactionRetries = 0;
+   m_pTransactionCallback = NULL;
+   m_pTransactionContext = NULL;
+#endif
+}
+
+/**
+   Деструктор класса
+*/
+CIridiumPacketBuilder::~CIridiumPacketBuilder()
+{
+}
+
+/**
+   Привязка построителя к протоколу и исходящему буферу
+   на входе    :  in_pProtocol   - указатель на протокол, через который отправляются пакеты
+                  in_pBuffer     - указатель на исходящий буфер построителя
+   на выходе   :  *
+   примечание  :  буфер не должен использоваться другими построителями
+*/
+void CIridiumPacketBuilder::Init(CIridiumProtocol* in_pProtocol, CIridiumOutBuffer* in_pBuffer)
+{
+   m_pProtocol = in_pProtocol;
+   m_pBuffer = in_pBuffer;
+}
+
+/**
+   Начало формирования пакета
+   на входе    :  *
+   на выходе   :  *
+*/
+void CIridiumPacketBuilder::Begin()
+{
+   m_pProtocol->BeginPacket(this);
+}
+
+/**
+   Окончание формирования пакета и его отправка
+   на входе    :  *
+   на выходе   :  успешность окончания работы с пакетом
+*/
+bool CIridiumPacketBuilder::End()
+{
+   return m_pProtocol->EndPacket(this);
+}
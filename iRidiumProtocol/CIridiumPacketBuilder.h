@@ -0,0 +1,77 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+#ifndef _C_IRIDIUM_PACKET_BUILDER_H_INCLUDED_
+#define _C_IRIDIUM_PACKET_BUILDER_H_INCLUDED_
+
+// Включения
+#include "Iridium.h"
+#include "CIridiumOutBuffer.h"
+
+#if defined(IRIDIUM_ENABLE_TRANSACTIONS)
+#include "CIridiumTransactions.h"
+#endif
+
+class CIridiumProtocol;
+
+//////////////////////////////////////////////////////////////////////////
+// class CIridiumPacketBuilder
+//////////////////////////////////////////////////////////////////////////
+// Контекст формирования исходящего пакета. Построитель хранит заголовки пакета и сообщения и работает
+// со своим исходящим буфером, поэтому несколько построителей могут формировать пакеты одновременно
+// (разные потоки, прерывание и основной цикл). Общие данные протокола используются только при передаче
+// сформированного пакета (см. CIridiumProtocol::Lock)
+class CIridiumPacketBuilder
+{
+public:
+   // Конструктор/деструктор
+   CIridiumPacketBuilder();
+   ~CIridiumPacketBuilder();
+
+   // Привязка построителя к протоколу и исходящему буферу
+   void Init(CIridiumProtocol* in_pProtocol, CIridiumOutBuffer* in_pBuffer);
+   // Установка исходящего буфера
+   void SetBuffer(CIridiumOutBuffer* in_pBuffer)
+      { m_pBuffer = in_pBuffer; }
+
+   // Начало/окончание формирования исходящего пакета
+   void Begin();
+   bool End();
+
+public:
+   // Данные для формирования исходящих сообщения
+   iridium_packet_header_t    m_PH;                // Данные заголовка исходящего пакета
+   iridium_message_header_t   m_MH;                // Заголовок исходящего сообщения
+   CIridiumOutBuffer*         m_pBuffer;           // Указатель на исходящий буфер сообщения
+
+#if defined(IRIDIUM_CONFIG_BATCH_MASTER) || defined(IRIDIUM_CONFIG_BATCH_SLAVE)
+   size_t                     m_stBatchBegin;      // Размер сообщения без элементов пакетного сообщения
+#endif
+
+#if defined(IRIDIUM_ENABLE_TRANSACTIONS)
+   // Параметры транзакции следующего запроса
+   bool                       m_bTransaction;      // Признак регистрации следующего запроса
+   bool                       m_bTransactionChain; // Признак того, что запрос передается цепочкой пакетов
+   bool                       m_bTransactionReject; // Признак отклонения запроса (окно получателя заполнено)
+   u32                        m_u32TransactionTimeout; // Время ожидания ответа
+   u8                         m_u8TransactionRetries; // Количество повторов
+   iridium_transaction_callback_t m_pTransactionCallback; // Обработчик завершения транзакции
+   void*                      m_pTransactionContext; // Пользовательские данные обработчика
+#endif   // defined(IRIDIUM_ENABLE_TRANSACTIONS)
+
+protected:
+   CIridiumProtocol*          m_pProtocol;         // Указатель на протокол, через который отправляются пакеты
+};
+#endif   // _C_IRIDIUM_PACKET_BUILDER_H_INCLUDED_
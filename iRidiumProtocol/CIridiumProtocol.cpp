@@ -19,6 +19,227 @@
 #include "Bytes.h"
 #include <stdlib.h>
 
+// Таблица обработчиков входящих сообщений. Строки одного типа сообщения должны располагаться подряд,
+// обработчики сообщений, отключенных в конфигурации, в таблицу и в образ программы не попадают
+static const iridium_message_entry_t g_aMessageHandlers[] =
+{
+#if defined(IRIDIUM_CONFIG_SYSTEM_PING_SLAVE)
+   // Пинг (запрос)
+   {  IRIDIUM_MESSAGE_SYSTEM_PING,               IRIDIUM_REQUEST,  0, &CIridiumProtocol::ReceivePingRequest },
+#endif
+#if defined(IRIDIUM_CONFIG_SYSTEM_PING_MASTER)
+   // Пинг (ответ)
+   {  IRIDIUM_MESSAGE_SYSTEM_PING,               IRIDIUM_RESPONSE, 0, &CIridiumProtocol::ReceivePingResponse },
+#endif
+#if defined(IRIDIUM_CONFIG_SYSTEM_SEARCH_SLAVE)
+   // Поиск (запрос)
+   {  IRIDIUM_MESSAGE_SYSTEM_SEARCH,             IRIDIUM_REQUEST,  0, &CIridiumProtocol::ReceiveSearchRequest },
+#endif
+#if defined(IRIDIUM_CONFIG_SYSTEM_SEARCH_MASTER)
+   // Поиск (ответ)
+   {  IRIDIUM_MESSAGE_SYSTEM_SEARCH,             IRIDIUM_RESPONSE, 0, &CIridiumProtocol::ReceiveSearchResponse },
+#endif
+#if defined(IRIDIUM_CONFIG_SYSTEM_DEVICE_INFO_SLAVE)
+   // Информация об устройстве (запрос)
+   {  IRIDIUM_MESSAGE_SYSTEM_DEVICE_INFO,        IRIDIUM_REQUEST,  0, &CIridiumProtocol::ReceiveDeviceInfoRequest },
+#endif
+#if defined(IRIDIUM_CONFIG_SYSTEM_DEVICE_INFO_MASTER)
+   // Информация об устройстве (ответ)
+   {  IRIDIUM_MESSAGE_SYSTEM_DEVICE_INFO,        IRIDIUM_RESPONSE, 0, &CIridiumProtocol::ReceiveDeviceInfoResponse },
+#endif
+#if defined(IRIDIUM_CONFIG_SYSTEM_SET_LID_SLAVE)
+   // Установка локального идентификатора (запрос)
+   {  IRIDIUM_MESSAGE_SYSTEM_SET_LID,            IRIDIUM_REQUEST,  0, &CIridiumProtocol::ReceiveSetLIDRequest },
+#endif
+#if defined(IRIDIUM_CONFIG_SYSTEM_SET_LID_MASTER)
+   // Установка локального идентификатора (ответ)
+   {  IRIDIUM_MESSAGE_SYSTEM_SET_LID,            IRIDIUM_RESPONSE, 0, &CIridiumProtocol::ReceiveSetLIDResponse },
+#endif
+#if defined(IRIDIUM_CONFIG_SYSTEM_SMART_API_SLAVE)
+   // Получение информации о Smart API (запрос)
+   {  IRIDIUM_MESSAGE_SYSTEM_SMART_API,          IRIDIUM_REQUEST,  0, &CIridiumProtocol::ReceiveSmartAPIRequest },
+#endif
+#if defined(IRIDIUM_CONFIG_SYSTEM_SMART_API_MASTER)
+   // Получение информации о Smart API (ответ)
+   {  IRIDIUM_MESSAGE_SYSTEM_SMART_API,          IRIDIUM_RESPONSE, 0, &CIridiumProtocol::ReceiveSmartAPIResponse },
+#endif
+
+#if defined(IRIDIUM_CONFIG_SET_VARIABLE_SLAVE)
+   // Установка глобальной переменной (запрос)
+   {  IRIDIUM_MESSAGE_SET_VARIABLE,              IRIDIUM_REQUEST,  0, &CIridiumProtocol::ReceiveSetVariableRequest },
+#endif
+#if defined(IRIDIUM_CONFIG_SET_VARIABLE_MASTER)
+   // Установка глобальной переменной (ответ)
+   {  IRIDIUM_MESSAGE_SET_VARIABLE,              IRIDIUM_RESPONSE, 0, &CIridiumProtocol::ReceiveSetVariableResponse },
+#endif
+#if defined(IRIDIUM_CONFIG_GET_VARIABLE_SLAVE)
+   // Получение глобальной переменной (запрос)
+   {  IRIDIUM_MESSAGE_GET_VARIABLE,              IRIDIUM_REQUEST,  0, &CIridiumProtocol::ReceiveGetVariableRequest },
+#endif
+#if defined(IRIDIUM_CONFIG_GET_VARIABLE_MASTER)
+   // Получение глобальной переменной (ответ)
+   {  IRIDIUM_MESSAGE_GET_VARIABLE,              IRIDIUM_RESPONSE, 0, &CIridiumProtocol::ReceiveGetVariableResponse },
+#endif
+
+#if defined(IRIDIUM_CONFIG_GET_TAGS_SLAVE)
+   // Получение списка каналов обратной связи (запрос)
+   {  IRIDIUM_MESSAGE_GET_TAGS,                  IRIDIUM_REQUEST,  0, &CIridiumProtocol::ReceiveGetTagsRequest },
+#endif
+#if defined(IRIDIUM_CONFIG_GET_TAGS_MASTER)
+   // Получение списка каналов обратной связи (ответ)
+   {  IRIDIUM_MESSAGE_GET_TAGS,                  IRIDIUM_RESPONSE, 0, &CIridiumProtocol::ReceiveGetTagsResponse },
+#endif
+#if defined(IRIDIUM_CONFIG_LINK_TAG_AND_VARIABLE_SLAVE)
+   // Связывание канала обратной связи и глобальной переменной (запрос)
+   {  IRIDIUM_MESSAGE_LINK_TAG_AND_VARIABLE,     IRIDIUM_REQUEST,  0, &CIridiumProtocol::ReceiveLinkTagAndVariableRequest },
+#endif
+#if defined(IRIDIUM_CONFIG_LINK_TAG_AND_VARIABLE_MASTER)
+   // Связывание канала обратной связи и глобальной переменной (ответ)
+   {  IRIDIUM_MESSAGE_LINK_TAG_AND_VARIABLE,     IRIDIUM_RESPONSE, 0, &CIridiumProtocol::ReceiveLinkTagAndVariableResponse },
+#endif
+#if defined(IRIDIUM_CONFIG_GET_TAG_DESCRIPTION_SLAVE)
+   // Получение описания канала обратной связи (запрос)
+   {  IRIDIUM_MESSAGE_GET_TAG_DESCRIPTION,       IRIDIUM_REQUEST,  0, &CIridiumProtocol::ReceiveGetTagDescriptionRequest },
+#endif
+#if defined(IRIDIUM_CONFIG_GET_TAG_DESCRIPTION_MASTER)
+   // Получение описания канала обратной связи (ответ)
+   {  IRIDIUM_MESSAGE_GET_TAG_DESCRIPTION,       IRIDIUM_RESPONSE, 0, &CIridiumProtocol::ReceiveGetTagDescriptionResponse },
+#endif
+#if defined(IRIDIUM_CONFIG_SET_TAG_VALUE_SLAVE)
+   // Установка значения канала обратной связи (запрос)
+   {  IRIDIUM_MESSAGE_SET_TAG_VALUE,             IRIDIUM_REQUEST,  0, &CIridiumProtocol::ReceiveSetTagValueRequest },
+#endif
+#if defined(IRIDIUM_CONFIG_SET_TAG_VALUE_MASTER)
+   // Установка значения канала обратной связи (ответ)
+   {  IRIDIUM_MESSAGE_SET_TAG_VALUE,             IRIDIUM_RESPONSE, 0, &CIridiumProtocol::ReceiveSetTagValueResponse },
+#endif
+#if defined(IRIDIUM_CONFIG_GET_TAG_VALUE_SLAVE)
+   // Получение значения канала обратной связи (запрос)
+   {  IRIDIUM_MESSAGE_GET_TAG_VALUE,             IRIDIUM_REQUEST,  0, &CIridiumProtocol::ReceiveGetTagValueRequest },
+#endif
+#if defined(IRIDIUM_CONFIG_GET_TAG_VALUE_MASTER)
+   // Получение значения канала обратной связи (ответ)
+   {  IRIDIUM_MESSAGE_GET_TAG_VALUE,             IRIDIUM_RESPONSE, 0, &CIridiumProtocol::ReceiveGetTagValueResponse },
+#endif
+#if defined(IRIDIUM_CONFIG_SUBSCRIBE_TAG_SLAVE)
+   // Подписка на изменение значения канала обратной связи (запрос)
+   {  IRIDIUM_MESSAGE_SUBSCRIBE_TAG,             IRIDIUM_REQUEST,  0, &CIridiumProtocol::ReceiveSubscribeTagRequest },
+#endif
+#if defined(IRIDIUM_CONFIG_SUBSCRIBE_TAG_MASTER)
+   // Подписка на изменение значения канала обратной связи (ответ)
+   {  IRIDIUM_MESSAGE_SUBSCRIBE_TAG,             IRIDIUM_RESPONSE, 0, &CIridiumProtocol::ReceiveSubscribeTagResponse },
+#endif
+#if defined(IRIDIUM_CONFIG_SUBSCRIBE_TAG_MASTER)
+   // Уведомление об изменении значения канала обратной связи (запрос)
+   {  IRIDIUM_MESSAGE_TAG_NOTIFY,                IRIDIUM_REQUEST,  0, &CIridiumProtocol::ReceiveTagNotifyRequest },
+#endif
+
+#if defined(IRIDIUM_CONFIG_GET_CHANNELS_SLAVE)
+   // Получение списка каналов управления (запрос)
+   {  IRIDIUM_MESSAGE_GET_CHANNELS,              IRIDIUM_REQUEST,  0, &CIridiumProtocol::ReceiveGetChannelsRequest },
+#endif
+#if defined(IRIDIUM_CONFIG_GET_CHANNELS_MASTER)
+   // Получение списка каналов управления (ответ)
+   {  IRIDIUM_MESSAGE_GET_CHANNELS,              IRIDIUM_RESPONSE, 0, &CIridiumProtocol::ReceiveGetChannelsResponse },
+#endif
+#if defined(IRIDIUM_CONFIG_SET_CHANNEL_VALUE_SLAVE)
+   // Установка значения канала управления (запрос)
+   {  IRIDIUM_MESSAGE_SET_CHANNEL_VALUE,         IRIDIUM_REQUEST,  0, &CIridiumProtocol::ReceiveSetChannelValueRequest },
+#endif
+#if defined(IRIDIUM_CONFIG_SET_CHANNEL_VALUE_MASTER)
+   // Установка значения канала управления (ответ)
+   {  IRIDIUM_MESSAGE_SET_CHANNEL_VALUE,         IRIDIUM_RESPONSE, 0, &CIridiumProtocol::ReceiveSetChannelValueResponse },
+#endif
+#if defined(IRIDIUM_CONFIG_LINK_CHANNEL_AND_VARIABLE_SLAVE)
+   // Связывание канала управления и глобальной переменной (запрос)
+   {  IRIDIUM_MESSAGE_LINK_CHANNEL_AND_VARIABLE, IRIDIUM_REQUEST,  0, &CIridiumProtocol::ReceiveLinkChannelAndVariableRequest },
+#endif
+#if defined(IRIDIUM_CONFIG_LINK_CHANNEL_AND_VARIABLE_MASTER)
+   // Связывание канала управления и глобальной переменной (ответ)
+   {  IRIDIUM_MESSAGE_LINK_CHANNEL_AND_VARIABLE, IRIDIUM_RESPONSE, 0, &CIridiumProtocol::ReceiveLinkChannelAndVariableResponse },
+#endif
+#if defined(IRIDIUM_CONFIG_GET_CHANNEL_DESCRIPTION_SLAVE)
+   // Получение описания канала управления (запрос)
+   {  IRIDIUM_MESSAGE_GET_CHANNEL_DESCRIPTION,   IRIDIUM_REQUEST,  0, &CIridiumProtocol::ReceiveGetChannelDescriptionRequest },
+#endif
+#if defined(IRIDIUM_CONFIG_GET_CHANNEL_DESCRIPTION_MASTER)
+   // Получение описания канала управления (ответ)
+   {  IRIDIUM_MESSAGE_GET_CHANNEL_DESCRIPTION,   IRIDIUM_RESPONSE, 0, &CIridiumProtocol::ReceiveGetChannelDescriptionResponse },
+#endif
+#if defined(IRIDIUM_CONFIG_GET_CHANNEL_VALUE_SLAVE)
+   // Получение значения канала управления (запрос)
+   {  IRIDIUM_MESSAGE_GET_CHANNEL_VALUE,         IRIDIUM_REQUEST,  0, &CIridiumProtocol::ReceiveGetChannelValueRequest },
+#endif
+#if defined(IRIDIUM_CONFIG_GET_CHANNEL_VALUE_MASTER)
+   // Получение значения канала управления (ответ)
+   {  IRIDIUM_MESSAGE_GET_CHANNEL_VALUE,         IRIDIUM_RESPONSE, 0, &CIridiumProtocol::ReceiveGetChannelValueResponse },
+#endif
+#if defined(IRIDIUM_CONFIG_BATCH_SLAVE)
+   // Пакетное выполнение операций с каналами (запрос)
+   {  IRIDIUM_MESSAGE_BATCH,                     IRIDIUM_REQUEST,  0, &CIridiumProtocol::ReceiveBatchRequest },
+#endif
+#if defined(IRIDIUM_CONFIG_BATCH_MASTER)
+   // Пакетное выполнение операций с каналами (ответ)
+   {  IRIDIUM_MESSAGE_BATCH,                     IRIDIUM_RESPONSE, 0, &CIridiumProtocol::ReceiveBatchResponse },
+#endif
+
+#if defined(IRIDIUM_CONFIG_STREAM_OPEN_SLAVE)
+   // Открытия потока (запрос)
+   {  IRIDIUM_MESSAGE_STREAM_OPEN,               IRIDIUM_REQUEST,  0, &CIridiumProtocol::ReceiveStreamOpenRequest },
+#endif
+#if defined(IRIDIUM_CONFIG_STREAM_OPEN_MASTER)
+   // Открытия потока (ответ)
+   {  IRIDIUM_MESSAGE_STREAM_OPEN,               IRIDIUM_RESPONSE, 0, &CIridiumProtocol::ReceiveStreamOpenResponse },
+#endif
+#if defined(IRIDIUM_CONFIG_STREAM_BLOCK_SLAVE)
+   // Передача блока потока (запрос)
+   {  IRIDIUM_MESSAGE_STREAM_BLOCK,              IRIDIUM_REQUEST,  0, &CIridiumProtocol::ReceiveStreamBlockRequest },
+#endif
+#if defined(IRIDIUM_CONFIG_STREAM_BLOCK_MASTER)
+   // Передача блока потока (ответ)
+   {  IRIDIUM_MESSAGE_STREAM_BLOCK,              IRIDIUM_RESPONSE, 0, &CIridiumProtocol::ReceiveStreamBlockResponse },
+#endif
+#if defined(IRIDIUM_CONFIG_STREAM_CLOSE_SLAVE)
+   // Закрытия потока (запрос)
+   {  IRIDIUM_MESSAGE_STREAM_CLOSE,              IRIDIUM_REQUEST,  0, &CIridiumProtocol::ReceiveStreamCloseRequest },
+#endif
+#if defined(IRIDIUM_CONFIG_STREAM_CLOSE_MASTER)
+   // Закрытия потока (ответ)
+   {  IRIDIUM_MESSAGE_STREAM_CLOSE,              IRIDIUM_RESPONSE, 0, &CIridiumProtocol::ReceiveStreamCloseResponse },
+#endif
+
+   // Конец таблицы
+   {  0,                                         IRIDIUM_REQUEST,  0, NULL },
+};
+
+// Количество обработчиков в таблице (без завершающей записи)
+#define IRIDIUM_MESSAGE_HANDLERS (sizeof(g_aMessageHandlers) / sizeof(g_aMessageHandlers[0]) - 1)
+
+// Индекс первой строки таблицы обработчиков для каждого типа сообщения (0 - обработчиков нет)
+static u8 g_aMessageIndex[IRIDIUM_MESSAGE_MAX + 1];
+static bool g_bMessageIndex = false;
+
+/**
+   Построение индекса таблицы обработчиков сообщений
+   на входе    :  *
+   на выходе   :  *
+   примечание  :  индекс строится один раз и используется всеми экземплярами протокола
+*/
+static void InitMessageIndex()
+{
+   if(!g_bMessageIndex)
+   {
+      // Просмотр с конца, в индекс попадает первая строка каждого типа
+      for(size_t i = IRIDIUM_MESSAGE_HANDLERS; i > 0; i--)
+      {
+         u8 l_u8Type = g_aMessageHandlers[i - 1].m_u8Type;
+         if(l_u8Type <= IRIDIUM_MESSAGE_MAX)
+            g_aMessageIndex[l_u8Type] = (u8)i;
+      }
+      g_bMessageIndex = true;
+   }
+}
+
 /**
    Конструктор класса
    на входе    :  *
@@ -35,8 +256,28 @@ CIridiumProtocol::CIridiumProtocol()
 
    // Подготовка структрур для отправки данных
    memset(&m_OutPH, 0, sizeof(m_OutPH));
-   memset(&m_OutMH, 0, sizeof(m_OutMH));
-   m_pOutMessage = NULL;
+   m_Builder.Init(this, NULL);
+
+   // Подготовка обработчиков сообщений
+   m_pMessageHandlers = NULL;
+   m_stMessageHandlers = 0;
+   InitMessageIndex();
+
+#if defined(IRIDIUM_ENABLE_TRANSACTIONS)
+   // Подготовка данных транзакций
+   m_u32Time = 0;
+#endif
+
+#if defined(IRIDIUM_ENABLE_CATALOG_HASH)
+   // Хэш каталога будет рассчитан при первом запросе
+   m_bCatalogHash = false;
+   m_u32CatalogHash = 0;
+   memset(m_aCatalogBuffer, 0, sizeof(m_aCatalogBuffer));
+#endif
+
+#if defined(IRIDIUM_ENABLE_STREAM_WINDOW) && defined(IRIDIUM_CONFIG_STREAM_OPEN_SLAVE)
+   m_u8StreamWindow = 0;
+#endif
 
    // Сброс данных
    Reset();
@@ -58,6 +299,43 @@ void CIridiumProtocol::Reset()
 {
    m_bEnableLongString = false;
    m_u16TID = 0;
+
+#if defined(IRIDIUM_ENABLE_TRANSACTIONS)
+   // Ожидающие ответа запросы теряют смысл
+   m_Transactions.Clear();
+   m_Builder.m_bTransaction = false;
+#endif
+
+#if defined(IRIDIUM_CONFIG_SUBSCRIBE_TAG_SLAVE)
+   // Подписчики должны подписаться заново
+   m_Subscriptions.Clear();
+#endif
+
+#if defined(IRIDIUM_ENABLE_SEARCH_SLOTS)
+#if defined(IRIDIUM_CONFIG_SYSTEM_SEARCH_MASTER)
+   m_Search.Stop();
+#endif
+#if defined(IRIDIUM_CONFIG_SYSTEM_SEARCH_SLAVE)
+   m_bSearchResponse = false;
+   m_bSearchStart = false;
+   m_SearchAddr = 0;
+   m_u16SearchTID = 0;
+   m_u32SearchDelay = 0;
+   m_u32SearchTime = 0;
+#endif
+#endif   // defined(IRIDIUM_ENABLE_SEARCH_SLOTS)
+
+#if defined(IRIDIUM_ENABLE_STREAM_WINDOW)
+   // Открытые окнами потоки закрываются
+#if defined(IRIDIUM_CONFIG_STREAM_BLOCK_SLAVE)
+   m_StreamRx.Close();
+#endif
+#if defined(IRIDIUM_CONFIG_STREAM_BLOCK_MASTER)
+   for(size_t i = 0; i < IRIDIUM_STREAM_MAX_TX; i++)
+      m_aStreamTx[i].Close();
+   m_stStreamTx = 0;
+#endif
+#endif   // defined(IRIDIUM_ENABLE_STREAM_WINDOW)
 }
 
 #if defined(IRIDIUM_CONFIG_SYSTEM_PING_MASTER)
@@ -117,12 +395,55 @@ void CIridiumProtocol::ReceiveSearchResponse()
    // Получение информации об удаленном устройстве
    if(m_pInMessage->GetSearchInfo(l_Info))
    {
+#if defined(IRIDIUM_ENABLE_SEARCH_SLOTS)
+      // Учет ответа в загрузке текущего раунда поиска
+      Lock();
+      m_Search.Received(m_InMH.m_u16TID, GetSearchHash(l_Info));
+      Unlock();
+#endif
       // Установка полученных данных
       SetSearchInfo(l_Info);
       m_eError = IRIDIUM_OK;
    }
 }
 
+#if defined(IRIDIUM_ENABLE_SEARCH_SLOTS)
+
+/**
+   Запуск поиска устройств раундами
+   на входе    :  in_DstAddr     - адрес сегмента
+                  in_u8Mask      - маска поиска
+                  in_u8Slots     - количество слотов ответа (не менее 2)
+                  in_u16SlotTime - ширина слота в миллисекундах
+   на выходе   :  успешность запуска
+   примечание  :  запросы отправляются из ProcessSearch, найденные устройства передаются в SetSearchInfo.
+                  Ширина слота должна вмещать передачу ответа и задержку обработки запроса ведомым
+*/
+bool CIridiumProtocol::StartSearch(iridium_address_t in_DstAddr, u8 in_u8Mask, u8 in_u8Slots, u16 in_u16SlotTime)
+{
+   bool l_bResult = false;
+
+   Lock();
+   l_bResult = m_Search.Start(in_DstAddr, in_u8Mask, in_u8Slots, in_u16SlotTime);
+   Unlock();
+
+   return l_bResult;
+}
+
+/**
+   Остановка поиска устройств раундами
+   на входе    :  *
+   на выходе   :  *
+*/
+void CIridiumProtocol::StopSearch()
+{
+   Lock();
+   m_Search.Stop();
+   Unlock();
+}
+
+#endif   // defined(IRIDIUM_ENABLE_SEARCH_SLOTS)
+
 #endif   // #if defined(IRIDIUM_CONFIG_SYSTEM_SEARCH_MASTER)
 
 #if defined(IRIDIUM_CONFIG_SYSTEM_SEARCH_SLAVE)
@@ -145,12 +466,70 @@ void CIridiumProtocol::ReceiveSearchRequest()
       {
          // Если устройство принадлежит к запрашиваемой группе, отправим информацию об устройстве
          if(l_Info.m_u8Group & l_u8Mask)
+         {
+#if defined(IRIDIUM_ENABLE_SEARCH_SLOTS)
+            u32 l_u32Delay = 0;
+            // Устройство вне префикса запроса не отвечает
+            if(GetSearchDelay(l_Info, l_u32Delay))
+            {
+               if(l_u32Delay)
+               {
+                  // Ответ будет отправлен из ProcessSearch в слоте устройства, предыдущий ответ заменяется
+                  m_bSearchResponse = true;
+                  m_bSearchStart = false;
+                  m_SearchAddr = m_pInPH->m_Flags.m_bAddress ? m_pInPH->m_SrcAddr : 0;
+                  m_u16SearchTID = m_InMH.m_u16TID;
+                  m_u32SearchDelay = l_u32Delay;
+               } else
+                  SendSearchResponse(m_InMH.m_u16TID, l_Info);
+            }
+#else
             SendSearchResponse(m_InMH.m_u16TID, l_Info);
+#endif
+         }
       }
    }
    m_eError = IRIDIUM_OK;
 }
 
+#if defined(IRIDIUM_ENABLE_SEARCH_SLOTS)
+
+/**
+   Получение задержки ответа на запрос поиска
+   на входе    :  in_rInfo    - ссылка на данные устройства
+                  out_rDelay  - ссылка куда нужно поместить задержку ответа в миллисекундах
+   на выходе   :  true - устройство должно ответить, false - хэш HWID не совпадает с префиксом запроса
+   примечание  :  параметры слотов следуют за маской поиска и необязательны, запрос без них обрабатывается
+                  без задержки. Префикс сравнивается с младшими битами хэша HWID, слот выбирается по
+                  следующим битам, поэтому при делении префикса устройства распределяются по слотам заново
+*/
+bool CIridiumProtocol::GetSearchDelay(iridium_search_info_t& in_rInfo, u32& out_rDelay)
+{
+   bool l_bResult = true;
+   iridium_search_slots_t l_Slots;
+   memset(&l_Slots, 0, sizeof(l_Slots));
+   out_rDelay = 0;
+
+   // Получение параметров слотов
+   if(m_pInMessage->GetU8(l_Slots.m_u8Slots) && m_pInMessage->GetU16LE(l_Slots.m_u16SlotTime))
+   {
+      if(!m_pInMessage->GetU8(l_Slots.m_u8Bits) || !m_pInMessage->GetU16LE(l_Slots.m_u16Prefix))
+         l_Slots.m_u8Bits = 0;
+
+      u16 l_u16Hash = GetSearchHash(in_rInfo);
+      u8 l_u8Bits = (l_Slots.m_u8Bits < 16) ? l_Slots.m_u8Bits : 16;
+      u16 l_u16Mask = (u16)((1UL << l_u8Bits) - 1);
+
+      // Проверка префикса и вычисление слота
+      l_bResult = ((l_u16Hash & l_u16Mask) == (l_Slots.m_u16Prefix & l_u16Mask));
+      if(l_bResult && l_Slots.m_u8Slots > 1)
+         out_rDelay = (u32)(((u32)l_u16Hash >> l_u8Bits) % l_Slots.m_u8Slots) * l_Slots.m_u16SlotTime;
+   }
+   return l_bResult;
+}
+
+#endif   // defined(IRIDIUM_ENABLE_SEARCH_SLOTS)
+
 /**
    Отправка успешного ответа на поиск устройств
    на входе    :  in_u16TID   - идентификатор транзакции
@@ -160,30 +539,95 @@ void CIridiumProtocol::ReceiveSearchRequest()
 */
 bool CIridiumProtocol::SendSearchResponse(u16 in_u16TID, iridium_search_info_t& in_rInfo)
 {
+   return SendSearchResponse(m_pInPH->m_Flags.m_bAddress ? m_pInPH->m_SrcAddr : 0, in_u16TID, in_rInfo);
+}
+
+/**
+   Отправка успешного ответа на поиск устройств указанному получателю
+   на входе    :  in_DstAddr  - адрес получателя (0 - широковещательный ответ)
+                  in_u16TID   - идентификатор транзакции
+                  in_rInfo    - ссылка на данные устройства
+   на выходе   :  успешность
+   примечание  :  используется для отложенного ответа, когда данные входящего пакета уже недоступны
+*/
+bool CIridiumProtocol::SendSearchResponse(iridium_address_t in_DstAddr, u16 in_u16TID, iridium_search_info_t& in_rInfo)
+{
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
+
    // Заполнение заголовка пакета
-   m_OutPH.m_Flags.m_bAddress    = true;
-   m_OutPH.m_SrcAddr             = m_Address;
-   m_OutPH.m_DstAddr             = m_pInPH->m_Flags.m_bAddress ? m_pInPH->m_SrcAddr : 0;
+   l_pOut->m_PH.m_Flags.m_bAddress = true;
+   l_pOut->m_PH.m_SrcAddr          = m_Address;
+   l_pOut->m_PH.m_DstAddr          = in_DstAddr;
 
    // Заполнение заголовка сообщения
-   m_OutMH.m_Flags.m_bDirection  = IRIDIUM_RESPONSE;
-   m_OutMH.m_Flags.m_bError      = IRIDIUM_NO_ERROR;
-   m_OutMH.m_Flags.m_bNoTID      = (0 == in_u16TID);
-   m_OutMH.m_Flags.m_bEnd        = true;
-   m_OutMH.m_Flags.m_u4Version   = GetMessageVersion(IRIDIUM_MESSAGE_SYSTEM_SEARCH);
-   m_OutMH.m_u8Type              = IRIDIUM_MESSAGE_SYSTEM_SEARCH;
-   m_OutMH.m_u16TID              = in_u16TID;
+   l_pOut->m_MH.m_Flags.m_bDirection = IRIDIUM_RESPONSE;
+   l_pOut->m_MH.m_Flags.m_bError     = IRIDIUM_NO_ERROR;
+   l_pOut->m_MH.m_Flags.m_bNoTID     = (0 == in_u16TID);
+   l_pOut->m_MH.m_Flags.m_bEnd       = true;
+   l_pOut->m_MH.m_Flags.m_u4Version  = GetMessageVersion(IRIDIUM_MESSAGE_SYSTEM_SEARCH);
+   l_pOut->m_MH.m_u8Type             = IRIDIUM_MESSAGE_SYSTEM_SEARCH;
+   l_pOut->m_MH.m_u16TID             = in_u16TID;
 
    // Начало работы с пакетом
-   Begin();
+   l_pOut->Begin();
    // Добавление информации об устройстве в поток
-   m_pOutMessage->AddSearchInfo(in_rInfo);
+   l_pOut->m_pBuffer->AddSearchInfo(in_rInfo);
    // Окончание работы и отправка пакета
-   return End();
+   return l_pOut->End();
 }
 
 #endif   // #if defined(IRIDIUM_CONFIG_SYSTEM_SEARCH_SLAVE)
 
+#if defined(IRIDIUM_ENABLE_SEARCH_SLOTS) && (defined(IRIDIUM_CONFIG_SYSTEM_SEARCH_MASTER) || defined(IRIDIUM_CONFIG_SYSTEM_SEARCH_SLAVE))
+
+/**
+   Отправка отложенных ответов и запросов раундов поиска
+   на входе    :  in_u32Time  - монотонное время платформы в миллисекундах
+   на выходе   :  *
+   примечание  :  задержка ответа отсчитывается от первого вызова после получения запроса, поэтому метод
+                  нужно вызывать чаще ширины слота. Если ответ не удалось отправить, он будет отправлен
+                  при следующем вызове
+*/
+void CIridiumProtocol::ProcessSearch(u32 in_u32Time)
+{
+#if defined(IRIDIUM_CONFIG_SYSTEM_SEARCH_SLAVE)
+   // Отправка ответа в слоте устройства
+   if(m_bSearchResponse)
+   {
+      if(!m_bSearchStart)
+      {
+         m_u32SearchTime = in_u32Time;
+         m_bSearchStart = true;
+      }
+      if((u32)(in_u32Time - m_u32SearchTime) >= m_u32SearchDelay)
+      {
+         iridium_search_info_t l_Info;
+         memset(&l_Info, 0, sizeof(l_Info));
+         if(!GetSearchInfo(l_Info) || SendSearchResponse(m_SearchAddr, m_u16SearchTID, l_Info))
+            m_bSearchResponse = false;
+      }
+   }
+#endif
+
+#if defined(IRIDIUM_CONFIG_SYSTEM_SEARCH_MASTER)
+   Lock();
+   // Отправка запроса следующего раунда по окончании текущего
+   if(m_Search.IsDue(in_u32Time))
+   {
+      iridium_search_slots_t l_Slots;
+      u16 l_u16TID = GetTID();
+      if(m_Search.Next(l_u16TID, in_u32Time, l_Slots))
+      {
+         if(!SendSearchRequest(m_Search.GetAddress(), m_Search.GetMask(), l_u16TID, &l_Slots))
+            m_Search.Repeat();
+      }
+   }
+   Unlock();
+#endif
+}
+
+#endif   // defined(IRIDIUM_ENABLE_SEARCH_SLOTS)
+
 #if defined(IRIDIUM_CONFIG_SYSTEM_DEVICE_INFO_MASTER)
 
 /**
@@ -225,6 +669,7 @@ void CIridiumProtocol::ReceiveDeviceInfoResponse()
 */
 void CIridiumProtocol::ReceiveDeviceInfoRequest()
 {
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
    bool l_bResult = false;
    iridium_device_info_t l_Info;
    memset(&l_Info, 0, sizeof(iridium_device_info_t));
@@ -232,15 +677,19 @@ void CIridiumProtocol::ReceiveDeviceInfoRequest()
    // Получение данных устройства
    if(GetDeviceInfo(l_Info))
    {
+#if defined(IRIDIUM_ENABLE_CATALOG_HASH)
+      // Добавление хэша каталога каналов
+      l_Info.m_u32Catalog = GetCatalogHash();
+#endif
       // Инициализация пакета ответа
       InitResponsePacket();
       // Начало работы с пакетом
-      Begin();
+      l_pOut->Begin();
       // Добавление информации об устройстве в поток
-      l_bResult = m_pOutMessage->AddDeviceInfo(l_Info);
+      l_bResult = l_pOut->m_pBuffer->AddDeviceInfo(l_Info);
       // Окончание работы и отправка пакета
       if(l_bResult)
-         l_bResult = End();
+         l_bResult = l_pOut->End();
    }
    // Проверка наличия ошибки
    if(!l_bResult)
@@ -249,6 +698,104 @@ void CIridiumProtocol::ReceiveDeviceInfoRequest()
 
 #endif   // #if defined(IRIDIUM_CONFIG_SYSTEM_DEVICE_INFO_SLAVE)
 
+#if defined(IRIDIUM_ENABLE_CATALOG_HASH)
+
+/**
+   Получение хэша каталога каналов
+   на входе    :  *
+   на выходе   :  хэш каталога, 0 - данные канала не поместились в буфер IRIDIUM_CATALOG_BUFFER_SIZE
+   примечание  :  хэш учитывает идентификаторы, имена и типы каналов обратной связи и управления и их описания
+                  в том виде, в котором они передаются ведущему, значения каналов не учитываются. Хэш рассчитывается
+                  при первом запросе и сбрасывается при связывании каналов с глобальными переменными, остальные
+                  изменения каталога приложение должно отметить вызовом SetCatalogChanged. Ведущий, у которого
+                  сохранен каталог устройства с тем же HWID, версией и хэшем, может не запрашивать списки и описания.
+                  Если данные канала не помещаются в буфер, хэш не сообщается и ведущий запрашивает каталог полностью
+*/
+u32 CIridiumProtocol::GetCatalogHash()
+{
+   Lock();
+   if(!m_bCatalogHash)
+   {
+      CIridiumOutBuffer l_Buffer;
+      u32 l_u32Hash = IRIDIUM_HASH32_INIT;
+      bool l_bResult = true;
+
+      l_Buffer.SetBuffer(0, 0, m_aCatalogBuffer, sizeof(m_aCatalogBuffer));
+
+      // Учет каналов обратной связи
+      size_t l_stSize = GetTags();
+      l_Buffer.AddU32LE((u32)l_stSize);
+      for(size_t i = 0; l_bResult && i < l_stSize; i++)
+      {
+         iridium_tag_info_t l_Tag;
+         iridium_tag_description_t l_Desc;
+         memset(&l_Tag, 0, sizeof(l_Tag));
+         memset(&l_Desc, 0, sizeof(l_Desc));
+
+         if(GetTagData(i, l_Tag, sizeof(l_Tag)))
+         {
+            l_bResult = l_Buffer.AddU32LE(l_Tag.m_u32ID);
+#if defined(IRIDIUM_AVR_PLATFORM)
+            if(l_bResult)
+               l_bResult = l_Buffer.AddStringFromFlash(l_Tag.m_pszName);
+#else
+            if(l_bResult)
+               l_bResult = l_Buffer.AddString(l_Tag.m_pszName);
+#endif
+            if(l_bResult)
+               l_bResult = l_Buffer.AddU8(l_Tag.m_u8Type);
+            if(l_bResult && GetTagDescription(l_Tag.m_u32ID, l_Desc))
+               l_bResult = l_Buffer.AddTagDescription(l_Desc);
+         }
+         // Накопление хэша по одному каналу, буфер вмещает данные одного канала
+         l_u32Hash = GetHash32(l_u32Hash, l_Buffer.GetBuffer(), l_Buffer.Size());
+         l_Buffer.Clear();
+      }
+
+      // Учет каналов управления
+      l_stSize = GetChannels();
+      l_Buffer.AddU32LE((u32)l_stSize);
+      for(size_t i = 0; l_bResult && i < l_stSize; i++)
+      {
+         iridium_channel_info_t l_Channel;
+         iridium_channel_description_t l_Desc;
+         memset(&l_Channel, 0, sizeof(l_Channel));
+         memset(&l_Desc, 0, sizeof(l_Desc));
+
+         if(GetChannelData(i, l_Channel))
+         {
+            l_bResult = l_Buffer.AddU32LE(l_Channel.m_u32ID);
+#if defined(IRIDIUM_AVR_PLATFORM)
+            if(l_bResult)
+               l_bResult = l_Buffer.AddStringFromFlash(l_Channel.m_pszName);
+#else
+            if(l_bResult)
+               l_bResult = l_Buffer.AddString(l_Channel.m_pszName);
+#endif
+            if(l_bResult)
+               l_bResult = l_Buffer.AddU8(l_Channel.m_u8Type);
+            if(l_bResult && GetChannelDescription(l_Channel.m_u32ID, l_Desc))
+               l_bResult = l_Buffer.AddChannelDescription(l_Desc);
+         }
+         l_u32Hash = GetHash32(l_u32Hash, l_Buffer.GetBuffer(), l_Buffer.Size());
+         l_Buffer.Clear();
+      }
+
+      // Значение 0 означает отсутствие хэша, усеченные данные канала не учитываются
+      if(!l_bResult)
+         l_u32Hash = 0;
+      else if(!l_u32Hash)
+         l_u32Hash = 1;
+      m_u32CatalogHash = l_u32Hash;
+      m_bCatalogHash = true;
+   }
+   u32 l_u32Result = m_u32CatalogHash;
+   Unlock();
+   return l_u32Result;
+}
+
+#endif   // defined(IRIDIUM_ENABLE_CATALOG_HASH)
+
 #if defined(IRIDIUM_CONFIG_SYSTEM_SET_LID_MASTER)
 
 /**
@@ -349,6 +896,7 @@ void CIridiumProtocol::ReceiveSmartAPIResponse()
 */
 void CIridiumProtocol::ReceiveSmartAPIRequest()
 {
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
    bool l_bResult = true;
    size_t l_stRemain = (size_t)-1;
    universal_value_t l_Value;
@@ -367,15 +915,15 @@ void CIridiumProtocol::ReceiveSmartAPIRequest()
    while(l_bResult && l_stRemain)
    {
       // Начало работы с пакетом
-      Begin();
+      l_pOut->Begin();
       // Добавление значения запроса
-      l_bResult = m_pOutMessage->AddValue(IVT_ARRAY_U8, l_Value, l_stRemain, 0);
+      l_bResult = l_pOut->m_pBuffer->AddArrayRef(l_Value, l_stRemain, 0);
       if(l_bResult)
       {
          // Установка флага конца цепочки
-         m_OutMH.m_Flags.m_bEnd = (l_stRemain == 0);
+         l_pOut->m_MH.m_Flags.m_bEnd = (l_stRemain == 0);
          // Окончание работы и отправка пакета
-         l_bResult = End();
+         l_bResult = l_pOut->End();
       }
    }
 }
@@ -394,42 +942,43 @@ void CIridiumProtocol::ReceiveSmartAPIRequest()
 */
 bool CIridiumProtocol::SendSetVariableRequest(u16 in_u16Variable, u8 in_u8Type, universal_value_t& in_rValue)
 {
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
    bool l_bResult = false;
    size_t l_stRemain = (size_t)-1;
    // Проверка входнях данных
    if(in_u16Variable)
    {
       // Заполнение заголовка пакета
-      m_OutPH.m_Flags.m_bAddress    = false; // Запрос всегда широковещательный
+      l_pOut->m_PH.m_Flags.m_bAddress = false; // Запрос всегда широковещательный
 
       // Заполнение заголовка сообщения
-      m_OutMH.m_Flags.m_bDirection  = IRIDIUM_REQUEST;
-      m_OutMH.m_Flags.m_bError      = IRIDIUM_NO_ERROR;
-      m_OutMH.m_Flags.m_bNoTID      = true;
-      m_OutMH.m_Flags.m_bEnd        = true;
-      m_OutMH.m_Flags.m_u4Version   = GetMessageVersion(IRIDIUM_MESSAGE_SET_VARIABLE);
-      m_OutMH.m_u8Type              = IRIDIUM_MESSAGE_SET_VARIABLE;
+      l_pOut->m_MH.m_Flags.m_bDirection = IRIDIUM_REQUEST;
+      l_pOut->m_MH.m_Flags.m_bError     = IRIDIUM_NO_ERROR;
+      l_pOut->m_MH.m_Flags.m_bNoTID     = true;
+      l_pOut->m_MH.m_Flags.m_bEnd       = true;
+      l_pOut->m_MH.m_Flags.m_u4Version  = GetMessageVersion(IRIDIUM_MESSAGE_SET_VARIABLE);
+      l_pOut->m_MH.m_u8Type             = IRIDIUM_MESSAGE_SET_VARIABLE;
 
       // Выполнять пока нет ошибки и все данные значения не переданы
       l_bResult = true;
       while(l_bResult && l_stRemain)
       {
          // Начало работы с пакетом
-         Begin();
+         l_pOut->Begin();
          // Добавление значение глобальной переменной
-         l_bResult = m_pOutMessage->AddValue(in_u8Type, in_rValue, l_stRemain, 0);
+         l_bResult = l_pOut->m_pBuffer->AddValue(in_u8Type, in_rValue, l_stRemain, 0);
          if(l_bResult)
          {
             // Добавление идентификатора глобальной переменной
-            l_bResult = m_pOutMessage->AddU16LE(in_u16Variable);
+            l_bResult = l_pOut->m_pBuffer->AddU16LE(in_u16Variable);
 
             // Если есть хотябы один канал, закончим формирование пакета с последующей отправкой
             if(l_bResult)
             {
                // Установка флага конца цепочки
-               m_OutMH.m_Flags.m_bEnd = (l_stRemain == 0);
+               l_pOut->m_MH.m_Flags.m_bEnd = (l_stRemain == 0);
                // Окончание работы и отправка пакета
-               l_bResult = End();
+               l_bResult = l_pOut->End();
             }
          }
       }
@@ -480,28 +1029,29 @@ void CIridiumProtocol::ReceiveSetVariableRequest()
 */
 bool CIridiumProtocol::SendGetVariableRequest(u16 in_u16Variable)
 {
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
    bool l_bResult = false;
    // Проверка входнях данных
    if(in_u16Variable)
    {
       // Заполнение заголовка пакета
-      m_OutPH.m_Flags.m_bAddress    = false; // Запрос всегда широковещательный
+      l_pOut->m_PH.m_Flags.m_bAddress = false; // Запрос всегда широковещательный
 
       // Заполнение заголовка сообщения
-      m_OutMH.m_Flags.m_bDirection  = IRIDIUM_REQUEST;
-      m_OutMH.m_Flags.m_bError      = IRIDIUM_NO_ERROR;
-      m_OutMH.m_Flags.m_bNoTID      = false;
-      m_OutMH.m_Flags.m_bEnd        = true;
-      m_OutMH.m_Flags.m_u4Version   = GetMessageVersion(IRIDIUM_MESSAGE_GET_VARIABLE);
-      m_OutMH.m_u8Type              = IRIDIUM_MESSAGE_GET_VARIABLE;
-      m_OutMH.m_u16TID              = GetTID();
+      l_pOut->m_MH.m_Flags.m_bDirection = IRIDIUM_REQUEST;
+      l_pOut->m_MH.m_Flags.m_bError     = IRIDIUM_NO_ERROR;
+      l_pOut->m_MH.m_Flags.m_bNoTID     = false;
+      l_pOut->m_MH.m_Flags.m_bEnd       = true;
+      l_pOut->m_MH.m_Flags.m_u4Version  = GetMessageVersion(IRIDIUM_MESSAGE_GET_VARIABLE);
+      l_pOut->m_MH.m_u8Type             = IRIDIUM_MESSAGE_GET_VARIABLE;
+      l_pOut->m_MH.m_u16TID             = GetTID();
 
       // Начало работы с пакетом
-      Begin();
+      l_pOut->Begin();
       // Добавляем идентификатор глобальной переменной
-      m_pOutMessage->AddU16LE(in_u16Variable);
+      l_pOut->m_pBuffer->AddU16LE(in_u16Variable);
       // Окончание работы и отправка пакета
-      l_bResult = End();
+      l_bResult = l_pOut->End();
    }
    return l_bResult;
 }
@@ -555,27 +1105,28 @@ void CIridiumProtocol::ReceiveGetVariableRequest()
 */
 bool CIridiumProtocol::SendGetVariableResponse(u16 in_u16Variable, u8 in_u8Type, universal_value_t& in_rValue)
 {
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
    size_t l_stPosition = (size_t)-1;
    // Заполнение заголовка пакета
-   m_OutPH.m_Flags.m_bAddress    = false; // ответ всегда широковещательный
+   l_pOut->m_PH.m_Flags.m_bAddress = false; // ответ всегда широковещательный
 
    // Заполнение заголовка сообщения
-   m_OutMH.m_Flags.m_bDirection  = IRIDIUM_RESPONSE;
-   m_OutMH.m_Flags.m_bError      = IRIDIUM_NO_ERROR;
-   m_OutMH.m_Flags.m_bNoTID      = false;
-   m_OutMH.m_Flags.m_bEnd        = true;
-   m_OutMH.m_Flags.m_u4Version   = GetMessageVersion(IRIDIUM_MESSAGE_GET_VARIABLE);
-   m_OutMH.m_u8Type              = IRIDIUM_MESSAGE_GET_VARIABLE;
-   m_OutMH.m_u16TID              = m_InMH.m_u16TID;
+   l_pOut->m_MH.m_Flags.m_bDirection = IRIDIUM_RESPONSE;
+   l_pOut->m_MH.m_Flags.m_bError     = IRIDIUM_NO_ERROR;
+   l_pOut->m_MH.m_Flags.m_bNoTID     = false;
+   l_pOut->m_MH.m_Flags.m_bEnd       = true;
+   l_pOut->m_MH.m_Flags.m_u4Version  = GetMessageVersion(IRIDIUM_MESSAGE_GET_VARIABLE);
+   l_pOut->m_MH.m_u8Type             = IRIDIUM_MESSAGE_GET_VARIABLE;
+   l_pOut->m_MH.m_u16TID             = m_InMH.m_u16TID;
 
    // Начало работы с пакетом
-   Begin();
+   l_pOut->Begin();
    // Добавление идентификатора глобальной переменной
-   m_pOutMessage->AddU16LE(in_u16Variable);
+   l_pOut->m_pBuffer->AddU16LE(in_u16Variable);
    // Добавление значения глобальной переменной
-   m_pOutMessage->AddValue(in_u8Type, in_rValue, l_stPosition, 0);
+   l_pOut->m_pBuffer->AddValue(in_u8Type, in_rValue, l_stPosition, 0);
    // Окончание работы и отправка пакета
-   return End();
+   return l_pOut->End();
 }
 
 #endif   // #if defined(IRIDIUM_CONFIG_GET_VARIABLE_SLAVE)
@@ -592,6 +1143,29 @@ bool CIridiumProtocol::SendGetTagsRequest(iridium_address_t in_DstAddr)
    return SendRequest(in_DstAddr, IRIDIUM_MESSAGE_GET_TAGS);
 }
 
+/**
+   Отправка запроса на получение страницы списка тегов
+   на входе    :  in_DstAddr  - адрес получателя
+                  in_u16Start - индекс первого канала страницы (продолжение из предыдущего ответа)
+                  in_u16Count - максимальное количество каналов на странице (0 - до конца списка)
+   нв выходе   :  успешность
+   примечание  :  каждый пакет ответа содержит продолжение списка, которое передается в TagsPage
+*/
+bool CIridiumProtocol::SendGetTagsRequest(iridium_address_t in_DstAddr, u16 in_u16Start, u16 in_u16Count)
+{
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
+
+   // Заполнение данных пакета
+   InitRequestPacket(in_DstAddr, IRIDIUM_MESSAGE_GET_TAGS);
+   // Начало работы с пакетом
+   l_pOut->Begin();
+   // Добавление параметров страницы
+   l_pOut->m_pBuffer->AddU16LE(in_u16Start);
+   l_pOut->m_pBuffer->AddU16LE(in_u16Count);
+   // Окончание работы и отправка пакета
+   return l_pOut->End();
+}
+
 /**
    Обработка полученого ответа на запроса получения списка каналов обратной связи
    на входе    :  *
@@ -600,6 +1174,7 @@ bool CIridiumProtocol::SendGetTagsRequest(iridium_address_t in_DstAddr)
 void CIridiumProtocol::ReceiveGetTagsResponse()
 {
    u16 l_u16Tags = 0;
+   u16 l_u16Next = 0;
    iridium_tag_info_t l_Info;
    // Получение количества тегов
    m_pInMessage->GetU16LE(l_u16Tags);
@@ -614,7 +1189,13 @@ void CIridiumProtocol::ReceiveGetTagsResponse()
       // Отправка полученных данных родителю
       SetTagData(l_Info);
    }
-   if(m_InMH.m_Flags.m_bEnd)
+   // Получение продолжения списка (есть только в ответе на запрос страницы)
+   if(m_pInMessage->GetU16LE(l_u16Next))
+   {
+      TagsPage(l_u16Next, m_InMH.m_Flags.m_bEnd);
+      if(m_InMH.m_Flags.m_bEnd && !l_u16Next)
+         EndTags();
+   } else if(m_InMH.m_Flags.m_bEnd)
       EndTags();
 }
 
@@ -629,6 +1210,7 @@ void CIridiumProtocol::ReceiveGetTagsResponse()
 */
 void CIridiumProtocol::ReceiveGetTagsRequest()
 {
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
    bool l_bResult = true;
    iridium_tag_info_t l_Tag;
    size_t l_stPosition = (size_t)-1;
@@ -639,15 +1221,27 @@ void CIridiumProtocol::ReceiveGetTagsRequest()
    // Получение количества тегов
    size_t l_stSize = GetTags();
    size_t l_stCurrent = 0;
-   while(l_bResult && l_stCurrent < l_stSize)
+   size_t l_stEnd = l_stSize;
+   size_t l_stReserve = 0;
+   // Получение границ страницы списка
+   bool l_bPage = GetListPage(l_stSize, l_stCurrent, l_stEnd);
+   bool l_bFirst = true;
+
+   // Место под продолжение списка в каждом пакете страницы
+   if(l_bPage)
+      l_stReserve = sizeof(u16);
+
+   // Страница отправляется даже пустой, чтобы ведущий получил продолжение списка
+   while(l_bResult && (l_stCurrent < l_stEnd || (l_bPage && l_bFirst)))
    {
       u16 l_u16Count = 0;
+      l_bFirst = false;
       // Начало работы с пакетом
-      Begin();
+      l_pOut->Begin();
       // Зарезервируем количество тегов
-      m_pOutMessage->CreateAnchorU16();
+      l_pOut->m_pBuffer->CreateAnchorU16();
       // Обработка списка тегов
-      for( ; l_stCurrent < l_stSize; l_stCurrent++)
+      for( ; l_stCurrent < l_stEnd; l_stCurrent++)
       {
          // Получение данных тега
          size_t l_stLen = GetTagData(l_stCurrent, l_Tag, sizeof(l_Tag));
@@ -655,27 +1249,34 @@ void CIridiumProtocol::ReceiveGetTagsRequest()
          {
             l_stPosition = (size_t)-1;
             // Проверка свободного места в буфере для помещения данных канала обратной связи, иначе остановка добавления данных
-            if(m_pOutMessage->Free() > l_stLen)
+            if(l_pOut->m_pBuffer->Free() > l_stLen + l_stReserve)
             {
                // Запись данных тега
-               m_pOutMessage->AddU32LE(l_Tag.m_u32ID);
+               l_pOut->m_pBuffer->AddU32LE(l_Tag.m_u32ID);
 #if defined(IRIDIUM_AVR_PLATFORM)
-               m_pOutMessage->AddStringFromFlash(l_Tag.m_pszName);
+               l_pOut->m_pBuffer->AddStringFromFlash(l_Tag.m_pszName);
 #else
-               m_pOutMessage->AddString(l_Tag.m_pszName);
+               l_pOut->m_pBuffer->AddString(l_Tag.m_pszName);
 #endif
-               m_pOutMessage->AddValue(l_Tag.m_u8Type, l_Tag.m_Value, l_stPosition, 0);
+               l_pOut->m_pBuffer->AddValue(l_Tag.m_u8Type, l_Tag.m_Value, l_stPosition, 0);
                l_u16Count++;
             } else
                break;
          }
       }
       // Установка флага конца цепочки
-      m_OutMH.m_Flags.m_bEnd = (l_stCurrent == l_stSize);
+      l_pOut->m_MH.m_Flags.m_bEnd = (l_stCurrent == l_stEnd);
       // Обновим количество тегов
-      m_pOutMessage->SetAnchorU16LEValue(l_u16Count);
+      l_pOut->m_pBuffer->SetAnchorU16LEValue(l_u16Count);
+      // Добавление продолжения списка
+      if(l_bPage)
+         l_pOut->m_pBuffer->AddU16LE((l_stCurrent < l_stSize) ? (u16)l_stCurrent : 0);
+      // Канал, который не помещается в пустой пакет, не может быть отправлен
+      if(!l_u16Count && l_stCurrent < l_stEnd)
+         l_bResult = false;
       // Окончание работы и отправка пакета
-      l_bResult = End();
+      if(l_bResult)
+         l_bResult = l_pOut->End();
    }
    // Проверка наличия ошибки
    if(!l_bResult)
@@ -697,41 +1298,42 @@ void CIridiumProtocol::ReceiveGetTagsRequest()
 */
 bool CIridiumProtocol::SendLinkTagAndVariableRequest(iridium_address_t in_DstAddr, u32 in_u32TagID, bool in_bOwner, u16 in_u16Variable, u32 in_u32PIN)
 {
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
    bool l_bResult = false;
    u8 l_u8Temp = 0;
 
    // Заполнение данных пакета
    InitRequestPacket(in_DstAddr, IRIDIUM_MESSAGE_LINK_TAG_AND_VARIABLE);
    // Начало работы с пакетом
-   Begin();
+   l_pOut->Begin();
    // Добавление идентификатора канала обратной связи
-   l_bResult = m_pOutMessage->AddU32LE(in_u32TagID);
+   l_bResult = l_pOut->m_pBuffer->AddU32LE(in_u32TagID);
    if(l_bResult)
    {
       // Зарезирвируем место под флаги
-      l_bResult = m_pOutMessage->CreateAnchorU8();
+      l_bResult = l_pOut->m_pBuffer->CreateAnchorU8();
       if(l_bResult)
       {
          // Добавление PIN кода
          if(in_u32PIN)
          {
-            l_bResult = m_pOutMessage->AddU32LE(in_u32PIN);
+            l_bResult = l_pOut->m_pBuffer->AddU32LE(in_u32PIN);
             // Отметим что есть PIN код
             l_u8Temp |= 0x40;
          }
          // Добавление идентификатора глобальной переменной
          if(l_bResult && in_u16Variable)
          {
-            l_bResult = m_pOutMessage->AddU16LE(in_u16Variable);
+            l_bResult = l_pOut->m_pBuffer->AddU16LE(in_u16Variable);
             // Отметим что есть переменная
             l_u8Temp |= 0x80;
          }
          // Запись флагов
-         m_pOutMessage->SetAnchorU8Value(l_u8Temp | (u8)in_bOwner);
+         l_pOut->m_pBuffer->SetAnchorU8Value(l_u8Temp | (u8)in_bOwner);
 
          // Окончание работы и отправка пакета
          if(l_bResult)
-            l_bResult = End();
+            l_bResult = l_pOut->End();
       }
    }
    return l_bResult;
@@ -783,6 +1385,10 @@ void CIridiumProtocol::ReceiveLinkTagAndVariableRequest()
             // Связывание канала обратной связи и глобальной переменной
             if(LinkTagAndVariable(l_u32ID, l_u8Flags & 1, l_u16Variable))
             {
+#if defined(IRIDIUM_ENABLE_CATALOG_HASH)
+               // Связь с переменной входит в описание канала
+               SetCatalogChanged();
+#endif
                SendResponse(IRIDIUM_OK);
                m_eError = IRIDIUM_OK;
             } else
@@ -808,14 +1414,16 @@ void CIridiumProtocol::ReceiveLinkTagAndVariableRequest()
 */
 bool CIridiumProtocol::SendGetTagDescriptionRequest(iridium_address_t in_DstAddr, u32 in_u32TagID)
 {
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
+
    // Заполнение данных пакета
    InitRequestPacket(in_DstAddr, IRIDIUM_MESSAGE_GET_TAG_DESCRIPTION);
    // Начало работы с пакетом
-   Begin();
+   l_pOut->Begin();
    // Добавление идентификатора канала обратной связи
-   m_pOutMessage->AddU32LE(in_u32TagID);
+   l_pOut->m_pBuffer->AddU32LE(in_u32TagID);
    // Окончание работы и отправка пакета
-   return End();
+   return l_pOut->End();
 }
 
 /**
@@ -848,6 +1456,7 @@ void CIridiumProtocol::ReceiveGetTagDescriptionResponse()
 */
 void CIridiumProtocol::ReceiveGetTagDescriptionRequest()
 {
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
    u32 l_u32TagID = 0;
    iridium_tag_description_t l_Desc;
    memset(&l_Desc, 0, sizeof(l_Desc));
@@ -860,13 +1469,13 @@ void CIridiumProtocol::ReceiveGetTagDescriptionRequest()
       // Инициализация пакета ответа
       InitResponsePacket();
       // Начало работы с пакетом
-      Begin();
+      l_pOut->Begin();
       // Добавление идентификатора канала управления
-      m_pOutMessage->AddU32LE(l_u32TagID);
+      l_pOut->m_pBuffer->AddU32LE(l_u32TagID);
       // Добавление описания канала управления
-      m_pOutMessage->AddTagDescription(l_Desc);
+      l_pOut->m_pBuffer->AddTagDescription(l_Desc);
       // Окончание работы и отправка пакета
-      if(!End())
+      if(!l_pOut->End())
          m_eError = IRIDIUM_UNKNOWN_ERROR;
    } else
       m_eError = IRIDIUM_ERROR_BAD_TAG_ID;
@@ -886,6 +1495,7 @@ void CIridiumProtocol::ReceiveGetTagDescriptionRequest()
 */
 bool CIridiumProtocol::SendSetTagValueRequest(iridium_address_t in_DstAddr, u32 in_u32TagID, u8 in_u8Type, universal_value_t& in_rValue)
 {
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
    bool l_bResult = true;
    size_t l_stRemain = (size_t)-1;
    // Заполнение данных пакета
@@ -895,19 +1505,19 @@ bool CIridiumProtocol::SendSetTagValueRequest(iridium_address_t in_DstAddr, u32
    while(l_bResult && l_stRemain)
    {
       // Начало работы с пакетом
-      Begin();
+      l_pOut->Begin();
       // Добавление идентификатора канала обратной связи
-      l_bResult =  m_pOutMessage->AddU32LE(in_u32TagID);
+      l_bResult =  l_pOut->m_pBuffer->AddU32LE(in_u32TagID);
       if(l_bResult)
       {
          // Добавление значения канала обратной связи
-         l_bResult = m_pOutMessage->AddValue(in_u8Type, in_rValue, l_stRemain, 0);
+         l_bResult = l_pOut->m_pBuffer->AddValue(in_u8Type, in_rValue, l_stRemain, 0);
          if(l_bResult)
          {
             // Установка флага конца цепочки
-            m_OutMH.m_Flags.m_bEnd = (l_stRemain == 0);
+            l_pOut->m_MH.m_Flags.m_bEnd = (l_stRemain == 0);
             // Окончание работы и отправка пакета
-            l_bResult = End();
+            l_bResult = l_pOut->End();
          }
       }
    }
@@ -968,19 +1578,20 @@ void CIridiumProtocol::ReceiveSetTagValueRequest()
 */
 bool CIridiumProtocol::SendGetTagValueRequest(iridium_address_t in_DstAddr, u32 in_u32TagID)
 {
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
    bool l_bResult = false;
 
    // Заполнение данных пакета
    InitRequestPacket(in_DstAddr, IRIDIUM_MESSAGE_GET_TAG_VALUE);
 
    // Начало работы с пакетом
-   Begin();
+   l_pOut->Begin();
    // Добавление идентификатора канала управления
-   l_bResult = m_pOutMessage->AddU32LE(in_u32TagID);
+   l_bResult = l_pOut->m_pBuffer->AddU32LE(in_u32TagID);
    if(l_bResult)
    {
       // Окончание работы и отправка пакета
-      l_bResult = End();
+      l_bResult = l_pOut->End();
    }
    return l_bResult;
 }
@@ -1046,6 +1657,7 @@ void CIridiumProtocol::ReceiveGetTagValueRequest()
 */
 bool CIridiumProtocol::SendGetTagValueResponse(u32 in_u32TagID, iridium_tag_info_t& in_rInfo)
 {
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
    bool l_bResult = true;
    size_t l_stRemain = (size_t)-1;
 
@@ -1056,19 +1668,19 @@ bool CIridiumProtocol::SendGetTagValueResponse(u32 in_u32TagID, iridium_tag_info
    while(l_bResult && l_stRemain)
    {
       // Начало работы с пакетом
-      Begin();
+      l_pOut->Begin();
       // Добавление идентификатора канала управления
-      l_bResult = m_pOutMessage->AddU32LE(in_u32TagID);
+      l_bResult = l_pOut->m_pBuffer->AddU32LE(in_u32TagID);
       if(l_bResult)
       {
          // Добавление значения тега
-         l_bResult = m_pOutMessage->AddValue(in_rInfo.m_u8Type, in_rInfo.m_Value, l_stRemain, 0);
+         l_bResult = l_pOut->m_pBuffer->AddValue(in_rInfo.m_u8Type, in_rInfo.m_Value, l_stRemain, 0);
          if(l_bResult)
          {
             // Установка флага конца цепочки
-            m_OutMH.m_Flags.m_bEnd = (l_stRemain == 0);
+            l_pOut->m_MH.m_Flags.m_bEnd = (l_stRemain == 0);
             // Окончание работы и отправка пакета
-            l_bResult = End();
+            l_bResult = l_pOut->End();
          }
       }
    }
@@ -1077,18 +1689,260 @@ bool CIridiumProtocol::SendGetTagValueResponse(u32 in_u32TagID, iridium_tag_info
 
 #endif   // #if defined(IRIDIUM_CONFIG_GET_TAG_VALUE_SLAVE)
 
-#if defined(IRIDIUM_CONFIG_GET_CHANNELS_MASTER)
+#if defined(IRIDIUM_CONFIG_SUBSCRIBE_TAG_MASTER)
 
 /**
-   Отправка запроса на получение списка тегов
-   на входе    :  in_DstAddr  - адрес получателя
-   нв выходе   :  успешность
+   Запрос подписки на изменение значения канала обратной связи
+   на входе    :  in_DstAddr         - адрес получателя
+                  in_u32TagID        - идентифкатор канала обратной связи
+                  in_u8Flags         - флаги запроса (IRIDIUM_SUBSCRIBE_FLAG_CANCEL - отмена подписки)
+                  in_u32MinInterval  - минимальный интервал между отправками значения в миллисекундах
+                  in_u32MaxInterval  - максимальный интервал между отправками значения в миллисекундах (0 - без контрольной отправки)
+                  in_f32Deadband     - зона нечувствительности для числовых типов (0 - любое изменение)
+   на выходе   :  успешность
+   примечание  :  после подписки получатель сам отправляет значения канала сообщением IRIDIUM_MESSAGE_TAG_NOTIFY
 */
-bool CIridiumProtocol::SendGetChannelsRequest(iridium_address_t in_DstAddr)
+bool CIridiumProtocol::SendSubscribeTagRequest(iridium_address_t in_DstAddr, u32 in_u32TagID, u8 in_u8Flags, u32 in_u32MinInterval, u32 in_u32MaxInterval, f32 in_f32Deadband)
+{
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
+   bool l_bResult = false;
+
+   // Заполнение данных пакета
+   InitRequestPacket(in_DstAddr, IRIDIUM_MESSAGE_SUBSCRIBE_TAG);
+
+   // Начало работы с пакетом
+   l_pOut->Begin();
+   // Добавление параметров подписки
+   l_bResult = l_pOut->m_pBuffer->AddU32LE(in_u32TagID) &&
+               l_pOut->m_pBuffer->AddU8(in_u8Flags) &&
+               l_pOut->m_pBuffer->AddU32LE(in_u32MinInterval) &&
+               l_pOut->m_pBuffer->AddU32LE(in_u32MaxInterval) &&
+               l_pOut->m_pBuffer->AddF32LE(in_f32Deadband);
+   if(l_bResult)
+   {
+      // Окончание работы и отправка пакета
+      l_bResult = l_pOut->End();
+   }
+   return l_bResult;
+}
+
+/**
+   Обработка полученого ответа на запрос подписки
+   на входе    :  *
+   на выходе   :  *
+*/
+void CIridiumProtocol::ReceiveSubscribeTagResponse()
+{
+}
+
+/**
+   Обработка полученого уведомления об изменении значения канала обратной связи
+   на входе    :  *
+   на выходе   :  *
+   примечание  :  уведомление не требует ответа и не имеет идентификатора транзакции
+*/
+void CIridiumProtocol::ReceiveTagNotifyRequest()
+{
+   u8 l_u8Type = 0;
+   universal_value_t l_Value;
+   u32 l_u32ID = 0;
+   // Получение идентификатора канала обратной связи
+   if(m_pInMessage->GetU32LE(l_u32ID))
+   {
+      // Получение значения канала обратной связи
+      if(m_pInMessage->GetValue(l_u8Type, l_Value))
+      {
+         // Оповещение о получении значения канала обратной связи
+         SetTagValue(l_u32ID, l_u8Type, l_Value, m_InMH.m_Flags.m_bEnd);
+      }
+   }
+}
+
+#endif   // #if defined(IRIDIUM_CONFIG_SUBSCRIBE_TAG_MASTER)
+
+#if defined(IRIDIUM_CONFIG_SUBSCRIBE_TAG_SLAVE)
+
+/**
+   Обработка полученого запроса подписки на изменение значения канала обратной связи
+   на входе    :  *
+   на выходе   :  *
+*/
+void CIridiumProtocol::ReceiveSubscribeTagRequest()
+{
+   u32 l_u32ID = 0;
+   u8 l_u8Flags = 0;
+   u32 l_u32MinInterval = 0;
+   u32 l_u32MaxInterval = 0;
+   f32 l_f32Deadband = 0.0f;
+   m_eError = IRIDIUM_PROTOCOL_CORRUPT;
+
+   // Получение параметров подписки
+   if(m_pInMessage->GetU32LE(l_u32ID) &&
+      m_pInMessage->GetU8(l_u8Flags) &&
+      m_pInMessage->GetU32LE(l_u32MinInterval) &&
+      m_pInMessage->GetU32LE(l_u32MaxInterval) &&
+      m_pInMessage->GetF32LE(l_f32Deadband))
+   {
+      if(l_u8Flags & IRIDIUM_SUBSCRIBE_FLAG_CANCEL)
+      {
+         // Отмена подписки, отсутствие подписки ошибкой не считается
+         m_Subscriptions.Remove(l_u32ID, GetSrcAddress());
+         m_eError = IRIDIUM_OK;
+      } else if(GetTagIndex(l_u32ID) == (size_t)-1)
+      {
+         m_eError = IRIDIUM_ERROR_BAD_TAG_ID;
+      } else if(m_Subscriptions.Add(l_u32ID, GetSrcAddress(), l_u32MinInterval, l_u32MaxInterval, l_f32Deadband))
+      {
+         m_eError = IRIDIUM_OK;
+      } else
+         m_eError = IRIDIUM_SERVER_IS_FULL;
+
+      if(m_eError == IRIDIUM_OK)
+         SendResponse(IRIDIUM_OK);
+   }
+}
+
+/**
+   Отправка уведомления об изменении значения канала обратной связи
+   на входе    :  in_DstAddr  - адрес подписчика
+                  in_u32TagID - идентифкатор канала обратной связи
+                  in_rInfo    - ссылка на данные канала обратной связи
+   на выходе   :  успешность
+   примечание  :  уведомление не требует ответа и не имеет идентификатора транзакции
+*/
+bool CIridiumProtocol::SendTagNotifyRequest(iridium_address_t in_DstAddr, u32 in_u32TagID, iridium_tag_info_t& in_rInfo)
+{
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
+   bool l_bResult = true;
+   size_t l_stRemain = (size_t)-1;
+
+   // Заполнение данных пакета
+   InitRequestPacket(in_DstAddr, IRIDIUM_MESSAGE_TAG_NOTIFY);
+   l_pOut->m_MH.m_Flags.m_bNoTID = true;
+
+   // Выполнять пока нет ошибки и все данные значения не переданы
+   while(l_bResult && l_stRemain)
+   {
+      // Начало работы с пакетом
+      l_pOut->Begin();
+      // Добавление идентификатора канала обратной связи
+      l_bResult = l_pOut->m_pBuffer->AddU32LE(in_u32TagID);
+      if(l_bResult)
+      {
+         // Добавление значения канала обратной связи
+         l_bResult = l_pOut->m_pBuffer->AddValue(in_rInfo.m_u8Type, in_rInfo.m_Value, l_stRemain, 0);
+         if(l_bResult)
+         {
+            // Установка флага конца цепочки
+            l_pOut->m_MH.m_Flags.m_bEnd = (l_stRemain == 0);
+            // Окончание работы и отправка пакета
+            l_bResult = l_pOut->End();
+         }
+      }
+   }
+   return l_bResult;
+}
+
+/**
+   Отметка изменения значения канала обратной связи
+   на входе    :  in_u32TagID - идентифкатор канала обратной связи
+   на выходе   :  true - у канала есть подписчики
+   примечание  :  значение не копируется, подписчикам отправляется значение, актуальное на момент отправки
+*/
+bool CIridiumProtocol::SetTagChanged(u32 in_u32TagID)
+{
+   return m_Subscriptions.SetChanged(in_u32TagID);
+}
+
+/**
+   Отправка изменений значений каналов обратной связи подписчикам
+   на входе    :  in_u32Time - монотонное время платформы в миллисекундах
+   на выходе   :  *
+   примечание  :  изменение отправляется не раньше минимального интервала подписки и только если оно вышло
+                  за зону нечувствительности, по истечении максимального интервала значение отправляется
+                  без изменений. Если отправить значение не удалось, оно будет отправлено при следующем вызове.
+                  Подписки на удаленные каналы удаляются
+*/
+void CIridiumProtocol::ProcessSubscriptions(u32 in_u32Time)
+{
+   iridium_tag_info_t l_Tag;
+   bool l_bResult = true;
+
+   // Таблица просматривается только при наступлении времени ближайшей отправки
+   if(m_Subscriptions.IsDue(in_u32Time))
+   {
+      size_t i = 0;
+      while(l_bResult && i < m_Subscriptions.GetCount())
+      {
+         iridium_subscription_t* l_pSubscription = m_Subscriptions.Get(i);
+         u8 l_u8Due = m_Subscriptions.GetDue(l_pSubscription);
+         if(l_u8Due)
+         {
+            // Получение текущего значения канала обратной связи
+            size_t l_stIndex = GetTagIndex(l_pSubscription->m_u32TagID);
+            if(l_stIndex == (size_t)-1 || !GetTagData(l_stIndex, l_Tag, sizeof(l_Tag)))
+            {
+               // Канал удален, подписка теряет смысл
+               m_Subscriptions.Remove(i);
+               continue;
+            }
+
+            // Изменение в пределах зоны нечувствительности отправлять не нужно
+            if(l_u8Due == IRIDIUM_SUBSCRIPTION_CHANGED && !m_Subscriptions.IsChanged(l_pSubscription, l_Tag.m_u8Type, l_Tag.m_Value))
+               m_Subscriptions.Skip(l_pSubscription);
+            else
+            {
+               // Отправка значения, при ошибке отправки остальные значения будут отправлены при следующем вызове
+               l_bResult = SendTagNotifyRequest(l_pSubscription->m_Addr, l_pSubscription->m_u32TagID, l_Tag);
+               if(l_bResult)
+                  m_Subscriptions.Sent(l_pSubscription, l_Tag.m_u8Type, l_Tag.m_Value);
+            }
+         }
+         i++;
+      }
+
+      // Вычисление времени ближайшей отправки
+      m_Subscriptions.Schedule();
+   }
+}
+
+#endif   // #if defined(IRIDIUM_CONFIG_SUBSCRIBE_TAG_SLAVE)
+
+#if defined(IRIDIUM_CONFIG_GET_CHANNELS_MASTER)
+
+/**
+   Отправка запроса на получение списка тегов
+   на входе    :  in_DstAddr  - адрес получателя
+   нв выходе   :  успешность
+*/
+bool CIridiumProtocol::SendGetChannelsRequest(iridium_address_t in_DstAddr)
 {
    return SendRequest(in_DstAddr, IRIDIUM_MESSAGE_GET_CHANNELS);
 }
 
+/**
+   Отправка запроса на получение страницы списка каналов управления
+   на входе    :  in_DstAddr  - адрес получателя
+                  in_u16Start - индекс первого канала страницы (продолжение из предыдущего ответа)
+                  in_u16Count - максимальное количество каналов на странице (0 - до конца списка)
+   нв выходе   :  успешность
+   примечание  :  каждый пакет ответа содержит продолжение списка, которое передается в ChannelsPage
+*/
+bool CIridiumProtocol::SendGetChannelsRequest(iridium_address_t in_DstAddr, u16 in_u16Start, u16 in_u16Count)
+{
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
+
+   // Заполнение данных пакета
+   InitRequestPacket(in_DstAddr, IRIDIUM_MESSAGE_GET_CHANNELS);
+   // Начало работы с пакетом
+   l_pOut->Begin();
+   // Добавление параметров страницы
+   l_pOut->m_pBuffer->AddU16LE(in_u16Start);
+   l_pOut->m_pBuffer->AddU16LE(in_u16Count);
+   // Окончание работы и отправка пакета
+   return l_pOut->End();
+}
+
 /**
    Обработка полученого ответа на запрос каналов управления сервера
    на входе    :  *
@@ -1097,6 +1951,7 @@ bool CIridiumProtocol::SendGetChannelsRequest(iridium_address_t in_DstAddr)
 void CIridiumProtocol::ReceiveGetChannelsResponse()
 {
    u16 l_u16Channels = 0;
+   u16 l_u16Next = 0;
    iridium_channel_info_t l_Info;
    memset(&l_Info, 0, sizeof(iridium_channel_info_t));
 
@@ -1114,7 +1969,13 @@ void CIridiumProtocol::ReceiveGetChannelsResponse()
       if(l_Info.m_pszName)
          SetChannelData(l_Info);
    }
-   if(m_InMH.m_Flags.m_bEnd)
+   // Получение продолжения списка (есть только в ответе на запрос страницы)
+   if(m_pInMessage->GetU16LE(l_u16Next))
+   {
+      ChannelsPage(l_u16Next, m_InMH.m_Flags.m_bEnd);
+      if(m_InMH.m_Flags.m_bEnd && !l_u16Next)
+         EndChannels();
+   } else if(m_InMH.m_Flags.m_bEnd)
       EndChannels();
 }
 
@@ -1129,6 +1990,7 @@ void CIridiumProtocol::ReceiveGetChannelsResponse()
 */
 void CIridiumProtocol::ReceiveGetChannelsRequest()
 {
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
    bool l_bResult = true;
    iridium_channel_info_t l_Channel;
 
@@ -1138,30 +2000,42 @@ void CIridiumProtocol::ReceiveGetChannelsRequest()
    // Получение количества каналов
    size_t l_stSize = GetChannels();
    size_t l_stCurrent = 0;
-   while(l_bResult && l_stCurrent < l_stSize)
+   size_t l_stEnd = l_stSize;
+   size_t l_stReserve = 0;
+   // Получение границ страницы списка
+   bool l_bPage = GetListPage(l_stSize, l_stCurrent, l_stEnd);
+   bool l_bFirst = true;
+
+   // Место под продолжение списка в каждом пакете страницы
+   if(l_bPage)
+      l_stReserve = sizeof(u16);
+
+   // Страница отправляется даже пустой, чтобы ведущий получил продолжение списка
+   while(l_bResult && (l_stCurrent < l_stEnd || (l_bPage && l_bFirst)))
    {
       // Количество каналов управления в пакете
       u16 l_u16Count = 0;
+      l_bFirst = false;
       // Начало работы с пакетом
-      Begin();
+      l_pOut->Begin();
 
       // Создание точки для записи количества каналов
-      m_pOutMessage->CreateAnchorU16();
+      l_pOut->m_pBuffer->CreateAnchorU16();
       // Обработка списка каналов управления
-      for( ; l_stCurrent < l_stSize; l_stCurrent++)
+      for( ; l_stCurrent < l_stEnd; l_stCurrent++)
       {
          // Получение данных канала управления
          size_t l_stLen = GetChannelData(l_stCurrent, l_Channel);
          if(l_stLen)
          {
-            if(m_pOutMessage->Free() > l_stLen)
+            if(l_pOut->m_pBuffer->Free() > l_stLen + l_stReserve)
             {
                // Запись данных тега
-               m_pOutMessage->AddU32LE(l_Channel.m_u32ID);
+               l_pOut->m_pBuffer->AddU32LE(l_Channel.m_u32ID);
 #if defined(IRIDIUM_AVR_PLATFORM)
-               m_pOutMessage->AddStringFromFlash(l_Channel.m_pszName);
+               l_pOut->m_pBuffer->AddStringFromFlash(l_Channel.m_pszName);
 #else
-               m_pOutMessage->AddString(l_Channel.m_pszName);
+               l_pOut->m_pBuffer->AddString(l_Channel.m_pszName);
 #endif
                l_u16Count++;
             } else
@@ -1169,11 +2043,18 @@ void CIridiumProtocol::ReceiveGetChannelsRequest()
          }
       }
       // Установка флага конца цепочки
-      m_OutMH.m_Flags.m_bEnd = (l_stCurrent == l_stSize);
+      l_pOut->m_MH.m_Flags.m_bEnd = (l_stCurrent == l_stEnd);
       // Запись количества каналов
-      m_pOutMessage->SetAnchorU16LEValue(l_u16Count);
+      l_pOut->m_pBuffer->SetAnchorU16LEValue(l_u16Count);
+      // Добавление продолжения списка
+      if(l_bPage)
+         l_pOut->m_pBuffer->AddU16LE((l_stCurrent < l_stSize) ? (u16)l_stCurrent : 0);
+      // Канал, который не помещается в пустой пакет, не может быть отправлен
+      if(!l_u16Count && l_stCurrent < l_stEnd)
+         l_bResult = false;
       // Окончание работы и отправка пакета
-      l_bResult = End();
+      if(l_bResult)
+         l_bResult = l_pOut->End();
    }
    // Проверка на наличие ошибки
    if(!l_bResult)
@@ -1195,6 +2076,7 @@ void CIridiumProtocol::ReceiveGetChannelsRequest()
 */
 bool CIridiumProtocol::SendSetChannelValueRequest(iridium_address_t in_DstAddr, u32 in_u32ChannelID, u8 in_u8Type, universal_value_t& in_rValue, u32 in_u32PIN)
 {
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
    bool l_bResult = true;
    size_t l_stRemain = (size_t)-1;
    // Заполнение данных пакета
@@ -1204,24 +2086,24 @@ bool CIridiumProtocol::SendSetChannelValueRequest(iridium_address_t in_DstAddr,
    while(l_bResult && l_stRemain)
    {
       // Начало работы с пакетом
-      Begin();
+      l_pOut->Begin();
       // Добавление идентификатора канала управления
-      l_bResult = m_pOutMessage->AddU32LE(in_u32ChannelID);
+      l_bResult = l_pOut->m_pBuffer->AddU32LE(in_u32ChannelID);
       if(l_bResult)
       {
          // Добавление значения тега
-         l_bResult = m_pOutMessage->AddValue(in_u8Type, in_rValue, l_stRemain, 0);
+         l_bResult = l_pOut->m_pBuffer->AddValue(in_u8Type, in_rValue, l_stRemain, 0);
          if(l_bResult)
          {
             // Добавление PIN кода
             if(in_u32PIN)
-               l_bResult = m_pOutMessage->AddU32LE(in_u32PIN);
+               l_bResult = l_pOut->m_pBuffer->AddU32LE(in_u32PIN);
             if(l_bResult)
             {
                // Установка флага конца цепочки
-               m_OutMH.m_Flags.m_bEnd = (l_stRemain == 0);
+               l_pOut->m_MH.m_Flags.m_bEnd = (l_stRemain == 0);
                // Окончание работы и отправка пакета
-               l_bResult = End();
+               l_bResult = l_pOut->End();
             }
          }
       }
@@ -1299,6 +2181,7 @@ void CIridiumProtocol::ReceiveSetChannelValueRequest()
 */
 bool CIridiumProtocol::SendLinkChannelAndVariableRequest(iridium_address_t in_DstAddr, u32 in_u32ChannelID, u8 in_u8Variables, u16* in_pVariables, u32 in_u32PIN)
 {
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
    u8 l_u8Temp = 0;
    bool l_bResult = false;
    // Проверка количества переменных
@@ -1311,15 +2194,15 @@ bool CIridiumProtocol::SendLinkChannelAndVariableRequest(iridium_address_t in_Ds
       // Заполнение данных пакета
       InitRequestPacket(in_DstAddr, IRIDIUM_MESSAGE_LINK_CHANNEL_AND_VARIABLE);
       // Начало работы с пакетом
-      Begin();
+      l_pOut->Begin();
       // Добавление идентификатора канала управления
-      m_pOutMessage->AddU32LE(in_u32ChannelID);
+      l_pOut->m_pBuffer->AddU32LE(in_u32ChannelID);
       // Зарезервируем место под флаги
-      m_pOutMessage->CreateAnchorU8();
+      l_pOut->m_pBuffer->CreateAnchorU8();
       // Добавление PIN кода
       if(in_u32PIN)
       {
-         m_pOutMessage->AddU32LE(in_u32PIN);
+         l_pOut->m_pBuffer->AddU32LE(in_u32PIN);
          // Отметим наличие PIN кода
          l_u8Temp = 0x40;
       }
@@ -1327,15 +2210,15 @@ bool CIridiumProtocol::SendLinkChannelAndVariableRequest(iridium_address_t in_Ds
       if(in_u8Variables)
       {
          for(u8 i = 0; i < in_u8Variables; i++)
-            m_pOutMessage->AddU16LE(in_pVariables[i]);
+            l_pOut->m_pBuffer->AddU16LE(in_pVariables[i]);
          // Отметим наличие данных
          l_u8Temp |= (0x80 | (in_u8Variables - 1) & 0x1f);
       }
 
       // Добавление списка флагов
-      m_pOutMessage->SetAnchorU8Value(l_u8Temp);
+      l_pOut->m_pBuffer->SetAnchorU8Value(l_u8Temp);
       // Окончание работы и отправка пакета
-      l_bResult = End();
+      l_bResult = l_pOut->End();
    }
    return l_bResult;
 }
@@ -1399,6 +2282,10 @@ void CIridiumProtocol::ReceiveLinkChannelAndVariableRequest()
             // Связывание канала управления со списком глобальных переменных
             if(LinkChannelAndVariable(l_u32ID, l_u8Count, l_aVariables))
             {
+#if defined(IRIDIUM_ENABLE_CATALOG_HASH)
+               // Связь с переменными входит в описание канала
+               SetCatalogChanged();
+#endif
                SendResponse(IRIDIUM_OK);
                m_eError = IRIDIUM_OK;
             }
@@ -1425,14 +2312,16 @@ void CIridiumProtocol::ReceiveLinkChannelAndVariableRequest()
 */
 bool CIridiumProtocol::SendGetChannelDescriptionRequest(iridium_address_t in_DstAddr, u32 in_u32ChannelID)
 {
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
+
    // Заполнение данных пакета
    InitRequestPacket(in_DstAddr, IRIDIUM_MESSAGE_GET_CHANNEL_DESCRIPTION);
    // Начало работы с пакетом
-   Begin();
+   l_pOut->Begin();
    // Добавление идентификатора тега
-   m_pOutMessage->AddU32LE(in_u32ChannelID);
+   l_pOut->m_pBuffer->AddU32LE(in_u32ChannelID);
    // Окончание работы и отправка пакета
-   return End();
+   return l_pOut->End();
 }
 
 /**
@@ -1469,6 +2358,7 @@ void CIridiumProtocol::ReceiveGetChannelDescriptionResponse()
 */
 void CIridiumProtocol::ReceiveGetChannelDescriptionRequest()
 {
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
    u32 l_u32ChannelID = 0;
    iridium_channel_description_t l_Desc;
 
@@ -1482,13 +2372,13 @@ void CIridiumProtocol::ReceiveGetChannelDescriptionRequest()
          // Инициализация пакета ответа
          InitResponsePacket();
          // Начало работы с пакетом
-         Begin();
+         l_pOut->Begin();
          // Добавление идентификатора канала управления
-         m_pOutMessage->AddU32LE(l_u32ChannelID);
+         l_pOut->m_pBuffer->AddU32LE(l_u32ChannelID);
          // Добавление описания канала управления
-         m_pOutMessage->AddChannelDescription(l_Desc);
+         l_pOut->m_pBuffer->AddChannelDescription(l_Desc);
          // Окончание работы и отправка пакета
-         if(End())
+         if(l_pOut->End())
             m_eError = IRIDIUM_OK;
          else
             m_eError = IRIDIUM_UNKNOWN_ERROR;
@@ -1510,23 +2400,24 @@ void CIridiumProtocol::ReceiveGetChannelDescriptionRequest()
 */
 bool CIridiumProtocol::SendGetChannelValueRequest(iridium_address_t in_DstAddr, u32 in_u32ChannelID, u32 in_u32PIN)
 {
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
    bool l_bResult = true;
    // Заполнение данных пакета
    InitRequestPacket(in_DstAddr, IRIDIUM_MESSAGE_GET_CHANNEL_VALUE);
 
    // Начало работы с пакетом
-   Begin();
+   l_pOut->Begin();
    // Добавление идентификатора канала управления
-   l_bResult = m_pOutMessage->AddU32LE(in_u32ChannelID);
+   l_bResult = l_pOut->m_pBuffer->AddU32LE(in_u32ChannelID);
    if(l_bResult)
    {
       // Добавление PIN кода
       if(in_u32PIN)
-         l_bResult = m_pOutMessage->AddU32LE(in_u32PIN);
+         l_bResult = l_pOut->m_pBuffer->AddU32LE(in_u32PIN);
 
       // Окончание работы и отправка пакета
       if(l_bResult)
-         l_bResult = End();
+         l_bResult = l_pOut->End();
    }
    return l_bResult;
 }
@@ -1606,6 +2497,7 @@ void CIridiumProtocol::ReceiveGetChannelValueRequest()
 */
 bool CIridiumProtocol::SendGetChannelValueResponse(u32 in_u32ChannelID, iridium_channel_info_t& in_rInfo)
 {
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
    bool l_bResult = true;
    size_t l_stRemain = (size_t)-1;
 
@@ -1616,19 +2508,19 @@ bool CIridiumProtocol::SendGetChannelValueResponse(u32 in_u32ChannelID, iridium_
    while(l_bResult && l_stRemain)
    {
       // Начало работы с пакетом
-      Begin();
+      l_pOut->Begin();
       // Добавление идентификатора канала управления
-      l_bResult = m_pOutMessage->AddU32LE(in_u32ChannelID);
+      l_bResult = l_pOut->m_pBuffer->AddU32LE(in_u32ChannelID);
       if(l_bResult)
       {
          // Добавление значения тега
-         l_bResult = m_pOutMessage->AddValue(in_rInfo.m_u8Type, in_rInfo.m_Value, l_stRemain, 0);
+         l_bResult = l_pOut->m_pBuffer->AddValue(in_rInfo.m_u8Type, in_rInfo.m_Value, l_stRemain, 0);
          if(l_bResult)
          {
             // Установка флага конца цепочки
-            m_OutMH.m_Flags.m_bEnd = (l_stRemain == 0);
+            l_pOut->m_MH.m_Flags.m_bEnd = (l_stRemain == 0);
             // Окончание работы и отправка пакета
-            l_bResult = End();
+            l_bResult = l_pOut->End();
          }
       }
    }
@@ -1637,104 +2529,480 @@ bool CIridiumProtocol::SendGetChannelValueResponse(u32 in_u32ChannelID, iridium_
 
 #endif   // #if defined(IRIDIUM_CONFIG_GET_CHANNEL_VALUE_SLAVE)
 
-#if defined(IRIDIUM_CONFIG_STREAM_OPEN_MASTER)
+#if defined(IRIDIUM_CONFIG_BATCH_MASTER)
 
 /**
-   Запрос на открытие потока
+   Начало формирования пакетного запроса
    на входе    :  in_DstAddr  - адрес получателя
-                  in_pszName  - указатель на имя потока
-                  in_eMode    - режим открытия потока
-                  in_u32PIN   - пин код
    на выходе   :  успешность
+   примечание  :  пакетный запрос объединяет операции установки и получения значений каналов одного получателя.
+                  Операции добавляются методами AddBatch*, запрос отправляется методом SendBatchRequest.
+                  Операции, не поместившиеся в пакет, передаются следующими пакетами цепочки.
+                  Между BeginBatchRequest и SendBatchRequest нельзя отправлять другие сообщения через тот же построитель.
+                  Получатель, не поддерживающий сообщение, отвечает ошибкой IRIDIUM_UNKNOWN_MESSAGE_VERSION
 */
-bool CIridiumProtocol::SendStreamOpenRequest(iridium_address_t in_DstAddr, const char* in_pszName, eIridiumStreamMode in_eMode, u32 in_u32PIN)
+bool CIridiumProtocol::BeginBatchRequest(iridium_address_t in_DstAddr)
 {
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
+
    // Заполнение данных пакета
-   InitRequestPacket(in_DstAddr, IRIDIUM_MESSAGE_STREAM_OPEN);
+   InitRequestPacket(in_DstAddr, IRIDIUM_MESSAGE_BATCH);
    // Начало работы с пакетом
-   Begin();
-   // Добавление имени потока
-   m_pOutMessage->AddString(in_pszName);
-   // Добавление режима открытия потока
-   m_pOutMessage->AddU8(in_eMode);
-   // Добавление PIN кода
-   if(in_u32PIN)
-      m_pOutMessage->AddU32LE(in_u32PIN);
+   l_pOut->Begin();
+   l_pOut->m_stBatchBegin = l_pOut->m_pBuffer->GetMessageSize();
+   return true;
+}
+
+/**
+   Добавление в пакетный запрос установки значения канала обратной связи
+   на входе    :  in_u32TagID - идентифкатор канала обратной связи
+                  in_u8Type   - тип значения
+                  in_rValue   - ссылка на данные значения
+   на выходе   :  успешность, false - значение не помещается в пакет или ошибка отправки пакета
+*/
+bool CIridiumProtocol::AddBatchSetTagValue(u32 in_u32TagID, u8 in_u8Type, universal_value_t& in_rValue)
+{
+   return AddBatchItem(IRIDIUM_MESSAGE_SET_TAG_VALUE, in_u32TagID, IRIDIUM_OK, 0, in_u8Type, &in_rValue);
+}
+
+/**
+   Добавление в пакетный запрос установки значения канала управления
+   на входе    :  in_u32ChannelID   - идентифкатор канала управления
+                  in_u8Type         - тип значения
+                  in_rValue         - ссылка на данные значения
+                  in_u32PIN         - пароль доступа для записи значения
+   на выходе   :  успешность, false - значение не помещается в пакет или ошибка отправки пакета
+*/
+bool CIridiumProtocol::AddBatchSetChannelValue(u32 in_u32ChannelID, u8 in_u8Type, universal_value_t& in_rValue, u32 in_u32PIN)
+{
+   return AddBatchItem(IRIDIUM_MESSAGE_SET_CHANNEL_VALUE, in_u32ChannelID, IRIDIUM_OK, in_u32PIN, in_u8Type, &in_rValue);
+}
+
+/**
+   Добавление в пакетный запрос получения значения канала управления
+   на входе    :  in_u32ChannelID   - идентифкатор канала управления
+                  in_u32PIN         - пароль доступа для чтения значения
+   на выходе   :  успешность
+*/
+bool CIridiumProtocol::AddBatchGetChannelValue(u32 in_u32ChannelID, u32 in_u32PIN)
+{
+   return AddBatchItem(IRIDIUM_MESSAGE_GET_CHANNEL_VALUE, in_u32ChannelID, IRIDIUM_OK, in_u32PIN, 0, NULL);
+}
+
+/**
+   Отправка последнего пакета пакетного запроса
+   на входе    :  *
+   на выходе   :  успешность
+*/
+bool CIridiumProtocol::SendBatchRequest()
+{
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
+
+   // Установка флага конца цепочки
+   l_pOut->m_MH.m_Flags.m_bEnd = true;
    // Окончание работы и отправка пакета
-   return End();
+   return l_pOut->End();
 }
 
 /**
-   Обработка полученого ответа на запрос открытия потока
+   Обработка полученого ответа на пакетный запрос
    на входе    :  *
    на выходе   :  *
+   примечание  :  для каждой операции вызывается BatchResult, полученные значения каналов управления
+                  передаются в SetChannelValue
 */
-void CIridiumProtocol::ReceiveStreamOpenResponse()
+void CIridiumProtocol::ReceiveBatchResponse()
 {
-   char* l_pszName = NULL;
-   u8 l_u8Mode = 0;
-   u8 l_u8StreamID = 0;
-   m_eError = IRIDIUM_PROTOCOL_CORRUPT;
-   // Получение имени потока
-   if(m_pInMessage->GetString(l_pszName))
+   u8 l_u8Operation = 0;
+   u32 l_u32ID = 0;
+   u8 l_u8Status = 0;
+   u8 l_u8Type = 0;
+   universal_value_t l_Value;
+
+   // Обработка результатов операций
+   while(m_pInMessage->Size() && m_pInMessage->GetU8(l_u8Operation) && m_pInMessage->GetU32LE(l_u32ID) && m_pInMessage->GetU8(l_u8Status))
    {
-      // Получение режима открытия потока
-      if(m_pInMessage->GetU8(l_u8Mode))
+      // Получение значения канала управления
+      if(l_u8Operation == IRIDIUM_MESSAGE_GET_CHANNEL_VALUE && l_u8Status == IRIDIUM_OK)
       {
-         // Получение идентификатора открытого потока
-         if(m_pInMessage->GetU8(l_u8StreamID))
-         {
-            // Вызов обработчика успешного открытия потока
-            StreamOpenResult(l_pszName, (eIridiumStreamMode)l_u8Mode, l_u8StreamID);
-            m_eError = IRIDIUM_OK;
-         }
+         if(!m_pInMessage->GetValue(l_u8Type, l_Value))
+            break;
+         SetChannelValue(l_u32ID, l_u8Type, l_Value, IRIDIUM_FLAGS_END);
       }
+      // Оповещение о результате операции
+      BatchResult(l_u8Operation, l_u32ID, (eIridiumError)l_u8Status);
    }
 }
 
-#endif   // #if defined(IRIDIUM_CONFIG_STREAM_OPEN_MASTER)
+#endif   // #if defined(IRIDIUM_CONFIG_BATCH_MASTER)
 
-#if defined(IRIDIUM_CONFIG_STREAM_OPEN_SLAVE)
+#if defined(IRIDIUM_CONFIG_BATCH_SLAVE)
 
 /**
-   Обработка полученого запроса открытия потока
+   Обработка полученого пакетного запроса
    на входе    :  *
    на выходе   :  *
+   примечание  :  операции выполняются через SetTagValue, SetChannelValue и GetChannelData. Ответ содержит
+                  результат каждой операции и передается цепочкой пакетов, последний пакет ответа отправляется
+                  на последний пакет запроса
 */
-void CIridiumProtocol::ReceiveStreamOpenRequest()
+void CIridiumProtocol::ReceiveBatchRequest()
 {
-   char* l_pszName = NULL;
-   u8 l_u8Mode = 0;
-   u8 l_u8StreamID = 0;
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
+   bool l_bResult = true;
+   u8 l_u8Operation = 0;
+   u32 l_u32ID = 0;
    u32 l_u32PIN = 0;
-   m_eError = IRIDIUM_PROTOCOL_CORRUPT;
-   // Получение имени потока
-   if(m_pInMessage->GetString(l_pszName))
+   u8 l_u8Type = 0;
+   universal_value_t l_Value;
+   iridium_channel_info_t l_Channel;
+
+   // Инициализация пакета ответа
+   InitResponsePacket();
+   // Начало работы с пакетом
+   l_pOut->Begin();
+   l_pOut->m_stBatchBegin = l_pOut->m_pBuffer->GetMessageSize();
+
+   // Выполнять пока нет ошибки и есть операции
+   while(l_bResult && m_pInMessage->Size())
    {
-      // Получение режима открытия потока
-      if(m_pInMessage->GetU8(l_u8Mode))
+      eIridiumError l_eStatus = IRIDIUM_OK;
+      universal_value_t* l_pValue = NULL;
+      l_u32PIN = 0;
+
+      // Получение операции и идентификатора канала
+      l_bResult = m_pInMessage->GetU8(l_u8Operation) && m_pInMessage->GetU32LE(l_u32ID);
+      // Получение пароля доступа
+      if(l_bResult && (l_u8Operation & IRIDIUM_BATCH_FLAG_PIN))
+         l_bResult = m_pInMessage->GetU32LE(l_u32PIN);
+      l_u8Operation &= ~IRIDIUM_BATCH_FLAG_PIN;
+
+      if(l_bResult)
       {
-         // Получение пина, если таковой есть
-         if(m_pInMessage->Size() >= 4)
-            m_pInMessage->GetU32LE(l_u32PIN);
-         // Проверка PIN кода
-         s8 l_s8Result = TestPIN((l_u8Mode == IRIDIUM_STREAM_MODE_READ) ? IRIDIUM_OPERATION_READ_STREAM : IRIDIUM_OPERATION_WRITE_STREAM, l_u32PIN, &l_pszName);
-         if(l_s8Result > 0)
-         {
-            // Вызов обработчика открытия потока
-            l_u8StreamID = StreamOpen(l_pszName, (eIridiumStreamMode)l_u8Mode);
-            // Отправка ответа
-            SendStreamOpenResponse(l_pszName, (eIridiumStreamMode)l_u8Mode, l_u8StreamID);
-            m_eError = IRIDIUM_OK;
-         } else
+         switch(l_u8Operation)
          {
-            // Определение ошибки
-            m_eError = (l_s8Result < 0) ? IRIDIUM_PIN_LOCK : IRIDIUM_BAD_PIN;
-         }
-      }
-   }
-}
-
+         // Установка значения канала обратной связи
+         case IRIDIUM_MESSAGE_SET_TAG_VALUE:
+            l_bResult = m_pInMessage->GetValue(l_u8Type, l_Value);
+            if(l_bResult && !SetTagValue(l_u32ID, l_u8Type, l_Value, IRIDIUM_FLAGS_SET | IRIDIUM_FLAGS_END))
+               l_eStatus = IRIDIUM_ERROR_BAD_TAG_ID;
+            break;
+
+         // Установка значения канала управления
+         case IRIDIUM_MESSAGE_SET_CHANNEL_VALUE:
+            l_bResult = m_pInMessage->GetValue(l_u8Type, l_Value);
+            if(l_bResult)
+            {
+               // Проверка возможности изменения значения
+               s8 l_s8Result = TestPIN(IRIDIUM_OPERATION_WRITE_CHANNEL, l_u32PIN, &l_u32ID);
+               if(l_s8Result > 0)
+               {
+                  if(!SetChannelValue(l_u32ID, l_u8Type, l_Value, IRIDIUM_FLAGS_SET | IRIDIUM_FLAGS_END))
+                     l_eStatus = IRIDIUM_ERROR_BAD_CHANNEL_ID;
+               } else
+                  l_eStatus = (l_s8Result < 0) ? IRIDIUM_PIN_LOCK : IRIDIUM_BAD_PIN;
+            }
+            break;
+
+         // Получение значения канала управления
+         case IRIDIUM_MESSAGE_GET_CHANNEL_VALUE:
+            {
+               size_t l_stIndex = GetChannelIndex(l_u32ID);
+               if(l_stIndex != (size_t)-1)
+               {
+                  // Проверка PIN кода
+                  s8 l_s8Result = TestPIN(IRIDIUM_OPERATION_READ_CHANNEL, l_u32PIN, &l_u32ID);
+                  if(l_s8Result > 0)
+                  {
+                     // Получение данных канала управления
+                     if(GetChannelData(l_stIndex, l_Channel))
+                        l_pValue = &l_Channel.m_Value;
+                     else
+                        l_eStatus = IRIDIUM_ERROR_BAD_CHANNEL_ID;
+                  } else
+                     l_eStatus = (l_s8Result < 0) ? IRIDIUM_PIN_LOCK : IRIDIUM_BAD_PIN;
+               } else
+                  l_eStatus = IRIDIUM_ERROR_BAD_CHANNEL_ID;
+            }
+            break;
+
+         // Неизвестная операция, длина данных операции неизвестна
+         default:
+            l_bResult = false;
+            break;
+         }
+      }
+
+      if(l_bResult)
+      {
+         // Добавление результата операции
+         l_bResult = AddBatchItem(l_u8Operation, l_u32ID, l_eStatus, 0, l_pValue ? l_Channel.m_u8Type : IVT_NONE, l_pValue);
+         // Значение не помещается в пакет ответа
+         if(!l_bResult && l_pValue)
+            l_bResult = AddBatchItem(l_u8Operation, l_u32ID, IRIDIUM_SERVER_IS_FULL, 0, 0, NULL);
+         if(!l_bResult)
+            m_eError = IRIDIUM_SERVER_IS_FULL;
+      } else
+         m_eError = IRIDIUM_PROTOCOL_CORRUPT;
+   }
+
+   // Отправка последнего пакета ответа
+   if(l_bResult)
+   {
+      l_pOut->m_MH.m_Flags.m_bEnd = m_InMH.m_Flags.m_bEnd;
+      l_pOut->End();
+   }
+}
+
+#endif   // #if defined(IRIDIUM_CONFIG_BATCH_SLAVE)
+
+#if defined(IRIDIUM_CONFIG_STREAM_OPEN_MASTER)
+
+/**
+   Запрос на открытие потока
+   на входе    :  in_DstAddr  - адрес получателя
+                  in_pszName  - указатель на имя потока
+                  in_eMode    - режим открытия потока
+                  in_u32PIN   - пин код
+   на выходе   :  успешность
+*/
+bool CIridiumProtocol::SendStreamOpenRequest(iridium_address_t in_DstAddr, const char* in_pszName, eIridiumStreamMode in_eMode, u32 in_u32PIN)
+{
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
+
+   // Заполнение данных пакета
+   InitRequestPacket(in_DstAddr, IRIDIUM_MESSAGE_STREAM_OPEN);
+   // Начало работы с пакетом
+   l_pOut->Begin();
+   // Добавление имени потока
+   l_pOut->m_pBuffer->AddString(in_pszName);
+   // Добавление режима открытия потока
+   l_pOut->m_pBuffer->AddU8(in_eMode);
+   // Добавление PIN кода
+   if(in_u32PIN)
+      l_pOut->m_pBuffer->AddU32LE(in_u32PIN);
+   // Окончание работы и отправка пакета
+   return l_pOut->End();
+}
+
+#if defined(IRIDIUM_ENABLE_STREAM_WINDOW) && defined(IRIDIUM_CONFIG_STREAM_BLOCK_MASTER)
+
+/**
+   Запрос на открытие потока с передачей блоков окном
+   на входе    :  in_DstAddr  - адрес получателя
+                  in_pszName  - указатель на имя потока
+                  in_eMode    - режим открытия потока
+                  in_u32PIN   - пин код
+                  in_u8Window - желаемое количество блоков в пути без подтверждения
+   на выходе   :  успешность
+   примечание  :  пин код передается всегда, чтобы размер окна шел за ним. Устройство без поддержки окна
+                  игнорирует размер окна и отвечает без него, тогда поток передается по одному блоку.
+                  Окно резервируется до получения ответа, если свободного окна нет, окно не запрашивается
+*/
+bool CIridiumProtocol::SendStreamOpenRequest(iridium_address_t in_DstAddr, const char* in_pszName, eIridiumStreamMode in_eMode, u32 in_u32PIN, u8 in_u8Window)
+{
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
+
+   // Заполнение данных пакета
+   InitRequestPacket(in_DstAddr, IRIDIUM_MESSAGE_STREAM_OPEN);
+   // Начало работы с пакетом
+   l_pOut->Begin();
+   // Добавление имени потока
+   l_pOut->m_pBuffer->AddString(in_pszName);
+   // Добавление режима открытия потока
+   l_pOut->m_pBuffer->AddU8(in_eMode);
+   // Добавление PIN кода
+   l_pOut->m_pBuffer->AddU32LE(in_u32PIN);
+   // Резервирование окна до получения ответа
+   Lock();
+   CloseStreamWindow(in_DstAddr);
+   CIridiumStreamWindow* l_pWindow = (in_eMode == IRIDIUM_STREAM_MODE_WRITE) ? FindStreamWindow(in_DstAddr, 0, true) : NULL;
+   if(l_pWindow && in_u8Window)
+      l_pWindow->Open(in_DstAddr, 0, in_u8Window);
+   else
+      in_u8Window = 0;
+   Unlock();
+   // Добавление размера окна
+   l_pOut->m_pBuffer->AddU8(in_u8Window);
+   // Окончание работы и отправка пакета
+   return l_pOut->End();
+}
+
+#if defined(IRIDIUM_ENABLE_STREAM_RESUME)
+
+/**
+   Запрос на открытие потока с передачей блоков окном и запросом точки продолжения записи
+   на входе    :  in_DstAddr  - адрес получателя
+                  in_pszName  - указатель на имя потока
+                  in_eMode    - режим открытия потока
+                  in_u32PIN   - пин код
+                  in_u8Window - желаемое количество блоков в пути без подтверждения
+                  in_bResume  - запрос точки продолжения прерванной записи
+   на выходе   :  успешность
+   примечание  :  признак запроса следует за размером окна. Если устройство сохранило точку продолжения, она
+                  передается в StreamResumeResult до вызова StreamOpenResult, и блоки окна (начиная с 0)
+                  передаются с этого смещения. Без точки поток передается с начала
+*/
+bool CIridiumProtocol::SendStreamOpenRequest(iridium_address_t in_DstAddr, const char* in_pszName, eIridiumStreamMode in_eMode, u32 in_u32PIN, u8 in_u8Window, bool in_bResume)
+{
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
+
+   // Заполнение данных пакета
+   InitRequestPacket(in_DstAddr, IRIDIUM_MESSAGE_STREAM_OPEN);
+   // Начало работы с пакетом
+   l_pOut->Begin();
+   // Добавление имени потока
+   l_pOut->m_pBuffer->AddString(in_pszName);
+   // Добавление режима открытия потока
+   l_pOut->m_pBuffer->AddU8(in_eMode);
+   // Добавление PIN кода
+   l_pOut->m_pBuffer->AddU32LE(in_u32PIN);
+   // Резервирование окна до получения ответа
+   Lock();
+   CloseStreamWindow(in_DstAddr);
+   CIridiumStreamWindow* l_pWindow = (in_eMode == IRIDIUM_STREAM_MODE_WRITE) ? FindStreamWindow(in_DstAddr, 0, true) : NULL;
+   if(l_pWindow && in_u8Window)
+      l_pWindow->Open(in_DstAddr, 0, in_u8Window);
+   else
+      in_u8Window = 0;
+   Unlock();
+   // Добавление размера окна
+   l_pOut->m_pBuffer->AddU8(in_u8Window);
+   // Добавление признака запроса точки продолжения
+   if(in_bResume)
+      l_pOut->m_pBuffer->AddU8(1);
+   // Окончание работы и отправка пакета
+   return l_pOut->End();
+}
+
+#endif   // defined(IRIDIUM_ENABLE_STREAM_RESUME)
+
+#endif   // defined(IRIDIUM_ENABLE_STREAM_WINDOW) && defined(IRIDIUM_CONFIG_STREAM_BLOCK_MASTER)
+
+/**
+   Обработка полученого ответа на запрос открытия потока
+   на входе    :  *
+   на выходе   :  *
+*/
+void CIridiumProtocol::ReceiveStreamOpenResponse()
+{
+   char* l_pszName = NULL;
+   u8 l_u8Mode = 0;
+   u8 l_u8StreamID = 0;
+   m_eError = IRIDIUM_PROTOCOL_CORRUPT;
+   // Получение имени потока
+   if(m_pInMessage->GetString(l_pszName))
+   {
+      // Получение режима открытия потока
+      if(m_pInMessage->GetU8(l_u8Mode))
+      {
+         // Получение идентификатора открытого потока
+         if(m_pInMessage->GetU8(l_u8StreamID))
+         {
+#if defined(IRIDIUM_ENABLE_STREAM_WINDOW) && defined(IRIDIUM_CONFIG_STREAM_BLOCK_MASTER)
+            // Открытие окна передачи, если устройство ответило согласованным размером окна
+            u8 l_u8Window = 0;
+            m_pInMessage->GetU8(l_u8Window);
+            Lock();
+            CIridiumStreamWindow* l_pWindow = FindStreamWindow(GetSrcAddress(), 0, false);
+            if(l_pWindow)
+            {
+               if(l_u8StreamID && l_u8Window && l_u8Mode == IRIDIUM_STREAM_MODE_WRITE)
+                  l_pWindow->Open(GetSrcAddress(), l_u8StreamID, (l_u8Window < l_pWindow->GetWindow()) ? l_u8Window : l_pWindow->GetWindow());
+               else
+                  l_pWindow->Close();
+            }
+            Unlock();
+#if defined(IRIDIUM_ENABLE_STREAM_RESUME)
+            // Получение точки продолжения записи, если устройство ее сохранило (следует за размером окна)
+            u32 l_u32Offset = 0;
+            u16 l_u16CRC = 0;
+            if(l_u8StreamID && m_pInMessage->GetU32LE(l_u32Offset) && m_pInMessage->GetU16LE(l_u16CRC))
+               StreamResumeResult(GetSrcAddress(), l_u8StreamID, l_u32Offset, l_u16CRC);
+#endif
+#endif
+            // Вызов обработчика успешного открытия потока
+            StreamOpenResult(l_pszName, (eIridiumStreamMode)l_u8Mode, l_u8StreamID);
+            m_eError = IRIDIUM_OK;
+         }
+      }
+   }
+}
+
+#endif   // #if defined(IRIDIUM_CONFIG_STREAM_OPEN_MASTER)
+
+#if defined(IRIDIUM_CONFIG_STREAM_OPEN_SLAVE)
+
+/**
+   Обработка полученого запроса открытия потока
+   на входе    :  *
+   на выходе   :  *
+*/
+void CIridiumProtocol::ReceiveStreamOpenRequest()
+{
+   char* l_pszName = NULL;
+   u8 l_u8Mode = 0;
+   u8 l_u8StreamID = 0;
+   u32 l_u32PIN = 0;
+   m_eError = IRIDIUM_PROTOCOL_CORRUPT;
+   // Получение имени потока
+   if(m_pInMessage->GetString(l_pszName))
+   {
+      // Получение режима открытия потока
+      if(m_pInMessage->GetU8(l_u8Mode))
+      {
+         // Получение пина, если таковой есть
+         if(m_pInMessage->Size() >= 4)
+            m_pInMessage->GetU32LE(l_u32PIN);
+#if defined(IRIDIUM_ENABLE_STREAM_WINDOW)
+         // Получение размера окна, если таковой есть (следует за пин кодом)
+         m_u8StreamWindow = 0;
+         m_pInMessage->GetU8(m_u8StreamWindow);
+#if defined(IRIDIUM_ENABLE_STREAM_RESUME)
+         // Получение признака запроса точки продолжения записи (следует за размером окна)
+         u8 l_u8Resume = 0;
+         m_pInMessage->GetU8(l_u8Resume);
+#endif
+#endif
+         // Проверка PIN кода
+         s8 l_s8Result = TestPIN((l_u8Mode == IRIDIUM_STREAM_MODE_READ) ? IRIDIUM_OPERATION_READ_STREAM : IRIDIUM_OPERATION_WRITE_STREAM, l_u32PIN, &l_pszName);
+         if(l_s8Result > 0)
+         {
+            // Вызов обработчика открытия потока
+            l_u8StreamID = StreamOpen(l_pszName, (eIridiumStreamMode)l_u8Mode);
+#if defined(IRIDIUM_ENABLE_STREAM_WINDOW)
+            // Согласование размера окна для потока записи
+            u8 l_u8Window = 0;
+#if defined(IRIDIUM_CONFIG_STREAM_BLOCK_SLAVE)
+            if(m_u8StreamWindow && l_u8StreamID && l_u8Mode == IRIDIUM_STREAM_MODE_WRITE)
+               l_u8Window = OpenStreamWindow(GetSrcAddress(), l_u8StreamID, m_u8StreamWindow);
+            else if(l_u8StreamID && m_StreamRx.GetStreamID() == l_u8StreamID)
+               m_StreamRx.Close();
+#endif
+#if defined(IRIDIUM_ENABLE_STREAM_RESUME)
+            // Отправка ответа с точкой продолжения записи, если она запрошена и сохранена устройством
+            u32 l_u32Offset = 0;
+            u16 l_u16CRC = 0;
+            if(l_u8Resume && l_u8StreamID && l_u8Mode == IRIDIUM_STREAM_MODE_WRITE && StreamResume(l_u8StreamID, l_u32Offset, l_u16CRC))
+               SendStreamOpenResponse(l_pszName, (eIridiumStreamMode)l_u8Mode, l_u8StreamID, l_u8Window, l_u32Offset, l_u16CRC);
+            else
+#endif
+            // Отправка ответа
+            SendStreamOpenResponse(l_pszName, (eIridiumStreamMode)l_u8Mode, l_u8StreamID, l_u8Window);
+#else
+            // Отправка ответа
+            SendStreamOpenResponse(l_pszName, (eIridiumStreamMode)l_u8Mode, l_u8StreamID);
+#endif
+            m_eError = IRIDIUM_OK;
+         } else
+         {
+            // Определение ошибки
+            m_eError = (l_s8Result < 0) ? IRIDIUM_PIN_LOCK : IRIDIUM_BAD_PIN;
+         }
+      }
+   }
+}
+
 /**
    Отправка ответа на запрос открытия потока
    на входе    :  in_pszName     - указатель на имя потока
@@ -1744,20 +3012,93 @@ void CIridiumProtocol::ReceiveStreamOpenRequest()
 */
 bool CIridiumProtocol::SendStreamOpenResponse(const char* in_pszName, eIridiumStreamMode in_eMode, u8 in_u8StreamID)
 {
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
+
+   // Инициализация пакета ответа
+   InitResponsePacket();
+   // Начало работы с пакетом
+   l_pOut->Begin();
+   // Добавление имени потока
+   l_pOut->m_pBuffer->AddString(in_pszName);
+   // Добавление режима открытия потока
+   l_pOut->m_pBuffer->AddU8(in_eMode);
+   // Добавление идентификатора открытого потока
+   l_pOut->m_pBuffer->AddU8(in_u8StreamID);
+   // Окончание работы и отправка пакета
+   return l_pOut->End();
+}
+
+#if defined(IRIDIUM_ENABLE_STREAM_WINDOW)
+
+/**
+   Отправка ответа на запрос открытия потока с согласованным размером окна
+   на входе    :  in_pszName     - указатель на имя потока
+                  in_eMode       - режим открытия потока
+                  in_u8StreamID  - идентифкатор открытого потока
+                  in_u8Window    - размер окна (0 - поток передается по одному блоку, размер не добавляется)
+   на выходе   :  успешность
+*/
+bool CIridiumProtocol::SendStreamOpenResponse(const char* in_pszName, eIridiumStreamMode in_eMode, u8 in_u8StreamID, u8 in_u8Window)
+{
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
+
+   // Инициализация пакета ответа
+   InitResponsePacket();
+   // Начало работы с пакетом
+   l_pOut->Begin();
+   // Добавление имени потока
+   l_pOut->m_pBuffer->AddString(in_pszName);
+   // Добавление режима открытия потока
+   l_pOut->m_pBuffer->AddU8(in_eMode);
+   // Добавление идентификатора открытого потока
+   l_pOut->m_pBuffer->AddU8(in_u8StreamID);
+   // Добавление размера окна
+   if(in_u8Window)
+      l_pOut->m_pBuffer->AddU8(in_u8Window);
+   // Окончание работы и отправка пакета
+   return l_pOut->End();
+}
+
+#if defined(IRIDIUM_ENABLE_STREAM_RESUME)
+
+/**
+   Отправка ответа на запрос открытия потока с точкой продолжения записи
+   на входе    :  in_pszName     - указатель на имя потока
+                  in_eMode       - режим открытия потока
+                  in_u8StreamID  - идентифкатор открытого потока
+                  in_u8Window    - размер окна (0 - поток передается по одному блоку)
+                  in_u32Offset   - смещение в потоке, с которого нужно продолжить передачу
+                  in_u16CRC      - CRC16 данных потока до смещения (начальное значение IRIDIUM_STREAM_RESUME_CRC_INIT)
+   на выходе   :  успешность
+   примечание  :  размер окна добавляется всегда, так как точка продолжения следует за ним
+*/
+bool CIridiumProtocol::SendStreamOpenResponse(const char* in_pszName, eIridiumStreamMode in_eMode, u8 in_u8StreamID, u8 in_u8Window, u32 in_u32Offset, u16 in_u16CRC)
+{
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
+
    // Инициализация пакета ответа
    InitResponsePacket();
    // Начало работы с пакетом
-   Begin();
+   l_pOut->Begin();
    // Добавление имени потока
-   m_pOutMessage->AddString(in_pszName);
+   l_pOut->m_pBuffer->AddString(in_pszName);
    // Добавление режима открытия потока
-   m_pOutMessage->AddU8(in_eMode);
+   l_pOut->m_pBuffer->AddU8(in_eMode);
    // Добавление идентификатора открытого потока
-   m_pOutMessage->AddU8(in_u8StreamID);
+   l_pOut->m_pBuffer->AddU8(in_u8StreamID);
+   // Добавление размера окна
+   l_pOut->m_pBuffer->AddU8(in_u8Window);
+   // Добавление точки продолжения записи
+   l_pOut->m_pBuffer->AddU32LE(in_u32Offset);
+   l_pOut->m_pBuffer->AddU16LE(in_u16CRC);
    // Окончание работы и отправка пакета
-   return End();
+   return l_pOut->End();
 }
 
+#endif   // defined(IRIDIUM_ENABLE_STREAM_RESUME)
+
+#endif   // defined(IRIDIUM_ENABLE_STREAM_WINDOW)
+
 #endif   // #if defined(IRIDIUM_CONFIG_STREAM_OPEN_SLAVE)
 
 #if defined(IRIDIUM_CONFIG_STREAM_BLOCK_MASTER)
@@ -1773,20 +3114,22 @@ bool CIridiumProtocol::SendStreamOpenResponse(const char* in_pszName, eIridiumSt
 */
 bool CIridiumProtocol::SendStreamBlockRequest(iridium_address_t in_DstAddr, u8 in_u8StreamID, u8 in_u8BlockID, u16 in_u16Size, const void* in_pBlock)
 {
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
+
    // Заполнение данных пакета
    InitRequestPacket(in_DstAddr, IRIDIUM_MESSAGE_STREAM_BLOCK);
    // Начало работы с пакетом
-   Begin();
+   l_pOut->Begin();
    // Добавление идентификатора потока
-   m_pOutMessage->AddU8(in_u8StreamID);
+   l_pOut->m_pBuffer->AddU8(in_u8StreamID);
    // Добавление идентификатора блока
-   m_pOutMessage->AddU8(in_u8BlockID);
+   l_pOut->m_pBuffer->AddU8(in_u8BlockID);
    // Добавление длинны блока
-   m_pOutMessage->AddU16LE(in_u16Size);
-   // Добавление данных блока
-   m_pOutMessage->AddData(in_pBlock, in_u16Size);
+   l_pOut->m_pBuffer->AddU16LE(in_u16Size);
+   // Добавление ссылки на данные блока (без копирования, если сообщение не шифруется)
+   l_pOut->m_pBuffer->AddDataRef(in_pBlock, in_u16Size);
    // Окончание работы и отправка пакета
-   return End();
+   return l_pOut->End();
 }
 
 /**
@@ -1808,14 +3151,193 @@ void CIridiumProtocol::ReceiveStreamBlockResponse()
          // Получение длинны блока
          if(m_pInMessage->GetU16LE(l_u16Size))
          {
+#if defined(IRIDIUM_ENABLE_STREAM_WINDOW)
+            // Подтверждение окна содержит маску принятых блоков, запоздавшие подтверждения закрытого окна отбрасываются
+            u16 l_u16Mask = 0;
+            bool l_bWindow = m_pInMessage->GetU16LE(l_u16Mask);
+            bool l_bClose = false;
+            s8 l_s8Count = 0;
+            Lock();
+            CIridiumStreamWindow* l_pWindow = l_u8StreamID ? FindStreamWindow(GetSrcAddress(), l_u8StreamID, false) : NULL;
+            if(l_pWindow)
+            {
+               l_bWindow = true;
+               l_s8Count = l_pWindow->Acknowledge(l_u8BlockID, l_u16Mask);
+               // Ошибка обработки блока прерывает передачу
+               l_bClose = (l_s8Count > 0 && !l_u16Size);
+               if(l_bClose)
+                  l_pWindow->Close();
+            }
+            Unlock();
+            // Вызов обработчика для последнего подтвержденного по порядку блока
+            if(!l_bWindow || l_s8Count > 0)
+               StreamBlockResult(l_u8StreamID, l_u8BlockID, l_u16Size);
+            if(l_bClose)
+               StreamComplete(GetSrcAddress(), l_u8StreamID, false);
+#else
             // Вызов обработчика получения блока
             StreamBlockResult(l_u8StreamID, l_u8BlockID, l_u16Size);
+#endif
             m_eError = IRIDIUM_OK;
          }
       }
    }
 }
 
+#if defined(IRIDIUM_ENABLE_STREAM_WINDOW)
+
+/**
+   Отправка блоков потоков открытых окном
+   на входе    :  in_u32Time  - монотонное время платформы в миллисекундах
+   на выходе   :  *
+   примечание  :  потокам по кругу отправляется по одному блоку (сначала повторы потерянных блоков, затем
+                  новые), пока окна не заполнены или очередь исходящих пакетов не отказала в отправке.
+                  Поток, которому не хватило места в очереди, при следующем вызове обслуживается первым.
+                  По окончании передачи вызывается StreamComplete. Окно, не получившее ответа на запрос
+                  открытия за IRIDIUM_STREAM_OPEN_TIMEOUT, освобождается без вызова обработчиков
+*/
+void CIridiumProtocol::ProcessStream(u32 in_u32Time)
+{
+   iridium_address_t l_aAddr[IRIDIUM_STREAM_MAX_TX];
+   u8 l_aStreamID[IRIDIUM_STREAM_MAX_TX];
+   bool l_aSuccess[IRIDIUM_STREAM_MAX_TX];
+   size_t l_stDone = 0;
+   size_t l_stStart = m_stStreamTx;
+   bool l_bSend = true;
+   bool l_bFull = false;
+   u32 l_u32Index = 0;
+   const void* l_pBlock = NULL;
+   u16 l_u16Size = 0;
+
+   Lock();
+   while(l_bSend && !l_bFull)
+   {
+      l_bSend = false;
+      for(size_t i = 0; !l_bFull && i < IRIDIUM_STREAM_MAX_TX; i++)
+      {
+         size_t l_stIndex = (l_stStart + i) % IRIDIUM_STREAM_MAX_TX;
+         CIridiumStreamWindow& l_rWindow = m_aStreamTx[l_stIndex];
+         // Окно ожидающее ответа на запрос открытия пропускается
+         if(l_rWindow.GetStreamID() && l_rWindow.GetNext(in_u32Time, l_u32Index))
+         {
+            // Получение данных блока у приложения
+            if(!StreamGetBlock(l_rWindow.GetAddress(), l_rWindow.GetStreamID(), l_u32Index, l_pBlock, l_u16Size))
+               l_rWindow.SetEnd(l_u32Index);
+            else if(SendStreamBlockRequest(l_rWindow.GetAddress(), l_rWindow.GetStreamID(), (u8)l_u32Index, l_u16Size, l_pBlock))
+            {
+               l_rWindow.Sent(l_u32Index, in_u32Time);
+               l_bSend = true;
+            } else
+            {
+               m_stStreamTx = l_stIndex;
+               l_bFull = true;
+            }
+         }
+      }
+   }
+   if(!l_bFull)
+      m_stStreamTx = (l_stStart + 1) % IRIDIUM_STREAM_MAX_TX;
+
+   // Проверка окончания передачи
+   for(size_t i = 0; i < IRIDIUM_STREAM_MAX_TX; i++)
+   {
+      CIridiumStreamWindow& l_rWindow = m_aStreamTx[i];
+      if(l_rWindow.GetStreamID() && (l_rWindow.IsFailed() || l_rWindow.IsComplete()))
+      {
+         l_aAddr[l_stDone] = l_rWindow.GetAddress();
+         l_aStreamID[l_stDone] = l_rWindow.GetStreamID();
+         l_aSuccess[l_stDone] = !l_rWindow.IsFailed();
+         l_stDone++;
+         l_rWindow.Close();
+      } else if(l_rWindow.IsOpenExpired(in_u32Time))
+         l_rWindow.Close();
+   }
+   Unlock();
+
+   // Вызов обработчиков окончания передачи
+   for(size_t i = 0; i < l_stDone; i++)
+      StreamComplete(l_aAddr[i], l_aStreamID[i], l_aSuccess[i]);
+}
+
+/**
+   Поиск окна передачи потока
+   на входе    :  in_Addr        - адрес получателя потока
+                  in_u8StreamID  - идентификатор потока (0 - окно ожидающее ответа на запрос открытия)
+                  in_bFree       - при отсутствии окна вернуть свободное окно
+   на выходе   :  указатель на окно, NULL - окно не найдено
+*/
+CIridiumStreamWindow* CIridiumProtocol::FindStreamWindow(iridium_address_t in_Addr, u8 in_u8StreamID, bool in_bFree)
+{
+   CIridiumStreamWindow* l_pResult = NULL;
+
+   for(size_t i = 0; !l_pResult && i < IRIDIUM_STREAM_MAX_TX; i++)
+   {
+      if(m_aStreamTx[i].IsOpen() && m_aStreamTx[i].GetAddress() == in_Addr && m_aStreamTx[i].GetStreamID() == in_u8StreamID)
+         l_pResult = &m_aStreamTx[i];
+   }
+   for(size_t i = 0; in_bFree && !l_pResult && i < IRIDIUM_STREAM_MAX_TX; i++)
+   {
+      if(!m_aStreamTx[i].IsOpen())
+         l_pResult = &m_aStreamTx[i];
+   }
+   return l_pResult;
+}
+
+/**
+   Закрытие окон передачи потоков получателю
+   на входе    :  in_DstAddr  - адрес получателя
+   на выходе   :  *
+   примечание  :  закрываются и окна ожидающие ответа на запрос открытия, StreamComplete не вызывается
+*/
+void CIridiumProtocol::CloseStreamWindow(iridium_address_t in_DstAddr)
+{
+   Lock();
+   for(size_t i = 0; i < IRIDIUM_STREAM_MAX_TX; i++)
+   {
+      if(m_aStreamTx[i].IsOpen() && m_aStreamTx[i].GetAddress() == in_DstAddr)
+         m_aStreamTx[i].Close();
+   }
+   Unlock();
+}
+
+/**
+   Получение размера окна передачи потока
+   на входе    :  in_DstAddr     - адрес получателя
+                  in_u8StreamID  - идентификатор потока
+   на выходе   :  размер окна, 0 - поток передается по одному блоку или передача окончена
+*/
+u8 CIridiumProtocol::GetStreamWindow(iridium_address_t in_DstAddr, u8 in_u8StreamID)
+{
+   u8 l_u8Result = 0;
+
+   Lock();
+   CIridiumStreamWindow* l_pWindow = in_u8StreamID ? FindStreamWindow(in_DstAddr, in_u8StreamID, false) : NULL;
+   if(l_pWindow)
+      l_u8Result = l_pWindow->GetWindow();
+   Unlock();
+   return l_u8Result;
+}
+
+/**
+   Получение количества подтвержденных блоков потока
+   на входе    :  in_DstAddr     - адрес получателя
+                  in_u8StreamID  - идентификатор потока
+   на выходе   :  количество блоков подтвержденных по порядку
+*/
+u32 CIridiumProtocol::GetStreamProgress(iridium_address_t in_DstAddr, u8 in_u8StreamID)
+{
+   u32 l_u32Result = 0;
+
+   Lock();
+   CIridiumStreamWindow* l_pWindow = in_u8StreamID ? FindStreamWindow(in_DstAddr, in_u8StreamID, false) : NULL;
+   if(l_pWindow)
+      l_u32Result = l_pWindow->GetBase();
+   Unlock();
+   return l_u32Result;
+}
+
+#endif   // defined(IRIDIUM_ENABLE_STREAM_WINDOW)
+
 #endif   // #if defined(IRIDIUM_CONFIG_STREAM_BLOCK_MASTER)
 
 #if defined(IRIDIUM_CONFIG_STREAM_BLOCK_SLAVE)
@@ -1839,9 +3361,19 @@ void CIridiumProtocol::ReceiveStreamBlockRequest()
          // Получение длинны блока
          if(m_pInMessage->GetU16LE(l_u16Size))
          {
-            // Вызов обработчика получения блока
-            l_u16Size = (u16)StreamBlock(l_u8StreamID, l_u8BlockID, l_u16Size, m_pInMessage->GetDataPtr());
-            SendStreamBlockResponse(l_u8StreamID, l_u8BlockID, l_u16Size);
+#if defined(IRIDIUM_ENABLE_STREAM_WINDOW)
+            if(m_StreamRx.IsOpen() && m_StreamRx.GetStreamID() == l_u8StreamID)
+            {
+               // Прием блока потока открытого окном
+               if(l_u16Size <= m_pInMessage->Size())
+                  ReceiveStreamWindowBlock(l_u8BlockID, l_u16Size, m_pInMessage->GetDataPtr());
+            } else
+#endif
+            {
+               // Вызов обработчика получения блока
+               l_u16Size = (u16)StreamBlock(l_u8StreamID, l_u8BlockID, l_u16Size, m_pInMessage->GetDataPtr());
+               SendStreamBlockResponse(l_u8StreamID, l_u8BlockID, l_u16Size);
+            }
             m_eError = IRIDIUM_OK;
          }
       }
@@ -1857,20 +3389,106 @@ void CIridiumProtocol::ReceiveStreamBlockRequest()
 */
 bool CIridiumProtocol::SendStreamBlockResponse(u8 in_u8StreamID, u8 in_u8BlockID, u16 in_u16Size)
 {
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
+
    // Инициализация пакета ответа
    InitResponsePacket();
    // Начало работы с пакетом
-   Begin();
+   l_pOut->Begin();
    // Добавление идентификатора потока
-   m_pOutMessage->AddU8(in_u8StreamID);
+   l_pOut->m_pBuffer->AddU8(in_u8StreamID);
    // Добавление идентификатора блока
-   m_pOutMessage->AddU8(in_u8BlockID);
+   l_pOut->m_pBuffer->AddU8(in_u8BlockID);
    // Добавление длинны блока
-   m_pOutMessage->AddU16LE(in_u16Size);
+   l_pOut->m_pBuffer->AddU16LE(in_u16Size);
    // Окончание работы и отправка пакета
-   return End();
+   return l_pOut->End();
+}
+
+#if defined(IRIDIUM_ENABLE_STREAM_WINDOW)
+
+/**
+   Подтверждение блоков потока открытого окном
+   на входе    :  in_u8StreamID  - идентификатор потока
+                  in_u8BlockID   - идентификатор последнего блока принятого по порядку
+                  in_u16Size     - результат обработки этого блока
+                  in_u16Mask     - маска блоков принятых после него (бит i - блок in_u8BlockID + 1 + i)
+   на выходе   :  успешность
+*/
+bool CIridiumProtocol::SendStreamBlockResponse(u8 in_u8StreamID, u8 in_u8BlockID, u16 in_u16Size, u16 in_u16Mask)
+{
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
+
+   // Инициализация пакета ответа
+   InitResponsePacket();
+   // Начало работы с пакетом
+   l_pOut->Begin();
+   // Добавление идентификатора потока
+   l_pOut->m_pBuffer->AddU8(in_u8StreamID);
+   // Добавление идентификатора блока
+   l_pOut->m_pBuffer->AddU8(in_u8BlockID);
+   // Добавление длинны блока
+   l_pOut->m_pBuffer->AddU16LE(in_u16Size);
+   // Добавление маски принятых блоков
+   l_pOut->m_pBuffer->AddU16LE(in_u16Mask);
+   // Окончание работы и отправка пакета
+   return l_pOut->End();
+}
+
+/**
+   Открытие окна приема блоков потока
+   на входе    :  in_SrcAddr     - адрес отправителя блоков
+                  in_u8StreamID  - идентификатор потока
+                  in_u8Window    - размер окна запрошенный отправителем
+   на выходе   :  согласованный размер окна, 0 - окно не открыто
+   примечание  :  окно ограничено буфером блоков полученных вне очереди (SetStreamBuffer), окно из
+                  одного блока отбрасывает повторно полученные блоки
+*/
+u8 CIridiumProtocol::OpenStreamWindow(iridium_address_t in_SrcAddr, u8 in_u8StreamID, u8 in_u8Window)
+{
+   u8 l_u8Window = m_StreamRx.GetMaxWindow();
+
+   if(in_u8Window < l_u8Window)
+      l_u8Window = in_u8Window;
+   if(l_u8Window)
+      m_StreamRx.Open(in_SrcAddr, in_u8StreamID, l_u8Window);
+   else
+      m_StreamRx.Close();
+   return l_u8Window;
+}
+
+/**
+   Обработка блока потока открытого окном
+   на входе    :  in_u8BlockID   - идентификатор блока
+                  in_u16Size     - размер данных блока
+                  in_pData       - указатель на данные блока
+   на выходе   :  *
+   примечание  :  приложению блоки передаются строго по порядку, после ожидаемого блока передаются
+                  сохраненные блоки следующие за ним. Подтверждение отправляется на каждый блок
+*/
+void CIridiumProtocol::ReceiveStreamWindowBlock(u8 in_u8BlockID, u16 in_u16Size, const void* in_pData)
+{
+   u8 l_u8StreamID = m_StreamRx.GetStreamID();
+   u8 l_u8BlockID = 0;
+   u16 l_u16Size = 0;
+   u16 l_u16Mask = 0;
+   void* l_pData = NULL;
+
+   if(m_StreamRx.Receive(in_u8BlockID, in_u16Size, in_pData))
+   {
+      // Вызов обработчика получения блока
+      m_StreamRx.Delivered((u16)StreamBlock(l_u8StreamID, in_u8BlockID, in_u16Size, in_pData));
+      // Передача сохраненных блоков, полученных ранее вне очереди
+      while(m_StreamRx.GetStored(l_u8BlockID, l_u16Size, l_pData))
+         m_StreamRx.Delivered((u16)StreamBlock(l_u8StreamID, l_u8BlockID, l_u16Size, l_pData));
+   }
+   // Отправка подтверждения
+   m_StreamRx.GetAck(l_u8BlockID, l_u16Size, l_u16Mask);
+   SendStreamBlockResponse(l_u8StreamID, l_u8BlockID, l_u16Size, l_u16Mask);
 }
 
+#endif   // defined(IRIDIUM_ENABLE_STREAM_WINDOW)
+
 #endif   // #if defined(IRIDIUM_CONFIG_STREAM_BLOCK_SLAVE)
 
 #if defined(IRIDIUM_CONFIG_STREAM_CLOSE_MASTER)
@@ -1883,14 +3501,16 @@ bool CIridiumProtocol::SendStreamBlockResponse(u8 in_u8StreamID, u8 in_u8BlockID
 */
 bool CIridiumProtocol::SendStreamCloseRequest(iridium_address_t in_DstAddr, u8 in_u8StreamID)
 {
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
+
    // Заполнение данных пакета
    InitRequestPacket(in_DstAddr, IRIDIUM_MESSAGE_STREAM_CLOSE);
    // Начало работы с пакетом
-   Begin();
+   l_pOut->Begin();
    // Добавление идентификатора потока
-   m_pOutMessage->AddU8(in_u8StreamID);
+   l_pOut->m_pBuffer->AddU8(in_u8StreamID);
    // Окончание работы и отправка пакета
-   return End();
+   return l_pOut->End();
 }
 
 /**
@@ -1904,6 +3524,14 @@ void CIridiumProtocol::ReceiveStreamCloseResponse()
    // Получение идентификатора открытого потока
    if(m_pInMessage->GetU8(l_u8StreamID))
    {
+#if defined(IRIDIUM_ENABLE_STREAM_WINDOW) && defined(IRIDIUM_CONFIG_STREAM_BLOCK_MASTER)
+      // Закрытие окна передачи потока
+      Lock();
+      CIridiumStreamWindow* l_pWindow = l_u8StreamID ? FindStreamWindow(GetSrcAddress(), l_u8StreamID, false) : NULL;
+      if(l_pWindow)
+         l_pWindow->Close();
+      Unlock();
+#endif
       // Вызов обработчика закрытия потока
       StreamClose(l_u8StreamID);
    }
@@ -1926,6 +3554,11 @@ void CIridiumProtocol::ReceiveStreamCloseRequest()
    {
       // Отправка ответа на закрытие потока
       SendStreamCloseResponse(l_u8StreamID);
+#if defined(IRIDIUM_ENABLE_STREAM_WINDOW) && defined(IRIDIUM_CONFIG_STREAM_BLOCK_SLAVE)
+      // Закрытие окна приема потока
+      if(m_StreamRx.GetStreamID() == l_u8StreamID)
+         m_StreamRx.Close();
+#endif
       // Вызов обработчика закрытия потока
       StreamClose(l_u8StreamID);
    }
@@ -1938,27 +3571,38 @@ void CIridiumProtocol::ReceiveStreamCloseRequest()
 */
 bool CIridiumProtocol::SendStreamCloseResponse(u8 in_u8StreamID)
 {
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
+
    // Инициализация пакета ответа
    InitResponsePacket();
    // Начало работы с пакетом
-   Begin();
+   l_pOut->Begin();
    // Добавление идентификатора потока
-   m_pOutMessage->AddU8(in_u8StreamID);
+   l_pOut->m_pBuffer->AddU8(in_u8StreamID);
    // Окончание работы и отправка пакета
-   return End();
+   return l_pOut->End();
 }
 
 #endif   // #if defined(IRIDIUM_CONFIG_STREAM_CLOSE_SLAVE)
 
 /**
-   Начало формирования пакета
-   на входе    :  *
+   Начало формирования пакета построителем
+   на входе    :  in_pOut  - указатель на построитель пакета
    на выходе   :  *
-   примечание  :  данная процедура нужна для уменьшения размера исполняемого кода
+   примечание  :  тип протокола, приоритет, версия и шифрование пакета берутся из шаблона m_OutPH,
+                  адресация пакета заполняется построителем. Интерактивные сообщения (см. GetMessagePriority)
+                  отправляются с флагом приоритета
 */
-void CIridiumProtocol::Begin()
+void CIridiumProtocol::BeginPacket(CIridiumPacketBuilder* in_pOut)
 {
    size_t l_stSize = 0;
+   CIridiumOutBuffer* l_pBuffer = in_pOut->m_pBuffer;
+
+   // Заполнение общих данных заголовка пакета
+   in_pOut->m_PH.m_u8Type              = m_OutPH.m_u8Type;
+   in_pOut->m_PH.m_Flags.m_bPriority   = m_OutPH.m_Flags.m_bPriority || GetMessagePriority(in_pOut->m_MH.m_u8Type);
+   in_pOut->m_PH.m_Flags.m_u2Version   = m_OutPH.m_Flags.m_u2Version;
+   in_pOut->m_PH.m_Flags.m_u3Crypt     = m_OutPH.m_Flags.m_u3Crypt;
 
    // Получение размера блока
 #if defined(IRIDIUM_ENABLE_CIPHER)
@@ -1966,35 +3610,118 @@ void CIridiumProtocol::Begin()
       l_stSize = m_pCipher->GetBlockSize();
 #endif
 
-   m_pOutMessage->Clear();
+   l_pBuffer->Clear();
    // Начало работы с пакетом
-   m_pOutMessage->Begin(l_stSize);
+   l_pBuffer->Begin(l_stSize);
+   // Ссылки на внешние данные возможны только если сообщение не шифруется
+#if defined(IRIDIUM_ENABLE_CIPHER)
+   l_pBuffer->AllowDataRef(m_pCipher == NULL);
+#else
+   l_pBuffer->AllowDataRef(true);
+#endif
    // Добавление заголовка сообщения
-   m_pOutMessage->AddMessageHeader(m_OutMH);
+   l_pBuffer->AddMessageHeader(in_pOut->m_MH);
 }
 
 /**
-   Окончание формирования пакета
-   на входе    :  *
+   Окончание формирования пакета построителем и отправка пакета
+   на входе    :  in_pOut  - указатель на построитель пакета
    на выходе   :  успешность окончания работы с пакетов
+   примечание  :  кодирование, регистрация транзакции и отправка выполняются под захватом общих данных
+                  протокола (Lock/Unlock), так как шифр с вектором инициализации и таблица транзакций
+                  зависят от порядка отправки пакетов
 */
-bool CIridiumProtocol::End()
+bool CIridiumProtocol::EndPacket(CIridiumPacketBuilder* in_pOut)
 {
+   bool l_bResult = false;
+   bool l_bSend = true;
+   CIridiumOutBuffer* l_pBuffer = in_pOut->m_pBuffer;
+
    // Установка признака конца цепочки
-   m_pOutMessage->SetMessageHeaderEnd(m_OutMH.m_Flags.m_bEnd);
+   l_pBuffer->SetMessageHeaderEnd(in_pOut->m_MH.m_Flags.m_bEnd);
+
+   Lock();
 
    // Кодирование сообщения
 #if defined(IRIDIUM_ENABLE_CIPHER)
 
-   size_t l_stMax = m_pOutMessage->GetMaxMessageSize();
-   if(EncodeMessage(m_pOutMessage->GetMessagePtr(), m_pOutMessage->GetMessageSize(), l_stMax))
-      m_pOutMessage->SetMessageSize(l_stMax);
+   size_t l_stMax = l_pBuffer->GetMaxMessageSize();
+   if(EncodeMessage(l_pBuffer->GetMessagePtr(), l_pBuffer->GetMessageSize(), l_stMax))
+      l_pBuffer->SetMessageSize(l_stMax);
 #endif
 
    // Окончание работы с пакетом
-   m_pOutMessage->End(m_OutPH);
-   // Отправка пакета
-   return SendPacket(m_pOutMessage->GetPacketPtr(), m_pOutMessage->GetPacketSize());
+   l_pBuffer->End(in_pOut->m_PH);
+
+#if defined(IRIDIUM_ENABLE_TRANSACTIONS)
+   // Регистрация запроса в таблице транзакций, если таблица заполнена запрос не отправляется
+   iridium_transaction_t* l_pTransaction = NULL;
+   l_bSend = AddTransaction(in_pOut, l_pTransaction);
+   // Окно получателя заполнено, запрос ожидает в очереди и будет отправлен после получения ответов
+   if(l_bSend && l_pTransaction && !l_pTransaction->m_bSent)
+   {
+      l_bSend = false;
+      l_bResult = true;
+   }
+#endif
+
+   if(l_bSend)
+   {
+      // Отправка пакета со ссылкой на внешние данные по сегментам
+      if(l_pBuffer->IsDataRef())
+      {
+         iridium_iovec_t l_aVec[IRIDIUM_PACKET_MAX_SEGMENTS];
+         size_t l_stCount = l_pBuffer->GetPacketVector(l_aVec, IRIDIUM_PACKET_MAX_SEGMENTS);
+         l_bResult = SendPacketV(l_aVec, l_stCount);
+      } else
+      {
+         // Отправка пакета
+         l_bResult = SendPacket(l_pBuffer->GetPacketPtr(), l_pBuffer->GetPacketSize());
+      }
+
+#if defined(IRIDIUM_ENABLE_TRANSACTIONS)
+      // Запрос не отправлен, ожидать ответа не нужно
+      if(!l_bResult && l_pTransaction)
+         m_Transactions.Remove(l_pTransaction);
+#endif
+   }
+
+   Unlock();
+   return l_bResult;
+}
+
+/**
+   Отправка пакета, состоящего из нескольких сегментов
+   на входе    :  in_pVec     - указатель на массив сегментов пакета
+                  in_stCount  - количество сегментов
+   на выходе   :  успешность отправки
+   примечание  :  реализация по умолчанию собирает сегменты в буфере первого сегмента и вызывает SendPacket.
+                  Место под все сегменты зарезервировано в исходящем буфере (см. CIridiumOutBuffer::GetPacketVector).
+                  Реализации, умеющие отправлять данные по частям (writev, DMA цепочки и т.п.), могут
+                  перегрузить метод и отправлять сегменты без копирования. Внешние данные доступны только
+                  до возврата из метода
+*/
+bool CIridiumProtocol::SendPacketV(const iridium_iovec_t* in_pVec, size_t in_stCount)
+{
+   bool l_bResult = false;
+
+   // Проверка входных параметров
+   if(in_pVec && in_stCount)
+   {
+      u8* l_pBuffer = (u8*)in_pVec[0].m_pPtr;
+      u8* l_pPtr = l_pBuffer + in_pVec[0].m_stSize;
+
+      // Сборка пакета
+      for(size_t i = 1; i < in_stCount; i++)
+      {
+         if(in_pVec[i].m_stSize && in_pVec[i].m_pPtr != l_pPtr)
+            memmove(l_pPtr, in_pVec[i].m_pPtr, in_pVec[i].m_stSize);
+         l_pPtr += in_pVec[i].m_stSize;
+      }
+      // Отправка собранного пакета
+      l_bResult = SendPacket(l_pBuffer, l_pPtr - l_pBuffer);
+   }
+   return l_bResult;
 }
 
 /**
@@ -2006,6 +3733,7 @@ bool CIridiumProtocol::End()
 */
 bool CIridiumProtocol::Resend(iridium_packet_header_t* in_pPH, const void* in_pPtr, size_t in_stSize)
 {
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
    bool l_bResult = false;
    size_t l_stSize = 0;
    iridium_packet_header_t l_PH;
@@ -2025,22 +3753,26 @@ bool CIridiumProtocol::Resend(iridium_packet_header_t* in_pPH, const void* in_pP
 #endif
 
       // Начало работы с пакетом
-      m_pOutMessage->Begin(l_stSize);
+      l_pOut->m_pBuffer->Begin(l_stSize);
       // Добавление сообщения
-      m_pOutMessage->AddData(in_pPtr, in_stSize);
+      l_pOut->m_pBuffer->AddData(in_pPtr, in_stSize);
+
+      Lock();
 
       // Кодирование сообщения
 #if defined(IRIDIUM_ENABLE_CIPHER)
 
-      size_t l_stMax = m_pOutMessage->GetMaxMessageSize();
-      if(EncodeMessage(m_pOutMessage->GetMessagePtr(), m_pOutMessage->GetMessageSize(), l_stMax))
-         m_pOutMessage->SetMessageSize(l_stMax);
+      size_t l_stMax = l_pOut->m_pBuffer->GetMaxMessageSize();
+      if(EncodeMessage(l_pOut->m_pBuffer->GetMessagePtr(), l_pOut->m_pBuffer->GetMessageSize(), l_stMax))
+         l_pOut->m_pBuffer->SetMessageSize(l_stMax);
 
 #endif
       // Конец работы с пакетом
-      m_pOutMessage->End(l_PH);
+      l_pOut->m_pBuffer->End(l_PH);
       // Отправка сформированного пакета
-      l_bResult = SendPacket(m_pOutMessage->GetPacketPtr(), m_pOutMessage->GetPacketSize());
+      l_bResult = SendPacket(l_pOut->m_pBuffer->GetPacketPtr(), l_pOut->m_pBuffer->GetPacketSize());
+
+      Unlock();
    }
    return l_bResult;
 }
@@ -2066,7 +3798,7 @@ bool CIridiumProtocol::ProcessMessage(iridium_packet_header_t* in_pPH, const voi
       if(m_pInMessage->GetMessageHeader(m_InMH))
       {
          // Проверка номера версии сообщения
-         if(m_InMH.m_Flags.m_u4Version <= GetMessageVersion(m_InMH.m_u8Type))
+         if(m_InMH.m_Flags.m_u4Version <= GetVersion(m_InMH.m_u8Type))
          {
             m_eError = IRIDIUM_OK;
             if(m_InMH.m_Flags.m_bDirection == IRIDIUM_REQUEST)
@@ -2080,22 +3812,58 @@ bool CIridiumProtocol::ProcessMessage(iridium_packet_header_t* in_pPH, const voi
 
             } else
             {
+#if defined(IRIDIUM_ENABLE_TRANSACTIONS)
+               // Поиск запроса, на который получен ответ, таблица транзакций захватывается до завершения обработки
+               Lock();
+               iridium_transaction_t* l_pTransaction = m_InMH.m_Flags.m_bNoTID ? NULL : m_Transactions.Find(m_pInPH->m_SrcAddr, m_InMH.m_u16TID);
+#endif
                // Обработка ответа на запрос
                if(m_InMH.m_Flags.m_bError)
                {
                   // Получение кода ошибки
                   u8 l_u8Error = 0;
                   m_pInMessage->GetU8(l_u8Error);
+#if defined(IRIDIUM_ENABLE_STREAM_WINDOW) && defined(IRIDIUM_CONFIG_STREAM_BLOCK_MASTER)
+                  // Поток не открыт, освободим окно, зарезервированное до получения ответа
+                  if(m_InMH.m_u8Type == IRIDIUM_MESSAGE_STREAM_OPEN)
+                  {
+                     Lock();
+                     CIridiumStreamWindow* l_pWindow = FindStreamWindow(GetSrcAddress(), 0, false);
+                     if(l_pWindow)
+                        l_pWindow->Close();
+                     Unlock();
+                  }
+#endif
                   // Сообщим о полученой ошибке
                   ReceivedError((eIridiumError)l_u8Error, m_pInPH, &m_InMH);
                   // Сбросим ошибку
                   m_eError = IRIDIUM_OK;
+#if defined(IRIDIUM_ENABLE_TRANSACTIONS)
+                  // Завершение транзакции с ошибкой и отправка ожидающих запросов
+                  CompleteTransaction(l_pTransaction, IRIDIUM_TRANSACTION_ERROR, (eIridiumError)l_u8Error);
+                  SendTransactions();
+#endif
 
                } else
                {
                   // Обработка ответа на запрос
                   ProcessMessageResponse();
+#if defined(IRIDIUM_ENABLE_TRANSACTIONS)
+                  if(l_pTransaction)
+                  {
+                     // Транзакция завершается последним пакетом цепочки ответа, иначе продлим ожидание
+                     if(m_InMH.m_Flags.m_bEnd)
+                     {
+                        CompleteTransaction(l_pTransaction, IRIDIUM_TRANSACTION_DONE, IRIDIUM_OK);
+                        SendTransactions();
+                     } else
+                        m_Transactions.Send(l_pTransaction, m_u32Time);
+                  }
+#endif
                }
+#if defined(IRIDIUM_ENABLE_TRANSACTIONS)
+               Unlock();
+#endif
             }
             l_bResult = true;
 
@@ -2121,138 +3889,11 @@ bool CIridiumProtocol::ProcessMessage(iridium_packet_header_t* in_pPH, const voi
 void CIridiumProtocol::ProcessMessageRequest()
 {
    // Обработка данных пакета
-   switch(m_InMH.m_u8Type)
-   {
-#if defined(IRIDIUM_CONFIG_SYSTEM_PING_SLAVE)
-   // Пинг
-   case IRIDIUM_MESSAGE_SYSTEM_PING:
-      ReceivePingRequest();
-      break;
-#endif
-#if defined(IRIDIUM_CONFIG_SYSTEM_SEARCH_SLAVE)
-   // Поиск
-   case IRIDIUM_MESSAGE_SYSTEM_SEARCH:
-      ReceiveSearchRequest();
-      break;
-#endif
-#if defined(IRIDIUM_CONFIG_SYSTEM_DEVICE_INFO_SLAVE)
-   // Информация об устройстве
-   case IRIDIUM_MESSAGE_SYSTEM_DEVICE_INFO:
-      ReceiveDeviceInfoRequest();
-      break;
-#endif
-#if defined(IRIDIUM_CONFIG_SYSTEM_SET_LID_SLAVE)
-   // Установка локального идентификатора
-   case IRIDIUM_MESSAGE_SYSTEM_SET_LID:
-      ReceiveSetLIDRequest();
-      break;
-#endif
-#if defined(IRIDIUM_CONFIG_SYSTEM_SMART_API_SLAVE)
-   // Получение информации о Smart API
-   case IRIDIUM_MESSAGE_SYSTEM_SMART_API:
-      ReceiveSmartAPIRequest();
-      break;
-#endif
-
-#if defined(IRIDIUM_CONFIG_SET_VARIABLE_SLAVE)
-   // Установка глобальной переменной
-   case IRIDIUM_MESSAGE_SET_VARIABLE:
-      ReceiveSetVariableRequest();
-      break;
-#endif
-#if defined(IRIDIUM_CONFIG_GET_VARIABLE_SLAVE)
-   // Получение глобальной переменной
-   case IRIDIUM_MESSAGE_GET_VARIABLE:
-      ReceiveGetVariableRequest();
-      break;
-#endif
-
-#if defined(IRIDIUM_CONFIG_GET_TAGS_SLAVE)
-   // Получение списка каналов обратной связи
-   case IRIDIUM_MESSAGE_GET_TAGS:
-      ReceiveGetTagsRequest();
-      break;
-#endif
-#if defined(IRIDIUM_CONFIG_LINK_TAG_AND_VARIABLE_SLAVE)
-   // Связывание канала обратной связи и глобальной переменной
-   case IRIDIUM_MESSAGE_LINK_TAG_AND_VARIABLE:
-      ReceiveLinkTagAndVariableRequest();
-      break;
-#endif
-#if defined(IRIDIUM_CONFIG_GET_TAG_DESCRIPTION_SLAVE)
-   // Получение описания канала обратной связи
-   case IRIDIUM_MESSAGE_GET_TAG_DESCRIPTION:
-      ReceiveGetTagDescriptionRequest();
-      break;
-#endif
-#if defined(IRIDIUM_CONFIG_SET_TAG_VALUE_SLAVE)
-   // Установка значения канала обратной связи
-   case IRIDIUM_MESSAGE_SET_TAG_VALUE:
-      ReceiveSetTagValueRequest();
-      break;
-#endif
-#if defined(IRIDIUM_CONFIG_GET_TAG_VALUE_SLAVE)
-   // Получение значения канала обратной связи
-   case IRIDIUM_MESSAGE_GET_TAG_VALUE:
-      ReceiveGetTagValueRequest();
-      break;
-#endif
-
-#if defined(IRIDIUM_CONFIG_GET_CHANNELS_SLAVE)
-   // Получение списка каналов управления
-   case IRIDIUM_MESSAGE_GET_CHANNELS:
-      ReceiveGetChannelsRequest();
-      break;
-#endif
-#if defined(IRIDIUM_CONFIG_SET_CHANNEL_VALUE_SLAVE)
-   // Установка значения канала управления
-   case IRIDIUM_MESSAGE_SET_CHANNEL_VALUE:
-      ReceiveSetChannelValueRequest();
-      break;
-#endif
-#if defined(IRIDIUM_CONFIG_LINK_CHANNEL_AND_VARIABLE_SLAVE)
-   // Связывание канала управления и глобальной переменной
-   case IRIDIUM_MESSAGE_LINK_CHANNEL_AND_VARIABLE:
-      ReceiveLinkChannelAndVariableRequest();
-      break;
-#endif
-#if defined(IRIDIUM_CONFIG_GET_CHANNEL_DESCRIPTION_SLAVE)
-   // Получение описания канала управления
-   case IRIDIUM_MESSAGE_GET_CHANNEL_DESCRIPTION:
-      ReceiveGetChannelDescriptionRequest();
-      break;
-#endif
-#if defined(IRIDIUM_CONFIG_GET_CHANNEL_VALUE_SLAVE)
-   // Получение значения канала управления
-   case IRIDIUM_MESSAGE_GET_CHANNEL_VALUE:
-      ReceiveGetChannelValueRequest();
-      break;
-#endif
-
-#if defined(IRIDIUM_CONFIG_STREAM_OPEN_SLAVE)
-   // Открытия потока
-   case IRIDIUM_MESSAGE_STREAM_OPEN:
-      ReceiveStreamOpenRequest();
-      break;
-#endif
-#if defined(IRIDIUM_CONFIG_STREAM_BLOCK_SLAVE)
-   // Передача блока потока
-   case IRIDIUM_MESSAGE_STREAM_BLOCK:
-      ReceiveStreamBlockRequest();
-      break;
-#endif
-#if defined(IRIDIUM_CONFIG_STREAM_CLOSE_SLAVE)
-   // Закрытия потока
-   case IRIDIUM_MESSAGE_STREAM_CLOSE:
-      ReceiveStreamCloseRequest();
-      break;
-#endif
-
-   // Неизвестное тип сообщения
-   default:
+   const iridium_message_entry_t* l_pEntry = GetMessageHandler(m_InMH.m_u8Type, IRIDIUM_REQUEST);
+   if(l_pEntry)
+      (this->*l_pEntry->m_pHandler)();
+   else
       m_eError = IRIDIUM_UNKNOWN_MESSAGE;
-      break;
-   }
 }
 
 /**
@@ -2263,139 +3904,85 @@ void CIridiumProtocol::ProcessMessageRequest()
 void CIridiumProtocol::ProcessMessageResponse()
 {
    // Обработка данных пакета
-   switch(m_InMH.m_u8Type)
-   {
-#if defined(IRIDIUM_CONFIG_SYSTEM_PING_MASTER)
-   // Пинг
-   case IRIDIUM_MESSAGE_SYSTEM_PING:
-      ReceivePingResponse();
-      break;
-#endif
-#if defined(IRIDIUM_CONFIG_SYSTEM_SEARCH_MASTER)
-   // Поиск
-   case IRIDIUM_MESSAGE_SYSTEM_SEARCH:
-      ReceiveSearchResponse();
-      break;
-#endif
-#if defined(IRIDIUM_CONFIG_SYSTEM_DEVICE_INFO_MASTER)
-   // Информация об устройстве
-   case IRIDIUM_MESSAGE_SYSTEM_DEVICE_INFO:
-      ReceiveDeviceInfoResponse();
-      break;
-#endif
-#if defined(IRIDIUM_CONFIG_SYSTEM_SET_LID_MASTER)
-   // Установка локального идентификатора
-   case IRIDIUM_MESSAGE_SYSTEM_SET_LID:
-      ReceiveSetLIDResponse();
-      break;
-#endif
-
-#if defined(IRIDIUM_CONFIG_SYSTEM_SMART_API_MASTER)
-   // Получение информации о Smart API
-   case IRIDIUM_MESSAGE_SYSTEM_SMART_API:
-      ReceiveSmartAPIResponse();
-      break;
-#endif
+   const iridium_message_entry_t* l_pEntry = GetMessageHandler(m_InMH.m_u8Type, IRIDIUM_RESPONSE);
+   if(l_pEntry)
+      (this->*l_pEntry->m_pHandler)();
+   else
+      m_eError = IRIDIUM_UNKNOWN_MESSAGE;
+}
 
-#if defined(IRIDIUM_CONFIG_SET_VARIABLE_MASTER)
-   // Установка глобальной переменной
-   case IRIDIUM_MESSAGE_SET_VARIABLE:
-      ReceiveSetVariableResponse();
-      break;
-#endif
-#if defined(IRIDIUM_CONFIG_GET_VARIABLE_MASTER)
-   // Получение глобальной переменной
-   case IRIDIUM_MESSAGE_GET_VARIABLE:
-      ReceiveGetVariableResponse();
-      break;
-#endif
+/**
+   Регистрация обработчиков сообщений приложения
+   на входе    :  in_pHandlers   - указатель на таблицу обработчиков, NULL - удалить регистрацию
+                  in_stCount     - количество обработчиков в таблице
+   на выходе   :  *
+   примечание  :  таблица не копируется и должна существовать все время работы протокола. Таблица проверяется
+                  до встроенной, поэтому может как добавлять новые типы сообщений, так и заменять обработчики
+                  встроенных. Обработчики методов наследника приводятся к типу iridium_message_handler_t
+                  через static_cast
+*/
+void CIridiumProtocol::SetMessageHandlers(const iridium_message_entry_t* in_pHandlers, size_t in_stCount)
+{
+   m_pMessageHandlers = in_pHandlers;
+   m_stMessageHandlers = in_pHandlers ? in_stCount : 0;
+}
 
-#if defined(IRIDIUM_CONFIG_GET_TAGS_MASTER)
-   // Получение списка каналов обратной связи
-   case IRIDIUM_MESSAGE_GET_TAGS:
-      ReceiveGetTagsResponse();
-      break;
-#endif
-#if defined(IRIDIUM_CONFIG_LINK_TAG_AND_VARIABLE_MASTER)
-   // Связывание канала обратной связи и глобальной переменной
-   case IRIDIUM_MESSAGE_LINK_TAG_AND_VARIABLE:
-      ReceiveLinkTagAndVariableResponse();
-      break;
-#endif
-#if defined(IRIDIUM_CONFIG_GET_TAG_DESCRIPTION_MASTER)
-   // Получение описания канала обратной связи
-   case IRIDIUM_MESSAGE_GET_TAG_DESCRIPTION:
-      ReceiveGetTagDescriptionResponse();
-      break;
-#endif
-#if defined(IRIDIUM_CONFIG_SET_TAG_VALUE_MASTER)
-   // Установка значения канала обратной связи
-   case IRIDIUM_MESSAGE_SET_TAG_VALUE:
-      ReceiveSetTagValueResponse();
-      break;
-#endif
-#if defined(IRIDIUM_CONFIG_GET_TAG_VALUE_MASTER)
-   // Получение значения канала обратной связи
-   case IRIDIUM_MESSAGE_GET_TAG_VALUE:
-      ReceiveGetTagValueResponse();
-      break;
-#endif
+/**
+   Поиск обработчика сообщения
+   на входе    :  in_u8Type      - тип сообщения
+                  in_bDirection  - направление сообщения (IRIDIUM_REQUEST/IRIDIUM_RESPONSE)
+   на выходе   :  указатель на описание обработчика, NULL - сообщение не обрабатывается
+*/
+const iridium_message_entry_t* CIridiumProtocol::GetMessageHandler(u8 in_u8Type, bool in_bDirection)
+{
+   const iridium_message_entry_t* l_pResult = NULL;
 
-#if defined(IRIDIUM_CONFIG_GET_CHANNELS_MASTER)
-   // Получение списка каналов управления
-   case IRIDIUM_MESSAGE_GET_CHANNELS:
-      ReceiveGetChannelsResponse();
-      break;
-#endif
-#if defined(IRIDIUM_CONFIG_SET_CHANNEL_VALUE_MASTER)
-   // Установка значения канала управления
-   case IRIDIUM_MESSAGE_SET_CHANNEL_VALUE:
-      ReceiveSetChannelValueResponse();
-      break;
-#endif
-#if defined(IRIDIUM_CONFIG_LINK_CHANNEL_AND_VARIABLE_MASTER)
-   // Связывание канала управления и глобальной переменной
-   case IRIDIUM_MESSAGE_LINK_CHANNEL_AND_VARIABLE:
-      ReceiveLinkChannelAndVariableResponse();
-      break;
-#endif
-#if defined(IRIDIUM_CONFIG_GET_CHANNEL_DESCRIPTION_MASTER)
-   // Получение описания канала управления
-   case IRIDIUM_MESSAGE_GET_CHANNEL_DESCRIPTION:
-      ReceiveGetChannelDescriptionResponse();
-      break;
-#endif
-#if defined(IRIDIUM_CONFIG_GET_CHANNEL_VALUE_MASTER)
-   // Получение значения канала управления
-   case IRIDIUM_MESSAGE_GET_CHANNEL_VALUE:
-      ReceiveGetChannelValueResponse();
-      break;
-#endif
+   // Поиск в таблице приложения
+   for(size_t i = 0; i < m_stMessageHandlers; i++)
+   {
+      const iridium_message_entry_t* l_pEntry = &m_pMessageHandlers[i];
+      if(l_pEntry->m_u8Type == in_u8Type && l_pEntry->m_bDirection == in_bDirection && l_pEntry->m_pHandler)
+      {
+         l_pResult = l_pEntry;
+         break;
+      }
+   }
 
-#if defined(IRIDIUM_CONFIG_STREAM_OPEN_MASTER)
-   // Открытия потока
-   case IRIDIUM_MESSAGE_STREAM_OPEN:
-      ReceiveStreamOpenResponse();
-      break;
-#endif
-#if defined(IRIDIUM_CONFIG_STREAM_BLOCK_MASTER)
-   // Передача блока потока
-   case IRIDIUM_MESSAGE_STREAM_BLOCK:
-      ReceiveStreamBlockResponse();
-      break;
-#endif
-#if defined(IRIDIUM_CONFIG_STREAM_CLOSE_MASTER)
-   // Закрытия потока
-   case IRIDIUM_MESSAGE_STREAM_CLOSE:
-      ReceiveStreamCloseResponse();
-      break;
-#endif
+   // Поиск во встроенной таблице по индексу
+   if(!l_pResult && in_u8Type <= IRIDIUM_MESSAGE_MAX)
+   {
+      for(size_t i = g_aMessageIndex[in_u8Type]; i && i <= IRIDIUM_MESSAGE_HANDLERS && g_aMessageHandlers[i - 1].m_u8Type == in_u8Type; i++)
+      {
+         if(g_aMessageHandlers[i - 1].m_bDirection == in_bDirection)
+         {
+            l_pResult = &g_aMessageHandlers[i - 1];
+            break;
+         }
+      }
+   }
+   return l_pResult;
+}
 
-   // Неизвестное тип сообщения
-   default:
-      m_eError = IRIDIUM_UNKNOWN_MESSAGE;
-      break;
+/**
+   Получение версии сообщения
+   на входе    :  in_u8Type - тип сообщения
+   на выходе   :  версия сообщения, 0 тип не найден
+   примечание  :  для сообщений приложения используется версия из таблицы обработчиков приложения
+*/
+u8 CIridiumProtocol::GetVersion(u8 in_u8Type)
+{
+   u8 l_u8Result = 0;
+   for(size_t i = 0; i < m_stMessageHandlers; i++)
+   {
+      if(m_pMessageHandlers[i].m_u8Type == in_u8Type && m_pMessageHandlers[i].m_u8Version)
+      {
+         l_u8Result = m_pMessageHandlers[i].m_u8Version;
+         break;
+      }
    }
+   if(!l_u8Result)
+      l_u8Result = GetMessageVersion(in_u8Type);
+   return l_u8Result;
 }
 
 /**
@@ -2405,11 +3992,17 @@ void CIridiumProtocol::ProcessMessageResponse()
 */
 u16 CIridiumProtocol::GetTID()
 {
+   u16 l_u16TID = 0;
+
+   Lock();
    // Увеличение идентиифкатора с отсечением нулевого значения
    m_u16TID++;
    if(!m_u16TID)
       m_u16TID++;
-   return m_u16TID;
+   l_u16TID = m_u16TID;
+   Unlock();
+
+   return l_u16TID;
 }
 
 /**
@@ -2420,12 +4013,14 @@ u16 CIridiumProtocol::GetTID()
 */
 bool CIridiumProtocol::SendRequest(iridium_address_t in_DstAddr, u8 in_u8Type)
 {
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
+
    // Заполнение данных пакета
    InitRequestPacket(in_DstAddr, in_u8Type);
    // Начало работы с пакетом
-   Begin();
+   l_pOut->Begin();
    // Окончание работы и отправка пакета
-   return End();
+   return l_pOut->End();
 }
 
 /**
@@ -2435,25 +4030,380 @@ bool CIridiumProtocol::SendRequest(iridium_address_t in_DstAddr, u8 in_u8Type)
 */
 bool CIridiumProtocol::SendResponse(eIridiumError in_eCode)
 {
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
+
    // Заполнение заголовка пакета
-   m_OutPH.m_Flags.m_bAddress    = true;
-   m_OutPH.m_SrcAddr             = m_Address;
-   m_OutPH.m_DstAddr             = m_pInPH->m_SrcAddr;
+   l_pOut->m_PH.m_Flags.m_bAddress = true;
+   l_pOut->m_PH.m_SrcAddr          = m_Address;
+   l_pOut->m_PH.m_DstAddr          = m_pInPH->m_SrcAddr;
 
    // Заполнение заголовка сообщения
-   m_OutMH.m_Flags.m_bDirection  = IRIDIUM_RESPONSE;
-   m_OutMH.m_Flags.m_bError      = in_eCode ? IRIDIUM_ERROR : IRIDIUM_NO_ERROR;
-   m_OutMH.m_Flags.m_bNoTID      = false;
-   m_OutMH.m_Flags.m_bEnd        = true;
-   m_OutMH.m_Flags.m_u4Version   = m_InMH.m_Flags.m_u4Version;
-   m_OutMH.m_u8Type              = m_InMH.m_u8Type;
-   m_OutMH.m_u16TID              = m_InMH.m_u16TID;
+   l_pOut->m_MH.m_Flags.m_bDirection = IRIDIUM_RESPONSE;
+   l_pOut->m_MH.m_Flags.m_bError     = in_eCode ? IRIDIUM_ERROR : IRIDIUM_NO_ERROR;
+   l_pOut->m_MH.m_Flags.m_bNoTID     = false;
+   l_pOut->m_MH.m_Flags.m_bEnd       = true;
+   l_pOut->m_MH.m_Flags.m_u4Version  = m_InMH.m_Flags.m_u4Version;
+   l_pOut->m_MH.m_u8Type             = m_InMH.m_u8Type;
+   l_pOut->m_MH.m_u16TID             = m_InMH.m_u16TID;
 
    // Начало работы с пакетом
-   Begin();
+   l_pOut->Begin();
    // Если код ошибки определен, добавим кода ошибки
    if(in_eCode)
-      m_pOutMessage->AddU8(in_eCode);
+      l_pOut->m_pBuffer->AddU8(in_eCode);
    // Окончание работы и отправка пакета
-   return End();
+   return l_pOut->End();
+}
+
+#if defined(IRIDIUM_CONFIG_GET_TAGS_SLAVE) || defined(IRIDIUM_CONFIG_GET_CHANNELS_SLAVE)
+
+/**
+   Получение границ запрошенной страницы списка каналов
+   на входе    :  in_stSize      - количество каналов в списке
+                  out_rStart     - ссылка куда нужно поместить индекс первого канала страницы
+                  out_rEnd       - ссылка куда нужно поместить индекс канала после последнего канала страницы
+   на выходе   :  true - запрошена страница, false - запрошен весь список (запрос без параметров)
+*/
+bool CIridiumProtocol::GetListPage(size_t in_stSize, size_t& out_rStart, size_t& out_rEnd)
+{
+   u16 l_u16Start = 0;
+   u16 l_u16Count = 0;
+
+   out_rStart = 0;
+   out_rEnd = in_stSize;
+   // Параметры страницы необязательны, старые ведущие запрашивают весь список
+   bool l_bResult = m_pInMessage->GetU16LE(l_u16Start);
+   if(l_bResult)
+   {
+      m_pInMessage->GetU16LE(l_u16Count);
+      out_rStart = (l_u16Start < in_stSize) ? l_u16Start : in_stSize;
+      if(l_u16Count && in_stSize - out_rStart > l_u16Count)
+         out_rEnd = out_rStart + l_u16Count;
+   }
+   return l_bResult;
+}
+
+#endif   // defined(IRIDIUM_CONFIG_GET_TAGS_SLAVE) || defined(IRIDIUM_CONFIG_GET_CHANNELS_SLAVE)
+
+#if defined(IRIDIUM_CONFIG_BATCH_MASTER) || defined(IRIDIUM_CONFIG_BATCH_SLAVE)
+
+/**
+   Добавление элемента пакетного сообщения
+   на входе    :  in_u8Operation - тип операции (тип сообщения, выполняющего ту же операцию)
+                  in_u32ID       - идентификатор канала
+                  in_u8Status    - результат операции, добавляется в ответ
+                  in_u32PIN      - пароль доступа, добавляется в запрос если не равен 0
+                  in_u8Type      - тип значения
+                  in_pValue      - указатель на значение, NULL - значения нет
+   на выходе   :  успешность
+   примечание  :  если элемент не помещается в пакет, пакет отправляется как промежуточный пакет цепочки
+                  и элемент добавляется в новый пакет. Значение элемента не разделяется между пакетами
+*/
+bool CIridiumProtocol::AddBatchItem(u8 in_u8Operation, u32 in_u32ID, u8 in_u8Status, u32 in_u32PIN, u8 in_u8Type, universal_value_t* in_pValue)
+{
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
+   bool l_bResult = false;
+   bool l_bRepeat = true;
+
+   while(!l_bResult && l_bRepeat)
+   {
+      size_t l_stSize = l_pOut->m_pBuffer->GetMessageSize();
+
+      // Добавление операции и идентификатора канала
+      l_bResult = l_pOut->m_pBuffer->AddU8(in_u8Operation | (in_u32PIN ? IRIDIUM_BATCH_FLAG_PIN : 0)) && l_pOut->m_pBuffer->AddU32LE(in_u32ID);
+      if(l_bResult)
+      {
+         // Добавление результата операции или пароля доступа
+         if(l_pOut->m_MH.m_Flags.m_bDirection == IRIDIUM_RESPONSE)
+            l_bResult = l_pOut->m_pBuffer->AddU8(in_u8Status);
+         else if(in_u32PIN)
+            l_bResult = l_pOut->m_pBuffer->AddU32LE(in_u32PIN);
+      }
+      // Добавление значения целиком
+      if(l_bResult && in_pValue)
+      {
+         size_t l_stRemain = (size_t)-1;
+         l_bResult = l_pOut->m_pBuffer->AddValue(in_u8Type, *in_pValue, l_stRemain, 0) && !l_stRemain;
+      }
+
+      if(!l_bResult)
+      {
+         // Отмена добавления элемента
+         l_pOut->m_pBuffer->SetMessageSize(l_stSize);
+         // Отправка пакета, если в нем есть элементы, и начало нового пакета
+         l_bRepeat = (l_stSize > l_pOut->m_stBatchBegin);
+         if(l_bRepeat)
+         {
+            l_pOut->m_MH.m_Flags.m_bEnd = false;
+            l_bRepeat = l_pOut->End();
+            if(l_bRepeat)
+               l_pOut->Begin();
+         }
+      }
+   }
+   return l_bResult;
+}
+
+#endif   // #if defined(IRIDIUM_CONFIG_BATCH_MASTER) || defined(IRIDIUM_CONFIG_BATCH_SLAVE)
+
+#if defined(IRIDIUM_ENABLE_TRANSACTIONS)
+
+/**
+   Установка параметров транзакции для следующего запроса
+   на входе    :  in_u32Timeout  - время ожидания ответа в единицах времени платформы
+                  in_u8Retries   - количество повторов запроса при отсутствии ответа
+                  in_pCallback   - указатель на обработчик завершения транзакции, NULL - вызывается TransactionResult
+                  in_pContext    - пользовательские данные обработчика
+   на выходе   :  *
+   примечание  :  параметры действуют на один запрос (Send*Request), запрос отслеживается по адресу получателя
+                  и идентификатору транзакции. Время ожидания отсчитывается от значения, переданного в последний
+                  вызов ProcessTransactions. Если таблица транзакций заполнена, запрос не отправляется.
+                  Если окно получателя заполнено, запрос ставится в очередь (см. SetTransactionWindow), а запрос,
+                  который нельзя сохранить (цепочка пакетов или пакет больше IRIDIUM_TRANSACTION_PACKET_SIZE),
+                  не отправляется, и Send*Request возвращает false.
+                  Широковещательный запрос отправляется без регистрации, обработчик завершения не вызывается
+*/
+void CIridiumProtocol::SetTransaction(u32 in_u32Timeout, u8 in_u8Retries, iridium_transaction_callback_t in_pCallback, void* in_pContext)
+{
+   CIridiumPacketBuilder* l_pOut = GetBuilder();
+
+   l_pOut->m_bTransaction = true;
+   l_pOut->m_bTransactionChain = false;
+   l_pOut->m_bTransactionReject = false;
+   l_pOut->m_u32TransactionTimeout = in_u32Timeout;
+   l_pOut->m_u8TransactionRetries = in_u8Retries;
+   l_pOut->m_pTransactionCallback = in_pCallback;
+   l_pOut->m_pTransactionContext = in_pContext;
+}
+
+/**
+   Обработка истечения времени ожидания ответов
+   на входе    :  in_u32Time  - текущее монотонное время платформы (например миллисекунды от запуска)
+   на выходе   :  *
+   примечание  :  запрос, на который не получен ответ, отправляется повторно с тем же идентификатором транзакции.
+                  Когда попытки исчерпаны, транзакция завершается с состоянием IRIDIUM_TRANSACTION_TIMEOUT
+*/
+void CIridiumProtocol::ProcessTransactions(u32 in_u32Time)
+{
+   iridium_transaction_t* l_pTransaction = NULL;
+
+   Lock();
+   // Запомним текущее время
+   m_u32Time = in_u32Time;
+
+   // Обработка запросов с истекшим временем ожидания
+   while((l_pTransaction = m_Transactions.GetExpired(in_u32Time)) != NULL)
+   {
+      // Ответ потерян, уменьшим окно получателя
+      m_Transactions.Learn(l_pTransaction->m_DstAddr, false);
+
+      if(l_pTransaction->m_u8Retries && l_pTransaction->m_u16Size)
+      {
+         // Повторная отправка запроса
+         l_pTransaction->m_u8Retries--;
+         m_Transactions.Send(l_pTransaction, in_u32Time);
+         SendPacket(l_pTransaction->m_aPacket, l_pTransaction->m_u16Size);
+      } else
+         CompleteTransaction(l_pTransaction, IRIDIUM_TRANSACTION_TIMEOUT, IRIDIUM_OK);
+   }
+
+   // Отправка ожидающих запросов
+   SendTransactions();
+   Unlock();
+}
+
+/**
+   Установка окна запросов получателя
+   на входе    :  in_DstAddr  - адрес получателя
+                  in_u8Window - максимальное количество запросов, ожидающих ответа от получателя,
+                                0 - использовать окно по умолчанию (IRIDIUM_TRANSACTION_WINDOW)
+                  in_u16Bytes - максимальный суммарный размер отправленных запросов (размер входящего буфера
+                                получателя), 0 - без ограничения
+   на выходе   :  успешность установки
+   примечание  :  окно получателя без заданных параметров увеличивается с каждым ответом от одного запроса
+                  до IRIDIUM_TRANSACTION_WINDOW, ограничение размера IRIDIUM_TRANSACTION_WINDOW_BYTES.
+                  При потере ответа окно сбрасывается до одного запроса
+*/
+bool CIridiumProtocol::SetTransactionWindow(iridium_address_t in_DstAddr, u8 in_u8Window, u16 in_u16Bytes)
+{
+   Lock();
+   bool l_bResult = m_Transactions.SetWindow(in_DstAddr, in_u8Window, in_u16Bytes);
+   Unlock();
+   return l_bResult;
+}
+
+/**
+   Установка общего ограничения количества запросов, ожидающих ответа
+   на входе    :  in_stLimit  - максимальное количество отправленных запросов для всех получателей
+   на выходе   :  *
+*/
+void CIridiumProtocol::SetTransactionLimit(size_t in_stLimit)
+{
+   Lock();
+   m_Transactions.SetLimit(in_stLimit);
+   Unlock();
+}
+
+/**
+   Отмена транзакций получателя
+   на входе    :  in_DstAddr  - адрес получателя
+   на выходе   :  *
+   примечание  :  для каждой отмененной транзакции вызывается обработчик завершения с состоянием IRIDIUM_TRANSACTION_CANCEL
+*/
+void CIridiumProtocol::CancelTransactions(iridium_address_t in_DstAddr)
+{
+   Lock();
+   iridium_transaction_t* l_pTransaction = m_Transactions.GetNext(NULL);
+   while(l_pTransaction)
+   {
+      iridium_transaction_t* l_pNext = m_Transactions.GetNext(l_pTransaction);
+      if(l_pTransaction->m_DstAddr == in_DstAddr)
+         CompleteTransaction(l_pTransaction, IRIDIUM_TRANSACTION_CANCEL, IRIDIUM_OK);
+      l_pTransaction = l_pNext;
+   }
+
+   // Отправка ожидающих запросов другим получателям
+   SendTransactions();
+   Unlock();
+}
+
+/**
+   Регистрация сформированного запроса в таблице транзакций
+   на входе    :  in_pOut           - указатель на построитель пакета
+                  out_rTransaction  - ссылка на указатель, куда будет помещена зарегистрированная транзакция
+   на выходе   :  false - пакет не должен отправляться: таблица транзакций заполнена или окно получателя
+                  заполнено, а запрос не может быть сохранен в очереди
+   примечание  :  вызывается из EndPacket после формирования пакета. Регистрируется последний пакет цепочки,
+                  пакет сохраняется для повторной отправки, если запрос состоит из одного пакета
+                  и помещается в IRIDIUM_TRANSACTION_PACKET_SIZE. Если окно получателя заполнено, сохраненный
+                  запрос остается в таблице неотправленным, а запрос, который нельзя сохранить, отклоняется.
+                  Окно проверяется по первому пакету запроса: цепочка, начало которой передано, отправляется
+                  до конца, отклоненная цепочка не отправляется целиком. Широковещательный запрос
+                  не регистрируется: ответы на него приходят от разных устройств и не могут быть сопоставлены
+                  с одной транзакцией
+*/
+bool CIridiumProtocol::AddTransaction(CIridiumPacketBuilder* in_pOut, iridium_transaction_t*& out_rTransaction)
+{
+   bool l_bResult = true;
+   out_rTransaction = NULL;
+
+   // Широковещательный запрос отправляется без регистрации
+   if(!in_pOut->m_PH.m_Flags.m_bAddress || !in_pOut->m_PH.m_DstAddr)
+      in_pOut->m_bTransaction = false;
+
+   // Проверка необходимости регистрации
+   if(in_pOut->m_bTransaction && in_pOut->m_MH.m_Flags.m_bDirection == IRIDIUM_REQUEST && !in_pOut->m_MH.m_Flags.m_bNoTID)
+   {
+      // Получение сегментов и размера пакета
+      iridium_iovec_t l_aVec[IRIDIUM_PACKET_MAX_SEGMENTS];
+      size_t l_stCount = in_pOut->m_pBuffer->GetPacketVector(l_aVec, IRIDIUM_PACKET_MAX_SEGMENTS);
+      size_t l_stSize = 0;
+      for(size_t i = 0; i < l_stCount; i++)
+         l_stSize += l_aVec[i].m_stSize;
+
+      // Проверка окна получателя по первому пакету запроса
+      bool l_bFirst = !in_pOut->m_bTransactionChain && !in_pOut->m_bTransactionReject;
+      bool l_bReady = !l_bFirst || m_Transactions.IsReady(in_pOut->m_PH.m_DstAddr, l_stSize);
+      // Запрос можно поставить в очередь, только если он состоит из одного пакета и пакет можно сохранить
+      bool l_bStore = l_bFirst && in_pOut->m_MH.m_Flags.m_bEnd && l_stCount && l_stSize <= IRIDIUM_TRANSACTION_PACKET_SIZE;
+
+      // Окно заполнено, а запрос нельзя сохранить, запрос отклоняется целиком
+      if(!l_bReady && !l_bStore)
+         in_pOut->m_bTransactionReject = true;
+
+      if(in_pOut->m_bTransactionReject)
+      {
+         // Пакет отклоненного запроса не отправляется
+         l_bResult = false;
+      } else if(!in_pOut->m_MH.m_Flags.m_bEnd)
+      {
+         // Промежуточный пакет цепочки, повторить запрос целиком будет невозможно
+         in_pOut->m_bTransactionChain = true;
+      } else
+      {
+         // Добавление транзакции
+         out_rTransaction = m_Transactions.Add(in_pOut->m_PH.m_DstAddr, in_pOut->m_MH.m_u16TID, in_pOut->m_MH.m_u8Type, in_pOut->m_u32TransactionTimeout, in_pOut->m_u8TransactionRetries);
+         if(out_rTransaction)
+         {
+            out_rTransaction->m_pCallback = in_pOut->m_pTransactionCallback;
+            out_rTransaction->m_pContext = in_pOut->m_pTransactionContext;
+            out_rTransaction->m_u16Bytes = (u16)l_stSize;
+
+            // Сохранение пакета для повторной отправки
+            if(l_bStore)
+            {
+               u8* l_pPtr = out_rTransaction->m_aPacket;
+               for(size_t i = 0; i < l_stCount; i++)
+               {
+                  memcpy(l_pPtr, l_aVec[i].m_pPtr, l_aVec[i].m_stSize);
+                  l_pPtr += l_aVec[i].m_stSize;
+               }
+               out_rTransaction->m_u16Size = (u16)l_stSize;
+            }
+
+            // Запрос будет отправлен сразу, иначе сохраненный запрос ожидает в очереди
+            if(l_bReady)
+               m_Transactions.Send(out_rTransaction, m_u32Time);
+         } else
+            l_bResult = false;
+      }
+
+      // Последний пакет запроса, параметры транзакции действуют на один запрос
+      if(in_pOut->m_MH.m_Flags.m_bEnd)
+      {
+         in_pOut->m_bTransaction = false;
+         in_pOut->m_bTransactionChain = false;
+         in_pOut->m_bTransactionReject = false;
+      }
+   }
+   return l_bResult;
+}
+
+/**
+   Отправка ожидающих в очереди запросов
+   на входе    :  *
+   на выходе   :  *
+   примечание  :  запросы отправляются, пока в окнах получателей и в общем ограничении есть место.
+                  Ошибка отправки обрабатывается как потеря ответа (повтор по истечении времени ожидания)
+*/
+void CIridiumProtocol::SendTransactions()
+{
+   iridium_transaction_t* l_pTransaction = NULL;
+   while((l_pTransaction = m_Transactions.GetPending()) != NULL)
+   {
+      m_Transactions.Send(l_pTransaction, m_u32Time);
+      SendPacket(l_pTransaction->m_aPacket, l_pTransaction->m_u16Size);
+   }
+}
+
+/**
+   Завершение транзакции
+   на входе    :  in_pTransaction   - указатель на транзакцию
+                  in_eState         - состояние завершения
+                  in_eError         - код ошибки, полученный в ответе
+   на выходе   :  *
+   примечание  :  транзакция удаляется из таблицы до вызова обработчика, поэтому из обработчика можно
+                  отправлять новые запросы. Обработчик вызывается под захватом Lock, отправка запроса из
+                  обработчика захватывает его повторно, поэтому Lock должен допускать повторный захват
+*/
+void CIridiumProtocol::CompleteTransaction(iridium_transaction_t* in_pTransaction, eIridiumTransactionState in_eState, eIridiumError in_eError)
+{
+   if(in_pTransaction)
+   {
+      // Копия данных транзакции для обработчика
+      iridium_transaction_t l_Transaction = *in_pTransaction;
+      m_Transactions.Remove(in_pTransaction);
+
+      // Получен ответ, увеличим окно получателя. Переполнение получателя уменьшает окно
+      if(in_eState == IRIDIUM_TRANSACTION_DONE || in_eState == IRIDIUM_TRANSACTION_ERROR)
+         m_Transactions.Learn(l_Transaction.m_DstAddr, in_eError != IRIDIUM_SERVER_IS_FULL);
+
+      // Вызов обработчика завершения
+      if(l_Transaction.m_pCallback)
+         l_Transaction.m_pCallback(l_Transaction.m_pContext, l_Transaction, in_eState, in_eError);
+      else
+         TransactionResult(l_Transaction, in_eState, in_eError);
+   }
 }
+
+#endif   // defined(IRIDIUM_ENABLE_TRANSACTIONS)
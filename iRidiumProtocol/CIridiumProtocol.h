@@ -20,6 +20,46 @@
 #include "CIridiumInBuffer.h"
 #include "CIridiumOutBuffer.h"
 #include "CIridiumCipher.h"
+#include "CIridiumPacketBuilder.h"
+
+#if defined(IRIDIUM_ENABLE_TRANSACTIONS)
+#include "CIridiumTransactions.h"
+#endif
+
+#if defined(IRIDIUM_CONFIG_SUBSCRIBE_TAG_SLAVE)
+#include "CIridiumSubscriptions.h"
+#endif
+
+#if defined(IRIDIUM_ENABLE_SEARCH_SLOTS) && defined(IRIDIUM_CONFIG_SYSTEM_SEARCH_MASTER)
+#include "CIridiumSearch.h"
+#endif
+
+#if defined(IRIDIUM_ENABLE_STREAM_WINDOW)
+#include "CIridiumStreamWindow.h"
+
+// Количество потоков, одновременно передаваемых окном (разным получателям)
+#ifndef IRIDIUM_STREAM_MAX_TX
+#define IRIDIUM_STREAM_MAX_TX             1
+#endif
+
+#if defined(IRIDIUM_ENABLE_STREAM_RESUME)
+// Начальное значение CRC16 принятой части потока, по которой ведущий проверяет точку продолжения записи
+#define IRIDIUM_STREAM_RESUME_CRC_INIT    0xFFFF
+#endif
+#endif
+
+#if defined(IRIDIUM_ENABLE_CATALOG_HASH)
+#include "IridiumBus.h"
+
+// Размер буфера для расчета хэша каталога каналов, должен вмещать данные и описание любого канала в том виде,
+// в котором они передаются ведущему. По умолчанию максимальный размер тела шинного пакета. Буфер является членом
+// класса, а не размещается в стеке: стек микроконтроллера может быть меньше буфера (0x400 байт на STM32F103)
+#ifndef IRIDIUM_CATALOG_BUFFER_SIZE
+#define IRIDIUM_CATALOG_BUFFER_SIZE       IRIDIUM_BUS_MAX_BODY_SIZE
+#endif
+#endif
+
+struct iridium_message_entry_s;
 
 class CIridiumProtocol
 {
@@ -47,12 +87,28 @@ public:
 #if defined(IRIDIUM_CONFIG_SYSTEM_SEARCH_MASTER)
    virtual bool SendSearchRequest(iridium_address_t in_DstAddr, u8 in_u8Mask)
       { return false; }
+   // Запрос поиска с распределением ответов по слотам (in_pSlots == NULL - ответ без задержки)
+   virtual bool SendSearchRequest(iridium_address_t in_DstAddr, u8 in_u8Mask, u16 in_u16TID, iridium_search_slots_t* in_pSlots)
+      { return false; }
    void ReceiveSearchResponse();
+#if defined(IRIDIUM_ENABLE_SEARCH_SLOTS)
+   // Поиск раундами с распределением ответов по слотам и сужением по префиксу хэша HWID
+   bool StartSearch(iridium_address_t in_DstAddr, u8 in_u8Mask, u8 in_u8Slots, u16 in_u16SlotTime);
+   void StopSearch();
+   bool IsSearching()
+      { return m_Search.IsActive(); }
+#endif
 #endif
 
 #if defined(IRIDIUM_CONFIG_SYSTEM_SEARCH_SLAVE)
    void ReceiveSearchRequest();
    bool SendSearchResponse(u16 in_u16TID, iridium_search_info_t& in_rInfo);
+   bool SendSearchResponse(iridium_address_t in_DstAddr, u16 in_u16TID, iridium_search_info_t& in_rInfo);
+#endif
+
+#if defined(IRIDIUM_ENABLE_SEARCH_SLOTS) && (defined(IRIDIUM_CONFIG_SYSTEM_SEARCH_MASTER) || defined(IRIDIUM_CONFIG_SYSTEM_SEARCH_SLAVE))
+   // Отправка отложенных ответов и запросов раундов поиска (in_u32Time - монотонное время платформы в миллисекундах)
+   void ProcessSearch(u32 in_u32Time);
 #endif
 
    // IRIDIUM_MESSAGE_SYSTEM_GET_DEVICE_INFO (0x04)
@@ -65,6 +121,14 @@ public:
    void ReceiveDeviceInfoRequest();
 #endif
 
+#if defined(IRIDIUM_ENABLE_CATALOG_HASH)
+   // Хэш каталога каналов (списки и описания каналов обратной связи и управления) для кэширования ведущим
+   u32 GetCatalogHash();
+   // Пересчет хэша каталога после изменения списков или описаний каналов приложением
+   void SetCatalogChanged()
+      { m_bCatalogHash = false; }
+#endif
+
    // IRIDIUM_MESSAGE_SYSTEM_SET_LID (0x05)
 #if defined(IRIDIUM_CONFIG_SYSTEM_SET_LID_MASTER)
    virtual bool SendSetLIDRequest(iridium_address_t in_DstAddr, const char* in_pszHWID, u8 in_u8LID, u32 in_u32PIN)
@@ -114,6 +178,8 @@ public:
    // IRIDIUM_MESSAGE_GET_TAGS (0x20)
 #if defined(IRIDIUM_CONFIG_GET_TAGS_MASTER)
    bool SendGetTagsRequest(iridium_address_t in_DstAddr);
+   // Запрос страницы списка (in_u16Count == 0 - до конца списка)
+   bool SendGetTagsRequest(iridium_address_t in_DstAddr, u16 in_u16Start, u16 in_u16Count);
    void ReceiveGetTagsResponse();
 #endif
 
@@ -162,11 +228,32 @@ public:
    bool SendGetTagValueResponse(u32 in_u32TagID, iridium_tag_info_t& in_rInfo);
 #endif
 
+   // IRIDIUM_MESSAGE_SUBSCRIBE_TAG (0x28), IRIDIUM_MESSAGE_TAG_NOTIFY (0x29)
+#if defined(IRIDIUM_CONFIG_SUBSCRIBE_TAG_MASTER)
+   bool SendSubscribeTagRequest(iridium_address_t in_DstAddr, u32 in_u32TagID, u8 in_u8Flags, u32 in_u32MinInterval, u32 in_u32MaxInterval, f32 in_f32Deadband);
+   void ReceiveSubscribeTagResponse();
+   void ReceiveTagNotifyRequest();
+#endif
+
+#if defined(IRIDIUM_CONFIG_SUBSCRIBE_TAG_SLAVE)
+   void ReceiveSubscribeTagRequest();
+   bool SendTagNotifyRequest(iridium_address_t in_DstAddr, u32 in_u32TagID, iridium_tag_info_t& in_rInfo);
+   // Отметка изменения значения канала обратной связи, значение будет отправлено подписчикам
+   bool SetTagChanged(u32 in_u32TagID);
+   // Отправка изменений подписчикам (in_u32Time - монотонное время платформы в миллисекундах)
+   void ProcessSubscriptions(u32 in_u32Time);
+   // Получение количества подписок
+   size_t GetSubscriptions()
+      { return m_Subscriptions.GetCount(); }
+#endif
+
    ////////////////////////////////////////////////////////////////////////////
    // Работа с каналами управления
    // IRIDIUM_MESSAGE_GET_CHANNELS (0x30)
 #if defined(IRIDIUM_CONFIG_GET_CHANNELS_MASTER)
    bool SendGetChannelsRequest(iridium_address_t in_DstAddr);
+   // Запрос страницы списка (in_u16Count == 0 - до конца списка)
+   bool SendGetChannelsRequest(iridium_address_t in_DstAddr, u16 in_u16Start, u16 in_u16Count);
    void ReceiveGetChannelsResponse();
 #endif
 
@@ -215,17 +302,47 @@ public:
    bool SendGetChannelValueResponse(u32 in_u32ChannelID, iridium_channel_info_t& in_rInfo);
 #endif
 
+   // IRIDIUM_MESSAGE_BATCH (0x37)
+#if defined(IRIDIUM_CONFIG_BATCH_MASTER)
+   bool BeginBatchRequest(iridium_address_t in_DstAddr);
+   bool AddBatchSetTagValue(u32 in_u32TagID, u8 in_u8Type, universal_value_t& in_rValue);
+   bool AddBatchSetChannelValue(u32 in_u32ChannelID, u8 in_u8Type, universal_value_t& in_rValue, u32 in_u32PIN);
+   bool AddBatchGetChannelValue(u32 in_u32ChannelID, u32 in_u32PIN);
+   bool SendBatchRequest();
+   void ReceiveBatchResponse();
+#endif
+
+#if defined(IRIDIUM_CONFIG_BATCH_SLAVE)
+   void ReceiveBatchRequest();
+#endif
+
    ////////////////////////////////////////////////////////////////////////////
    // Работа с каналами управления
    // IRIDIUM_MESSAGE_STREAM_OPEN (0x50)
 #if defined(IRIDIUM_CONFIG_STREAM_OPEN_MASTER)
    bool SendStreamOpenRequest(iridium_address_t in_DstAddr, const char* in_pszName, eIridiumStreamMode in_eMode, u32 in_u32PIN);
+#if defined(IRIDIUM_ENABLE_STREAM_WINDOW) && defined(IRIDIUM_CONFIG_STREAM_BLOCK_MASTER)
+   // Запрос открытия потока для записи блоками окном (in_u8Window - желаемое количество блоков в пути)
+   bool SendStreamOpenRequest(iridium_address_t in_DstAddr, const char* in_pszName, eIridiumStreamMode in_eMode, u32 in_u32PIN, u8 in_u8Window);
+#if defined(IRIDIUM_ENABLE_STREAM_RESUME)
+   // Запрос открытия потока с запросом точки продолжения прерванной записи (in_bResume)
+   bool SendStreamOpenRequest(iridium_address_t in_DstAddr, const char* in_pszName, eIridiumStreamMode in_eMode, u32 in_u32PIN, u8 in_u8Window, bool in_bResume);
+#endif
+#endif
    void ReceiveStreamOpenResponse();
 #endif
 
 #if defined(IRIDIUM_CONFIG_STREAM_OPEN_SLAVE)
    void ReceiveStreamOpenRequest();
    bool SendStreamOpenResponse(const char* in_pszName, eIridiumStreamMode in_eMode, u8 in_u8StreamID);
+#if defined(IRIDIUM_ENABLE_STREAM_WINDOW)
+   // Ответ с согласованным размером окна (in_u8Window == 0 - окно не запрашивалось)
+   bool SendStreamOpenResponse(const char* in_pszName, eIridiumStreamMode in_eMode, u8 in_u8StreamID, u8 in_u8Window);
+#if defined(IRIDIUM_ENABLE_STREAM_RESUME)
+   // Ответ с точкой продолжения записи (смещение в потоке и CRC16 принятых до него данных)
+   bool SendStreamOpenResponse(const char* in_pszName, eIridiumStreamMode in_eMode, u8 in_u8StreamID, u8 in_u8Window, u32 in_u32Offset, u16 in_u16CRC);
+#endif
+#endif
 #endif
 
    // IRIDIUM_MESSAGE_STREAM_BLOCK (0x51)
@@ -237,6 +354,10 @@ public:
 #if defined(IRIDIUM_CONFIG_STREAM_BLOCK_SLAVE)
    void ReceiveStreamBlockRequest();
    bool SendStreamBlockResponse(u8 in_u8StreamID, u8 in_u8BlockID, u16 in_u16Size);
+#if defined(IRIDIUM_ENABLE_STREAM_WINDOW)
+   // Подтверждение окна: in_u8BlockID - последний блок принятый по порядку, in_u16Mask - блоки принятые после него
+   bool SendStreamBlockResponse(u8 in_u8StreamID, u8 in_u8BlockID, u16 in_u16Size, u16 in_u16Mask);
+#endif
 #endif
 
    // IRIDIUM_MESSAGE_STREAM_CLOSE (0x52)
@@ -250,6 +371,25 @@ public:
    bool SendStreamCloseResponse(u8 in_u8StreamID);
 #endif
 
+#if defined(IRIDIUM_ENABLE_STREAM_WINDOW) && defined(IRIDIUM_CONFIG_STREAM_BLOCK_SLAVE)
+   // Буфер блоков полученных вне очереди, определяет максимальное окно приема
+   void SetStreamBuffer(void* in_pBuffer, size_t in_stSize, u16 in_u16SlotSize)
+      { m_StreamRx.SetBuffer(in_pBuffer, in_stSize, in_u16SlotSize); }
+   // Открытие окна приема блоков потока (возвращает согласованный размер окна)
+   u8 OpenStreamWindow(iridium_address_t in_SrcAddr, u8 in_u8StreamID, u8 in_u8Window);
+#endif
+
+#if defined(IRIDIUM_ENABLE_STREAM_WINDOW) && defined(IRIDIUM_CONFIG_STREAM_BLOCK_MASTER)
+   // Отправка блоков потоков открытых окном и повторы потерянных блоков (in_u32Time - монотонное время платформы в миллисекундах)
+   void ProcessStream(u32 in_u32Time);
+   // Закрытие окон передачи получателю, в том числе ожидающих ответа на запрос открытия
+   void CloseStreamWindow(iridium_address_t in_DstAddr);
+   // Размер окна передачи блоков потока (0 - поток передается по одному блоку)
+   u8 GetStreamWindow(iridium_address_t in_DstAddr, u8 in_u8StreamID);
+   // Количество блоков потока подтвержденных по порядку
+   u32 GetStreamProgress(iridium_address_t in_DstAddr, u8 in_u8StreamID);
+#endif
+
    // Установка адресации
    void SetAddress(iridium_address_t in_Address)
       { m_Address = in_Address; }
@@ -262,9 +402,9 @@ public:
    virtual void InitResponsePacket()
       {}
 
-   // Начало/окончанияе формирования исходящего пакета
-   void Begin();
-   bool End();
+   // Начало/окончание формирования исходящего пакета построителем (вызываются из CIridiumPacketBuilder)
+   void BeginPacket(CIridiumPacketBuilder* in_pOut);
+   bool EndPacket(CIridiumPacketBuilder* in_pOut);
 
    // Получение заголовка сообщения
    iridium_message_header_t* GetMessageHeader()
@@ -276,9 +416,27 @@ public:
    size_t GetMessageSize()
       { return m_pInMessage->Size(); }
 
+   // Регистрация обработчиков сообщений приложения, таблица проверяется до встроенной
+   void SetMessageHandlers(const struct iridium_message_entry_s* in_pHandlers, size_t in_stCount);
+
    // Переотправка сообщения с модификацией заголовка
    bool Resend(iridium_packet_header_t* in_pPH, const void* in_pPtr, size_t in_stSize);
 
+#if defined(IRIDIUM_ENABLE_TRANSACTIONS)
+   // Транзакции: следующий запрос будет ожидать ответа с повторами и вызовом обработчика завершения
+   void SetTransaction(u32 in_u32Timeout, u8 in_u8Retries, iridium_transaction_callback_t in_pCallback, void* in_pContext);
+   // Обработка истечения времени ожидания ответов (in_u32Time - монотонное время платформы)
+   void ProcessTransactions(u32 in_u32Time);
+   // Отмена транзакций получателя
+   void CancelTransactions(iridium_address_t in_DstAddr);
+   // Получение количества зарегистрированных запросов (отправленных и ожидающих в очереди)
+   size_t GetTransactions()
+      { return m_Transactions.GetCount(); }
+   // Окно запросов получателя и общее ограничение количества отправленных запросов
+   bool SetTransactionWindow(iridium_address_t in_DstAddr, u8 in_u8Window, u16 in_u16Bytes);
+   void SetTransactionLimit(size_t in_stLimit);
+#endif   // defined(IRIDIUM_ENABLE_TRANSACTIONS)
+
    //////////////////////////////////////////////////////////////////////////
    // Перегруженные методы, методы предназначены для реализации
    // особенностей протоколов типа TCP/UDP/CAN и так далее
@@ -309,6 +467,18 @@ public:
    // Отправка данных
    virtual bool SendPacket(void* in_pBuffer, size_t in_stSize)
       { return false; }
+   // Отправка данных, состоящих из нескольких сегментов
+   virtual bool SendPacketV(const iridium_iovec_t* in_pVec, size_t in_stCount);
+
+   // Получение построителя пакетов текущего контекста выполнения (по умолчанию общий построитель m_Builder),
+   // для одновременной отправки из нескольких потоков каждому потоку нужен свой построитель
+   virtual CIridiumPacketBuilder* GetBuilder()
+      { return &m_Builder; }
+   // Захват/освобождение общих данных протокола при передаче пакета (должны допускать повторный захват)
+   virtual void Lock()
+      {}
+   virtual void Unlock()
+      {}
 
    // Настройка
    virtual bool SetLID(char* in_pszHWID, u8 in_u8LID)
@@ -324,6 +494,12 @@ public:
    virtual void ReceivedError(eIridiumError in_eError, iridium_packet_header_t* in_pPH, iridium_message_header_t* in_pMH)
       {}
 
+#if defined(IRIDIUM_ENABLE_TRANSACTIONS)
+   // Обработчик завершения транзакции, вызывается если при создании транзакции не был указан обработчик
+   virtual void TransactionResult(iridium_transaction_t& in_rTransaction, eIridiumTransactionState in_eState, eIridiumError in_eError)
+      {}
+#endif
+
    // Получение информации о клиенте, который подключен к нам
    virtual iridium_device_info_t* GetClientInfo()
       { return NULL; }
@@ -405,6 +581,12 @@ public:
    virtual bool SetChannelValue(u32 in_u32ChannelID, u8 in_u8Type, universal_value_t& in_rValue, u8 in_u8Flags)
       { return false; }
 
+   // Результат операции пакетного сообщения
+#if defined(IRIDIUM_CONFIG_BATCH_MASTER)
+   virtual void BatchResult(u8 in_u8Operation, u32 in_u32ID, eIridiumError in_eError)
+      { }
+#endif
+
    // Работа с потоками
    virtual u8 StreamOpen(const char* in_pszName, eIridiumStreamMode in_eMode)
       { return 0; }
@@ -416,10 +598,30 @@ public:
       { }
    virtual void StreamClose(u8 in_u8StreamID)
       { }
+#if defined(IRIDIUM_ENABLE_STREAM_RESUME)
+   // Получение точки продолжения прерванной записи открытого потока: смещение в потоке, с которого нужно
+   // передавать данные, и CRC16 данных до него (false - точки нет, поток передается с начала)
+   virtual bool StreamResume(u8 in_u8StreamID, u32& out_rOffset, u16& out_rCRC)
+      { return false; }
+   // Получение точки продолжения записи от устройства (вызывается перед StreamOpenResult)
+   virtual void StreamResumeResult(iridium_address_t in_SrcAddr, u8 in_u8StreamID, u32 in_u32Offset, u16 in_u16CRC)
+      { }
+#endif
+#if defined(IRIDIUM_ENABLE_STREAM_WINDOW) && defined(IRIDIUM_CONFIG_STREAM_BLOCK_MASTER)
+   // Получение блока потока для отправки окном по порядковому номеру (false - данные потока закончились),
+   // блок может быть запрошен повторно, пока не подтвержден
+   virtual bool StreamGetBlock(iridium_address_t in_DstAddr, u8 in_u8StreamID, u32 in_u32Index, const void*& out_rBlock, u16& out_rSize)
+      { return false; }
+   // Окончание передачи потока окном (in_bSuccess - все блоки подтверждены, иначе передача прервана)
+   virtual void StreamComplete(iridium_address_t in_DstAddr, u8 in_u8StreamID, bool in_bSuccess)
+      { }
+#endif
 
 protected:
    // Вспомогательные функции
    u16 GetTID();
+   u8 GetVersion(u8 in_u8Type);
+   const struct iridium_message_entry_s* GetMessageHandler(u8 in_u8Type, bool in_bDirection);
    bool SendRequest(iridium_address_t in_DstAddr, u8 in_u8Type);
    bool SendResponse(eIridiumError in_eCode);
 
@@ -427,6 +629,12 @@ protected:
       { }
    virtual void EndChannels()
       { }
+   // Получен пакет страницы списка: in_u16Next - индекс следующего канала (0 - список окончен),
+   // in_bEnd - последний пакет страницы
+   virtual void TagsPage(u16 in_u16Next, bool in_bEnd)
+      { }
+   virtual void ChannelsPage(u16 in_u16Next, bool in_bEnd)
+      { }
    // Получение адреса источника
    iridium_address_t GetSrcAddress()
       { return m_pInPH->m_SrcAddr; }
@@ -434,6 +642,38 @@ protected:
    iridium_address_t GetDstAddress()
       { return m_pInPH->m_DstAddr; }
 
+#if defined(IRIDIUM_CONFIG_BATCH_MASTER) || defined(IRIDIUM_CONFIG_BATCH_SLAVE)
+   // Добавление элемента пакетного сообщения
+   bool AddBatchItem(u8 in_u8Operation, u32 in_u32ID, u8 in_u8Status, u32 in_u32PIN, u8 in_u8Type, universal_value_t* in_pValue);
+#endif
+
+#if defined(IRIDIUM_CONFIG_GET_TAGS_SLAVE) || defined(IRIDIUM_CONFIG_GET_CHANNELS_SLAVE)
+   // Получение границ запрошенной страницы списка каналов
+   bool GetListPage(size_t in_stSize, size_t& out_rStart, size_t& out_rEnd);
+#endif
+
+#if defined(IRIDIUM_ENABLE_STREAM_WINDOW) && defined(IRIDIUM_CONFIG_STREAM_BLOCK_SLAVE)
+   // Прием блока потока открытого окном и отправка подтверждения
+   void ReceiveStreamWindowBlock(u8 in_u8BlockID, u16 in_u16Size, const void* in_pData);
+#endif
+
+#if defined(IRIDIUM_ENABLE_STREAM_WINDOW) && defined(IRIDIUM_CONFIG_STREAM_BLOCK_MASTER)
+   // Поиск окна передачи потока
+   CIridiumStreamWindow* FindStreamWindow(iridium_address_t in_Addr, u8 in_u8StreamID, bool in_bFree);
+#endif
+
+#if defined(IRIDIUM_ENABLE_SEARCH_SLOTS) && defined(IRIDIUM_CONFIG_SYSTEM_SEARCH_SLAVE)
+   // Получение задержки ответа на запрос поиска по параметрам слотов из запроса
+   bool GetSearchDelay(iridium_search_info_t& in_rInfo, u32& out_rDelay);
+#endif
+
+#if defined(IRIDIUM_ENABLE_TRANSACTIONS)
+   // Работа с транзакциями
+   bool AddTransaction(CIridiumPacketBuilder* in_pOut, iridium_transaction_t*& out_rTransaction);
+   void CompleteTransaction(iridium_transaction_t* in_pTransaction, eIridiumTransactionState in_eState, eIridiumError in_eError);
+   void SendTransactions();
+#endif
+
 protected:
    bool                       m_bEnableLongString; // Флаг блокирующий длинные строки
    u16                        m_u16TID;            // Текущий идентификатор транзакции
@@ -444,9 +684,55 @@ protected:
    iridium_message_header_t   m_InMH;              // Заголовок входящего сообщения
    CIridiumInBuffer*          m_pInMessage;        // Указатель на входящий буфер сообщения
    // Данные для формирования исходящих сообщения
-   iridium_packet_header_t    m_OutPH;             // Данные заголовка исходящего пакета
-   iridium_message_header_t   m_OutMH;             // Заголовок исходящего сообщения
-   CIridiumOutBuffer*         m_pOutMessage;       // Указатель на исходящий буфер сообщения
+   iridium_packet_header_t    m_OutPH;             // Шаблон заголовка исходящего пакета (тип протокола, приоритет, версия, шифрование)
+   CIridiumPacketBuilder      m_Builder;           // Построитель пакетов по умолчанию
+   // Обработчики сообщений приложения
+   const struct iridium_message_entry_s* m_pMessageHandlers; // Указатель на таблицу обработчиков
+   size_t                     m_stMessageHandlers; // Количество обработчиков в таблице
+
+#if defined(IRIDIUM_ENABLE_TRANSACTIONS)
+   // Транзакции
+   CIridiumTransactions       m_Transactions;      // Таблица запросов ожидающих ответа
+   u32                        m_u32Time;           // Текущее время, последнее значение переданное в ProcessTransactions
+#endif   // defined(IRIDIUM_ENABLE_TRANSACTIONS)
+
+#if defined(IRIDIUM_CONFIG_SUBSCRIBE_TAG_SLAVE)
+   CIridiumSubscriptions      m_Subscriptions;     // Таблица подписок на изменение каналов обратной связи
+#endif
+
+#if defined(IRIDIUM_ENABLE_SEARCH_SLOTS)
+#if defined(IRIDIUM_CONFIG_SYSTEM_SEARCH_MASTER)
+   CIridiumSearch             m_Search;            // Поиск устройств раундами
+#endif
+#if defined(IRIDIUM_CONFIG_SYSTEM_SEARCH_SLAVE)
+   // Отложенный ответ на запрос поиска
+   bool                       m_bSearchResponse;   // Признак ожидания отправки ответа
+   bool                       m_bSearchStart;      // Признак начала отсчета задержки
+   iridium_address_t          m_SearchAddr;        // Адрес получателя ответа
+   u16                        m_u16SearchTID;      // Идентификатор транзакции запроса
+   u32                        m_u32SearchDelay;    // Задержка ответа в миллисекундах (слот устройства)
+   u32                        m_u32SearchTime;     // Время начала отсчета задержки
+#endif
+#endif   // defined(IRIDIUM_ENABLE_SEARCH_SLOTS)
+
+#if defined(IRIDIUM_ENABLE_CATALOG_HASH)
+   bool                       m_bCatalogHash;      // Признак актуальности хэша каталога каналов
+   u32                        m_u32CatalogHash;    // Хэш каталога каналов
+   u8                         m_aCatalogBuffer[IRIDIUM_CATALOG_BUFFER_SIZE]; // Буфер данных одного канала для расчета хэша
+#endif
+
+#if defined(IRIDIUM_ENABLE_STREAM_WINDOW)
+#if defined(IRIDIUM_CONFIG_STREAM_OPEN_SLAVE)
+   u8                         m_u8StreamWindow;    // Размер окна из последнего запроса открытия потока (0 - не запрашивалось)
+#endif
+#if defined(IRIDIUM_CONFIG_STREAM_BLOCK_SLAVE)
+   CIridiumStreamWindow       m_StreamRx;          // Окно приема блоков потока
+#endif
+#if defined(IRIDIUM_CONFIG_STREAM_BLOCK_MASTER)
+   CIridiumStreamWindow       m_aStreamTx[IRIDIUM_STREAM_MAX_TX]; // Окна передачи блоков потоков
+   size_t                     m_stStreamTx;        // Окно обслуживаемое первым при следующей отправке
+#endif
+#endif   // defined(IRIDIUM_ENABLE_STREAM_WINDOW)
 
 #if defined(IRIDIUM_ENABLE_CIPHER)
    // Шифрование тела сообщения
@@ -454,4 +740,16 @@ protected:
    u8                   m_u8Count;                 // "Случайное" значение
 #endif   // defined(IRIDIUM_ENABLE_CIPHER)
 };
+
+// Обработчик входящего сообщения
+typedef void (CIridiumProtocol::*iridium_message_handler_t)();
+
+// Структура описания обработчика сообщения
+typedef struct iridium_message_entry_s
+{
+   u8                               m_u8Type;      // Тип сообщения
+   bool                             m_bDirection;  // Направление сообщения (IRIDIUM_REQUEST/IRIDIUM_RESPONSE)
+   u8                               m_u8Version;   // Версия сообщения (0 - версия из таблицы версий сообщений)
+   iridium_message_handler_t        m_pHandler;    // Обработчик сообщения
+} iridium_message_entry_t;
 #endif   // _C_IRIDIUM_PROTOCOL_H_INCLUDED_
@@ -0,0 +1,199 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+#include "CIridiumSearch.h"
+
+/**
+   Конструктор класса
+   на входе    :  *
+*/
+CIridiumSearch::CIridiumSearch()
+{
+   memset(&m_Round, 0, sizeof(m_Round));
+   m_DstAddr = 0;
+   m_u8Mask = 0;
+   m_u16TID = 0;
+   m_u32Time = 0;
+   m_u32Duration = 0;
+   Stop();
+}
+
+/**
+   Деструктор класса
+*/
+CIridiumSearch::~CIridiumSearch()
+{
+}
+
+/**
+   Запуск поиска
+   на входе    :  in_DstAddr     - адрес сегмента
+                  in_u8Mask      - маска групп устройств
+                  in_u8Slots     - количество слотов ответа
+                  in_u16SlotTime - ширина слота в миллисекундах
+   на выходе   :  успешность запуска
+   примечание  :  первый раунд опрашивает все устройства (пустой префикс), запрос отправляется при
+                  следующей проверке IsDue
+*/
+bool CIridiumSearch::Start(iridium_address_t in_DstAddr, u8 in_u8Mask, u8 in_u8Slots, u16 in_u16SlotTime)
+{
+   bool l_bResult = false;
+
+   if(in_u8Mask && in_u8Slots > 1 && in_u16SlotTime)
+   {
+      Stop();
+      m_DstAddr = in_DstAddr;
+      m_u8Mask = in_u8Mask;
+      m_Round.m_u8Slots = in_u8Slots;
+      m_Round.m_u16SlotTime = in_u16SlotTime;
+      m_bActive = Push(0, 0);
+      l_bResult = m_bActive;
+   }
+   return l_bResult;
+}
+
+/**
+   Остановка поиска
+   на входе    :  *
+   на выходе   :  *
+*/
+void CIridiumSearch::Stop()
+{
+   m_stStack = 0;
+   m_u16Round = 0;
+   m_u32Responses = 0;
+   m_bRound = false;
+   m_bActive = false;
+}
+
+/**
+   Добавление префикса в стек
+   на входе    :  in_u8Bits      - количество бит префикса
+                  in_u16Prefix   - префикс хэша HWID
+   на выходе   :  успешность добавления
+*/
+bool CIridiumSearch::Push(u8 in_u8Bits, u16 in_u16Prefix)
+{
+   bool l_bResult = false;
+
+   if(m_stStack < sizeof(m_aStack) / sizeof(m_aStack[0]))
+   {
+      iridium_search_slots_t& l_rSlots = m_aStack[m_stStack++];
+      l_rSlots.m_u8Slots = m_Round.m_u8Slots;
+      l_rSlots.m_u16SlotTime = m_Round.m_u16SlotTime;
+      l_rSlots.m_u8Bits = in_u8Bits;
+      l_rSlots.m_u16Prefix = in_u16Prefix;
+      l_bResult = true;
+   }
+   return l_bResult;
+}
+
+/**
+   Проверка необходимости отправки следующего запроса
+   на входе    :  in_u32Time  - монотонное время платформы в миллисекундах
+   на выходе   :  true - нужно начать следующий раунд
+   примечание  :  по окончании раунда с перегрузкой слотов в стек добавляются обе половины префикса,
+                  более длинный префикс проверяется раньше (обход в глубину)
+*/
+bool CIridiumSearch::IsDue(u32 in_u32Time)
+{
+   bool l_bResult = false;
+
+   if(m_bActive)
+   {
+      if(!m_bRound)
+         l_bResult = true;
+      else if((u32)(in_u32Time - m_u32Time) >= m_u32Duration)
+      {
+         // Раунд окончен, при перегрузке префикс делится на два
+         if((u32)m_u16Round * 100 > (u32)m_Round.m_u8Slots * IRIDIUM_SEARCH_MAX_LOAD && m_Round.m_u8Bits < IRIDIUM_SEARCH_MAX_BITS)
+         {
+            Push(m_Round.m_u8Bits + 1, m_Round.m_u16Prefix | (1 << m_Round.m_u8Bits));
+            Push(m_Round.m_u8Bits + 1, m_Round.m_u16Prefix);
+         }
+         m_bRound = false;
+         l_bResult = true;
+      }
+   }
+   return l_bResult;
+}
+
+/**
+   Начало следующего раунда
+   на входе    :  in_u16TID   - идентификатор транзакции запроса
+                  in_u32Time  - монотонное время платформы в миллисекундах
+                  out_rSlots  - ссылка куда нужно поместить параметры запроса
+   на выходе   :  true - раунд начат, false - префиксов больше нет и поиск окончен
+*/
+bool CIridiumSearch::Next(u16 in_u16TID, u32 in_u32Time, iridium_search_slots_t& out_rSlots)
+{
+   bool l_bResult = false;
+
+   if(m_bActive && !m_bRound)
+   {
+      if(m_stStack)
+      {
+         m_Round = m_aStack[--m_stStack];
+         m_u16TID = in_u16TID;
+         m_u32Time = in_u32Time;
+         m_u32Duration = (u32)m_Round.m_u8Slots * m_Round.m_u16SlotTime + IRIDIUM_SEARCH_GUARD_TIME;
+         m_u16Round = 0;
+         m_bRound = true;
+         out_rSlots = m_Round;
+         l_bResult = true;
+      } else
+         m_bActive = false;
+   }
+   return l_bResult;
+}
+
+/**
+   Повтор раунда, запрос которого не удалось отправить
+   на входе    :  *
+   на выходе   :  *
+*/
+void CIridiumSearch::Repeat()
+{
+   if(m_bRound)
+   {
+      m_bRound = false;
+      Push(m_Round.m_u8Bits, m_Round.m_u16Prefix);
+   }
+}
+
+/**
+   Учет полученного ответа
+   на входе    :  in_u16TID   - идентификатор транзакции ответа
+                  in_u16Hash  - хэш HWID ответившего устройства
+   на выходе   :  true - ответ относится к текущему раунду
+   примечание  :  ответы устройств вне префикса (например без поддержки слотов) не учитываются в загрузке
+                  раунда, иначе такие устройства вызывали бы деление префикса до максимальной длины
+*/
+bool CIridiumSearch::Received(u16 in_u16TID, u16 in_u16Hash)
+{
+   bool l_bResult = false;
+
+   if(m_bRound && in_u16TID == m_u16TID)
+   {
+      u16 l_u16Mask = (u16)((1UL << m_Round.m_u8Bits) - 1);
+      if((in_u16Hash & l_u16Mask) == (m_Round.m_u16Prefix & l_u16Mask))
+      {
+         m_u16Round++;
+         m_u32Responses++;
+         l_bResult = true;
+      }
+   }
+   return l_bResult;
+}
@@ -0,0 +1,92 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+#ifndef _C_IRIDIUM_SEARCH_H_INCLUDED_
+#define _C_IRIDIUM_SEARCH_H_INCLUDED_
+
+// Включения
+#include "Iridium.h"
+
+// Максимальное количество бит префикса хэша HWID
+#define IRIDIUM_SEARCH_MAX_BITS           16
+
+// Время ожидания ответов после последнего слота в миллисекундах
+#ifndef IRIDIUM_SEARCH_GUARD_TIME
+#define IRIDIUM_SEARCH_GUARD_TIME         50
+#endif
+
+// Загрузка слотов в процентах, при превышении которой префикс делится на два
+#ifndef IRIDIUM_SEARCH_MAX_LOAD
+#define IRIDIUM_SEARCH_MAX_LOAD           50
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+// class CIridiumSearch
+//////////////////////////////////////////////////////////////////////////
+// Поиск устройств ведущим с последовательным сужением. Поиск выполняется раундами, в каждом раунде
+// отвечают устройства, у которых младшие биты хэша HWID совпадают с префиксом раунда, ответы распределены
+// по слотам. Если ответов в раунде больше IRIDIUM_SEARCH_MAX_LOAD процентов слотов, префикс удлиняется
+// на один бит и раунд повторяется для двух половин, поэтому в каждом раунде отвечает не больше половины
+// слотов, а количество раундов растет линейно с количеством устройств. Префиксы ожидающие опроса хранятся
+// в стеке (обход в глубину), его размер ограничен длиной префикса
+class CIridiumSearch
+{
+public:
+   // Конструктор/деструктор
+   CIridiumSearch();
+   ~CIridiumSearch();
+
+   // Запуск/остановка поиска
+   bool Start(iridium_address_t in_DstAddr, u8 in_u8Mask, u8 in_u8Slots, u16 in_u16SlotTime);
+   void Stop();
+
+   // Проверка необходимости отправки следующего запроса (текущий раунд окончен или не начат)
+   bool IsDue(u32 in_u32Time);
+   // Начало следующего раунда (false - поиск окончен)
+   bool Next(u16 in_u16TID, u32 in_u32Time, iridium_search_slots_t& out_rSlots);
+   // Повтор раунда, запрос которого не удалось отправить
+   void Repeat();
+   // Учет полученного ответа
+   bool Received(u16 in_u16TID, u16 in_u16Hash);
+
+   // Получение состояния поиска
+   bool IsActive() const
+      { return m_bActive; }
+   iridium_address_t GetAddress() const
+      { return m_DstAddr; }
+   u8 GetMask() const
+      { return m_u8Mask; }
+   // Получение общего количества ответов
+   u32 GetResponses() const
+      { return m_u32Responses; }
+
+protected:
+   bool Push(u8 in_u8Bits, u16 in_u16Prefix);
+
+private:
+   iridium_search_slots_t  m_aStack[IRIDIUM_SEARCH_MAX_BITS + 1]; // Префиксы ожидающие опроса
+   size_t                  m_stStack;              // Количество префиксов в стеке
+   iridium_search_slots_t  m_Round;                // Параметры текущего раунда
+   iridium_address_t       m_DstAddr;              // Адрес сегмента
+   u8                      m_u8Mask;               // Маска групп устройств
+   u16                     m_u16TID;               // Идентификатор транзакции запроса текущего раунда
+   u32                     m_u32Time;              // Время начала текущего раунда
+   u32                     m_u32Duration;          // Длительность текущего раунда
+   u16                     m_u16Round;             // Количество ответов в текущем раунде
+   u32                     m_u32Responses;         // Общее количество ответов
+   bool                    m_bRound;               // Признак выполнения раунда
+   bool                    m_bActive;              // Признак выполнения поиска
+};
+#endif   // _C_IRIDIUM_SEARCH_H_INCLUDED_
@@ -0,0 +1,338 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+#include "CIridiumStreamWindow.h"
+
+/**
+   Конструктор класса
+   на входе    :  *
+*/
+CIridiumStreamWindow::CIridiumStreamWindow()
+{
+   m_pBuffer = NULL;
+   m_u16SlotSize = 0;
+   m_u8Slots = 0;
+   Close();
+}
+
+/**
+   Деструктор класса
+*/
+CIridiumStreamWindow::~CIridiumStreamWindow()
+{
+}
+
+/**
+   Открытие окна
+   на входе    :  in_Addr        - адрес второй стороны
+                  in_u8StreamID  - идентификатор потока
+                  in_u8Window    - размер окна
+   на выходе   :  *
+   примечание  :  нумерация блоков начинается с 0, окно с нулевым идентификатором потока ожидает
+                  ответа на запрос открытия и блоки не передает
+*/
+void CIridiumStreamWindow::Open(iridium_address_t in_Addr, u8 in_u8StreamID, u8 in_u8Window)
+{
+   Close();
+   if(in_u8Window > IRIDIUM_STREAM_MAX_WINDOW)
+      in_u8Window = IRIDIUM_STREAM_MAX_WINDOW;
+   m_Addr = in_Addr;
+   m_u8StreamID = in_u8StreamID;
+   m_u8Window = in_u8Window;
+}
+
+/**
+   Закрытие окна
+   на входе    :  *
+   на выходе   :  *
+*/
+void CIridiumStreamWindow::Close()
+{
+   m_Addr = 0;
+   m_u8StreamID = 0;
+   m_u8Window = 0;
+   m_u32Expected = 0;
+   m_u16Received = 0;
+   m_u16Result = 0;
+   m_u32Base = 0;
+   m_u32Next = 0;
+   m_u32End = 0xFFFFFFFF;
+   m_u16Acked = 0;
+   m_u16Lost = 0;
+   m_u16Resent = 0;
+   m_bFailed = false;
+   m_u32Opened = 0;
+   m_bOpenTime = false;
+}
+
+/**
+   Проверка ожидания ответа на запрос открытия
+   на входе    :  in_u32Time  - текущее время в миллисекундах
+   на выходе   :  true - окно ожидает ответа дольше IRIDIUM_STREAM_OPEN_TIMEOUT
+   примечание  :  время отправки запроса неизвестно, поэтому отсчет начинается с первой проверки
+*/
+bool CIridiumStreamWindow::IsOpenExpired(u32 in_u32Time)
+{
+   bool l_bResult = false;
+
+   if(IsOpen() && !m_u8StreamID)
+   {
+      if(!m_bOpenTime)
+      {
+         m_u32Opened = in_u32Time;
+         m_bOpenTime = true;
+      }
+      l_bResult = (in_u32Time - m_u32Opened) >= IRIDIUM_STREAM_OPEN_TIMEOUT;
+   }
+   return l_bResult;
+}
+
+/**
+   Установка буфера блоков полученных вне очереди
+   на входе    :  in_pBuffer     - указатель на буфер
+                  in_stSize      - размер буфера
+                  in_u16SlotSize - максимальный размер блока
+   на выходе   :  *
+*/
+void CIridiumStreamWindow::SetBuffer(void* in_pBuffer, size_t in_stSize, u16 in_u16SlotSize)
+{
+   size_t l_stSlots = 0;
+
+   if(in_pBuffer && in_u16SlotSize)
+      l_stSlots = in_stSize / in_u16SlotSize;
+   if(l_stSlots > IRIDIUM_STREAM_MAX_WINDOW - 1)
+      l_stSlots = IRIDIUM_STREAM_MAX_WINDOW - 1;
+
+   m_pBuffer = (u8*)in_pBuffer;
+   m_u16SlotSize = in_u16SlotSize;
+   m_u8Slots = (u8)l_stSlots;
+}
+
+/**
+   Получение максимального окна приема
+   на входе    :  *
+   на выходе   :  размер окна, 1 - буфера нет, прием только по одному блоку
+   примечание  :  ожидаемый блок передается приложению сразу, место нужно только блокам после него
+*/
+u8 CIridiumStreamWindow::GetMaxWindow() const
+{
+   return m_u8Slots + 1;
+}
+
+/**
+   Учет полученного блока
+   на входе    :  in_u8BlockID   - идентификатор блока
+                  in_u16Size     - размер данных блока
+                  in_pData       - указатель на данные блока
+   на выходе   :  true - блок следующий по порядку, его нужно передать приложению и вызвать Delivered
+   примечание  :  блок внутри окна сохраняется в буфере, повторно полученные и блоки вне окна отбрасываются
+*/
+bool CIridiumStreamWindow::Receive(u8 in_u8BlockID, u16 in_u16Size, const void* in_pData)
+{
+   bool l_bResult = false;
+   u8 l_u8Shift = (u8)(in_u8BlockID - (u8)m_u32Expected);
+
+   if(m_bFailed)
+      l_bResult = false;
+   else if(!l_u8Shift)
+      l_bResult = true;
+   else if(l_u8Shift < m_u8Window && in_u16Size <= m_u16SlotSize && !(m_u16Received & (1 << l_u8Shift)))
+   {
+      // Место определяется номером блока, блоки окна занимают разные места
+      u8 l_u8Slot = (u8)((m_u32Expected + l_u8Shift) % m_u8Slots);
+      memcpy(m_pBuffer + (size_t)l_u8Slot * m_u16SlotSize, in_pData, in_u16Size);
+      m_au16Size[l_u8Slot] = in_u16Size;
+      m_u16Received |= (1 << l_u8Shift);
+   }
+   return l_bResult;
+}
+
+/**
+   Учет передачи ожидаемого блока приложению
+   на входе    :  in_u16Result   - результат обработки блока приложением
+   на выходе   :  *
+*/
+void CIridiumStreamWindow::Delivered(u16 in_u16Result)
+{
+   m_u16Result = in_u16Result;
+   m_u32Expected++;
+   m_u16Received >>= 1;
+   // Блок не принят приложением, дальнейшие блоки отбрасываются, подтверждение сообщает об ошибке
+   if(!in_u16Result)
+   {
+      m_u16Received = 0;
+      m_bFailed = true;
+   }
+}
+
+/**
+   Получение сохраненного блока, следующего по порядку
+   на входе    :  out_rBlockID   - ссылка куда нужно поместить идентификатор блока
+                  out_rSize      - ссылка куда нужно поместить размер данных блока
+                  out_rData      - ссылка куда нужно поместить указатель на данные блока
+   на выходе   :  true - блок есть, его нужно передать приложению и вызвать Delivered
+*/
+bool CIridiumStreamWindow::GetStored(u8& out_rBlockID, u16& out_rSize, void*& out_rData)
+{
+   bool l_bResult = false;
+
+   if(!m_bFailed && (m_u16Received & 1))
+   {
+      u8 l_u8Slot = (u8)(m_u32Expected % m_u8Slots);
+      out_rBlockID = (u8)m_u32Expected;
+      out_rSize = m_au16Size[l_u8Slot];
+      out_rData = m_pBuffer + (size_t)l_u8Slot * m_u16SlotSize;
+      l_bResult = true;
+   }
+   return l_bResult;
+}
+
+/**
+   Получение данных подтверждения
+   на входе    :  out_rBlockID   - ссылка куда нужно поместить идентификатор последнего блока полученного по порядку
+                  out_rSize      - ссылка куда нужно поместить результат обработки этого блока
+                  out_rMask      - ссылка куда нужно поместить маску блоков полученных после него
+   на выходе   :  *
+*/
+void CIridiumStreamWindow::GetAck(u8& out_rBlockID, u16& out_rSize, u16& out_rMask) const
+{
+   out_rBlockID = (u8)(m_u32Expected - 1);
+   out_rSize = m_u16Result;
+   out_rMask = m_u16Received;
+}
+
+/**
+   Получение номера блока для отправки
+   на входе    :  in_u32Time  - монотонное время платформы в миллисекундах
+                  out_rIndex  - ссылка куда нужно поместить номер блока
+   на выходе   :  true - блок нужно отправить и вызвать Sent, false - отправлять нечего или передача прервана
+   примечание  :  повторы пропущенных блоков отправляются раньше новых блоков
+*/
+bool CIridiumStreamWindow::GetNext(u32 in_u32Time, u32& out_rIndex)
+{
+   bool l_bResult = false;
+
+   if(m_u8Window && !m_bFailed)
+   {
+      u32 l_u32Count = m_u32Next - m_u32Base;
+      for(u32 i = 0; !l_bResult && !m_bFailed && i < l_u32Count; i++)
+      {
+         if(!(m_u16Acked & (1 << i)))
+         {
+            u8 l_u8Slot = (u8)((m_u32Base + i) % IRIDIUM_STREAM_MAX_WINDOW);
+            if(m_u16Lost & (1 << i))
+               l_bResult = true;
+            else if((u32)(in_u32Time - m_au32Time[l_u8Slot]) >= IRIDIUM_STREAM_RETRY_TIME)
+            {
+               if(m_au8Retries[l_u8Slot] < IRIDIUM_STREAM_MAX_RETRIES)
+                  l_bResult = true;
+               else
+                  m_bFailed = true;
+            }
+            if(l_bResult)
+               out_rIndex = m_u32Base + i;
+         }
+      }
+      // Новый блок, если окно не заполнено
+      if(!l_bResult && !m_bFailed && m_u32Next != m_u32End && l_u32Count < m_u8Window)
+      {
+         out_rIndex = m_u32Next;
+         l_bResult = true;
+      }
+   }
+   return l_bResult;
+}
+
+/**
+   Учет отправки блока
+   на входе    :  in_u32Index - номер блока
+                  in_u32Time  - монотонное время платформы в миллисекундах
+   на выходе   :  *
+*/
+void CIridiumStreamWindow::Sent(u32 in_u32Index, u32 in_u32Time)
+{
+   u8 l_u8Slot = (u8)(in_u32Index % IRIDIUM_STREAM_MAX_WINDOW);
+   u32 l_u32Shift = in_u32Index - m_u32Base;
+
+   if(in_u32Index == m_u32Next)
+   {
+      // Новый блок
+      m_au8Retries[l_u8Slot] = 0;
+      m_u32Next++;
+   } else if(l_u32Shift < IRIDIUM_STREAM_MAX_WINDOW)
+   {
+      // Повтор: по обнаруженному пропуску не более одного раза, иначе по тайм-ауту
+      if(m_u16Lost & (1 << l_u32Shift))
+      {
+         m_u16Lost &= ~(1 << l_u32Shift);
+         m_u16Resent |= (1 << l_u32Shift);
+      } else
+         m_au8Retries[l_u8Slot]++;
+   }
+   m_au32Time[l_u8Slot] = in_u32Time;
+}
+
+/**
+   Установка количества блоков потока
+   на входе    :  in_u32Index - номер блока, для которого данных нет
+   на выходе   :  *
+   примечание  :  данные могут закончиться только на новом блоке, иначе передача прерывается
+*/
+void CIridiumStreamWindow::SetEnd(u32 in_u32Index)
+{
+   if(in_u32Index == m_u32Next)
+      m_u32End = in_u32Index;
+   else
+      m_bFailed = true;
+}
+
+/**
+   Учет подтверждения
+   на входе    :  in_u8BlockID   - идентификатор последнего блока полученного по порядку
+                  in_u16Mask     - маска блоков полученных после него
+   на выходе   :  количество вновь подтвержденных по порядку блоков, -1 - подтверждение устарело
+   примечание  :  неподтвержденные блоки перед подтвержденным по маске считаются потерянными
+*/
+s8 CIridiumStreamWindow::Acknowledge(u8 in_u8BlockID, u16 in_u16Mask)
+{
+   s8 l_s8Result = -1;
+   u8 l_u8Count = (u8)(in_u8BlockID + 1 - (u8)m_u32Base);
+   u32 l_u32Count = m_u32Next - m_u32Base;
+
+   if(m_u8Window && l_u8Count <= l_u32Count)
+   {
+      // Сдвиг окна на подтвержденные по порядку блоки
+      m_u32Base += l_u8Count;
+      l_u32Count -= l_u8Count;
+      m_u16Acked = (l_u8Count < 16) ? (m_u16Acked >> l_u8Count) : 0;
+      m_u16Lost = (l_u8Count < 16) ? (m_u16Lost >> l_u8Count) : 0;
+      m_u16Resent = (l_u8Count < 16) ? (m_u16Resent >> l_u8Count) : 0;
+
+      // Учет блоков полученных вне очереди (только отправленных)
+      m_u16Acked |= in_u16Mask & (u16)((1UL << l_u32Count) - 1);
+      if(m_u16Acked)
+      {
+         // Поиск самого позднего подтвержденного блока
+         u8 l_u8Last = 15;
+         while(!(m_u16Acked & (1 << l_u8Last)))
+            l_u8Last--;
+         // Более ранние неподтвержденные блоки потеряны
+         u16 l_u16Lost = (u16)((1UL << l_u8Last) - 1) & ~m_u16Acked & ~m_u16Resent;
+         m_u16Lost |= l_u16Lost;
+      }
+      l_s8Result = (s8)l_u8Count;
+   }
+   return l_s8Result;
+}
@@ -0,0 +1,126 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+#ifndef _C_IRIDIUM_STREAM_WINDOW_H_INCLUDED_
+#define _C_IRIDIUM_STREAM_WINDOW_H_INCLUDED_
+
+// Включения
+#include "Iridium.h"
+
+// Максимальный размер окна потока (ограничен размером маски подтверждения)
+#define IRIDIUM_STREAM_MAX_WINDOW         16
+
+// Время ожидания подтверждения блока до повторной отправки в миллисекундах
+#ifndef IRIDIUM_STREAM_RETRY_TIME
+#define IRIDIUM_STREAM_RETRY_TIME         500
+#endif
+
+// Количество повторов блока по тайм-ауту, после которого передача прерывается
+#ifndef IRIDIUM_STREAM_MAX_RETRIES
+#define IRIDIUM_STREAM_MAX_RETRIES        5
+#endif
+
+// Время ожидания ответа на запрос открытия потока в миллисекундах, после которого окно освобождается
+#ifndef IRIDIUM_STREAM_OPEN_TIMEOUT
+#define IRIDIUM_STREAM_OPEN_TIMEOUT       (IRIDIUM_STREAM_RETRY_TIME * IRIDIUM_STREAM_MAX_RETRIES)
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+// class CIridiumStreamWindow
+//////////////////////////////////////////////////////////////////////////
+// Окно передачи блоков потока. Передающая сторона держит в пути до m_u8Window блоков, принимающая
+// подтверждает последний блок полученный по порядку (накопительное подтверждение) и маской блоков,
+// полученных после него (бит i - блок с идентификатором на i + 1 больше подтвержденного). Блоки вне
+// очереди сохраняются в буфере приемника и передаются приложению строго по порядку, поэтому повторно
+// отправляются только пропущенные блоки: сразу, если подтвержден более поздний блок, иначе по тайм-ауту.
+// Идентификатор блока - младший байт его порядкового номера в потоке
+class CIridiumStreamWindow
+{
+public:
+   // Конструктор/деструктор
+   CIridiumStreamWindow();
+   ~CIridiumStreamWindow();
+
+   // Открытие/закрытие окна
+   void Open(iridium_address_t in_Addr, u8 in_u8StreamID, u8 in_u8Window);
+   void Close();
+
+   // Получение параметров окна
+   bool IsOpen() const
+      { return m_u8Window != 0; }
+   iridium_address_t GetAddress() const
+      { return m_Addr; }
+   u8 GetStreamID() const
+      { return m_u8StreamID; }
+   u8 GetWindow() const
+      { return m_u8Window; }
+
+   // Прием: буфер блоков полученных вне очереди и максимальное окно, которое он позволяет принять
+   void SetBuffer(void* in_pBuffer, size_t in_stSize, u16 in_u16SlotSize);
+   u8 GetMaxWindow() const;
+   // Учет полученного блока (true - блок следующий по порядку, его нужно передать приложению)
+   bool Receive(u8 in_u8BlockID, u16 in_u16Size, const void* in_pData);
+   // Блок передан приложению, in_u16Result - результат обработки (0 - ошибка, прием прекращается)
+   void Delivered(u16 in_u16Result);
+   // Получение сохраненного блока, следующего по порядку
+   bool GetStored(u8& out_rBlockID, u16& out_rSize, void*& out_rData);
+   // Получение данных подтверждения
+   void GetAck(u8& out_rBlockID, u16& out_rSize, u16& out_rMask) const;
+
+   // Передача: проверка ожидания ответа на запрос открытия (true - время ожидания истекло)
+   bool IsOpenExpired(u32 in_u32Time);
+   // Получение номера блока для отправки (повтор или новый блок)
+   bool GetNext(u32 in_u32Time, u32& out_rIndex);
+   // Блок отправлен
+   void Sent(u32 in_u32Index, u32 in_u32Time);
+   // Установка количества блоков потока (данные закончились)
+   void SetEnd(u32 in_u32Index);
+   // Учет подтверждения (количество вновь подтвержденных по порядку блоков, -1 - устаревшее подтверждение)
+   s8 Acknowledge(u8 in_u8BlockID, u16 in_u16Mask);
+   // Получение состояния передачи
+   u32 GetBase() const
+      { return m_u32Base; }
+   bool IsComplete() const
+      { return m_u32End == m_u32Base; }
+   // Признак прерывания приема или передачи
+   bool IsFailed() const
+      { return m_bFailed; }
+
+private:
+   iridium_address_t       m_Addr;                 // Адрес второй стороны
+   u8                      m_u8StreamID;           // Идентификатор потока
+   u8                      m_u8Window;             // Размер окна (0 - окно закрыто)
+   // Прием
+   u8*                     m_pBuffer;              // Буфер блоков вне очереди
+   u16                     m_u16SlotSize;          // Размер места под блок в буфере
+   u8                      m_u8Slots;              // Количество мест под блоки
+   u32                     m_u32Expected;          // Номер ожидаемого блока
+   u16                     m_u16Received;          // Маска полученных блоков (бит i - блок m_u32Expected + i)
+   u16                     m_u16Result;            // Результат обработки последнего переданного приложению блока
+   u16                     m_au16Size[IRIDIUM_STREAM_MAX_WINDOW]; // Размеры сохраненных блоков
+   // Передача
+   u32                     m_u32Base;              // Номер первого неподтвержденного блока
+   u32                     m_u32Next;              // Номер следующего нового блока
+   u32                     m_u32End;               // Количество блоков потока (0xFFFFFFFF - неизвестно)
+   u16                     m_u16Acked;             // Маска подтвержденных блоков (бит i - блок m_u32Base + i)
+   u16                     m_u16Lost;              // Маска блоков, пропуск которых обнаружен по подтверждению
+   u16                     m_u16Resent;            // Маска блоков, уже повторенных по обнаруженному пропуску
+   u32                     m_au32Time[IRIDIUM_STREAM_MAX_WINDOW]; // Время отправки блоков
+   u8                      m_au8Retries[IRIDIUM_STREAM_MAX_WINDOW]; // Количество повторов блоков по тайм-ауту
+   bool                    m_bFailed;              // Признак прерывания приема или передачи
+   u32                     m_u32Opened;            // Время начала ожидания ответа на запрос открытия
+   bool                    m_bOpenTime;            // Признак начала отсчета ожидания ответа на запрос открытия
+};
+#endif   // _C_IRIDIUM_STREAM_WINDOW_H_INCLUDED_
@@ -0,0 +1,379 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+#include "CIridiumSubscriptions.h"
+
+/**
+   Получение числового значения для проверки зоны нечувствительности
+   на входе    :  in_u8Type   - тип значения
+                  in_rValue   - ссылка на значение
+                  out_rNumber - ссылка куда нужно поместить числовое значение
+   на выходе   :  true - значение имеет числовой тип
+*/
+static bool GetNumber(u8 in_u8Type, universal_value_t& in_rValue, f32& out_rNumber)
+{
+   bool l_bResult = true;
+   switch(in_u8Type)
+   {
+   case IVT_BOOL:
+      out_rNumber = in_rValue.m_bValue ? 1.0f : 0.0f;
+      break;
+   case IVT_S8:
+      out_rNumber = (f32)in_rValue.m_s8Value;
+      break;
+   case IVT_U8:
+      out_rNumber = (f32)in_rValue.m_u8Value;
+      break;
+   case IVT_S16:
+      out_rNumber = (f32)in_rValue.m_s16Value;
+      break;
+   case IVT_U16:
+      out_rNumber = (f32)in_rValue.m_u16Value;
+      break;
+   case IVT_S32:
+      out_rNumber = (f32)in_rValue.m_s32Value;
+      break;
+   case IVT_U32:
+      out_rNumber = (f32)in_rValue.m_u32Value;
+      break;
+   case IVT_F32:
+      out_rNumber = in_rValue.m_f32Value;
+      break;
+   case IVT_S64:
+      out_rNumber = (f32)in_rValue.m_s64Value;
+      break;
+   case IVT_U64:
+      out_rNumber = (f32)in_rValue.m_u64Value;
+      break;
+   case IVT_F64:
+      out_rNumber = (f32)in_rValue.m_f64Value;
+      break;
+   default:
+      l_bResult = false;
+      break;
+   }
+   return l_bResult;
+}
+
+/**
+   Конструктор класса
+   на входе    :  *
+*/
+CIridiumSubscriptions::CIridiumSubscriptions()
+{
+   m_u32Time = 0;
+   Clear();
+}
+
+/**
+   Деструктор класса
+*/
+CIridiumSubscriptions::~CIridiumSubscriptions()
+{
+}
+
+/**
+   Очистка таблицы подписок
+   на входе    :  *
+   на выходе   :  *
+*/
+void CIridiumSubscriptions::Clear()
+{
+   memset(m_aTable, 0, sizeof(m_aTable));
+   m_stCount = 0;
+   m_u32Next = 0;
+   m_bNext = false;
+}
+
+/**
+   Добавление подписки
+   на входе    :  in_u32TagID       - идентификатор канала обратной связи
+                  in_Addr           - адрес подписчика
+                  in_u32MinInterval - минимальный интервал между отправками значения
+                  in_u32MaxInterval - максимальный интервал между отправками значения (0 - без контрольной отправки)
+                  in_f32Deadband    - зона нечувствительности для числовых типов
+   на выходе   :  указатель на подписку, NULL - нет свободного места
+   примечание  :  повторная подписка изменяет параметры существующей. Текущее значение канала будет
+                  отправлено подписчику при следующем вызове обработки подписок
+*/
+iridium_subscription_t* CIridiumSubscriptions::Add(u32 in_u32TagID, iridium_address_t in_Addr, u32 in_u32MinInterval, u32 in_u32MaxInterval, f32 in_f32Deadband)
+{
+   iridium_subscription_t* l_pResult = NULL;
+
+   // Поиск существующей подписки или места для новой
+   size_t l_stIndex = Lower(in_u32TagID, in_Addr);
+   if(l_stIndex < m_stCount && m_aTable[l_stIndex].m_u32TagID == in_u32TagID && m_aTable[l_stIndex].m_Addr == in_Addr)
+      l_pResult = &m_aTable[l_stIndex];
+   else if(m_stCount < IRIDIUM_MAX_SUBSCRIPTIONS)
+   {
+      // Вставка записи с сохранением порядка таблицы
+      l_pResult = &m_aTable[l_stIndex];
+      memmove(l_pResult + 1, l_pResult, (m_stCount - l_stIndex) * sizeof(iridium_subscription_t));
+      memset(l_pResult, 0, sizeof(iridium_subscription_t));
+      l_pResult->m_u32TagID = in_u32TagID;
+      l_pResult->m_Addr = in_Addr;
+      m_stCount++;
+   }
+
+   if(l_pResult)
+   {
+      // Ограничение интервалов, разность времени должна помещаться в s32
+      if(in_u32MinInterval > IRIDIUM_SUBSCRIPTION_MAX_INTERVAL)
+         in_u32MinInterval = IRIDIUM_SUBSCRIPTION_MAX_INTERVAL;
+      if(in_u32MaxInterval > IRIDIUM_SUBSCRIPTION_MAX_INTERVAL)
+         in_u32MaxInterval = IRIDIUM_SUBSCRIPTION_MAX_INTERVAL;
+      if(in_u32MaxInterval && in_u32MaxInterval < in_u32MinInterval)
+         in_u32MaxInterval = in_u32MinInterval;
+
+      l_pResult->m_u32MinInterval = in_u32MinInterval;
+      l_pResult->m_u32MaxInterval = in_u32MaxInterval;
+      l_pResult->m_f32Deadband = (in_f32Deadband > 0.0f) ? in_f32Deadband : 0.0f;
+
+      // Текущее значение отправляется сразу
+      l_pResult->m_u32Time = m_u32Time - in_u32MinInterval;
+      l_pResult->m_u8Flags |= IRIDIUM_SUBSCRIPTION_CHANGED | IRIDIUM_SUBSCRIPTION_FORCE;
+      SetNext(l_pResult);
+   }
+   return l_pResult;
+}
+
+/**
+   Поиск подписки
+   на входе    :  in_u32TagID - идентификатор канала обратной связи
+                  in_Addr     - адрес подписчика
+   на выходе   :  указатель на подписку, NULL - подписка не найдена
+*/
+iridium_subscription_t* CIridiumSubscriptions::Find(u32 in_u32TagID, iridium_address_t in_Addr)
+{
+   iridium_subscription_t* l_pResult = NULL;
+   size_t l_stIndex = Lower(in_u32TagID, in_Addr);
+   if(l_stIndex < m_stCount && m_aTable[l_stIndex].m_u32TagID == in_u32TagID && m_aTable[l_stIndex].m_Addr == in_Addr)
+      l_pResult = &m_aTable[l_stIndex];
+   return l_pResult;
+}
+
+/**
+   Удаление подписки
+   на входе    :  in_u32TagID - идентификатор канала обратной связи
+                  in_Addr     - адрес подписчика
+   на выходе   :  true - подписка была удалена
+*/
+bool CIridiumSubscriptions::Remove(u32 in_u32TagID, iridium_address_t in_Addr)
+{
+   bool l_bResult = false;
+   iridium_subscription_t* l_pSubscription = Find(in_u32TagID, in_Addr);
+   if(l_pSubscription)
+   {
+      Remove(l_pSubscription - m_aTable);
+      l_bResult = true;
+   }
+   return l_bResult;
+}
+
+/**
+   Удаление подписки по индексу
+   на входе    :  in_stIndex - индекс подписки
+   на выходе   :  *
+   примечание  :  подписки, расположенные после удаленной, сдвигаются на одну позицию
+*/
+void CIridiumSubscriptions::Remove(size_t in_stIndex)
+{
+   if(in_stIndex < m_stCount)
+   {
+      m_stCount--;
+      memmove(&m_aTable[in_stIndex], &m_aTable[in_stIndex + 1], (m_stCount - in_stIndex) * sizeof(iridium_subscription_t));
+      memset(&m_aTable[m_stCount], 0, sizeof(iridium_subscription_t));
+   }
+}
+
+/**
+   Отметка изменения значения канала для всех подписчиков
+   на входе    :  in_u32TagID - идентификатор канала обратной связи
+   на выходе   :  true - у канала есть подписчики
+   примечание  :  частые изменения объединяются, подписчику отправляется значение, актуальное на момент
+                  отправки, не чаще минимального интервала подписки
+*/
+bool CIridiumSubscriptions::SetChanged(u32 in_u32TagID)
+{
+   bool l_bResult = false;
+   for(size_t i = Lower(in_u32TagID, 0); i < m_stCount && m_aTable[i].m_u32TagID == in_u32TagID; i++)
+   {
+      iridium_subscription_t* l_pSubscription = &m_aTable[i];
+      if(!(l_pSubscription->m_u8Flags & IRIDIUM_SUBSCRIPTION_CHANGED))
+      {
+         // После долгого ожидания разность времени может переполниться, ограничим ее минимальным интервалом
+         if(m_u32Time - l_pSubscription->m_u32Time > l_pSubscription->m_u32MinInterval)
+            l_pSubscription->m_u32Time = m_u32Time - l_pSubscription->m_u32MinInterval;
+         l_pSubscription->m_u8Flags |= IRIDIUM_SUBSCRIPTION_CHANGED;
+         SetNext(l_pSubscription);
+      }
+      l_bResult = true;
+   }
+   return l_bResult;
+}
+
+/**
+   Проверка наступления времени отправки хотя бы одного значения
+   на входе    :  in_u32Time - текущее время
+   на выходе   :  true - таблицу нужно просмотреть
+*/
+bool CIridiumSubscriptions::IsDue(u32 in_u32Time)
+{
+   m_u32Time = in_u32Time;
+   return m_bNext && (s32)(in_u32Time - m_u32Next) >= 0;
+}
+
+/**
+   Получение причины отправки значения подписчику
+   на входе    :  in_pSubscription - указатель на подписку
+   на выходе   :  IRIDIUM_SUBSCRIPTION_CHANGED - значение изменилось и минимальный интервал истек,
+                  IRIDIUM_SUBSCRIPTION_HEARTBEAT - истек максимальный интервал, 0 - отправка не нужна
+*/
+u8 CIridiumSubscriptions::GetDue(iridium_subscription_t* in_pSubscription)
+{
+   u8 l_u8Result = 0;
+   u32 l_u32Elapsed = m_u32Time - in_pSubscription->m_u32Time;
+
+   if((in_pSubscription->m_u8Flags & IRIDIUM_SUBSCRIPTION_CHANGED) && l_u32Elapsed >= in_pSubscription->m_u32MinInterval)
+      l_u8Result |= IRIDIUM_SUBSCRIPTION_CHANGED;
+   if(in_pSubscription->m_u32MaxInterval && l_u32Elapsed >= in_pSubscription->m_u32MaxInterval)
+      l_u8Result |= IRIDIUM_SUBSCRIPTION_HEARTBEAT;
+   return l_u8Result;
+}
+
+/**
+   Проверка выхода значения за зону нечувствительности
+   на входе    :  in_pSubscription - указатель на подписку
+                  in_u8Type        - тип текущего значения
+                  in_rValue        - ссылка на текущее значение
+   на выходе   :  true - значение нужно отправить
+   примечание  :  нечисловые значения и первое значение после подписки отправляются всегда
+*/
+bool CIridiumSubscriptions::IsChanged(iridium_subscription_t* in_pSubscription, u8 in_u8Type, universal_value_t& in_rValue)
+{
+   bool l_bResult = true;
+   f32 l_f32Value = 0.0f;
+
+   if(in_pSubscription->m_f32Deadband > 0.0f &&
+      (in_pSubscription->m_u8Flags & (IRIDIUM_SUBSCRIPTION_FORCE | IRIDIUM_SUBSCRIPTION_VALUE)) == IRIDIUM_SUBSCRIPTION_VALUE &&
+      GetNumber(in_u8Type, in_rValue, l_f32Value))
+   {
+      f32 l_f32Delta = l_f32Value - in_pSubscription->m_f32Value;
+      if(l_f32Delta < 0.0f)
+         l_f32Delta = -l_f32Delta;
+      l_bResult = (l_f32Delta >= in_pSubscription->m_f32Deadband);
+   }
+   return l_bResult;
+}
+
+/**
+   Отметка отправки значения подписчику
+   на входе    :  in_pSubscription - указатель на подписку
+                  in_u8Type        - тип отправленного значения
+                  in_rValue        - ссылка на отправленное значение
+   на выходе   :  *
+*/
+void CIridiumSubscriptions::Sent(iridium_subscription_t* in_pSubscription, u8 in_u8Type, universal_value_t& in_rValue)
+{
+   in_pSubscription->m_u32Time = m_u32Time;
+   in_pSubscription->m_u8Flags &= ~(IRIDIUM_SUBSCRIPTION_CHANGED | IRIDIUM_SUBSCRIPTION_FORCE | IRIDIUM_SUBSCRIPTION_VALUE);
+
+   // Запомним числовое значение для проверки зоны нечувствительности
+   if(GetNumber(in_u8Type, in_rValue, in_pSubscription->m_f32Value))
+      in_pSubscription->m_u8Flags |= IRIDIUM_SUBSCRIPTION_VALUE;
+}
+
+/**
+   Отметка пропуска значения, изменение не вышло за зону нечувствительности
+   на входе    :  in_pSubscription - указатель на подписку
+   на выходе   :  *
+*/
+void CIridiumSubscriptions::Skip(iridium_subscription_t* in_pSubscription)
+{
+   in_pSubscription->m_u8Flags &= ~IRIDIUM_SUBSCRIPTION_CHANGED;
+}
+
+/**
+   Вычисление времени ближайшей отправки
+   на входе    :  *
+   на выходе   :  *
+   примечание  :  вызывается после просмотра таблицы
+*/
+void CIridiumSubscriptions::Schedule()
+{
+   m_bNext = false;
+   for(size_t i = 0; i < m_stCount; i++)
+      SetNext(&m_aTable[i]);
+}
+
+/**
+   Поиск первой подписки, не меньшей заданной пары
+   на входе    :  in_u32TagID - идентификатор канала обратной связи
+                  in_Addr     - адрес подписчика
+   на выходе   :  индекс подписки, m_stCount - все подписки меньше заданной пары
+*/
+size_t CIridiumSubscriptions::Lower(u32 in_u32TagID, iridium_address_t in_Addr)
+{
+   size_t l_stLow = 0;
+   size_t l_stHigh = m_stCount;
+
+   // Двоичный поиск
+   while(l_stLow < l_stHigh)
+   {
+      size_t l_stMiddle = (l_stLow + l_stHigh) / 2;
+      iridium_subscription_t* l_pSubscription = &m_aTable[l_stMiddle];
+      if(l_pSubscription->m_u32TagID < in_u32TagID || (l_pSubscription->m_u32TagID == in_u32TagID && l_pSubscription->m_Addr < in_Addr))
+         l_stLow = l_stMiddle + 1;
+      else
+         l_stHigh = l_stMiddle;
+   }
+   return l_stLow;
+}
+
+/**
+   Учет времени отправки подписки во времени ближайшей отправки
+   на входе    :  in_pSubscription - указатель на подписку
+   на выходе   :  *
+*/
+void CIridiumSubscriptions::SetNext(iridium_subscription_t* in_pSubscription)
+{
+   u32 l_u32Elapsed = m_u32Time - in_pSubscription->m_u32Time;
+   u32 l_u32Wait = 0;
+   bool l_bWait = false;
+
+   // Отправка изменения не раньше минимального интервала
+   if(in_pSubscription->m_u8Flags & IRIDIUM_SUBSCRIPTION_CHANGED)
+   {
+      l_u32Wait = (l_u32Elapsed < in_pSubscription->m_u32MinInterval) ? in_pSubscription->m_u32MinInterval - l_u32Elapsed : 0;
+      l_bWait = true;
+   }
+
+   // Контрольная отправка по истечении максимального интервала
+   if(in_pSubscription->m_u32MaxInterval)
+   {
+      u32 l_u32Heartbeat = (l_u32Elapsed < in_pSubscription->m_u32MaxInterval) ? in_pSubscription->m_u32MaxInterval - l_u32Elapsed : 0;
+      if(!l_bWait || l_u32Heartbeat < l_u32Wait)
+         l_u32Wait = l_u32Heartbeat;
+      l_bWait = true;
+   }
+
+   if(l_bWait)
+   {
+      u32 l_u32Next = m_u32Time + l_u32Wait;
+      if(!m_bNext || (s32)(l_u32Next - m_u32Next) < 0)
+         m_u32Next = l_u32Next;
+      m_bNext = true;
+   }
+}
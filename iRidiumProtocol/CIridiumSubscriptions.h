@@ -0,0 +1,105 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+#ifndef _C_IRIDIUM_SUBSCRIPTIONS_H_INCLUDED_
+#define _C_IRIDIUM_SUBSCRIPTIONS_H_INCLUDED_
+
+// Включения
+#include "Iridium.h"
+
+// Максимальное количество подписок на изменение каналов обратной связи
+#ifndef IRIDIUM_MAX_SUBSCRIPTIONS
+#define IRIDIUM_MAX_SUBSCRIPTIONS         8
+#endif
+
+// Максимальный интервал отправки значений (разность времени должна помещаться в s32)
+#define IRIDIUM_SUBSCRIPTION_MAX_INTERVAL 0x7FFFFFFF
+
+// Флаги состояния подписки
+#define IRIDIUM_SUBSCRIPTION_CHANGED      0x01  // Значение изменилось и ожидает отправки
+#define IRIDIUM_SUBSCRIPTION_FORCE        0x02  // Отправить значение без проверки зоны нечувствительности
+#define IRIDIUM_SUBSCRIPTION_VALUE        0x04  // Сохранено последнее отправленное числовое значение
+#define IRIDIUM_SUBSCRIPTION_HEARTBEAT    0x08  // Истек максимальный интервал отправки
+
+// Структура описания подписки
+typedef struct iridium_subscription_s
+{
+   u32                              m_u32TagID;    // Идентификатор канала обратной связи
+   iridium_address_t                m_Addr;        // Адрес подписчика
+   u8                               m_u8Flags;     // Флаги состояния подписки
+   u32                              m_u32MinInterval; // Минимальный интервал между отправками значения
+   u32                              m_u32MaxInterval; // Максимальный интервал между отправками значения (0 - без контрольной отправки)
+   u32                              m_u32Time;     // Время последней отправки значения
+   f32                              m_f32Deadband; // Зона нечувствительности для числовых типов (0 - любое изменение)
+   f32                              m_f32Value;    // Последнее отправленное числовое значение
+} iridium_subscription_t;
+
+//////////////////////////////////////////////////////////////////////////
+// class CIridiumSubscriptions
+//////////////////////////////////////////////////////////////////////////
+// Таблица подписок на изменение каналов обратной связи. Подписки идентифицируются парой
+// (идентификатор канала, адрес подписчика), таблица имеет фиксированный размер и упорядочена по этой
+// паре, поэтому поиск подписчиков канала выполняется двоичным поиском. Время задается монотонным
+// счетчиком платформы, время ближайшей отправки запоминается, чтобы не просматривать таблицу без необходимости
+class CIridiumSubscriptions
+{
+public:
+   // Конструктор/деструктор
+   CIridiumSubscriptions();
+   ~CIridiumSubscriptions();
+
+   // Очистка таблицы
+   void Clear();
+
+   // Добавление/поиск/удаление подписки
+   iridium_subscription_t* Add(u32 in_u32TagID, iridium_address_t in_Addr, u32 in_u32MinInterval, u32 in_u32MaxInterval, f32 in_f32Deadband);
+   iridium_subscription_t* Find(u32 in_u32TagID, iridium_address_t in_Addr);
+   bool Remove(u32 in_u32TagID, iridium_address_t in_Addr);
+   void Remove(size_t in_stIndex);
+
+   // Отметка изменения значения канала для всех подписчиков
+   bool SetChanged(u32 in_u32TagID);
+
+   // Проверка наступления времени отправки хотя бы одного значения
+   bool IsDue(u32 in_u32Time);
+   // Получение причины отправки значения подписчику (0 - отправка не нужна)
+   u8 GetDue(iridium_subscription_t* in_pSubscription);
+   // Проверка выхода значения за зону нечувствительности
+   bool IsChanged(iridium_subscription_t* in_pSubscription, u8 in_u8Type, universal_value_t& in_rValue);
+   // Отметка отправки/пропуска значения
+   void Sent(iridium_subscription_t* in_pSubscription, u8 in_u8Type, universal_value_t& in_rValue);
+   void Skip(iridium_subscription_t* in_pSubscription);
+   // Вычисление времени ближайшей отправки
+   void Schedule();
+
+   // Получение подписки по индексу
+   iridium_subscription_t* Get(size_t in_stIndex)
+      { return (in_stIndex < m_stCount) ? &m_aTable[in_stIndex] : NULL; }
+   // Получение количества подписок
+   size_t GetCount() const
+      { return m_stCount; }
+
+protected:
+   size_t Lower(u32 in_u32TagID, iridium_address_t in_Addr);
+   void SetNext(iridium_subscription_t* in_pSubscription);
+
+private:
+   iridium_subscription_t  m_aTable[IRIDIUM_MAX_SUBSCRIPTIONS]; // Таблица подписок
+   size_t                  m_stCount;              // Количество подписок
+   u32                     m_u32Time;              // Текущее время, последнее значение переданное в IsDue
+   u32                     m_u32Next;              // Время ближайшей отправки
+   bool                    m_bNext;                // Признак наличия запланированной отправки
+};
+#endif   // _C_IRIDIUM_SUBSCRIPTIONS_H_INCLUDED_
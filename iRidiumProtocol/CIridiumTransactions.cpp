@@ -0,0 +1,430 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+#include "CIridiumTransactions.h"
+
+/**
+   Конструктор класса
+   на входе    :  *
+*/
+CIridiumTransactions::CIridiumTransactions()
+{
+   memset(m_aWindows, 0, sizeof(m_aWindows));
+   m_stLimit = IRIDIUM_MAX_TRANSACTIONS;
+   m_u16Order = 0;
+   Clear();
+}
+
+/**
+   Деструктор класса
+*/
+CIridiumTransactions::~CIridiumTransactions()
+{
+}
+
+/**
+   Очистка таблицы транзакций
+   на входе    :  *
+   на выходе   :  *
+   примечание  :  обработчики завершения транзакций не вызываются. Окна, заданные приложением, сохраняются,
+                  вычисленные окна сбрасываются
+*/
+void CIridiumTransactions::Clear()
+{
+   memset(m_aTable, 0, sizeof(m_aTable));
+   m_stCount = 0;
+   m_stSent = 0;
+
+   // Сброс вычисленных окон
+   for(size_t i = 0; i < IRIDIUM_MAX_TRANSACTION_WINDOWS; i++)
+   {
+      iridium_transaction_window_t* l_pWindow = &m_aWindows[i];
+      if(l_pWindow->m_bFixed)
+         l_pWindow->m_u8Window = l_pWindow->m_u8Max;
+      else
+         l_pWindow->m_u8Max = 0;
+   }
+}
+
+/**
+   Добавление транзакции
+   на входе    :  in_DstAddr     - адрес получателя запроса
+                  in_u16TID      - идентификатор транзакции
+                  in_u8Type      - тип сообщения
+                  in_u32Timeout  - время ожидания ответа
+                  in_u8Retries   - количество повторов запроса
+   на выходе   :  указатель на транзакцию, NULL - нет свободного места или транзакция уже существует
+   примечание  :  транзакция добавляется в состоянии ожидания отправки, отсчет времени начинается вызовом Send
+*/
+iridium_transaction_t* CIridiumTransactions::Add(iridium_address_t in_DstAddr, u16 in_u16TID, u8 in_u8Type, u32 in_u32Timeout, u8 in_u8Retries)
+{
+   iridium_transaction_t* l_pResult = NULL;
+
+   // Проверка входных параметров и наличия свободного места
+   if(in_u16TID && m_stCount < IRIDIUM_MAX_TRANSACTIONS && !Find(in_DstAddr, in_u16TID))
+   {
+      // Поиск свободной записи
+      for(size_t i = 0; i < IRIDIUM_MAX_TRANSACTIONS; i++)
+      {
+         iridium_transaction_t* l_pCur = &m_aTable[i];
+         if(!l_pCur->m_u16TID)
+         {
+            // Заполнение данных транзакции
+            l_pCur->m_DstAddr       = in_DstAddr;
+            l_pCur->m_u16TID        = in_u16TID;
+            l_pCur->m_u8Type        = in_u8Type;
+            l_pCur->m_u8Retries     = in_u8Retries;
+            l_pCur->m_u32Timeout    = in_u32Timeout;
+            l_pCur->m_u32Deadline   = 0;
+            l_pCur->m_pCallback     = NULL;
+            l_pCur->m_pContext      = NULL;
+            l_pCur->m_u16Size       = 0;
+            l_pCur->m_u16Bytes      = 0;
+            l_pCur->m_u16Order      = m_u16Order++;
+            l_pCur->m_bSent         = false;
+            m_stCount++;
+            l_pResult = l_pCur;
+            break;
+         }
+      }
+   }
+   return l_pResult;
+}
+
+/**
+   Поиск транзакции
+   на входе    :  in_DstAddr  - адрес получателя запроса
+                  in_u16TID   - идентификатор транзакции
+   на выходе   :  указатель на транзакцию, NULL - транзакция не найдена
+*/
+iridium_transaction_t* CIridiumTransactions::Find(iridium_address_t in_DstAddr, u16 in_u16TID)
+{
+   iridium_transaction_t* l_pResult = NULL;
+
+   // Проверка наличия активных транзакций
+   if(in_u16TID && m_stCount)
+   {
+      for(size_t i = 0; i < IRIDIUM_MAX_TRANSACTIONS; i++)
+      {
+         iridium_transaction_t* l_pCur = &m_aTable[i];
+         if(l_pCur->m_u16TID == in_u16TID && l_pCur->m_DstAddr == in_DstAddr)
+         {
+            l_pResult = l_pCur;
+            break;
+         }
+      }
+   }
+   return l_pResult;
+}
+
+/**
+   Удаление транзакции
+   на входе    :  in_pTransaction   - указатель на транзакцию
+   на выходе   :  *
+*/
+void CIridiumTransactions::Remove(iridium_transaction_t* in_pTransaction)
+{
+   if(in_pTransaction && in_pTransaction->m_u16TID)
+   {
+      if(in_pTransaction->m_bSent)
+         m_stSent--;
+      in_pTransaction->m_u16TID = 0;
+      m_stCount--;
+   }
+}
+
+/**
+   Отметка отправки запроса
+   на входе    :  in_pTransaction   - указатель на транзакцию
+                  in_u32Time        - текущее время
+   на выходе   :  *
+   примечание  :  вызывается при первой и повторных отправках, время ожидания ответа отсчитывается заново
+*/
+void CIridiumTransactions::Send(iridium_transaction_t* in_pTransaction, u32 in_u32Time)
+{
+   if(in_pTransaction && in_pTransaction->m_u16TID)
+   {
+      if(!in_pTransaction->m_bSent)
+      {
+         in_pTransaction->m_bSent = true;
+         m_stSent++;
+      }
+      in_pTransaction->m_u32Deadline = in_u32Time + in_pTransaction->m_u32Timeout;
+   }
+}
+
+/**
+   Получение транзакции, время ожидания ответа которой истекло
+   на входе    :  in_u32Time  - текущее время
+   на выходе   :  указатель на транзакцию, NULL - таких транзакций нет
+   примечание  :  сравнение выполняется через разность, поэтому переполнение счетчика времени допустимо
+*/
+iridium_transaction_t* CIridiumTransactions::GetExpired(u32 in_u32Time)
+{
+   iridium_transaction_t* l_pResult = NULL;
+
+   if(m_stCount)
+   {
+      for(size_t i = 0; i < IRIDIUM_MAX_TRANSACTIONS; i++)
+      {
+         iridium_transaction_t* l_pCur = &m_aTable[i];
+         if(l_pCur->m_u16TID && l_pCur->m_bSent && (s32)(in_u32Time - l_pCur->m_u32Deadline) >= 0)
+         {
+            l_pResult = l_pCur;
+            break;
+         }
+      }
+   }
+   return l_pResult;
+}
+
+/**
+   Получение следующей активной транзакции
+   на входе    :  in_pTransaction   - указатель на текущую транзакцию, NULL - начать с начала таблицы
+   на выходе   :  указатель на следующую транзакцию, NULL - транзакций больше нет
+*/
+iridium_transaction_t* CIridiumTransactions::GetNext(iridium_transaction_t* in_pTransaction)
+{
+   iridium_transaction_t* l_pResult = NULL;
+
+   // Вычисление позиции начала поиска
+   size_t l_stIndex = in_pTransaction ? (in_pTransaction - m_aTable) + 1 : 0;
+   for(size_t i = l_stIndex; i < IRIDIUM_MAX_TRANSACTIONS; i++)
+   {
+      if(m_aTable[i].m_u16TID)
+      {
+         l_pResult = &m_aTable[i];
+         break;
+      }
+   }
+   return l_pResult;
+}
+
+/**
+   Получение количества активных транзакций для получателя
+   на входе    :  in_DstAddr  - адрес получателя
+   на выходе   :  количество транзакций
+*/
+size_t CIridiumTransactions::GetCount(iridium_address_t in_DstAddr) const
+{
+   size_t l_stResult = 0;
+
+   if(m_stCount)
+   {
+      for(size_t i = 0; i < IRIDIUM_MAX_TRANSACTIONS; i++)
+      {
+         if(m_aTable[i].m_u16TID && m_aTable[i].m_DstAddr == in_DstAddr)
+            l_stResult++;
+      }
+   }
+   return l_stResult;
+}
+
+/**
+   Установка окна запросов получателя
+   на входе    :  in_DstAddr  - адрес получателя
+                  in_u8Window - максимальное количество отправленных запросов, ожидающих ответа,
+                                0 - удалить параметры получателя (используются значения по умолчанию)
+                  in_u16Bytes - максимальный суммарный размер отправленных запросов (размер входящего буфера
+                                получателя), 0 - без ограничения
+   на выходе   :  успешность установки, false - нет свободного места для параметров получателя
+*/
+bool CIridiumTransactions::SetWindow(iridium_address_t in_DstAddr, u8 in_u8Window, u16 in_u16Bytes)
+{
+   bool l_bResult = false;
+
+   if(in_u8Window)
+   {
+      // Поиск или создание записи
+      iridium_transaction_window_t* l_pWindow = GetWindow(in_DstAddr, true);
+      if(l_pWindow)
+      {
+         l_pWindow->m_u8Max      = in_u8Window;
+         l_pWindow->m_u8Window   = in_u8Window;
+         l_pWindow->m_u16Bytes   = in_u16Bytes;
+         l_pWindow->m_bFixed     = true;
+         l_bResult = true;
+      }
+   } else
+   {
+      // Удаление записи
+      iridium_transaction_window_t* l_pWindow = GetWindow(in_DstAddr, false);
+      if(l_pWindow)
+         memset(l_pWindow, 0, sizeof(iridium_transaction_window_t));
+      l_bResult = true;
+   }
+   return l_bResult;
+}
+
+/**
+   Проверка возможности отправки запроса получателю
+   на входе    :  in_DstAddr  - адрес получателя
+                  in_stSize   - размер пакета запроса
+   на выходе   :  true - запрос можно отправить сразу, false - запрос должен ожидать в очереди
+   примечание  :  запрос не отправляется, если у получателя есть ожидающие в очереди запросы, чтобы сохранить
+                  порядок запросов
+*/
+bool CIridiumTransactions::IsReady(iridium_address_t in_DstAddr, size_t in_stSize)
+{
+   bool l_bResult = IsOpen(in_DstAddr, in_stSize);
+
+   // Проверка наличия ожидающих в очереди запросов получателя
+   for(size_t i = 0; l_bResult && i < IRIDIUM_MAX_TRANSACTIONS; i++)
+   {
+      iridium_transaction_t* l_pCur = &m_aTable[i];
+      if(l_pCur->m_u16TID && !l_pCur->m_bSent && l_pCur->m_DstAddr == in_DstAddr)
+         l_bResult = false;
+   }
+   return l_bResult;
+}
+
+/**
+   Получение следующего ожидающего отправки запроса, который можно отправить
+   на входе    :  *
+   на выходе   :  указатель на транзакцию, NULL - таких запросов нет
+   примечание  :  для каждого получателя запросы отправляются в порядке добавления, получатель с заполненным
+                  окном не задерживает запросы другим получателям
+*/
+iridium_transaction_t* CIridiumTransactions::GetPending()
+{
+   iridium_transaction_t* l_pResult = NULL;
+
+   if(m_stCount > m_stSent && m_stSent < m_stLimit)
+   {
+      for(size_t i = 0; i < IRIDIUM_MAX_TRANSACTIONS; i++)
+      {
+         iridium_transaction_t* l_pCur = &m_aTable[i];
+         if(!l_pCur->m_u16TID || l_pCur->m_bSent)
+            continue;
+
+         // Будет выбран самый ранний из запросов
+         if(l_pResult && (s16)(l_pCur->m_u16Order - l_pResult->m_u16Order) > 0)
+            continue;
+
+         // Запрос должен быть первым в очереди получателя
+         bool l_bFirst = true;
+         for(size_t j = 0; l_bFirst && j < IRIDIUM_MAX_TRANSACTIONS; j++)
+         {
+            iridium_transaction_t* l_pPrev = &m_aTable[j];
+            if(l_pPrev->m_u16TID && !l_pPrev->m_bSent && l_pPrev->m_DstAddr == l_pCur->m_DstAddr && (s16)(l_pPrev->m_u16Order - l_pCur->m_u16Order) < 0)
+               l_bFirst = false;
+         }
+
+         if(l_bFirst && IsOpen(l_pCur->m_DstAddr, l_pCur->m_u16Bytes))
+            l_pResult = l_pCur;
+      }
+   }
+   return l_pResult;
+}
+
+/**
+   Изменение окна по результату запроса
+   на входе    :  in_DstAddr  - адрес получателя
+                  in_bSuccess - true - получен ответ, false - ответ потерян или получатель переполнен
+   на выходе   :  *
+   примечание  :  окно увеличивается на единицу с каждым ответом до максимального значения и сбрасывается
+                  до одного запроса при потере ответа
+*/
+void CIridiumTransactions::Learn(iridium_address_t in_DstAddr, bool in_bSuccess)
+{
+   iridium_transaction_window_t* l_pWindow = GetWindow(in_DstAddr, in_bSuccess);
+   if(l_pWindow)
+   {
+      if(!in_bSuccess)
+         l_pWindow->m_u8Window = 1;
+      else if(l_pWindow->m_u8Window < l_pWindow->m_u8Max)
+         l_pWindow->m_u8Window++;
+   }
+}
+
+/**
+   Получение параметров окна получателя
+   на входе    :  in_DstAddr  - адрес получателя
+                  in_bCreate  - признак создания записи, если получатель не найден
+   на выходе   :  указатель на параметры окна, NULL - получатель не найден и нет свободного места
+   примечание  :  при отсутствии свободного места вытесняется вычисленное окно получателя без активных запросов
+*/
+iridium_transaction_window_t* CIridiumTransactions::GetWindow(iridium_address_t in_DstAddr, bool in_bCreate)
+{
+   iridium_transaction_window_t* l_pResult = NULL;
+   iridium_transaction_window_t* l_pFree = NULL;
+
+   for(size_t i = 0; i < IRIDIUM_MAX_TRANSACTION_WINDOWS; i++)
+   {
+      iridium_transaction_window_t* l_pCur = &m_aWindows[i];
+      if(!l_pCur->m_u8Max)
+      {
+         // Свободная запись
+         if(!l_pFree || l_pFree->m_u8Max)
+            l_pFree = l_pCur;
+      } else if(l_pCur->m_Addr == in_DstAddr)
+      {
+         l_pResult = l_pCur;
+         break;
+      } else if(!l_pFree && !l_pCur->m_bFixed && !GetCount(l_pCur->m_Addr))
+         l_pFree = l_pCur;
+   }
+
+   // Создание записи с параметрами по умолчанию
+   if(!l_pResult && in_bCreate && l_pFree)
+   {
+      l_pResult = l_pFree;
+      l_pResult->m_Addr       = in_DstAddr;
+      l_pResult->m_u8Max      = IRIDIUM_TRANSACTION_WINDOW;
+      l_pResult->m_u8Window   = 1;
+      l_pResult->m_u16Bytes   = IRIDIUM_TRANSACTION_WINDOW_BYTES;
+      l_pResult->m_bFixed     = false;
+   }
+   return l_pResult;
+}
+
+/**
+   Проверка наличия места в окне получателя
+   на входе    :  in_DstAddr  - адрес получателя
+                  in_stSize   - размер пакета запроса
+   на выходе   :  true - запрос помещается в окно получателя и в общее ограничение отправленных запросов
+   примечание  :  если получателю не отправлено ни одного запроса, запрос помещается в окно независимо от размера.
+                  Для получателя без параметров окна отправляется один запрос
+*/
+bool CIridiumTransactions::IsOpen(iridium_address_t in_DstAddr, size_t in_stSize)
+{
+   bool l_bResult = false;
+
+   if(m_stSent < m_stLimit)
+   {
+      // Подсчет отправленных получателю запросов
+      size_t l_stCount = 0;
+      size_t l_stBytes = 0;
+      for(size_t i = 0; i < IRIDIUM_MAX_TRANSACTIONS; i++)
+      {
+         iridium_transaction_t* l_pCur = &m_aTable[i];
+         if(l_pCur->m_u16TID && l_pCur->m_bSent && l_pCur->m_DstAddr == in_DstAddr)
+         {
+            l_stCount++;
+            l_stBytes += l_pCur->m_u16Bytes;
+         }
+      }
+
+      if(!l_stCount)
+         l_bResult = true;
+      else
+      {
+         iridium_transaction_window_t* l_pWindow = GetWindow(in_DstAddr, false);
+         if(l_pWindow)
+            l_bResult = l_stCount < l_pWindow->m_u8Window && (!l_pWindow->m_u16Bytes || l_stBytes + in_stSize <= l_pWindow->m_u16Bytes);
+      }
+   }
+   return l_bResult;
+}
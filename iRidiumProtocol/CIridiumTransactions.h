@@ -0,0 +1,149 @@
+/*******************************************************************************
+ * Copyright (c) 2013-2019 iRidi Ltd. www.iridi.com
+ *
+ * Все права зарегистрированы. Эта программа и сопровождающие материалы доступны
+ * на условиях Eclipse Public License v2.0 и Eclipse Distribution License v1.0,
+ * которая сопровождает это распространение. 
+ *
+ * Текст Eclipse Public License доступен по ссылке
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * Текст Eclipse Distribution License доступн по ссылке
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Участники:
+ *    Марат Гилязетдинов, Сергей Королёв  - первая версия
+ *******************************************************************************/
+#ifndef _C_IRIDIUM_TRANSACTIONS_H_INCLUDED_
+#define _C_IRIDIUM_TRANSACTIONS_H_INCLUDED_
+
+// Включения
+#include "Iridium.h"
+#include "IridiumBus.h"
+
+// Максимальное количество одновременно ожидающих ответа запросов
+#ifndef IRIDIUM_MAX_TRANSACTIONS
+#define IRIDIUM_MAX_TRANSACTIONS          8
+#endif
+
+// Максимальный размер пакета, который сохраняется для повторной отправки запроса
+#ifndef IRIDIUM_TRANSACTION_PACKET_SIZE
+#define IRIDIUM_TRANSACTION_PACKET_SIZE   64
+#endif
+
+// Максимальное количество получателей, для которых хранятся параметры окна запросов
+#ifndef IRIDIUM_MAX_TRANSACTION_WINDOWS
+#define IRIDIUM_MAX_TRANSACTION_WINDOWS   8
+#endif
+
+// Максимальное окно по умолчанию (количество отправленных запросов, ожидающих ответа от одного получателя)
+#ifndef IRIDIUM_TRANSACTION_WINDOW
+#define IRIDIUM_TRANSACTION_WINDOW        4
+#endif
+
+// Максимальный суммарный размер отправленных получателю запросов по умолчанию (входящий буфер устройства)
+#ifndef IRIDIUM_TRANSACTION_WINDOW_BYTES
+#define IRIDIUM_TRANSACTION_WINDOW_BYTES  IRIDIUM_BUS_IN_BUFFER_SIZE
+#endif
+
+// Состояние завершения транзакции
+enum eIridiumTransactionState
+{
+   IRIDIUM_TRANSACTION_DONE = 0,                   // Получен ответ
+   IRIDIUM_TRANSACTION_ERROR,                      // Получен ответ с ошибкой
+   IRIDIUM_TRANSACTION_TIMEOUT,                    // Ответ не получен, попытки повтора исчерпаны
+   IRIDIUM_TRANSACTION_CANCEL,                     // Транзакция отменена
+};
+
+struct iridium_transaction_s;
+
+// Обработчик завершения транзакции
+typedef void (*iridium_transaction_callback_t)(void* in_pContext, struct iridium_transaction_s& in_rTransaction, eIridiumTransactionState in_eState, eIridiumError in_eError);
+
+// Структура описания транзакции
+typedef struct iridium_transaction_s
+{
+   iridium_address_t                m_DstAddr;     // Адрес получателя запроса
+   u16                              m_u16TID;      // Идентификатор транзакции (0 - запись свободна)
+   u8                               m_u8Type;      // Тип сообщения
+   u8                               m_u8Retries;   // Оставшееся количество повторов
+   u32                              m_u32Timeout;  // Время ожидания ответа
+   u32                              m_u32Deadline; // Время окончания ожидания ответа
+   iridium_transaction_callback_t   m_pCallback;   // Обработчик завершения транзакции
+   void*                            m_pContext;    // Пользовательские данные обработчика
+   u16                              m_u16Size;     // Размер сохраненного пакета (0 - повтор невозможен)
+   u16                              m_u16Bytes;    // Размер пакета запроса
+   u16                              m_u16Order;    // Порядковый номер для отправки запросов в порядке добавления
+   bool                             m_bSent;       // Признак отправки запроса (false - запрос ожидает в очереди)
+   u8                               m_aPacket[IRIDIUM_TRANSACTION_PACKET_SIZE]; // Пакет запроса для повторной отправки
+} iridium_transaction_t;
+
+// Структура описания окна запросов получателя
+typedef struct iridium_transaction_window_s
+{
+   iridium_address_t                m_Addr;        // Адрес получателя
+   u8                               m_u8Max;       // Максимальное окно (0 - запись свободна)
+   u8                               m_u8Window;    // Текущее окно, уменьшается при потере ответов
+   u16                              m_u16Bytes;    // Максимальный суммарный размер отправленных запросов (0 - без ограничения)
+   bool                             m_bFixed;      // Признак заданных приложением параметров (запись не вытесняется)
+} iridium_transaction_window_t;
+
+//////////////////////////////////////////////////////////////////////////
+// class CIridiumTransactions
+//////////////////////////////////////////////////////////////////////////
+// Таблица запросов, ожидающих ответа. Запросы идентифицируются парой (адрес получателя, идентификатор
+// транзакции), таблица имеет фиксированный размер, время задается монотонным счетчиком платформы.
+// Для каждого получателя ограничивается количество и суммарный размер отправленных запросов (окно),
+// запросы сверх окна ожидают в таблице и отправляются по мере получения ответов
+class CIridiumTransactions
+{
+public:
+   // Конструктор/деструктор
+   CIridiumTransactions();
+   ~CIridiumTransactions();
+
+   // Очистка таблицы без вызова обработчиков
+   void Clear();
+
+   // Добавление/поиск/удаление транзакции
+   iridium_transaction_t* Add(iridium_address_t in_DstAddr, u16 in_u16TID, u8 in_u8Type, u32 in_u32Timeout, u8 in_u8Retries);
+   iridium_transaction_t* Find(iridium_address_t in_DstAddr, u16 in_u16TID);
+   void Remove(iridium_transaction_t* in_pTransaction);
+
+   // Отметка отправки запроса
+   void Send(iridium_transaction_t* in_pTransaction, u32 in_u32Time);
+
+   // Получение следующей транзакции, время ожидания которой истекло
+   iridium_transaction_t* GetExpired(u32 in_u32Time);
+   // Получение следующей активной транзакции, NULL - начать с начала таблицы
+   iridium_transaction_t* GetNext(iridium_transaction_t* in_pTransaction);
+
+   // Получение количества активных транзакций
+   size_t GetCount() const
+      { return m_stCount; }
+   size_t GetCount(iridium_address_t in_DstAddr) const;
+   size_t GetSentCount() const
+      { return m_stSent; }
+
+   // Окно запросов
+   bool SetWindow(iridium_address_t in_DstAddr, u8 in_u8Window, u16 in_u16Bytes);
+   void SetLimit(size_t in_stLimit)
+      { m_stLimit = in_stLimit; }
+   bool IsReady(iridium_address_t in_DstAddr, size_t in_stSize);
+   // Получение следующего ожидающего отправки запроса, который можно отправить
+   iridium_transaction_t* GetPending();
+   // Изменение окна по результату запроса
+   void Learn(iridium_address_t in_DstAddr, bool in_bSuccess);
+
+protected:
+   iridium_transaction_window_t* GetWindow(iridium_address_t in_DstAddr, bool in_bCreate);
+   bool IsOpen(iridium_address_t in_DstAddr, size_t in_stSize);
+
+private:
+   iridium_transaction_t   m_aTable[IRIDIUM_MAX_TRANSACTIONS]; // Таблица транзакций
+   size_t                  m_stCount;              // Количество активных транзакций
+   size_t                  m_stSent;               // Количество отправленных запросов
+   size_t                  m_stLimit;              // Максимальное количество отправленных запросов
+   u16                     m_u16Order;             // Порядковый номер следующей транзакции
+   iridium_transaction_window_t m_aWindows[IRIDIUM_MAX_TRANSACTION_WINDOWS]; // Окна запросов получателей
+};
+#endif   // _C_IRIDIUM_TRANSACTIONS_H_INCLUDED_
@@ -20,8 +20,6 @@
 #include <avr/pgmspace.h>
 #endif
 
-#define IRIDIUM_VALUE_RESERVE 5                    // Зарезервированый размер в исходящем буфере для строк
-
 /**
    Конструктор класса
    на входе    :  *
@@ -21,6 +21,8 @@
 #include "IridiumValue.h"
 #include "IridiumConfig.h"
 
+#define IRIDIUM_VALUE_RESERVE 5                    // Зарезервированый размер в исходящем буфере для строк
+
 // Буфер 
 class COutBuffer
 {
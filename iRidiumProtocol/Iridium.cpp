@@ -14,18 +14,30 @@
  *    Марат Гилязетдинов, Сергей Королёв  - первая версия
  *******************************************************************************/
 #include "Iridium.h"
+#include "IridiumCRC16.h"
 
 // Таблица с версиями сообщения 
 u8 g_aVersion[] =
 {
    0x11, 0x11, 0x11, 0x11, 0x11, 0x10, 0x00, 0x00, // 0x00-0x09
    0x11, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // 0x10-0x11
-   0x11, 0x11, 0x11, 0x11, 0x00, 0x00, 0x00, 0x00, // 0x20-0x27
-   0x11, 0x11, 0x11, 0x10, 0x00, 0x00, 0x00, 0x00, // 0x30-0x36
+   0x11, 0x11, 0x11, 0x11, 0x11, 0x00, 0x00, 0x00, // 0x20-0x29
+   0x11, 0x11, 0x11, 0x11, 0x00, 0x00, 0x00, 0x00, // 0x30-0x37
    0x12, 0x11, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // 0x40-0x43
    0x11, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // 0x50-0x52
 };
 
+// Таблица приоритетных (интерактивных) сообщений, бит на сообщение
+u8 g_aPriority[] =
+{
+   0x04, 0x00,                                     // 0x00-0x0F PING
+   0x03, 0x00,                                     // 0x10-0x1F SET_VARIABLE, GET_VARIABLE
+   0xC0, 0x03,                                     // 0x20-0x2F SET_TAG_VALUE, GET_TAG_VALUE, SUBSCRIBE_TAG, TAG_NOTIFY
+   0xC8, 0x00,                                     // 0x30-0x3F SET_CHANNEL_VALUE, GET_CHANNEL_VALUE, BATCH
+   0x00, 0x00,                                     // 0x40-0x4F
+   0x05, 0x00,                                     // 0x50-0x5F STREAM_OPEN, STREAM_CLOSE
+};
+
 /**
    Получение версии сообщения
    на входе    :  in_eType - тип сообщения
@@ -44,3 +56,69 @@ u8 GetMessageVersion(u8 in_u8Type)
    }
    return l_u8Ver;
 }
+
+/**
+   Получение приоритета сообщения
+   на входе    :  in_u8Type - тип сообщения
+   на выходе   :  true - интерактивное сообщение, отправляется раньше передачи больших объемов данных
+                  (списки каналов, описания, блоки потоков)
+*/
+bool GetMessagePriority(u8 in_u8Type)
+{
+   bool l_bResult = false;
+   if(in_u8Type <= IRIDIUM_MESSAGE_MAX)
+      l_bResult = (0 != (g_aPriority[in_u8Type >> 3] & (1 << (in_u8Type & 7))));
+   return l_bResult;
+}
+
+/**
+   Получение хэша HWID устройства для распределения ответов на запрос поиска
+   на входе    :  in_rInfo - ссылка на данные найденного устройства
+   на выходе   :  хэш HWID
+   примечание  :  CRC-16 (Modbus) с первичным значением 1 по строке HWID вместе с завершающим нулем,
+                  совпадает с идентификатором CAN фреймов устройств STM32. Хэш вычисляется одинаково
+                  ведомым при выборе слота и ведущим при подсчете ответов
+*/
+u16 GetSearchHash(iridium_search_info_t& in_rInfo)
+{
+   u16 l_u16Hash = 1;
+   const char* l_pszHWID = in_rInfo.m_pszHWID;
+
+   if(l_pszHWID)
+   {
+#if defined(IRIDIUM_AVR_PLATFORM)
+      if(in_rInfo.Mem.m_bHWID)
+      {
+         // HWID расположен в программной памяти, расчет по одному байту
+         u8 l_u8Byte = 0;
+         do
+         {
+            l_u8Byte = pgm_read_byte(l_pszHWID++);
+            l_u16Hash = GetCRC16Modbus(l_u16Hash, &l_u8Byte, 1);
+         } while(l_u8Byte);
+      } else
+#endif
+         l_u16Hash = GetCRC16Modbus(l_u16Hash, (const u8*)l_pszHWID, strlen(l_pszHWID) + 1);
+   }
+   return l_u16Hash;
+}
+
+/**
+   Расчет 32 битного хэша блока данных
+   на входе    :  in_u32Hash  - текущее значение хэша (IRIDIUM_HASH32_INIT для первого блока)
+                  in_pBuffer  - указатель на данные
+                  in_stSize   - размер данных
+   на выходе   :  значение хэша с учетом блока
+   примечание  :  FNV-1a, в отличие от GetCRC32Words принимает данные произвольного размера и выравнивания,
+                  поэтому хэш можно накапливать по частям
+*/
+u32 GetHash32(u32 in_u32Hash, const void* in_pBuffer, size_t in_stSize)
+{
+   const u8* l_pBuffer = (const u8*)in_pBuffer;
+   for(size_t i = 0; i < in_stSize; i++)
+   {
+      in_u32Hash ^= l_pBuffer[i];
+      in_u32Hash *= 0x01000193;
+   }
+   return in_u32Hash;
+}
@@ -35,6 +35,7 @@
 #define IRIDIUM_FLAGS_SET              0x02        // Флаг указывает что значение переменной было получено через запрос изменения канала, иначе через запрос получения значения
 
 #define IRIDIUM_MAX_VARIABLES          16          // Максимальное количество переменных на канал управления и обратной связи (Максимальное количество 32)
+#define IRIDIUM_HASH32_INIT            0x811C9DC5  // Первичное значение 32 битного хэша (FNV-1a)
 //////////////////////////////////////////////////////////////////////////
 // Идентификаторы контейнеров
 //////////////////////////////////////////////////////////////////////////
@@ -53,17 +54,25 @@
 #define IRIDIUM_MESSAGE_GET_TAG_DESCRIPTION        0x25  // Получение описания канала обратной связи
 #define IRIDIUM_MESSAGE_SET_TAG_VALUE              0x26  // Установка значения канала обратной связи
 #define IRIDIUM_MESSAGE_GET_TAG_VALUE              0x27  // Получение значения канала обратной связи
+#define IRIDIUM_MESSAGE_SUBSCRIBE_TAG              0x28  // Подписка на изменение значения канала обратной связи
+#define IRIDIUM_MESSAGE_TAG_NOTIFY                 0x29  // Уведомление об изменении значения канала обратной связи
 // Работа с каналами управления
 #define IRIDIUM_MESSAGE_GET_CHANNELS               0x30  // Получение списка каналов управления
 #define IRIDIUM_MESSAGE_SET_CHANNEL_VALUE          0x33  // Изменение значения канала управления
 #define IRIDIUM_MESSAGE_LINK_CHANNEL_AND_VARIABLE  0x34  // Связывание канала управления и глобальной переменной
 #define IRIDIUM_MESSAGE_GET_CHANNEL_DESCRIPTION    0x35  // Получение описания канала управления
 #define IRIDIUM_MESSAGE_GET_CHANNEL_VALUE          0x36  // Получение значения канала обратной связи
+#define IRIDIUM_MESSAGE_BATCH                      0x37  // Пакетное выполнение операций с каналами
 // Работа с потоками
 #define IRIDIUM_MESSAGE_STREAM_OPEN                0x50  // Открытие потока
 #define IRIDIUM_MESSAGE_STREAM_BLOCK               0x51  // Блок потока
 #define IRIDIUM_MESSAGE_STREAM_CLOSE               0x52  // Закрытие потока
 
+// Флаг операции пакетного сообщения, указывает на наличие пароля доступа после идентификатора канала
+#define IRIDIUM_BATCH_FLAG_PIN                     0x80
+// Флаг запроса подписки, указывает на отмену подписки
+#define IRIDIUM_SUBSCRIBE_FLAG_CANCEL              0x01
+
 #define IRIDIUM_MESSAGE_MAX                        IRIDIUM_MESSAGE_STREAM_CLOSE  // Максимальный номер сообщения
 
 // Группа клиента который подключается к серверу
@@ -166,6 +175,16 @@ typedef struct iridium_message_header_s
    u16                     m_u16TID;               // Идентификатор транзакции
 } iridium_message_header_t;
 
+// Максимальное количество сегментов исходящего пакета (заголовок, внешние данные, окончание с CRC)
+#define IRIDIUM_PACKET_MAX_SEGMENTS                3
+
+// Структура для описания сегмента исходящего пакета
+typedef struct iridium_iovec_s
+{
+   const void* m_pPtr;                             // Указатель на данные сегмента
+   size_t      m_stSize;                           // Размер данных сегмента
+} iridium_iovec_t;
+
 // Структура с информацией о найденном устройстве
 typedef struct iridium_search_info_s
 {
@@ -183,6 +202,15 @@ typedef struct iridium_search_info_s
 #endif
 } iridium_search_info_t;
 
+// Параметры распределения ответов на запрос поиска по временным слотам
+typedef struct iridium_search_slots_s
+{
+   u8    m_u8Slots;                                // Количество слотов (0, 1 - ответ без задержки)
+   u16   m_u16SlotTime;                            // Ширина слота в миллисекундах
+   u8    m_u8Bits;                                 // Количество младших бит хэша HWID, сравниваемых с префиксом
+   u16   m_u16Prefix;                              // Префикс хэша HWID, отвечают только совпадающие устройства
+} iridium_search_slots_t;
+
 // Структура с информацией об устройстве
 typedef struct iridium_device_info_s
 {
@@ -195,6 +223,7 @@ typedef struct iridium_device_info_s
    u32   m_u32Version;                             // Версия устройства
    u32   m_u32Channels;                            // Количество каналов управления на устройстве
    u32   m_u32Tags;                                // Количество каналов обратной связи
+   u32   m_u32Catalog;                             // Хэш каталога каналов (0 - устройство не сообщает хэш)
 
 #ifdef IRIDIUM_AVR_PLATFORM
    // Структра для хранения типа памяти в которой хранятся данные
@@ -301,6 +330,9 @@ typedef struct iridium_channel_description_s
 
 // Получение версии сообщения
 u8 GetMessageVersion(u8 in_u8Type);
+bool GetMessagePriority(u8 in_u8Type);
+u16 GetSearchHash(iridium_search_info_t& in_rInfo);
+u32 GetHash32(u32 in_u32Hash, const void* in_pBuffer, size_t in_stSize);
 
 #endif   // _IRIDIUM_H_INCLUDED_
 
@@ -27,6 +27,9 @@
 
 #define IRIDIUM_PROTOCOL_BUS_VERSION   1           // Версия заголовка протокола для шин 77, 232/422/485, CAN
 
+// Флаг приоритета в первом байте шинного заголовка пакета
+#define IRIDIUM_BUS_PRIORITY_MASK      0x80
+
 // Минимальный и максимальный размер шинного заголовка пакета
 #define IRIDIUM_BUS_MIN_HEADER_SIZE    3
 #define IRIDIUM_BUS_MAX_HEADER_SIZE    7
@@ -42,5 +45,12 @@
 #define IRIDIUM_BUS_OUT_BUFFER_SIZE    (IRIDIUM_BUS_MAX_HEADER_SIZE + IRIDIUM_BUS_MAX_BODY_SIZE)
 #define IRIDIUM_BUS_IN_BUFFER_SIZE     (IRIDIUM_BUS_OUT_BUFFER_SIZE * 2)
 
+// Размер кольцевого входящего буфера (данные + область зеркалирования начала буфера)
+#define IRIDIUM_BUS_RING_MIRROR_SIZE   IRIDIUM_BUS_OUT_BUFFER_SIZE
+#define IRIDIUM_BUS_RING_BUFFER_SIZE   (IRIDIUM_BUS_IN_BUFFER_SIZE + IRIDIUM_BUS_RING_MIRROR_SIZE)
+
+// Количество запоминаемых пакетов, CRC16 которых проверена при добавлении данных (IRIDIUM_ENABLE_STREAM_CRC16)
+#define IRIDIUM_BUS_STREAM_CHECKED     4
+
 #endif   // _IRIDIUM_BUS_H_INCLUDED_
 
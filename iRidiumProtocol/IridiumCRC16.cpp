@@ -20,11 +20,271 @@
 // Быстрая реализация 5 секунды
 //////////////////////////////////////////////////////////////////////////
 #include "IridiumCRC16.h"
+#include "IridiumPlatform.h"
+
+// На хостах используется табличный расчет по 16 байт и свертка умножением без переносов (PCLMULQDQ/PMULL),
+// реализация выбирается во время выполнения. На микроконтроллерах используются реализации ниже
+#if !defined(IRIDIUM_AVR_PLATFORM) && !defined(IRIDIUM_CORTEX_M_PLATFORM)
+   #define IRIDIUM_CRC16_HOST
+   #if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+      #define IRIDIUM_CRC16_PCLMUL
+      #include <emmintrin.h>
+      #include <wmmintrin.h>
+   #elif defined(__aarch64__) && (defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_AES)) && defined(IRIDIUM_LINUX_PLATFORM)
+      #define IRIDIUM_CRC16_PMULL
+      #include <arm_neon.h>
+      #include <sys/auxv.h>
+      #include <asm/hwcap.h>
+   #endif
+#endif
+
+#if defined(IRIDIUM_CRC16_HOST)
+
+// Минимальный размер данных для которого выгодна свертка
+#define IRIDIUM_CRC16_FOLD_MIN_SIZE    64
+
+typedef u16 (*crc16_func_t)(u16 in_u16Init, const u8* in_pBuffer, size_t in_stSize);
+
+static u16 g_aCRC16Slice[16][256];                 // Таблицы для расчета по 16 байт, [n][b] - CRC байта b за которым следует n нулей
+static u64 g_u64CRC16Fold127 = 0;                  // x^127 mod P в отраженном виде, для старшей половины блока
+static u64 g_u64CRC16Fold191 = 0;                  // x^191 mod P в отраженном виде, для младшей половины блока
+
+/**
+   Табличное вычисление CRC-16 (Modbus) по 16 байт
+   на входе    :  in_u16Init  - первичное значение
+                  in_pBuffer  - указатель на буфер с данными
+                  in_stSize   - размер данных в буфере
+   на выходе   :  вычисленное значение CRC
+   примечание  :  чтение данных побайтное, результат не зависит от порядка байт и выравнивания
+*/
+static u16 GetCRC16ModbusSlicing(u16 in_u16Init, const u8* in_pBuffer, size_t in_stSize)
+{
+   u16 l_u16CRC = in_u16Init;
+
+   // Расчет блоками по 16 байт
+   while(in_stSize >= 16)
+   {
+      l_u16CRC = g_aCRC16Slice[15][in_pBuffer[0] ^ (l_u16CRC & 0xFF)] ^ g_aCRC16Slice[14][in_pBuffer[1] ^ (l_u16CRC >> 8)] ^
+         g_aCRC16Slice[13][in_pBuffer[2]] ^ g_aCRC16Slice[12][in_pBuffer[3]] ^
+         g_aCRC16Slice[11][in_pBuffer[4]] ^ g_aCRC16Slice[10][in_pBuffer[5]] ^
+         g_aCRC16Slice[9][in_pBuffer[6]] ^ g_aCRC16Slice[8][in_pBuffer[7]] ^
+         g_aCRC16Slice[7][in_pBuffer[8]] ^ g_aCRC16Slice[6][in_pBuffer[9]] ^
+         g_aCRC16Slice[5][in_pBuffer[10]] ^ g_aCRC16Slice[4][in_pBuffer[11]] ^
+         g_aCRC16Slice[3][in_pBuffer[12]] ^ g_aCRC16Slice[2][in_pBuffer[13]] ^
+         g_aCRC16Slice[1][in_pBuffer[14]] ^ g_aCRC16Slice[0][in_pBuffer[15]];
+      in_pBuffer += 16;
+      in_stSize -= 16;
+   }
+
+   // Расчет блока 8 байт
+   if(in_stSize >= 8)
+   {
+      l_u16CRC = g_aCRC16Slice[7][in_pBuffer[0] ^ (l_u16CRC & 0xFF)] ^ g_aCRC16Slice[6][in_pBuffer[1] ^ (l_u16CRC >> 8)] ^
+         g_aCRC16Slice[5][in_pBuffer[2]] ^ g_aCRC16Slice[4][in_pBuffer[3]] ^
+         g_aCRC16Slice[3][in_pBuffer[4]] ^ g_aCRC16Slice[2][in_pBuffer[5]] ^
+         g_aCRC16Slice[1][in_pBuffer[6]] ^ g_aCRC16Slice[0][in_pBuffer[7]];
+      in_pBuffer += 8;
+      in_stSize -= 8;
+   }
+
+   // Расчет остатка
+   while(in_stSize--)
+      l_u16CRC = (l_u16CRC >> 8) ^ g_aCRC16Slice[0][(l_u16CRC ^ *in_pBuffer++) & 0xFF];
+
+   return l_u16CRC;
+}
+
+#if defined(IRIDIUM_CRC16_PCLMUL)
+/**
+   Вычисление CRC-16 (Modbus) сверткой блоков по 16 байт (PCLMULQDQ)
+   на входе    :  in_u16Init  - первичное значение
+                  in_pBuffer  - указатель на буфер с данными
+                  in_stSize   - размер данных в буфере
+   на выходе   :  вычисленное значение CRC
+   примечание  :  первичное значение складывается с первыми двумя байтами, далее каждый блок умножается на
+                  x^128 mod P и складывается со следующим. Остаток блока и хвост данных досчитываются таблично
+*/
+__attribute__((target("pclmul,sse2"))) static u16 GetCRC16ModbusPCLMUL(u16 in_u16Init, const u8* in_pBuffer, size_t in_stSize)
+{
+   u8 l_aRest[16];
+
+   if(in_stSize < IRIDIUM_CRC16_FOLD_MIN_SIZE)
+      return GetCRC16ModbusSlicing(in_u16Init, in_pBuffer, in_stSize);
+
+   const __m128i l_Fold = _mm_set_epi64x((long long)g_u64CRC16Fold127, (long long)g_u64CRC16Fold191);
+   __m128i l_Block = _mm_xor_si128(_mm_loadu_si128((const __m128i*)in_pBuffer), _mm_cvtsi32_si128(in_u16Init));
+   in_pBuffer += 16;
+   in_stSize -= 16;
+
+   // Свертка блоков
+   while(in_stSize >= 16)
+   {
+      __m128i l_Low = _mm_clmulepi64_si128(l_Block, l_Fold, 0x00);
+      __m128i l_High = _mm_clmulepi64_si128(l_Block, l_Fold, 0x11);
+      l_Block = _mm_xor_si128(_mm_xor_si128(l_Low, l_High), _mm_loadu_si128((const __m128i*)in_pBuffer));
+      in_pBuffer += 16;
+      in_stSize -= 16;
+   }
+
+   // Расчет остатка свертки и хвоста
+   _mm_storeu_si128((__m128i*)l_aRest, l_Block);
+   return GetCRC16ModbusSlicing(GetCRC16ModbusSlicing(0, l_aRest, sizeof(l_aRest)), in_pBuffer, in_stSize);
+}
+#endif   // defined(IRIDIUM_CRC16_PCLMUL)
+
+#if defined(IRIDIUM_CRC16_PMULL)
+/**
+   Вычисление CRC-16 (Modbus) сверткой блоков по 16 байт (PMULL)
+   на входе    :  in_u16Init  - первичное значение
+                  in_pBuffer  - указатель на буфер с данными
+                  in_stSize   - размер данных в буфере
+   на выходе   :  вычисленное значение CRC
+   примечание  :  алгоритм совпадает с GetCRC16ModbusPCLMUL
+*/
+static u16 GetCRC16ModbusPMULL(u16 in_u16Init, const u8* in_pBuffer, size_t in_stSize)
+{
+   u8 l_aRest[16];
+
+   if(in_stSize < IRIDIUM_CRC16_FOLD_MIN_SIZE)
+      return GetCRC16ModbusSlicing(in_u16Init, in_pBuffer, in_stSize);
+
+   uint8x16_t l_Block = veorq_u8(vld1q_u8(in_pBuffer), vreinterpretq_u8_u16(vsetq_lane_u16(in_u16Init, vdupq_n_u16(0), 0)));
+   in_pBuffer += 16;
+   in_stSize -= 16;
+
+   // Свертка блоков
+   while(in_stSize >= 16)
+   {
+      uint64x2_t l_Value = vreinterpretq_u64_u8(l_Block);
+      uint8x16_t l_Low = vreinterpretq_u8_p128(vmull_p64((poly64_t)vgetq_lane_u64(l_Value, 0), (poly64_t)g_u64CRC16Fold191));
+      uint8x16_t l_High = vreinterpretq_u8_p128(vmull_p64((poly64_t)vgetq_lane_u64(l_Value, 1), (poly64_t)g_u64CRC16Fold127));
+      l_Block = veorq_u8(veorq_u8(l_Low, l_High), vld1q_u8(in_pBuffer));
+      in_pBuffer += 16;
+      in_stSize -= 16;
+   }
+
+   // Расчет остатка свертки и хвоста
+   vst1q_u8(l_aRest, l_Block);
+   return GetCRC16ModbusSlicing(GetCRC16ModbusSlicing(0, l_aRest, sizeof(l_aRest)), in_pBuffer, in_stSize);
+}
+#endif   // defined(IRIDIUM_CRC16_PMULL)
+
+/**
+   Получение константы свертки
+   на входе    :  in_u32Power - степень x
+   на выходе   :  x^in_u32Power mod P, коэффициент при x^d находится в бите 63 - d
+*/
+static u64 GetCRC16FoldConstant(u32 in_u32Power)
+{
+   u32 l_u32Value = 1;
+   u64 l_u64Result = 0;
+
+   // Остаток от деления на P(x) = x^16 + x^15 + x^2 + 1
+   while(in_u32Power--)
+   {
+      l_u32Value <<= 1;
+      if(l_u32Value & 0x10000)
+         l_u32Value ^= 0x18005;
+   }
+
+   // Отражение
+   for(u8 i = 0; i < 16; i++)
+   {
+      if(l_u32Value & (1 << i))
+         l_u64Result |= (u64)1 << (63 - i);
+   }
+   return l_u64Result;
+}
+
+/**
+   Получение реализации со сверткой, поддерживаемой процессором
+   на входе    :  *
+   на выходе   :  указатель на функцию вычисления CRC, NULL - свертка не поддерживается
+*/
+static crc16_func_t GetCRC16ModbusFold()
+{
+   crc16_func_t l_pFunc = NULL;
+
+#if defined(IRIDIUM_CRC16_PCLMUL)
+   __builtin_cpu_init();
+   if(__builtin_cpu_supports("pclmul"))
+      l_pFunc = GetCRC16ModbusPCLMUL;
+#elif defined(IRIDIUM_CRC16_PMULL)
+   if(getauxval(AT_HWCAP) & HWCAP_PMULL)
+      l_pFunc = GetCRC16ModbusPMULL;
+#endif
+
+   return l_pFunc;
+}
+
+static u16 GetCRC16ModbusSelect(u16 in_u16Init, const u8* in_pBuffer, size_t in_stSize);
+
+static crc16_func_t g_pCRC16Func = GetCRC16ModbusSelect;  // Выбранная реализация
+
+/**
+   Подготовка таблиц и выбор реализации по возможностям процессора (выполняется при первом вызове)
+   на входе    :  in_u16Init  - первичное значение
+                  in_pBuffer  - указатель на буфер с данными
+                  in_stSize   - размер данных в буфере
+   на выходе   :  вычисленное значение CRC
+*/
+static u16 GetCRC16ModbusSelect(u16 in_u16Init, const u8* in_pBuffer, size_t in_stSize)
+{
+   crc16_func_t l_pFunc = NULL;
+
+   // Заполнение таблиц
+   for(u16 b = 0; b < 256; b++)
+   {
+      u16 l_u16CRC = b;
+      for(u8 i = 0; i < 8; i++)
+         l_u16CRC = l_u16CRC & 0x1 ? (l_u16CRC >> 1) ^ 0xA001 : l_u16CRC >> 1;
+      g_aCRC16Slice[0][b] = l_u16CRC;
+   }
+   for(u8 n = 1; n < 16; n++)
+   {
+      for(u16 b = 0; b < 256; b++)
+         g_aCRC16Slice[n][b] = (g_aCRC16Slice[n - 1][b] >> 8) ^ g_aCRC16Slice[0][g_aCRC16Slice[n - 1][b] & 0xFF];
+   }
+   g_u64CRC16Fold127 = GetCRC16FoldConstant(127);
+   g_u64CRC16Fold191 = GetCRC16FoldConstant(191);
+
+   l_pFunc = GetCRC16ModbusFold();
+   if(!l_pFunc)
+      l_pFunc = GetCRC16ModbusSlicing;
+
+   g_pCRC16Func = l_pFunc;
+   return l_pFunc(in_u16Init, in_pBuffer, in_stSize);
+}
+
+// Выбор реализации при загрузке модуля, до запуска потоков
+static struct crc16_select_t
+{
+   crc16_select_t()
+      { GetCRC16ModbusSelect(0xFFFF, NULL, 0); }
+} g_CRC16Select;
+
+/**
+   Вычисление CRC-16 (Modbus)
+   на входе    :  in_u16Init  - первичное значение
+                  in_pBuffer  - указатель на буфер с данными
+                  in_stSize   - размер данных в буфере
+   на выходе   :  вычисленное значение CRC
+   примечание  :  name:    "CRC-16/MODBUS"
+                  init:    0xFFFF
+                  poly:    0x8005 (0xA001)
+                  xor:     0x0000
+                  rev:     true
+                  результат всех реализаций совпадает побитно
+*/
+u16 GetCRC16Modbus(u16 in_u16Init, const u8* in_pBuffer, size_t in_stSize)
+{
+   return g_pCRC16Func(in_u16Init, in_pBuffer, in_stSize);
+}
 
 // Проверка на использование быстрого алгоритма вычисления CRC16
-#if defined(IRIDIUM_ENABLE_FAST_CRC16)
+#elif defined(IRIDIUM_ENABLE_FAST_CRC16)
 
-#include "IridiumPlatform.h"
+static crc16_hook_t g_pCRC16Hook = NULL;           // Платформенная реализация
 
 // Таблица CRC16 modbus
 #if defined(IRIDIUM_AVR_PLATFORM)
@@ -205,6 +465,10 @@ u16 GetCRC16Modbus(u16 in_u16Init, const u8* in_pBuffer, size_t in_stSize)
 {
    u16 l_u16CRC = in_u16Init;
 
+   // Вычисление платформенной реализацией
+   if(g_pCRC16Hook)
+      return g_pCRC16Hook(in_u16Init, in_pBuffer, in_stSize);
+
    // Расчет до выравнивания
    while(((uintptr_t)in_pBuffer & 3) && in_stSize)
    {
@@ -230,7 +494,9 @@ u16 GetCRC16Modbus(u16 in_u16Init, const u8* in_pBuffer, size_t in_stSize)
    return l_u16CRC;
 }
 
-#else    // defined(IRIDIUM_ENABLE_FAST_CRC16)
+#else    // defined(IRIDIUM_CRC16_HOST)
+
+static crc16_hook_t g_pCRC16Hook = NULL;           // Платформенная реализация
 
 /**
    Медленное вычисление CRC-16 (Modbus)
@@ -246,6 +512,10 @@ u16 GetCRC16Modbus(u16 in_u16Init, const u8* in_pBuffer, size_t in_stSize)
 */
 u16 GetCRC16Modbus(u16 in_u16Init, const u8* in_pBuffer, size_t in_stSize)
 {
+   // Вычисление платформенной реализацией
+   if(g_pCRC16Hook)
+      return g_pCRC16Hook(in_u16Init, in_pBuffer, in_stSize);
+
    // Обработка данных из буфера
    while(in_stSize--)
    {
@@ -257,5 +527,212 @@ u16 GetCRC16Modbus(u16 in_u16Init, const u8* in_pBuffer, size_t in_stSize)
    return in_u16Init;
 }
 
-#endif   // defined(IRIDIUM_ENABLE_FAST_CRC16)
+#endif   // defined(IRIDIUM_CRC16_HOST)
+
+//////////////////////////////////////////////////////////////////////////
+// Платформенные реализации
+//////////////////////////////////////////////////////////////////////////
+static crc32_hook_t g_pCRC32Hook = NULL;           // Платформенная реализация CRC-32
+
+/**
+   Установка платформенной реализации CRC-16 (Modbus)
+   на входе    :  in_pHook    - указатель на функцию вычисления CRC, NULL - программная реализация
+   на выходе   :  *
+   примечание  :  результат платформенной реализации должен совпадать с GetCRC16Modbus побитно,
+                  функцию нужно устанавливать до начала работы с протоколом
+*/
+void SetCRC16Hook(crc16_hook_t in_pHook)
+{
+#if defined(IRIDIUM_CRC16_HOST)
+   g_pCRC16Func = in_pHook ? in_pHook : GetCRC16ModbusSelect;
+#else
+   g_pCRC16Hook = in_pHook;
+#endif
+}
+
+/**
+   Выбор программной реализации CRC-16 (Modbus)
+   на входе    :  in_eEngine  - реализация
+   на выходе   :  true  - реализация установлена
+                  false - реализация не поддерживается платформой
+   примечание  :  используется для сверки реализаций и замеров, IRIDIUM_CRC16_ENGINE_AUTO возвращает
+                  выбор по возможностям процессора. На микроконтроллерах доступен только IRIDIUM_CRC16_ENGINE_AUTO
+*/
+bool SetCRC16Engine(eIridiumCRC16Engine in_eEngine)
+{
+   bool l_bResult = false;
+
+#if defined(IRIDIUM_CRC16_HOST)
+   crc16_func_t l_pFunc = NULL;
+
+   switch(in_eEngine)
+   {
+   case IRIDIUM_CRC16_ENGINE_AUTO:
+      l_pFunc = GetCRC16ModbusSelect;
+      break;
+   case IRIDIUM_CRC16_ENGINE_SLICING:
+      l_pFunc = GetCRC16ModbusSlicing;
+      break;
+   case IRIDIUM_CRC16_ENGINE_FOLD:
+      l_pFunc = GetCRC16ModbusFold();
+      break;
+   }
+
+   if(l_pFunc)
+   {
+      g_pCRC16Func = l_pFunc;
+      l_bResult = true;
+   }
+#else
+   l_bResult = (in_eEngine == IRIDIUM_CRC16_ENGINE_AUTO);
+#endif
+
+   return l_bResult;
+}
+
+/**
+   Установка платформенной реализации CRC-32
+   на входе    :  in_pHook    - указатель на функцию вычисления CRC, NULL - программная реализация
+   на выходе   :  *
+*/
+void SetCRC32Hook(crc32_hook_t in_pHook)
+{
+   g_pCRC32Hook = in_pHook;
+}
+
+/**
+   Вычисление CRC-32 по 32 битным словам
+   на входе    :  in_pBuffer  - указатель на выровненный буфер с данными
+                  in_stCount  - количество 32 битных слов в буфере
+   на выходе   :  вычисленное значение CRC
+   примечание  :  name:    "CRC-32/MPEG-2"
+                  init:    0xFFFFFFFF
+                  poly:    0x04C11DB7
+                  xor:     0x00000000
+                  rev:     false
+                  слова обрабатываются целиком, начиная со старшего бита, в порядке байт процессора.
+                  Алгоритм совпадает с аппаратным блоком CRC микроконтроллеров STM32
+*/
+u32 GetCRC32Words(const u32* in_pBuffer, size_t in_stCount)
+{
+   u32 l_u32CRC = 0xFFFFFFFF;
+
+   // Вычисление платформенной реализацией
+   if(g_pCRC32Hook)
+      return g_pCRC32Hook(in_pBuffer, in_stCount);
+
+   while(in_stCount--)
+   {
+      l_u32CRC ^= *in_pBuffer++;
+      for(u8 i = 0; i < 32; i++)
+         l_u32CRC = (l_u32CRC & 0x80000000) ? (l_u32CRC << 1) ^ 0x04C11DB7 : l_u32CRC << 1;
+   }
+   return l_u32CRC;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Объединение и исправление CRC
+// CRC без выходного XOR линейна: CRC(A + B) = CRC(A) * x^(8 * |B|) mod P + CRC0(B),
+// где CRC0 - CRC с нулевым первичным значением
+//////////////////////////////////////////////////////////////////////////
+
+/**
+   Умножение многочленов по модулю P в отраженном виде
+   на входе    :  in_u16A     - первый многочлен (бит 15 - x^0)
+                  in_u16B     - второй многочлен (бит 15 - x^0)
+   на выходе   :  in_u16A * in_u16B mod P
+*/
+static u16 MultiplyCRC16(u16 in_u16A, u16 in_u16B)
+{
+   u16 l_u16Result = 0;
+
+   for(u16 l_u16Mask = 0x8000; l_u16Mask; l_u16Mask >>= 1)
+   {
+      if(in_u16A & l_u16Mask)
+         l_u16Result ^= in_u16B;
+      in_u16B = in_u16B & 0x1 ? (in_u16B >> 1) ^ 0xA001 : in_u16B >> 1;
+   }
+   return l_u16Result;
+}
 
+/**
+   Сдвиг CRC на указанное количество нулевых байт
+   на входе    :  in_u16CRC   - значение CRC
+                  in_stSize   - количество нулевых байт
+   на выходе   :  значение CRC после обработки in_stSize нулевых байт
+   примечание  :  вычисляется за log2(in_stSize) умножений
+*/
+static u16 ShiftCRC16(u16 in_u16CRC, size_t in_stSize)
+{
+   u16 l_u16Power = 0x0080;                        // x^8
+
+   while(in_stSize)
+   {
+      if(in_stSize & 1)
+         in_u16CRC = MultiplyCRC16(in_u16CRC, l_u16Power);
+      l_u16Power = MultiplyCRC16(l_u16Power, l_u16Power);
+      in_stSize >>= 1;
+   }
+   return in_u16CRC;
+}
+
+/**
+   Объединение CRC двух соседних участков данных
+   на входе    :  in_u16CRCA  - CRC первого участка (с любым первичным значением)
+                  in_u16CRCB  - CRC второго участка, вычисленная с первичным значением 0xFFFF
+                  in_stSizeB  - размер второго участка
+   на выходе   :  CRC объединенных данных, совпадает с GetCRC16Modbus(Init A, A + B)
+*/
+u16 CombineCRC16Modbus(u16 in_u16CRCA, u16 in_u16CRCB, size_t in_stSizeB)
+{
+   return ShiftCRC16(in_u16CRCA ^ 0xFFFF, in_stSizeB) ^ in_u16CRCB;
+}
+
+/**
+   Исправление CRC после изменения части данных
+   на входе    :  in_u16CRC   - CRC исходных данных
+                  in_pOld     - указатель на прежнее содержимое измененного участка
+                  in_pNew     - указатель на новое содержимое измененного участка
+                  in_stSize   - размер измененного участка
+                  in_stTail   - количество данных после измененного участка
+   на выходе   :  CRC измененных данных
+   примечание  :  пересчитывается только измененный участок, остальные данные не читаются
+*/
+u16 PatchCRC16Modbus(u16 in_u16CRC, const u8* in_pOld, const u8* in_pNew, size_t in_stSize, size_t in_stTail)
+{
+   u16 l_u16Delta = 0;
+   u8 l_u8Byte = 0;
+
+   // CRC0 разницы данных
+   while(in_stSize--)
+   {
+      l_u8Byte = *in_pOld++ ^ *in_pNew++;
+      l_u16Delta = GetCRC16Modbus(l_u16Delta, &l_u8Byte, 1);
+   }
+   return in_u16CRC ^ ShiftCRC16(l_u16Delta, in_stTail);
+}
+
+/**
+   Начало потокового вычисления CRC
+   на входе    :  out_pStream - указатель на состояние
+                  in_u16Init  - первичное значение
+   на выходе   :  *
+*/
+void InitCRC16Stream(crc16_stream_t* out_pStream, u16 in_u16Init)
+{
+   out_pStream->m_u16CRC = in_u16Init;
+   out_pStream->m_stSize = 0;
+}
+
+/**
+   Добавление данных в потоковое вычисление CRC
+   на входе    :  io_pStream  - указатель на состояние
+                  in_pBuffer  - указатель на данные
+                  in_stSize   - размер данных
+   на выходе   :  *
+*/
+void UpdateCRC16Stream(crc16_stream_t* io_pStream, const u8* in_pBuffer, size_t in_stSize)
+{
+   io_pStream->m_u16CRC = GetCRC16Modbus(io_pStream->m_u16CRC, in_pBuffer, in_stSize);
+   io_pStream->m_stSize += in_stSize;
+}
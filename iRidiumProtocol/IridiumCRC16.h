@@ -19,12 +19,49 @@
 #include "IridiumConfig.h"
 #include "IridiumTypes.h"
 
+// Состояние потокового вычисления CRC-16 (Modbus)
+typedef struct crc16_stream_s
+{
+   u16      m_u16CRC;                              // Текущее значение CRC
+   size_t   m_stSize;                              // Количество обработанных данных
+} crc16_stream_t;
+
+// Платформенные реализации вычисления контрольных сумм (например аппаратный блок CRC микроконтроллера)
+typedef u16 (*crc16_hook_t)(u16 in_u16Init, const u8* in_pBuffer, size_t in_stSize);
+typedef u32 (*crc32_hook_t)(const u32* in_pBuffer, size_t in_stCount);
+
+// Программные реализации CRC-16 (Modbus)
+enum eIridiumCRC16Engine
+{
+   IRIDIUM_CRC16_ENGINE_AUTO = 0,                  // Выбор по возможностям процессора
+   IRIDIUM_CRC16_ENGINE_SLICING,                   // Табличный расчет по 16 байт
+   IRIDIUM_CRC16_ENGINE_FOLD,                      // Свертка умножением без переносов (PCLMULQDQ/PMULL)
+};
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 // Работа с Flash памятью
 u16 GetCRC16Modbus(u16 in_u16Init, const u8* in_pBuffer, size_t in_stSize);
+
+// Объединение CRC соседних участков и исправление CRC после изменения данных
+u16 CombineCRC16Modbus(u16 in_u16CRCA, u16 in_u16CRCB, size_t in_stSizeB);
+u16 PatchCRC16Modbus(u16 in_u16CRC, const u8* in_pOld, const u8* in_pNew, size_t in_stSize, size_t in_stTail);
+
+// Потоковое вычисление CRC
+void InitCRC16Stream(crc16_stream_t* out_pStream, u16 in_u16Init);
+void UpdateCRC16Stream(crc16_stream_t* io_pStream, const u8* in_pBuffer, size_t in_stSize);
+
+// Установка платформенных реализаций, NULL - программная реализация
+void SetCRC16Hook(crc16_hook_t in_pHook);
+void SetCRC32Hook(crc32_hook_t in_pHook);
+
+// Выбор программной реализации CRC-16
+bool SetCRC16Engine(enum eIridiumCRC16Engine in_eEngine);
+
+// Вычисление CRC-32 по 32 битным словам
+u32 GetCRC32Words(const u32* in_pBuffer, size_t in_stCount);
    
 #ifdef __cplusplus
 }